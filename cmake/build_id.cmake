@@ -0,0 +1,22 @@
+# Writes a header defining CUMULUS_BUILD_ID, a hash of the sources and shaders
+# the executable is built from. The pipeline cache stores it to drop files
+# written by a different build.
+# Usage: cmake -DSOURCE_DIR=<repo> -DOUTPUT=<file.h> -P build_id.cmake
+
+file(GLOB inputs "${SOURCE_DIR}/src/*" "${SOURCE_DIR}/shaders/*")
+list(SORT inputs)
+set(hashes "")
+foreach(input ${inputs})
+    file(SHA1 "${input}" hash)
+    string(APPEND hashes "${hash}")
+endforeach()
+string(SHA1 build_id "${hashes}")
+
+set(content "/* Generated by build_id.cmake, do not edit */\n#define CUMULUS_BUILD_ID \"${build_id}\"\n")
+# Only touch the header when the id changes, so unchanged builds don't recompile its users
+if(EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" previous)
+endif()
+if(NOT previous STREQUAL content)
+    file(WRITE "${OUTPUT}" "${content}")
+endif()
@@ -0,0 +1,20 @@
+# Turns a compiled SPIR-V module into a C header with a byte array.
+# Usage: cmake -DINPUT=<file.spv> -DOUTPUT=<file.h> -DNAME=<symbol> -P embed_spirv.cmake
+
+file(READ "${INPUT}" hex HEX)
+string(LENGTH "${hex}" hex_length)
+math(EXPR size "${hex_length} / 2")
+
+# 16 bytes per line
+set(body "")
+set(offset 0)
+while(offset LESS hex_length)
+    string(SUBSTRING "${hex}" ${offset} 32 line)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" " 0x\\1," line "${line}")
+    string(APPEND body "   ${line}\n")
+    math(EXPR offset "${offset} + 32")
+endwhile()
+
+file(WRITE "${OUTPUT}"
+    "/* Generated from ${INPUT}, do not edit */\n"
+    "static const unsigned char ${NAME}[${size}] = {\n${body}};\n")
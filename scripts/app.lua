@@ -1,13 +1,16 @@
 print("Lua script loaded successfully!")
 
-local frame_count = 0
+local elapsed = 0
+local next_report = 1
 
--- This function is called by C every frame
-function Update()
-	frame_count = frame_count + 1
+-- Called by C once per fixed simulation tick (CUMULUS_SIM_HZ, default 60),
+-- however fast frames are rendered. dt is the tick length in seconds.
+function Update(dt, tick)
+	elapsed = elapsed + dt
 
-	-- Print a message every 60 frames (approx 1 sec)
-	if frame_count % 60 == 0 then
-	    print("Lua update running... Frame: " .. frame_count)
+	-- Print a message about once a second of simulated time
+	if elapsed >= next_report then
+	    next_report = next_report + 1
+	    print("Lua update running... Tick: " .. tick)
 	end
 end
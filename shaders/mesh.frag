@@ -0,0 +1,16 @@
+#version 450
+
+layout(location = 0) in vec3 in_normal;
+layout(location = 1) in vec4 in_color;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+    /* Primitives without normals get flat full light */
+    float len = length(in_normal);
+    float light = 1.0;
+    if (len > 1e-6)
+        light = max(dot(in_normal / len, normalize(vec3(0.4, 0.8, 0.3))), 0.0) * 0.8 + 0.2;
+    out_color = vec4(in_color.rgb * light, in_color.a);
+}
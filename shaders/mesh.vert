@@ -0,0 +1,37 @@
+#version 450
+
+/* SDL_gpu SPIR-V layout: vertex storage buffers in set 0, uniforms in set 1 */
+
+struct Object
+{
+    mat4 world;
+    vec4 bounds_min;
+    vec4 bounds_max;
+    vec4 color;
+};
+
+layout(location = 0) in vec3 in_position;
+layout(location = 1) in vec3 in_normal;
+layout(location = 2) in vec2 in_uv;
+layout(location = 3) in uint in_object; /* per-instance, offset by first_instance */
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects
+{
+    Object objects[];
+};
+
+layout(set = 1, binding = 0) uniform Frame
+{
+    mat4 view_proj;
+};
+
+layout(location = 0) out vec3 out_normal;
+layout(location = 1) out vec4 out_color;
+
+void main()
+{
+    Object o = objects[in_object];
+    gl_Position = view_proj * (o.world * vec4(in_position, 1.0));
+    out_normal = mat3(o.world) * in_normal;
+    out_color = o.color;
+}
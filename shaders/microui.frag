@@ -0,0 +1,15 @@
+#version 450
+
+/* SDL_gpu SPIR-V layout: fragment samplers in set 2 */
+
+layout(location = 0) in vec2 in_uv;
+layout(location = 1) in vec4 in_color;
+
+layout(set = 2, binding = 0) uniform sampler2D tex;
+
+layout(location = 0) out vec4 out_color;
+
+void main()
+{
+    out_color = in_color * texture(tex, in_uv);
+}
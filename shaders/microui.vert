@@ -0,0 +1,23 @@
+#version 450
+
+/* SDL_gpu SPIR-V layout: vertex uniforms in set 1. UBYTE4 arrives as
+   unsigned integers, same as the uchar4 in the MSL variant. */
+
+layout(location = 0) in vec2 in_position;
+layout(location = 1) in vec2 in_uv;
+layout(location = 2) in uvec4 in_color;
+
+layout(set = 1, binding = 0) uniform Uniforms
+{
+    mat4 projection;
+};
+
+layout(location = 0) out vec2 out_uv;
+layout(location = 1) out vec4 out_color;
+
+void main()
+{
+    gl_Position = projection * vec4(in_position, 0.0, 1.0);
+    out_uv = in_uv;
+    out_color = vec4(in_color) / 255.0;
+}
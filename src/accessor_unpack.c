@@ -0,0 +1,528 @@
+#include "accessor_unpack.h"
+#include "parallel.h"
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_intrin.h>
+#include <cgltf.h>
+
+/* Elements per parallel work item. Big enough to amortise scheduling,
+   small enough that one huge POSITION accessor still spreads over cores. */
+#define UNPACK_CHUNK_ELEMENTS 16384
+
+/* Elements converted per inner block (widen to int32, then int32 -> float) */
+#define UNPACK_BLOCK 64
+
+const Uint8 *accessor_view_data(const cgltf_buffer_view *view)
+{
+    if (!view)
+        return NULL;
+    if (view->data)
+        return view->data;
+    if (!view->buffer || !view->buffer->data)
+        return NULL;
+    return (const Uint8 *)view->buffer->data + view->offset;
+}
+
+static size_t component_size(cgltf_component_type type)
+{
+    switch (type)
+    {
+    case cgltf_component_type_r_8:
+    case cgltf_component_type_r_8u:
+        return 1;
+    case cgltf_component_type_r_16:
+    case cgltf_component_type_r_16u:
+        return 2;
+    case cgltf_component_type_r_32u:
+    case cgltf_component_type_r_32f:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+/* glTF normalisation: unsigned c / max, signed max(c / max, -1) */
+static float component_scale(cgltf_component_type type, bool normalized)
+{
+    if (!normalized)
+        return 1.0f;
+    switch (type)
+    {
+    case cgltf_component_type_r_8:
+        return 1.0f / 127.0f;
+    case cgltf_component_type_r_8u:
+        return 1.0f / 255.0f;
+    case cgltf_component_type_r_16:
+        return 1.0f / 32767.0f;
+    case cgltf_component_type_r_16u:
+        return 1.0f / 65535.0f;
+    default:
+        return 1.0f;
+    }
+}
+
+static bool component_signed(cgltf_component_type type)
+{
+    return type == cgltf_component_type_r_8 || type == cgltf_component_type_r_16;
+}
+
+/*================================================================================
+ * Kernels
+ *================================================================================*/
+
+/* Stage 1: widen n (<= UNPACK_BLOCK) strided integer components to int32 */
+static void widen_block(const Uint8 *src, size_t stride, size_t n, cgltf_component_type type, Sint32 *out)
+{
+    size_t i = 0;
+
+    switch (type)
+    {
+    case cgltf_component_type_r_8u:
+#if defined(SDL_SSE2_INTRINSICS)
+        if (stride == 1)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 16 <= n; i += 16)
+            {
+                __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+                __m128i lo = _mm_unpacklo_epi8(b, zero);
+                __m128i hi = _mm_unpackhi_epi8(b, zero);
+                _mm_storeu_si128((__m128i *)(out + i + 0), _mm_unpacklo_epi16(lo, zero));
+                _mm_storeu_si128((__m128i *)(out + i + 4), _mm_unpackhi_epi16(lo, zero));
+                _mm_storeu_si128((__m128i *)(out + i + 8), _mm_unpacklo_epi16(hi, zero));
+                _mm_storeu_si128((__m128i *)(out + i + 12), _mm_unpackhi_epi16(hi, zero));
+            }
+        }
+#elif defined(SDL_NEON_INTRINSICS)
+        if (stride == 1)
+        {
+            for (; i + 8 <= n; i += 8)
+            {
+                uint16x8_t w = vmovl_u8(vld1_u8(src + i));
+                vst1q_s32(out + i + 0, vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(w))));
+                vst1q_s32(out + i + 4, vreinterpretq_s32_u32(vmovl_u16(vget_high_u16(w))));
+            }
+        }
+#endif
+        for (; i < n; i++)
+            out[i] = src[i * stride];
+        break;
+
+    case cgltf_component_type_r_8:
+#if defined(SDL_SSE2_INTRINSICS)
+        if (stride == 1)
+        {
+            for (; i + 16 <= n; i += 16)
+            {
+                __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+                /* sign-extend by placing bytes in the top of each lane and shifting back down */
+                __m128i lo = _mm_unpacklo_epi8(b, b);
+                __m128i hi = _mm_unpackhi_epi8(b, b);
+                _mm_storeu_si128((__m128i *)(out + i + 0), _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 24));
+                _mm_storeu_si128((__m128i *)(out + i + 4), _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 24));
+                _mm_storeu_si128((__m128i *)(out + i + 8), _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 24));
+                _mm_storeu_si128((__m128i *)(out + i + 12), _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 24));
+            }
+        }
+#elif defined(SDL_NEON_INTRINSICS)
+        if (stride == 1)
+        {
+            for (; i + 8 <= n; i += 8)
+            {
+                int16x8_t w = vmovl_s8(vld1_s8((const int8_t *)src + i));
+                vst1q_s32(out + i + 0, vmovl_s16(vget_low_s16(w)));
+                vst1q_s32(out + i + 4, vmovl_s16(vget_high_s16(w)));
+            }
+        }
+#endif
+        for (; i < n; i++)
+            out[i] = (Sint8)src[i * stride];
+        break;
+
+    case cgltf_component_type_r_16u:
+#if defined(SDL_SSE2_INTRINSICS)
+        if (stride == 2)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            for (; i + 8 <= n; i += 8)
+            {
+                __m128i w = _mm_loadu_si128((const __m128i *)(src + i * 2));
+                _mm_storeu_si128((__m128i *)(out + i + 0), _mm_unpacklo_epi16(w, zero));
+                _mm_storeu_si128((__m128i *)(out + i + 4), _mm_unpackhi_epi16(w, zero));
+            }
+        }
+#elif defined(SDL_NEON_INTRINSICS)
+        if (stride == 2)
+        {
+            for (; i + 4 <= n; i += 4)
+            {
+                uint16x4_t w = vld1_u16((const uint16_t *)(src + i * 2));
+                vst1q_s32(out + i, vreinterpretq_s32_u32(vmovl_u16(w)));
+            }
+        }
+#endif
+        for (; i < n; i++)
+        {
+            Uint16 v;
+            SDL_memcpy(&v, src + i * stride, sizeof(v));
+            out[i] = v;
+        }
+        break;
+
+    case cgltf_component_type_r_16:
+#if defined(SDL_SSE2_INTRINSICS)
+        if (stride == 2)
+        {
+            for (; i + 8 <= n; i += 8)
+            {
+                __m128i w = _mm_loadu_si128((const __m128i *)(src + i * 2));
+                _mm_storeu_si128((__m128i *)(out + i + 0), _mm_srai_epi32(_mm_unpacklo_epi16(w, w), 16));
+                _mm_storeu_si128((__m128i *)(out + i + 4), _mm_srai_epi32(_mm_unpackhi_epi16(w, w), 16));
+            }
+        }
+#elif defined(SDL_NEON_INTRINSICS)
+        if (stride == 2)
+        {
+            for (; i + 4 <= n; i += 4)
+            {
+                int16x4_t w = vld1_s16((const int16_t *)(src + i * 2));
+                vst1q_s32(out + i, vmovl_s16(w));
+            }
+        }
+#endif
+        for (; i < n; i++)
+        {
+            Sint16 v;
+            SDL_memcpy(&v, src + i * stride, sizeof(v));
+            out[i] = v;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* Stage 2: dst = max(int32 * scale, -1 if clamp) */
+static void convert_block(const Sint32 *in, size_t n, float scale, bool clamp, float *dst)
+{
+    size_t i = 0;
+#if defined(SDL_SSE2_INTRINSICS)
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 vmin = _mm_set1_ps(clamp ? -1.0f : -3.402823466e+38f);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128 f = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(in + i)));
+        _mm_storeu_ps(dst + i, _mm_max_ps(_mm_mul_ps(f, vscale), vmin));
+    }
+#elif defined(SDL_NEON_INTRINSICS)
+    const float32x4_t vmin = vdupq_n_f32(clamp ? -1.0f : -3.402823466e+38f);
+    for (; i + 4 <= n; i += 4)
+    {
+        float32x4_t f = vcvtq_f32_s32(vld1q_s32(in + i));
+        vst1q_f32(dst + i, vmaxq_f32(vmulq_n_f32(f, scale), vmin));
+    }
+#endif
+    for (; i < n; i++)
+    {
+        float f = (float)in[i] * scale;
+        dst[i] = clamp && f < -1.0f ? -1.0f : f;
+    }
+}
+
+/* Convert n strided components of one type into a contiguous float stream */
+static void unpack_component_stream(const Uint8 *src, size_t stride, size_t n, cgltf_component_type type,
+                                    bool normalized, float *dst)
+{
+    if (type == cgltf_component_type_r_32f)
+    {
+        if (stride == sizeof(float))
+        {
+            SDL_memcpy(dst, src, n * sizeof(float));
+            return;
+        }
+        for (size_t i = 0; i < n; i++)
+            SDL_memcpy(&dst[i], src + i * stride, sizeof(float));
+        return;
+    }
+
+    if (type == cgltf_component_type_r_32u)
+    {
+        /* Out of int32 range for the SIMD convert; rare outside indices */
+        for (size_t i = 0; i < n; i++)
+        {
+            Uint32 v;
+            SDL_memcpy(&v, src + i * stride, sizeof(v));
+            dst[i] = (float)v;
+        }
+        return;
+    }
+
+    float scale = component_scale(type, normalized);
+    bool clamp = normalized && component_signed(type);
+    Sint32 tmp[UNPACK_BLOCK];
+
+    for (size_t i = 0; i < n; i += UNPACK_BLOCK)
+    {
+        size_t block = n - i < UNPACK_BLOCK ? n - i : UNPACK_BLOCK;
+        widen_block(src + i * stride, stride, block, type, tmp);
+        convert_block(tmp, block, scale, clamp, dst + i);
+    }
+}
+
+static void unpack_index_stream(const Uint8 *src, size_t stride, size_t n, cgltf_component_type type, Uint32 *dst)
+{
+    if (type == cgltf_component_type_r_32u)
+    {
+        if (stride == sizeof(Uint32))
+        {
+            SDL_memcpy(dst, src, n * sizeof(Uint32));
+            return;
+        }
+        for (size_t i = 0; i < n; i++)
+            SDL_memcpy(&dst[i], src + i * stride, sizeof(Uint32));
+        return;
+    }
+
+    /* u8/u16 widen straight into the output; values are never negative */
+    for (size_t i = 0; i < n; i += UNPACK_BLOCK)
+    {
+        size_t block = n - i < UNPACK_BLOCK ? n - i : UNPACK_BLOCK;
+        widen_block(src + i * stride, stride, block, type, (Sint32 *)(dst + i));
+    }
+}
+
+static float read_component(const Uint8 *src, cgltf_component_type type, bool normalized)
+{
+    float f = 0.0f;
+    unpack_component_stream(src, 0, 1, type, normalized, &f);
+    return f;
+}
+
+static Uint32 read_index(const Uint8 *src, cgltf_component_type type)
+{
+    Uint32 v = 0;
+    unpack_index_stream(src, 0, 1, type, &v);
+    return v;
+}
+
+/*================================================================================
+ * Accessor-level decode
+ *================================================================================*/
+static size_t accessor_stride(const cgltf_accessor *acc)
+{
+    if (acc->stride)
+        return acc->stride;
+    return component_size(acc->component_type) * cgltf_num_components(acc->type);
+}
+
+/* Dense part of elements [begin, end) */
+static void unpack_request_range(const AccessorUnpackRequest *req, size_t begin, size_t end)
+{
+    const cgltf_accessor *acc = req->accessor;
+    const Uint8 *base = accessor_view_data(acc->buffer_view);
+    size_t n = end - begin;
+
+    if (req->indices)
+    {
+        if (!base)
+        {
+            SDL_memset(req->indices + begin, 0, n * sizeof(Uint32));
+            return;
+        }
+        size_t stride = accessor_stride(acc);
+        unpack_index_stream(base + acc->offset + begin * stride, stride, n, acc->component_type, req->indices + begin);
+        return;
+    }
+
+    AccessorStreams *out = req->floats;
+    if (!base)
+    {
+        /* No buffer view: zeros, possibly overridden by sparse values */
+        for (int c = 0; c < out->num_components; c++)
+            SDL_memset(out->streams[c] + begin, 0, n * sizeof(float));
+        return;
+    }
+
+    size_t stride = accessor_stride(acc);
+    size_t csize = component_size(acc->component_type);
+    const Uint8 *src = base + acc->offset + begin * stride;
+    for (int c = 0; c < out->num_components; c++)
+    {
+        unpack_component_stream(src + (size_t)c * csize, stride, n, acc->component_type, acc->normalized != 0,
+                                out->streams[c] + begin);
+    }
+}
+
+static void apply_sparse(const AccessorUnpackRequest *req)
+{
+    const cgltf_accessor *acc = req->accessor;
+    const cgltf_accessor_sparse *sparse = &acc->sparse;
+
+    const Uint8 *idx_base = accessor_view_data(sparse->indices_buffer_view);
+    const Uint8 *val_base = accessor_view_data(sparse->values_buffer_view);
+    if (!idx_base || !val_base)
+        return;
+
+    idx_base += sparse->indices_byte_offset;
+    val_base += sparse->values_byte_offset;
+    size_t idx_size = component_size(sparse->indices_component_type);
+    size_t csize = component_size(acc->component_type);
+    size_t ncomp = cgltf_num_components(acc->type);
+
+    for (size_t i = 0; i < sparse->count; i++)
+    {
+        Uint32 target = read_index(idx_base + i * idx_size, sparse->indices_component_type);
+        if (target >= acc->count)
+            continue;
+
+        const Uint8 *value = val_base + i * csize * ncomp;
+        if (req->indices)
+        {
+            req->indices[target] = read_index(value, acc->component_type);
+            continue;
+        }
+        for (int c = 0; c < req->floats->num_components; c++)
+        {
+            req->floats->streams[c][target] = read_component(value + c * csize, acc->component_type,
+                                                             acc->normalized != 0);
+        }
+    }
+}
+
+/*================================================================================
+ * Batch scheduling
+ *================================================================================*/
+typedef struct UnpackChunk
+{
+    size_t request;
+    size_t begin;
+    size_t end;
+} UnpackChunk;
+
+typedef struct UnpackBatch
+{
+    AccessorUnpackRequest *requests;
+    UnpackChunk *chunks;
+    size_t *sparse;
+} UnpackBatch;
+
+static void unpack_chunk_range(void *userdata, size_t begin, size_t end)
+{
+    UnpackBatch *batch = userdata;
+    for (size_t i = begin; i < end; i++)
+    {
+        const UnpackChunk *chunk = &batch->chunks[i];
+        unpack_request_range(&batch->requests[chunk->request], chunk->begin, chunk->end);
+    }
+}
+
+static void unpack_sparse_range(void *userdata, size_t begin, size_t end)
+{
+    UnpackBatch *batch = userdata;
+    for (size_t i = begin; i < end; i++)
+        apply_sparse(&batch->requests[batch->sparse[i]]);
+}
+
+static bool streams_alloc(AccessorStreams *out, const cgltf_accessor *acc)
+{
+    SDL_zerop(out);
+    int ncomp = (int)cgltf_num_components(acc->type);
+    if (ncomp <= 0 || ncomp > ACCESSOR_MAX_COMPONENTS || component_size(acc->component_type) == 0)
+        return false;
+
+    out->count = acc->count;
+    out->num_components = ncomp;
+    if (acc->count == 0)
+        return true;
+
+    out->storage = SDL_malloc(acc->count * (size_t)ncomp * sizeof(float));
+    if (!out->storage)
+        return false;
+    for (int c = 0; c < ncomp; c++)
+        out->streams[c] = out->storage + (size_t)c * acc->count;
+    return true;
+}
+
+bool accessor_unpack_batch(AccessorUnpackRequest *requests, size_t count)
+{
+    size_t num_chunks = 0, num_sparse = 0;
+
+    for (size_t r = 0; r < count; r++)
+    {
+        AccessorUnpackRequest *req = &requests[r];
+        if (req->floats && !streams_alloc(req->floats, req->accessor))
+        {
+            for (size_t k = 0; k <= r; k++)
+            {
+                if (requests[k].floats)
+                    accessor_streams_free(requests[k].floats);
+            }
+            return false;
+        }
+        num_chunks += (req->accessor->count + UNPACK_CHUNK_ELEMENTS - 1) / UNPACK_CHUNK_ELEMENTS;
+        if (req->accessor->is_sparse)
+            num_sparse++;
+    }
+
+    UnpackBatch batch;
+    batch.requests = requests;
+    batch.chunks = SDL_malloc((num_chunks + 1) * sizeof(UnpackChunk));
+    batch.sparse = SDL_malloc((num_sparse + 1) * sizeof(size_t));
+    if (!batch.chunks || !batch.sparse)
+    {
+        SDL_free(batch.chunks);
+        SDL_free(batch.sparse);
+        for (size_t r = 0; r < count; r++)
+        {
+            if (requests[r].floats)
+                accessor_streams_free(requests[r].floats);
+        }
+        return false;
+    }
+
+    size_t c = 0, s = 0;
+    for (size_t r = 0; r < count; r++)
+    {
+        size_t n = requests[r].accessor->count;
+        for (size_t begin = 0; begin < n; begin += UNPACK_CHUNK_ELEMENTS)
+        {
+            batch.chunks[c].request = r;
+            batch.chunks[c].begin = begin;
+            batch.chunks[c].end = n - begin < UNPACK_CHUNK_ELEMENTS ? n : begin + UNPACK_CHUNK_ELEMENTS;
+            c++;
+        }
+        if (requests[r].accessor->is_sparse)
+            batch.sparse[s++] = r;
+    }
+
+    parallel_for(num_chunks, 1, unpack_chunk_range, &batch);
+
+    /* Sparse substitution runs after every dense chunk of its accessor */
+    parallel_for(num_sparse, 1, unpack_sparse_range, &batch);
+
+    SDL_free(batch.chunks);
+    SDL_free(batch.sparse);
+    return true;
+}
+
+bool accessor_unpack_floats(const cgltf_accessor *accessor, AccessorStreams *out)
+{
+    AccessorUnpackRequest req = {accessor, out, NULL};
+    return accessor_unpack_batch(&req, 1);
+}
+
+bool accessor_unpack_indices(const cgltf_accessor *accessor, Uint32 *out)
+{
+    AccessorUnpackRequest req = {accessor, NULL, out};
+    return accessor_unpack_batch(&req, 1);
+}
+
+void accessor_streams_free(AccessorStreams *streams)
+{
+    if (streams)
+    {
+        SDL_free(streams->storage);
+        SDL_zerop(streams);
+    }
+}
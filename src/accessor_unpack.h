@@ -0,0 +1,45 @@
+#ifndef CUMULUS_ACCESSOR_UNPACK_H
+#define CUMULUS_ACCESSOR_UNPACK_H
+
+#include <SDL3/SDL.h>
+
+struct cgltf_accessor;
+struct cgltf_buffer_view;
+
+#define ACCESSOR_MAX_COMPONENTS 16
+
+/* An accessor decoded to float in structure-of-arrays form:
+   streams[c][i] is component c of element i. Integer components are
+   normalised per the glTF rules when the accessor is marked normalized. */
+typedef struct AccessorStreams
+{
+    size_t count;
+    int num_components;
+    float *streams[ACCESSOR_MAX_COMPONENTS];
+    float *storage; /* single allocation backing all streams */
+} AccessorStreams;
+
+/* One unit of work for accessor_unpack_batch: set exactly one of
+   `floats` (vertex data) or `indices` (index data, count elements). */
+typedef struct AccessorUnpackRequest
+{
+    const struct cgltf_accessor *accessor;
+    AccessorStreams *floats;
+    Uint32 *indices;
+} AccessorUnpackRequest;
+
+/* Decode many accessors at once, split across the worker pool by accessor
+   and by chunk. Float outputs are allocated here; index outputs must be
+   preallocated by the caller. Returns false on allocation failure. */
+bool accessor_unpack_batch(AccessorUnpackRequest *requests, size_t count);
+
+/* Single-accessor convenience wrappers (still chunked across the pool) */
+bool accessor_unpack_floats(const struct cgltf_accessor *accessor, AccessorStreams *out);
+bool accessor_unpack_indices(const struct cgltf_accessor *accessor, Uint32 *out);
+
+void accessor_streams_free(AccessorStreams *streams);
+
+/* Raw bytes of a buffer view, honouring data decoded by extensions */
+const Uint8 *accessor_view_data(const struct cgltf_buffer_view *view);
+
+#endif /* CUMULUS_ACCESSOR_UNPACK_H */
@@ -0,0 +1,858 @@
+#include "animation.h"
+#include "bench.h"
+#include "parallel.h"
+#include "scene_graph.h"
+
+#include <SDL3/SDL.h>
+#include <cgltf.h>
+
+/*================================================================================
+ * Set construction
+ *================================================================================*/
+void animation_set_free(AnimationSet *set)
+{
+    if (!set)
+        return;
+
+    for (size_t i = 0; i < set->clip_count; i++)
+    {
+        SDL_free(set->clips[i].name);
+        SDL_free(set->clips[i].channels);
+    }
+    for (size_t i = 0; i < set->skin_count; i++)
+    {
+        SDL_free(set->skins[i].joints);
+        SDL_aligned_free(set->skins[i].inverse_bind);
+    }
+    SDL_free(set->clips);
+    SDL_free(set->skins);
+    SDL_free(set->parent);
+    SDL_free(set->rest_translation);
+    SDL_free(set->rest_rotation);
+    SDL_free(set->rest_scale);
+    SDL_aligned_free(set->rest_local);
+    SDL_free(set->animated);
+    SDL_free(set->rest_weights);
+    SDL_free(set->data);
+    SDL_free(set);
+}
+
+/* Rest pose and hierarchy copied from the graph's current local state */
+static AnimationSet *alloc_set(const SceneGraph *graph, size_t weight_count)
+{
+    AnimationSet *set = SDL_calloc(1, sizeof(AnimationSet));
+    if (!set)
+        return NULL;
+
+    size_t n = graph->count ? graph->count : 1;
+    set->node_count = graph->count;
+    set->weight_count = weight_count;
+    set->parent = SDL_malloc(n * sizeof(Sint32));
+    set->rest_translation = SDL_malloc(n * 3 * sizeof(float));
+    set->rest_rotation = SDL_malloc(n * 4 * sizeof(float));
+    set->rest_scale = SDL_malloc(n * 3 * sizeof(float));
+    set->rest_local = SDL_aligned_alloc(16, n * sizeof(Mat4));
+    set->animated = SDL_calloc(n, 1);
+    set->rest_weights = SDL_calloc(weight_count ? weight_count : 1, sizeof(float));
+    if (!set->parent || !set->rest_translation || !set->rest_rotation || !set->rest_scale || !set->rest_local ||
+        !set->animated || !set->rest_weights)
+    {
+        animation_set_free(set);
+        return NULL;
+    }
+
+    SDL_memcpy(set->parent, graph->parent, graph->count * sizeof(Sint32));
+    SDL_memcpy(set->rest_translation, graph->translation, graph->count * 3 * sizeof(float));
+    SDL_memcpy(set->rest_rotation, graph->rotation, graph->count * 4 * sizeof(float));
+    SDL_memcpy(set->rest_scale, graph->scale, graph->count * 3 * sizeof(float));
+    SDL_memcpy(set->rest_local, graph->local, graph->count * sizeof(Mat4));
+    return set;
+}
+
+static size_t mesh_weight_count(const cgltf_mesh *mesh)
+{
+    size_t count = mesh->weights_count;
+    if (mesh->primitives_count > 0 && mesh->primitives[0].targets_count > count)
+        count = mesh->primitives[0].targets_count;
+    return count;
+}
+
+/* Components per key, or 0 if the channel is unusable */
+static Uint16 channel_components(const cgltf_animation_channel *ch, size_t node_weights)
+{
+    const cgltf_animation_sampler *s = ch->sampler;
+    size_t keys = s->input->count;
+    size_t per_key = s->interpolation == cgltf_interpolation_type_cubic_spline ? 3 : 1;
+    size_t expected;
+    switch (ch->target_path)
+    {
+    case cgltf_animation_path_type_translation:
+    case cgltf_animation_path_type_scale:
+        expected = 3;
+        break;
+    case cgltf_animation_path_type_rotation:
+        expected = 4;
+        break;
+    case cgltf_animation_path_type_weights:
+        expected = node_weights;
+        if (expected == 0 || expected > ANIMATION_MAX_WEIGHTS)
+            return 0;
+        return s->output->count == keys * per_key * expected ? (Uint16)expected : 0;
+    default:
+        return 0;
+    }
+    size_t comps = cgltf_num_components(s->output->type);
+    return comps == expected && s->output->count == keys * per_key ? (Uint16)expected : 0;
+}
+
+static Uint8 channel_path(cgltf_animation_path_type path)
+{
+    switch (path)
+    {
+    case cgltf_animation_path_type_translation:
+        return ANIMATION_PATH_TRANSLATION;
+    case cgltf_animation_path_type_rotation:
+        return ANIMATION_PATH_ROTATION;
+    case cgltf_animation_path_type_scale:
+        return ANIMATION_PATH_SCALE;
+    default:
+        return ANIMATION_PATH_WEIGHTS;
+    }
+}
+
+static Uint8 channel_interpolation(cgltf_interpolation_type type)
+{
+    switch (type)
+    {
+    case cgltf_interpolation_type_step:
+        return ANIMATION_INTERP_STEP;
+    case cgltf_interpolation_type_cubic_spline:
+        return ANIMATION_INTERP_CUBICSPLINE;
+    default:
+        return ANIMATION_INTERP_LINEAR;
+    }
+}
+
+static bool build_skins(AnimationSet *set, const cgltf_data *data, const SceneGraph *graph)
+{
+    set->skins = SDL_calloc(data->skins_count ? data->skins_count : 1, sizeof(AnimationSkin));
+    if (!set->skins)
+        return false;
+    set->skin_count = data->skins_count;
+
+    Uint32 matrices = 0;
+    for (size_t i = 0; i < data->skins_count; i++)
+    {
+        const cgltf_skin *src = &data->skins[i];
+        AnimationSkin *skin = &set->skins[i];
+        size_t n = src->joints_count ? src->joints_count : 1;
+        skin->joint_count = (Uint32)src->joints_count;
+        skin->first_matrix = matrices;
+        skin->joints = SDL_malloc(n * sizeof(Uint32));
+        skin->inverse_bind = SDL_aligned_alloc(16, n * sizeof(Mat4));
+        if (!skin->joints || !skin->inverse_bind)
+            return false;
+
+        for (size_t j = 0; j < src->joints_count; j++)
+        {
+            size_t node = (size_t)(src->joints[j] - data->nodes);
+            skin->joints[j] = node < graph->node_map_count ? graph->node_map[node] : SCENE_NODE_NONE;
+            mat4_identity(&skin->inverse_bind[j]);
+        }
+        const cgltf_accessor *ibm = src->inverse_bind_matrices;
+        if (ibm && ibm->type == cgltf_type_mat4 && ibm->count >= src->joints_count)
+            cgltf_accessor_unpack_floats(ibm, skin->inverse_bind[0].m, src->joints_count * 16);
+        matrices += skin->joint_count;
+    }
+    set->skin_matrix_count = matrices;
+    return true;
+}
+
+AnimationSet *animation_set_build(const cgltf_data *data, const SceneGraph *graph)
+{
+    if (!graph || (data->animations_count == 0 && data->skins_count == 0))
+        return NULL;
+
+    /* Morph weights are laid out per mesh node, in scene order */
+    Uint32 *node_weights = SDL_calloc(graph->count + 1, sizeof(Uint32));
+    if (!node_weights)
+        return NULL;
+    size_t weight_count = 0;
+    for (size_t i = 0; i < graph->count; i++)
+    {
+        node_weights[i] = (Uint32)weight_count;
+        if (graph->mesh[i] >= 0)
+            weight_count += mesh_weight_count(&data->meshes[graph->mesh[i]]);
+    }
+    node_weights[graph->count] = (Uint32)weight_count;
+
+    AnimationSet *set = alloc_set(graph, weight_count);
+    if (!set)
+    {
+        SDL_free(node_weights);
+        return NULL;
+    }
+    for (size_t i = 0; i < graph->count; i++)
+    {
+        size_t count = node_weights[i + 1] - node_weights[i];
+        if (count == 0)
+            continue;
+        const cgltf_node *node = graph->source[i] >= 0 ? &data->nodes[graph->source[i]] : NULL;
+        const cgltf_mesh *mesh = &data->meshes[graph->mesh[i]];
+        const float *rest = node && node->weights_count == count ? node->weights
+                            : mesh->weights_count == count       ? mesh->weights
+                                                                 : NULL;
+        if (rest)
+            SDL_memcpy(&set->rest_weights[node_weights[i]], rest, count * sizeof(float));
+    }
+
+    /* Size one pool for every key of every usable channel */
+    size_t floats = 0;
+    for (size_t a = 0; a < data->animations_count; a++)
+    {
+        const cgltf_animation *anim = &data->animations[a];
+        for (size_t c = 0; c < anim->channels_count; c++)
+        {
+            const cgltf_animation_channel *ch = &anim->channels[c];
+            if (!ch->target_node || !ch->sampler || !ch->sampler->input || !ch->sampler->output)
+                continue;
+            floats += ch->sampler->input->count + ch->sampler->output->count * cgltf_num_components(ch->sampler->output->type);
+        }
+    }
+
+    set->data = SDL_malloc((floats ? floats : 1) * sizeof(float));
+    set->clips = SDL_calloc(data->animations_count ? data->animations_count : 1, sizeof(AnimationClip));
+    if (!set->data || !set->clips || !build_skins(set, data, graph))
+    {
+        SDL_free(node_weights);
+        animation_set_free(set);
+        return NULL;
+    }
+    set->clip_count = data->animations_count;
+
+    float *pool = set->data;
+    size_t skipped = 0;
+    for (size_t a = 0; a < data->animations_count; a++)
+    {
+        const cgltf_animation *anim = &data->animations[a];
+        AnimationClip *clip = &set->clips[a];
+        clip->name = SDL_strdup(anim->name ? anim->name : "");
+        clip->channels = SDL_calloc(anim->channels_count ? anim->channels_count : 1, sizeof(AnimationChannel));
+        if (!clip->name || !clip->channels)
+        {
+            SDL_free(node_weights);
+            animation_set_free(set);
+            return NULL;
+        }
+
+        float start = 0.0f, end = 0.0f;
+        for (size_t c = 0; c < anim->channels_count; c++)
+        {
+            const cgltf_animation_channel *src = &anim->channels[c];
+            const cgltf_animation_sampler *s = src->sampler;
+            size_t source = src->target_node ? (size_t)(src->target_node - data->nodes) : graph->node_map_count;
+            Uint32 node = source < graph->node_map_count ? graph->node_map[source] : SCENE_NODE_NONE;
+            Uint16 components = 0;
+            if (node != SCENE_NODE_NONE && s && s->input && s->output && s->input->count > 0)
+                components = channel_components(src, node_weights[node + 1] - node_weights[node]);
+            if (components == 0)
+            {
+                skipped++;
+                continue;
+            }
+
+            AnimationChannel *ch = &clip->channels[clip->channel_count++];
+            ch->node = node;
+            ch->path = channel_path(src->target_path);
+            ch->interpolation = channel_interpolation(s->interpolation);
+            ch->components = components;
+            ch->weight_offset = node_weights[node];
+            ch->key_count = (Uint32)s->input->count;
+
+            size_t value_count = s->output->count * cgltf_num_components(s->output->type);
+            cgltf_accessor_unpack_floats(s->input, pool, s->input->count);
+            cgltf_accessor_unpack_floats(s->output, pool + s->input->count, value_count);
+            ch->times = pool;
+            ch->values = pool + s->input->count;
+            pool += s->input->count + value_count;
+
+            bool first = clip->channel_count == 1;
+            start = first ? ch->times[0] : SDL_min(start, ch->times[0]);
+            end = first ? ch->times[ch->key_count - 1] : SDL_max(end, ch->times[ch->key_count - 1]);
+            if (ch->path != ANIMATION_PATH_WEIGHTS)
+                set->animated[node] = 1;
+        }
+        clip->start = clip->channel_count ? start : 0.0f;
+        clip->duration = clip->channel_count ? SDL_max(end - start, 0.0f) : 0.0f;
+        set->max_channels = SDL_max(set->max_channels, clip->channel_count);
+    }
+    SDL_free(node_weights);
+
+    if (skipped)
+        SDL_Log("  animation: skipped %zu channels with missing targets or mismatched data", skipped);
+    return set;
+}
+
+/*================================================================================
+ * Instances
+ *================================================================================*/
+void animation_instance_free(AnimationInstance *inst)
+{
+    if (!inst)
+        return;
+
+    SDL_free(inst->translation);
+    SDL_free(inst->rotation);
+    SDL_free(inst->scale);
+    SDL_free(inst->weights);
+    SDL_aligned_free(inst->world);
+    SDL_aligned_free(inst->skin_matrices);
+    SDL_free(inst->cursor_storage);
+    SDL_free(inst);
+}
+
+AnimationInstance *animation_instance_create(const AnimationSet *set)
+{
+    AnimationInstance *inst = SDL_calloc(1, sizeof(AnimationInstance));
+    if (!inst)
+        return NULL;
+
+    size_t n = set->node_count ? set->node_count : 1;
+    size_t channels = set->max_channels ? set->max_channels : 1;
+    inst->set = set;
+    inst->translation = SDL_malloc(n * 3 * sizeof(float));
+    inst->rotation = SDL_malloc(n * 4 * sizeof(float));
+    inst->scale = SDL_malloc(n * 3 * sizeof(float));
+    inst->weights = SDL_malloc((set->weight_count ? set->weight_count : 1) * sizeof(float));
+    inst->world = SDL_aligned_alloc(16, n * sizeof(Mat4));
+    inst->skin_matrices = SDL_aligned_alloc(16, (set->skin_matrix_count ? set->skin_matrix_count : 1) * sizeof(Mat4));
+    inst->cursor_storage = SDL_calloc(channels * ANIMATION_MAX_LAYERS, sizeof(Uint32));
+    if (!inst->translation || !inst->rotation || !inst->scale || !inst->weights || !inst->world ||
+        !inst->skin_matrices || !inst->cursor_storage)
+    {
+        animation_instance_free(inst);
+        return NULL;
+    }
+
+    for (int l = 0; l < ANIMATION_MAX_LAYERS; l++)
+    {
+        inst->layers[l].clip = -1;
+        inst->layers[l].cursors = inst->cursor_storage + l * channels;
+    }
+    return inst;
+}
+
+void animation_instance_play(AnimationInstance *inst, int layer, int clip, float weight, bool loop)
+{
+    if (layer < 0 || layer >= ANIMATION_MAX_LAYERS)
+        return;
+
+    AnimationLayer *l = &inst->layers[layer];
+    l->clip = clip >= 0 && (size_t)clip < inst->set->clip_count ? clip : -1;
+    l->time = 0.0f;
+    l->speed = 1.0f;
+    l->weight = weight;
+    l->loop = loop;
+    SDL_memset(l->cursors, 0, inst->set->max_channels * sizeof(Uint32));
+}
+
+void animation_instance_apply(const AnimationInstance *inst, SceneGraph *graph)
+{
+    const AnimationSet *set = inst->set;
+    size_t n = SDL_min(set->node_count, graph->count);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (set->animated[i])
+            scene_graph_set_trs(graph, (Uint32)i, &inst->translation[i * 3], &inst->rotation[i * 4],
+                                &inst->scale[i * 3]);
+    }
+}
+
+/*================================================================================
+ * Sampling
+ *================================================================================*/
+
+/* dst = normalize(lerp(dst, src, w)) along the shorter arc */
+static inline void quat_blend(float *dst, const float *src, float w)
+{
+#if defined(SDL_SSE2_INTRINSICS)
+    __m128 a = _mm_loadu_ps(dst);
+    __m128 b = _mm_loadu_ps(src);
+    __m128 d = _mm_mul_ps(a, b);
+    d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1)));
+    d = _mm_add_ps(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 0, 3, 2)));
+    b = _mm_xor_ps(b, _mm_and_ps(d, _mm_set1_ps(-0.0f)));
+    __m128 r = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), _mm_set1_ps(w)));
+    __m128 len = _mm_mul_ps(r, r);
+    len = _mm_add_ps(len, _mm_shuffle_ps(len, len, _MM_SHUFFLE(2, 3, 0, 1)));
+    len = _mm_add_ps(len, _mm_shuffle_ps(len, len, _MM_SHUFFLE(1, 0, 3, 2)));
+    _mm_storeu_ps(dst, _mm_div_ps(r, _mm_sqrt_ps(len)));
+#elif defined(SDL_NEON_INTRINSICS)
+    float32x4_t a = vld1q_f32(dst);
+    float32x4_t b = vld1q_f32(src);
+    float32x4_t p = vmulq_f32(a, b);
+    float32x2_t s = vadd_f32(vget_low_f32(p), vget_high_f32(p));
+    if (vget_lane_f32(vpadd_f32(s, s), 0) < 0.0f)
+        b = vnegq_f32(b);
+    float32x4_t r = vmlaq_n_f32(a, vsubq_f32(b, a), w);
+    p = vmulq_f32(r, r);
+    s = vadd_f32(vget_low_f32(p), vget_high_f32(p));
+    vst1q_f32(dst, vmulq_n_f32(r, 1.0f / SDL_sqrtf(vget_lane_f32(vpadd_f32(s, s), 0))));
+#else
+    float dot = dst[0] * src[0] + dst[1] * src[1] + dst[2] * src[2] + dst[3] * src[3];
+    float sign = dot < 0.0f ? -1.0f : 1.0f;
+    float r[4], len = 0.0f;
+    for (int i = 0; i < 4; i++)
+    {
+        r[i] = dst[i] + (src[i] * sign - dst[i]) * w;
+        len += r[i] * r[i];
+    }
+    len = 1.0f / SDL_sqrtf(len);
+    for (int i = 0; i < 4; i++)
+        dst[i] = r[i] * len;
+#endif
+}
+
+static inline void lerp_floats(float *dst, const float *src, float w, int n)
+{
+    for (int i = 0; i < n; i++)
+        dst[i] += (src[i] - dst[i]) * w;
+}
+
+/* Key k with times[k] <= t < times[k + 1], for times[0] < t < times[count - 1].
+   Playback moves a key or two per frame, so the cached key and its next few
+   successors are checked before falling back to a binary search. */
+static inline Uint32 seek_key(const float *times, Uint32 count, float t, Uint32 *cursor)
+{
+    Uint32 k = *cursor < count - 1 ? *cursor : 0;
+    Uint32 lo = 0, hi = k;
+    if (t >= times[k])
+    {
+        for (int step = 0; step < 4; step++)
+        {
+            if (t < times[k + 1])
+            {
+                *cursor = k;
+                return k;
+            }
+            k++;
+        }
+        lo = k;
+        hi = count - 1;
+    }
+    while (hi - lo > 1)
+    {
+        Uint32 mid = (lo + hi) / 2;
+        if (times[mid] <= t)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    *cursor = lo;
+    return lo;
+}
+
+static inline Uint32 search_key(const float *times, Uint32 count, float t)
+{
+    Uint32 lo = 0, hi = count - 1;
+    while (hi - lo > 1)
+    {
+        Uint32 mid = (lo + hi) / 2;
+        if (times[mid] <= t)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+static void sample_channel(const AnimationChannel *ch, float t, Uint32 *cursor, float *out)
+{
+    int n = ch->components;
+    bool cubic = ch->interpolation == ANIMATION_INTERP_CUBICSPLINE;
+    int stride = cubic ? n * 3 : n;
+    int value = cubic ? n : 0; /* skip the in-tangent */
+    Uint32 last = ch->key_count - 1;
+
+    if (t <= ch->times[0] || last == 0)
+    {
+        SDL_memcpy(out, ch->values + value, n * sizeof(float));
+        return;
+    }
+    if (t >= ch->times[last])
+    {
+        SDL_memcpy(out, ch->values + last * stride + value, n * sizeof(float));
+        return;
+    }
+
+    Uint32 k = cursor ? seek_key(ch->times, ch->key_count, t, cursor) : search_key(ch->times, ch->key_count, t);
+    const float *v0 = ch->values + k * stride;
+    const float *v1 = v0 + stride;
+    float dt = ch->times[k + 1] - ch->times[k];
+    float u = (t - ch->times[k]) / dt;
+
+    switch (ch->interpolation)
+    {
+    case ANIMATION_INTERP_STEP:
+        SDL_memcpy(out, v0, n * sizeof(float));
+        break;
+    case ANIMATION_INTERP_CUBICSPLINE:
+    {
+        /* Hermite between value k and k + 1 with out-tangent k and in-tangent k + 1 */
+        float u2 = u * u, u3 = u2 * u;
+        float h00 = 2.0f * u3 - 3.0f * u2 + 1.0f, h10 = (u3 - 2.0f * u2 + u) * dt;
+        float h01 = -2.0f * u3 + 3.0f * u2, h11 = (u3 - u2) * dt;
+        for (int i = 0; i < n; i++)
+            out[i] = h00 * v0[n + i] + h10 * v0[2 * n + i] + h01 * v1[n + i] + h11 * v1[i];
+        if (ch->path == ANIMATION_PATH_ROTATION)
+        {
+            float len = SDL_sqrtf(out[0] * out[0] + out[1] * out[1] + out[2] * out[2] + out[3] * out[3]);
+            for (int i = 0; i < 4; i++)
+                out[i] /= len > 0.0f ? len : 1.0f;
+        }
+        break;
+    }
+    default:
+        SDL_memcpy(out, v0, n * sizeof(float));
+        /* Normalised lerp: keys are dense enough that it matches slerp visually */
+        if (ch->path == ANIMATION_PATH_ROTATION)
+            quat_blend(out, v1, u);
+        else
+            lerp_floats(out, v1, u, n);
+        break;
+    }
+}
+
+static float advance_layer(AnimationLayer *layer, const AnimationClip *clip, float dt)
+{
+    layer->time += dt * layer->speed;
+    if (clip->duration <= 0.0f)
+        layer->time = 0.0f;
+    else if (layer->loop)
+    {
+        layer->time = SDL_fmodf(layer->time, clip->duration);
+        if (layer->time < 0.0f)
+            layer->time += clip->duration;
+    }
+    else
+        layer->time = SDL_clamp(layer->time, 0.0f, clip->duration);
+    return clip->start + layer->time;
+}
+
+static void evaluate_instance(AnimationInstance *inst, float dt, bool cached)
+{
+    const AnimationSet *set = inst->set;
+    size_t n = set->node_count;
+    SDL_memcpy(inst->translation, set->rest_translation, n * 3 * sizeof(float));
+    SDL_memcpy(inst->rotation, set->rest_rotation, n * 4 * sizeof(float));
+    SDL_memcpy(inst->scale, set->rest_scale, n * 3 * sizeof(float));
+    SDL_memcpy(inst->weights, set->rest_weights, set->weight_count * sizeof(float));
+
+    bool base = true;
+    for (int l = 0; l < ANIMATION_MAX_LAYERS; l++)
+    {
+        AnimationLayer *layer = &inst->layers[l];
+        if (layer->clip < 0 || (!base && layer->weight <= 0.0f))
+            continue;
+
+        const AnimationClip *clip = &set->clips[layer->clip];
+        float t = advance_layer(layer, clip, dt);
+        float w = base ? 1.0f : SDL_min(layer->weight, 1.0f);
+        for (size_t c = 0; c < clip->channel_count; c++)
+        {
+            const AnimationChannel *ch = &clip->channels[c];
+            float sample[ANIMATION_MAX_WEIGHTS];
+            sample_channel(ch, t, cached ? &layer->cursors[c] : NULL, sample);
+
+            float *dst;
+            switch (ch->path)
+            {
+            case ANIMATION_PATH_TRANSLATION:
+                dst = &inst->translation[ch->node * 3];
+                break;
+            case ANIMATION_PATH_ROTATION:
+                dst = &inst->rotation[ch->node * 4];
+                break;
+            case ANIMATION_PATH_SCALE:
+                dst = &inst->scale[ch->node * 3];
+                break;
+            default:
+                dst = &inst->weights[ch->weight_offset];
+                break;
+            }
+            if (w >= 1.0f)
+                SDL_memcpy(dst, sample, ch->components * sizeof(float));
+            else if (ch->path == ANIMATION_PATH_ROTATION)
+                quat_blend(dst, sample, w);
+            else
+                lerp_floats(dst, sample, w, ch->components);
+        }
+        base = false;
+    }
+
+    /* Preorder: parents are final before their children */
+    for (size_t i = 0; i < n; i++)
+    {
+        Mat4 local;
+        const Mat4 *m = &set->rest_local[i];
+        if (set->animated[i])
+        {
+            mat4_from_trs(&local, &inst->translation[i * 3], &inst->rotation[i * 4], &inst->scale[i * 3]);
+            m = &local;
+        }
+        Sint32 p = set->parent[i];
+        if (p < 0)
+            inst->world[i] = *m;
+        else
+            mat4_mul(&inst->world[i], &inst->world[p], m);
+    }
+
+    for (size_t s = 0; s < set->skin_count; s++)
+    {
+        const AnimationSkin *skin = &set->skins[s];
+        Mat4 *out = inst->skin_matrices + skin->first_matrix;
+        for (Uint32 j = 0; j < skin->joint_count; j++)
+        {
+            Uint32 node = skin->joints[j];
+            if (node == SCENE_NODE_NONE || node >= n)
+                out[j] = skin->inverse_bind[j];
+            else
+                mat4_mul(&out[j], &inst->world[node], &skin->inverse_bind[j]);
+        }
+    }
+}
+
+typedef struct UpdateJob
+{
+    AnimationInstance **instances;
+    float dt;
+    bool cached;
+} UpdateJob;
+
+static void update_range(void *userdata, size_t begin, size_t end)
+{
+    UpdateJob *job = userdata;
+    for (size_t i = begin; i < end; i++)
+        evaluate_instance(job->instances[i], job->dt, job->cached);
+}
+
+void animation_update(AnimationInstance **instances, size_t count, float dt)
+{
+    UpdateJob job = {instances, dt, true};
+    parallel_for(count, 8, update_range, &job);
+}
+
+/*================================================================================
+ * Benchmark
+ *================================================================================*/
+#define BENCH_JOINTS 64
+#define BENCH_FPS 30
+
+/* Rotation channels on every joint plus root motion, keyed at 30 fps */
+static void bench_clip(AnimationClip *clip, float duration, float amplitude, float **pool, Uint64 *seed)
+{
+    Uint32 keys = (Uint32)(duration * BENCH_FPS) + 1;
+    clip->start = 0.0f;
+    clip->duration = duration;
+    clip->channel_count = BENCH_JOINTS + 1;
+    for (size_t c = 0; c < clip->channel_count; c++)
+    {
+        AnimationChannel *ch = &clip->channels[c];
+        bool root_motion = c == BENCH_JOINTS;
+        ch->node = root_motion ? 0 : (Uint32)c;
+        ch->path = root_motion ? ANIMATION_PATH_TRANSLATION : ANIMATION_PATH_ROTATION;
+        ch->interpolation = ANIMATION_INTERP_LINEAR;
+        ch->components = root_motion ? 3 : 4;
+        ch->key_count = keys;
+
+        float *times = *pool;
+        float *values = times + keys;
+        *pool += keys + keys * ch->components;
+        float phase = (float)SDL_rand_r(seed, 628) * 0.01f;
+        for (Uint32 k = 0; k < keys; k++)
+        {
+            times[k] = duration * (float)k / (float)(keys - 1);
+            float angle = amplitude * SDL_sinf(phase + 2.0f * SDL_PI_F * times[k] / duration);
+            float *v = values + k * ch->components;
+            if (root_motion)
+            {
+                v[0] = 0.0f;
+                v[1] = 0.05f * SDL_fabsf(angle);
+                v[2] = times[k];
+            }
+            else
+            {
+                v[0] = SDL_sinf(angle * 0.5f);
+                v[1] = 0.0f;
+                v[2] = 0.0f;
+                v[3] = SDL_cosf(angle * 0.5f);
+            }
+        }
+        ch->times = times;
+        ch->values = values;
+    }
+}
+
+static AnimationSet *bench_set(void)
+{
+    /* Humanoid-sized random preorder skeleton */
+    Sint32 parent[BENCH_JOINTS];
+    Sint32 path[BENCH_JOINTS];
+    Uint64 seed = 0x9E3779B97F4A7C15ull;
+    size_t depth = 0;
+    for (int i = 0; i < BENCH_JOINTS; i++)
+    {
+        if (depth > 1 && (SDL_rand_r(&seed, 100) < 25 || depth > 8))
+            depth -= 1 + (size_t)SDL_rand_r(&seed, 2);
+        parent[i] = depth > 0 ? path[depth - 1] : -1;
+        path[depth++] = i;
+    }
+    SceneGraph *graph = scene_graph_create(BENCH_JOINTS, parent);
+    if (!graph)
+        return NULL;
+    for (Uint32 i = 1; i < BENCH_JOINTS; i++)
+    {
+        float t[3] = {0.0f, 0.1f, 0.0f};
+        scene_graph_set_trs(graph, i, t, NULL, NULL);
+    }
+    scene_graph_update(graph);
+
+    AnimationSet *set = alloc_set(graph, 0);
+    scene_graph_free(graph);
+    if (!set)
+        return NULL;
+
+    const float durations[2] = {1.0f, 0.7f};
+    size_t floats = 0;
+    for (int c = 0; c < 2; c++)
+    {
+        size_t keys = (size_t)(durations[c] * BENCH_FPS) + 1;
+        floats += BENCH_JOINTS * keys * 5 + keys * 4;
+    }
+    set->data = SDL_malloc(floats * sizeof(float));
+    set->clips = SDL_calloc(2, sizeof(AnimationClip));
+    set->skins = SDL_calloc(1, sizeof(AnimationSkin));
+    if (!set->data || !set->clips || !set->skins)
+    {
+        animation_set_free(set);
+        return NULL;
+    }
+
+    set->clip_count = 2;
+    set->max_channels = BENCH_JOINTS + 1;
+    float *pool = set->data;
+    for (int c = 0; c < 2; c++)
+    {
+        set->clips[c].name = SDL_strdup(c == 0 ? "walk" : "run");
+        set->clips[c].channels = SDL_calloc(BENCH_JOINTS + 1, sizeof(AnimationChannel));
+        if (!set->clips[c].channels)
+        {
+            animation_set_free(set);
+            return NULL;
+        }
+        bench_clip(&set->clips[c], durations[c], c == 0 ? 0.4f : 0.8f, &pool, &seed);
+    }
+    for (int i = 0; i < BENCH_JOINTS; i++)
+        set->animated[i] = 1;
+
+    AnimationSkin *skin = &set->skins[0];
+    set->skin_count = 1;
+    set->skin_matrix_count = BENCH_JOINTS;
+    skin->joint_count = BENCH_JOINTS;
+    skin->joints = SDL_malloc(BENCH_JOINTS * sizeof(Uint32));
+    skin->inverse_bind = SDL_aligned_alloc(16, BENCH_JOINTS * sizeof(Mat4));
+    if (!skin->joints || !skin->inverse_bind)
+    {
+        animation_set_free(set);
+        return NULL;
+    }
+    for (Uint32 j = 0; j < BENCH_JOINTS; j++)
+    {
+        skin->joints[j] = j;
+        mat4_identity(&skin->inverse_bind[j]);
+        skin->inverse_bind[j].m[13] = -0.1f * (float)j;
+    }
+    return set;
+}
+
+void animation_benchmark(size_t instance_count)
+{
+    AnimationSet *set = bench_set();
+    AnimationInstance **instances = SDL_calloc(instance_count, sizeof(AnimationInstance *));
+    float *start_times = SDL_malloc(instance_count * sizeof(float));
+    Mat4 *reference = SDL_aligned_alloc(16, instance_count * BENCH_JOINTS * sizeof(Mat4));
+    if (!set || !instances || !start_times || !reference)
+    {
+        animation_set_free(set);
+        SDL_free(instances);
+        SDL_free(start_times);
+        SDL_aligned_free(reference);
+        return;
+    }
+
+    /* Every character walks with a random share of run blended on top */
+    Uint64 seed = 0x853C49E6748FEA9Bull;
+    size_t created = 0;
+    for (; created < instance_count; created++)
+    {
+        AnimationInstance *inst = animation_instance_create(set);
+        if (!inst)
+            break;
+        animation_instance_play(inst, 0, 0, 1.0f, true);
+        animation_instance_play(inst, 1, 1, (float)SDL_rand_r(&seed, 100) * 0.01f, true);
+        start_times[created] = (float)SDL_rand_r(&seed, 1000) * 0.001f;
+        inst->layers[0].time = start_times[created];
+        inst->layers[1].time = start_times[created] * 0.7f;
+        instances[created] = inst;
+    }
+
+    const int frames = 60;
+    const float dt = 1.0f / 60.0f;
+    UpdateJob job = {instances, dt, false};
+
+    /* Binary search every channel, single thread */
+    Uint64 start = bench_now();
+    for (int f = 0; f < frames; f++)
+        update_range(&job, 0, created);
+    double search_ms = bench_ms_since(start) / frames;
+    for (size_t i = 0; i < created; i++)
+        SDL_memcpy(&reference[i * BENCH_JOINTS], instances[i]->skin_matrices, BENCH_JOINTS * sizeof(Mat4));
+
+    /* Rewind, then replay with cursors: single thread, then across the pool */
+    for (size_t i = 0; i < created; i++)
+    {
+        instances[i]->layers[0].time = start_times[i];
+        instances[i]->layers[1].time = start_times[i] * 0.7f;
+    }
+    job.cached = true;
+    start = bench_now();
+    for (int f = 0; f < frames; f++)
+        update_range(&job, 0, created);
+    double cursor_ms = bench_ms_since(start) / frames;
+
+    float max_error = 0.0f;
+    for (size_t i = 0; i < created; i++)
+    {
+        const float *a = reference[i * BENCH_JOINTS].m;
+        const float *b = instances[i]->skin_matrices[0].m;
+        for (size_t k = 0; k < BENCH_JOINTS * 16; k++)
+            max_error = SDL_max(max_error, SDL_fabsf(a[k] - b[k]));
+    }
+
+    start = bench_now();
+    for (int f = 0; f < frames; f++)
+        animation_update(instances, created, dt);
+    double parallel_ms = bench_ms_since(start) / frames;
+
+    SDL_Log("Animation bench (%zu characters, %d joints, 2 blended clips): binary search %.3f ms, "
+            "cursors %.3f ms, cursors on %d workers %.3f ms per frame (%.2f us per character), max diff %g",
+            created, BENCH_JOINTS, search_ms, cursor_ms, parallel_worker_count() + 1, parallel_ms,
+            parallel_ms * 1000.0 / (double)SDL_max(created, 1), (double)max_error);
+
+    for (size_t i = 0; i < created; i++)
+        animation_instance_free(instances[i]);
+    SDL_free(instances);
+    SDL_free(start_times);
+    SDL_aligned_free(reference);
+    animation_set_free(set);
+}
@@ -0,0 +1,128 @@
+#ifndef CUMULUS_ANIMATION_H
+#define CUMULUS_ANIMATION_H
+
+#include "vecmath.h"
+#include <SDL3/SDL.h>
+
+struct cgltf_data;
+struct SceneGraph;
+
+#define ANIMATION_MAX_LAYERS 4
+#define ANIMATION_MAX_WEIGHTS 64 /* morph targets per weights channel */
+
+typedef enum AnimationPath
+{
+    ANIMATION_PATH_TRANSLATION,
+    ANIMATION_PATH_ROTATION,
+    ANIMATION_PATH_SCALE,
+    ANIMATION_PATH_WEIGHTS
+} AnimationPath;
+
+typedef enum AnimationInterpolation
+{
+    ANIMATION_INTERP_LINEAR,
+    ANIMATION_INTERP_STEP,
+    ANIMATION_INTERP_CUBICSPLINE
+} AnimationInterpolation;
+
+/* One animated property of one node. Keys are stored interleaved so a
+   sample touches a single run of memory. */
+typedef struct AnimationChannel
+{
+    Uint32 node;          /* flat scene node */
+    Uint8 path;           /* AnimationPath */
+    Uint8 interpolation;  /* AnimationInterpolation */
+    Uint16 components;    /* 3, 4, or the morph target count for weights */
+    Uint32 weight_offset; /* weights channels: first entry in the pose's weights */
+    Uint32 key_count;
+    const float *times;
+    const float *values; /* components per key; cubic splines store (in, value, out) */
+} AnimationChannel;
+
+typedef struct AnimationClip
+{
+    char *name;
+    float start;    /* first key time */
+    float duration; /* last key time - start */
+    AnimationChannel *channels;
+    size_t channel_count;
+} AnimationClip;
+
+typedef struct AnimationSkin
+{
+    Uint32 joint_count;
+    Uint32 *joints;       /* flat scene node per joint, SCENE_NODE_NONE if not in the scene */
+    Mat4 *inverse_bind;   /* 16-byte aligned */
+    Uint32 first_matrix;  /* offset into AnimationInstance.skin_matrices */
+} AnimationSkin;
+
+/* Immutable animation data of one model: clips, skins and the rest pose
+   of the scene graph they drive. Shared by any number of instances. */
+typedef struct AnimationSet
+{
+    size_t node_count;
+    Sint32 *parent; /* preorder, copied from the scene graph */
+    float *rest_translation;
+    float *rest_rotation;
+    float *rest_scale;
+    Mat4 *rest_local;  /* used as-is for nodes no clip animates */
+    Uint8 *animated;   /* per node: some clip writes its TRS */
+    float *rest_weights;
+    size_t weight_count;
+
+    AnimationClip *clips;
+    size_t clip_count;
+    size_t max_channels;
+    AnimationSkin *skins;
+    size_t skin_count;
+    size_t skin_matrix_count;
+
+    float *data; /* key times and values of every channel */
+} AnimationSet;
+
+typedef struct AnimationLayer
+{
+    Sint32 clip; /* -1 when the layer is off */
+    float time;  /* seconds from the clip start */
+    float speed;
+    float weight; /* layer 0 is the base pose; higher layers blend over it */
+    bool loop;
+    Uint32 *cursors; /* last key found per channel */
+} AnimationLayer;
+
+/* Evaluated pose of one animated character */
+typedef struct AnimationInstance
+{
+    const AnimationSet *set;
+    AnimationLayer layers[ANIMATION_MAX_LAYERS];
+    float *translation; /* 3 per node */
+    float *rotation;    /* 4 per node */
+    float *scale;       /* 3 per node */
+    float *weights;     /* morph weights, set->weight_count */
+    Mat4 *world;
+    Mat4 *skin_matrices; /* world-space joint matrices, set->skin_matrix_count */
+    Uint32 *cursor_storage;
+} AnimationInstance;
+
+/* Collect the animations and skins of `data` against its flattened scene.
+   Returns NULL if there are none or on allocation failure. */
+AnimationSet *animation_set_build(const struct cgltf_data *data, const struct SceneGraph *graph);
+void animation_set_free(AnimationSet *set);
+
+AnimationInstance *animation_instance_create(const AnimationSet *set);
+void animation_instance_free(AnimationInstance *instance);
+
+/* Start `clip` on `layer` from time 0 (clip -1 turns the layer off) */
+void animation_instance_play(AnimationInstance *instance, int layer, int clip, float weight, bool loop);
+
+/* Advance every instance by dt seconds and evaluate its pose, world and
+   skinning matrices, spread across the worker pool. */
+void animation_update(AnimationInstance **instances, size_t count, float dt);
+
+/* Write the animated nodes' pose into a scene graph built from the same file */
+void animation_instance_apply(const AnimationInstance *instance, struct SceneGraph *graph);
+
+/* Log per-frame cost of many blended characters on a synthetic rig */
+void animation_benchmark(size_t instance_count);
+
+#endif /* CUMULUS_ANIMATION_H */
@@ -1,8 +1,28 @@
 #include "app.h"
 #include "SDL3/SDL_dialog.h"
 #include "SDL3/SDL_log.h"
+#include "animation.h"
+#include "asset_cache.h"
+#include "bench.h"
+#include "ecs.h"
+#include "frame_arena.h"
+#include "frame_capture.h"
+#include "glyph_cache.h"
+#include "input.h"
+#include "lua_ecs.h"
 #include "lua_script.h"
+#include "mesh_bvh.h"
+#include "mesh_renderer.h"
+#include "meshlet_stream.h"
 #include "model_import.h"
+#include "occlusion.h"
+#include "parallel.h"
+#include "pipeline_cache.h"
+#include "render_graph.h"
+#include "residency.h"
+#include "scene_bvh.h"
+#include "scene_graph.h"
+#include "texture_stream.h"
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
@@ -14,12 +34,19 @@
 #define WINDOW_TITLE "Cumulus"
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
+#define TOOL_WINDOW_WIDTH 320
+#define TOOL_WINDOW_HEIGHT 240
+#define FRAME_ARENA_SIZE (256u * 1024u)
+#define SIM_DEFAULT_HZ 60
+#define SIM_MAX_TICKS 8            /* per frame; a longer stall drops simulated time */
+#define SIM_MAX_FRAME_SECONDS 0.25 /* frame time the simulation tries to catch up on */
 
 static const float CLEAR_COLOR[4] = {0.16f, 0.47f, 0.34f, 1.0f};
 
 /* File dialog filters — must stay alive until callback fires (SDL is async) */
 static const SDL_DialogFileFilter FILE_FILTERS[] = {{.name = "glTF Model", .pattern = "gltf"},
-                                                    {.name = "glTF Binary", .pattern = "glb"}};
+                                                    {.name = "glTF Binary", .pattern = "glb"},
+                                                    {.name = "Cooked Meshlets", .pattern = "meshlets"}};
 
 /* Callback fired by SDL_ShowOpenFileDialog when user picks a file (or cancels)
  */
@@ -42,27 +69,308 @@ static void SDLCALL on_file_dialog_result(void *userdata, const char *const *fil
 
     SDL_Log("File selected: %s", files[0]);
 
-    /* Free previous model if any */
-    model_free(ctx->model);
-    ctx->model = model_load(files[0]);
+    /* The callback may run on another thread; hand the path to the main loop */
+    SDL_free(SDL_SetAtomicPointer(&ctx->pending_model_path, SDL_strdup(files[0])));
+}
+
+static Uint32 env_uint(const char *name, Uint32 fallback)
+{
+    const char *v = SDL_getenv(name);
+    return v && v[0] ? (Uint32)SDL_strtoul(v, NULL, 10) : fallback;
+}
+
+/* .meshlets files stream as they are; with CUMULUS_STREAM=1 other models
+   are cooked next to themselves first. Returns false to load normally. */
+static bool open_stream(AppContext *ctx, const char *path)
+{
+    const char *ext = SDL_strrchr(path, '.');
+    bool cooked = ext && SDL_strcasecmp(ext, ".meshlets") == 0;
+    if (!cooked && env_uint("CUMULUS_STREAM", 0) == 0)
+    {
+        return false;
+    }
+
+    char *stream_path = NULL;
+    if (cooked)
+    {
+        stream_path = SDL_strdup(path);
+    }
+    else if (SDL_asprintf(&stream_path, "%s.meshlets", path) < 0 || !meshlet_cook(path, stream_path))
+    {
+        SDL_free(stream_path);
+        return cooked;
+    }
+    size_t cap = (size_t)env_uint("CUMULUS_STREAM_MB", 256) * 1024u * 1024u;
+    ctx->stream = stream_path ? meshlet_stream_open(ctx->device, stream_path, cap) : NULL;
+    SDL_free(stream_path);
+    if (ctx->stream && ctx->meshes)
+    {
+        mesh_renderer_set_stream(ctx->meshes, ctx->stream);
+    }
+    return true;
+}
+
+static void load_pending_model(AppContext *ctx)
+{
+    char *path = SDL_SetAtomicPointer(&ctx->pending_model_path, NULL);
+    if (!path)
+    {
+        return;
+    }
+    frame_arena_warmup();
+
+    /* Release previous model if any; its textures reference its data */
+    texture_streamer_clear(ctx->textures);
+    mesh_renderer_clear(ctx->meshes);
+    occlusion_set_occluders(ctx->occlusion, NULL, 0);
+    meshlet_stream_close(ctx->stream);
+    ctx->stream = NULL;
+    animation_instance_free(ctx->animation);
+    ctx->animation = NULL;
+    scene_bvh_free(ctx->bvh);
+    ctx->bvh = NULL;
+    mesh_picker_free(ctx->picker);
+    ctx->picker = NULL;
+    ctx->picked = false;
+    asset_cache_release_model(ctx->assets, ctx->model);
+    ctx->model = NULL;
+    if (open_stream(ctx, path))
+    {
+        SDL_free(path);
+        return;
+    }
+    ctx->model = asset_cache_acquire_model(ctx->assets, path);
+    SDL_free(path);
+
+    if (ctx->model)
+    {
+        texture_streamer_load(ctx->textures, ctx->model);
+        if (ctx->model->animation && ctx->model->animation->clip_count > 0)
+        {
+            ctx->animation = animation_instance_create(ctx->model->animation);
+            if (ctx->animation)
+            {
+                animation_instance_play(ctx->animation, 0, 0, 1.0f, true);
+            }
+        }
+        ctx->bvh = scene_bvh_build_model(ctx->model);
+        if (ctx->bvh)
+        {
+            SDL_Log("  bvh: %zu primitives, %zu nodes in %.2f ms", ctx->bvh->item_count, ctx->bvh->node_count,
+                    ctx->bvh->stats.build_ms);
+            occlusion_select_occluders(ctx->occlusion, ctx->model, ctx->bvh, OCCLUSION_DEFAULT_OCCLUDERS);
+            if (ctx->meshes)
+            {
+                mesh_renderer_set_model(ctx->meshes, ctx->model, ctx->bvh);
+            }
+        }
+        ctx->picker = mesh_picker_create(ctx->model);
+        if (ctx->picker)
+        {
+            const MeshPickerStats *pick = mesh_picker_stats(ctx->picker);
+            SDL_Log("  picking: %llu triangles, %zu nodes (%.1f MB) in %.2f ms", (unsigned long long)pick->triangles,
+                    pick->nodes, (double)pick->bytes / (1024.0 * 1024.0), pick->build_ms);
+        }
+    }
+}
+
+/* Closest model triangle under a position in window coordinates, as in
+   mouse events (capture pixels when headless). Rays use the last frame's
+   camera and the bounds of the last refit. */
+static bool pick_at(void *userdata, float x, float y, MeshPick *hit)
+{
+    AppContext *ctx = userdata;
+    if (!ctx->picker || !ctx->bvh || !ctx->model)
+    {
+        return false;
+    }
+    int w = 0, h = 0;
+    if (ctx->window)
+    {
+        SDL_GetWindowSize(ctx->window, &w, &h);
+    }
+    else if (ctx->capture)
+    {
+        w = (int)frame_capture_width(ctx->capture);
+        h = (int)frame_capture_height(ctx->capture);
+    }
+    float origin[3], dir[3];
+    if (w <= 0 || h <= 0 || !mesh_pick_ray(&ctx->view_proj, x / (float)w, y / (float)h, origin, dir))
+    {
+        return false;
+    }
+    return mesh_picker_raycast(ctx->picker, ctx->bvh, ctx->model->scene, origin, dir, hit);
+}
+
+/* Slow orbit around the scene bounds until there is a real camera */
+static void update_camera(AppContext *ctx)
+{
+    float center[3] = {0.0f, 0.0f, 0.0f};
+    float radius = 1.0f;
+    if (ctx->stream)
+    {
+        float min[3], max[3], extent = 0.0f;
+        meshlet_stream_bounds(ctx->stream, min, max);
+        for (int a = 0; a < 3; a++)
+        {
+            center[a] = (min[a] + max[a]) * 0.5f;
+            extent += (max[a] - min[a]) * (max[a] - min[a]);
+        }
+        radius = SDL_max(SDL_sqrtf(extent) * 0.5f, 0.01f);
+    }
+    else if (ctx->bvh && ctx->bvh->node_count > 0)
+    {
+        const SceneBvhNode *root = &ctx->bvh->nodes[0];
+        float extent = 0.0f;
+        for (int a = 0; a < 3; a++)
+        {
+            center[a] = (root->min[a] + root->max[a]) * 0.5f;
+            extent += (root->max[a] - root->min[a]) * (root->max[a] - root->min[a]);
+        }
+        radius = SDL_max(SDL_sqrtf(extent) * 0.5f, 0.01f);
+    }
+
+    int w = 1, h = 1;
+    if (ctx->capture)
+    {
+        w = (int)frame_capture_width(ctx->capture);
+        h = (int)frame_capture_height(ctx->capture);
+    }
+    else
+    {
+        SDL_GetWindowSizeInPixels(ctx->window, &w, &h);
+    }
+    /* Follows simulated time, so the orbit is the same at any frame rate */
+    float angle = (float)SDL_fmod(ctx->render_time * 0.2, 2.0 * SDL_PI_D);
+    float eye[3] = {center[0] + SDL_cosf(angle) * radius * 1.5f, center[1] + radius * 0.5f,
+                    center[2] + SDL_sinf(angle) * radius * 1.5f};
+    float up[3] = {0.0f, 1.0f, 0.0f};
+
+    Mat4 view, proj;
+    mat4_look_at(&view, eye, center, up);
+    mat4_perspective(&proj, 60.0f * SDL_PI_F / 180.0f, (float)w / (float)SDL_max(h, 1), radius * 0.01f,
+                     radius * 10.0f);
+    mat4_mul(&ctx->view_proj, &proj, &view);
+    SDL_memcpy(ctx->eye, eye, sizeof(ctx->eye));
+    ctx->pixel_scale = (float)h / (2.0f * SDL_tanf(30.0f * SDL_PI_F / 180.0f));
+}
+
+static void update_scene(AppContext *ctx, float dt)
+{
+    update_camera(ctx);
+    meshlet_stream_update(ctx->stream, &ctx->view_proj, ctx->eye, ctx->pixel_scale);
+    if (!ctx->model || !ctx->bvh)
+    {
+        return;
+    }
+
+    if (ctx->animation)
+    {
+        animation_update(&ctx->animation, 1, dt);
+        animation_instance_apply(ctx->animation, ctx->model->scene);
+    }
+    scene_graph_update(ctx->model->scene);
+    scene_bvh_refit(ctx->bvh, ctx->model->scene);
+
+    /* In GPU mode the compute pass culls, so the CPU result is not needed */
+    mesh_renderer_set_cull_mode(ctx->meshes, ctx->gpu_culling ? MESH_CULL_GPU : MESH_CULL_CPU);
+    if (!ctx->meshes || !ctx->gpu_culling)
+    {
+        scene_bvh_cull(ctx->bvh, &ctx->view_proj);
+        if (ctx->cpu_occlusion)
+        {
+            occlusion_cull(ctx->occlusion, ctx->bvh, ctx->model->scene, &ctx->view_proj);
+        }
+    }
+}
+
+/* Run the fixed ticks that `dt` seconds of frame time cover: Lua's
+   Update(dt, tick) and the simulated clock. The frame is then drawn at
+   render_time, between the last two ticks by the leftover fraction. */
+static void run_simulation(AppContext *ctx, double dt)
+{
+    double step = 1.0 / (double)ctx->sim_hz;
+    if (dt > SIM_MAX_FRAME_SECONDS)
+    {
+        /* A stall past the catch-up window is dropped too, and counted */
+        ctx->sim_dropped += (Uint64)((dt - SIM_MAX_FRAME_SECONDS) / step + 0.5);
+        dt = SIM_MAX_FRAME_SECONDS;
+    }
+    ctx->sim_accumulator += dt;
+    Uint32 ticks = 0;
+    while (ctx->sim_accumulator >= step)
+    {
+        if (ticks == SIM_MAX_TICKS)
+        {
+            /* Too far behind: drop the rest rather than spiral */
+            Uint64 behind = (Uint64)(ctx->sim_accumulator / step);
+            ctx->sim_dropped += behind;
+            ctx->sim_accumulator -= (double)behind * step;
+            break;
+        }
+        ctx->sim_accumulator -= step;
+        ctx->sim_prev_time = ctx->sim_time;
+        ctx->sim_tick++;
+        ctx->sim_time = (double)ctx->sim_tick * step;
+        input_begin_tick();
+        lua_script_update(ctx->L, (float)step, ctx->sim_tick);
+        ticks++;
+    }
+    ctx->sim_ticks_last_frame = ticks;
+
+    double alpha = SDL_min(ctx->sim_accumulator / step, 1.0);
+    ctx->render_time = ctx->sim_prev_time + (ctx->sim_time - ctx->sim_prev_time) * alpha;
+}
+
+/* CUMULUS_HEADLESS=1 renders offscreen at the window's default size,
+   =<w>x<h> at that size. Returns the CUMULUS_CAPTURE_* readback setup,
+   or NULL with a window. */
+static FrameCapture *create_headless_capture(SDL_GPUDevice *device, Uint32 frames)
+{
+    const char *v = SDL_getenv("CUMULUS_HEADLESS");
+    unsigned width = WINDOW_WIDTH, height = WINDOW_HEIGHT;
+    if (v && SDL_strchr(v, 'x') && (SDL_sscanf(v, "%ux%u", &width, &height) != 2 || width == 0 || height == 0))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "CUMULUS_HEADLESS=%s is not <width>x<height>", v);
+        return NULL;
+    }
+
+    const char *format = SDL_getenv("CUMULUS_CAPTURE_FORMAT");
+    FrameCaptureDump dump = format && SDL_strcasecmp(format, "raw") == 0 ? FRAME_CAPTURE_DUMP_RAW
+                                                                          : FRAME_CAPTURE_DUMP_PNG;
+    return frame_capture_create(device, width, height, SDL_getenv("CUMULUS_CAPTURE_DIR"), dump,
+                                env_uint("CUMULUS_CAPTURE_FROM", frames - 1));
 }
 
 AppContext *app_init(void)
 {
+    Uint64 startup = bench_now();
+    if (!frame_arena_init(FRAME_ARENA_SIZE))
+    {
+        return NULL;
+    }
+    residency_init();
     SDL_SetAppMetadata(WINDOW_TITLE, "0.0.1", "com.arda.cumulus");
 
-    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS))
+    /* Headless runs need neither a display nor a video driver */
+    const char *headlessEnv = SDL_getenv("CUMULUS_HEADLESS");
+    bool headless = headlessEnv && headlessEnv[0] && headlessEnv[0] != '0';
+    if (!SDL_Init(headless ? SDL_INIT_EVENTS : SDL_INIT_VIDEO | SDL_INIT_EVENTS))
     {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't initialize SDL: %s", SDL_GetError());
         return NULL;
     }
 
-    SDL_Window *window = SDL_CreateWindow(WINDOW_TITLE, WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_RESIZABLE);
-
-    if (!window)
+    SDL_Window *window = NULL;
+    if (!headless)
     {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create window: %s", SDL_GetError());
-        return NULL;
+        window = SDL_CreateWindow(WINDOW_TITLE, WINDOW_WIDTH, WINDOW_HEIGHT,
+                                  SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY);
+        if (!window)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create window: %s", SDL_GetError());
+            return NULL;
+        }
     }
 
     SDL_GPUShaderFormat shaderFormats =
@@ -77,62 +385,563 @@ AppContext *app_init(void)
 
     SDL_Log("Using %s GPU implementation.", SDL_GetGPUDeviceDriver(device));
 
-    if (!SDL_ClaimWindowForGPUDevice(device, window))
+    parallel_init(0);
+
+    if (bench_enabled())
     {
-        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_ClaimWindowForGPUDevice failed: %s", SDL_GetError());
-        return NULL;
+        parallel_benchmark();
+        scene_graph_benchmark(100000);
+        scene_bvh_benchmark();
+        occlusion_benchmark();
+        animation_benchmark(1000);
+        mesh_renderer_benchmark();
+        render_graph_benchmark();
+        glyph_cache_benchmark();
+        input_benchmark();
+        ecs_benchmark(100000);
+        lua_ecs_benchmark(100000);
+        meshlet_stream_benchmark(16u * 1024u * 1024u);
+        mesh_bvh_benchmark(5000000);
     }
 
-    SDL_SetGPUSwapchainParameters(device, window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, SDL_GPU_PRESENTMODE_VSYNC);
+    Uint32 frameLimit = headless ? SDL_max(env_uint("CUMULUS_FRAMES", 1), 1) : 0;
+    FrameCapture *capture = NULL;
+    SDL_GPUTextureFormat colorFormat = FRAME_CAPTURE_FORMAT;
+    if (headless)
+    {
+        capture = create_headless_capture(device, frameLimit);
+        if (!capture)
+        {
+            return NULL;
+        }
+        SDL_Log("Headless: %ux%u offscreen, %u frames", frame_capture_width(capture), frame_capture_height(capture),
+                frameLimit);
+    }
+    else
+    {
+        if (!SDL_ClaimWindowForGPUDevice(device, window))
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "SDL_ClaimWindowForGPUDevice failed: %s", SDL_GetError());
+            return NULL;
+        }
+        SDL_SetGPUSwapchainParameters(device, window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, SDL_GPU_PRESENTMODE_VSYNC);
+        colorFormat = SDL_GetGPUSwapchainTextureFormat(device, window);
+    }
+
+    /* Create every pipeline now, so none is compiled once frames start */
+    char *cache_path = pipeline_cache_default_path();
+    PipelineCache *pipelines = pipeline_cache_create(device, cache_path);
+    SDL_free(cache_path);
+    if (!pipelines)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create the pipeline cache");
+        return NULL;
+    }
 
     AppContext *ctx = SDL_malloc(sizeof(AppContext));
     ctx->window = window;
     ctx->device = device;
-    ctx->L = lua_script_init();
+    ctx->pipelines = pipelines;
+    ctx->world = ecs_world_create();
+    ctx->L = lua_script_init(ctx->world);
+    lua_script_set_pick(ctx->L, pick_at, ctx);
     ctx->model = NULL;
-    mu_sdl3_gpu_init(device, window, &ctx->mu_ctx);
+    ctx->stream = NULL;
+    ctx->pending_model_path = SDL_getenv("CUMULUS_MODEL") ? SDL_strdup(SDL_getenv("CUMULUS_MODEL")) : NULL;
+    ctx->bvh = NULL;
+    ctx->picker = NULL;
+    ctx->picked = false;
+    ctx->animation = NULL;
+    ctx->last_frame_ns = 0;
+    ctx->sim_hz = SDL_max(env_uint("CUMULUS_SIM_HZ", SIM_DEFAULT_HZ), 1);
+    ctx->sim_tick = 0;
+    ctx->sim_ticks_last_frame = 0;
+    ctx->sim_dropped = 0;
+    ctx->sim_accumulator = 0.0;
+    ctx->sim_time = 0.0;
+    ctx->sim_prev_time = 0.0;
+    ctx->render_time = 0.0;
+    ctx->textures = texture_streamer_create(device);
+    ctx->assets = asset_cache_create(device);
+    ctx->meshes = mesh_renderer_create(device, pipelines, ctx->assets, colorFormat);
+    ctx->gpu_culling = 1;
+    ctx->occlusion = occlusion_create(OCCLUSION_DEFAULT_WIDTH, OCCLUSION_DEFAULT_HEIGHT);
+    ctx->cpu_occlusion = env_uint("CUMULUS_OCCLUSION", 0) != 0;
+    ctx->graph = render_graph_create(device);
+    ctx->dump_graph = false;
+    ctx->tool_count = 0;
+    ctx->capture = capture;
+    SDL_zeroa(ctx->frame_fences);
+    ctx->frames_submitted = 0;
+    ctx->frame_limit = frameLimit;
+    ctx->frame_count = 0;
+    ctx->first_frame = 0;
+    mu_sdl3_gpu_init(device, colorFormat, pipelines);
+    input_init(mu_sdl3_gpu_handle_event);
+    ctx->ui = window ? mu_sdl3_gpu_add_window(window, &ctx->mu_ctx)
+                     : mu_sdl3_gpu_add_target(&ctx->mu_ctx, frame_capture_width(capture),
+                                              frame_capture_height(capture), 1.0f);
+
+    pipeline_cache_seal(pipelines);
+    const PipelineCacheStats *cache = pipeline_cache_stats(pipelines);
+    SDL_Log("Startup: %.1f ms; pipelines: %u prewarmed in %.1f ms, %u hits, %u created in %.1f ms",
+            bench_ms_since(startup), cache->prewarmed, cache->prewarm_ms, cache->hits, cache->misses,
+            cache->create_ms);
 
     return ctx;
 }
 
+/* Userdata shared by this frame's graph passes */
+typedef struct FramePasses
+{
+    AppContext *ctx;
+    RenderGraphResource swapchain; /* or the offscreen target */
+} FramePasses;
+
+static void ui_upload_pass(const RenderGraphContext *g, void *userdata)
+{
+    (void)userdata;
+    mu_sdl3_gpu_copy(g->copy);
+}
+
+static void texture_stream_pass(const RenderGraphContext *g, void *userdata)
+{
+    FramePasses *frame = userdata;
+    texture_streamer_pump(frame->ctx->textures, g->copy);
+}
+
+static void mesh_upload_pass(const RenderGraphContext *g, void *userdata)
+{
+    FramePasses *frame = userdata;
+    mesh_renderer_upload(frame->ctx->meshes, g->copy);
+}
+
+static void mesh_pass(const RenderGraphContext *g, void *userdata)
+{
+    FramePasses *frame = userdata;
+    mesh_renderer_draw(frame->ctx->meshes, g->cmd, render_graph_texture(g->graph, frame->swapchain), CLEAR_COLOR,
+                       &frame->ctx->view_proj);
+}
+
+static void readback_pass(const RenderGraphContext *g, void *userdata)
+{
+    FramePasses *frame = userdata;
+    frame_capture_download(frame->ctx->capture, g->copy);
+}
+
+/* userdata is the window's MuSDL3GPU_Window */
+static void ui_pass(const RenderGraphContext *g, void *userdata)
+{
+    mu_sdl3_gpu_render(g->cmd, g->render, userdata);
+}
+
+/* The frame's one submission; its fence is lent to everything that read
+   back from it and released once the ring comes round */
+static void submit_frame(AppContext *ctx, SDL_GPUCommandBuffer *cmdBuf)
+{
+    SDL_GPUFence **fence = &ctx->frame_fences[ctx->frames_submitted++ % APP_FRAME_FENCES];
+    if (*fence)
+    {
+        SDL_ReleaseGPUFence(ctx->device, *fence);
+    }
+    *fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmdBuf);
+    if (ctx->capture)
+    {
+        frame_capture_submitted(ctx->capture, *fence);
+    }
+    mesh_renderer_submitted(ctx->meshes, *fence);
+}
+
 static SDL_AppResult render_frame(AppContext *ctx, SDL_GPUCommandBuffer *cmdBuf)
 {
-    mu_sdl3_gpu_frame_start(cmdBuf);
-    mu_sdl3_gpu_upload(cmdBuf, &ctx->mu_ctx);
+    mu_sdl3_gpu_prepare(ctx->ui);
+    for (int i = 0; i < ctx->tool_count; i++)
+    {
+        mu_sdl3_gpu_prepare(ctx->tools[i]->ui);
+    }
 
+    /* Only the main window waits for a swapchain image; tool windows take
+       one if it is ready and otherwise skip this frame. All of them are
+       presented by the one submission below. Headless, the offscreen
+       target stands in for the main window's swapchain. */
     SDL_GPUTexture *swapchainTexture;
-    if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmdBuf, ctx->window, &swapchainTexture, NULL, NULL))
+    Uint32 width, height;
+    if (ctx->capture)
+    {
+        frame_capture_begin(ctx->capture);
+        swapchainTexture = frame_capture_texture(ctx->capture);
+        width = frame_capture_width(ctx->capture);
+        height = frame_capture_height(ctx->capture);
+    }
+    else if (!SDL_WaitAndAcquireGPUSwapchainTexture(cmdBuf, ctx->window, &swapchainTexture, &width, &height))
     {
         SDL_Log("SDL_WaitAndAcquireGPUSwapchainTexture failed: %s", SDL_GetError());
         return SDL_APP_FAILURE;
     }
+    SDL_GPUTexture *toolTextures[APP_MAX_TOOL_WINDOWS] = {NULL};
+    for (int i = 0; i < ctx->tool_count; i++)
+    {
+        if (!SDL_AcquireGPUSwapchainTexture(cmdBuf, ctx->tools[i]->window, &toolTextures[i], NULL, NULL))
+        {
+            SDL_Log("SDL_AcquireGPUSwapchainTexture failed for a tool window: %s", SDL_GetError());
+        }
+    }
+
+    /* Uploads are copy passes the graph batches into one; without a
+       swapchain texture (minimized window) only they run. The UI upload
+       covers every window. */
+    RenderGraph *g = ctx->graph;
+    FramePasses frame = {ctx, RENDER_GRAPH_NONE};
+    render_graph_begin(g);
+    RenderGraphResource uiGeometry = render_graph_import_buffer(g, "ui geometry", NULL);
+    RenderGraphResource modelTextures = render_graph_import_texture(g, "model textures", NULL);
+    RenderGraphResource meshObjects = render_graph_import_buffer(g, "mesh objects", NULL);
+
+    Uint32 pass = render_graph_add_pass(g, "ui upload", RENDER_GRAPH_COPY, ui_upload_pass, &frame);
+    render_graph_write(g, pass, uiGeometry);
+    pass = render_graph_add_pass(g, "texture stream", RENDER_GRAPH_COPY, texture_stream_pass, &frame);
+    render_graph_write(g, pass, modelTextures);
+
+    SDL_FColor clear = {CLEAR_COLOR[0], CLEAR_COLOR[1], CLEAR_COLOR[2], CLEAR_COLOR[3]};
+    bool drawMeshes = swapchainTexture && (ctx->model || ctx->stream) &&
+                      mesh_renderer_prepare(ctx->meshes, width, height, ctx->model ? ctx->model->scene : NULL,
+                                            ctx->bvh);
+    if (drawMeshes)
+    {
+        pass = render_graph_add_pass(g, "mesh upload", RENDER_GRAPH_COPY, mesh_upload_pass, &frame);
+        render_graph_write(g, pass, meshObjects);
+    }
 
     if (swapchainTexture)
     {
-        SDL_GPUColorTargetInfo targetInfo = {
-            .texture = swapchainTexture,
-            .cycle = true,
-            .load_op = SDL_GPU_LOADOP_CLEAR,
-            .store_op = SDL_GPU_STOREOP_STORE,
-            .clear_color = {CLEAR_COLOR[0], CLEAR_COLOR[1], CLEAR_COLOR[2], CLEAR_COLOR[3]},
-        };
+        frame.swapchain = render_graph_import_texture(g, ctx->capture ? "offscreen" : "swapchain", swapchainTexture);
 
-        SDL_GPURenderPass *renderPass = SDL_BeginGPURenderPass(cmdBuf, &targetInfo, 1, NULL);
-        mu_sdl3_gpu_render(cmdBuf, renderPass);
-        SDL_EndGPURenderPass(renderPass);
+        /* The mesh pass clears the target itself; the UI then draws over it */
+        if (drawMeshes)
+        {
+            pass = render_graph_add_pass(g, "meshes", RENDER_GRAPH_CUSTOM, mesh_pass, &frame);
+            render_graph_read(g, pass, meshObjects);
+            render_graph_write(g, pass, frame.swapchain);
+        }
+
+        pass = render_graph_add_pass(g, "ui", RENDER_GRAPH_RENDER, ui_pass, ctx->ui);
+        render_graph_read(g, pass, uiGeometry);
+        render_graph_color_target(g, pass, frame.swapchain, drawMeshes ? SDL_GPU_LOADOP_LOAD : SDL_GPU_LOADOP_CLEAR,
+                                  clear);
+
+        /* Into this frame's readback buffer, mapped two frames later */
+        if (ctx->capture)
+        {
+            RenderGraphResource readback = render_graph_import_buffer(g, "readback", NULL);
+            pass = render_graph_add_pass(g, "readback", RENDER_GRAPH_COPY, readback_pass, &frame);
+            render_graph_read(g, pass, frame.swapchain);
+            render_graph_write(g, pass, readback);
+        }
     }
 
-    SDL_SubmitGPUCommandBuffer(cmdBuf);
+    for (int i = 0; i < ctx->tool_count; i++)
+    {
+        if (!toolTextures[i])
+        {
+            continue;
+        }
+        RenderGraphResource target = render_graph_import_texture(g, "tool swapchain", toolTextures[i]);
+        pass = render_graph_add_pass(g, "tool ui", RENDER_GRAPH_RENDER, ui_pass, ctx->tools[i]->ui);
+        render_graph_read(g, pass, uiGeometry);
+        render_graph_color_target(g, pass, target, SDL_GPU_LOADOP_CLEAR, clear);
+    }
+
+    if (render_graph_compile(g))
+    {
+        if (ctx->dump_graph)
+        {
+            render_graph_log_report(g);
+            ctx->dump_graph = false;
+        }
+        render_graph_execute(g, cmdBuf);
+    }
+    else
+    {
+        SDL_Log("Render graph failed to compile; frame skipped");
+    }
+
+    submit_frame(ctx, cmdBuf);
     return SDL_APP_CONTINUE;
 }
 
+/* Used against budget per residency category, with a bar; categories
+   never used and without a budget are left out */
+static void memory_window(mu_Context *mu)
+{
+    if (!mu_begin_window(mu, "Memory", mu_rect(340, 40, 320, 250)))
+    {
+        return;
+    }
+    const double mb = 1024.0 * 1024.0;
+    char text[64];
+    Uint32 denied = 0;
+    mu_layout_row(mu, 3, (int[]){70, 130, -1}, 0);
+    for (int i = 0; i <= RESIDENCY_CATEGORY_COUNT; i++)
+    {
+        ResidencyStats stats;
+        if (i < RESIDENCY_CATEGORY_COUNT)
+        {
+            residency_stats((ResidencyCategory)i, &stats);
+            denied += stats.denied;
+        }
+        else
+        {
+            residency_total(&stats);
+        }
+        if (!stats.peak && !stats.budget)
+        {
+            continue;
+        }
+
+        if (stats.budget)
+            SDL_snprintf(text, sizeof(text), "%.1f / %.0f MB", stats.used / mb, stats.budget / mb);
+        else
+            SDL_snprintf(text, sizeof(text), "%.1f MB", stats.used / mb);
+        mu_label(mu, stats.name);
+        mu_label(mu, text);
+
+        /* Fill against the budget, or against the peak when unlimited */
+        size_t scale = stats.budget ? stats.budget : stats.peak;
+        double fill = scale ? SDL_min((double)stats.used / (double)scale, 1.0) : 0.0;
+        mu_Rect bar = mu_layout_next(mu);
+        bar.y += bar.h / 4;
+        bar.h /= 2;
+        mu_draw_rect(mu, bar, mu->style->colors[MU_COLOR_BASE]);
+        bar.w = (int)(bar.w * fill);
+        mu_Color color = !stats.budget ? mu_color(120, 120, 120, 255)
+                         : fill > 0.9  ? mu_color(220, 80, 60, 255)
+                                       : mu_color(90, 170, 90, 255);
+        mu_draw_rect(mu, bar, color);
+    }
+
+    ResidencyStats total;
+    residency_total(&total);
+    mu_layout_row(mu, 1, (int[]){-1}, 0);
+    SDL_snprintf(text, sizeof(text), "Peak %.1f MB, %u GPU resources, %u refused", total.peak / mb, total.count,
+                 denied);
+    mu_label(mu, text);
+    mu_end_window(mu);
+}
+
+/* Streaming, culling and frame statistics, shown by the main window and
+   by every tool window */
+static void stats_labels(AppContext *ctx, mu_Context *mu)
+{
+    char text[64];
+    if (ctx->model)
+    {
+        TextureStreamStats stats;
+        texture_streamer_stats(ctx->textures, &stats);
+        if (stats.reduced)
+            SDL_snprintf(text, sizeof(text), "%zu / %zu (%zu reduced)", stats.resident, stats.total, stats.reduced);
+        else
+            SDL_snprintf(text, sizeof(text), "%zu / %zu", stats.resident, stats.total);
+        mu_label(mu, "Textures:");
+        mu_label(mu, text);
+    }
+
+    const AssetCacheStats *assets = ctx->assets ? asset_cache_stats(ctx->assets) : NULL;
+    if (assets && assets->model_hits + assets->model_misses > 0)
+    {
+        Uint32 loads = assets->model_hits + assets->model_misses;
+        SDL_snprintf(text, sizeof(text), "%.0f%% hits, %u idle, %.1f MB GPU", 100.0 * assets->model_hits / loads,
+                     assets->models_idle, (double)assets->gpu_bytes / (1024.0 * 1024.0));
+        mu_label(mu, "Assets:");
+        mu_label(mu, text);
+    }
+
+    if (ctx->bvh && ctx->bvh->item_count > 0 && !(ctx->meshes && ctx->gpu_culling))
+    {
+        const SceneBvhStats *cull = &ctx->bvh->stats;
+        SDL_snprintf(text, sizeof(text), "%.0f%% in %.3f ms",
+                     100.0 * (1.0 - (double)cull->visible / (double)ctx->bvh->item_count), cull->cull_ms);
+        mu_label(mu, "Culled:");
+        mu_label(mu, text);
+        const OcclusionStats *occ = ctx->occlusion && ctx->cpu_occlusion ? occlusion_stats(ctx->occlusion) : NULL;
+        if (occ && occ->occluders > 0)
+        {
+            SDL_snprintf(text, sizeof(text), "%.0f%% in %.2f + %.2f ms",
+                         occ->tested ? 100.0 * occ->culled / occ->tested : 0.0, occ->raster_ms, occ->test_ms);
+            mu_label(mu, "Occluded:");
+            mu_label(mu, text);
+        }
+    }
+
+    if (ctx->picked)
+    {
+        const MeshPickerStats *pick = mesh_picker_stats(ctx->picker);
+        SDL_snprintf(text, sizeof(text), "node %u, triangle %u in %.3f ms", ctx->pick.node, ctx->pick.triangle,
+                     pick->pick_ms);
+        mu_label(mu, "Picked:");
+        mu_label(mu, text);
+    }
+
+    const MeshRenderStats *draws = ctx->meshes ? mesh_renderer_stats(ctx->meshes) : NULL;
+    if (draws && draws->objects > 0)
+    {
+        SDL_snprintf(text, sizeof(text), "%u for %u objects (%u calls)", draws->draws_emitted, draws->instances,
+                     draws->draw_calls);
+        mu_label(mu, "Draws:");
+        mu_label(mu, text);
+        if (ctx->gpu_culling)
+        {
+            SDL_snprintf(text, sizeof(text), "%u frustum, %u occluded", draws->frustum_culled,
+                         draws->occlusion_culled);
+            mu_label(mu, "Culled:");
+            mu_label(mu, text);
+        }
+    }
+
+    if (ctx->stream)
+    {
+        MeshletStreamStats meshlets;
+        meshlet_stream_stats(ctx->stream, &meshlets);
+        SDL_snprintf(text, sizeof(text), "%u / %u drawn, %u / %u pages", meshlets.drawn, meshlets.visible,
+                     meshlets.resident, meshlets.slots);
+        mu_label(mu, "Meshlets:");
+        mu_label(mu, text);
+    }
+
+    const RenderGraphStats *frame = ctx->graph ? render_graph_stats(ctx->graph) : NULL;
+    if (frame)
+    {
+        SDL_snprintf(text, sizeof(text), "%u passes, %u copies in %u", frame->passes - frame->culled,
+                     frame->copy_passes, frame->copy_batches);
+        mu_label(mu, "Graph:");
+        mu_label(mu, text);
+    }
+
+    SDL_snprintf(text, sizeof(text), "%u Hz, %u ticks, %llu dropped", ctx->sim_hz, ctx->sim_ticks_last_frame,
+                 (unsigned long long)ctx->sim_dropped);
+    mu_label(mu, "Simulation:");
+    mu_label(mu, text);
+
+    const InputStats *input = input_stats();
+    SDL_snprintf(text, sizeof(text), "%u events, %u to the UI", input->received, input->dispatched);
+    mu_label(mu, "Input:");
+    mu_label(mu, text);
+
+    const FrameArenaStats *arena = frame_arena_stats();
+    SDL_snprintf(text, sizeof(text), "%zu / %zu KB", (arena->used + 1023) / 1024, arena->capacity / 1024);
+    mu_label(mu, "Scratch:");
+    mu_label(mu, text);
+}
+
+/* A second OS window on the same device, e.g. for another monitor */
+static void open_tool_window(AppContext *ctx)
+{
+    if (ctx->tool_count == APP_MAX_TOOL_WINDOWS)
+    {
+        return;
+    }
+    AppToolWindow *tool = SDL_calloc(1, sizeof(AppToolWindow));
+    if (!tool)
+    {
+        return;
+    }
+    tool->window = SDL_CreateWindow(WINDOW_TITLE " Stats", TOOL_WINDOW_WIDTH, TOOL_WINDOW_HEIGHT,
+                                    SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY);
+    if (!tool->window || !SDL_ClaimWindowForGPUDevice(ctx->device, tool->window))
+    {
+        SDL_Log("Couldn't open a tool window: %s", SDL_GetError());
+        SDL_DestroyWindow(tool->window);
+        SDL_free(tool);
+        return;
+    }
+    SDL_SetGPUSwapchainParameters(ctx->device, tool->window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR,
+                                  SDL_GPU_PRESENTMODE_VSYNC);
+    tool->ui = mu_sdl3_gpu_add_window(tool->window, &tool->mu_ctx);
+    if (!tool->ui)
+    {
+        SDL_ReleaseWindowFromGPUDevice(ctx->device, tool->window);
+        SDL_DestroyWindow(tool->window);
+        SDL_free(tool);
+        return;
+    }
+    ctx->tools[ctx->tool_count++] = tool;
+    frame_arena_warmup();
+}
+
+static void close_tool_window(AppContext *ctx, int index)
+{
+    AppToolWindow *tool = ctx->tools[index];
+    ctx->tools[index] = ctx->tools[--ctx->tool_count];
+    frame_arena_warmup();
+    mu_sdl3_gpu_remove_window(tool->ui);
+    SDL_ReleaseWindowFromGPUDevice(ctx->device, tool->window);
+    SDL_DestroyWindow(tool->window);
+    SDL_free(tool);
+}
+
+/* Statistics panel filling the whole tool window */
+static void build_tool_ui(AppContext *ctx, AppToolWindow *tool)
+{
+    int w = 0, h = 0;
+    SDL_GetWindowSizeInPixels(tool->window, &w, &h);
+    float scale = SDL_GetWindowDisplayScale(tool->window);
+    if (scale <= 0.0f)
+    {
+        scale = 1.0f;
+    }
+
+    mu_Context *mu = &tool->mu_ctx;
+    mu_begin(mu);
+    mu_Rect rect = mu_rect(0, 0, (int)((float)w / scale), (int)((float)h / scale));
+    mu_get_container(mu, "Stats")->rect = rect; /* follow the OS window's size */
+    if (mu_begin_window_ex(mu, "Stats", rect, MU_OPT_NOTITLE | MU_OPT_NORESIZE | MU_OPT_NOCLOSE))
+    {
+        mu_layout_row(mu, 2, (int[]){80, -1}, 0);
+        stats_labels(ctx, mu);
+        mu_end_window(mu);
+    }
+    mu_end(mu);
+}
+
 SDL_AppResult app_iterate(AppContext *ctx)
 {
-    lua_script_update(ctx->L);
+    frame_arena_begin();
+    Uint64 now = SDL_GetTicksNS();
+    double dt = ctx->last_frame_ns ? (double)(now - ctx->last_frame_ns) / 1e9 : 0.0;
+    ctx->last_frame_ns = now;
+    if (ctx->capture)
+    {
+        /* Headless frames advance a fixed 60 Hz step, so captures repeat */
+        if (ctx->frame_count == ctx->frame_limit)
+        {
+            return SDL_APP_SUCCESS;
+        }
+        dt = ctx->frame_count ? 1.0 / 60.0 : 0.0;
+        if (ctx->frame_count == 0)
+        {
+            ctx->first_frame = bench_now();
+        }
+        ctx->frame_count++;
+    }
+
+    input_begin_frame();
+    load_pending_model(ctx);
+    if (ctx->model)
+    {
+        /* Streaming creates textures; the frame is not steady until done */
+        TextureStreamStats streaming;
+        texture_streamer_stats(ctx->textures, &streaming);
+        if (streaming.resident + streaming.failed < streaming.total)
+        {
+            frame_arena_warmup();
+        }
+    }
+    double renderTime = ctx->render_time;
+    run_simulation(ctx, dt);
+    update_scene(ctx, (float)(ctx->render_time - renderTime));
 
     /* Build microui UI */
     mu_begin(&ctx->mu_ctx);
-    if (mu_begin_window(&ctx->mu_ctx, "Cumulus", mu_rect(40, 40, 240, 140)))
+    if (mu_begin_window(&ctx->mu_ctx, "Cumulus", mu_rect(40, 40, 280, 200)))
     {
         mu_layout_row(&ctx->mu_ctx, 2, (int[]){80, -1}, 0);
 
@@ -144,15 +953,40 @@ SDL_AppResult app_iterate(AppContext *ctx)
             SDL_Log("File dialog dispatched.\n");
         }
 
-        if (ctx->model)
+        if (ctx->model || ctx->stream)
         {
             mu_label(&ctx->mu_ctx, "Loaded: yes");
         }
 
+        if (ctx->meshes)
+        {
+            mu_label(&ctx->mu_ctx, "Culling:");
+            mu_checkbox(&ctx->mu_ctx, "GPU", &ctx->gpu_culling);
+        }
+        if (ctx->occlusion)
+        {
+            mu_label(&ctx->mu_ctx, "Occlusion:");
+            mu_checkbox(&ctx->mu_ctx, "CPU", &ctx->cpu_occlusion);
+        }
+
+        stats_labels(ctx, &ctx->mu_ctx);
+
+        mu_label(&ctx->mu_ctx, "Windows:");
+        if (mu_button(&ctx->mu_ctx, "New Stats Window"))
+        {
+            open_tool_window(ctx);
+        }
+
         mu_end_window(&ctx->mu_ctx);
     }
+    memory_window(&ctx->mu_ctx);
     mu_end(&ctx->mu_ctx);
 
+    for (int i = 0; i < ctx->tool_count; i++)
+    {
+        build_tool_ui(ctx, ctx->tools[i]);
+    }
+
     /* Render */
     SDL_GPUCommandBuffer *cmdBuf = SDL_AcquireGPUCommandBuffer(ctx->device);
     if (!cmdBuf)
@@ -171,6 +1005,23 @@ SDL_AppResult app_event(AppContext *ctx, SDL_Event *event)
         return SDL_APP_SUCCESS;
     }
 
+    /* Closing the main window quits; closing a tool window just closes it */
+    if (event->type == SDL_EVENT_WINDOW_CLOSE_REQUESTED)
+    {
+        if (event->window.windowID == SDL_GetWindowID(ctx->window))
+        {
+            return SDL_APP_SUCCESS;
+        }
+        for (int i = 0; i < ctx->tool_count; i++)
+        {
+            if (event->window.windowID == SDL_GetWindowID(ctx->tools[i]->window))
+            {
+                close_tool_window(ctx, i);
+                return SDL_APP_CONTINUE;
+            }
+        }
+    }
+
     if (event->type == SDL_EVENT_KEY_DOWN)
     {
         if (event->key.key == SDLK_ESCAPE)
@@ -181,9 +1032,26 @@ SDL_AppResult app_event(AppContext *ctx, SDL_Event *event)
         {
             lua_script_reload(ctx->L);
         }
+        if (event->key.key == SDLK_F2)
+        {
+            ctx->dump_graph = true;
+        }
+    }
+
+    /* Left clicks the UI doesn't take pick the model */
+    if (event->type == SDL_EVENT_MOUSE_BUTTON_DOWN && event->button.button == SDL_BUTTON_LEFT && ctx->window &&
+        event->button.windowID == SDL_GetWindowID(ctx->window) && !ctx->mu_ctx.hover_root)
+    {
+        ctx->picked = pick_at(ctx, event->button.x, event->button.y, &ctx->pick);
+        if (ctx->picked)
+        {
+            SDL_Log("Picked node %u, primitive %u, triangle %u at (%.3f, %.3f, %.3f)", ctx->pick.node,
+                    ctx->pick.primitive, ctx->pick.triangle, ctx->pick.position[0], ctx->pick.position[1],
+                    ctx->pick.position[2]);
+        }
     }
 
-    mu_sdl3_gpu_handle_event(event, &ctx->mu_ctx);
+    input_event(event);
     return SDL_APP_CONTINUE;
 }
 
@@ -196,12 +1064,44 @@ void app_quit(AppContext *ctx)
         return;
     }
 
-    model_free(ctx->model);
+    texture_streamer_destroy(ctx->textures);
+    mesh_renderer_destroy(ctx->meshes);
+    occlusion_destroy(ctx->occlusion);
+    meshlet_stream_close(ctx->stream);
+    animation_instance_free(ctx->animation);
+    scene_bvh_free(ctx->bvh);
+    mesh_picker_free(ctx->picker);
+    asset_cache_release_model(ctx->assets, ctx->model);
+    asset_cache_destroy(ctx->assets);
+    SDL_free(SDL_GetAtomicPointer(&ctx->pending_model_path));
+    parallel_shutdown();
+    while (ctx->tool_count > 0)
+    {
+        close_tool_window(ctx, ctx->tool_count - 1);
+    }
     mu_sdl3_gpu_shutdown();
-    lua_script_shutdown(ctx->L);
+    if (ctx->capture)
+    {
+        SDL_WaitForGPUIdle(ctx->device);
+        double ms = bench_ms_since(ctx->first_frame);
+        SDL_Log("Headless: %u frames in %.1f ms, %.2f ms/frame", ctx->frame_count, ms,
+                ctx->frame_count ? ms / ctx->frame_count : 0.0);
+        frame_capture_destroy(ctx->capture);
+    }
+    render_graph_destroy(ctx->graph);
+    pipeline_cache_destroy(ctx->pipelines);
+    lua_script_shutdown(ctx->L); /* its queries belong to the world */
+    ecs_world_destroy(ctx->world);
 
     if (ctx->device)
     {
+        for (int i = 0; i < APP_FRAME_FENCES; i++)
+        {
+            if (ctx->frame_fences[i])
+            {
+                SDL_ReleaseGPUFence(ctx->device, ctx->frame_fences[i]);
+            }
+        }
         if (ctx->window)
         {
             SDL_ReleaseWindowFromGPUDevice(ctx->device, ctx->window);
@@ -211,5 +1111,7 @@ void app_quit(AppContext *ctx)
     }
 
     SDL_free(ctx);
+    frame_arena_shutdown();
+    residency_shutdown();
     SDL_Quit();
 }
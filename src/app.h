@@ -1,23 +1,100 @@
 #ifndef CUMULUS_APP_H
 #define CUMULUS_APP_H
 
+#include "mesh_bvh.h"
 #include "microui.h"
+#include "vecmath.h"
 #include <SDL3/SDL.h>
 #include <lua.h>
 
-/* Opaque cgltf model handle */
-struct cgltf_data;
+struct Model;
+struct AssetCache;
+struct TextureStreamer;
+struct SceneBvh;
+struct MeshRenderer;
+struct AnimationInstance;
+struct PipelineCache;
+struct RenderGraph;
+struct FrameCapture;
+struct MeshletStream;
+struct OcclusionCuller;
+struct MuSDL3GPU_Window;
+struct EcsWorld;
 
-typedef struct AppContext
+#define APP_MAX_TOOL_WINDOWS 3
+
+/* Fences of the last frames' submissions, kept longer than the mesh
+   renderer (three frames) and the frame capture (two) borrow them */
+#define APP_FRAME_FENCES 4
+
+/* Extra OS window sharing the device, pipelines and atlases, with its own
+   microui context and swapchain */
+typedef struct AppToolWindow
 {
     SDL_Window *window;
+    struct MuSDL3GPU_Window *ui;
+    mu_Context mu_ctx;
+} AppToolWindow;
+
+typedef struct AppContext
+{
+    SDL_Window *window; /* NULL when headless */
     SDL_GPUDevice *device;
     lua_State *L;
+    struct EcsWorld *world; /* entities driven by Lua and native systems */
     mu_Context mu_ctx;
-    struct cgltf_data *model; /* loaded glTF model, NULL if none */
+    struct MuSDL3GPU_Window *ui; /* the main window's microui state */
+    AppToolWindow *tools[APP_MAX_TOOL_WINDOWS];
+    int tool_count;
+    struct Model *model; /* loaded glTF model, NULL if none */
+    struct MeshletStream *stream;     /* out-of-core geometry drawn instead of a model, NULL if none */
+    struct AssetCache *assets;        /* owns models; released ones stay warm for reloads */
+    void *pending_model_path;         /* set by the file dialog, consumed by app_iterate */
+    struct TextureStreamer *textures; /* streams the model's images to the GPU */
+    struct SceneBvh *bvh;             /* culling hierarchy over the model's primitives */
+    MeshPicker *picker;               /* triangle BVHs of the model's primitives, for picking */
+    MeshPick pick;                    /* last left click on the model, if `picked` */
+    bool picked;
+    struct PipelineCache *pipelines;  /* every shader and pipeline, saved across runs */
+    struct MeshRenderer *meshes;      /* NULL if the device has no shader format we ship */
+    struct RenderGraph *graph;        /* rebuilt every frame; F2 logs its report */
+    bool dump_graph;
+    struct FrameCapture *capture; /* headless: the offscreen target and its readback */
+    SDL_GPUFence *frame_fences[APP_FRAME_FENCES];
+    Uint64 frames_submitted;
+    Uint32 frame_limit;           /* headless: quit after this many frames */
+    Uint32 frame_count;
+    Uint64 first_frame;
+    int gpu_culling;                  /* microui checkbox: compute culling + indirect draws */
+    struct OcclusionCuller *occlusion; /* software occlusion after the CPU frustum cull */
+    int cpu_occlusion;                 /* microui checkbox, CUMULUS_OCCLUSION */
+    struct AnimationInstance *animation; /* plays the model's first clip, NULL if it has none */
+    Uint64 last_frame_ns;
+    Uint32 sim_hz;                  /* fixed simulation rate, CUMULUS_SIM_HZ */
+    Uint64 sim_tick;                /* ticks run so far */
+    Uint32 sim_ticks_last_frame;
+    Uint64 sim_dropped;             /* ticks skipped to catch up after long frames */
+    double sim_accumulator;         /* frame time not yet simulated */
+    double sim_time, sim_prev_time; /* simulated seconds at the last two ticks */
+    double render_time;             /* interpolated between them for this frame */
+    Mat4 view_proj;
+    float eye[3];
+    float pixel_scale; /* viewport height over 2 tan(fovy / 2), for screen-space error */
 } AppContext;
 
-/* Init SDL, window, GPU device, microui, Lua. Returns NULL on failure. */
+/* Init SDL, window, GPU device, microui, Lua. Returns NULL on failure.
+   With CUMULUS_HEADLESS=1 or =<w>x<h> there is no window: frames render
+   offscreen and are read back, CUMULUS_FRAMES of them (default 1), and
+   CUMULUS_CAPTURE_DIR receives the last one, or every one from frame
+   CUMULUS_CAPTURE_FROM, as PNG (CUMULUS_CAPTURE_FORMAT=raw: RGBA8).
+   CUMULUS_MODEL loads a model at startup. Lua and the simulated clock
+   tick at a fixed CUMULUS_SIM_HZ (default 60) whatever the frame rate.
+   CUMULUS_MEMORY_MB and CUMULUS_BUDGET_<CATEGORY>_MB cap the memory the
+   app allocates (see residency.h). .meshlets files are streamed within
+   CUMULUS_STREAM_MB (default 256); with CUMULUS_STREAM=1 a glTF is cooked
+   to <path>.meshlets first and streamed the same way. CUMULUS_OCCLUSION=1
+   starts with software occlusion culling on. A left click on the model
+   picks the triangle under the cursor. */
 AppContext *app_init(void);
 
 /* Per-frame: Lua update, UI, render */
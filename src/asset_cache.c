@@ -0,0 +1,699 @@
+#include "asset_cache.h"
+#include "bench.h"
+#include "model_import.h"
+#include "residency.h"
+
+#include <SDL3/SDL.h>
+#include <cgltf.h>
+
+/* File contents, shared by every path (and reader) with the same bytes */
+typedef struct AssetData
+{
+    void *bytes;
+    size_t size;
+    Uint64 hash;
+    Uint32 refs;
+} AssetData;
+
+typedef struct AssetFile
+{
+    char *path; /* canonical */
+    SDL_Time modified;
+    AssetData *data;
+} AssetFile;
+
+typedef struct AssetModel
+{
+    char *path; /* canonical */
+    Uint64 hash; /* of the main file */
+    SDL_Time modified;
+    bool self_contained; /* no external buffers or images: content hash alone identifies it */
+    bool stale;          /* file changed while in use; freed on last release */
+    Model *model;
+    Uint32 refs;
+    Uint64 last_used; /* LRU stamp, set when refs drops to 0 */
+} AssetModel;
+
+typedef struct AssetBuffer
+{
+    Uint64 key;
+    SDL_GPUBuffer *buffer;
+    SDL_GPUBufferUsageFlags usage;
+    Uint32 size;
+    Uint32 refs;
+    bool ready;
+    Uint64 last_used;
+} AssetBuffer;
+
+struct AssetCache
+{
+    SDL_GPUDevice *device;
+    AssetData **data;
+    Uint32 data_count, data_capacity;
+    AssetFile *files;
+    Uint32 file_count, file_capacity;
+    AssetModel *models;
+    Uint32 model_count, model_capacity;
+    AssetBuffer *buffers;
+    Uint32 buffer_count, buffer_capacity;
+    Uint64 clock;
+    AssetCacheStats stats;
+};
+
+/* Room for one more element in a growable array */
+static bool reserve(void **items, Uint32 *capacity, Uint32 count, size_t item_size)
+{
+    if (count < *capacity)
+        return true;
+    Uint32 grown = *capacity ? *capacity * 2 : 16;
+    void *resized = SDL_realloc(*items, grown * item_size);
+    if (!resized)
+        return false;
+    *items = resized;
+    *capacity = grown;
+    return true;
+}
+
+static void recount(AssetCache *cache)
+{
+    AssetCacheStats *s = &cache->stats;
+    s->models_live = s->models_idle = 0;
+    for (Uint32 i = 0; i < cache->model_count; i++)
+    {
+        if (cache->models[i].refs)
+            s->models_live++;
+        else
+            s->models_idle++;
+    }
+    s->file_bytes = 0;
+    for (Uint32 i = 0; i < cache->data_count; i++)
+        s->file_bytes += cache->data[i]->size;
+    s->gpu_bytes = s->gpu_idle_bytes = 0;
+    for (Uint32 i = 0; i < cache->buffer_count; i++)
+    {
+        s->gpu_bytes += cache->buffers[i].size;
+        if (!cache->buffers[i].refs)
+            s->gpu_idle_bytes += cache->buffers[i].size;
+    }
+}
+
+/*================================================================================
+ * Hashing and paths
+ *================================================================================*/
+static Uint64 mix64(Uint64 h)
+{
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+Uint64 asset_hash(const void *data, size_t size, Uint64 seed)
+{
+    const Uint8 *p = data;
+    Uint64 h = seed ^ (size * 0x9E3779B97F4A7C15ull);
+    for (; size >= 8; size -= 8, p += 8)
+    {
+        Uint64 word;
+        SDL_memcpy(&word, p, 8);
+        h ^= word * 0x87C37B91114253D5ull;
+        h = ((h << 31) | (h >> 33)) * 0x4CF5AD432745937Full;
+    }
+    Uint64 tail = 0;
+    if (size)
+        SDL_memcpy(&tail, p, size);
+    return mix64(h ^ tail);
+}
+
+/* Absolute, with '/' separators and no "." or ".." segments, so every
+   spelling of a path finds the same entry */
+static char *canonical_path(const char *path)
+{
+    bool absolute = path[0] == '/' || path[0] == '\\' || (path[0] && path[1] == ':');
+    char *cwd = absolute ? NULL : SDL_GetCurrentDirectory();
+    size_t len = (cwd ? SDL_strlen(cwd) : 0) + SDL_strlen(path) + 2;
+    char *out = SDL_malloc(len);
+    if (!out)
+    {
+        SDL_free(cwd);
+        return NULL;
+    }
+    SDL_snprintf(out, len, "%s/%s", cwd ? cwd : "", path);
+    SDL_free(cwd);
+    for (char *c = out; *c; c++)
+    {
+        if (*c == '\\')
+            *c = '/';
+    }
+
+    /* Collapse in place; output never overtakes input. A drive letter
+       stands in for the leading '/'. */
+    const char *p = out;
+    while (*p == '/')
+        p++;
+    bool root = !(p[0] && p[1] == ':');
+    size_t n = root ? 1 : 0;
+    while (*p)
+    {
+        while (*p == '/')
+            p++;
+        const char *seg = p;
+        while (*p && *p != '/')
+            p++;
+        size_t seg_len = (size_t)(p - seg);
+        if (seg_len == 0 || (seg_len == 1 && seg[0] == '.'))
+            continue;
+        if (seg_len == 2 && seg[0] == '.' && seg[1] == '.')
+        {
+            size_t base = root ? 1 : 0;
+            while (n > base && out[n - 1] != '/')
+                n--;
+            if (n > base)
+                n--;
+            continue;
+        }
+        if (n > 0 && out[n - 1] != '/')
+            out[n++] = '/';
+        SDL_memmove(out + n, seg, seg_len);
+        n += seg_len;
+    }
+    out[n] = '\0';
+    return out;
+}
+
+/*================================================================================
+ * Files
+ *================================================================================*/
+static AssetData *find_data(const AssetCache *cache, const void *bytes, Uint32 *index)
+{
+    for (Uint32 i = 0; i < cache->data_count; i++)
+    {
+        if (cache->data[i]->bytes == bytes)
+        {
+            if (index)
+                *index = i;
+            return cache->data[i];
+        }
+    }
+    return NULL;
+}
+
+static void remove_file(AssetCache *cache, Uint32 index)
+{
+    SDL_free(cache->files[index].path);
+    cache->files[index] = cache->files[--cache->file_count];
+}
+
+/* Cache `bytes` (taking ownership) or share an identical copy. `size`
+   bytes of the model budget are already reserved; sharing returns them. */
+static AssetData *intern_data(AssetCache *cache, void *bytes, size_t size)
+{
+    Uint64 hash = asset_hash(bytes, size, 0);
+    for (Uint32 i = 0; i < cache->data_count; i++)
+    {
+        AssetData *d = cache->data[i];
+        if (d->hash == hash && d->size == size && SDL_memcmp(d->bytes, bytes, size) == 0)
+        {
+            SDL_free(bytes);
+            residency_release(RESIDENCY_MODELS, size);
+            cache->stats.file_shared++;
+            return d;
+        }
+    }
+
+    AssetData *d = SDL_calloc(1, sizeof(AssetData));
+    if (!d || !reserve((void **)&cache->data, &cache->data_capacity, cache->data_count, sizeof(AssetData *)))
+    {
+        SDL_free(d);
+        SDL_free(bytes);
+        residency_release(RESIDENCY_MODELS, size);
+        return NULL;
+    }
+    d->bytes = bytes;
+    d->size = size;
+    d->hash = hash;
+    cache->data[cache->data_count++] = d;
+    return d;
+}
+
+const void *asset_cache_read_file(AssetCache *cache, const char *path, size_t *size)
+{
+    char *canonical = canonical_path(path);
+    SDL_PathInfo info;
+    if (!canonical || !SDL_GetPathInfo(canonical, &info) || info.type != SDL_PATHTYPE_FILE)
+    {
+        SDL_free(canonical);
+        return NULL;
+    }
+
+    for (Uint32 i = 0; i < cache->file_count; i++)
+    {
+        AssetFile *file = &cache->files[i];
+        if (SDL_strcmp(file->path, canonical) != 0)
+            continue;
+        if (file->modified == info.modify_time && file->data->size == info.size)
+        {
+            SDL_free(canonical);
+            cache->stats.file_hits++;
+            file->data->refs++;
+            *size = file->data->size;
+            return file->data->bytes;
+        }
+        /* Changed on disk; readers of the old bytes keep them */
+        remove_file(cache, i);
+        break;
+    }
+
+    if (!residency_reserve(RESIDENCY_MODELS, info.size))
+    {
+        SDL_Log("Assets: '%s' (%.1f MB) does not fit the model budget", canonical,
+                (double)info.size / (1024.0 * 1024.0));
+        SDL_free(canonical);
+        return NULL;
+    }
+    size_t loaded = 0;
+    void *bytes = SDL_LoadFile(canonical, &loaded);
+    if (!bytes)
+        residency_release(RESIDENCY_MODELS, info.size);
+    else if (loaded < info.size) /* the file may have changed since */
+        residency_release(RESIDENCY_MODELS, info.size - loaded);
+    else if (loaded > info.size && !residency_reserve(RESIDENCY_MODELS, loaded - info.size))
+    {
+        SDL_Log("Assets: '%s' grew to %.1f MB while loading and no longer fits the model budget", canonical,
+                (double)loaded / (1024.0 * 1024.0));
+        residency_release(RESIDENCY_MODELS, info.size);
+        SDL_free(bytes);
+        bytes = NULL;
+    }
+    AssetData *d = bytes ? intern_data(cache, bytes, loaded) : NULL;
+    if (!d || !reserve((void **)&cache->files, &cache->file_capacity, cache->file_count, sizeof(AssetFile)))
+    {
+        SDL_free(canonical);
+        return NULL;
+    }
+    cache->stats.file_misses++;
+    AssetFile *file = &cache->files[cache->file_count++];
+    file->path = canonical;
+    file->modified = info.modify_time;
+    file->data = d;
+    d->refs++;
+    recount(cache);
+    *size = d->size;
+    return d->bytes;
+}
+
+void asset_cache_release_file(AssetCache *cache, const void *bytes)
+{
+    Uint32 index;
+    AssetData *d = bytes ? find_data(cache, bytes, &index) : NULL;
+    if (!d || --d->refs > 0)
+        return;
+
+    for (Uint32 i = cache->file_count; i-- > 0;)
+    {
+        if (cache->files[i].data == d)
+            remove_file(cache, i);
+    }
+    cache->data[index] = cache->data[--cache->data_count];
+    residency_release(RESIDENCY_MODELS, d->size);
+    SDL_free(d->bytes);
+    SDL_free(d);
+    recount(cache);
+}
+
+/*================================================================================
+ * Models
+ *================================================================================*/
+static bool is_external(const char *uri)
+{
+    return uri && SDL_strncmp(uri, "data:", 5) != 0;
+}
+
+static bool self_contained(const Model *model)
+{
+    const cgltf_data *data = model->gltf;
+    for (size_t i = 0; i < data->buffers_count; i++)
+    {
+        if (is_external(data->buffers[i].uri))
+            return false;
+    }
+    for (size_t i = 0; i < data->images_count; i++)
+    {
+        if (is_external(data->images[i].uri))
+            return false;
+    }
+    return true;
+}
+
+static void evict_model(AssetCache *cache, Uint32 index)
+{
+    AssetModel *entry = &cache->models[index];
+    model_free(entry->model); /* releases its files through the cache */
+    SDL_free(entry->path);
+    cache->models[index] = cache->models[--cache->model_count];
+}
+
+static void trim_models(AssetCache *cache)
+{
+    for (;;)
+    {
+        Uint32 idle = 0, oldest = 0;
+        for (Uint32 i = 0; i < cache->model_count; i++)
+        {
+            if (cache->models[i].refs)
+                continue;
+            if (idle++ == 0 || cache->models[i].last_used < cache->models[oldest].last_used)
+                oldest = i;
+        }
+        if (idle <= ASSET_CACHE_IDLE_MODELS)
+            break;
+        SDL_Log("Assets: evicting '%s'", cache->models[oldest].path);
+        evict_model(cache, oldest);
+    }
+    recount(cache);
+}
+
+/* A current entry for the file: by path, or by content when both sides
+   are self-contained. Entries whose file changed are retired. */
+static AssetModel *find_model(AssetCache *cache, const char *path, const SDL_PathInfo *info, const Uint64 *hash)
+{
+    for (Uint32 i = 0; i < cache->model_count; i++)
+    {
+        AssetModel *entry = &cache->models[i];
+        if (entry->stale)
+            continue;
+        if (!hash && SDL_strcmp(entry->path, path) == 0)
+        {
+            if (entry->modified == info->modify_time)
+                return entry;
+            if (entry->refs)
+            {
+                entry->stale = true;
+            }
+            else
+            {
+                evict_model(cache, i);
+                recount(cache);
+            }
+            return NULL;
+        }
+        if (hash && entry->self_contained && entry->hash == *hash)
+            return entry;
+    }
+    return NULL;
+}
+
+Model *asset_cache_acquire_model(AssetCache *cache, const char *path)
+{
+    if (!cache)
+        return model_load(path, NULL);
+
+    Uint64 start = bench_now();
+    char *canonical = canonical_path(path);
+    SDL_PathInfo info;
+    if (!canonical || !SDL_GetPathInfo(canonical, &info))
+    {
+        SDL_Log("Assets: cannot open '%s'", path);
+        SDL_free(canonical);
+        return NULL;
+    }
+
+    AssetModel *entry = find_model(cache, canonical, &info, NULL);
+    if (!entry)
+    {
+        /* Holding the main file across the load makes cgltf's read a hit */
+        size_t size;
+        const void *bytes = asset_cache_read_file(cache, canonical, &size);
+        Uint64 hash = bytes ? find_data(cache, bytes, NULL)->hash : 0;
+        entry = bytes ? find_model(cache, canonical, &info, &hash) : NULL;
+        Model *model = NULL;
+        if (!entry && bytes && reserve((void **)&cache->models, &cache->model_capacity, cache->model_count,
+                                       sizeof(AssetModel)))
+        {
+            model = model_load(canonical, cache);
+        }
+        asset_cache_release_file(cache, bytes);
+
+        if (!entry)
+        {
+            cache->stats.model_misses++;
+            if (!model)
+            {
+                SDL_free(canonical);
+                return NULL;
+            }
+            entry = &cache->models[cache->model_count++];
+            SDL_zerop(entry);
+            entry->path = canonical;
+            entry->hash = hash;
+            entry->modified = info.modify_time;
+            entry->self_contained = self_contained(model);
+            entry->model = model;
+            entry->refs = 1;
+            recount(cache);
+            return model;
+        }
+    }
+
+    SDL_Log("Assets: '%s' %s in %.2f ms", path, entry->refs ? "shared" : "reused from the LRU", bench_ms_since(start));
+    SDL_free(canonical);
+    cache->stats.model_hits++;
+    entry->refs++;
+    recount(cache);
+    return entry->model;
+}
+
+void asset_cache_release_model(AssetCache *cache, Model *model)
+{
+    if (!cache)
+    {
+        model_free(model);
+        return;
+    }
+    if (!model)
+        return;
+
+    for (Uint32 i = 0; i < cache->model_count; i++)
+    {
+        AssetModel *entry = &cache->models[i];
+        if (entry->model != model)
+            continue;
+        if (--entry->refs == 0)
+        {
+            entry->last_used = ++cache->clock;
+            if (entry->stale)
+                evict_model(cache, i);
+            trim_models(cache);
+        }
+        return;
+    }
+    model_free(model); /* not ours */
+}
+
+/*================================================================================
+ * GPU buffers
+ *================================================================================*/
+static AssetBuffer *find_buffer(AssetCache *cache, const SDL_GPUBuffer *buffer)
+{
+    for (Uint32 i = 0; i < cache->buffer_count; i++)
+    {
+        if (cache->buffers[i].buffer == buffer)
+            return &cache->buffers[i];
+    }
+    return NULL;
+}
+
+static void remove_buffer(AssetCache *cache, AssetBuffer *entry)
+{
+    residency_release_buffer(cache->device, entry->buffer);
+    *entry = cache->buffers[--cache->buffer_count];
+}
+
+static void trim_buffers(AssetCache *cache)
+{
+    recount(cache);
+    while (cache->stats.gpu_idle_bytes > ASSET_CACHE_IDLE_GPU_BYTES)
+    {
+        AssetBuffer *oldest = NULL;
+        for (Uint32 i = 0; i < cache->buffer_count; i++)
+        {
+            AssetBuffer *entry = &cache->buffers[i];
+            if (!entry->refs && (!oldest || entry->last_used < oldest->last_used))
+                oldest = entry;
+        }
+        remove_buffer(cache, oldest);
+        recount(cache);
+    }
+}
+
+SDL_GPUBuffer *asset_cache_acquire_buffer(AssetCache *cache, Uint64 key, SDL_GPUBufferUsageFlags usage, Uint32 size,
+                                          bool *needs_upload)
+{
+    for (Uint32 i = 0; i < cache->buffer_count; i++)
+    {
+        AssetBuffer *entry = &cache->buffers[i];
+        if (entry->key == key && entry->usage == usage && entry->size == size)
+        {
+            if (entry->ready)
+                cache->stats.buffer_hits++;
+            entry->refs++;
+            *needs_upload = !entry->ready;
+            recount(cache);
+            return entry->buffer;
+        }
+    }
+
+    if (!reserve((void **)&cache->buffers, &cache->buffer_capacity, cache->buffer_count, sizeof(AssetBuffer)))
+        return NULL;
+    SDL_GPUBufferCreateInfo info;
+    SDL_zero(info);
+    info.usage = usage;
+    info.size = size;
+    SDL_GPUBuffer *buffer = residency_create_buffer(cache->device, &info, RESIDENCY_GEOMETRY);
+    if (!buffer)
+    {
+        SDL_Log("Assets: failed to create %u byte buffer: %s", size, SDL_GetError());
+        return NULL;
+    }
+    cache->stats.buffer_misses++;
+    AssetBuffer *entry = &cache->buffers[cache->buffer_count++];
+    SDL_zerop(entry);
+    entry->key = key;
+    entry->buffer = buffer;
+    entry->usage = usage;
+    entry->size = size;
+    entry->refs = 1;
+    *needs_upload = true;
+    recount(cache);
+    return buffer;
+}
+
+void asset_cache_buffer_ready(AssetCache *cache, SDL_GPUBuffer *buffer)
+{
+    AssetBuffer *entry = find_buffer(cache, buffer);
+    if (entry)
+        entry->ready = true;
+}
+
+void asset_cache_release_buffer(AssetCache *cache, SDL_GPUBuffer *buffer)
+{
+    AssetBuffer *entry = buffer ? find_buffer(cache, buffer) : NULL;
+    if (!entry || --entry->refs > 0)
+        return;
+
+    /* Contents of an unfinished upload are unknown; nobody may reuse them */
+    if (!entry->ready)
+        remove_buffer(cache, entry);
+    else
+        entry->last_used = ++cache->clock;
+    trim_buffers(cache);
+}
+
+/*================================================================================
+ * Memory pressure
+ *================================================================================*/
+static size_t used_by(ResidencyCategory category)
+{
+    ResidencyStats stats;
+    if (category == RESIDENCY_CATEGORY_COUNT)
+        residency_total(&stats);
+    else
+        residency_stats(category, &stats);
+    return stats.used;
+}
+
+/* Idle assets go first, least recently used first: GPU buffers for
+   geometry pressure, models (and the files only they hold) for model
+   pressure, either for the total */
+static size_t evict_idle(void *userdata, ResidencyCategory category, size_t bytes)
+{
+    AssetCache *cache = userdata;
+    size_t before = used_by(category);
+    size_t freed = 0;
+    while (freed < bytes && (category == RESIDENCY_GEOMETRY || category == RESIDENCY_CATEGORY_COUNT))
+    {
+        AssetBuffer *oldest = NULL;
+        for (Uint32 i = 0; i < cache->buffer_count; i++)
+        {
+            AssetBuffer *entry = &cache->buffers[i];
+            if (!entry->refs && (!oldest || entry->last_used < oldest->last_used))
+                oldest = entry;
+        }
+        if (!oldest)
+            break;
+        remove_buffer(cache, oldest);
+        freed = before - SDL_min(used_by(category), before);
+    }
+    while (freed < bytes && (category == RESIDENCY_MODELS || category == RESIDENCY_CATEGORY_COUNT))
+    {
+        Uint32 idle = 0, oldest = 0;
+        for (Uint32 i = 0; i < cache->model_count; i++)
+        {
+            if (cache->models[i].refs)
+                continue;
+            if (idle++ == 0 || cache->models[i].last_used < cache->models[oldest].last_used)
+                oldest = i;
+        }
+        if (!idle)
+            break;
+        SDL_Log("Assets: evicting '%s' under memory pressure", cache->models[oldest].path);
+        evict_model(cache, oldest);
+        freed = before - SDL_min(used_by(category), before);
+    }
+    recount(cache);
+    return freed;
+}
+
+/*================================================================================
+ * Public API
+ *================================================================================*/
+AssetCache *asset_cache_create(SDL_GPUDevice *device)
+{
+    AssetCache *cache = SDL_calloc(1, sizeof(AssetCache));
+    if (!cache)
+        return NULL;
+    cache->device = device;
+    residency_add_evictor(evict_idle, cache);
+    return cache;
+}
+
+void asset_cache_destroy(AssetCache *cache)
+{
+    if (!cache)
+        return;
+
+    residency_remove_evictor(evict_idle, cache);
+    AssetCacheStats *s = &cache->stats;
+    SDL_Log("Assets: %u/%u model hits, %u/%u file hits (%u shared by content), %u/%u buffer hits", s->model_hits,
+            s->model_hits + s->model_misses, s->file_hits, s->file_hits + s->file_misses, s->file_shared,
+            s->buffer_hits, s->buffer_hits + s->buffer_misses);
+
+    while (cache->model_count > 0)
+    {
+        if (cache->models[cache->model_count - 1].refs)
+            SDL_Log("Assets: '%s' still in use at shutdown", cache->models[cache->model_count - 1].path);
+        evict_model(cache, cache->model_count - 1);
+    }
+    while (cache->buffer_count > 0)
+        remove_buffer(cache, &cache->buffers[cache->buffer_count - 1]);
+    for (Uint32 i = 0; i < cache->data_count; i++)
+    {
+        residency_release(RESIDENCY_MODELS, cache->data[i]->size);
+        SDL_free(cache->data[i]->bytes);
+        SDL_free(cache->data[i]);
+    }
+    for (Uint32 i = 0; i < cache->file_count; i++)
+        SDL_free(cache->files[i].path);
+    SDL_free(cache->data);
+    SDL_free(cache->files);
+    SDL_free(cache->models);
+    SDL_free(cache->buffers);
+    SDL_free(cache);
+}
+
+const AssetCacheStats *asset_cache_stats(const AssetCache *cache)
+{
+    return &cache->stats;
+}
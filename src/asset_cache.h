@@ -0,0 +1,73 @@
+#ifndef CUMULUS_ASSET_CACHE_H
+#define CUMULUS_ASSET_CACHE_H
+
+#include <SDL3/SDL.h>
+
+struct Model;
+
+/* Shares loaded assets between their users and keeps recently released
+   ones warm:
+
+   - Files are keyed by canonical path and deduplicated by content hash,
+     so models referencing the same .bin (or copies of it) hold one copy.
+     glTF parsing reads every file through the cache.
+   - Models are refcounted handles keyed by canonical path, or by content
+     hash when the file is self-contained (.glb or embedded buffers).
+   - GPU buffers are keyed by a hash of their contents, so identical
+     geometry is uploaded once.
+
+   Models and GPU buffers whose last reference goes away move to an LRU
+   instead of being freed; acquiring them again is a hit. Files on disk
+   that changed since they were cached are loaded again. Everything runs
+   on the main thread. */
+typedef struct AssetCache AssetCache;
+
+#define ASSET_CACHE_IDLE_MODELS 4
+#define ASSET_CACHE_IDLE_GPU_BYTES (256u << 20)
+
+typedef struct AssetCacheStats
+{
+    Uint32 model_hits; /* acquires served by a live or idle model */
+    Uint32 model_misses;
+    Uint32 models_live;
+    Uint32 models_idle;
+    Uint32 file_hits;   /* reads served by a cached file */
+    Uint32 file_misses;
+    Uint32 file_shared; /* misses whose content was already cached under another path */
+    size_t file_bytes;
+    Uint32 buffer_hits; /* GPU buffers reused without an upload */
+    Uint32 buffer_misses;
+    size_t gpu_bytes; /* live and idle buffers */
+    size_t gpu_idle_bytes;
+} AssetCacheStats;
+
+AssetCache *asset_cache_create(SDL_GPUDevice *device);
+
+/* Frees idle assets. Live models and buffers must have been released. */
+void asset_cache_destroy(AssetCache *cache);
+
+/* Model for `path`, loaded or shared; NULL on failure. Every acquire is
+   matched by a release. A shared model is one object, scene graph
+   included. With a NULL cache this is model_load / model_free. */
+struct Model *asset_cache_acquire_model(AssetCache *cache, const char *path);
+void asset_cache_release_model(AssetCache *cache, struct Model *model);
+
+/* Contents of `path` (canonicalized), shared with other readers. NULL if
+   unreadable. Release with asset_cache_release_file. */
+const void *asset_cache_read_file(AssetCache *cache, const char *path, size_t *size);
+void asset_cache_release_file(AssetCache *cache, const void *data);
+
+/* GPU buffer for content `key` with the given usage and size. Sets
+   *needs_upload when the buffer is new (or its upload never finished);
+   the caller then fills it and calls asset_cache_buffer_ready. */
+SDL_GPUBuffer *asset_cache_acquire_buffer(AssetCache *cache, Uint64 key, SDL_GPUBufferUsageFlags usage, Uint32 size,
+                                          bool *needs_upload);
+void asset_cache_buffer_ready(AssetCache *cache, SDL_GPUBuffer *buffer);
+void asset_cache_release_buffer(AssetCache *cache, SDL_GPUBuffer *buffer);
+
+const AssetCacheStats *asset_cache_stats(const AssetCache *cache);
+
+/* 64-bit content hash, 8 bytes per step */
+Uint64 asset_hash(const void *data, size_t size, Uint64 seed);
+
+#endif /* CUMULUS_ASSET_CACHE_H */
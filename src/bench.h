@@ -0,0 +1,26 @@
+#ifndef CUMULUS_BENCH_H
+#define CUMULUS_BENCH_H
+
+#include <SDL3/SDL.h>
+
+/* Timing helpers shared by the subsystems that log their own cost.
+   Set CUMULUS_BENCH=1 in the environment to also run the slower
+   comparison benchmarks (reference implementations, synthetic scenes). */
+
+static inline bool bench_enabled(void)
+{
+    const char *v = SDL_getenv("CUMULUS_BENCH");
+    return v && v[0] && v[0] != '0';
+}
+
+static inline Uint64 bench_now(void)
+{
+    return SDL_GetPerformanceCounter();
+}
+
+static inline double bench_ms_since(Uint64 start)
+{
+    return (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+#endif /* CUMULUS_BENCH_H */
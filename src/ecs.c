@@ -0,0 +1,807 @@
+#include "ecs.h"
+#include "bench.h"
+#include "parallel.h"
+#include "residency.h"
+
+#include <SDL3/SDL.h>
+
+#define ECS_NAME_MAX 32
+#define ECS_NONE 0xFFFFFFFFu /* no archetype / edge / free record */
+#define ECS_NO_COLUMN 0xFF
+#define ECS_MIN_ROWS 64
+
+typedef struct ComponentInfo
+{
+    char name[ECS_NAME_MAX];
+    Uint32 size;
+} ComponentInfo;
+
+/* Entities sharing one component set. Columns are in ascending component
+   order; the edges cache the archetype one component away. */
+typedef struct Archetype
+{
+    Uint64 mask;
+    Uint32 column_count;
+    EcsComponent components[ECS_MAX_COMPONENTS];
+    Uint8 column_of[ECS_MAX_COMPONENTS]; /* ECS_NO_COLUMN if absent */
+    Uint8 *columns[ECS_MAX_COMPONENTS];
+    EcsEntity *entities;
+    Uint32 count;
+    Uint32 capacity;
+    Uint32 add_edge[ECS_MAX_COMPONENTS];
+    Uint32 remove_edge[ECS_MAX_COMPONENTS];
+} Archetype;
+
+/* Where an entity lives; for dead entities `row` links the free list */
+typedef struct EntityRecord
+{
+    Uint32 archetype; /* ECS_NONE when dead */
+    Uint32 row;
+    Uint32 generation;
+} EntityRecord;
+
+typedef struct QueryChunk
+{
+    Uint32 archetype;
+    Uint32 begin;
+    Uint32 count;
+} QueryChunk;
+
+struct EcsQuery
+{
+    EcsWorld *world;
+    Uint64 with_mask;
+    Uint64 without_mask;
+    Uint32 term_count;
+    EcsComponent terms[ECS_MAX_TERMS];
+    Uint32 archetypes_seen; /* archetypes [0, seen) have been matched */
+    Uint32 *matched;
+    Uint32 matched_count;
+    Uint32 matched_capacity;
+    QueryChunk *chunks;
+    Uint32 chunk_count;
+    Uint32 chunk_capacity;
+};
+
+struct EcsWorld
+{
+    ComponentInfo components[ECS_MAX_COMPONENTS];
+    Uint32 component_count;
+    Archetype **archetypes;
+    Uint32 archetype_count;
+    Uint32 archetype_capacity;
+    EntityRecord *records;
+    Uint32 record_count;
+    Uint32 record_capacity;
+    Uint32 free_head;
+    Uint32 alive;
+    EcsQuery **queries;
+    Uint32 query_count;
+    Uint32 query_capacity;
+    Uint64 version; /* bumped by every structural change */
+};
+
+/* Make room for `needed` elements, at least doubling */
+static bool grow_array(void **array, Uint32 *capacity, Uint32 needed, size_t size)
+{
+    if (needed <= *capacity)
+    {
+        return true;
+    }
+    Uint32 grown = SDL_max(SDL_max(needed, *capacity * 2), 16);
+    void *p = SDL_realloc(*array, (size_t)grown * size);
+    if (!p)
+    {
+        return false;
+    }
+    *array = p;
+    *capacity = grown;
+    return true;
+}
+
+static Uint32 entity_index(EcsEntity entity)
+{
+    return (Uint32)entity;
+}
+
+static Uint32 entity_generation(EcsEntity entity)
+{
+    return (Uint32)(entity >> 32);
+}
+
+static EcsEntity make_entity(Uint32 index, Uint32 generation)
+{
+    return ((EcsEntity)generation << 32) | index;
+}
+
+/* NULL unless `entity` is alive */
+static EntityRecord *find_record(const EcsWorld *world, EcsEntity entity)
+{
+    Uint32 index = entity_index(entity);
+    if (index >= world->record_count)
+    {
+        return NULL;
+    }
+    EntityRecord *record = &world->records[index];
+    if (record->archetype == ECS_NONE || record->generation != entity_generation(entity))
+    {
+        return NULL;
+    }
+    return record;
+}
+
+/*================================================================================
+ * Archetypes
+ *================================================================================*/
+/* Bytes per row: every column plus the entity handle */
+static size_t archetype_row_size(const EcsWorld *world, const Archetype *a)
+{
+    size_t size = sizeof(EcsEntity);
+    for (Uint32 c = 0; c < a->column_count; c++)
+    {
+        size += world->components[a->components[c]].size;
+    }
+    return size;
+}
+
+static bool archetype_reserve(EcsWorld *world, Archetype *a, Uint32 rows)
+{
+    if (rows <= a->capacity)
+    {
+        return true;
+    }
+    Uint32 capacity = SDL_max(SDL_max(rows, a->capacity * 2), ECS_MIN_ROWS);
+    size_t growth = (size_t)(capacity - a->capacity) * archetype_row_size(world, a);
+    if (!residency_reserve(RESIDENCY_ECS, growth))
+    {
+        return false;
+    }
+    for (Uint32 c = 0; c < a->column_count; c++)
+    {
+        Uint8 *column = SDL_realloc(a->columns[c], (size_t)capacity * world->components[a->components[c]].size);
+        if (!column)
+        {
+            residency_release(RESIDENCY_ECS, growth);
+            return false;
+        }
+        a->columns[c] = column;
+    }
+    EcsEntity *entities = SDL_realloc(a->entities, (size_t)capacity * sizeof(EcsEntity));
+    if (!entities)
+    {
+        residency_release(RESIDENCY_ECS, growth);
+        return false;
+    }
+    a->entities = entities;
+    a->capacity = capacity;
+    return true;
+}
+
+static Uint32 find_archetype(EcsWorld *world, Uint64 mask)
+{
+    for (Uint32 i = 0; i < world->archetype_count; i++)
+    {
+        if (world->archetypes[i]->mask == mask)
+        {
+            return i;
+        }
+    }
+
+    if (!grow_array((void **)&world->archetypes, &world->archetype_capacity, world->archetype_count + 1,
+                    sizeof(Archetype *)))
+    {
+        return ECS_NONE;
+    }
+    Archetype *a = SDL_calloc(1, sizeof(Archetype));
+    if (!a)
+    {
+        return ECS_NONE;
+    }
+    a->mask = mask;
+    SDL_memset(a->column_of, ECS_NO_COLUMN, sizeof(a->column_of));
+    SDL_memset(a->add_edge, 0xFF, sizeof(a->add_edge));
+    SDL_memset(a->remove_edge, 0xFF, sizeof(a->remove_edge));
+    for (EcsComponent c = 0; c < ECS_MAX_COMPONENTS; c++)
+    {
+        if (mask & ((Uint64)1 << c))
+        {
+            a->column_of[c] = (Uint8)a->column_count;
+            a->components[a->column_count++] = c;
+        }
+    }
+    world->archetypes[world->archetype_count] = a;
+    return world->archetype_count++;
+}
+
+/* Archetype of `from` with `component` toggled, through the edge cache */
+static Uint32 neighbour(EcsWorld *world, Uint32 from, EcsComponent component)
+{
+    Archetype *a = world->archetypes[from];
+    bool add = !(a->mask & ((Uint64)1 << component));
+    Uint32 *edge = add ? &a->add_edge[component] : &a->remove_edge[component];
+    if (*edge == ECS_NONE)
+    {
+        Uint32 to = find_archetype(world, a->mask ^ ((Uint64)1 << component));
+        if (to == ECS_NONE)
+        {
+            return ECS_NONE;
+        }
+        *edge = to;
+        Archetype *b = world->archetypes[to];
+        (add ? b->remove_edge : b->add_edge)[component] = from;
+    }
+    return *edge;
+}
+
+/* Move the last row into `row` */
+static void archetype_remove_row(EcsWorld *world, Archetype *a, Uint32 row)
+{
+    Uint32 last = --a->count;
+    if (row == last)
+    {
+        return;
+    }
+    for (Uint32 c = 0; c < a->column_count; c++)
+    {
+        Uint32 size = world->components[a->components[c]].size;
+        SDL_memcpy(a->columns[c] + (size_t)row * size, a->columns[c] + (size_t)last * size, size);
+    }
+    a->entities[row] = a->entities[last];
+    world->records[entity_index(a->entities[row])].row = row;
+}
+
+/* Give the entity the components of archetype `to`, keeping shared ones */
+static bool move_entity(EcsWorld *world, EntityRecord *record, Uint32 to)
+{
+    Archetype *src = world->archetypes[record->archetype];
+    Archetype *dst = world->archetypes[to];
+    if (!archetype_reserve(world, dst, dst->count + 1))
+    {
+        return false;
+    }
+    Uint32 row = dst->count++;
+    dst->entities[row] = src->entities[record->row];
+    for (Uint32 c = 0; c < dst->column_count; c++)
+    {
+        EcsComponent component = dst->components[c];
+        Uint32 size = world->components[component].size;
+        Uint8 *value = dst->columns[c] + (size_t)row * size;
+        Uint8 column = src->column_of[component];
+        if (column == ECS_NO_COLUMN)
+        {
+            SDL_memset(value, 0, size);
+        }
+        else
+        {
+            SDL_memcpy(value, src->columns[column] + (size_t)record->row * size, size);
+        }
+    }
+    archetype_remove_row(world, src, record->row);
+    record->archetype = to;
+    record->row = row;
+    return true;
+}
+
+/*================================================================================
+ * World and components
+ *================================================================================*/
+EcsWorld *ecs_world_create(void)
+{
+    EcsWorld *world = SDL_calloc(1, sizeof(EcsWorld));
+    if (!world)
+    {
+        return NULL;
+    }
+    world->free_head = ECS_NONE;
+    /* Archetype 0 holds entities without components */
+    if (find_archetype(world, 0) == ECS_NONE)
+    {
+        ecs_world_destroy(world);
+        return NULL;
+    }
+    return world;
+}
+
+static void query_free(EcsQuery *query)
+{
+    SDL_free(query->matched);
+    SDL_free(query->chunks);
+    SDL_free(query);
+}
+
+void ecs_world_destroy(EcsWorld *world)
+{
+    if (!world)
+    {
+        return;
+    }
+    for (Uint32 i = 0; i < world->query_count; i++)
+    {
+        query_free(world->queries[i]);
+    }
+    for (Uint32 i = 0; i < world->archetype_count; i++)
+    {
+        Archetype *a = world->archetypes[i];
+        residency_release(RESIDENCY_ECS, (size_t)a->capacity * archetype_row_size(world, a));
+        for (Uint32 c = 0; c < a->column_count; c++)
+        {
+            SDL_free(a->columns[c]);
+        }
+        SDL_free(a->entities);
+        SDL_free(a);
+    }
+    SDL_free(world->queries);
+    SDL_free(world->archetypes);
+    SDL_free(world->records);
+    SDL_free(world);
+}
+
+EcsComponent ecs_component_find(const EcsWorld *world, const char *name)
+{
+    for (Uint32 i = 0; i < world->component_count; i++)
+    {
+        if (SDL_strcmp(world->components[i].name, name) == 0)
+        {
+            return i;
+        }
+    }
+    return ECS_COMPONENT_NONE;
+}
+
+EcsComponent ecs_component_register(EcsWorld *world, const char *name, Uint32 size)
+{
+    EcsComponent existing = ecs_component_find(world, name);
+    if (existing != ECS_COMPONENT_NONE)
+    {
+        if (world->components[existing].size != size)
+        {
+            SDL_Log("ECS: component %s is already registered with %u bytes", name, world->components[existing].size);
+            return ECS_COMPONENT_NONE;
+        }
+        return existing;
+    }
+    if (size == 0 || SDL_strlen(name) >= ECS_NAME_MAX || world->component_count == ECS_MAX_COMPONENTS)
+    {
+        SDL_Log("ECS: cannot register component %s (%u bytes)", name, size);
+        return ECS_COMPONENT_NONE;
+    }
+    ComponentInfo *info = &world->components[world->component_count];
+    SDL_strlcpy(info->name, name, sizeof(info->name));
+    info->size = size;
+    return world->component_count++;
+}
+
+Uint32 ecs_component_size(const EcsWorld *world, EcsComponent component)
+{
+    return component < world->component_count ? world->components[component].size : 0;
+}
+
+const char *ecs_component_name(const EcsWorld *world, EcsComponent component)
+{
+    return component < world->component_count ? world->components[component].name : NULL;
+}
+
+/* Component set as a mask; *ok is false if any component is unknown or
+   repeated */
+static Uint64 component_mask(const EcsWorld *world, const EcsComponent *components, int count, bool *ok)
+{
+    Uint64 mask = 0;
+    *ok = true;
+    for (int i = 0; i < count; i++)
+    {
+        Uint64 bit = (Uint64)1 << (components[i] % ECS_MAX_COMPONENTS);
+        if (components[i] >= world->component_count || (mask & bit))
+        {
+            *ok = false;
+            return 0;
+        }
+        mask |= bit;
+    }
+    return mask;
+}
+
+/*================================================================================
+ * Entities
+ *================================================================================*/
+bool ecs_entity_create_many(EcsWorld *world, const EcsComponent *components, int count, Uint32 n, EcsEntity *out)
+{
+    bool ok;
+    Uint64 mask = component_mask(world, components, count, &ok);
+    Uint32 index = ok ? find_archetype(world, mask) : ECS_NONE;
+    if (index == ECS_NONE)
+    {
+        return false;
+    }
+    Archetype *a = world->archetypes[index];
+    world->version++;
+
+    /* Reserve everything first, so the loop below cannot fail halfway */
+    Uint32 reused = 0;
+    for (Uint32 f = world->free_head; f != ECS_NONE && reused < n; f = world->records[f].row)
+    {
+        reused++;
+    }
+    if (!archetype_reserve(world, a, a->count + n) ||
+        !grow_array((void **)&world->records, &world->record_capacity, world->record_count + (n - reused),
+                    sizeof(EntityRecord)))
+    {
+        return false;
+    }
+
+    Uint32 first = a->count;
+    for (Uint32 i = 0; i < n; i++)
+    {
+        Uint32 slot = world->free_head;
+        if (slot != ECS_NONE)
+        {
+            world->free_head = world->records[slot].row;
+        }
+        else
+        {
+            slot = world->record_count++;
+            world->records[slot].generation = 1;
+        }
+        EntityRecord *record = &world->records[slot];
+        record->archetype = index;
+        record->row = a->count++;
+        a->entities[record->row] = make_entity(slot, record->generation);
+        if (out)
+        {
+            out[i] = a->entities[record->row];
+        }
+    }
+    for (Uint32 c = 0; c < a->column_count; c++)
+    {
+        Uint32 size = world->components[a->components[c]].size;
+        SDL_memset(a->columns[c] + (size_t)first * size, 0, (size_t)n * size);
+    }
+    world->alive += n;
+    return true;
+}
+
+EcsEntity ecs_entity_create(EcsWorld *world, const EcsComponent *components, int count)
+{
+    EcsEntity entity = 0;
+    ecs_entity_create_many(world, components, count, 1, &entity);
+    return entity;
+}
+
+void ecs_entity_destroy(EcsWorld *world, EcsEntity entity)
+{
+    EntityRecord *record = find_record(world, entity);
+    if (!record)
+    {
+        return;
+    }
+    world->version++;
+    archetype_remove_row(world, world->archetypes[record->archetype], record->row);
+    record->archetype = ECS_NONE;
+    record->generation = record->generation == SDL_MAX_UINT32 ? 1 : record->generation + 1;
+    record->row = world->free_head;
+    world->free_head = entity_index(entity);
+    world->alive--;
+}
+
+bool ecs_entity_alive(const EcsWorld *world, EcsEntity entity)
+{
+    return find_record(world, entity) != NULL;
+}
+
+Uint32 ecs_entity_count(const EcsWorld *world)
+{
+    return world->alive;
+}
+
+Uint64 ecs_world_version(const EcsWorld *world)
+{
+    return world->version;
+}
+
+static bool toggle_component(EcsWorld *world, EcsEntity entity, EcsComponent component, bool add)
+{
+    EntityRecord *record = find_record(world, entity);
+    if (!record || component >= world->component_count)
+    {
+        return false;
+    }
+    bool has = (world->archetypes[record->archetype]->mask & ((Uint64)1 << component)) != 0;
+    if (has == add)
+    {
+        return false;
+    }
+    world->version++;
+    Uint32 to = neighbour(world, record->archetype, component);
+    return to != ECS_NONE && move_entity(world, record, to);
+}
+
+bool ecs_add(EcsWorld *world, EcsEntity entity, EcsComponent component)
+{
+    return toggle_component(world, entity, component, true);
+}
+
+bool ecs_remove(EcsWorld *world, EcsEntity entity, EcsComponent component)
+{
+    return toggle_component(world, entity, component, false);
+}
+
+void *ecs_get(EcsWorld *world, EcsEntity entity, EcsComponent component)
+{
+    EntityRecord *record = find_record(world, entity);
+    if (!record || component >= world->component_count)
+    {
+        return NULL;
+    }
+    Archetype *a = world->archetypes[record->archetype];
+    Uint8 column = a->column_of[component];
+    if (column == ECS_NO_COLUMN)
+    {
+        return NULL;
+    }
+    return a->columns[column] + (size_t)record->row * world->components[component].size;
+}
+
+/*================================================================================
+ * Queries
+ *================================================================================*/
+EcsQuery *ecs_query_create(EcsWorld *world, const EcsComponent *with, int with_count, const EcsComponent *without,
+                           int without_count)
+{
+    bool with_ok, without_ok;
+    Uint64 with_mask = component_mask(world, with, with_count, &with_ok);
+    Uint64 without_mask = component_mask(world, without, without_count, &without_ok);
+    if (!with_ok || !without_ok || with_count > ECS_MAX_TERMS)
+    {
+        SDL_Log("ECS: invalid query (unknown, repeated or more than %d components)", ECS_MAX_TERMS);
+        return NULL;
+    }
+    if (!grow_array((void **)&world->queries, &world->query_capacity, world->query_count + 1, sizeof(EcsQuery *)))
+    {
+        return NULL;
+    }
+    EcsQuery *query = SDL_calloc(1, sizeof(EcsQuery));
+    if (!query)
+    {
+        return NULL;
+    }
+    query->world = world;
+    query->with_mask = with_mask;
+    query->without_mask = without_mask;
+    query->term_count = (Uint32)with_count;
+    for (int i = 0; i < with_count; i++)
+    {
+        query->terms[i] = with[i];
+    }
+    world->queries[world->query_count++] = query;
+    return query;
+}
+
+void ecs_query_destroy(EcsQuery *query)
+{
+    if (!query)
+    {
+        return;
+    }
+    EcsWorld *world = query->world;
+    for (Uint32 i = 0; i < world->query_count; i++)
+    {
+        if (world->queries[i] == query)
+        {
+            world->queries[i] = world->queries[--world->query_count];
+            break;
+        }
+    }
+    query_free(query);
+}
+
+/* Only archetypes created since the last call need matching */
+static bool query_match(EcsQuery *query)
+{
+    EcsWorld *world = query->world;
+    for (; query->archetypes_seen < world->archetype_count; query->archetypes_seen++)
+    {
+        Uint64 mask = world->archetypes[query->archetypes_seen]->mask;
+        if ((mask & query->with_mask) != query->with_mask || (mask & query->without_mask))
+        {
+            continue;
+        }
+        if (!grow_array((void **)&query->matched, &query->matched_capacity, query->matched_count + 1,
+                        sizeof(Uint32)))
+        {
+            return false;
+        }
+        query->matched[query->matched_count++] = query->archetypes_seen;
+    }
+    return true;
+}
+
+Uint32 ecs_query_prepare(EcsQuery *query)
+{
+    query->chunk_count = 0;
+    if (!query_match(query))
+    {
+        return 0;
+    }
+    EcsWorld *world = query->world;
+    for (Uint32 m = 0; m < query->matched_count; m++)
+    {
+        Uint32 rows = world->archetypes[query->matched[m]]->count;
+        for (Uint32 begin = 0; begin < rows; begin += ECS_CHUNK_ROWS)
+        {
+            if (!grow_array((void **)&query->chunks, &query->chunk_capacity, query->chunk_count + 1,
+                            sizeof(QueryChunk)))
+            {
+                return query->chunk_count;
+            }
+            QueryChunk *chunk = &query->chunks[query->chunk_count++];
+            chunk->archetype = query->matched[m];
+            chunk->begin = begin;
+            chunk->count = SDL_min(rows - begin, ECS_CHUNK_ROWS);
+        }
+    }
+    return query->chunk_count;
+}
+
+void ecs_query_chunk(const EcsQuery *query, Uint32 index, EcsChunk *chunk)
+{
+    const EcsWorld *world = query->world;
+    const QueryChunk *range = &query->chunks[index];
+    const Archetype *a = world->archetypes[range->archetype];
+    chunk->count = range->count;
+    chunk->entities = a->entities + range->begin;
+    for (Uint32 t = 0; t < query->term_count; t++)
+    {
+        EcsComponent component = query->terms[t];
+        chunk->columns[t] =
+            a->columns[a->column_of[component]] + (size_t)range->begin * world->components[component].size;
+    }
+}
+
+Uint32 ecs_query_count(EcsQuery *query)
+{
+    query_match(query);
+    Uint32 count = 0;
+    for (Uint32 m = 0; m < query->matched_count; m++)
+    {
+        count += query->world->archetypes[query->matched[m]]->count;
+    }
+    return count;
+}
+
+void ecs_query_each(EcsQuery *query, EcsSystemFn fn, void *userdata)
+{
+    Uint32 chunks = ecs_query_prepare(query);
+    EcsChunk chunk;
+    for (Uint32 i = 0; i < chunks; i++)
+    {
+        ecs_query_chunk(query, i, &chunk);
+        fn(&chunk, userdata);
+    }
+}
+
+typedef struct SystemJob
+{
+    const EcsQuery *query;
+    EcsSystemFn fn;
+    void *userdata;
+} SystemJob;
+
+static void system_range(void *userdata, size_t begin, size_t end)
+{
+    SystemJob *job = userdata;
+    EcsChunk chunk;
+    for (size_t i = begin; i < end; i++)
+    {
+        ecs_query_chunk(job->query, (Uint32)i, &chunk);
+        job->fn(&chunk, job->userdata);
+    }
+}
+
+void ecs_query_each_parallel(EcsQuery *query, EcsSystemFn fn, void *userdata)
+{
+    Uint32 chunks = ecs_query_prepare(query);
+    SystemJob job = {query, fn, userdata};
+    parallel_for(chunks, 1, system_range, &job);
+}
+
+/*================================================================================
+ * Benchmark
+ *================================================================================*/
+#define BENCH_RUNS 20
+
+static void bench_integrate(const EcsChunk *chunk, void *userdata)
+{
+    float dt = *(const float *)userdata;
+    float *position = chunk->columns[0];
+    const float *velocity = chunk->columns[1];
+    for (Uint32 i = 0; i < chunk->count * 3; i++)
+    {
+        position[i] += velocity[i] * dt;
+    }
+}
+
+/* Best of BENCH_RUNS, in ms */
+static double bench_system(EcsQuery *query, bool parallel)
+{
+    float dt = 1.0f / 60.0f;
+    double best = 1e9;
+    for (int run = 0; run < BENCH_RUNS; run++)
+    {
+        Uint64 start = bench_now();
+        if (parallel)
+        {
+            ecs_query_each_parallel(query, bench_integrate, &dt);
+        }
+        else
+        {
+            ecs_query_each(query, bench_integrate, &dt);
+        }
+        best = SDL_min(best, bench_ms_since(start));
+    }
+    return best;
+}
+
+void ecs_benchmark(Uint32 count)
+{
+    EcsWorld *world = ecs_world_create();
+    EcsEntity *entities = SDL_malloc((size_t)count * sizeof(EcsEntity));
+    if (!world || !entities)
+    {
+        goto done;
+    }
+    EcsComponent position = ecs_component_register(world, "Position", 3 * sizeof(float));
+    EcsComponent velocity = ecs_component_register(world, "Velocity", 3 * sizeof(float));
+    EcsComponent health = ecs_component_register(world, "Health", sizeof(float));
+    EcsComponent frozen = ecs_component_register(world, "Frozen", 1);
+
+    /* Half moving, a quarter moving with health, a quarter static */
+    const EcsComponent moving[] = {position, velocity};
+    const EcsComponent living[] = {position, velocity, health};
+    Uint64 start = bench_now();
+    Uint32 half = count / 2, quarter = count / 4;
+    bool ok = ecs_entity_create_many(world, moving, 2, half, entities) &&
+              ecs_entity_create_many(world, living, 3, quarter, entities + half) &&
+              ecs_entity_create_many(world, &position, 1, count - half - quarter, entities + half + quarter);
+    double create_ms = bench_ms_since(start);
+    EcsQuery *query = ok ? ecs_query_create(world, moving, 2, &frozen, 1) : NULL;
+    if (!query)
+    {
+        goto done;
+    }
+    Uint32 matched = ecs_query_count(query);
+    double serial_ms = bench_system(query, false);
+    double parallel_ms = bench_system(query, true);
+
+    /* Freeze every 8th entity and thaw it again: two archetype moves each */
+    Uint32 churn = 0;
+    start = bench_now();
+    for (Uint32 i = 0; i < count; i += 8)
+    {
+        churn += ecs_add(world, entities[i], frozen);
+    }
+    Uint32 frozen_matched = ecs_query_count(query);
+    for (Uint32 i = 0; i < count; i += 8)
+    {
+        ecs_remove(world, entities[i], frozen);
+    }
+    double churn_ms = bench_ms_since(start);
+    bool consistent = ecs_query_count(query) == matched && frozen_matched < matched;
+
+    start = bench_now();
+    for (Uint32 i = 0; i < count; i++)
+    {
+        ecs_entity_destroy(world, entities[i]);
+    }
+    double destroy_ms = bench_ms_since(start);
+    consistent = consistent && ecs_entity_count(world) == 0 && !ecs_entity_alive(world, entities[0]);
+
+    SDL_Log("ECS benchmark: %u entities in %u archetypes, %u match position+velocity", count,
+            world->archetype_count, matched);
+    SDL_Log("  create %.2f ms, integrate %.3f ms serial / %.3f ms on %d workers", create_ms, serial_ms, parallel_ms,
+            parallel_worker_count());
+    SDL_Log("  %u add+remove in %.2f ms (%.0f ns each), destroy %.2f ms%s", churn, churn_ms,
+            churn ? churn_ms * 1e6 / (2.0 * churn) : 0.0, destroy_ms, consistent ? "" : " -- INCONSISTENT");
+
+done:
+    ecs_world_destroy(world);
+    SDL_free(entities);
+}
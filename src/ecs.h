@@ -0,0 +1,99 @@
+#ifndef CUMULUS_ECS_H
+#define CUMULUS_ECS_H
+
+#include <SDL3/SDL.h>
+
+/* Archetype entity-component store. Entities with the same set of
+   components share an archetype, which keeps one contiguous column per
+   component plus the entity handles, all indexed by row. Removing a row
+   moves the last one into it, so creating, destroying and adding or
+   removing a component are O(1) (the latter two move the entity to the
+   neighbouring archetype, found through a cached edge).
+
+   Systems iterate queries chunk by chunk: a chunk is up to
+   ECS_CHUNK_ROWS consecutive rows of one archetype, with a column
+   pointer per query term. Queries cache the archetypes they match and
+   pick up new ones as they appear. Structural changes (create, destroy,
+   add, remove) must not happen while a query is being iterated. */
+
+#define ECS_MAX_COMPONENTS 64
+#define ECS_MAX_TERMS 8
+#define ECS_CHUNK_ROWS 1024
+#define ECS_COMPONENT_NONE 0xFFFFFFFFu
+
+typedef Uint32 EcsComponent;
+
+/* Index in the low 32 bits, generation in the high ones. 0 is never a
+   live entity. */
+typedef Uint64 EcsEntity;
+
+typedef struct EcsWorld EcsWorld;
+typedef struct EcsQuery EcsQuery;
+
+typedef struct EcsChunk
+{
+    Uint32 count;
+    const EcsEntity *entities;
+    void *columns[ECS_MAX_TERMS]; /* per query term, `count` components each */
+} EcsChunk;
+
+typedef void (*EcsSystemFn)(const EcsChunk *chunk, void *userdata);
+
+EcsWorld *ecs_world_create(void);
+
+/* Frees every entity and query of the world */
+void ecs_world_destroy(EcsWorld *world);
+
+/* Register a component of `size` bytes (16-byte alignment at most).
+   Registering an existing name again returns it if the size matches.
+   Returns ECS_COMPONENT_NONE when full or on a size mismatch. */
+EcsComponent ecs_component_register(EcsWorld *world, const char *name, Uint32 size);
+EcsComponent ecs_component_find(const EcsWorld *world, const char *name);
+Uint32 ecs_component_size(const EcsWorld *world, EcsComponent component);
+const char *ecs_component_name(const EcsWorld *world, EcsComponent component);
+
+/* New entities with zeroed components. create_many writes the handles
+   to `out` if it is not NULL. */
+EcsEntity ecs_entity_create(EcsWorld *world, const EcsComponent *components, int count);
+bool ecs_entity_create_many(EcsWorld *world, const EcsComponent *components, int count, Uint32 n, EcsEntity *out);
+void ecs_entity_destroy(EcsWorld *world, EcsEntity entity);
+bool ecs_entity_alive(const EcsWorld *world, EcsEntity entity);
+Uint32 ecs_entity_count(const EcsWorld *world);
+
+/* Changes with every structural change: chunks and ecs_get pointers
+   taken at another version may point at moved or freed memory */
+Uint64 ecs_world_version(const EcsWorld *world);
+
+/* The added component starts zeroed. Both return false if the entity is
+   dead, or already has (add) / lacks (remove) the component. */
+bool ecs_add(EcsWorld *world, EcsEntity entity, EcsComponent component);
+bool ecs_remove(EcsWorld *world, EcsEntity entity, EcsComponent component);
+
+/* NULL if the entity is dead or lacks the component. Valid until the
+   next structural change. */
+void *ecs_get(EcsWorld *world, EcsEntity entity, EcsComponent component);
+
+/* Entities with every `with` component and none of `without`. Chunk
+   columns follow the order of `with`. Destroyed with the world. */
+EcsQuery *ecs_query_create(EcsWorld *world, const EcsComponent *with, int with_count, const EcsComponent *without,
+                           int without_count);
+void ecs_query_destroy(EcsQuery *query);
+
+/* Match archetypes created since the last call and split the matching
+   ones into chunks. Returns the chunk count; ecs_query_chunk then
+   fills any of them until the next structural change. */
+Uint32 ecs_query_prepare(EcsQuery *query);
+void ecs_query_chunk(const EcsQuery *query, Uint32 index, EcsChunk *chunk);
+
+/* Entities the query matches */
+Uint32 ecs_query_count(EcsQuery *query);
+
+/* Run fn on every chunk, on the calling thread or across the job pool */
+void ecs_query_each(EcsQuery *query, EcsSystemFn fn, void *userdata);
+void ecs_query_each_parallel(EcsQuery *query, EcsSystemFn fn, void *userdata);
+
+/* Create, iterate (serial and parallel), churn and destroy `count`
+   entities over a few archetypes */
+void ecs_benchmark(Uint32 count);
+
+#endif /* CUMULUS_ECS_H */
@@ -0,0 +1,229 @@
+#include "frame_arena.h"
+#include "residency.h"
+
+#include <SDL3/SDL.h>
+
+#define ARENA_ALIGN 16
+#define ARENA_GRANULE (64u * 1024u)
+/* Frames without a frame_arena_warmup before allocating counts as a leak */
+#define ARENA_STEADY_FRAMES 120
+
+/* Heap block holding one allocation that did not fit; the data follows
+   the header at ARENA_ALIGN */
+typedef struct SpillBlock
+{
+    struct SpillBlock *next;
+} SpillBlock;
+
+static struct
+{
+    Uint8 *base;
+    size_t capacity;
+    size_t used;
+    size_t spilled;
+    SpillBlock *spills;
+    FrameArenaStats stats;
+
+    /* CUMULUS_ALLOC_CHECK */
+    bool checking;
+    SDL_ThreadID main_thread;
+    Uint32 allocs; /* main-thread allocations since frame_arena_begin */
+    size_t alloc_bytes;
+    Uint32 steady_frames;
+    SDL_malloc_func real_malloc;
+    SDL_calloc_func real_calloc;
+    SDL_realloc_func real_realloc;
+    SDL_free_func real_free;
+} arena;
+
+/*================================================================================
+ * Allocation check
+ *================================================================================*/
+static void count_alloc(size_t size)
+{
+    if (SDL_GetCurrentThreadID() == arena.main_thread)
+    {
+        arena.allocs++;
+        arena.alloc_bytes += size;
+    }
+}
+
+static void *SDLCALL counting_malloc(size_t size)
+{
+    count_alloc(size);
+    return arena.real_malloc(size);
+}
+
+static void *SDLCALL counting_calloc(size_t nmemb, size_t size)
+{
+    count_alloc(nmemb * size);
+    return arena.real_calloc(nmemb, size);
+}
+
+static void *SDLCALL counting_realloc(void *mem, size_t size)
+{
+    count_alloc(size);
+    return arena.real_realloc(mem, size);
+}
+
+static void SDLCALL counting_free(void *mem)
+{
+    arena.real_free(mem);
+}
+
+/* Allocations made before the hook are freed through it, so it wraps the
+   functions in place rather than replacing them */
+static void install_check(void)
+{
+    const char *v = SDL_getenv("CUMULUS_ALLOC_CHECK");
+    if (!v || !v[0] || v[0] == '0')
+    {
+        return;
+    }
+    SDL_GetMemoryFunctions(&arena.real_malloc, &arena.real_calloc, &arena.real_realloc, &arena.real_free);
+    arena.main_thread = SDL_GetCurrentThreadID();
+    if (!SDL_SetMemoryFunctions(counting_malloc, counting_calloc, counting_realloc, counting_free))
+    {
+        SDL_Log("Couldn't hook SDL's allocator: %s", SDL_GetError());
+        return;
+    }
+    arena.checking = true;
+    SDL_Log("Allocation check on: steady frames must not allocate on the main thread");
+}
+
+/*================================================================================
+ * Arena
+ *================================================================================*/
+static size_t round_up(size_t size, size_t granule)
+{
+    return (size + granule - 1) / granule * granule;
+}
+
+bool frame_arena_init(size_t capacity)
+{
+    SDL_zero(arena);
+    install_check();
+
+    arena.capacity = round_up(SDL_max(capacity, 1), ARENA_GRANULE);
+    arena.base = SDL_aligned_alloc(ARENA_ALIGN, arena.capacity);
+    if (!arena.base)
+    {
+        SDL_Log("Failed to allocate the frame arena (%zu bytes)", arena.capacity);
+        arena.capacity = 0;
+        return false;
+    }
+    arena.stats.capacity = arena.capacity;
+    residency_account(RESIDENCY_FRAME, arena.capacity);
+    return true;
+}
+
+static void free_spills(void)
+{
+    while (arena.spills)
+    {
+        SpillBlock *next = arena.spills->next;
+        SDL_aligned_free(arena.spills);
+        arena.spills = next;
+    }
+    residency_release(RESIDENCY_FRAME, arena.spilled);
+    arena.spilled = 0;
+}
+
+void frame_arena_shutdown(void)
+{
+    free_spills();
+    residency_release(RESIDENCY_FRAME, arena.capacity);
+    SDL_aligned_free(arena.base);
+    arena.base = NULL;
+    arena.capacity = 0;
+    SDL_Log("Frame arena: %zu KB, largest frame %zu KB, regrown %u times", arena.stats.capacity / 1024,
+            arena.stats.peak / 1024, arena.stats.grows);
+    if (arena.checking)
+    {
+        SDL_Log("Allocation check: %u steady frames allocated", arena.stats.violations);
+        SDL_SetMemoryFunctions(arena.real_malloc, arena.real_calloc, arena.real_realloc, arena.real_free);
+        arena.checking = false;
+    }
+}
+
+void frame_arena_begin(void)
+{
+    size_t used = arena.used + arena.spilled;
+    arena.stats.used = used;
+    arena.stats.peak = SDL_max(arena.stats.peak, used);
+
+    if (arena.checking)
+    {
+        arena.stats.heap_allocs = arena.allocs;
+        if (arena.allocs > 0 && arena.steady_frames >= ARENA_STEADY_FRAMES)
+        {
+            arena.stats.violations++;
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Steady frame made %u heap allocations (%zu bytes)",
+                         arena.allocs, arena.alloc_bytes);
+            SDL_assert(arena.allocs == 0);
+        }
+        arena.steady_frames++;
+    }
+
+    /* Spilled last frame: grow with some headroom, so the next frame fits */
+    if (arena.spills)
+    {
+        free_spills();
+        size_t capacity = round_up(arena.stats.peak + arena.stats.peak / 4, ARENA_GRANULE);
+        /* Over the frame budget the arena stays as it is and keeps spilling */
+        bool reserved = residency_reserve(RESIDENCY_FRAME, capacity);
+        Uint8 *base = reserved ? SDL_aligned_alloc(ARENA_ALIGN, capacity) : NULL;
+        if (!base && reserved)
+        {
+            residency_release(RESIDENCY_FRAME, capacity);
+        }
+        if (base)
+        {
+            residency_release(RESIDENCY_FRAME, arena.capacity);
+            SDL_aligned_free(arena.base);
+            arena.base = base;
+            arena.capacity = capacity;
+            arena.stats.capacity = capacity;
+            arena.stats.grows++;
+        }
+    }
+    arena.used = 0;
+    arena.allocs = 0;
+    arena.alloc_bytes = 0;
+}
+
+void *frame_alloc(size_t size)
+{
+    size = round_up(SDL_max(size, 1), ARENA_ALIGN);
+    if (size <= arena.capacity - arena.used)
+    {
+        void *p = arena.base + arena.used;
+        arena.used += size;
+        return p;
+    }
+
+    if (!residency_reserve(RESIDENCY_FRAME, size))
+    {
+        return NULL;
+    }
+    SpillBlock *block = SDL_aligned_alloc(ARENA_ALIGN, ARENA_ALIGN + size);
+    if (!block)
+    {
+        residency_release(RESIDENCY_FRAME, size);
+        return NULL;
+    }
+    block->next = arena.spills;
+    arena.spills = block;
+    arena.spilled += size;
+    return (Uint8 *)block + ARENA_ALIGN;
+}
+
+void frame_arena_warmup(void)
+{
+    arena.steady_frames = 0;
+}
+
+const FrameArenaStats *frame_arena_stats(void)
+{
+    return &arena.stats;
+}
@@ -0,0 +1,45 @@
+#ifndef CUMULUS_FRAME_ARENA_H
+#define CUMULUS_FRAME_ARENA_H
+
+#include <SDL3/SDL.h>
+
+/* Linear allocator for scratch memory that lives for one frame. Allocation
+   is a pointer bump and frame_arena_begin releases everything at once.
+   A frame that outgrows the arena spills into heap blocks; the next
+   frame_arena_begin frees them and regrows the arena to fit, so the arena
+   settles at the largest frame's size. Main thread only.
+
+   With CUMULUS_ALLOC_CHECK=1 every SDL_malloc is counted through
+   SDL_SetMemoryFunctions, and once the app has been steady for a while,
+   any frame that still allocates on the main thread is reported. */
+
+typedef struct FrameArenaStats
+{
+    size_t capacity;    /* bytes in the arena */
+    size_t used;        /* by the last completed frame, including spills */
+    size_t peak;        /* largest frame so far */
+    Uint32 grows;       /* times the arena was regrown */
+    Uint32 heap_allocs; /* main-thread SDL allocations in the last frame (with the check on) */
+    Uint32 violations;  /* steady frames that allocated */
+} FrameArenaStats;
+
+/* Call first, before SDL allocates anything, so the check can hook it */
+bool frame_arena_init(size_t capacity);
+void frame_arena_shutdown(void);
+
+/* Start a frame: forget every allocation of the last one, and check
+   whether the last one touched the heap */
+void frame_arena_begin(void);
+
+/* 16-byte aligned, valid until the next frame_arena_begin. NULL when a
+   spill would not fit the frame budget. */
+void *frame_alloc(size_t size);
+
+/* The app is about to change (a model loads, a window opens, textures are
+   still streaming): allocations are expected until it has been steady
+   for a while again */
+void frame_arena_warmup(void);
+
+const FrameArenaStats *frame_arena_stats(void);
+
+#endif /* CUMULUS_FRAME_ARENA_H */
@@ -0,0 +1,265 @@
+#include "frame_capture.h"
+#include "bench.h"
+#include "residency.h"
+
+#include <SDL3/SDL.h>
+
+#define STBI_WRITE_NO_STDIO
+#define STBIW_MALLOC(sz) SDL_malloc(sz)
+#define STBIW_REALLOC(p, newsz) SDL_realloc(p, newsz)
+#define STBIW_FREE(p) SDL_free(p)
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#define CAPTURE_SLOTS 2
+
+/* One persistent download buffer and the submission filling it */
+typedef struct CaptureSlot
+{
+    SDL_GPUTransferBuffer *buffer;
+    SDL_GPUFence *fence; /* borrowed from the frame's submitter; NULL when nothing is in flight */
+    Uint32 frame;
+} CaptureSlot;
+
+struct FrameCapture
+{
+    SDL_GPUDevice *device;
+    SDL_GPUTexture *texture;
+    Uint32 width, height;
+    CaptureSlot slots[CAPTURE_SLOTS];
+    Uint32 frame;    /* number of the next frame */
+    bool downloaded; /* this frame recorded a download into slots[frame % CAPTURE_SLOTS] */
+    char *dump_dir;
+    FrameCaptureDump dump;
+    Uint32 dump_from;
+    FrameCaptureStats stats;
+};
+
+FrameCapture *frame_capture_create(SDL_GPUDevice *device, Uint32 width, Uint32 height, const char *dump_dir,
+                                   FrameCaptureDump dump, Uint32 dump_from)
+{
+    FrameCapture *capture = SDL_calloc(1, sizeof(FrameCapture));
+    if (!capture)
+    {
+        return NULL;
+    }
+    capture->device = device;
+    capture->width = width;
+    capture->height = height;
+    capture->dump = dump_dir ? dump : FRAME_CAPTURE_DUMP_NONE;
+    capture->dump_from = dump_from;
+
+    SDL_GPUTextureCreateInfo info;
+    SDL_zero(info);
+    info.type = SDL_GPU_TEXTURETYPE_2D;
+    info.format = FRAME_CAPTURE_FORMAT;
+    info.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER;
+    info.width = width;
+    info.height = height;
+    info.layer_count_or_depth = 1;
+    info.num_levels = 1;
+    capture->texture = residency_create_texture(device, &info, RESIDENCY_TARGETS);
+    if (!capture->texture)
+    {
+        SDL_Log("Failed to create the offscreen target: %s", SDL_GetError());
+        frame_capture_destroy(capture);
+        return NULL;
+    }
+
+    SDL_GPUTransferBufferCreateInfo download;
+    SDL_zero(download);
+    download.usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD;
+    download.size = width * height * 4;
+    for (int i = 0; i < CAPTURE_SLOTS; i++)
+    {
+        capture->slots[i].buffer = residency_create_transfer_buffer(device, &download, RESIDENCY_STAGING);
+        if (!capture->slots[i].buffer)
+        {
+            SDL_Log("Failed to create a readback buffer: %s", SDL_GetError());
+            frame_capture_destroy(capture);
+            return NULL;
+        }
+    }
+
+    if (capture->dump != FRAME_CAPTURE_DUMP_NONE)
+    {
+        capture->dump_dir = SDL_strdup(dump_dir);
+        if (!SDL_CreateDirectory(dump_dir))
+        {
+            SDL_Log("Couldn't create %s: %s; frames will not be written", dump_dir, SDL_GetError());
+            capture->dump = FRAME_CAPTURE_DUMP_NONE;
+        }
+    }
+    return capture;
+}
+
+SDL_GPUTexture *frame_capture_texture(const FrameCapture *capture)
+{
+    return capture->texture;
+}
+
+Uint32 frame_capture_width(const FrameCapture *capture)
+{
+    return capture->width;
+}
+
+Uint32 frame_capture_height(const FrameCapture *capture)
+{
+    return capture->height;
+}
+
+const FrameCaptureStats *frame_capture_stats(const FrameCapture *capture)
+{
+    return &capture->stats;
+}
+
+/*================================================================================
+ * Readback
+ *================================================================================*/
+static void SDLCALL write_io(void *context, void *data, int size)
+{
+    SDL_WriteIO(context, data, (size_t)size);
+}
+
+static void dump_frame(FrameCapture *capture, Uint32 frame, const Uint8 *pixels)
+{
+    Uint64 start = bench_now();
+    char path[1024];
+    bool ok;
+    if (capture->dump == FRAME_CAPTURE_DUMP_PNG)
+    {
+        SDL_snprintf(path, sizeof(path), "%s/frame_%05u.png", capture->dump_dir, frame);
+        SDL_IOStream *io = SDL_IOFromFile(path, "wb");
+        ok = io != NULL;
+        if (io)
+        {
+            ok = stbi_write_png_to_func(write_io, io, (int)capture->width, (int)capture->height, 4, pixels,
+                                        (int)capture->width * 4);
+            ok = SDL_CloseIO(io) && ok;
+        }
+    }
+    else
+    {
+        SDL_snprintf(path, sizeof(path), "%s/frame_%05u_%ux%u.rgba", capture->dump_dir, frame, capture->width,
+                     capture->height);
+        ok = SDL_SaveFile(path, pixels, (size_t)capture->width * capture->height * 4);
+    }
+    if (ok)
+    {
+        capture->stats.dumped++;
+    }
+    else
+    {
+        SDL_Log("Couldn't write %s: %s", path, SDL_GetError());
+    }
+    capture->stats.dump_ms += bench_ms_since(start);
+}
+
+/* Wait for the slot's download if it is still in flight, then map it */
+static void collect(FrameCapture *capture, CaptureSlot *slot)
+{
+    if (!slot->fence)
+    {
+        return;
+    }
+    if (!SDL_QueryGPUFence(capture->device, slot->fence))
+    {
+        Uint64 start = bench_now();
+        SDL_WaitForGPUFences(capture->device, true, &slot->fence, 1);
+        capture->stats.stalls++;
+        capture->stats.stall_ms += bench_ms_since(start);
+    }
+    slot->fence = NULL;
+    capture->stats.read++;
+
+    if (capture->dump == FRAME_CAPTURE_DUMP_NONE || slot->frame < capture->dump_from)
+    {
+        return;
+    }
+    const Uint8 *pixels = SDL_MapGPUTransferBuffer(capture->device, slot->buffer, false);
+    if (!pixels)
+    {
+        SDL_Log("Couldn't map frame %u: %s", slot->frame, SDL_GetError());
+        return;
+    }
+    dump_frame(capture, slot->frame, pixels);
+    SDL_UnmapGPUTransferBuffer(capture->device, slot->buffer);
+}
+
+void frame_capture_begin(FrameCapture *capture)
+{
+    capture->downloaded = false;
+    collect(capture, &capture->slots[capture->frame % CAPTURE_SLOTS]);
+}
+
+void frame_capture_download(FrameCapture *capture, SDL_GPUCopyPass *copy_pass)
+{
+    CaptureSlot *slot = &capture->slots[capture->frame % CAPTURE_SLOTS];
+
+    SDL_GPUTextureRegion src;
+    SDL_zero(src);
+    src.texture = capture->texture;
+    src.w = capture->width;
+    src.h = capture->height;
+    src.d = 1;
+
+    SDL_GPUTextureTransferInfo dst;
+    SDL_zero(dst);
+    dst.transfer_buffer = slot->buffer;
+    dst.pixels_per_row = capture->width;
+    dst.rows_per_layer = capture->height;
+
+    SDL_DownloadFromGPUTexture(copy_pass, &src, &dst);
+    capture->downloaded = true;
+}
+
+void frame_capture_submitted(FrameCapture *capture, SDL_GPUFence *fence)
+{
+    if (!capture->downloaded)
+    {
+        /* A skipped frame: collect now rather than keep fences the
+           submitter will release before the slots come round again */
+        for (Uint32 i = 0; i < CAPTURE_SLOTS; i++)
+        {
+            collect(capture, &capture->slots[(capture->frame + i) % CAPTURE_SLOTS]);
+        }
+        return;
+    }
+
+    CaptureSlot *slot = &capture->slots[capture->frame % CAPTURE_SLOTS];
+    slot->fence = fence;
+    slot->frame = capture->frame++;
+    capture->downloaded = false;
+    capture->stats.frames++;
+}
+
+void frame_capture_destroy(FrameCapture *capture)
+{
+    if (!capture)
+    {
+        return;
+    }
+    /* Oldest first, so dumps keep frame order */
+    for (Uint32 i = 0; i < CAPTURE_SLOTS; i++)
+    {
+        collect(capture, &capture->slots[(capture->frame + i) % CAPTURE_SLOTS]);
+    }
+    if (capture->stats.frames > 0)
+    {
+        SDL_Log("Readback: %u frames, %u waited on the GPU (%.1f ms), %u written in %.1f ms", capture->stats.read,
+                capture->stats.stalls, capture->stats.stall_ms, capture->stats.dumped, capture->stats.dump_ms);
+    }
+    for (int i = 0; i < CAPTURE_SLOTS; i++)
+    {
+        if (capture->slots[i].buffer)
+        {
+            residency_release_transfer_buffer(capture->device, capture->slots[i].buffer);
+        }
+    }
+    if (capture->texture)
+    {
+        residency_release_texture(capture->device, capture->texture);
+    }
+    SDL_free(capture->dump_dir);
+    SDL_free(capture);
+}
@@ -0,0 +1,58 @@
+#ifndef CUMULUS_FRAME_CAPTURE_H
+#define CUMULUS_FRAME_CAPTURE_H
+
+#include <SDL3/SDL.h>
+
+/* Offscreen render target whose frames are read back to the CPU. Each
+   frame's download goes into one of two persistent transfer buffers and is
+   only mapped when that buffer comes round again, two frames later, so the
+   CPU never waits for the frame it just submitted. Frames can be written
+   out as PNG or as raw RGBA8. */
+typedef struct FrameCapture FrameCapture;
+
+/* Format of the target, and of every dumped pixel */
+#define FRAME_CAPTURE_FORMAT SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM
+
+typedef enum FrameCaptureDump
+{
+    FRAME_CAPTURE_DUMP_NONE,
+    FRAME_CAPTURE_DUMP_PNG, /* <dir>/frame_00000.png */
+    FRAME_CAPTURE_DUMP_RAW  /* <dir>/frame_00000_<w>x<h>.rgba, rows top to bottom */
+} FrameCaptureDump;
+
+typedef struct FrameCaptureStats
+{
+    Uint32 frames;   /* downloads recorded */
+    Uint32 read;     /* downloads mapped */
+    Uint32 dumped;   /* files written */
+    Uint32 stalls;   /* mapping had to wait for the GPU */
+    double stall_ms;
+    double dump_ms;
+} FrameCaptureStats;
+
+/* Frames numbered dump_from and later are written to dump_dir, which is
+   created if needed. Returns NULL if the GPU resources cannot be made. */
+FrameCapture *frame_capture_create(SDL_GPUDevice *device, Uint32 width, Uint32 height, const char *dump_dir,
+                                   FrameCaptureDump dump, Uint32 dump_from);
+
+/* Collects every frame still in flight, then releases everything */
+void frame_capture_destroy(FrameCapture *capture);
+
+SDL_GPUTexture *frame_capture_texture(const FrameCapture *capture);
+Uint32 frame_capture_width(const FrameCapture *capture);
+Uint32 frame_capture_height(const FrameCapture *capture);
+
+/* Start a frame: collect the frame that used the buffer this one will
+   write, which normally finished while the previous frame was recorded */
+void frame_capture_begin(FrameCapture *capture);
+
+/* Record the download of the target, after everything that draws to it */
+void frame_capture_download(FrameCapture *capture, SDL_GPUCopyPass *copy_pass);
+
+/* The frame was submitted with `fence`. The fence stays the caller's and
+   must remain valid until the download is collected, two frames later. */
+void frame_capture_submitted(FrameCapture *capture, SDL_GPUFence *fence);
+
+const FrameCaptureStats *frame_capture_stats(const FrameCapture *capture);
+
+#endif /* CUMULUS_FRAME_CAPTURE_H */
@@ -0,0 +1,135 @@
+#include "gltf_meshopt.h"
+#include "bench.h"
+#include "parallel.h"
+
+#include <SDL3/SDL.h>
+#include <cgltf.h>
+#include <meshoptimizer.h>
+
+typedef struct MeshoptDecodeJob
+{
+    cgltf_buffer_view **views;
+    SDL_AtomicInt failures;
+} MeshoptDecodeJob;
+
+static void meshopt_decode_range(void *userdata, size_t begin, size_t end)
+{
+    MeshoptDecodeJob *job = userdata;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        cgltf_buffer_view *view = job->views[i];
+        const cgltf_meshopt_compression *mc = &view->meshopt_compression;
+        const unsigned char *src = (const unsigned char *)mc->buffer->data + mc->offset;
+
+        void *dst = SDL_malloc(mc->count * mc->stride);
+        if (!dst)
+        {
+            SDL_AddAtomicInt(&job->failures, 1);
+            continue;
+        }
+
+        int rc = -1;
+        switch (mc->mode)
+        {
+        case cgltf_meshopt_compression_mode_attributes:
+            rc = meshopt_decodeVertexBuffer(dst, mc->count, mc->stride, src, mc->size);
+            break;
+        case cgltf_meshopt_compression_mode_triangles:
+            rc = meshopt_decodeIndexBuffer(dst, mc->count, mc->stride, src, mc->size);
+            break;
+        case cgltf_meshopt_compression_mode_indices:
+            rc = meshopt_decodeIndexSequence(dst, mc->count, mc->stride, src, mc->size);
+            break;
+        default:
+            break;
+        }
+
+        if (rc != 0)
+        {
+            SDL_Log("meshopt: failed to decode buffer view %s (error %d)", view->name ? view->name : "(unnamed)", rc);
+            SDL_free(dst);
+            SDL_AddAtomicInt(&job->failures, 1);
+            continue;
+        }
+
+        switch (mc->filter)
+        {
+        case cgltf_meshopt_compression_filter_octahedral:
+            meshopt_decodeFilterOct(dst, mc->count, mc->stride);
+            break;
+        case cgltf_meshopt_compression_filter_quaternion:
+            meshopt_decodeFilterQuat(dst, mc->count, mc->stride);
+            break;
+        case cgltf_meshopt_compression_filter_exponential:
+            meshopt_decodeFilterExp(dst, mc->count, mc->stride);
+            break;
+        default:
+            break;
+        }
+
+        /* cgltf reads view->data in preference to the buffer and frees it */
+        view->data = dst;
+    }
+}
+
+bool gltf_meshopt_decode(cgltf_data *data, const char *path)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < data->buffer_views_count; i++)
+    {
+        if (data->buffer_views[i].has_meshopt_compression)
+            count++;
+    }
+    if (count == 0)
+    {
+        return true;
+    }
+
+    MeshoptDecodeJob job;
+    SDL_zero(job);
+    job.views = SDL_malloc(count * sizeof(*job.views));
+    if (!job.views)
+    {
+        return false;
+    }
+
+    size_t in_bytes = 0, out_bytes = 0;
+    count = 0;
+    for (size_t i = 0; i < data->buffer_views_count; i++)
+    {
+        cgltf_buffer_view *view = &data->buffer_views[i];
+        if (!view->has_meshopt_compression)
+            continue;
+
+        const cgltf_meshopt_compression *mc = &view->meshopt_compression;
+        if (!mc->buffer || !mc->buffer->data || mc->offset + mc->size > mc->buffer->size)
+        {
+            SDL_Log("meshopt: compressed source for buffer view %zu is missing or out of range", i);
+            SDL_free(job.views);
+            return false;
+        }
+        in_bytes += mc->size;
+        out_bytes += mc->count * mc->stride;
+        job.views[count++] = view;
+    }
+
+    Uint64 start = bench_now();
+    parallel_for(count, 1, meshopt_decode_range, &job);
+    double secs = bench_ms_since(start) / 1000.0;
+
+    SDL_free(job.views);
+
+    int failures = SDL_GetAtomicInt(&job.failures);
+    if (failures > 0)
+    {
+        SDL_Log("meshopt: %d of %zu buffer views failed to decode in '%s'", failures, count, path);
+        return false;
+    }
+
+    double mb_out = (double)out_bytes / (1024.0 * 1024.0);
+    SDL_Log("  meshopt:   %zu views, %.2f MB -> %.2f MB in %.2f ms (%.1f MB/s, %d threads)", count,
+            (double)in_bytes / (1024.0 * 1024.0), mb_out, secs * 1000.0, secs > 0.0 ? mb_out / secs : 0.0,
+            parallel_worker_count() + 1);
+    return true;
+}
@@ -0,0 +1,14 @@
+#ifndef CUMULUS_GLTF_MESHOPT_H
+#define CUMULUS_GLTF_MESHOPT_H
+
+#include <SDL3/SDL.h>
+
+struct cgltf_data;
+
+/* EXT_meshopt_compression / KHR_meshopt_compression: decode every
+   compressed buffer view across the worker pool into view->data, where
+   cgltf reads it and cgltf_free frees it. The compressed source buffers
+   must be loaded. Returns false if any view failed to decode. */
+bool gltf_meshopt_decode(struct cgltf_data *data, const char *path);
+
+#endif /* CUMULUS_GLTF_MESHOPT_H */
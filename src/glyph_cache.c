@@ -0,0 +1,622 @@
+#include "glyph_cache.h"
+#include "bench.h"
+#include "residency.h"
+
+#include <SDL3/SDL.h>
+
+#define STBTT_malloc(x, u) ((void)(u), SDL_malloc(x))
+#define STBTT_free(x, u) ((void)(u), SDL_free(x))
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>
+
+#define GLYPH_MAX 4096
+#define GLYPH_HASH_SIZE 8192 /* power of two, at most half full */
+#define GLYPH_MAX_SHELVES 256
+#define GLYPH_PADDING 1 /* empty texels right of and below each glyph */
+#define GLYPH_SHELF_ROUND 4
+#define GLYPH_NONE 0xFFFFu
+#define GLYPH_FREE 0xFFFFFFFFu
+#define GLYPH_PAGE_COUNT (0x10000 / 256)
+
+typedef struct CachedGlyph
+{
+    GlyphCacheGlyph glyph;
+    Uint32 codepoint; /* GLYPH_FREE for unused slots */
+    Uint32 last_used;
+    Uint16 shelf; /* GLYPH_NONE for blank glyphs */
+} CachedGlyph;
+
+typedef struct Shelf
+{
+    Uint16 y;
+    Uint16 height;
+    Uint16 x; /* next free column */
+    Uint32 last_used;
+} Shelf;
+
+struct GlyphCache
+{
+    SDL_GPUDevice *device;
+    SDL_GPUTexture *texture;
+
+    void *font_data;
+    size_t font_size;
+    stbtt_fontinfo font;
+    float pixel_height;
+    float scale;
+    int ascent;
+    int line_height;
+
+    /* Basic Multilingual Plane advances in 1/64 px, filled a page at a time */
+    Uint16 advances[0x10000];
+    bool page_ready[GLYPH_PAGE_COUNT];
+
+    /* Coverage, mirrored into the texture by glyph_cache_upload */
+    Uint32 atlas_size;
+    Uint8 *pixels;
+    Uint32 dirty_x0, dirty_y0, dirty_x1, dirty_y1;
+
+    Shelf shelves[GLYPH_MAX_SHELVES];
+    Uint32 shelf_count;
+    Uint32 next_shelf_y;
+
+    CachedGlyph glyphs[GLYPH_MAX];
+    Uint16 free_slots[GLYPH_MAX];
+    Uint32 free_count;
+    Uint16 table[GLYPH_HASH_SIZE]; /* slot + 1, 0 when empty */
+
+    Uint32 frame;
+    GlyphCacheStats stats;
+};
+
+/*================================================================================
+ * Codepoint -> slot table (linear probing, backward-shift deletion)
+ *================================================================================*/
+static Uint32 table_home(Uint32 codepoint)
+{
+    return (codepoint * 2654435761u) >> 19; /* top 13 bits */
+}
+
+static Uint32 table_find(const GlyphCache *c, Uint32 codepoint)
+{
+    for (Uint32 i = table_home(codepoint);; i = (i + 1) & (GLYPH_HASH_SIZE - 1))
+    {
+        Uint16 entry = c->table[i];
+        if (entry == 0 || c->glyphs[entry - 1].codepoint == codepoint)
+            return i;
+    }
+}
+
+static void table_remove(GlyphCache *c, Uint32 codepoint)
+{
+    Uint32 hole = table_find(c, codepoint);
+    if (c->table[hole] == 0)
+        return;
+
+    /* Pull later entries of the probe run back into the hole, unless their
+       home lies cyclically after it */
+    for (Uint32 j = (hole + 1) & (GLYPH_HASH_SIZE - 1);; j = (j + 1) & (GLYPH_HASH_SIZE - 1))
+    {
+        Uint16 entry = c->table[j];
+        if (entry == 0)
+            break;
+        Uint32 home = table_home(c->glyphs[entry - 1].codepoint);
+        bool stays = hole <= j ? (home > hole && home <= j) : (home > hole || home <= j);
+        if (!stays)
+        {
+            c->table[hole] = entry;
+            hole = j;
+        }
+    }
+    c->table[hole] = 0;
+}
+
+/*================================================================================
+ * Advances
+ *================================================================================*/
+static Uint16 compute_advance(const GlyphCache *c, Uint32 codepoint)
+{
+    int advance = 0;
+    stbtt_GetGlyphHMetrics(&c->font, stbtt_FindGlyphIndex(&c->font, (int)codepoint), &advance, NULL);
+    float fixed = (float)advance * c->scale * GLYPH_CACHE_SUBPIXELS + 0.5f;
+    return (Uint16)SDL_clamp(fixed, 0.0f, 65535.0f);
+}
+
+static void fill_page(GlyphCache *c, Uint32 page)
+{
+    for (Uint32 i = 0; i < 256; i++)
+        c->advances[page * 256 + i] = compute_advance(c, page * 256 + i);
+    c->page_ready[page] = true;
+}
+
+Uint32 glyph_cache_advance(GlyphCache *c, Uint32 codepoint)
+{
+    if (codepoint >= 0x10000)
+        return compute_advance(c, codepoint);
+    if (!c->page_ready[codepoint >> 8])
+        fill_page(c, codepoint >> 8);
+    return c->advances[codepoint];
+}
+
+int glyph_cache_text_width(GlyphCache *c, const char *text, int len)
+{
+    size_t left = len < 0 ? SDL_strlen(text) : (size_t)len;
+    Uint32 width = 0;
+    while (left > 0)
+    {
+        Uint32 codepoint = SDL_StepUTF8(&text, &left);
+        if (codepoint == 0)
+            break;
+        width += glyph_cache_advance(c, codepoint);
+    }
+    return (int)((width + GLYPH_CACHE_SUBPIXELS / 2) / GLYPH_CACHE_SUBPIXELS);
+}
+
+int glyph_cache_line_height(const GlyphCache *c)
+{
+    return c->line_height;
+}
+
+int glyph_cache_ascent(const GlyphCache *c)
+{
+    return c->ascent;
+}
+
+/*================================================================================
+ * Atlas
+ *================================================================================*/
+static void mark_dirty(GlyphCache *c, Uint32 x, Uint32 y, Uint32 w, Uint32 h)
+{
+    c->dirty_x0 = SDL_min(c->dirty_x0, x);
+    c->dirty_y0 = SDL_min(c->dirty_y0, y);
+    c->dirty_x1 = SDL_max(c->dirty_x1, x + w);
+    c->dirty_y1 = SDL_max(c->dirty_y1, y + h);
+}
+
+static void evict_shelf(GlyphCache *c, Uint32 s)
+{
+    for (Uint32 i = 0; i < GLYPH_MAX; i++)
+    {
+        CachedGlyph *g = &c->glyphs[i];
+        if (g->codepoint == GLYPH_FREE || g->shelf != s)
+            continue;
+        table_remove(c, g->codepoint);
+        g->codepoint = GLYPH_FREE;
+        c->free_slots[c->free_count++] = (Uint16)i;
+        c->stats.resident--;
+    }
+
+    /* Clear it so new glyphs keep empty padding */
+    Shelf *shelf = &c->shelves[s];
+    SDL_memset(c->pixels + (size_t)shelf->y * c->atlas_size, 0, (size_t)shelf->height * c->atlas_size);
+    mark_dirty(c, 0, shelf->y, c->atlas_size, shelf->height);
+    shelf->x = 0;
+    c->stats.evictions++;
+}
+
+/* Least recently used shelf at least `height` tall that this frame has not
+   drawn from; GLYPH_NONE if there is none */
+static Uint32 evict_lru(GlyphCache *c, Uint32 height)
+{
+    Uint32 lru = GLYPH_NONE;
+    for (Uint32 s = 0; s < c->shelf_count; s++)
+    {
+        const Shelf *shelf = &c->shelves[s];
+        if (shelf->height >= height && shelf->last_used != c->frame &&
+            (lru == GLYPH_NONE || shelf->last_used < c->shelves[lru].last_used))
+            lru = s;
+    }
+    if (lru != GLYPH_NONE)
+        evict_shelf(c, lru);
+    return lru;
+}
+
+/* Best-fitting shelf with room, else a new shelf, else an evicted one */
+static Shelf *place(GlyphCache *c, Uint32 w, Uint32 h, Uint32 *x, Uint32 *y)
+{
+    Shelf *best = NULL;
+    for (Uint32 s = 0; s < c->shelf_count; s++)
+    {
+        Shelf *shelf = &c->shelves[s];
+        if (shelf->height >= h && shelf->x + w <= c->atlas_size && (!best || shelf->height < best->height))
+            best = shelf;
+    }
+
+    Uint32 height = (h + GLYPH_SHELF_ROUND - 1) / GLYPH_SHELF_ROUND * GLYPH_SHELF_ROUND;
+    bool wasteful = !best || best->height > h + h / 2;
+    if (wasteful && c->shelf_count < GLYPH_MAX_SHELVES && c->next_shelf_y + height <= c->atlas_size)
+    {
+        best = &c->shelves[c->shelf_count++];
+        best->y = (Uint16)c->next_shelf_y;
+        best->height = (Uint16)height;
+        best->x = 0;
+        c->next_shelf_y += height;
+        c->stats.shelves = c->shelf_count;
+    }
+
+    if (!best)
+    {
+        Uint32 lru = evict_lru(c, h);
+        if (lru == GLYPH_NONE)
+            return NULL;
+        best = &c->shelves[lru];
+    }
+
+    *x = best->x;
+    *y = best->y;
+    best->x = (Uint16)(best->x + w);
+    return best;
+}
+
+static CachedGlyph *rasterize(GlyphCache *c, Uint32 codepoint)
+{
+    int index = stbtt_FindGlyphIndex(&c->font, (int)codepoint);
+    int x0, y0, x1, y1;
+    stbtt_GetGlyphBitmapBox(&c->font, index, c->scale, c->scale, &x0, &y0, &x1, &y1);
+    Uint32 w = x1 > x0 ? (Uint32)(x1 - x0) : 0;
+    Uint32 h = y1 > y0 ? (Uint32)(y1 - y0) : 0;
+    if (w >= c->atlas_size || h >= c->atlas_size)
+        return NULL;
+
+    /* Every slot taken: free the glyphs of the oldest shelf */
+    while (c->free_count == 0)
+    {
+        if (evict_lru(c, 0) == GLYPH_NONE)
+            return NULL;
+    }
+
+    Uint32 x = 0, y = 0;
+    Shelf *shelf = NULL;
+    if (w > 0 && h > 0)
+    {
+        shelf = place(c, w + GLYPH_PADDING, h + GLYPH_PADDING, &x, &y);
+        if (!shelf)
+            return NULL;
+    }
+    Uint16 slot = c->free_slots[--c->free_count];
+
+    Uint64 start = bench_now();
+    if (shelf)
+    {
+        stbtt_MakeGlyphBitmap(&c->font, c->pixels + (size_t)y * c->atlas_size + x, (int)w, (int)h,
+                              (int)c->atlas_size, c->scale, c->scale, index);
+        mark_dirty(c, x, y, w, h);
+    }
+    c->stats.raster_ms += bench_ms_since(start);
+    c->stats.rasterized++;
+    c->stats.resident++;
+
+    CachedGlyph *g = &c->glyphs[slot];
+    g->glyph = (GlyphCacheGlyph){(Uint16)x, (Uint16)y, (Uint16)w, (Uint16)h, (Sint16)x0, (Sint16)y0};
+    g->codepoint = codepoint;
+    g->shelf = shelf ? (Uint16)(shelf - c->shelves) : GLYPH_NONE;
+    c->table[table_find(c, codepoint)] = (Uint16)(slot + 1);
+    return g;
+}
+
+const GlyphCacheGlyph *glyph_cache_glyph(GlyphCache *c, Uint32 codepoint)
+{
+    Uint16 entry = c->table[table_find(c, codepoint)];
+    CachedGlyph *g = entry ? &c->glyphs[entry - 1] : rasterize(c, codepoint);
+    if (!g)
+    {
+        c->stats.dropped++;
+        return NULL;
+    }
+    g->last_used = c->frame;
+    if (g->shelf != GLYPH_NONE)
+        c->shelves[g->shelf].last_used = c->frame;
+    return &g->glyph;
+}
+
+void glyph_cache_begin_frame(GlyphCache *c)
+{
+    c->frame++;
+    c->stats.dropped = 0;
+}
+
+SDL_GPUTexture *glyph_cache_texture(const GlyphCache *c)
+{
+    return c->texture;
+}
+
+Uint32 glyph_cache_atlas_size(const GlyphCache *c)
+{
+    return c->atlas_size;
+}
+
+void glyph_cache_upload(GlyphCache *c, SDL_GPUCopyPass *cp)
+{
+    if (!c->texture || c->dirty_x1 <= c->dirty_x0 || c->dirty_y1 <= c->dirty_y0)
+        return;
+
+    Uint32 w = c->dirty_x1 - c->dirty_x0, h = c->dirty_y1 - c->dirty_y0;
+    SDL_GPUTransferBufferCreateInfo tb_info;
+    SDL_zero(tb_info);
+    tb_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+    tb_info.size = w * h * 4;
+    SDL_GPUTransferBuffer *tbuf = residency_create_transfer_buffer(c->device, &tb_info, RESIDENCY_STAGING);
+    Uint8 *map = tbuf ? SDL_MapGPUTransferBuffer(c->device, tbuf, false) : NULL;
+    if (!map)
+    {
+        SDL_Log("Glyph atlas upload failed: %s", SDL_GetError());
+        residency_release_transfer_buffer(c->device, tbuf);
+        return;
+    }
+
+    /* White texels with coverage in alpha, as the UI pipeline expects */
+    for (Uint32 row = 0; row < h; row++)
+    {
+        const Uint8 *src = c->pixels + (size_t)(c->dirty_y0 + row) * c->atlas_size + c->dirty_x0;
+        Uint8 *dst = map + (size_t)row * w * 4;
+        for (Uint32 i = 0; i < w; i++)
+        {
+            dst[i * 4 + 0] = 255;
+            dst[i * 4 + 1] = 255;
+            dst[i * 4 + 2] = 255;
+            dst[i * 4 + 3] = src[i];
+        }
+    }
+    SDL_UnmapGPUTransferBuffer(c->device, tbuf);
+
+    SDL_GPUTextureTransferInfo src;
+    SDL_zero(src);
+    src.transfer_buffer = tbuf;
+    src.pixels_per_row = w;
+    src.rows_per_layer = h;
+    SDL_GPUTextureRegion dst;
+    SDL_zero(dst);
+    dst.texture = c->texture;
+    dst.x = c->dirty_x0;
+    dst.y = c->dirty_y0;
+    dst.w = w;
+    dst.h = h;
+    dst.d = 1;
+    SDL_UploadToGPUTexture(cp, &src, &dst, false);
+    residency_release_transfer_buffer(c->device, tbuf);
+
+    c->dirty_x0 = c->dirty_y0 = c->atlas_size;
+    c->dirty_x1 = c->dirty_y1 = 0;
+}
+
+const GlyphCacheStats *glyph_cache_stats(const GlyphCache *c)
+{
+    return &c->stats;
+}
+
+/*================================================================================
+ * Lifetime
+ *================================================================================*/
+GlyphCache *glyph_cache_create(SDL_GPUDevice *device, void *font_data, size_t font_size, float pixel_height,
+                               Uint32 atlas_size)
+{
+    const unsigned char *data = font_data;
+    int offset = font_data ? stbtt_GetFontOffsetForIndex(data, 0) : -1;
+    if (offset < 0 || font_size > (size_t)SDL_MAX_SINT32)
+    {
+        SDL_Log("Glyph cache: not a TrueType font");
+        SDL_free(font_data);
+        return NULL;
+    }
+
+    GlyphCache *c = SDL_calloc(1, sizeof(GlyphCache));
+    Uint8 *pixels = SDL_calloc(atlas_size, atlas_size);
+    if (!c || !pixels || !stbtt_InitFont(&c->font, data, offset))
+    {
+        SDL_Log("Glyph cache: could not load the font");
+        SDL_free(pixels);
+        SDL_free(c);
+        SDL_free(font_data);
+        return NULL;
+    }
+
+    c->device = device;
+    c->font_data = font_data;
+    c->font_size = font_size;
+    c->pixel_height = pixel_height;
+    c->scale = stbtt_ScaleForPixelHeight(&c->font, pixel_height);
+    int ascent, descent, line_gap;
+    stbtt_GetFontVMetrics(&c->font, &ascent, &descent, &line_gap);
+    c->ascent = (int)SDL_ceilf((float)ascent * c->scale);
+    c->line_height = (int)SDL_ceilf((float)(ascent - descent + line_gap) * c->scale);
+
+    c->atlas_size = atlas_size;
+    c->pixels = pixels;
+    for (Uint32 i = 0; i < GLYPH_MAX; i++)
+    {
+        c->glyphs[i].codepoint = GLYPH_FREE;
+        c->free_slots[i] = (Uint16)(GLYPH_MAX - 1 - i);
+    }
+    c->free_count = GLYPH_MAX;
+    fill_page(c, 0); /* ASCII and Latin-1 */
+
+    /* The first upload clears the whole texture */
+    c->dirty_x1 = c->dirty_y1 = atlas_size;
+    if (device)
+    {
+        SDL_GPUTextureCreateInfo info;
+        SDL_zero(info);
+        info.type = SDL_GPU_TEXTURETYPE_2D;
+        info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+        info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+        info.width = atlas_size;
+        info.height = atlas_size;
+        info.layer_count_or_depth = 1;
+        info.num_levels = 1;
+        c->texture = residency_create_texture(device, &info, RESIDENCY_UI);
+        if (!c->texture)
+        {
+            SDL_Log("Glyph cache: could not create the atlas: %s", SDL_GetError());
+            glyph_cache_destroy(c);
+            return NULL;
+        }
+    }
+    return c;
+}
+
+/* CUMULUS_UI_FONT, else the first system font found */
+static void *load_default_font(size_t *size, const char **path)
+{
+    static const char *const candidates[] = {
+        "C:/Windows/Fonts/segoeui.ttf",
+        "/System/Library/Fonts/Supplemental/Arial.ttf",
+        "/System/Library/Fonts/Helvetica.ttc",
+        "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf",
+        "/usr/share/fonts/TTF/DejaVuSans.ttf",
+        "/usr/share/fonts/dejavu/DejaVuSans.ttf",
+        "/usr/share/fonts/truetype/noto/NotoSans-Regular.ttf",
+    };
+
+    *path = SDL_getenv("CUMULUS_UI_FONT");
+    void *data = *path ? SDL_LoadFile(*path, size) : NULL;
+    for (size_t i = 0; !data && i < SDL_arraysize(candidates); i++)
+    {
+        *path = candidates[i];
+        data = SDL_LoadFile(*path, size);
+    }
+    return data;
+}
+
+GlyphCache *glyph_cache_create_default(SDL_GPUDevice *device, float pixel_height, Uint32 atlas_size)
+{
+    const char *path = NULL;
+    size_t size = 0;
+    void *data = load_default_font(&size, &path);
+    if (!data)
+        return NULL;
+
+    GlyphCache *c = glyph_cache_create(device, data, size, pixel_height, atlas_size);
+    if (c)
+        SDL_Log("UI font: %s at %.0f px", path, pixel_height);
+    return c;
+}
+
+GlyphCache *glyph_cache_clone(const GlyphCache *c, float pixel_height, Uint32 atlas_size)
+{
+    void *data = SDL_malloc(c->font_size);
+    if (!data)
+        return NULL;
+    SDL_memcpy(data, c->font_data, c->font_size);
+    return glyph_cache_create(c->device, data, c->font_size, pixel_height, atlas_size);
+}
+
+void glyph_cache_prewarm(GlyphCache *c, Uint32 first, Uint32 last)
+{
+    Uint64 start = bench_now();
+    for (Uint32 codepoint = first; codepoint <= last; codepoint++)
+        glyph_cache_glyph(c, codepoint);
+    SDL_Log("Glyph atlas at %.0f px: %u glyphs prebuilt in %.2f ms", c->pixel_height, last - first + 1,
+            bench_ms_since(start));
+}
+
+float glyph_cache_pixel_height(const GlyphCache *c)
+{
+    return c->pixel_height;
+}
+
+void glyph_cache_destroy(GlyphCache *c)
+{
+    if (!c)
+        return;
+    if (c->texture)
+        residency_release_texture(c->device, c->texture);
+    SDL_free(c->pixels);
+    SDL_free(c->font_data);
+    SDL_free(c);
+}
+
+/*================================================================================
+ * Benchmark
+ *================================================================================*/
+void glyph_cache_benchmark(void)
+{
+    const Uint32 target = 100000;
+    static const char *const samples[] = {
+        "The quick brown fox jumps over the lazy dog. ",
+        "Größenänderung: naïve café, façade, smørrebrød. ",
+        "Быстрая коричневая лиса прыгает через ленивую собаку. ",
+        "Γρήγορη καφέ αλεπού πηδά πάνω από τον σκύλο. ",
+        "0123456789 +-*/=<>()[]{} ",
+    };
+
+    /* ~100k codepoints of UTF-8, with each line followed by a run of
+       Cyrillic and Latin Extended letters that rotates through the atlas */
+    size_t cap = (size_t)target * 4 + 256, used = 0;
+    char *text = SDL_malloc(cap);
+    Uint32 glyphs = 0, lines = 0, rotate = 0;
+    while (text && glyphs < target)
+    {
+        const char *sample = samples[lines++ % SDL_arraysize(samples)];
+        for (size_t left = SDL_strlen(sample); left > 0 && glyphs < target; glyphs++)
+        {
+            const char *at = sample;
+            SDL_StepUTF8(&sample, &left);
+            SDL_memcpy(text + used, at, (size_t)(sample - at));
+            used += (size_t)(sample - at);
+        }
+        for (int i = 0; i < 16 && glyphs < target; i++, glyphs++)
+        {
+            Uint32 n = rotate++;
+            Uint32 cp = (n % 2 ? 0x0400u : 0x0100u) + (n / 2) % 256;
+            char *end = SDL_UCS4ToUTF8(cp, text + used);
+            used = (size_t)(end - text);
+        }
+    }
+
+    /* An atlas that holds only part of the working set */
+    const char *path = NULL;
+    size_t size = 0;
+    void *data = load_default_font(&size, &path);
+    if (!data)
+    {
+        SDL_Log("Glyph cache benchmark skipped: no font found (set CUMULUS_UI_FONT)");
+        SDL_free(text);
+        return;
+    }
+    if (!text)
+    {
+        SDL_free(data);
+        return;
+    }
+    GlyphCache *c = glyph_cache_create(NULL, data, size, 16.0f, 256);
+    if (!c)
+    {
+        SDL_free(text);
+        return;
+    }
+
+    /* Measure: one table read per codepoint */
+    Uint64 start = bench_now();
+    int width = glyph_cache_text_width(c, text, (int)used);
+    double measure_ms = bench_ms_since(start);
+    start = bench_now();
+    width = glyph_cache_text_width(c, text, (int)used); /* every page ready now */
+    double measure_warm_ms = bench_ms_since(start);
+
+    /* Lay out in 100-glyph frames, looking up every glyph like the UI does */
+    start = bench_now();
+    const char *p = text;
+    size_t left = used;
+    Uint32 pen = 0, placed = 0;
+    for (Uint32 i = 0; left > 0; i++)
+    {
+        if (i % 100 == 0)
+            glyph_cache_begin_frame(c);
+        Uint32 cp = SDL_StepUTF8(&p, &left);
+        if (glyph_cache_glyph(c, cp))
+            placed++;
+        pen += glyph_cache_advance(c, cp);
+    }
+    double layout_ms = bench_ms_since(start);
+    int laid_out = (int)((pen + GLYPH_CACHE_SUBPIXELS / 2) / GLYPH_CACHE_SUBPIXELS);
+
+    const GlyphCacheStats *s = glyph_cache_stats(c);
+    SDL_Log("Glyph cache benchmark (%s): %u glyphs (%zu bytes UTF-8) measured in %.3f ms cold, %.3f ms warm "
+            "(%.1f ns/glyph); laid out in %.3f ms",
+            path, glyphs, used, measure_ms, measure_warm_ms, measure_warm_ms * 1e6 / glyphs, layout_ms);
+    SDL_Log("  %u placed, %u rasterized in %.3f ms, %u shelves, %u evictions; width %d px %s", placed,
+            s->rasterized, s->raster_ms, s->shelves, s->evictions, width, width == laid_out ? "OK" : "MISMATCH");
+
+    glyph_cache_destroy(c);
+    SDL_free(text);
+}
@@ -0,0 +1,83 @@
+#ifndef CUMULUS_GLYPH_CACHE_H
+#define CUMULUS_GLYPH_CACHE_H
+
+#include <SDL3/SDL.h>
+
+/* TrueType glyphs rasterized on first use into a shelf-packed atlas.
+   When the atlas is full, the least recently used shelf not needed by the
+   current frame is evicted with all its glyphs. Advances are kept in
+   per-256-codepoint tables in 1/64 px, so measuring a string is one table
+   read per codepoint and never allocates; layout accumulates the same
+   fixed-point advances, so drawn text is exactly as wide as measured. */
+typedef struct GlyphCache GlyphCache;
+
+/* Position of a rasterized glyph in the atlas, relative to the pen
+   position on the baseline. w == 0 for blank glyphs (space). */
+typedef struct GlyphCacheGlyph
+{
+    Uint16 x, y, w, h; /* atlas texels */
+    Sint16 xoff, yoff; /* top-left corner from the pen */
+} GlyphCacheGlyph;
+
+typedef struct GlyphCacheStats
+{
+    Uint32 resident;   /* glyphs in the atlas now */
+    Uint32 rasterized; /* total rasterizations, including re-rasterized evictees */
+    Uint32 evictions;  /* shelves evicted */
+    Uint32 dropped;    /* glyphs that did not fit this frame and were not drawn */
+    Uint32 shelves;
+    double raster_ms;
+} GlyphCacheStats;
+
+/* Fixed-point advances: 1/64 px */
+#define GLYPH_CACHE_SUBPIXELS 64
+
+/* Takes ownership of `font_data` (SDL_malloc'd, freed with the cache).
+   device may be NULL to lay out text without a GPU texture. Returns NULL
+   if the font cannot be parsed. */
+GlyphCache *glyph_cache_create(SDL_GPUDevice *device, void *font_data, size_t font_size, float pixel_height,
+                               Uint32 atlas_size);
+
+/* Load the font named by CUMULUS_UI_FONT, else the first common system UI
+   font found. Returns NULL if there is none. */
+GlyphCache *glyph_cache_create_default(SDL_GPUDevice *device, float pixel_height, Uint32 atlas_size);
+
+/* Another cache for the same font at a different size, with its own atlas */
+GlyphCache *glyph_cache_clone(const GlyphCache *cache, float pixel_height, Uint32 atlas_size);
+
+void glyph_cache_destroy(GlyphCache *cache);
+
+/* Rasterize codepoints [first, last] now rather than on first use */
+void glyph_cache_prewarm(GlyphCache *cache, Uint32 first, Uint32 last);
+
+float glyph_cache_pixel_height(const GlyphCache *cache);
+
+/* Glyphs looked up after this are kept from eviction until the next call */
+void glyph_cache_begin_frame(GlyphCache *cache);
+
+/* Distance between baselines, and the baseline's offset from the line top */
+int glyph_cache_line_height(const GlyphCache *cache);
+int glyph_cache_ascent(const GlyphCache *cache);
+
+/* Advance of one codepoint in 1/64 px */
+Uint32 glyph_cache_advance(GlyphCache *cache, Uint32 codepoint);
+
+/* Width in pixels of `len` bytes of UTF-8 (len < 0: up to the NUL) */
+int glyph_cache_text_width(GlyphCache *cache, const char *text, int len);
+
+/* Rasterize on a miss. Returns NULL if the glyph could not be placed. */
+const GlyphCacheGlyph *glyph_cache_glyph(GlyphCache *cache, Uint32 codepoint);
+
+/* The atlas texture (RGBA8, white with coverage in alpha) and the upload
+   of every glyph rasterized since the last call */
+SDL_GPUTexture *glyph_cache_texture(const GlyphCache *cache);
+Uint32 glyph_cache_atlas_size(const GlyphCache *cache);
+void glyph_cache_upload(GlyphCache *cache, SDL_GPUCopyPass *copy_pass);
+
+const GlyphCacheStats *glyph_cache_stats(const GlyphCache *cache);
+
+/* Measure and lay out 100k glyphs of mixed-script UTF-8 with the default
+   font, through an atlas small enough to force evictions */
+void glyph_cache_benchmark(void);
+
+#endif /* CUMULUS_GLYPH_CACHE_H */
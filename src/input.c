@@ -0,0 +1,329 @@
+#include "input.h"
+#include "bench.h"
+
+#include <SDL3/SDL.h>
+#include <microui.h>
+
+/* Pending pointer state and the raw samples of one tick */
+typedef struct InputQueue
+{
+    InputDispatchFn dispatch;
+    SDL_Event motion; /* last motion event, deltas summed; valid when has_motion */
+    SDL_Event wheel;  /* summed wheel event; valid when has_wheel */
+    float wheel_rest_x, wheel_rest_y; /* sub-step scrolling of wheel's window, carried to later frames */
+    bool has_motion;
+    bool has_wheel;
+    InputSample samples[2][INPUT_MAX_SAMPLES]; /* collecting, published */
+    Uint32 sample_count[2];
+    Uint32 collecting;
+    Uint32 received;
+    Uint32 dispatched;
+    InputStats stats;
+} InputQueue;
+
+static InputQueue input;
+
+/*================================================================================
+ * Coalescing
+ *================================================================================*/
+static void forward(InputQueue *q, SDL_Event *event)
+{
+    q->dispatched++;
+    if (q->dispatch)
+    {
+        q->dispatch(event);
+    }
+}
+
+static void flush_motion(InputQueue *q)
+{
+    if (q->has_motion)
+    {
+        q->has_motion = false;
+        forward(q, &q->motion);
+    }
+}
+
+/* Only whole steps leave: the UI scrolls by integers, so the remainder
+   waits for more scrolling instead of being truncated away */
+static void flush_wheel(InputQueue *q)
+{
+    if (!q->has_wheel)
+    {
+        return;
+    }
+    q->has_wheel = false;
+    SDL_MouseWheelEvent *wheel = &q->wheel.wheel;
+    float x = wheel->x + q->wheel_rest_x;
+    float y = wheel->y + q->wheel_rest_y;
+    wheel->x = SDL_truncf(x);
+    wheel->y = SDL_truncf(y);
+    q->wheel_rest_x = x - wheel->x;
+    q->wheel_rest_y = y - wheel->y;
+    if (wheel->x != 0.0f || wheel->y != 0.0f)
+    {
+        forward(q, &q->wheel);
+    }
+}
+
+static void add_sample(InputQueue *q, const SDL_MouseMotionEvent *motion)
+{
+    Uint32 *count = &q->sample_count[q->collecting];
+    if (*count == INPUT_MAX_SAMPLES)
+    {
+        q->stats.dropped++;
+        return;
+    }
+    InputSample *sample = &q->samples[q->collecting][(*count)++];
+    sample->timestamp = motion->timestamp;
+    sample->window = motion->windowID;
+    sample->x = motion->x;
+    sample->y = motion->y;
+    sample->dx = motion->xrel;
+    sample->dy = motion->yrel;
+}
+
+static void queue_event(InputQueue *q, SDL_Event *event)
+{
+    q->received++;
+    if (event->type == SDL_EVENT_MOUSE_MOTION)
+    {
+        add_sample(q, &event->motion);
+        SDL_MouseMotionEvent *pending = &q->motion.motion;
+        if (q->has_motion && pending->windowID == event->motion.windowID && pending->which == event->motion.which &&
+            pending->state == event->motion.state)
+        {
+            pending->timestamp = event->motion.timestamp;
+            pending->x = event->motion.x;
+            pending->y = event->motion.y;
+            pending->xrel += event->motion.xrel;
+            pending->yrel += event->motion.yrel;
+            return;
+        }
+        flush_motion(q);
+        q->motion = *event;
+        q->has_motion = true;
+        return;
+    }
+
+    if (event->type == SDL_EVENT_MOUSE_WHEEL)
+    {
+        /* Fractional (high-resolution) steps add up instead of each
+           truncating to zero */
+        SDL_MouseWheelEvent *pending = &q->wheel.wheel;
+        if (q->has_wheel && pending->windowID == event->wheel.windowID && pending->direction == event->wheel.direction)
+        {
+            pending->timestamp = event->wheel.timestamp;
+            pending->x += event->wheel.x;
+            pending->y += event->wheel.y;
+            pending->mouse_x = event->wheel.mouse_x;
+            pending->mouse_y = event->wheel.mouse_y;
+            return;
+        }
+        flush_wheel(q);
+        if (pending->windowID != event->wheel.windowID || pending->direction != event->wheel.direction)
+        {
+            q->wheel_rest_x = 0.0f;
+            q->wheel_rest_y = 0.0f;
+        }
+        q->wheel = *event;
+        q->has_wheel = true;
+        return;
+    }
+
+    /* Buttons, keys, text and window changes see the pointer where it was */
+    flush_motion(q);
+    flush_wheel(q);
+    forward(q, event);
+}
+
+static void begin_frame(InputQueue *q)
+{
+    flush_motion(q);
+    flush_wheel(q);
+
+    q->stats.received = q->received;
+    q->stats.dispatched = q->dispatched;
+    q->received = 0;
+    q->dispatched = 0;
+}
+
+/* Frames without a tick keep collecting, so no sample is lost or repeated */
+static void begin_tick(InputQueue *q)
+{
+    q->stats.samples = q->sample_count[q->collecting];
+    q->collecting ^= 1;
+    q->sample_count[q->collecting] = 0;
+}
+
+/*================================================================================
+ * Public API
+ *================================================================================*/
+void input_init(InputDispatchFn dispatch)
+{
+    SDL_zero(input);
+    input.dispatch = dispatch;
+}
+
+void input_event(SDL_Event *event)
+{
+    queue_event(&input, event);
+}
+
+void input_begin_frame(void)
+{
+    begin_frame(&input);
+}
+
+void input_begin_tick(void)
+{
+    begin_tick(&input);
+}
+
+const InputSample *input_samples(Uint32 *count)
+{
+    Uint32 published = input.collecting ^ 1;
+    *count = input.sample_count[published];
+    return input.samples[published];
+}
+
+const InputStats *input_stats(void)
+{
+    return &input.stats;
+}
+
+/*================================================================================
+ * Benchmark
+ *================================================================================*/
+#define BENCH_FRAMES 600
+#define BENCH_MOUSE_HZ 8000
+#define BENCH_WHEEL_HZ 1000
+#define BENCH_FPS 60
+#define BENCH_MAX_EVENTS (2 * BENCH_MOUSE_HZ / BENCH_FPS + 2)
+
+static mu_Context *bench_mu;
+
+/* What the microui backend does with each event: find its window, feed
+   the window's context */
+static void bench_dispatch(SDL_Event *event)
+{
+    if (SDL_GetWindowFromEvent(event))
+    {
+        return; /* the synthetic window ID never matches a real window */
+    }
+    switch (event->type)
+    {
+    case SDL_EVENT_MOUSE_MOTION:
+        mu_input_mousemove(bench_mu, (int)event->motion.x, (int)event->motion.y);
+        break;
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        mu_input_mousedown(bench_mu, (int)event->button.x, (int)event->button.y, MU_MOUSE_LEFT);
+        break;
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+        mu_input_mouseup(bench_mu, (int)event->button.x, (int)event->button.y, MU_MOUSE_LEFT);
+        break;
+    case SDL_EVENT_MOUSE_WHEEL:
+        mu_input_scroll(bench_mu, (int)event->wheel.x, (int)event->wheel.y);
+        break;
+    }
+}
+
+/* One frame's worth of a mouse circling at BENCH_MOUSE_HZ, scrolling at
+   BENCH_WHEEL_HZ and clicking twice a second. Returns the event count. */
+static Uint32 bench_events(SDL_Event *events, Uint32 frame)
+{
+    const Uint32 per_frame = BENCH_MOUSE_HZ / BENCH_FPS;
+    const Uint32 click_every = BENCH_MOUSE_HZ / 4;
+    Uint32 count = 0;
+    for (Uint32 i = 0; i < per_frame; i++)
+    {
+        Uint32 n = frame * per_frame + i;
+        float t = (float)n / BENCH_MOUSE_HZ;
+        SDL_Event *event = &events[count++];
+        SDL_zerop(event);
+        event->type = SDL_EVENT_MOUSE_MOTION;
+        event->motion.timestamp = (Uint64)n * SDL_NS_PER_SECOND / BENCH_MOUSE_HZ;
+        event->motion.windowID = SDL_MAX_UINT32;
+        event->motion.x = 400.0f + SDL_cosf(t) * 200.0f;
+        event->motion.y = 300.0f + SDL_sinf(t) * 200.0f;
+        event->motion.xrel = -SDL_sinf(t) * 200.0f / BENCH_MOUSE_HZ;
+        event->motion.yrel = SDL_cosf(t) * 200.0f / BENCH_MOUSE_HZ;
+        float x = event->motion.x, y = event->motion.y;
+
+        if (n % (BENCH_MOUSE_HZ / BENCH_WHEEL_HZ) == 0)
+        {
+            event = &events[count++];
+            SDL_zerop(event);
+            event->type = SDL_EVENT_MOUSE_WHEEL;
+            event->wheel.windowID = SDL_MAX_UINT32;
+            event->wheel.y = 0.125f;
+        }
+        if (n % click_every == 0)
+        {
+            event = &events[count++];
+            SDL_zerop(event);
+            event->type = (n / click_every) % 2 ? SDL_EVENT_MOUSE_BUTTON_UP : SDL_EVENT_MOUSE_BUTTON_DOWN;
+            event->button.windowID = SDL_MAX_UINT32;
+            event->button.button = SDL_BUTTON_LEFT;
+            event->button.x = x;
+            event->button.y = y;
+        }
+    }
+    return count;
+}
+
+void input_benchmark(void)
+{
+    InputQueue *q = SDL_calloc(1, sizeof(InputQueue));
+    SDL_Event *events = SDL_malloc(BENCH_MAX_EVENTS * sizeof(SDL_Event));
+    bench_mu = SDL_malloc(sizeof(mu_Context));
+    if (!q || !events || !bench_mu)
+    {
+        goto done;
+    }
+    mu_init(bench_mu);
+    q->dispatch = bench_dispatch;
+
+    SDL_Log("Input benchmark: %u Hz mouse, %u Hz wheel, %u frames at %u fps", BENCH_MOUSE_HZ, BENCH_WHEEL_HZ,
+            BENCH_FRAMES, BENCH_FPS);
+    for (int coalesce = 0; coalesce < 2; coalesce++)
+    {
+        double total = 0.0, worst = 0.0;
+        Uint64 received = 0, dispatched = 0;
+        for (Uint32 frame = 0; frame < BENCH_FRAMES; frame++)
+        {
+            Uint32 count = bench_events(events, frame);
+            q->dispatched = 0;
+            Uint64 start = bench_now();
+            for (Uint32 i = 0; i < count; i++)
+            {
+                if (coalesce)
+                {
+                    queue_event(q, &events[i]);
+                }
+                else
+                {
+                    forward(q, &events[i]);
+                }
+            }
+            if (coalesce)
+            {
+                begin_frame(q);
+            }
+            double ms = bench_ms_since(start);
+            total += ms;
+            worst = SDL_max(worst, ms);
+            received += count;
+            dispatched += coalesce ? q->stats.dispatched : q->dispatched;
+        }
+        SDL_Log("  %-9s %7.2f us/frame (worst %6.2f us): %.1f events in, %.1f dispatched",
+                coalesce ? "coalesced" : "direct", total * 1000.0 / BENCH_FRAMES, worst * 1000.0,
+                (double)received / BENCH_FRAMES, (double)dispatched / BENCH_FRAMES);
+    }
+
+done:
+    SDL_free(bench_mu);
+    bench_mu = NULL;
+    SDL_free(events);
+    SDL_free(q);
+}
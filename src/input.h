@@ -0,0 +1,60 @@
+#ifndef CUMULUS_INPUT_H
+#define CUMULUS_INPUT_H
+
+#include <SDL3/SDL.h>
+
+/* Coalesces high-rate pointer input before it reaches the UI. Mouse motion
+   and wheel events only update a pending state; input_begin_frame hands
+   the UI one motion event (last position, summed deltas) and one wheel
+   event per window, in whole steps: the remainder is kept for later
+   frames. Every other event first flushes what is pending, so buttons,
+   keys and text keep their exact order relative to the pointer.
+   Each motion event is also kept as a raw sample until the next
+   simulation tick, for scripts that want the full-rate stream: every
+   sample reaches exactly one tick, however render and tick rates relate.
+   Main thread only. */
+
+#define INPUT_MAX_SAMPLES 4096
+
+/* Receives the events that leave the coalescer */
+typedef void (*InputDispatchFn)(SDL_Event *event);
+
+typedef struct InputSample
+{
+    Uint64 timestamp; /* SDL event time, ns */
+    SDL_WindowID window;
+    float x, y;   /* window coordinates */
+    float dx, dy; /* relative motion */
+} InputSample;
+
+typedef struct InputStats
+{
+    Uint32 received;   /* events seen during the last frame */
+    Uint32 dispatched; /* events forwarded for them */
+    Uint32 samples;    /* motion samples handed to the last tick */
+    Uint32 dropped;    /* samples past INPUT_MAX_SAMPLES, since startup */
+} InputStats;
+
+void input_init(InputDispatchFn dispatch);
+
+/* Coalesce a motion or wheel event, or flush and forward anything else */
+void input_event(SDL_Event *event);
+
+/* Dispatch pending motion and wheel. Call once per frame before the UI
+   is built. */
+void input_begin_frame(void);
+
+/* Publish the samples collected since the previous tick. Call once per
+   simulation tick, before the scripts run. */
+void input_begin_tick(void);
+
+/* Motion samples published by the last input_begin_tick, oldest first */
+const InputSample *input_samples(Uint32 *count);
+
+const InputStats *input_stats(void);
+
+/* Per-frame event cost under a synthetic 8 kHz mouse, with and without
+   coalescing */
+void input_benchmark(void);
+
+#endif /* CUMULUS_INPUT_H */
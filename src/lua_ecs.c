@@ -0,0 +1,509 @@
+#include "lua_ecs.h"
+#include "bench.h"
+#include "ecs.h"
+#include "lua_script.h"
+
+#include <SDL3/SDL.h>
+
+#include <lauxlib.h>
+#include <lualib.h>
+
+#define QUERY_METATABLE "cumulus.ecs.query"
+
+/* A query and the chunk a `for c in q:chunks()` loop is on; the loop
+   variable is the query itself, so iterating allocates nothing. The chunk
+   is only used at the world version it was taken at: a structural change
+   inside the loop may have moved its columns. */
+typedef struct LuaQuery
+{
+    EcsWorld *world;
+    EcsQuery *query;
+    Uint32 term_count;
+    Uint32 floats[ECS_MAX_TERMS]; /* per entity, for each term */
+    Uint32 chunk_count;
+    Uint32 next;
+    EcsChunk chunk;
+    Uint64 chunk_version;
+} LuaQuery;
+
+static EcsWorld *world_of(lua_State *L)
+{
+    return lua_touserdata(L, lua_upvalueindex(1));
+}
+
+static EcsComponent check_component(lua_State *L, EcsWorld *world, int arg)
+{
+    EcsComponent component = lua_type(L, arg) == LUA_TSTRING ? ecs_component_find(world, lua_tostring(L, arg))
+                                                              : (EcsComponent)luaL_checkinteger(L, arg);
+    if (ecs_component_size(world, component) == 0)
+    {
+        luaL_argerror(L, arg, "unknown component");
+    }
+    return component;
+}
+
+/* Components named by arguments [first, top] */
+static int check_components(lua_State *L, EcsWorld *world, int first, EcsComponent *components)
+{
+    int count = lua_gettop(L) - first + 1;
+    luaL_argcheck(L, count <= ECS_MAX_COMPONENTS, first, "too many components");
+    for (int i = 0; i < count; i++)
+    {
+        components[i] = check_component(L, world, first + i);
+    }
+    return SDL_max(count, 0);
+}
+
+static EcsEntity check_entity(lua_State *L, int arg)
+{
+    return (EcsEntity)luaL_checkinteger(L, arg);
+}
+
+/*================================================================================
+ * ecs.*
+ *================================================================================*/
+/* ecs.component(name, floats) -> id */
+static int l_component(lua_State *L)
+{
+    const char *name = luaL_checkstring(L, 1);
+    lua_Integer floats = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, floats > 0 && floats <= 1024, 2, "expected 1 to 1024 floats");
+    EcsComponent component = ecs_component_register(world_of(L), name, (Uint32)floats * sizeof(float));
+    if (component == ECS_COMPONENT_NONE)
+    {
+        return luaL_error(L, "cannot register component %s", name);
+    }
+    lua_pushinteger(L, component);
+    return 1;
+}
+
+/* ecs.spawn(n, components...): n entities with zeroed components */
+static int l_spawn(lua_State *L)
+{
+    EcsWorld *world = world_of(L);
+    lua_Integer n = luaL_checkinteger(L, 1);
+    luaL_argcheck(L, n >= 0 && n <= SDL_MAX_SINT32, 1, "bad entity count");
+    EcsComponent components[ECS_MAX_COMPONENTS];
+    int count = check_components(L, world, 2, components);
+    if (!ecs_entity_create_many(world, components, count, (Uint32)n, NULL))
+    {
+        return luaL_error(L, "out of memory spawning %d entities", (int)n);
+    }
+    return 0;
+}
+
+/* ecs.create(components...) -> entity */
+static int l_create(lua_State *L)
+{
+    EcsWorld *world = world_of(L);
+    EcsComponent components[ECS_MAX_COMPONENTS];
+    int count = check_components(L, world, 1, components);
+    EcsEntity entity = ecs_entity_create(world, components, count);
+    if (!entity)
+    {
+        return luaL_error(L, "out of memory creating an entity");
+    }
+    lua_pushinteger(L, (lua_Integer)entity);
+    return 1;
+}
+
+static int l_destroy(lua_State *L)
+{
+    ecs_entity_destroy(world_of(L), check_entity(L, 1));
+    return 0;
+}
+
+static int l_alive(lua_State *L)
+{
+    lua_pushboolean(L, ecs_entity_alive(world_of(L), check_entity(L, 1)));
+    return 1;
+}
+
+static int l_count(lua_State *L)
+{
+    lua_pushinteger(L, ecs_entity_count(world_of(L)));
+    return 1;
+}
+
+static int l_add(lua_State *L)
+{
+    EcsWorld *world = world_of(L);
+    lua_pushboolean(L, ecs_add(world, check_entity(L, 1), check_component(L, world, 2)));
+    return 1;
+}
+
+static int l_remove(lua_State *L)
+{
+    EcsWorld *world = world_of(L);
+    lua_pushboolean(L, ecs_remove(world, check_entity(L, 1), check_component(L, world, 2)));
+    return 1;
+}
+
+/* Float k (1-based, default 1) of an entity's component, or NULL */
+static float *entity_float(lua_State *L, EcsWorld *world)
+{
+    EcsComponent component = check_component(L, world, 2);
+    lua_Integer k = luaL_optinteger(L, 3, 1);
+    luaL_argcheck(L, k >= 1 && (Uint32)k <= ecs_component_size(world, component) / sizeof(float), 3,
+                  "float index out of range");
+    float *value = ecs_get(world, check_entity(L, 1), component);
+    return value ? value + (k - 1) : NULL;
+}
+
+/* ecs.get(entity, component, k) -> number, nil if it lacks the component */
+static int l_get(lua_State *L)
+{
+    float *value = entity_float(L, world_of(L));
+    if (value)
+    {
+        lua_pushnumber(L, *value);
+    }
+    else
+    {
+        lua_pushnil(L);
+    }
+    return 1;
+}
+
+/* ecs.set(entity, component, k, value) */
+static int l_set(lua_State *L)
+{
+    float value = (float)luaL_checknumber(L, 4);
+    float *dst = entity_float(L, world_of(L));
+    if (dst)
+    {
+        *dst = value;
+    }
+    return 0;
+}
+
+/* ecs.query(components...) -> query; a "!Name" argument excludes Name */
+static int l_query(lua_State *L)
+{
+    EcsWorld *world = world_of(L);
+    EcsComponent with[ECS_MAX_TERMS], without[ECS_MAX_COMPONENTS];
+    int with_count = 0, without_count = 0;
+    for (int arg = 1; arg <= lua_gettop(L); arg++)
+    {
+        const char *name = lua_type(L, arg) == LUA_TSTRING ? lua_tostring(L, arg) : NULL;
+        if (name && name[0] == '!')
+        {
+            EcsComponent component = ecs_component_find(world, name + 1);
+            luaL_argcheck(L, component != ECS_COMPONENT_NONE, arg, "unknown component");
+            luaL_argcheck(L, without_count < ECS_MAX_COMPONENTS, arg, "too many components");
+            without[without_count++] = component;
+            continue;
+        }
+        luaL_argcheck(L, with_count < ECS_MAX_TERMS, arg, "too many query terms");
+        with[with_count++] = check_component(L, world, arg);
+    }
+
+    LuaQuery *q = lua_newuserdatauv(L, sizeof(LuaQuery), 0);
+    SDL_zerop(q);
+    luaL_setmetatable(L, QUERY_METATABLE);
+    q->world = world;
+    q->query = ecs_query_create(world, with, with_count, without, without_count);
+    if (!q->query)
+    {
+        return luaL_error(L, "invalid query");
+    }
+    q->term_count = (Uint32)with_count;
+    for (int t = 0; t < with_count; t++)
+    {
+        q->floats[t] = ecs_component_size(world, with[t]) / sizeof(float);
+    }
+    return 1;
+}
+
+/*================================================================================
+ * Queries and chunks
+ *================================================================================*/
+static LuaQuery *check_query(lua_State *L)
+{
+    return luaL_checkudata(L, 1, QUERY_METATABLE);
+}
+
+static int q_gc(lua_State *L)
+{
+    LuaQuery *q = check_query(L);
+    ecs_query_destroy(q->query);
+    q->query = NULL;
+    return 0;
+}
+
+static int q_count(lua_State *L)
+{
+    lua_pushinteger(L, ecs_query_count(check_query(L)->query));
+    return 1;
+}
+
+static int q_next(lua_State *L)
+{
+    LuaQuery *q = check_query(L);
+    luaL_argcheck(L, q->next == 0 || q->chunk_version == ecs_world_version(q->world), 1,
+                  "entities spawned, destroyed or changed inside a chunks() loop");
+    if (q->next >= q->chunk_count)
+    {
+        SDL_zero(q->chunk);
+        lua_pushnil(L);
+        return 1;
+    }
+    ecs_query_chunk(q->query, q->next++, &q->chunk);
+    q->chunk_version = ecs_world_version(q->world);
+    lua_pushvalue(L, 1);
+    return 1;
+}
+
+/* Closing value of the loop: leaving it by break or error drops the chunk */
+static int q_close(lua_State *L)
+{
+    SDL_zero(check_query(L)->chunk);
+    return 0;
+}
+
+/* for c in q:chunks() do ... end */
+static int q_chunks(lua_State *L)
+{
+    LuaQuery *q = check_query(L);
+    q->chunk_count = ecs_query_prepare(q->query);
+    q->next = 0;
+    SDL_zero(q->chunk);
+    lua_pushcfunction(L, q_next);
+    lua_pushvalue(L, 1);
+    lua_pushnil(L);
+    lua_pushvalue(L, 1);
+    return 4;
+}
+
+/* The loop's current chunk, while its columns are still where they were */
+static void check_chunk(lua_State *L, LuaQuery *q)
+{
+    luaL_argcheck(L, q->chunk.count > 0, 1, "not inside a chunks() loop");
+    luaL_argcheck(L, q->chunk_version == ecs_world_version(q->world), 1,
+                  "entities spawned, destroyed or changed inside a chunks() loop");
+}
+
+/* Column of term `arg`, `floats` per row */
+static float *check_column(lua_State *L, LuaQuery *q, int arg, Uint32 *floats)
+{
+    lua_Integer term = luaL_checkinteger(L, arg);
+    luaL_argcheck(L, term >= 1 && (Uint32)term <= q->term_count, arg, "no such query term");
+    check_chunk(L, q);
+    *floats = q->floats[term - 1];
+    return q->chunk.columns[term - 1];
+}
+
+static Uint32 check_row(lua_State *L, LuaQuery *q, int arg)
+{
+    check_chunk(L, q);
+    lua_Integer row = luaL_checkinteger(L, arg);
+    luaL_argcheck(L, row >= 1 && (Uint32)row <= q->chunk.count, arg, "row out of range");
+    return (Uint32)row - 1;
+}
+
+static Uint32 check_float(lua_State *L, Uint32 floats, int arg)
+{
+    lua_Integer k = luaL_checkinteger(L, arg);
+    luaL_argcheck(L, k >= 1 && (Uint32)k <= floats, arg, "float index out of range");
+    return (Uint32)k - 1;
+}
+
+static int c_rows(lua_State *L)
+{
+    LuaQuery *q = check_query(L);
+    if (q->chunk.count > 0)
+    {
+        check_chunk(L, q);
+    }
+    lua_pushinteger(L, q->chunk.count);
+    return 1;
+}
+
+/* c:entity(row) */
+static int c_entity(lua_State *L)
+{
+    LuaQuery *q = check_query(L);
+    lua_pushinteger(L, (lua_Integer)q->chunk.entities[check_row(L, q, 2)]);
+    return 1;
+}
+
+/* c:get(term, row, k) */
+static int c_get(lua_State *L)
+{
+    LuaQuery *q = check_query(L);
+    Uint32 floats;
+    const float *column = check_column(L, q, 2, &floats);
+    Uint32 row = check_row(L, q, 3);
+    lua_pushnumber(L, column[row * floats + check_float(L, floats, 4)]);
+    return 1;
+}
+
+/* c:set(term, row, k, value) */
+static int c_set(lua_State *L)
+{
+    LuaQuery *q = check_query(L);
+    Uint32 floats;
+    float *column = check_column(L, q, 2, &floats);
+    Uint32 row = check_row(L, q, 3);
+    column[row * floats + check_float(L, floats, 4)] = (float)luaL_checknumber(L, 5);
+    return 0;
+}
+
+/* c:axpy(dst, src, a): dst += src * a for every row; same-sized terms */
+static int c_axpy(lua_State *L)
+{
+    LuaQuery *q = check_query(L);
+    Uint32 dst_floats, src_floats;
+    float *dst = check_column(L, q, 2, &dst_floats);
+    const float *src = check_column(L, q, 3, &src_floats);
+    luaL_argcheck(L, dst_floats == src_floats, 3, "terms differ in size");
+    float a = (float)luaL_checknumber(L, 4);
+    Uint32 n = q->chunk.count * dst_floats;
+    for (Uint32 i = 0; i < n; i++)
+    {
+        dst[i] += src[i] * a;
+    }
+    return 0;
+}
+
+/* c:scale(term, a) */
+static int c_scale(lua_State *L)
+{
+    LuaQuery *q = check_query(L);
+    Uint32 floats;
+    float *column = check_column(L, q, 2, &floats);
+    float a = (float)luaL_checknumber(L, 3);
+    Uint32 n = q->chunk.count * floats;
+    for (Uint32 i = 0; i < n; i++)
+    {
+        column[i] *= a;
+    }
+    return 0;
+}
+
+/* c:fill(term, k, value): float k of every row */
+static int c_fill(lua_State *L)
+{
+    LuaQuery *q = check_query(L);
+    Uint32 floats;
+    float *column = check_column(L, q, 2, &floats);
+    Uint32 k = check_float(L, floats, 3);
+    float value = (float)luaL_checknumber(L, 4);
+    for (Uint32 row = 0; row < q->chunk.count; row++)
+    {
+        column[row * floats + k] = value;
+    }
+    return 0;
+}
+
+void lua_ecs_open(lua_State *L, EcsWorld *world)
+{
+    static const luaL_Reg query_methods[] = {
+        {"count", q_count},   {"chunks", q_chunks}, {"rows", c_rows},   {"entity", c_entity}, {"get", c_get},
+        {"set", c_set},       {"axpy", c_axpy},     {"scale", c_scale}, {"fill", c_fill},     {NULL, NULL}};
+    static const luaL_Reg functions[] = {
+        {"component", l_component}, {"spawn", l_spawn}, {"create", l_create}, {"destroy", l_destroy},
+        {"alive", l_alive},         {"count", l_count}, {"add", l_add},       {"remove", l_remove},
+        {"get", l_get},             {"set", l_set},     {"query", l_query},   {NULL, NULL}};
+
+    luaL_newmetatable(L, QUERY_METATABLE);
+    lua_pushcfunction(L, q_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pushcfunction(L, q_close);
+    lua_setfield(L, -2, "__close");
+    lua_createtable(L, 0, (int)SDL_arraysize(query_methods) - 1);
+    luaL_setfuncs(L, query_methods, 0);
+    lua_setfield(L, -2, "__index");
+    lua_pop(L, 1);
+
+    lua_createtable(L, 0, (int)SDL_arraysize(functions) - 1);
+    lua_pushlightuserdata(L, world);
+    luaL_setfuncs(L, functions, 1);
+    lua_setglobal(L, "ecs");
+}
+
+/*================================================================================
+ * Benchmark
+ *================================================================================*/
+#define BENCH_RUNS 20
+
+static const char BENCH_SCRIPT[] =
+    "ecs.component('Position', 3)\n"
+    "ecs.component('Velocity', 3)\n"
+    "ecs.component('Frozen', 1)\n"
+    "ecs.spawn(N, 'Position', 'Velocity')\n"
+    "local q = ecs.query('Position', 'Velocity', '!Frozen')\n"
+    "for c in q:chunks() do c:fill(2, 1, 1.0) c:fill(2, 2, 0.5) end\n"
+    "function batched(dt)\n"
+    "  for c in q:chunks() do c:axpy(1, 2, dt) end\n"
+    "end\n"
+    "function per_entity(dt)\n"
+    "  for c in q:chunks() do\n"
+    "    for row = 1, c:rows() do\n"
+    "      for k = 1, 3 do c:set(1, row, k, c:get(1, row, k) + c:get(2, row, k) * dt) end\n"
+    "    end\n"
+    "  end\n"
+    "end\n";
+
+/* Best time of BENCH_RUNS calls of the global function `name`, in ms */
+static double bench_call(lua_State *L, const char *name, int runs)
+{
+    double best = 1e9;
+    for (int run = 0; run < runs; run++)
+    {
+        lua_getglobal(L, name);
+        lua_pushnumber(L, 1.0);
+        Uint64 start = bench_now();
+        if (lua_pcall(L, 1, 0, 0) != LUA_OK)
+        {
+            SDL_Log("Lua ECS benchmark: %s", lua_tostring(L, -1));
+            lua_pop(L, 1);
+            return -1.0;
+        }
+        best = SDL_min(best, bench_ms_since(start));
+    }
+    return best;
+}
+
+void lua_ecs_benchmark(Uint32 count)
+{
+    EcsWorld *world = ecs_world_create();
+    lua_State *L = lua_script_newstate();
+    if (!world || !L)
+    {
+        goto done;
+    }
+    luaL_openlibs(L);
+    lua_ecs_open(L, world);
+    lua_pushinteger(L, count);
+    lua_setglobal(L, "N");
+    if (luaL_dostring(L, BENCH_SCRIPT) != LUA_OK)
+    {
+        SDL_Log("Lua ECS benchmark: %s", lua_tostring(L, -1));
+        goto done;
+    }
+
+    double batched_ms = bench_call(L, "batched", BENCH_RUNS);
+    double per_entity_ms = bench_call(L, "per_entity", 1);
+
+    /* Every entity moved by (1, 0.5, 0) per call */
+    EcsComponent position = ecs_component_find(world, "Position");
+    EcsQuery *query = ecs_query_create(world, &position, 1, NULL, 0);
+    bool moved = false;
+    if (query && ecs_query_prepare(query) > 0)
+    {
+        EcsChunk chunk;
+        ecs_query_chunk(query, 0, &chunk);
+        const float *p = chunk.columns[0];
+        moved = p[0] == (float)(BENCH_RUNS + 1) && p[1] == 0.5f * (BENCH_RUNS + 1);
+    }
+    SDL_Log("Lua ECS benchmark: %u entities, %.3f ms per system batched by chunk, %.2f ms per entity%s", count,
+            batched_ms, per_entity_ms, moved ? "" : " -- WRONG RESULT");
+
+done:
+    if (L)
+    {
+        lua_close(L); /* collects its queries, before the world goes */
+    }
+    ecs_world_destroy(world);
+}
@@ -0,0 +1,29 @@
+#ifndef CUMULUS_LUA_ECS_H
+#define CUMULUS_LUA_ECS_H
+
+#include <SDL3/SDL.h>
+#include <lua.h>
+
+struct EcsWorld;
+
+/* Expose `world` to scripts as the global table `ecs`. Entities are
+   created and changed one at a time or in batches; systems run over
+   query chunks, with whole-column operations done natively:
+
+     ecs.component("Velocity", 3)          -- 3 floats, returns its id
+     ecs.spawn(1000, "Position", "Velocity")
+     local q = ecs.query("Position", "Velocity", "!Frozen")
+     for c in q:chunks() do c:axpy(1, 2, dt) end   -- position += velocity * dt
+
+   Components are addressed by name or id, and from Lua as arrays of
+   floats. Terms, rows and float indices count from 1. Spawning,
+   destroying, adding or removing inside a chunks() loop is an error the
+   next time the loop touches its chunk; collect the entities and change
+   them after the loop. */
+void lua_ecs_open(lua_State *L, struct EcsWorld *world);
+
+/* Native time of a Lua system over `count` entities, batched per chunk
+   and per entity */
+void lua_ecs_benchmark(Uint32 count);
+
+#endif /* CUMULUS_LUA_ECS_H */
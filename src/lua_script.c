@@ -5,6 +5,10 @@
 #include <string.h>
 #include <SDL3/SDL.h>
 
+#include "input.h"
+#include "lua_ecs.h"
+#include "mesh_bvh.h"
+
 #include <lauxlib.h>
 #include <lualib.h>
 
@@ -80,9 +84,107 @@ static void load_mods(lua_State *L)
     closedir(dir);
 }
 
-lua_State* lua_script_init(void)
+/* input_samples() -> { t, x, y, dx, dy, t, x, ... }, count
+   Every mouse motion sample since the previous tick in one flat array, five
+   numbers each: SDL timestamp in ms, window position, relative motion. */
+static int l_input_samples(lua_State *L)
 {
-    lua_State *L = luaL_newstate();
+    Uint32 count = 0;
+    const InputSample *samples = input_samples(&count);
+    lua_createtable(L, (int)(count * 5), 0);
+    for (Uint32 i = 0; i < count; i++) {
+        const InputSample *s = &samples[i];
+        const lua_Number values[5] = {(lua_Number)s->timestamp / 1e6, s->x, s->y, s->dx, s->dy};
+        for (int j = 0; j < 5; j++) {
+            lua_pushnumber(L, values[j]);
+            lua_rawseti(L, -2, (lua_Integer)(i * 5 + j + 1));
+        }
+    }
+    lua_pushinteger(L, (lua_Integer)count);
+    return 2;
+}
+
+typedef struct LuaPick {
+    LuaPickFn fn;
+    void *userdata;
+} LuaPick;
+
+static void set_field(lua_State *L, const char *name, lua_Number value)
+{
+    lua_pushnumber(L, value);
+    lua_setfield(L, -2, name);
+}
+
+/* pick(x, y) -> { node, primitive, triangle, t, x, y, z } or nil
+   The closest model triangle under a position in window coordinates;
+   node and primitive count from 0 like the C side. */
+static int l_pick(lua_State *L)
+{
+    const LuaPick *pick = lua_touserdata(L, lua_upvalueindex(1));
+    float x = (float)luaL_checknumber(L, 1);
+    float y = (float)luaL_checknumber(L, 2);
+    MeshPick hit;
+    if (!pick->fn(pick->userdata, x, y, &hit)) {
+        lua_pushnil(L);
+        return 1;
+    }
+    lua_createtable(L, 0, 7);
+    lua_pushinteger(L, (lua_Integer)hit.node);
+    lua_setfield(L, -2, "node");
+    lua_pushinteger(L, (lua_Integer)hit.primitive);
+    lua_setfield(L, -2, "primitive");
+    lua_pushinteger(L, (lua_Integer)hit.triangle);
+    lua_setfield(L, -2, "triangle");
+    set_field(L, "t", hit.t);
+    set_field(L, "x", hit.position[0]);
+    set_field(L, "y", hit.position[1]);
+    set_field(L, "z", hit.position[2]);
+    return 1;
+}
+
+void lua_script_set_pick(lua_State *L, LuaPickFn fn, void *userdata)
+{
+    if (!L || !fn) {
+        return;
+    }
+    LuaPick *pick = lua_newuserdata(L, sizeof(LuaPick));
+    pick->fn = fn;
+    pick->userdata = userdata;
+    lua_pushcclosure(L, l_pick, 1);
+    lua_setglobal(L, "pick");
+}
+
+static void *script_alloc(void *ud, void *ptr, size_t osize, size_t nsize)
+{
+    (void)ud;
+    (void)osize;
+    if (nsize == 0) {
+        SDL_free(ptr);
+        return NULL;
+    }
+    return SDL_realloc(ptr, nsize);
+}
+
+static int script_panic(lua_State *L)
+{
+    const char *msg = lua_tostring(L, -1);
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+        "Unprotected Lua error: %s", msg ? msg : "(error object is not a string)");
+    return 0;  /* Lua aborts */
+}
+
+lua_State* lua_script_newstate(void)
+{
+    lua_State *L = lua_newstate(script_alloc, NULL, luaL_makeseed(NULL));
+    if (L) {
+        lua_atpanic(L, script_panic);
+    }
+    return L;
+}
+
+lua_State* lua_script_init(struct EcsWorld *world)
+{
+    lua_State *L = lua_script_newstate();
     if (!L) {
         SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
             "Failed to create Lua state");
@@ -90,6 +192,10 @@ lua_State* lua_script_init(void)
     }
 
     luaL_openlibs(L);
+    lua_register(L, "input_samples", l_input_samples);
+    if (world) {
+        lua_ecs_open(L, world);
+    }
 
     /* Load main script */
     load_file(L, find_script("app.lua"));
@@ -107,11 +213,13 @@ void lua_script_reload(lua_State *L)
     load_mods(L);
 }
 
-void lua_script_update(lua_State *L)
+void lua_script_update(lua_State *L, float dt, Uint64 tick)
 {
     lua_getglobal(L, "Update");
     if (lua_isfunction(L, -1)) {
-        if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
+        lua_pushnumber(L, dt);
+        lua_pushinteger(L, (lua_Integer)tick);
+        if (lua_pcall(L, 2, 0, 0) != LUA_OK) {
             SDL_Log("Lua Runtime Error: %s", lua_tostring(L, -1));
             lua_pop(L, 1);
         }
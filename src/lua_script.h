@@ -1,20 +1,41 @@
 #ifndef CUMULUS_LUA_SCRIPT_H
 #define CUMULUS_LUA_SCRIPT_H
 
+#include <SDL3/SDL.h>
 #include <lua.h>
 
+struct EcsWorld;
+struct MeshPick;
+
 /* Init new Lua state, open libs, load scripts/app.lua.
    Searches alongside the binary first (scripts/ for debug builds,
    ../Resources/scripts/ for release macOS bundles), falling back
    to the current working directory.
-   Also loads any .lua files found in a mods/ folder next to the binary. */
-lua_State* lua_script_init(void);
+   Also loads any .lua files found in a mods/ folder next to the binary.
+   Scripts can call input_samples() for the raw mouse motion since the
+   previous tick, pick(x, y) once lua_script_set_pick is called, and
+   reach `world` (if not NULL) through the ecs table, see lua_ecs.h. */
+lua_State* lua_script_init(struct EcsWorld *world);
+
+/* Bare Lua state allocating through SDL_realloc and SDL_free, so
+   CUMULUS_ALLOC_CHECK counts what scripts allocate. NULL on failure. */
+lua_State* lua_script_newstate(void);
+
+/* Answers the scripts' pick(x, y): the closest triangle under a window
+   position, false if none */
+typedef bool (*LuaPickFn)(void *userdata, float x, float y, struct MeshPick *hit);
+
+/* Register pick(x, y) -> { node, primitive, triangle, t, x, y, z } or nil,
+   x and y in window coordinates like mouse events (capture pixels when
+   headless) and the result's in world space */
+void lua_script_set_pick(lua_State *L, LuaPickFn fn, void *userdata);
 
 /* Reload scripts/app.lua and mods (calls luaL_dofile again) */
 void lua_script_reload(lua_State *L);
 
-/* Call global Lua function "update()" if it exists */
-void lua_script_update(lua_State *L);
+/* Call global Lua function Update(dt, tick) if it exists: one fixed
+   simulation tick of dt seconds, tick counting from 1 */
+void lua_script_update(lua_State *L, float dt, Uint64 tick);
 
 /* Close Lua state */
 void lua_script_shutdown(lua_State *L);
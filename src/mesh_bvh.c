@@ -0,0 +1,1080 @@
+#include "mesh_bvh.h"
+#include "accessor_unpack.h"
+#include "bench.h"
+#include "model_import.h"
+#include "parallel.h"
+#include "residency.h"
+#include "scene_bvh.h"
+#include "scene_graph.h"
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_intrin.h>
+#include <cgltf.h>
+
+#define BVH_HUGE 1e30f
+#define BUILD_PARALLEL_TRIANGLES 16384 /* nodes this large scan on the pool and fork their subtrees */
+#define BUILD_CHUNK 8192
+#define RAY_MIN_DIR 1e-20f      /* keeps 1 / dir finite, so box tests never see 0 * inf */
+
+typedef struct MeshBvhNode
+{
+    float min[3];
+    Uint32 index; /* first child (the second is index + 1), or first entry of MeshBvh.order */
+    float max[3];
+    Uint32 count; /* triangles, 0 for inner nodes */
+} MeshBvhNode;
+
+struct MeshBvh
+{
+    const float *position[3];
+    const Uint32 *indices;
+    Uint32 triangle_count;
+    MeshBvhNode *nodes;
+    Uint32 node_count;
+    Uint32 *order; /* triangles in leaf order */
+};
+
+/*================================================================================
+ * Build — binned SAH, forking large subtrees onto the pool
+ *================================================================================*/
+typedef struct Bin
+{
+    float min[3];
+    float max[3];
+    Uint32 count;
+} Bin;
+
+/* A triangle's bounds, kept in node order so scans read them front to back */
+typedef struct BuildRef
+{
+    float min[3];
+    float max[3];
+    Uint32 triangle;
+} BuildRef;
+
+typedef struct BuildContext
+{
+    MeshBvh *bvh;
+    BuildRef *refs;
+    Uint32 vertex_count;
+    SDL_AtomicInt node_count;
+    SDL_AtomicInt bad_index; /* set when an index is past the vertices */
+} BuildContext;
+
+/* The node's bounds are already set; its range's centroid bounds ride along */
+typedef struct BuildTask
+{
+    BuildContext *ctx;
+    Uint32 node;
+    Uint32 begin, end;      /* range of BuildContext.refs */
+    float cmin[3], cmax[3]; /* centroids, doubled */
+    int depth;
+} BuildTask;
+
+typedef struct NodeScan
+{
+    const BuildRef *refs;
+    int bin_count;  /* fewer than MESH_BVH_BINS for small ranges */
+    float cmin[3];
+    float scale[3]; /* centroid to bin, 0 on flat axes */
+    Bin (*bins)[3][MESH_BVH_BINS]; /* one set per chunk */
+} NodeScan;
+
+static void empty_bounds(float min[3], float max[3])
+{
+    min[0] = min[1] = min[2] = BVH_HUGE;
+    max[0] = max[1] = max[2] = -BVH_HUGE;
+}
+
+static float half_area(const float min[3], const float max[3])
+{
+    float dx = max[0] - min[0], dy = max[1] - min[1], dz = max[2] - min[2];
+    return dx * dy + dy * dz + dz * dx;
+}
+
+/* Triangles are tested four at a time */
+static float packs(Uint32 count)
+{
+    return (float)((count + 3) / 4);
+}
+
+static void merge_bounds(float min[3], float max[3], const float bmin[3], const float bmax[3])
+{
+    for (int a = 0; a < 3; a++)
+    {
+        min[a] = SDL_min(min[a], bmin[a]);
+        max[a] = SDL_max(max[a], bmax[a]);
+    }
+}
+
+/* Grow a side's bounds and doubled-centroid bounds by one triangle */
+static void add_ref(float min[3], float max[3], float cmin[3], float cmax[3], const BuildRef *r)
+{
+    for (int a = 0; a < 3; a++)
+    {
+        float c = r->min[a] + r->max[a];
+        min[a] = SDL_min(min[a], r->min[a]);
+        max[a] = SDL_max(max[a], r->max[a]);
+        cmin[a] = SDL_min(cmin[a], c);
+        cmax[a] = SDL_max(cmax[a], c);
+    }
+}
+
+static void triangle_bounds_range(void *userdata, size_t begin, size_t end)
+{
+    BuildContext *ctx = userdata;
+    MeshBvh *bvh = ctx->bvh;
+    for (size_t t = begin; t < end; t++)
+    {
+        BuildRef *r = &ctx->refs[t];
+        empty_bounds(r->min, r->max);
+        r->triangle = (Uint32)t;
+        for (int k = 0; k < 3; k++)
+        {
+            Uint32 v = bvh->indices[t * 3 + k];
+            for (int a = 0; a < 3; a++)
+            {
+                float p = bvh->position[a][v];
+                r->min[a] = SDL_min(r->min[a], p);
+                r->max[a] = SDL_max(r->max[a], p);
+            }
+        }
+    }
+}
+
+static inline int bin_index(const NodeScan *scan, const BuildRef *r, int axis)
+{
+    int bin = (int)((r->min[axis] + r->max[axis] - scan->cmin[axis]) * scan->scale[axis]);
+    return bin < 0 ? 0 : bin >= scan->bin_count ? scan->bin_count - 1 : bin;
+}
+
+static void scan_bins_range(void *userdata, size_t begin, size_t end)
+{
+    NodeScan *scan = userdata;
+    Bin(*bins)[MESH_BVH_BINS] = scan->bins[begin / BUILD_CHUNK];
+    for (int a = 0; a < 3; a++)
+    {
+        for (int k = 0; k < scan->bin_count; k++)
+        {
+            empty_bounds(bins[a][k].min, bins[a][k].max);
+            bins[a][k].count = 0;
+        }
+    }
+    for (size_t i = begin; i < end; i++)
+    {
+        const BuildRef *r = &scan->refs[i];
+        for (int a = 0; a < 3; a++)
+        {
+            if (scan->scale[a] == 0.0f)
+                continue;
+            Bin *bin = &bins[a][bin_index(scan, r, a)];
+            merge_bounds(bin->min, bin->max, r->min, r->max);
+            bin->count++;
+        }
+    }
+}
+
+/* Best SAH plane of the task's range, or axis -1 if no plane separates it.
+   Large ranges bin a chunk per pool task and merge the chunks' bins. */
+static void find_split(const BuildTask *task, NodeScan *scan, int *best_axis, int *best_plane)
+{
+    Uint32 count = task->end - task->begin;
+    scan->bin_count = count < MESH_BVH_BINS ? (int)count : MESH_BVH_BINS;
+    for (int a = 0; a < 3; a++)
+    {
+        float extent = task->cmax[a] - task->cmin[a];
+        scan->cmin[a] = task->cmin[a];
+        scan->scale[a] = extent > 0.0f ? (float)scan->bin_count * 0.9999f / extent : 0.0f;
+    }
+
+    Bin local[1][3][MESH_BVH_BINS];
+    size_t parts = 1;
+    scan->bins = NULL;
+    if (count >= BUILD_PARALLEL_TRIANGLES && parallel_worker_count() > 0)
+    {
+        parts = (count + BUILD_CHUNK - 1) / BUILD_CHUNK;
+        scan->bins = SDL_malloc(parts * sizeof(*scan->bins));
+    }
+    if (scan->bins) /* bin serially when out of memory */
+    {
+        parallel_for(count, BUILD_CHUNK, scan_bins_range, scan);
+    }
+    else
+    {
+        parts = 1;
+        scan->bins = local;
+        scan_bins_range(scan, 0, count);
+    }
+
+    float best_cost = BVH_HUGE;
+    *best_axis = -1;
+    for (int a = 0; a < 3; a++)
+    {
+        if (scan->scale[a] == 0.0f)
+            continue;
+        Bin bins[MESH_BVH_BINS];
+        int last = scan->bin_count - 1;
+        for (int k = 0; k <= last; k++)
+        {
+            bins[k] = scan->bins[0][a][k];
+            for (size_t i = 1; i < parts; i++)
+            {
+                merge_bounds(bins[k].min, bins[k].max, scan->bins[i][a][k].min, scan->bins[i][a][k].max);
+                bins[k].count += scan->bins[i][a][k].count;
+            }
+        }
+
+        /* Sweep from the right for the cost of every right side, then
+           from the left; plane k puts bins below k on the left */
+        float right_cost[MESH_BVH_BINS];
+        float rmin[3], rmax[3];
+        Uint32 right = 0;
+        empty_bounds(rmin, rmax);
+        for (int k = last; k > 0; k--)
+        {
+            merge_bounds(rmin, rmax, bins[k].min, bins[k].max);
+            right += bins[k].count;
+            right_cost[k] = right ? half_area(rmin, rmax) * packs(right) : 0.0f;
+        }
+        float lmin[3], lmax[3];
+        Uint32 left = 0;
+        empty_bounds(lmin, lmax);
+        for (int k = 1; k <= last; k++)
+        {
+            merge_bounds(lmin, lmax, bins[k - 1].min, bins[k - 1].max);
+            left += bins[k - 1].count;
+            if (left == 0 || left == count)
+                continue;
+            float cost = half_area(lmin, lmax) * packs(left) + right_cost[k];
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                *best_axis = a;
+                *best_plane = k;
+            }
+        }
+    }
+    if (scan->bins != local)
+        SDL_free(scan->bins);
+}
+
+/* Turn the task's node into a leaf, or split its range and return the
+   two children's tasks. Ranges that fit one four-triangle test are always
+   leaves: two children cost at least that test again plus their boxes. */
+static bool split_node(const BuildTask *task, BuildTask children[2])
+{
+    BuildContext *ctx = task->ctx;
+    MeshBvhNode *node = &ctx->bvh->nodes[task->node];
+    Uint32 count = task->end - task->begin;
+    if (count <= MESH_BVH_LEAF_TRIANGLES || task->depth >= MESH_BVH_MAX_DEPTH)
+    {
+        node->index = task->begin;
+        node->count = count;
+        return false;
+    }
+
+    NodeScan scan = {ctx->refs + task->begin, 0, {0}, {0}, NULL};
+    int best_axis, best_plane = 0;
+    find_split(task, &scan, &best_axis, &best_plane);
+
+    Uint32 first = (Uint32)SDL_AddAtomicInt(&ctx->node_count, 2);
+    MeshBvhNode *left = &ctx->bvh->nodes[first], *right = left + 1;
+    BuildTask *lt = &children[0], *rt = &children[1];
+    empty_bounds(left->min, left->max);
+    empty_bounds(right->min, right->max);
+    empty_bounds(lt->cmin, lt->cmax);
+    empty_bounds(rt->cmin, rt->cmax);
+
+    /* Partition by the chosen plane, gathering each side's bounds on the
+       way; coincident centroids split in half */
+    BuildRef *refs = (BuildRef *)scan.refs;
+    Uint32 mid;
+    if (best_axis >= 0)
+    {
+        Uint32 i = 0, j = count;
+        while (i < j)
+        {
+            if (bin_index(&scan, &refs[i], best_axis) < best_plane)
+            {
+                add_ref(left->min, left->max, lt->cmin, lt->cmax, &refs[i]);
+                i++;
+            }
+            else
+            {
+                BuildRef r = refs[i];
+                refs[i] = refs[--j];
+                refs[j] = r;
+                add_ref(right->min, right->max, rt->cmin, rt->cmax, &r);
+            }
+        }
+        mid = i;
+    }
+    else
+    {
+        mid = count / 2;
+        for (Uint32 i = 0; i < count; i++)
+        {
+            if (i < mid)
+                add_ref(left->min, left->max, lt->cmin, lt->cmax, &refs[i]);
+            else
+                add_ref(right->min, right->max, rt->cmin, rt->cmax, &refs[i]);
+        }
+    }
+
+    node->index = first;
+    node->count = 0;
+    lt->ctx = rt->ctx = ctx;
+    lt->node = first;
+    rt->node = first + 1;
+    lt->begin = task->begin;
+    lt->end = rt->begin = task->begin + mid;
+    rt->end = task->end;
+    lt->depth = rt->depth = task->depth + 1;
+    return true;
+}
+
+static void build_subtree(void *userdata)
+{
+    BuildTask stack[MESH_BVH_MAX_DEPTH + 2];
+    int top = 0;
+    stack[top++] = *(const BuildTask *)userdata;
+    while (top > 0)
+    {
+        BuildTask task = stack[--top];
+        BuildTask children[2];
+        if (!split_node(&task, children))
+            continue;
+
+        /* Large halves fork: the pool takes one while this thread builds the other */
+        if (children[1].end - children[1].begin >= BUILD_PARALLEL_TRIANGLES &&
+            children[0].end - children[0].begin >= BUILD_PARALLEL_TRIANGLES && parallel_worker_count() > 0)
+        {
+            ParallelJob job = parallel_spawn(build_subtree, &children[1], NULL, 0);
+            build_subtree(&children[0]);
+            parallel_wait(job);
+            continue;
+        }
+        stack[top++] = children[1];
+        stack[top++] = children[0];
+    }
+}
+
+static void check_indices_range(void *userdata, size_t begin, size_t end)
+{
+    BuildContext *ctx = userdata;
+    for (size_t i = begin; i < end; i++)
+    {
+        if (ctx->bvh->indices[i] >= ctx->vertex_count)
+        {
+            SDL_SetAtomicInt(&ctx->bad_index, 1);
+            return;
+        }
+    }
+}
+
+static void store_order_range(void *userdata, size_t begin, size_t end)
+{
+    BuildContext *ctx = userdata;
+    for (size_t i = begin; i < end; i++)
+        ctx->bvh->order[i] = ctx->refs[i].triangle;
+}
+
+MeshBvh *mesh_bvh_build(const AccessorStreams *positions, const Uint32 *indices, size_t index_count)
+{
+    if (!positions || positions->num_components < 3 || positions->count > SDL_MAX_UINT32 || !indices ||
+        index_count / 3 > (1u << 30))
+        return NULL;
+    MeshBvh *bvh = SDL_calloc(1, sizeof(MeshBvh));
+    if (!bvh)
+        return NULL;
+    for (int a = 0; a < 3; a++)
+        bvh->position[a] = positions->streams[a];
+    bvh->indices = indices;
+    bvh->triangle_count = (Uint32)(index_count / 3);
+
+    Uint32 n = bvh->triangle_count ? bvh->triangle_count : 1;
+    BuildRef *refs = SDL_malloc((size_t)n * sizeof(BuildRef));
+    bvh->nodes = SDL_malloc((size_t)n * 2 * sizeof(MeshBvhNode));
+    bvh->order = SDL_malloc((size_t)n * sizeof(Uint32));
+    if (!refs || !bvh->nodes || !bvh->order)
+    {
+        SDL_free(refs);
+        mesh_bvh_free(bvh);
+        return NULL;
+    }
+
+    /* Every index must name a vertex before any is read */
+    BuildContext ctx;
+    ctx.bvh = bvh;
+    ctx.refs = refs;
+    ctx.vertex_count = (Uint32)positions->count;
+    SDL_SetAtomicInt(&ctx.node_count, 1);
+    SDL_SetAtomicInt(&ctx.bad_index, 0);
+    parallel_for((size_t)bvh->triangle_count * 3, BUILD_CHUNK * 3, check_indices_range, &ctx);
+    if (SDL_GetAtomicInt(&ctx.bad_index))
+    {
+        SDL_Log("Mesh BVH: index out of range of %zu vertices", positions->count);
+        SDL_free(refs);
+        mesh_bvh_free(bvh);
+        return NULL;
+    }
+
+    if (bvh->triangle_count)
+    {
+        parallel_for(bvh->triangle_count, BUILD_CHUNK, triangle_bounds_range, &ctx);
+        BuildTask root = {&ctx, 0, 0, bvh->triangle_count, {0}, {0}, 0};
+        empty_bounds(bvh->nodes[0].min, bvh->nodes[0].max);
+        empty_bounds(root.cmin, root.cmax);
+        for (Uint32 t = 0; t < bvh->triangle_count; t++)
+            add_ref(bvh->nodes[0].min, bvh->nodes[0].max, root.cmin, root.cmax, &refs[t]);
+        build_subtree(&root);
+
+        parallel_for(bvh->triangle_count, BUILD_CHUNK, store_order_range, &ctx);
+        bvh->node_count = (Uint32)SDL_GetAtomicInt(&ctx.node_count);
+        MeshBvhNode *fit = SDL_realloc(bvh->nodes, bvh->node_count * sizeof(MeshBvhNode));
+        if (fit)
+            bvh->nodes = fit;
+    }
+    SDL_free(refs);
+    return bvh;
+}
+
+void mesh_bvh_free(MeshBvh *bvh)
+{
+    if (!bvh)
+        return;
+    SDL_free(bvh->nodes);
+    SDL_free(bvh->order);
+    SDL_free(bvh);
+}
+
+size_t mesh_bvh_node_count(const MeshBvh *bvh)
+{
+    return bvh ? bvh->node_count : 0;
+}
+
+size_t mesh_bvh_bytes(const MeshBvh *bvh)
+{
+    if (!bvh)
+        return 0;
+    return sizeof(MeshBvh) + bvh->node_count * sizeof(MeshBvhNode) + bvh->triangle_count * sizeof(Uint32);
+}
+
+/*================================================================================
+ * Ray queries
+ *================================================================================*/
+typedef struct Ray
+{
+    float origin[4]; /* lane 3 unused */
+    float inv_dir[4];
+    float dir[3];
+} Ray;
+
+/* Four triangles as a vertex and two edges, lane per triangle. Unused
+   lanes are all zero, which no ray hits. */
+typedef struct TriangleLanes
+{
+    float v0[3][4];
+    float e1[3][4];
+    float e2[3][4];
+} TriangleLanes;
+
+static void ray_init(Ray *ray, const float origin[3], const float dir[3])
+{
+    for (int a = 0; a < 3; a++)
+    {
+        float d = dir[a];
+        if (SDL_fabsf(d) < RAY_MIN_DIR)
+            d = d < 0.0f ? -RAY_MIN_DIR : RAY_MIN_DIR;
+        ray->origin[a] = origin[a];
+        ray->inv_dir[a] = 1.0f / d;
+        ray->dir[a] = dir[a];
+    }
+    ray->origin[3] = 0.0f;
+    ray->inv_dir[3] = 0.0f;
+}
+
+/* Entry distance into the node's box within [0, t_max], or BVH_HUGE */
+static inline float ray_box(const Ray *ray, const MeshBvhNode *node, float t_max)
+{
+#if defined(SDL_SSE2_INTRINSICS)
+    /* Lane 3 loads the node's index and count: masked to the ray's range */
+    const __m128 xyz = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    __m128 o = _mm_loadu_ps(ray->origin), inv = _mm_loadu_ps(ray->inv_dir);
+    __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->min), o), inv);
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(node->max), o), inv);
+    __m128 enter = _mm_and_ps(xyz, _mm_min_ps(t0, t1));
+    __m128 leave = _mm_or_ps(_mm_and_ps(xyz, _mm_max_ps(t0, t1)), _mm_andnot_ps(xyz, _mm_set1_ps(t_max)));
+    enter = _mm_max_ps(enter, _mm_shuffle_ps(enter, enter, _MM_SHUFFLE(1, 0, 3, 2)));
+    enter = _mm_max_ps(enter, _mm_shuffle_ps(enter, enter, _MM_SHUFFLE(2, 3, 0, 1)));
+    leave = _mm_min_ps(leave, _mm_shuffle_ps(leave, leave, _MM_SHUFFLE(1, 0, 3, 2)));
+    leave = _mm_min_ps(leave, _mm_shuffle_ps(leave, leave, _MM_SHUFFLE(2, 3, 0, 1)));
+    float near = _mm_cvtss_f32(enter), far = _mm_cvtss_f32(leave);
+#elif defined(SDL_NEON_INTRINSICS)
+    const uint32x4_t xyz = vsetq_lane_u32(0, vdupq_n_u32(0xFFFFFFFFu), 3);
+    float32x4_t o = vld1q_f32(ray->origin), inv = vld1q_f32(ray->inv_dir);
+    float32x4_t t0 = vmulq_f32(vsubq_f32(vld1q_f32(node->min), o), inv);
+    float32x4_t t1 = vmulq_f32(vsubq_f32(vld1q_f32(node->max), o), inv);
+    float32x4_t enter = vbslq_f32(xyz, vminq_f32(t0, t1), vdupq_n_f32(0.0f));
+    float32x4_t leave = vbslq_f32(xyz, vmaxq_f32(t0, t1), vdupq_n_f32(t_max));
+    float32x2_t e = vpmax_f32(vget_low_f32(enter), vget_high_f32(enter));
+    float32x2_t l = vpmin_f32(vget_low_f32(leave), vget_high_f32(leave));
+    float near = vget_lane_f32(vpmax_f32(e, e), 0), far = vget_lane_f32(vpmin_f32(l, l), 0);
+#else
+    float near = 0.0f, far = t_max;
+    for (int a = 0; a < 3; a++)
+    {
+        float t0 = (node->min[a] - ray->origin[a]) * ray->inv_dir[a];
+        float t1 = (node->max[a] - ray->origin[a]) * ray->inv_dir[a];
+        near = SDL_max(near, SDL_min(t0, t1));
+        far = SDL_min(far, SDL_max(t0, t1));
+    }
+#endif
+    return near <= far ? near : BVH_HUGE;
+}
+
+static void gather_triangles(const MeshBvh *bvh, const Uint32 *triangles, Uint32 count, TriangleLanes *lanes)
+{
+    SDL_zerop(lanes);
+    for (Uint32 l = 0; l < count; l++)
+    {
+        const Uint32 *tri = &bvh->indices[(size_t)triangles[l] * 3];
+        for (int a = 0; a < 3; a++)
+        {
+            float p0 = bvh->position[a][tri[0]];
+            lanes->v0[a][l] = p0;
+            lanes->e1[a][l] = bvh->position[a][tri[1]] - p0;
+            lanes->e2[a][l] = bvh->position[a][tri[2]] - p0;
+        }
+    }
+}
+
+/* Möller-Trumbore on four triangles. Returns a bit per lane hit with t in
+   (0, t_max]; t, u and v are written for every lane. */
+static int intersect_triangles(const TriangleLanes *tri, const Ray *ray, float t_max, float t[4], float u[4],
+                               float v[4])
+{
+#if defined(SDL_SSE2_INTRINSICS)
+    __m128 dx = _mm_set1_ps(ray->dir[0]), dy = _mm_set1_ps(ray->dir[1]), dz = _mm_set1_ps(ray->dir[2]);
+    __m128 e1x = _mm_loadu_ps(tri->e1[0]), e1y = _mm_loadu_ps(tri->e1[1]), e1z = _mm_loadu_ps(tri->e1[2]);
+    __m128 e2x = _mm_loadu_ps(tri->e2[0]), e2y = _mm_loadu_ps(tri->e2[1]), e2z = _mm_loadu_ps(tri->e2[2]);
+    __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+    __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+    __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+    __m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+    __m128 inv = _mm_div_ps(_mm_set1_ps(1.0f), det);
+    __m128 sx = _mm_sub_ps(_mm_set1_ps(ray->origin[0]), _mm_loadu_ps(tri->v0[0]));
+    __m128 sy = _mm_sub_ps(_mm_set1_ps(ray->origin[1]), _mm_loadu_ps(tri->v0[1]));
+    __m128 sz = _mm_sub_ps(_mm_set1_ps(ray->origin[2]), _mm_loadu_ps(tri->v0[2]));
+    __m128 uu = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inv);
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+    __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+    __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+    __m128 vv = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv);
+    __m128 tt = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 hit = _mm_and_ps(_mm_cmpneq_ps(det, zero), _mm_cmpge_ps(uu, zero));
+    hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(vv, zero), _mm_cmple_ps(_mm_add_ps(uu, vv), _mm_set1_ps(1.0f))));
+    hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpgt_ps(tt, zero), _mm_cmple_ps(tt, _mm_set1_ps(t_max))));
+    _mm_storeu_ps(t, tt);
+    _mm_storeu_ps(u, uu);
+    _mm_storeu_ps(v, vv);
+    return _mm_movemask_ps(hit);
+#elif defined(SDL_NEON_INTRINSICS)
+    float32x4_t dx = vdupq_n_f32(ray->dir[0]), dy = vdupq_n_f32(ray->dir[1]), dz = vdupq_n_f32(ray->dir[2]);
+    float32x4_t e1x = vld1q_f32(tri->e1[0]), e1y = vld1q_f32(tri->e1[1]), e1z = vld1q_f32(tri->e1[2]);
+    float32x4_t e2x = vld1q_f32(tri->e2[0]), e2y = vld1q_f32(tri->e2[1]), e2z = vld1q_f32(tri->e2[2]);
+    float32x4_t px = vmlsq_f32(vmulq_f32(dy, e2z), dz, e2y);
+    float32x4_t py = vmlsq_f32(vmulq_f32(dz, e2x), dx, e2z);
+    float32x4_t pz = vmlsq_f32(vmulq_f32(dx, e2y), dy, e2x);
+    float32x4_t det = vmlaq_f32(vmlaq_f32(vmulq_f32(e1x, px), e1y, py), e1z, pz);
+    /* Reciprocal estimate and two Newton steps: full float precision */
+    float32x4_t inv = vrecpeq_f32(det);
+    inv = vmulq_f32(vrecpsq_f32(det, inv), inv);
+    inv = vmulq_f32(vrecpsq_f32(det, inv), inv);
+    float32x4_t sx = vsubq_f32(vdupq_n_f32(ray->origin[0]), vld1q_f32(tri->v0[0]));
+    float32x4_t sy = vsubq_f32(vdupq_n_f32(ray->origin[1]), vld1q_f32(tri->v0[1]));
+    float32x4_t sz = vsubq_f32(vdupq_n_f32(ray->origin[2]), vld1q_f32(tri->v0[2]));
+    float32x4_t uu = vmulq_f32(vmlaq_f32(vmlaq_f32(vmulq_f32(sx, px), sy, py), sz, pz), inv);
+    float32x4_t qx = vmlsq_f32(vmulq_f32(sy, e1z), sz, e1y);
+    float32x4_t qy = vmlsq_f32(vmulq_f32(sz, e1x), sx, e1z);
+    float32x4_t qz = vmlsq_f32(vmulq_f32(sx, e1y), sy, e1x);
+    float32x4_t vv = vmulq_f32(vmlaq_f32(vmlaq_f32(vmulq_f32(dx, qx), dy, qy), dz, qz), inv);
+    float32x4_t tt = vmulq_f32(vmlaq_f32(vmlaq_f32(vmulq_f32(e2x, qx), e2y, qy), e2z, qz), inv);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    uint32x4_t hit = vandq_u32(vmvnq_u32(vceqq_f32(det, zero)), vcgeq_f32(uu, zero));
+    hit = vandq_u32(hit, vandq_u32(vcgeq_f32(vv, zero), vcleq_f32(vaddq_f32(uu, vv), vdupq_n_f32(1.0f))));
+    hit = vandq_u32(hit, vandq_u32(vcgtq_f32(tt, zero), vcleq_f32(tt, vdupq_n_f32(t_max))));
+    vst1q_f32(t, tt);
+    vst1q_f32(u, uu);
+    vst1q_f32(v, vv);
+    Uint32 lanes[4];
+    vst1q_u32(lanes, hit);
+    return (int)((lanes[0] & 1) | (lanes[1] & 2) | (lanes[2] & 4) | (lanes[3] & 8));
+#else
+    int mask = 0;
+    for (int l = 0; l < 4; l++)
+    {
+        float e1[3] = {tri->e1[0][l], tri->e1[1][l], tri->e1[2][l]};
+        float e2[3] = {tri->e2[0][l], tri->e2[1][l], tri->e2[2][l]};
+        float s[3] = {ray->origin[0] - tri->v0[0][l], ray->origin[1] - tri->v0[1][l], ray->origin[2] - tri->v0[2][l]};
+        const float *d = ray->dir;
+        float p[3] = {d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0]};
+        float q[3] = {s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0]};
+        float det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+        float inv = det != 0.0f ? 1.0f / det : 0.0f;
+        u[l] = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv;
+        v[l] = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inv;
+        t[l] = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv;
+        if (det != 0.0f && u[l] >= 0.0f && v[l] >= 0.0f && u[l] + v[l] <= 1.0f && t[l] > 0.0f && t[l] <= t_max)
+            mask |= 1 << l;
+    }
+    return mask;
+#endif
+}
+
+typedef struct RayEntry
+{
+    Uint32 node;
+    float t;
+} RayEntry;
+
+bool mesh_bvh_raycast(const MeshBvh *bvh, const float origin[3], const float dir[3], float max_t, MeshBvhHit *hit)
+{
+    if (!bvh || bvh->node_count == 0)
+        return false;
+    Ray ray;
+    ray_init(&ray, origin, dir);
+
+    float best = max_t;
+    bool found = false;
+    RayEntry stack[MESH_BVH_MAX_DEPTH + 2];
+    int top = 0;
+    float t_root = ray_box(&ray, &bvh->nodes[0], best);
+    if (t_root < BVH_HUGE)
+        stack[top++] = (RayEntry){0, t_root};
+
+    while (top > 0)
+    {
+        RayEntry entry = stack[--top];
+        if (entry.t > best)
+            continue;
+        const MeshBvhNode *node = &bvh->nodes[entry.node];
+        if (node->count)
+        {
+            for (Uint32 i = 0; i < node->count; i += 4)
+            {
+                const Uint32 *triangles = &bvh->order[node->index + i];
+                TriangleLanes lanes;
+                gather_triangles(bvh, triangles, SDL_min(node->count - i, 4u), &lanes);
+                float t[4], u[4], v[4];
+                int mask = intersect_triangles(&lanes, &ray, best, t, u, v);
+                for (int l = 0; l < 4; l++)
+                {
+                    if (!(mask & (1 << l)) || t[l] > best)
+                        continue;
+                    best = t[l];
+                    found = true;
+                    if (hit)
+                        *hit = (MeshBvhHit){t[l], triangles[l], u[l], v[l]};
+                }
+            }
+            continue;
+        }
+
+        /* Nearer child on top of the stack */
+        RayEntry a = {node->index, ray_box(&ray, &bvh->nodes[node->index], best)};
+        RayEntry b = {node->index + 1, ray_box(&ray, &bvh->nodes[node->index + 1], best)};
+        if (b.t < a.t)
+        {
+            RayEntry swap = a;
+            a = b;
+            b = swap;
+        }
+        if (b.t < BVH_HUGE)
+            stack[top++] = b;
+        if (a.t < BVH_HUGE)
+            stack[top++] = a;
+    }
+    return found;
+}
+
+/*================================================================================
+ * Model picking
+ *================================================================================*/
+struct MeshPicker
+{
+    const Model *model;
+    MeshBvh **bvhs; /* per primitive, NULL when it has no triangles to pick */
+    MeshPickerStats stats;
+};
+
+typedef struct PickerBuild
+{
+    MeshPicker *picker;
+    Uint32 *primitives; /* largest first */
+} PickerBuild;
+
+static void build_primitives_range(void *userdata, size_t begin, size_t end)
+{
+    PickerBuild *build = userdata;
+    for (size_t i = begin; i < end; i++)
+    {
+        Uint32 p = build->primitives[i];
+        const ModelPrimitive *prim = &build->picker->model->primitives[p];
+        build->picker->bvhs[p] = mesh_bvh_build(prim->positions, prim->indices, prim->index_count);
+    }
+}
+
+static const Model *sort_model; /* SDL_qsort has no userdata */
+
+static int SDLCALL compare_primitive_size(const void *a, const void *b)
+{
+    size_t x = sort_model->primitives[*(const Uint32 *)a].index_count;
+    size_t y = sort_model->primitives[*(const Uint32 *)b].index_count;
+    return x > y ? -1 : x < y ? 1 : 0;
+}
+
+static bool pickable(const ModelPrimitive *prim)
+{
+    return prim->positions && prim->positions->num_components >= 3 &&
+           prim->source->type == cgltf_primitive_type_triangles && prim->index_count >= 3;
+}
+
+MeshPicker *mesh_picker_create(const Model *model)
+{
+    if (!model)
+        return NULL;
+    Uint64 start = bench_now();
+    MeshPicker *picker = SDL_calloc(1, sizeof(MeshPicker));
+    size_t n = model->primitives_count ? model->primitives_count : 1;
+    Uint32 *primitives = SDL_malloc(n * sizeof(Uint32));
+    if (picker)
+    {
+        picker->model = model;
+        picker->bvhs = SDL_calloc(n, sizeof(MeshBvh *));
+    }
+    if (!picker || !picker->bvhs || !primitives)
+    {
+        SDL_free(primitives);
+        mesh_picker_free(picker);
+        return NULL;
+    }
+
+    /* Big primitives first, so the last one started is a small one */
+    Uint32 count = 0;
+    for (size_t p = 0; p < model->primitives_count; p++)
+    {
+        if (pickable(&model->primitives[p]))
+            primitives[count++] = (Uint32)p;
+    }
+    sort_model = model;
+    SDL_qsort(primitives, count, sizeof(Uint32), compare_primitive_size);
+    PickerBuild build = {picker, primitives};
+    parallel_for(count, 1, build_primitives_range, &build);
+    SDL_free(primitives);
+
+    size_t bytes = n * sizeof(MeshBvh *);
+    for (size_t p = 0; p < model->primitives_count; p++)
+    {
+        const MeshBvh *bvh = picker->bvhs[p];
+        bytes += mesh_bvh_bytes(bvh);
+        picker->stats.nodes += mesh_bvh_node_count(bvh);
+        picker->stats.triangles += bvh ? bvh->triangle_count : 0;
+    }
+    if (!residency_reserve(RESIDENCY_MODELS, bytes))
+    {
+        SDL_Log("Picking BVHs need %.1f MB, over the models budget", bytes / (1024.0 * 1024.0));
+        mesh_picker_free(picker);
+        return NULL;
+    }
+    picker->stats.bytes = bytes;
+    picker->stats.build_ms = bench_ms_since(start);
+    return picker;
+}
+
+void mesh_picker_free(MeshPicker *picker)
+{
+    if (!picker)
+        return;
+    if (picker->bvhs)
+    {
+        for (size_t p = 0; p < picker->model->primitives_count; p++)
+            mesh_bvh_free(picker->bvhs[p]);
+    }
+    residency_release(RESIDENCY_MODELS, picker->stats.bytes);
+    SDL_free(picker->bvhs);
+    SDL_free(picker);
+}
+
+/* Entry distance into a scene item's or node's world box, or BVH_HUGE */
+static float ray_bounds(const Ray *ray, const float min[3], const float max[3], float t_max)
+{
+    float near = 0.0f, far = t_max;
+    for (int a = 0; a < 3; a++)
+    {
+        float t0 = (min[a] - ray->origin[a]) * ray->inv_dir[a];
+        float t1 = (max[a] - ray->origin[a]) * ray->inv_dir[a];
+        near = SDL_max(near, SDL_min(t0, t1));
+        far = SDL_min(far, SDL_max(t0, t1));
+    }
+    return near <= far ? near : BVH_HUGE;
+}
+
+bool mesh_picker_raycast(MeshPicker *picker, const SceneBvh *bvh, const SceneGraph *graph, const float origin[3],
+                         const float dir[3], MeshPick *hit)
+{
+    if (!picker || !bvh || !graph || bvh->item_count == 0)
+        return false;
+    Uint64 start = bench_now();
+    Ray ray;
+    ray_init(&ray, origin, dir);
+
+    /* The scene BVH finds the items the ray passes, nearest boxes first;
+       each is searched in its own space, where t means the same */
+    float best = BVH_HUGE;
+    bool found = false;
+    RayEntry stack[128];
+    int top = 0;
+    float t_root = ray_bounds(&ray, bvh->nodes[0].min, bvh->nodes[0].max, best);
+    if (t_root < BVH_HUGE)
+        stack[top++] = (RayEntry){0, t_root};
+    while (top > 0)
+    {
+        RayEntry entry = stack[--top];
+        if (entry.t > best)
+            continue;
+        const SceneBvhNode *node = &bvh->nodes[entry.node];
+        if (node->left)
+        {
+            const SceneBvhNode *l = &bvh->nodes[node->left], *r = l + 1;
+            RayEntry a = {node->left, ray_bounds(&ray, l->min, l->max, best)};
+            RayEntry b = {node->left + 1, ray_bounds(&ray, r->min, r->max, best)};
+            if (b.t < a.t)
+            {
+                RayEntry swap = a;
+                a = b;
+                b = swap;
+            }
+            if (b.t < BVH_HUGE && top < (int)SDL_arraysize(stack))
+                stack[top++] = b;
+            if (a.t < BVH_HUGE && top < (int)SDL_arraysize(stack))
+                stack[top++] = a;
+            continue;
+        }
+
+        for (Uint32 i = node->first; i < node->first + node->count; i++)
+        {
+            Uint32 item = bvh->order[i];
+            const float *b = &bvh->item_world[item * 6];
+            const MeshBvh *mesh = picker->bvhs[bvh->item_primitive[item]];
+            if (!mesh || ray_bounds(&ray, b, b + 3, best) > best)
+                continue;
+            Mat4 to_local;
+            if (!mat4_invert(&to_local, &graph->world[bvh->item_node[item]]))
+                continue;
+            float local_origin[3], local_dir[3];
+            mat4_transform_point(&to_local, origin, local_origin);
+            mat4_transform_vector(&to_local, dir, local_dir);
+            MeshBvhHit local;
+            if (!mesh_bvh_raycast(mesh, local_origin, local_dir, best, &local))
+                continue;
+            best = local.t;
+            found = true;
+            if (hit)
+            {
+                hit->t = local.t;
+                for (int a = 0; a < 3; a++)
+                    hit->position[a] = origin[a] + dir[a] * local.t;
+                hit->node = bvh->item_node[item];
+                hit->primitive = bvh->item_primitive[item];
+                hit->triangle = local.triangle;
+            }
+        }
+    }
+    picker->stats.pick_ms = bench_ms_since(start);
+    return found;
+}
+
+const MeshPickerStats *mesh_picker_stats(const MeshPicker *picker)
+{
+    return &picker->stats;
+}
+
+bool mesh_pick_ray(const Mat4 *view_proj, float x, float y, float origin[3], float dir[3])
+{
+    Mat4 inv;
+    if (!mat4_invert(&inv, view_proj))
+        return false;
+    /* Clip space has y up; the viewport's y runs down */
+    float ndc[2] = {x * 2.0f - 1.0f, 1.0f - y * 2.0f};
+    float points[2][3];
+    for (int k = 0; k < 2; k++)
+    {
+        float clip[4] = {ndc[0], ndc[1], (float)k, 1.0f};
+        float p[4];
+        for (int i = 0; i < 4; i++)
+            p[i] = inv.m[i] * clip[0] + inv.m[4 + i] * clip[1] + inv.m[8 + i] * clip[2] + inv.m[12 + i] * clip[3];
+        if (p[3] == 0.0f)
+            return false;
+        for (int i = 0; i < 3; i++)
+            points[k][i] = p[i] / p[3];
+    }
+    float length = 0.0f;
+    for (int i = 0; i < 3; i++)
+    {
+        dir[i] = points[1][i] - points[0][i];
+        length += dir[i] * dir[i];
+    }
+    length = SDL_sqrtf(length);
+    if (length == 0.0f)
+        return false;
+    for (int i = 0; i < 3; i++)
+    {
+        origin[i] = points[0][i];
+        dir[i] /= length;
+    }
+    return true;
+}
+
+/*================================================================================
+ * Benchmark — rolling terrain, rays from above at random slants
+ *================================================================================*/
+#define BENCH_RAYS 200000
+#define BENCH_CHECKED_RAYS 16
+
+static float bench_height(float x, float z)
+{
+    return SDL_sinf(x * 0.05f) * 8.0f + SDL_cosf(z * 0.043f) * 6.0f + SDL_sinf((x + z) * 0.31f) * 0.7f;
+}
+
+/* Every triangle, for reference */
+static bool brute_force_raycast(const AccessorStreams *positions, const Uint32 *indices, Uint32 triangles,
+                                const float origin[3], const float dir[3], MeshBvhHit *hit)
+{
+    Ray ray;
+    ray_init(&ray, origin, dir);
+    MeshBvh view = {.position = {positions->streams[0], positions->streams[1], positions->streams[2]},
+                    .indices = indices,
+                    .triangle_count = triangles};
+    bool found = false;
+    float best = BVH_HUGE;
+    for (Uint32 t = 0; t < triangles; t += 4)
+    {
+        Uint32 ids[4] = {t, t + 1, t + 2, t + 3};
+        TriangleLanes lanes;
+        gather_triangles(&view, ids, SDL_min(triangles - t, 4u), &lanes);
+        float tt[4], u[4], v[4];
+        int mask = intersect_triangles(&lanes, &ray, best, tt, u, v);
+        for (int l = 0; l < 4; l++)
+        {
+            if ((mask & (1 << l)) && tt[l] <= best)
+            {
+                best = tt[l];
+                *hit = (MeshBvhHit){tt[l], ids[l], u[l], v[l]};
+                found = true;
+            }
+        }
+    }
+    return found;
+}
+
+static void bench_ray(Uint64 *seed, float extent, float origin[3], float dir[3])
+{
+    float x = SDL_randf_r(seed) * extent, z = SDL_randf_r(seed) * extent;
+    origin[0] = x, origin[1] = 100.0f, origin[2] = z;
+    dir[0] = SDL_randf_r(seed) - 0.5f;
+    dir[1] = -1.0f;
+    dir[2] = SDL_randf_r(seed) - 0.5f;
+}
+
+void mesh_bvh_benchmark(Uint32 triangles)
+{
+    Uint32 side = (Uint32)SDL_sqrt((double)triangles / 2.0);
+    side = SDL_max(side, 1u);
+    Uint32 vertices = (side + 1) * (side + 1);
+    Uint32 count = side * side * 2;
+    const float spacing = 0.5f;
+
+    AccessorStreams positions;
+    SDL_zero(positions);
+    positions.count = vertices;
+    positions.num_components = 3;
+    positions.storage = SDL_malloc((size_t)vertices * 3 * sizeof(float));
+    Uint32 *indices = SDL_malloc((size_t)count * 3 * sizeof(Uint32));
+    MeshBvh *bvh = NULL;
+    if (!positions.storage || !indices)
+        goto done;
+    for (int a = 0; a < 3; a++)
+        positions.streams[a] = positions.storage + (size_t)a * vertices;
+    for (Uint32 z = 0; z <= side; z++)
+    {
+        for (Uint32 x = 0; x <= side; x++)
+        {
+            Uint32 v = z * (side + 1) + x;
+            positions.streams[0][v] = (float)x * spacing;
+            positions.streams[1][v] = bench_height((float)x * spacing, (float)z * spacing);
+            positions.streams[2][v] = (float)z * spacing;
+        }
+    }
+    /* Quads in row order, so the build has to sort them out */
+    Uint32 *idx = indices;
+    for (Uint32 z = 0; z < side; z++)
+    {
+        for (Uint32 x = 0; x < side; x++)
+        {
+            Uint32 v = z * (side + 1) + x;
+            *idx++ = v, *idx++ = v + side + 1, *idx++ = v + 1;
+            *idx++ = v + 1, *idx++ = v + side + 1, *idx++ = v + side + 2;
+        }
+    }
+
+    Uint64 start = bench_now();
+    bvh = mesh_bvh_build(&positions, indices, (size_t)count * 3);
+    double build_ms = bench_ms_since(start);
+    if (!bvh)
+    {
+        SDL_Log("Mesh BVH bench: out of memory for %u triangles", count);
+        goto done;
+    }
+
+    float extent = (float)side * spacing;
+    Uint64 seed = 7;
+    Uint32 hits = 0;
+    start = bench_now();
+    for (Uint32 r = 0; r < BENCH_RAYS; r++)
+    {
+        float origin[3], dir[3];
+        MeshBvhHit hit;
+        bench_ray(&seed, extent, origin, dir);
+        hits += mesh_bvh_raycast(bvh, origin, dir, BVH_HUGE, &hit);
+    }
+    double ray_ms = bench_ms_since(start);
+
+    Uint32 mismatches = 0;
+    double brute_ms = 0.0;
+    for (Uint32 r = 0; r < BENCH_CHECKED_RAYS; r++)
+    {
+        float origin[3], dir[3];
+        MeshBvhHit a = {0}, b = {0};
+        bench_ray(&seed, extent, origin, dir);
+        bool hit_a = mesh_bvh_raycast(bvh, origin, dir, BVH_HUGE, &a);
+        start = bench_now();
+        bool hit_b = brute_force_raycast(&positions, indices, count, origin, dir, &b);
+        brute_ms += bench_ms_since(start);
+        if (hit_a != hit_b || (hit_a && SDL_fabsf(a.t - b.t) > 1e-4f * b.t))
+            mismatches++;
+    }
+
+    SDL_Log("Mesh BVH bench (%u triangles, %zu nodes, %.1f MB): build %.0f ms on %d threads, %.2f M rays/s "
+            "(%.0f%% hit), brute force %.1f ms/ray, %u of %u checked rays differ",
+            count, mesh_bvh_node_count(bvh), mesh_bvh_bytes(bvh) / (1024.0 * 1024.0), build_ms,
+            parallel_worker_count() + 1, ray_ms > 0.0 ? BENCH_RAYS / ray_ms / 1000.0 : 0.0,
+            100.0 * hits / BENCH_RAYS, brute_ms / BENCH_CHECKED_RAYS, mismatches, BENCH_CHECKED_RAYS);
+    SDL_assert(mismatches == 0);
+
+done:
+    mesh_bvh_free(bvh);
+    accessor_streams_free(&positions);
+    SDL_free(indices);
+}
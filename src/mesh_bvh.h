@@ -0,0 +1,92 @@
+#ifndef CUMULUS_MESH_BVH_H
+#define CUMULUS_MESH_BVH_H
+
+#include "vecmath.h"
+#include <SDL3/SDL.h>
+
+struct AccessorStreams;
+struct Model;
+struct SceneBvh;
+struct SceneGraph;
+
+/* Triangle BVH of one primitive, for ray picking.
+
+   Built top-down with binned SAH: each split is the best of
+   MESH_BVH_BINS planes per axis by surface area, with triangles costed
+   in groups of four, the width they are tested at. Large nodes bin on
+   the worker pool and their two subtrees are built in parallel. Rays
+   visit the nearer child first and stop at boxes farther than the
+   closest hit; boxes and four triangles at a time are tested with SSE2
+   or NEON where available. */
+typedef struct MeshBvh MeshBvh;
+
+#define MESH_BVH_BINS 16
+#define MESH_BVH_LEAF_TRIANGLES 4 /* leaves hold more only past MESH_BVH_MAX_DEPTH */
+#define MESH_BVH_MAX_DEPTH 64
+
+typedef struct MeshBvhHit
+{
+    float t;         /* along the ray, in units of its direction */
+    Uint32 triangle; /* index / 3 into the primitive's indices */
+    float u, v;      /* barycentrics of the second and third vertex */
+} MeshBvhHit;
+
+/* Over `index_count / 3` triangles of `positions` (x, y, z streams).
+   Degenerate triangles are kept but never hit. */
+MeshBvh *mesh_bvh_build(const struct AccessorStreams *positions, const Uint32 *indices, size_t index_count);
+
+void mesh_bvh_free(MeshBvh *bvh);
+
+/* Closest hit with t in (0, max_t]. `dir` need not be normalized. */
+bool mesh_bvh_raycast(const MeshBvh *bvh, const float origin[3], const float dir[3], float max_t, MeshBvhHit *hit);
+
+size_t mesh_bvh_node_count(const MeshBvh *bvh);
+
+/* Nodes and triangle order, as allocated */
+size_t mesh_bvh_bytes(const MeshBvh *bvh);
+
+/* One BVH per primitive of a model, shared by every node drawing it */
+typedef struct MeshPicker MeshPicker;
+
+typedef struct MeshPick
+{
+    float t;
+    float position[3]; /* world space */
+    Uint32 node;       /* scene node */
+    Uint32 primitive;  /* index into Model.primitives */
+    Uint32 triangle;
+} MeshPick;
+
+typedef struct MeshPickerStats
+{
+    double build_ms;
+    Uint64 triangles;
+    size_t nodes;
+    size_t bytes; /* reserved in RESIDENCY_MODELS */
+    double pick_ms; /* the last raycast */
+} MeshPickerStats;
+
+/* Builds every primitive's BVH, the largest ones first, on the worker
+   pool. NULL when out of memory or over the models budget. */
+MeshPicker *mesh_picker_create(const struct Model *model);
+
+void mesh_picker_free(MeshPicker *picker);
+
+/* Closest triangle of the scene hit by a world-space ray. `bvh` supplies
+   the items' world bounds and `graph` their matrices, as of the last
+   scene_bvh_refit. */
+bool mesh_picker_raycast(MeshPicker *picker, const struct SceneBvh *bvh, const struct SceneGraph *graph,
+                         const float origin[3], const float dir[3], MeshPick *hit);
+
+const MeshPickerStats *mesh_picker_stats(const MeshPicker *picker);
+
+/* World-space ray through a point of the viewport, in 0..1 from its top
+   left corner, starting on the near plane. Returns false if view_proj is
+   singular. */
+bool mesh_pick_ray(const Mat4 *view_proj, float x, float y, float origin[3], float dir[3]);
+
+/* Builds a `triangles` terrain mesh, logs the build time and rays per
+   second, and checks a sample of rays against brute force */
+void mesh_bvh_benchmark(Uint32 triangles);
+
+#endif /* CUMULUS_MESH_BVH_H */
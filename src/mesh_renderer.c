@@ -0,0 +1,1472 @@
+#include "mesh_renderer.h"
+#include "asset_cache.h"
+#include "bench.h"
+#include "meshlet_stream.h"
+#include "model_import.h"
+#include "pipeline_cache.h"
+#include "residency.h"
+#include "scene_bvh.h"
+#include "scene_graph.h"
+
+#include <SDL3/SDL.h>
+#include <cgltf.h>
+
+#ifdef CUMULUS_HAVE_SPIRV
+#include "hiz_downsample_comp.spv.h"
+#include "mesh_cull_comp.spv.h"
+#include "mesh_frag.spv.h"
+#include "mesh_vert.spv.h"
+#endif
+
+#define HIZ_MAX_LEVELS 16
+#define READBACK_FRAMES 3
+#define CULL_GROUP_SIZE 64
+#define HIZ_GROUP_SIZE 8
+
+/* Layouts shared with shaders/mesh*.{vert,frag,comp} and the MSL below */
+typedef struct MeshVertex
+{
+    float position[3];
+    float normal[3];
+    float uv[2];
+} MeshVertex;
+
+SDL_COMPILE_TIME_ASSERT(meshlet_vertex, sizeof(MeshletVertex) == sizeof(MeshVertex));
+
+typedef struct GpuObject
+{
+    float world[16];
+    float bounds_min[4];
+    float bounds_max[4];
+    float color[4];
+} GpuObject;
+
+typedef struct CullParams
+{
+    float planes[6][4];
+    float prev_view_proj[16];
+    float hiz_size[2];
+    Uint32 object_count;
+    Uint32 hiz_levels;
+    Uint32 occlusion;
+    Uint32 pad[3];
+} CullParams;
+
+typedef struct HizParams
+{
+    Sint32 src_size[2];
+    Sint32 dst_size[2];
+} HizParams;
+
+typedef struct GpuCounters
+{
+    Uint32 emitted;
+    Uint32 frustum_culled;
+    Uint32 occlusion_culled;
+    Uint32 draws;
+} GpuCounters;
+
+#define GROUP_NONE 0xFFFFFFFFu
+
+struct MeshRenderer
+{
+    SDL_GPUDevice *device;
+    PipelineCache *pipelines; /* owns the shaders and pipelines below */
+    AssetCache *assets;       /* shares vertex/index buffers, may be NULL */
+    SDL_GPUShaderFormat shader_format;
+    SDL_GPUTextureFormat color_format;
+    SDL_GPUTextureFormat depth_format;
+
+    SDL_GPUGraphicsPipeline *pipeline;
+    SDL_GPUComputePipeline *cull_pipeline;
+    SDL_GPUComputePipeline *hiz_pipeline;
+    SDL_GPUComputePipeline *hiz_depth_pipeline; /* level 0 reads the depth buffer */
+    SDL_GPUSampler *point_sampler;
+
+    /* Model data. Objects are grouped by primitive, i.e. by mesh/material
+       pair; each group is drawn with one instanced draw whose instances
+       are the object ids written to its range of instance_buffer. */
+    Uint32 object_count;
+    Uint32 group_count;
+    SDL_GPUBuffer *vertex_buffer;
+    SDL_GPUBuffer *index_buffer;
+    SDL_GPUBuffer *instance_buffer; /* per-instance object ids, grouped */
+    SDL_GPUBuffer *object_buffer;
+    SDL_GPUBuffer *group_buffer;    /* per object group index, GROUP_NONE if not drawable */
+    SDL_GPUBuffer *command_reset;   /* per group command with zero instances */
+    SDL_GPUBuffer *command_buffer;
+    SDL_GPUBuffer *counter_buffer;
+    SDL_GPUTransferBuffer *object_upload;
+    SDL_GPUTransferBuffer *instance_upload;
+    SDL_GPUTransferBuffer *counter_reset;
+    SDL_GPUIndexedIndirectDrawCommand *groups; /* CPU copy of command_reset */
+    Uint32 *object_group;
+    Uint32 *group_fill; /* CPU mode scratch: per group instance count */
+    float *colors;
+    bool objects_dirty;
+
+    /* Streamed geometry instead: one object per material, drawn by the
+       stream's commands from its page pool */
+    MeshletStream *stream;
+
+    /* Readback ring for GPU cull counters, each slot mapped once its fence
+       signals */
+    SDL_GPUTransferBuffer *readback[READBACK_FRAMES];
+    SDL_GPUFence *readback_fence[READBACK_FRAMES]; /* borrowed from the app's submissions */
+    int readback_recorded; /* slot downloaded by the frame not yet submitted, or -1 */
+    Uint64 frame;
+
+    /* Depth buffer and the pyramid built from it */
+    SDL_GPUTexture *depth;
+    Uint32 depth_width;
+    Uint32 depth_height;
+    SDL_GPUTexture *hiz;
+    SDL_GPUTexture *hiz_levels[HIZ_MAX_LEVELS];
+    Uint32 hiz_level_count;
+    bool hiz_valid;
+    Mat4 hiz_view_proj;
+
+    /* Set by mesh_renderer_prepare for the upload and draw that follow */
+    const SceneGraph *frame_graph;
+    const SceneBvh *frame_bvh;
+    Uint32 frame_visible;
+    bool frame_gpu;
+    bool frame_stream;
+    bool frame_ready;
+
+    MeshCullMode mode;
+    MeshRenderStats stats;
+};
+
+/*================================================================================
+ * MSL Shaders — same interfaces as the GLSL in shaders/
+ *================================================================================*/
+#define MESH_MSL_TYPES                                                                                                 \
+    "#include <metal_stdlib>\n"                                                                                        \
+    "using namespace metal;\n"                                                                                         \
+    "struct Object { float4x4 world; float4 bounds_min; float4 bounds_max; float4 color; };\n"
+
+static const char *mesh_msl_vert = MESH_MSL_TYPES
+    "struct VertexIn {\n"
+    "    float3 position [[attribute(0)]];\n"
+    "    float3 normal [[attribute(1)]];\n"
+    "    float2 uv [[attribute(2)]];\n"
+    "    uint object [[attribute(3)]];\n"
+    "};\n"
+    "struct VertexOut {\n"
+    "    float4 position [[position]];\n"
+    "    float3 normal;\n"
+    "    float4 color;\n"
+    "};\n"
+    "struct Frame { float4x4 view_proj; };\n"
+    "vertex VertexOut main0(VertexIn in [[stage_in]], constant Frame &frame [[buffer(0)]],\n"
+    "                       const device Object *objects [[buffer(1)]]) {\n"
+    "    Object o = objects[in.object];\n"
+    "    VertexOut out;\n"
+    "    out.position = frame.view_proj * (o.world * float4(in.position, 1.0));\n"
+    "    out.normal = float3x3(o.world[0].xyz, o.world[1].xyz, o.world[2].xyz) * in.normal;\n"
+    "    out.color = o.color;\n"
+    "    return out;\n"
+    "}\n";
+
+static const char *mesh_msl_frag = "#include <metal_stdlib>\n"
+                                   "using namespace metal;\n"
+                                   "struct VertexOut {\n"
+                                   "    float4 position [[position]];\n"
+                                   "    float3 normal;\n"
+                                   "    float4 color;\n"
+                                   "};\n"
+                                   "fragment float4 main0(VertexOut in [[stage_in]]) {\n"
+                                   "    float len = length(in.normal);\n"
+                                   "    float light = 1.0;\n"
+                                   "    if (len > 1e-6)\n"
+                                   "        light = max(dot(in.normal / len, normalize(float3(0.4, 0.8, 0.3))), 0.0) "
+                                   "* 0.8 + 0.2;\n"
+                                   "    return float4(in.color.rgb * light, in.color.a);\n"
+                                   "}\n";
+
+static const char *mesh_msl_cull = MESH_MSL_TYPES
+    "struct DrawCommand { uint num_indices; atomic_uint num_instances; uint first_index; int vertex_offset;\n"
+    "                     uint first_instance; };\n"
+    "struct Counters { atomic_uint emitted; atomic_uint frustum_culled; atomic_uint occlusion_culled;\n"
+    "                  atomic_uint draws; };\n"
+    "struct CullParams { float4 planes[6]; float4x4 prev_view_proj; float2 hiz_size; uint object_count;\n"
+    "                    uint hiz_levels; uint occlusion; };\n"
+    "static bool frustum_visible(constant CullParams &p, float3 bmin, float3 bmax) {\n"
+    "    float3 c = (bmin + bmax) * 0.5, e = (bmax - bmin) * 0.5;\n"
+    "    for (int i = 0; i < 6; i++) {\n"
+    "        float dist = dot(p.planes[i].xyz, c) + p.planes[i].w;\n"
+    "        if (dist + dot(abs(p.planes[i].xyz), e) < 0.0) return false;\n"
+    "    }\n"
+    "    return true;\n"
+    "}\n"
+    "static bool occlusion_visible(constant CullParams &p, texture2d<float> hiz, float3 bmin, float3 bmax) {\n"
+    "    float2 uv_min = float2(1.0), uv_max = float2(0.0);\n"
+    "    float zmin = 1.0;\n"
+    "    for (int i = 0; i < 8; i++) {\n"
+    "        float3 c = float3((i & 1) ? bmax.x : bmin.x, (i & 2) ? bmax.y : bmin.y, (i & 4) ? bmax.z : bmin.z);\n"
+    "        float4 clip = p.prev_view_proj * float4(c, 1.0);\n"
+    "        if (clip.w <= 1e-5) return true;\n"
+    "        float3 ndc = clip.xyz / clip.w;\n"
+    "        float2 uv = float2(ndc.x * 0.5 + 0.5, 0.5 - ndc.y * 0.5);\n"
+    "        uv_min = min(uv_min, uv); uv_max = max(uv_max, uv); zmin = min(zmin, ndc.z);\n"
+    "    }\n"
+    "    uv_min = clamp(uv_min, 0.0, 1.0); uv_max = clamp(uv_max, 0.0, 1.0);\n"
+    "    int lod = 0; int2 p0, p1;\n"
+    "    for (;;) {\n"
+    "        float2 size = max(floor(p.hiz_size / float(1 << lod)), float2(1.0));\n"
+    "        p0 = int2(uv_min * size); p1 = min(int2(uv_max * size), int2(size) - 1);\n"
+    "        if ((p1.x - p0.x <= 1 && p1.y - p0.y <= 1) || lod + 1 >= int(p.hiz_levels)) break;\n"
+    "        lod++;\n"
+    "    }\n"
+    "    if (p1.x - p0.x > 1 || p1.y - p0.y > 1) return true;\n"
+    "    float zmax = max(max(hiz.read(uint2(p0), lod).r, hiz.read(uint2(p1.x, p0.y), lod).r),\n"
+    "                     max(hiz.read(uint2(p0.x, p1.y), lod).r, hiz.read(uint2(p1), lod).r));\n"
+    "    return zmin <= zmax;\n"
+    "}\n"
+    "kernel void main0(texture2d<float> hiz [[texture(0)]], sampler hiz_sampler [[sampler(0)]],\n"
+    "                  constant CullParams &params [[buffer(0)]], const device Object *objects [[buffer(1)]],\n"
+    "                  const device uint *groups [[buffer(2)]], device DrawCommand *commands [[buffer(3)]],\n"
+    "                  device uint *instances [[buffer(4)]], device Counters &counters [[buffer(5)]],\n"
+    "                  uint id [[thread_position_in_grid]]) {\n"
+    "    if (id >= params.object_count) return;\n"
+    "    uint group = groups[id];\n"
+    "    if (group == 0xFFFFFFFFu) return;\n"
+    "    Object o = objects[id];\n"
+    "    if (!frustum_visible(params, o.bounds_min.xyz, o.bounds_max.xyz)) {\n"
+    "        atomic_fetch_add_explicit(&counters.frustum_culled, 1u, memory_order_relaxed);\n"
+    "        return;\n"
+    "    }\n"
+    "    if (params.occlusion != 0 && !occlusion_visible(params, hiz, o.bounds_min.xyz, o.bounds_max.xyz)) {\n"
+    "        atomic_fetch_add_explicit(&counters.occlusion_culled, 1u, memory_order_relaxed);\n"
+    "        return;\n"
+    "    }\n"
+    "    uint slot = atomic_fetch_add_explicit(&commands[group].num_instances, 1u, memory_order_relaxed);\n"
+    "    if (slot == 0) atomic_fetch_add_explicit(&counters.draws, 1u, memory_order_relaxed);\n"
+    "    instances[commands[group].first_instance + slot] = id;\n"
+    "    atomic_fetch_add_explicit(&counters.emitted, 1u, memory_order_relaxed);\n"
+    "}\n";
+
+#define HIZ_MSL(SRC_TYPE)                                                                                              \
+    "#include <metal_stdlib>\n"                                                                                        \
+    "using namespace metal;\n"                                                                                         \
+    "struct Params { int2 src_size; int2 dst_size; };\n"                                                               \
+    "kernel void main0(" SRC_TYPE " src [[texture(0)]], sampler src_sampler [[sampler(0)]],\n"                         \
+    "                  texture2d<float, access::write> dst [[texture(1)]], constant Params &p [[buffer(0)]],\n"       \
+    "                  uint2 gid [[thread_position_in_grid]]) {\n"                                                     \
+    "    int2 q = int2(gid);\n"                                                                                        \
+    "    if (q.x >= p.dst_size.x || q.y >= p.dst_size.y) return;\n"                                                   \
+    "    int2 base = q * 2, last = p.src_size - 1;\n"                                                                  \
+    "    int nx = (q.x == p.dst_size.x - 1 && (p.src_size.x & 1) == 1) ? 3 : 2;\n"                                     \
+    "    int ny = (q.y == p.dst_size.y - 1 && (p.src_size.y & 1) == 1) ? 3 : 2;\n"                                     \
+    "    float depth = 0.0;\n"                                                                                         \
+    "    for (int y = 0; y < ny; y++)\n"                                                                               \
+    "        for (int x = 0; x < nx; x++)\n"                                                                           \
+    "            depth = max(depth, float(src.read(uint2(min(base + int2(x, y), last))).r));\n"                        \
+    "    dst.write(float4(depth), gid);\n"                                                                             \
+    "}\n"
+
+static const char *hiz_msl = HIZ_MSL("texture2d<float>");
+static const char *hiz_msl_depth = HIZ_MSL("depth2d<float>");
+
+/*================================================================================
+ * Setup
+ *================================================================================*/
+typedef struct ShaderSource
+{
+    const Uint8 *spirv;
+    size_t spirv_size;
+    const char *msl;
+} ShaderSource;
+
+#ifdef CUMULUS_HAVE_SPIRV
+#define SHADER_SOURCE(spv, msl) {spv, sizeof(spv), msl}
+#else
+#define SHADER_SOURCE(spv, msl) {NULL, 0, msl}
+#endif
+
+static void shader_code(const MeshRenderer *r, const ShaderSource *src, const Uint8 **code, size_t *size,
+                        const char **entry)
+{
+    if (r->shader_format == SDL_GPU_SHADERFORMAT_SPIRV)
+    {
+        *code = src->spirv;
+        *size = src->spirv_size;
+        *entry = "main";
+    }
+    else
+    {
+        *code = (const Uint8 *)src->msl;
+        *size = SDL_strlen(src->msl);
+        *entry = "main0";
+    }
+}
+
+static SDL_GPUShader *create_shader(MeshRenderer *r, const ShaderSource *src, SDL_GPUShaderStage stage,
+                                    Uint32 num_storage_buffers, Uint32 num_uniform_buffers)
+{
+    SDL_GPUShaderCreateInfo info;
+    SDL_zero(info);
+    shader_code(r, src, &info.code, &info.code_size, &info.entrypoint);
+    info.format = r->shader_format;
+    info.stage = stage;
+    info.num_storage_buffers = num_storage_buffers;
+    info.num_uniform_buffers = num_uniform_buffers;
+    SDL_GPUShader *shader = pipeline_cache_shader(r->pipelines, &info);
+    if (!shader)
+        SDL_Log("Mesh renderer: failed to create shader");
+    return shader;
+}
+
+static SDL_GPUComputePipeline *create_compute(MeshRenderer *r, const ShaderSource *src,
+                                              const SDL_GPUComputePipelineCreateInfo *layout)
+{
+    SDL_GPUComputePipelineCreateInfo info = *layout;
+    shader_code(r, src, &info.code, &info.code_size, &info.entrypoint);
+    info.format = r->shader_format;
+    SDL_GPUComputePipeline *pipeline = pipeline_cache_compute(r->pipelines, &info);
+    if (!pipeline)
+        SDL_Log("Mesh renderer: failed to create compute pipeline");
+    return pipeline;
+}
+
+static bool create_pipelines(MeshRenderer *r)
+{
+    const ShaderSource vert = SHADER_SOURCE(mesh_vert_spv, mesh_msl_vert);
+    const ShaderSource frag = SHADER_SOURCE(mesh_frag_spv, mesh_msl_frag);
+    const ShaderSource cull = SHADER_SOURCE(mesh_cull_comp_spv, mesh_msl_cull);
+    const ShaderSource hiz = SHADER_SOURCE(hiz_downsample_comp_spv, hiz_msl);
+    const ShaderSource hiz_depth = SHADER_SOURCE(hiz_downsample_comp_spv, hiz_msl_depth);
+
+    SDL_GPUShader *vs = create_shader(r, &vert, SDL_GPU_SHADERSTAGE_VERTEX, 1, 1);
+    SDL_GPUShader *fs = create_shader(r, &frag, SDL_GPU_SHADERSTAGE_FRAGMENT, 0, 0);
+    if (vs && fs)
+    {
+        SDL_GPUVertexBufferDescription buffers[2] = {
+            {.slot = 0, .pitch = sizeof(MeshVertex), .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX},
+            {.slot = 1, .pitch = sizeof(Uint32), .input_rate = SDL_GPU_VERTEXINPUTRATE_INSTANCE},
+        };
+        SDL_GPUVertexAttribute attributes[4] = {
+            {0, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, offsetof(MeshVertex, position)},
+            {1, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, offsetof(MeshVertex, normal)},
+            {2, 0, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2, offsetof(MeshVertex, uv)},
+            {3, 1, SDL_GPU_VERTEXELEMENTFORMAT_UINT, 0},
+        };
+        SDL_GPUColorTargetDescription color = {.format = r->color_format};
+
+        SDL_GPUGraphicsPipelineCreateInfo info;
+        SDL_zero(info);
+        info.vertex_shader = vs;
+        info.fragment_shader = fs;
+        info.vertex_input_state.vertex_buffer_descriptions = buffers;
+        info.vertex_input_state.num_vertex_buffers = 2;
+        info.vertex_input_state.vertex_attributes = attributes;
+        info.vertex_input_state.num_vertex_attributes = 4;
+        info.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
+        /* No face culling: glTF double-sided materials and mirrored nodes are common */
+        info.rasterizer_state.cull_mode = SDL_GPU_CULLMODE_NONE;
+        info.rasterizer_state.front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE;
+        info.depth_stencil_state.enable_depth_test = true;
+        info.depth_stencil_state.enable_depth_write = true;
+        info.depth_stencil_state.compare_op = SDL_GPU_COMPAREOP_LESS_OR_EQUAL;
+        info.target_info.color_target_descriptions = &color;
+        info.target_info.num_color_targets = 1;
+        info.target_info.depth_stencil_format = r->depth_format;
+        info.target_info.has_depth_stencil_target = true;
+        r->pipeline = pipeline_cache_graphics(r->pipelines, &info);
+        if (!r->pipeline)
+            SDL_Log("Mesh renderer: failed to create pipeline");
+    }
+
+    SDL_GPUComputePipelineCreateInfo cull_layout;
+    SDL_zero(cull_layout);
+    cull_layout.num_samplers = 1;
+    cull_layout.num_readonly_storage_buffers = 2;
+    cull_layout.num_readwrite_storage_buffers = 3;
+    cull_layout.num_uniform_buffers = 1;
+    cull_layout.threadcount_x = CULL_GROUP_SIZE;
+    cull_layout.threadcount_y = 1;
+    cull_layout.threadcount_z = 1;
+    r->cull_pipeline = create_compute(r, &cull, &cull_layout);
+
+    SDL_GPUComputePipelineCreateInfo hiz_layout;
+    SDL_zero(hiz_layout);
+    hiz_layout.num_samplers = 1;
+    hiz_layout.num_readwrite_storage_textures = 1;
+    hiz_layout.num_uniform_buffers = 1;
+    hiz_layout.threadcount_x = HIZ_GROUP_SIZE;
+    hiz_layout.threadcount_y = HIZ_GROUP_SIZE;
+    hiz_layout.threadcount_z = 1;
+    r->hiz_pipeline = create_compute(r, &hiz, &hiz_layout);
+    r->hiz_depth_pipeline = create_compute(r, &hiz_depth, &hiz_layout);
+
+    return r->pipeline && r->cull_pipeline && r->hiz_pipeline && r->hiz_depth_pipeline;
+}
+
+MeshRenderer *mesh_renderer_create(SDL_GPUDevice *device, PipelineCache *pipelines, AssetCache *assets,
+                                   SDL_GPUTextureFormat color_format)
+{
+    SDL_GPUShaderFormat formats = SDL_GetGPUShaderFormats(device);
+    SDL_GPUShaderFormat format = SDL_GPU_SHADERFORMAT_INVALID;
+#ifdef CUMULUS_HAVE_SPIRV
+    if (formats & SDL_GPU_SHADERFORMAT_SPIRV)
+        format = SDL_GPU_SHADERFORMAT_SPIRV;
+#endif
+    if (!format && (formats & SDL_GPU_SHADERFORMAT_MSL))
+        format = SDL_GPU_SHADERFORMAT_MSL;
+    if (!format)
+    {
+        SDL_Log("Mesh renderer: no shipped shader format for the %s driver", SDL_GetGPUDeviceDriver(device));
+        return NULL;
+    }
+
+    MeshRenderer *r = SDL_calloc(1, sizeof(MeshRenderer));
+    if (!r)
+        return NULL;
+    r->device = device;
+    r->pipelines = pipelines;
+    r->assets = assets;
+    r->shader_format = format;
+    r->readback_recorded = -1;
+    r->color_format = color_format;
+    r->mode = MESH_CULL_GPU;
+
+    const SDL_GPUTextureUsageFlags depth_usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER;
+    r->depth_format = SDL_GPUTextureSupportsFormat(device, SDL_GPU_TEXTUREFORMAT_D32_FLOAT, SDL_GPU_TEXTURETYPE_2D,
+                                                   depth_usage)
+                          ? SDL_GPU_TEXTUREFORMAT_D32_FLOAT
+                          : SDL_GPU_TEXTUREFORMAT_D24_UNORM;
+
+    SDL_GPUSamplerCreateInfo sampler;
+    SDL_zero(sampler);
+    sampler.min_filter = SDL_GPU_FILTER_NEAREST;
+    sampler.mag_filter = SDL_GPU_FILTER_NEAREST;
+    sampler.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST;
+    sampler.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+    sampler.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+    sampler.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+    sampler.max_lod = 1000.0f;
+    r->point_sampler = SDL_CreateGPUSampler(device, &sampler);
+
+    /* Counters are zeroed each frame from this never-written buffer */
+    SDL_GPUTransferBufferCreateInfo tb;
+    SDL_zero(tb);
+    tb.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+    tb.size = sizeof(GpuCounters);
+    r->counter_reset = residency_create_transfer_buffer(device, &tb, RESIDENCY_STAGING);
+    void *zero = r->counter_reset ? SDL_MapGPUTransferBuffer(device, r->counter_reset, false) : NULL;
+    if (zero)
+    {
+        SDL_memset(zero, 0, sizeof(GpuCounters));
+        SDL_UnmapGPUTransferBuffer(device, r->counter_reset);
+    }
+
+    tb.usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD;
+    for (int i = 0; i < READBACK_FRAMES; i++)
+        r->readback[i] = residency_create_transfer_buffer(device, &tb, RESIDENCY_STAGING);
+
+    if (!r->point_sampler || !zero || !create_pipelines(r))
+    {
+        mesh_renderer_destroy(r);
+        return NULL;
+    }
+
+    SDL_GPUBufferCreateInfo counters;
+    SDL_zero(counters);
+    counters.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE;
+    counters.size = sizeof(GpuCounters);
+    r->counter_buffer = residency_create_buffer(device, &counters, RESIDENCY_GEOMETRY);
+    if (!r->counter_buffer)
+    {
+        mesh_renderer_destroy(r);
+        return NULL;
+    }
+
+    SDL_Log("Mesh renderer: %s shaders", format == SDL_GPU_SHADERFORMAT_SPIRV ? "SPIR-V" : "MSL");
+    return r;
+}
+
+static void release_buffer(MeshRenderer *r, SDL_GPUBuffer **buffer)
+{
+    if (*buffer)
+        residency_release_buffer(r->device, *buffer);
+    *buffer = NULL;
+}
+
+static void release_geometry(MeshRenderer *r, SDL_GPUBuffer **buffer)
+{
+    if (r->assets)
+    {
+        asset_cache_release_buffer(r->assets, *buffer);
+        *buffer = NULL;
+    }
+    release_buffer(r, buffer);
+}
+
+static void release_targets(MeshRenderer *r)
+{
+    if (r->depth)
+        residency_release_texture(r->device, r->depth);
+    if (r->hiz)
+        residency_release_texture(r->device, r->hiz);
+    for (Uint32 i = 0; i < r->hiz_level_count; i++)
+        residency_release_texture(r->device, r->hiz_levels[i]);
+    r->depth = NULL;
+    r->hiz = NULL;
+    r->hiz_level_count = 0;
+    r->depth_width = r->depth_height = 0;
+    r->hiz_valid = false;
+}
+
+void mesh_renderer_clear(MeshRenderer *r)
+{
+    if (!r)
+        return;
+
+    release_geometry(r, &r->vertex_buffer);
+    release_geometry(r, &r->index_buffer);
+    release_buffer(r, &r->instance_buffer);
+    release_buffer(r, &r->object_buffer);
+    release_buffer(r, &r->group_buffer);
+    release_buffer(r, &r->command_reset);
+    release_buffer(r, &r->command_buffer);
+    if (r->object_upload)
+        residency_release_transfer_buffer(r->device, r->object_upload);
+    if (r->instance_upload)
+        residency_release_transfer_buffer(r->device, r->instance_upload);
+    r->object_upload = NULL;
+    r->instance_upload = NULL;
+    SDL_free(r->groups);
+    SDL_free(r->object_group);
+    SDL_free(r->group_fill);
+    SDL_free(r->colors);
+    r->groups = NULL;
+    r->object_group = NULL;
+    r->group_fill = NULL;
+    r->colors = NULL;
+    r->object_count = 0;
+    r->group_count = 0;
+    r->stream = NULL;
+    r->hiz_valid = false;
+    SDL_zero(r->stats);
+}
+
+void mesh_renderer_destroy(MeshRenderer *r)
+{
+    if (!r)
+        return;
+
+    mesh_renderer_clear(r);
+    release_targets(r);
+    release_buffer(r, &r->counter_buffer);
+    if (r->counter_reset)
+        residency_release_transfer_buffer(r->device, r->counter_reset);
+    for (int i = 0; i < READBACK_FRAMES; i++)
+    {
+        if (r->readback[i])
+            residency_release_transfer_buffer(r->device, r->readback[i]);
+    }
+    if (r->point_sampler)
+        SDL_ReleaseGPUSampler(r->device, r->point_sampler);
+    SDL_free(r);
+}
+
+void mesh_renderer_set_cull_mode(MeshRenderer *r, MeshCullMode mode)
+{
+    if (r && r->mode != mode)
+    {
+        r->mode = mode;
+        r->hiz_valid = false;
+    }
+}
+
+const MeshRenderStats *mesh_renderer_stats(const MeshRenderer *r)
+{
+    return &r->stats;
+}
+
+/*================================================================================
+ * Model upload
+ *================================================================================*/
+static SDL_GPUBuffer *create_buffer(MeshRenderer *r, SDL_GPUBufferUsageFlags usage, size_t size)
+{
+    SDL_GPUBufferCreateInfo info;
+    SDL_zero(info);
+    info.usage = usage;
+    info.size = (Uint32)(size ? size : 4);
+    SDL_GPUBuffer *buffer = residency_create_buffer(r->device, &info, RESIDENCY_GEOMETRY);
+    if (!buffer)
+        SDL_Log("Mesh renderer: failed to create %zu byte buffer: %s", size, SDL_GetError());
+    return buffer;
+}
+
+/* Geometry comes from the asset cache when it has the model's content
+   already; *upload says whether it still has to be sent */
+static SDL_GPUBuffer *create_geometry(MeshRenderer *r, const Model *model, SDL_GPUBufferUsageFlags usage, size_t size,
+                                      bool *upload)
+{
+    *upload = true;
+    if (!r->assets || !model->geometry_hash)
+        return create_buffer(r, usage, size);
+    Uint64 key = asset_hash(&usage, sizeof(usage), model->geometry_hash);
+    return asset_cache_acquire_buffer(r->assets, key, usage, (Uint32)(size ? size : 4), upload);
+}
+
+bool mesh_renderer_set_model(MeshRenderer *r, const Model *model, const SceneBvh *bvh)
+{
+    mesh_renderer_clear(r);
+    if (!model || !bvh)
+        return false;
+
+    /* Per-primitive placement in the shared buffers */
+    size_t prims = model->primitives_count;
+    Uint32 *first_index = SDL_calloc(prims + 1, sizeof(Uint32));
+    Sint32 *vertex_base = SDL_calloc(prims + 1, sizeof(Sint32));
+    Uint32 *primitive_group = SDL_malloc((prims + 1) * sizeof(Uint32));
+    if (!first_index || !vertex_base || !primitive_group)
+    {
+        SDL_free(first_index);
+        SDL_free(vertex_base);
+        SDL_free(primitive_group);
+        return false;
+    }
+
+    size_t vertex_count = 0, index_count = 0;
+    for (size_t p = 0; p < prims; p++)
+    {
+        const ModelPrimitive *prim = &model->primitives[p];
+        first_index[p] = (Uint32)index_count;
+        vertex_base[p] = (Sint32)vertex_count;
+        primitive_group[p] = GROUP_NONE;
+        if (prim->positions && prim->source->type == cgltf_primitive_type_triangles)
+        {
+            vertex_count += prim->positions->count;
+            index_count += prim->index_count;
+        }
+    }
+
+    /* Every drawable primitive some node uses becomes a group; all nodes
+       sharing its mesh are instances of the group's single draw. */
+    r->object_count = (Uint32)bvh->item_count;
+    r->object_group = SDL_malloc((r->object_count + 1) * sizeof(Uint32));
+    r->colors = SDL_malloc((r->object_count + 1) * 4 * sizeof(float));
+    if (!r->object_group || !r->colors)
+    {
+        SDL_free(first_index);
+        SDL_free(vertex_base);
+        SDL_free(primitive_group);
+        mesh_renderer_clear(r);
+        return false;
+    }
+    for (Uint32 i = 0; i < r->object_count; i++)
+    {
+        Uint32 p = bvh->item_primitive[i];
+        const ModelPrimitive *prim = &model->primitives[p];
+        bool drawable = prim->positions && prim->source->type == cgltf_primitive_type_triangles;
+        if (drawable && primitive_group[p] == GROUP_NONE)
+            primitive_group[p] = r->group_count++;
+        r->object_group[i] = drawable ? primitive_group[p] : GROUP_NONE;
+
+        const cgltf_material *mat = prim->source->material;
+        const float white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        SDL_memcpy(&r->colors[i * 4], mat ? mat->pbr_metallic_roughness.base_color_factor : white, 4 * sizeof(float));
+    }
+
+    /* Group commands with zero instances; each group owns a range of the
+       instance buffer as large as its object count */
+    r->groups = SDL_calloc(r->group_count + 1, sizeof(SDL_GPUIndexedIndirectDrawCommand));
+    r->group_fill = SDL_calloc(r->group_count * 2 + 1, sizeof(Uint32));
+    if (!r->groups || !r->group_fill)
+    {
+        SDL_free(first_index);
+        SDL_free(vertex_base);
+        SDL_free(primitive_group);
+        mesh_renderer_clear(r);
+        return false;
+    }
+    for (size_t p = 0; p < prims; p++)
+    {
+        Uint32 g = primitive_group[p];
+        if (g == GROUP_NONE)
+            continue;
+        r->groups[g].num_indices = (Uint32)model->primitives[p].index_count;
+        r->groups[g].first_index = first_index[p];
+        r->groups[g].vertex_offset = vertex_base[p];
+    }
+    for (Uint32 i = 0; i < r->object_count; i++)
+    {
+        if (r->object_group[i] != GROUP_NONE)
+            r->group_fill[r->object_group[i]]++;
+    }
+    Uint32 instance_base = 0;
+    for (Uint32 g = 0; g < r->group_count; g++)
+    {
+        r->groups[g].first_instance = instance_base;
+        instance_base += r->group_fill[g];
+    }
+    SDL_free(primitive_group);
+
+    size_t vertex_bytes = vertex_count * sizeof(MeshVertex);
+    size_t index_bytes = index_count * sizeof(Uint32);
+    size_t id_bytes = r->object_count * sizeof(Uint32);
+    size_t command_bytes = r->group_count * sizeof(SDL_GPUIndexedIndirectDrawCommand);
+    size_t object_bytes = r->object_count * sizeof(GpuObject);
+
+    const SDL_GPUBufferUsageFlags storage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ;
+    bool upload_vertices, upload_indices;
+    r->vertex_buffer = create_geometry(r, model, SDL_GPU_BUFFERUSAGE_VERTEX, vertex_bytes, &upload_vertices);
+    r->index_buffer = create_geometry(r, model, SDL_GPU_BUFFERUSAGE_INDEX, index_bytes, &upload_indices);
+    size_t vertex_upload = upload_vertices ? vertex_bytes : 0;
+    size_t index_upload = upload_indices ? index_bytes : 0;
+    size_t upload_bytes = vertex_upload + index_upload + id_bytes + command_bytes;
+    r->instance_buffer = create_buffer(r, SDL_GPU_BUFFERUSAGE_VERTEX | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE, id_bytes);
+    r->group_buffer = create_buffer(r, SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ, id_bytes);
+    r->object_buffer = create_buffer(r, storage, object_bytes);
+    r->command_reset = create_buffer(r, SDL_GPU_BUFFERUSAGE_INDIRECT, command_bytes);
+    r->command_buffer = create_buffer(r,
+                                      SDL_GPU_BUFFERUSAGE_INDIRECT | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ |
+                                          SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE,
+                                      command_bytes);
+
+    SDL_GPUTransferBufferCreateInfo tb;
+    SDL_zero(tb);
+    tb.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+    tb.size = (Uint32)(object_bytes ? object_bytes : 4);
+    r->object_upload = residency_create_transfer_buffer(r->device, &tb, RESIDENCY_STAGING);
+    tb.size = (Uint32)(id_bytes ? id_bytes : 4);
+    r->instance_upload = residency_create_transfer_buffer(r->device, &tb, RESIDENCY_STAGING);
+    tb.size = (Uint32)(upload_bytes ? upload_bytes : 4);
+    SDL_GPUTransferBuffer *staging = residency_create_transfer_buffer(r->device, &tb, RESIDENCY_STAGING);
+
+    Uint8 *map = staging ? SDL_MapGPUTransferBuffer(r->device, staging, false) : NULL;
+    if (!r->vertex_buffer || !r->index_buffer || !r->instance_buffer || !r->group_buffer || !r->object_buffer ||
+        !r->command_reset || !r->command_buffer || !r->object_upload || !r->instance_upload || !map)
+    {
+        if (staging)
+            residency_release_transfer_buffer(r->device, staging);
+        SDL_free(first_index);
+        SDL_free(vertex_base);
+        mesh_renderer_clear(r);
+        return false;
+    }
+
+    /* Interleave the SoA streams straight into the staging memory */
+    MeshVertex *vertices = (MeshVertex *)map;
+    Uint32 *indices = (Uint32 *)(map + vertex_upload);
+    for (size_t p = 0; p < prims; p++)
+    {
+        const ModelPrimitive *prim = &model->primitives[p];
+        if (!prim->positions || prim->source->type != cgltf_primitive_type_triangles)
+            continue;
+
+        if (index_upload)
+            SDL_memcpy(indices + first_index[p], prim->indices, prim->index_count * sizeof(Uint32));
+        if (!vertex_upload)
+            continue;
+        MeshVertex *v = vertices + vertex_base[p];
+        for (size_t i = 0; i < prim->positions->count; i++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                v[i].position[c] = prim->positions->streams[c][i];
+                v[i].normal[c] = prim->normals ? prim->normals->streams[c][i] : 0.0f;
+            }
+            v[i].uv[0] = prim->texcoords ? prim->texcoords->streams[0][i] : 0.0f;
+            v[i].uv[1] = prim->texcoords ? prim->texcoords->streams[1][i] : 0.0f;
+        }
+    }
+    SDL_memcpy(map + vertex_upload + index_upload, r->object_group, id_bytes);
+    SDL_memcpy(map + vertex_upload + index_upload + id_bytes, r->groups, command_bytes);
+    SDL_UnmapGPUTransferBuffer(r->device, staging);
+    SDL_free(first_index);
+    SDL_free(vertex_base);
+
+    SDL_GPUCommandBuffer *cmd = SDL_AcquireGPUCommandBuffer(r->device);
+    if (!cmd)
+    {
+        residency_release_transfer_buffer(r->device, staging);
+        mesh_renderer_clear(r);
+        return false;
+    }
+    SDL_GPUCopyPass *cp = SDL_BeginGPUCopyPass(cmd);
+    struct
+    {
+        SDL_GPUBuffer *buffer;
+        size_t size;
+    } regions[4] = {{r->vertex_buffer, vertex_upload},
+                    {r->index_buffer, index_upload},
+                    {r->group_buffer, id_bytes},
+                    {r->command_reset, command_bytes}};
+    Uint32 offset = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        if (regions[i].size == 0)
+            continue;
+        SDL_GPUTransferBufferLocation src = {staging, offset};
+        SDL_GPUBufferRegion dst = {regions[i].buffer, 0, (Uint32)regions[i].size};
+        SDL_UploadToGPUBuffer(cp, &src, &dst, false);
+        offset += (Uint32)regions[i].size;
+    }
+    SDL_EndGPUCopyPass(cp);
+    SDL_SubmitGPUCommandBuffer(cmd);
+    residency_release_transfer_buffer(r->device, staging);
+    if (r->assets)
+    {
+        asset_cache_buffer_ready(r->assets, r->vertex_buffer);
+        asset_cache_buffer_ready(r->assets, r->index_buffer);
+    }
+
+    r->objects_dirty = true;
+    r->stats.objects = r->object_count;
+    r->stats.groups = r->group_count;
+    SDL_Log("  mesh renderer: %zu vertices, %zu indices, %u objects in %u instanced groups (%.1f MB, geometry %s)",
+            vertex_count, index_count, r->object_count, r->group_count,
+            (double)(upload_bytes + object_bytes) / (1024.0 * 1024.0),
+            vertex_upload || index_upload ? "uploaded" : "shared");
+    return true;
+}
+
+bool mesh_renderer_set_stream(MeshRenderer *r, MeshletStream *stream)
+{
+    mesh_renderer_clear(r);
+    if (!stream)
+        return false;
+
+    /* Commands carry the material as first_instance, which indexes an id
+       buffer of 0..n-1 into identity objects with the material's color */
+    Uint32 count;
+    const float *colors = meshlet_stream_materials(stream, &count);
+    static const float white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    if (count == 0)
+    {
+        /* Material 0 is the default and every command may use it */
+        colors = white;
+        count = 1;
+    }
+    size_t id_bytes = count * sizeof(Uint32);
+    size_t object_bytes = count * sizeof(GpuObject);
+    r->instance_buffer = create_buffer(r, SDL_GPU_BUFFERUSAGE_VERTEX, id_bytes);
+    r->object_buffer = create_buffer(r, SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ, object_bytes);
+
+    SDL_GPUTransferBufferCreateInfo tb;
+    SDL_zero(tb);
+    tb.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+    tb.size = (Uint32)(id_bytes + object_bytes);
+    SDL_GPUTransferBuffer *staging = residency_create_transfer_buffer(r->device, &tb, RESIDENCY_STAGING);
+    Uint8 *map = staging ? SDL_MapGPUTransferBuffer(r->device, staging, false) : NULL;
+    SDL_GPUCommandBuffer *cmd = map ? SDL_AcquireGPUCommandBuffer(r->device) : NULL;
+    if (!r->instance_buffer || !r->object_buffer || !cmd)
+    {
+        if (map)
+            SDL_UnmapGPUTransferBuffer(r->device, staging);
+        if (staging)
+            residency_release_transfer_buffer(r->device, staging);
+        mesh_renderer_clear(r);
+        return false;
+    }
+
+    Uint32 *ids = (Uint32 *)map;
+    GpuObject *objects = (GpuObject *)(map + id_bytes);
+    for (Uint32 i = 0; i < count; i++)
+    {
+        ids[i] = i;
+        SDL_zero(objects[i]);
+        objects[i].world[0] = objects[i].world[5] = objects[i].world[10] = objects[i].world[15] = 1.0f;
+        SDL_memcpy(objects[i].color, &colors[i * 4], sizeof(objects[i].color));
+    }
+    SDL_UnmapGPUTransferBuffer(r->device, staging);
+
+    SDL_GPUCopyPass *cp = SDL_BeginGPUCopyPass(cmd);
+    SDL_GPUTransferBufferLocation src = {staging, 0};
+    SDL_GPUBufferRegion dst = {r->instance_buffer, 0, (Uint32)id_bytes};
+    SDL_UploadToGPUBuffer(cp, &src, &dst, false);
+    src.offset = (Uint32)id_bytes;
+    dst = (SDL_GPUBufferRegion){r->object_buffer, 0, (Uint32)object_bytes};
+    SDL_UploadToGPUBuffer(cp, &src, &dst, false);
+    SDL_EndGPUCopyPass(cp);
+    SDL_SubmitGPUCommandBuffer(cmd);
+    residency_release_transfer_buffer(r->device, staging);
+
+    r->stream = stream;
+    return true;
+}
+
+/*================================================================================
+ * Per-frame
+ *================================================================================*/
+static bool ensure_targets(MeshRenderer *r, Uint32 width, Uint32 height)
+{
+    if (r->depth && r->depth_width == width && r->depth_height == height)
+        return true;
+    release_targets(r);
+
+    SDL_GPUTextureCreateInfo info;
+    SDL_zero(info);
+    info.type = SDL_GPU_TEXTURETYPE_2D;
+    info.format = r->depth_format;
+    info.usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER;
+    info.width = width;
+    info.height = height;
+    info.layer_count_or_depth = 1;
+    info.num_levels = 1;
+    r->depth = residency_create_texture(r->device, &info, RESIDENCY_TARGETS);
+    if (!r->depth)
+    {
+        SDL_Log("Mesh renderer: failed to create depth buffer: %s", SDL_GetError());
+        return false;
+    }
+    r->depth_width = width;
+    r->depth_height = height;
+
+    /* Pyramid level 0 is half resolution; levels are separate storage
+       textures, copied into one mipmapped texture for the cull pass */
+    Uint32 w = SDL_max(width / 2, 1), h = SDL_max(height / 2, 1);
+    Uint32 levels = 1;
+    while ((w >> levels) > 0 || (h >> levels) > 0)
+        levels++;
+    levels = SDL_min(levels, HIZ_MAX_LEVELS);
+
+    info.format = SDL_GPU_TEXTUREFORMAT_R32_FLOAT;
+    info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+    info.width = w;
+    info.height = h;
+    info.num_levels = levels;
+    r->hiz = residency_create_texture(r->device, &info, RESIDENCY_TARGETS);
+
+    info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE;
+    info.num_levels = 1;
+    for (Uint32 i = 0; i < levels && r->hiz; i++)
+    {
+        info.width = SDL_max(w >> i, 1);
+        info.height = SDL_max(h >> i, 1);
+        r->hiz_levels[i] = residency_create_texture(r->device, &info, RESIDENCY_TARGETS);
+        if (!r->hiz_levels[i])
+            break;
+        r->hiz_level_count++;
+    }
+    if (!r->hiz || r->hiz_level_count != levels)
+    {
+        SDL_Log("Mesh renderer: failed to create depth pyramid: %s", SDL_GetError());
+        release_targets(r);
+        return false;
+    }
+    return true;
+}
+
+/* Counters of the newest frame the GPU has finished; older ones are
+   dropped with it and unfinished ones wait for a later frame */
+static void read_counters(MeshRenderer *r)
+{
+    for (Uint64 back = 1; back <= READBACK_FRAMES && back <= r->frame; back++)
+    {
+        int slot = (int)((r->frame - back) % READBACK_FRAMES);
+        if (!r->readback_fence[slot] || !SDL_QueryGPUFence(r->device, r->readback_fence[slot]))
+            continue;
+
+        const GpuCounters *c = SDL_MapGPUTransferBuffer(r->device, r->readback[slot], false);
+        if (c)
+        {
+            r->stats.instances = c->emitted;
+            r->stats.draws_emitted = c->draws;
+            r->stats.frustum_culled = c->frustum_culled;
+            r->stats.occlusion_culled = c->occlusion_culled;
+            SDL_UnmapGPUTransferBuffer(r->device, r->readback[slot]);
+        }
+        for (; back <= READBACK_FRAMES && back <= r->frame; back++)
+            r->readback_fence[(r->frame - back) % READBACK_FRAMES] = NULL;
+        return;
+    }
+}
+
+/* First item at or after scene node `node`; items are sorted by node */
+static Uint32 first_item_of(const SceneBvh *bvh, Uint32 node)
+{
+    size_t lo = 0, hi = bvh->item_count;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (bvh->item_node[mid] < node)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (Uint32)lo;
+}
+
+/* Next run of items under the subtrees the last graph update changed. A
+   subtree is one contiguous item range; adjacent ranges are merged. */
+static bool next_changed_range(const SceneGraph *graph, const SceneBvh *bvh, size_t *cursor, Uint32 *begin,
+                               Uint32 *end)
+{
+    bool found = false;
+    while (*cursor < graph->changed_count)
+    {
+        Uint32 root = graph->changed[*cursor];
+        Uint32 b = first_item_of(bvh, root);
+        Uint32 e = first_item_of(bvh, graph->subtree_end[root]);
+        if (found && b != *end && b != e)
+            break;
+        (*cursor)++;
+        if (b == e)
+            continue;
+        if (!found)
+            *begin = b;
+        *end = e;
+        found = true;
+    }
+    return found;
+}
+
+static void write_objects(const MeshRenderer *r, GpuObject *objects, const SceneGraph *graph, const SceneBvh *bvh,
+                          Uint32 begin, Uint32 end)
+{
+    for (Uint32 i = begin; i < end; i++)
+    {
+        GpuObject *o = &objects[i];
+        const float *b = &bvh->item_world[i * 6];
+        SDL_memcpy(o->world, graph->world[bvh->item_node[i]].m, sizeof(o->world));
+        o->bounds_min[0] = b[0], o->bounds_min[1] = b[1], o->bounds_min[2] = b[2], o->bounds_min[3] = 0.0f;
+        o->bounds_max[0] = b[3], o->bounds_max[1] = b[4], o->bounds_max[2] = b[5], o->bounds_max[3] = 0.0f;
+        SDL_memcpy(o->color, &r->colors[i * 4], sizeof(o->color));
+    }
+}
+
+/* Re-send the transforms of objects whose nodes moved. Partial uploads do
+   not cycle the object buffer, so untouched objects keep their data. */
+static void upload_objects(MeshRenderer *r, SDL_GPUCopyPass *cp, const SceneGraph *graph, const SceneBvh *bvh)
+{
+    bool all = r->objects_dirty || graph->all_changed;
+    GpuObject *objects = SDL_MapGPUTransferBuffer(r->device, r->object_upload, true);
+    if (!objects)
+        return;
+
+    Uint32 begin = 0, end = r->object_count, uploaded = 0;
+    size_t cursor = 0;
+    if (all)
+        write_objects(r, objects, graph, bvh, 0, r->object_count);
+    else
+    {
+        while (next_changed_range(graph, bvh, &cursor, &begin, &end))
+            write_objects(r, objects, graph, bvh, begin, end);
+    }
+    SDL_UnmapGPUTransferBuffer(r->device, r->object_upload);
+
+    if (all)
+    {
+        SDL_GPUTransferBufferLocation src = {r->object_upload, 0};
+        SDL_GPUBufferRegion dst = {r->object_buffer, 0, r->object_count * (Uint32)sizeof(GpuObject)};
+        SDL_UploadToGPUBuffer(cp, &src, &dst, true);
+        uploaded = r->object_count;
+    }
+    else
+    {
+        cursor = 0;
+        while (next_changed_range(graph, bvh, &cursor, &begin, &end))
+        {
+            SDL_GPUTransferBufferLocation src = {r->object_upload, begin * (Uint32)sizeof(GpuObject)};
+            SDL_GPUBufferRegion dst = {r->object_buffer, begin * (Uint32)sizeof(GpuObject),
+                                       (end - begin) * (Uint32)sizeof(GpuObject)};
+            SDL_UploadToGPUBuffer(cp, &src, &dst, false);
+            uploaded += end - begin;
+        }
+    }
+    r->stats.objects_uploaded = uploaded;
+}
+
+/* Counting sort of the visible objects by group: ids receives the object
+   ids grouped, first/counts each group's range. Returns the visible count. */
+static Uint32 group_visible(const Uint32 *object_group, const Uint8 *visible, Uint32 object_count, Uint32 group_count,
+                            Uint32 *first, Uint32 *counts, Uint32 *ids)
+{
+    SDL_memset(counts, 0, group_count * sizeof(Uint32));
+    for (Uint32 i = 0; i < object_count; i++)
+    {
+        if (visible[i] && object_group[i] != GROUP_NONE)
+            counts[object_group[i]]++;
+    }
+    Uint32 total = 0;
+    for (Uint32 g = 0; g < group_count; g++)
+    {
+        first[g] = total;
+        total += counts[g];
+        counts[g] = 0;
+    }
+    for (Uint32 i = 0; i < object_count; i++)
+    {
+        Uint32 g = object_group[i];
+        if (visible[i] && g != GROUP_NONE)
+            ids[first[g] + counts[g]++] = i;
+    }
+    return total;
+}
+
+static void dispatch_cull(MeshRenderer *r, SDL_GPUCommandBuffer *cmd, const Mat4 *view_proj)
+{
+    CullParams params;
+    SDL_zero(params);
+    mat4_frustum_planes(view_proj, params.planes);
+    SDL_memcpy(params.prev_view_proj, r->hiz_view_proj.m, sizeof(params.prev_view_proj));
+    params.hiz_size[0] = (float)SDL_max(r->depth_width / 2, 1);
+    params.hiz_size[1] = (float)SDL_max(r->depth_height / 2, 1);
+    params.object_count = r->object_count;
+    params.hiz_levels = r->hiz_level_count;
+    params.occlusion = r->hiz_valid ? 1 : 0;
+
+    /* Commands were just reset by a copy, so they must not cycle here */
+    SDL_GPUStorageBufferReadWriteBinding rw[3] = {{.buffer = r->command_buffer, .cycle = false},
+                                                  {.buffer = r->instance_buffer, .cycle = true},
+                                                  {.buffer = r->counter_buffer, .cycle = false}};
+    SDL_GPUComputePass *pass = SDL_BeginGPUComputePass(cmd, NULL, 0, rw, 3);
+    SDL_BindGPUComputePipeline(pass, r->cull_pipeline);
+    SDL_GPUTextureSamplerBinding hiz = {r->hiz, r->point_sampler};
+    SDL_BindGPUComputeSamplers(pass, 0, &hiz, 1);
+    SDL_GPUBuffer *ro[2] = {r->object_buffer, r->group_buffer};
+    SDL_BindGPUComputeStorageBuffers(pass, 0, ro, 2);
+    SDL_PushGPUComputeUniformData(cmd, 0, &params, sizeof(params));
+    SDL_DispatchGPUCompute(pass, (r->object_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+    SDL_EndGPUComputePass(pass);
+}
+
+static void build_hiz(MeshRenderer *r, SDL_GPUCommandBuffer *cmd)
+{
+    Uint32 src_w = r->depth_width, src_h = r->depth_height;
+    for (Uint32 level = 0; level < r->hiz_level_count; level++)
+    {
+        Uint32 dst_w = SDL_max((r->depth_width / 2) >> level, 1);
+        Uint32 dst_h = SDL_max((r->depth_height / 2) >> level, 1);
+        HizParams params = {{(Sint32)src_w, (Sint32)src_h}, {(Sint32)dst_w, (Sint32)dst_h}};
+
+        SDL_GPUStorageTextureReadWriteBinding dst = {.texture = r->hiz_levels[level]};
+        SDL_GPUComputePass *pass = SDL_BeginGPUComputePass(cmd, &dst, 1, NULL, 0);
+        SDL_BindGPUComputePipeline(pass, level == 0 ? r->hiz_depth_pipeline : r->hiz_pipeline);
+        SDL_GPUTextureSamplerBinding src = {level == 0 ? r->depth : r->hiz_levels[level - 1], r->point_sampler};
+        SDL_BindGPUComputeSamplers(pass, 0, &src, 1);
+        SDL_PushGPUComputeUniformData(cmd, 0, &params, sizeof(params));
+        SDL_DispatchGPUCompute(pass, (dst_w + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE,
+                               (dst_h + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+        SDL_EndGPUComputePass(pass);
+
+        src_w = dst_w;
+        src_h = dst_h;
+    }
+}
+
+bool mesh_renderer_prepare(MeshRenderer *r, Uint32 width, Uint32 height, const SceneGraph *graph, const SceneBvh *bvh)
+{
+    if (r)
+        r->frame_ready = false;
+    if (r && r->stream)
+    {
+        /* The stream culled and built its commands in its own update */
+        r->frame_gpu = false;
+        r->frame_stream = true;
+        r->frame_ready = ensure_targets(r, width, height);
+        return r->frame_ready;
+    }
+    if (!r || r->object_count == 0 || !graph || !bvh || bvh->item_count != r->object_count)
+        return false;
+    if (!ensure_targets(r, width, height))
+        return false;
+
+    Uint64 start = bench_now();
+    r->frame_gpu = r->mode == MESH_CULL_GPU;
+    r->frame_stream = false;
+    r->frame_graph = graph;
+    r->frame_bvh = bvh;
+    read_counters(r);
+
+    /* CPU mode: group the BVH's visible objects into instance ranges */
+    Uint32 *first = r->group_fill, *counts = r->group_fill + r->group_count;
+    r->frame_visible = 0;
+    Uint32 *ids = r->frame_gpu ? NULL : SDL_MapGPUTransferBuffer(r->device, r->instance_upload, true);
+    if (ids)
+    {
+        r->frame_visible =
+            group_visible(r->object_group, bvh->visible, r->object_count, r->group_count, first, counts, ids);
+        SDL_UnmapGPUTransferBuffer(r->device, r->instance_upload);
+    }
+    r->frame_ready = true;
+    r->stats.cpu_ms = bench_ms_since(start);
+    return true;
+}
+
+void mesh_renderer_upload(MeshRenderer *r, SDL_GPUCopyPass *cp)
+{
+    if (!r || !r->frame_ready)
+        return;
+
+    /* Moved objects, then either the grouped ids or a reset of the group
+       commands and counters for the cull pass to fill */
+    Uint64 start = bench_now();
+    if (r->frame_stream)
+    {
+        meshlet_stream_upload(r->stream, cp);
+        r->stats.cpu_ms = bench_ms_since(start);
+        return;
+    }
+    const SceneGraph *graph = r->frame_graph;
+    r->stats.objects_uploaded = 0;
+    if (r->objects_dirty || graph->all_changed || graph->changed_count > 0)
+        upload_objects(r, cp, graph, r->frame_bvh);
+    r->objects_dirty = false;
+    if (r->frame_gpu)
+    {
+        SDL_GPUBufferLocation src = {r->command_reset, 0};
+        SDL_GPUBufferLocation dst = {r->command_buffer, 0};
+        SDL_CopyGPUBufferToBuffer(cp, &src, &dst, r->group_count * (Uint32)sizeof(SDL_GPUIndexedIndirectDrawCommand),
+                                  true);
+        SDL_GPUTransferBufferLocation zero = {r->counter_reset, 0};
+        SDL_GPUBufferRegion counters = {r->counter_buffer, 0, sizeof(GpuCounters)};
+        SDL_UploadToGPUBuffer(cp, &zero, &counters, false);
+    }
+    else if (r->frame_visible > 0)
+    {
+        SDL_GPUTransferBufferLocation src = {r->instance_upload, 0};
+        SDL_GPUBufferRegion dst = {r->instance_buffer, 0, r->frame_visible * (Uint32)sizeof(Uint32)};
+        SDL_UploadToGPUBuffer(cp, &src, &dst, true);
+    }
+    r->stats.cpu_ms += bench_ms_since(start);
+}
+
+void mesh_renderer_draw(MeshRenderer *r, SDL_GPUCommandBuffer *cmd, SDL_GPUTexture *target, const float clear_color[4],
+                        const Mat4 *view_proj)
+{
+    if (!r || !r->frame_ready)
+        return;
+
+    Uint64 start = bench_now();
+    bool gpu = r->frame_gpu;
+    Uint32 visible = r->frame_visible;
+    const Uint32 *first = r->group_fill, *counts = r->group_fill + r->group_count;
+    r->frame_ready = false;
+
+    if (gpu)
+        dispatch_cull(r, cmd, view_proj);
+
+    SDL_GPUColorTargetInfo color;
+    SDL_zero(color);
+    color.texture = target;
+    color.load_op = SDL_GPU_LOADOP_CLEAR;
+    color.store_op = SDL_GPU_STOREOP_STORE;
+    color.clear_color = (SDL_FColor){clear_color[0], clear_color[1], clear_color[2], clear_color[3]};
+
+    SDL_GPUDepthStencilTargetInfo depth;
+    SDL_zero(depth);
+    depth.texture = r->depth;
+    depth.clear_depth = 1.0f;
+    depth.load_op = SDL_GPU_LOADOP_CLEAR;
+    depth.store_op = gpu ? SDL_GPU_STOREOP_STORE : SDL_GPU_STOREOP_DONT_CARE;
+    depth.stencil_load_op = SDL_GPU_LOADOP_DONT_CARE;
+    depth.stencil_store_op = SDL_GPU_STOREOP_DONT_CARE;
+    depth.cycle = true;
+
+    SDL_GPURenderPass *pass = SDL_BeginGPURenderPass(cmd, &color, 1, &depth);
+    SDL_BindGPUGraphicsPipeline(pass, r->pipeline);
+    SDL_GPUBuffer *vertices = r->vertex_buffer, *indices = r->index_buffer, *commands = NULL;
+    Uint32 command_count = 0;
+    if (r->frame_stream)
+        meshlet_stream_draw_buffers(r->stream, &vertices, &indices, &commands, &command_count);
+    SDL_GPUBufferBinding vb[2] = {{vertices, 0}, {r->instance_buffer, 0}};
+    SDL_BindGPUVertexBuffers(pass, 0, vb, 2);
+    SDL_GPUBufferBinding ib = {indices, 0};
+    SDL_BindGPUIndexBuffer(pass, &ib, SDL_GPU_INDEXELEMENTSIZE_32BIT);
+    SDL_BindGPUVertexStorageBuffers(pass, 0, &r->object_buffer, 1);
+    SDL_PushGPUVertexUniformData(cmd, 0, view_proj->m, sizeof(Mat4));
+
+    if (r->frame_stream)
+    {
+        MeshletStreamStats ms;
+        meshlet_stream_stats(r->stream, &ms);
+        if (command_count > 0)
+            SDL_DrawGPUIndexedPrimitivesIndirect(pass, commands, 0, command_count);
+        r->stats.draw_calls = command_count > 0;
+        r->stats.draws_submitted = command_count;
+        r->stats.draws_emitted = command_count;
+        r->stats.instances = command_count;
+        r->stats.frustum_culled = ms.clusters - ms.visible;
+        r->stats.occlusion_culled = 0;
+    }
+    else if (gpu)
+    {
+        SDL_DrawGPUIndexedPrimitivesIndirect(pass, r->command_buffer, 0, r->group_count);
+        r->stats.draw_calls = 1;
+        r->stats.draws_submitted = r->group_count;
+    }
+    else
+    {
+        Uint32 calls = 0;
+        for (Uint32 g = 0; g < r->group_count; g++)
+        {
+            if (counts[g] == 0)
+                continue;
+            const SDL_GPUIndexedIndirectDrawCommand *c = &r->groups[g];
+            SDL_DrawGPUIndexedPrimitives(pass, c->num_indices, counts[g], c->first_index, c->vertex_offset, first[g]);
+            calls++;
+        }
+        r->stats.draw_calls = calls;
+        r->stats.draws_submitted = calls;
+        r->stats.draws_emitted = calls;
+        r->stats.instances = visible;
+        r->stats.frustum_culled = r->object_count - visible;
+        r->stats.occlusion_culled = 0;
+    }
+    SDL_EndGPURenderPass(pass);
+
+    if (gpu)
+    {
+        /* Pyramid for next frame's occlusion test, plus the counter readback */
+        build_hiz(r, cmd);
+        SDL_GPUCopyPass *cp = SDL_BeginGPUCopyPass(cmd);
+        for (Uint32 level = 0; level < r->hiz_level_count; level++)
+        {
+            SDL_GPUTextureLocation src = {.texture = r->hiz_levels[level]};
+            SDL_GPUTextureLocation dst = {.texture = r->hiz, .mip_level = level};
+            SDL_CopyGPUTextureToTexture(cp, &src, &dst, SDL_max((r->depth_width / 2) >> level, 1),
+                                        SDL_max((r->depth_height / 2) >> level, 1), 1, false);
+        }
+        int slot = (int)(r->frame % READBACK_FRAMES);
+        r->readback_fence[slot] = NULL; /* never read in time; overwritten */
+        SDL_GPUBufferRegion counters = {r->counter_buffer, 0, sizeof(GpuCounters)};
+        SDL_GPUTransferBufferLocation readback = {r->readback[slot], 0};
+        SDL_DownloadFromGPUBuffer(cp, &counters, &readback);
+        SDL_EndGPUCopyPass(cp);
+        r->readback_recorded = slot;
+
+        r->hiz_valid = true;
+        r->hiz_view_proj = *view_proj;
+    }
+
+    r->frame++;
+    r->stats.cpu_ms += bench_ms_since(start);
+}
+
+void mesh_renderer_submitted(MeshRenderer *r, SDL_GPUFence *fence)
+{
+    if (!r)
+        return;
+    if (r->readback_recorded < 0)
+    {
+        /* No readback this frame, so the older fences would outlive the
+           submissions they were lent for */
+        SDL_zeroa(r->readback_fence);
+        return;
+    }
+    r->readback_fence[r->readback_recorded] = fence;
+    r->readback_recorded = -1;
+}
+
+/*================================================================================
+ * Benchmark
+ *================================================================================*/
+void mesh_renderer_benchmark(void)
+{
+    /* Four tree species of two primitives each (trunk, canopy) */
+    const int grid = 200;
+    const float spacing = 6.0f;
+    const Uint32 species = 4;
+    const size_t trees = (size_t)grid * grid;
+    const size_t count = trees + 1;
+    const size_t items = trees * 2;
+    const Uint32 group_count = species * 2;
+
+    Sint32 *parent = SDL_malloc(count * sizeof(Sint32));
+    Uint32 *item_node = SDL_malloc(items * sizeof(Uint32));
+    Uint32 *item_prim = SDL_malloc(items * sizeof(Uint32));
+    float *bounds = SDL_malloc(items * 6 * sizeof(float));
+    Uint32 *ids = SDL_malloc(items * sizeof(Uint32));
+    Uint32 first[8], counts[8];
+    SceneGraph *graph = NULL;
+    SceneBvh *bvh = NULL;
+    if (!parent || !item_node || !item_prim || !bounds || !ids)
+        goto done;
+
+    parent[0] = -1;
+    for (size_t i = 1; i < count; i++)
+        parent[i] = 0;
+    graph = scene_graph_create(count, parent);
+    if (!graph)
+        goto done;
+
+    Uint64 seed = 7;
+    for (size_t i = 0; i < trees; i++)
+    {
+        float t[3] = {((float)(i % grid) - grid * 0.5f) * spacing + (float)SDL_rand_r(&seed, 100) * 0.02f, 0.0f,
+                      ((float)(i / grid) - grid * 0.5f) * spacing + (float)SDL_rand_r(&seed, 100) * 0.02f};
+        float h = 0.8f + (float)SDL_rand_r(&seed, 40) * 0.01f;
+        float s[3] = {h, h, h};
+        scene_graph_set_trs(graph, (Uint32)(i + 1), t, NULL, s);
+
+        Uint32 kind = (Uint32)SDL_rand_r(&seed, (Sint32)species);
+        for (int part = 0; part < 2; part++)
+        {
+            size_t k = i * 2 + part;
+            item_node[k] = (Uint32)(i + 1);
+            item_prim[k] = kind * 2 + (Uint32)part;
+            float *b = &bounds[k * 6];
+            b[0] = part ? -2.0f : -0.3f, b[1] = part ? 3.0f : 0.0f, b[2] = b[0];
+            b[3] = -b[0], b[4] = part ? 9.0f : 4.0f, b[5] = -b[0];
+        }
+    }
+    scene_graph_update(graph);
+
+    bvh = scene_bvh_create(graph, items, item_node, item_prim, bounds);
+    if (!bvh)
+        goto done;
+
+    Mat4 proj, view, vp;
+    mat4_perspective(&proj, 60.0f * SDL_PI_F / 180.0f, 16.0f / 9.0f, 0.5f, 600.0f);
+
+    const int frames = 120;
+    size_t visible = 0, draws = 0, uploaded = 0;
+    double group_ms = 0.0;
+    size_t movers = trees / 100;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        /* 1% of trees sway each frame */
+        for (size_t k = 0; k < movers; k++)
+        {
+            Uint32 node = 1 + (Uint32)SDL_rand_r(&seed, (Sint32)trees);
+            float lean = 0.02f * SDL_sinf((float)(frame + node));
+            float r[4] = {SDL_sinf(lean), 0.0f, 0.0f, SDL_cosf(lean)};
+            scene_graph_set_trs(graph, node, NULL, r, NULL);
+        }
+        scene_graph_update(graph);
+        scene_bvh_refit(bvh, graph);
+
+        size_t cursor = 0;
+        Uint32 begin, end;
+        while (next_changed_range(graph, bvh, &cursor, &begin, &end))
+            uploaded += end - begin;
+
+        float yaw = (float)frame * (2.0f * SDL_PI_F / frames);
+        float eye[3] = {0.0f, 3.0f, 0.0f};
+        float target[3] = {SDL_cosf(yaw), 2.5f, SDL_sinf(yaw)};
+        float up[3] = {0.0f, 1.0f, 0.0f};
+        mat4_look_at(&view, eye, target, up);
+        mat4_mul(&vp, &proj, &view);
+        scene_bvh_cull(bvh, &vp);
+
+        Uint64 start = bench_now();
+        visible += group_visible(item_prim, bvh->visible, (Uint32)items, group_count, first, counts, ids);
+        group_ms += bench_ms_since(start);
+        for (Uint32 g = 0; g < group_count; g++)
+            draws += counts[g] > 0;
+    }
+
+    double per_object = (double)visible / frames;
+    double instanced = (double)draws / frames;
+    SDL_Log("Instancing bench (%zu trees, %u mesh/material pairs): %.0f draws per object vs %.1f instanced "
+            "(%.2f%% saved), grouping %.3f ms, %.0f of %zu transforms re-sent per frame",
+            trees, group_count, per_object, instanced,
+            per_object > 0.0 ? 100.0 * (1.0 - instanced / per_object) : 0.0, group_ms / frames,
+            (double)uploaded / frames, items);
+
+done:
+    scene_bvh_free(bvh);
+    scene_graph_free(graph);
+    SDL_free(parent);
+    SDL_free(item_node);
+    SDL_free(item_prim);
+    SDL_free(bounds);
+    SDL_free(ids);
+}
@@ -0,0 +1,91 @@
+#ifndef CUMULUS_MESH_RENDERER_H
+#define CUMULUS_MESH_RENDERER_H
+
+#include "vecmath.h"
+#include <SDL3/SDL.h>
+
+struct AssetCache;
+struct MeshletStream;
+struct Model;
+struct PipelineCache;
+struct SceneBvh;
+struct SceneGraph;
+
+/* Draws a model's primitives from one shared vertex/index buffer. Every
+   BVH item becomes an object in a GPU storage buffer, and objects sharing
+   a primitive (a mesh/material pair) are drawn as instances of one draw.
+   In CPU mode the BVH cull result is grouped into instance ranges and
+   each non-empty group is one draw call; in GPU mode a compute pass culls
+   against the frustum and last frame's depth pyramid and fills the
+   groups' indirect commands, so the CPU records a single indirect draw
+   whatever the object count. */
+typedef struct MeshRenderer MeshRenderer;
+
+typedef enum MeshCullMode
+{
+    MESH_CULL_CPU,
+    MESH_CULL_GPU
+} MeshCullMode;
+
+typedef struct MeshRenderStats
+{
+    Uint32 objects;
+    Uint32 groups;           /* mesh/material pairs, one instanced draw each */
+    Uint32 draw_calls;       /* draw API calls recorded this frame */
+    Uint32 draws_submitted;  /* draw commands handed to the GPU this frame */
+    Uint32 draws_emitted;    /* commands with at least one instance; GPU mode reads back two frames late */
+    Uint32 instances;        /* visible objects, same latency */
+    Uint32 frustum_culled;   /* same latency */
+    Uint32 occlusion_culled; /* GPU mode, same latency */
+    Uint32 objects_uploaded; /* transforms re-sent this frame */
+    double cpu_ms;           /* prepare, upload and draw together */
+} MeshRenderStats;
+
+/* Shaders and pipelines come from (and stay owned by) `pipelines`. Vertex
+   and index buffers are shared through `assets` when it is not NULL, so a
+   model seen before is not uploaded again. Returns NULL if the device
+   offers no shader format we ship. */
+MeshRenderer *mesh_renderer_create(SDL_GPUDevice *device, struct PipelineCache *pipelines, struct AssetCache *assets,
+                                   SDL_GPUTextureFormat color_format);
+void mesh_renderer_destroy(MeshRenderer *renderer);
+
+/* Upload geometry for `model` and one object per item of `bvh` (submits its
+   own command buffer). Replaces any previous model. */
+bool mesh_renderer_set_model(MeshRenderer *renderer, const struct Model *model, const struct SceneBvh *bvh);
+void mesh_renderer_clear(MeshRenderer *renderer);
+
+/* Draw a meshlet stream instead of a model, with one indirect draw of the
+   commands its last update built. The stream stays owned by the caller
+   and must outlive the renderer's use of it; clear to let go of it. */
+bool mesh_renderer_set_stream(MeshRenderer *renderer, struct MeshletStream *stream);
+
+void mesh_renderer_set_cull_mode(MeshRenderer *renderer, MeshCullMode mode);
+
+/* Start a frame: size the depth targets and, in CPU mode, group the BVH's
+   visible objects into instance ranges. Returns false when no model or
+   stream is loaded; upload and draw then record nothing. graph and bvh
+   are ignored for a stream. */
+bool mesh_renderer_prepare(MeshRenderer *renderer, Uint32 width, Uint32 height, const struct SceneGraph *graph,
+                           const struct SceneBvh *bvh);
+
+/* Record moved transforms and this frame's instance or command reset
+   uploads into a copy pass, which may be shared with other uploads */
+void mesh_renderer_upload(MeshRenderer *renderer, SDL_GPUCopyPass *copy_pass);
+
+/* Record culling and the mesh pass into cmd_buf, clearing `target` first.
+   Must follow the copy pass holding mesh_renderer_upload. */
+void mesh_renderer_draw(MeshRenderer *renderer, SDL_GPUCommandBuffer *cmd_buf, SDL_GPUTexture *target,
+                        const float clear_color[4], const Mat4 *view_proj);
+
+/* Call once the command buffer given to mesh_renderer_draw is submitted,
+   with the fence of that submission: a later prepare maps the GPU cull
+   counters only once it has signaled. The fence stays the caller's and
+   must remain valid for the next three submissions. */
+void mesh_renderer_submitted(MeshRenderer *renderer, SDL_GPUFence *fence);
+
+const MeshRenderStats *mesh_renderer_stats(const MeshRenderer *renderer);
+
+/* Log draws saved by instancing on a synthetic forest (CPU side only) */
+void mesh_renderer_benchmark(void);
+
+#endif /* CUMULUS_MESH_RENDERER_H */
@@ -0,0 +1,2023 @@
+#include "meshlet_stream.h"
+#include "accessor_unpack.h"
+#include "bench.h"
+#include "gltf_meshopt.h"
+#include "parallel.h"
+#include "residency.h"
+
+#include <SDL3/SDL.h>
+#include <cgltf.h>
+#include <meshoptimizer.h>
+
+#define MESHLET_FILE_MAGIC 0x544C4D43u /* "CMLT" */
+#define MESHLET_FILE_ALIGN 4096
+#define MESHLET_MAX_READS 8
+#define MESHLET_CONE_WEIGHT 0.25f
+#define MESHLET_LOD_MAX_ERROR 0.1f /* relative to the group's size */
+#define MESHLET_FALLBACK_STEP (1.0f / 4096.0f)
+#define SLOT_NONE 0xFFFFFFFFu
+#define LEVEL_NONE 0xFF
+#define NORMAL_NONE (-32768)
+
+/* File layout, little-endian: this header, the packed pages from
+   pages_offset, then the page table, the cluster table, the group table
+   and the material colors */
+typedef struct MeshletFileHeader
+{
+    Uint32 magic;
+    Uint32 version;
+    Uint32 page_vertices;
+    Uint32 page_indices;
+    Uint32 page_count;
+    Uint32 cluster_count;
+    Uint32 group_count;
+    Uint32 material_count;
+    Uint32 max_page_clusters;
+    float position_step; /* lattice spacing of packed positions, a power of two */
+    float bounds_min[3];
+    float bounds_max[3];
+    Uint64 pages_offset;
+    Uint64 tables_offset;
+} MeshletFileHeader;
+
+/* Unpacked, a page holds MESHLET_PAGE_VERTICES vertices, then
+   MESHLET_PAGE_INDICES indices relative to their cluster's first vertex */
+typedef struct MeshletPage
+{
+    float center[3];
+    float radius;
+    Uint32 first_cluster;
+    Uint32 cluster_count;
+    Uint64 offset; /* of the packed page in the file */
+    Uint32 size;
+    Uint32 reserved;
+} MeshletPage;
+
+typedef struct MeshletCluster
+{
+    float center[3];
+    float radius;
+    float cone_axis[3];
+    float cone_cutoff;    /* cosine of the normal cone's half angle; 1 never culls */
+    Uint16 vertex_offset; /* within the page */
+    Uint16 index_offset;
+    Uint8 vertex_count;
+    Uint8 triangle_count;
+    Uint16 material;
+    Uint32 group;
+    Uint8 lod;
+    Uint8 reserved[3];
+} MeshletCluster;
+
+typedef struct MeshletGroup
+{
+    float center[3];
+    float radius; /* around every level's clusters */
+    Uint32 lod_count;
+    float lod_error[MESHLET_MAX_LODS]; /* how far each level moved the surface; 0 at full detail */
+} MeshletGroup;
+
+/* A page on disk: this header, vertex_count UVs as floats, positions as
+   16-bit offsets from origin on the file's lattice (32-bit when wide),
+   octahedral normals as two snorm16, then index_count 8-bit indices */
+typedef struct MeshletPackedPage
+{
+    Sint32 origin[3];
+    Uint32 vertex_count;
+    Uint32 index_count;
+    Uint32 wide;
+} MeshletPackedPage;
+
+#define MESHLET_PACKED_MAX_BYTES                                                                                      \
+    (sizeof(MeshletPackedPage) +                                                                                       \
+     MESHLET_PAGE_VERTICES * (2 * sizeof(float) + 3 * sizeof(Uint32) + 2 * sizeof(Sint16)) + MESHLET_PAGE_INDICES)
+
+static MeshletVertex *page_vertex_data(Uint8 *page)
+{
+    return (MeshletVertex *)page;
+}
+
+static Uint32 *page_index_data(Uint8 *page)
+{
+    return (Uint32 *)(page + MESHLET_PAGE_VERTICES * sizeof(MeshletVertex));
+}
+
+static bool grow(void **items, Uint32 *capacity, Uint32 count, size_t size)
+{
+    if (count < *capacity)
+        return true;
+    Uint32 next = *capacity ? *capacity * 2 : 256;
+    void *grown = SDL_realloc(*items, next * size);
+    if (!grown)
+        return false;
+    *items = grown;
+    *capacity = next;
+    return true;
+}
+
+static bool read_at(SDL_IOStream *io, Uint64 offset, void *dst, size_t size)
+{
+    return SDL_SeekIO(io, (Sint64)offset, SDL_IO_SEEK_SET) >= 0 && SDL_ReadIO(io, dst, size) == size;
+}
+
+/* Smallest sphere around the spheres' bounding box */
+static void enclose_spheres(const MeshletCluster *clusters, Uint32 count, float center[3], float *radius)
+{
+    float lo[3] = {1e30f, 1e30f, 1e30f}, hi[3] = {-1e30f, -1e30f, -1e30f};
+    for (Uint32 i = 0; i < count; i++)
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            lo[a] = SDL_min(lo[a], clusters[i].center[a] - clusters[i].radius);
+            hi[a] = SDL_max(hi[a], clusters[i].center[a] + clusters[i].radius);
+        }
+    }
+    for (int a = 0; a < 3; a++)
+        center[a] = (lo[a] + hi[a]) * 0.5f;
+    *radius = 0.0f;
+    for (Uint32 i = 0; i < count; i++)
+    {
+        const float *c = clusters[i].center;
+        float d[3] = {c[0] - center[0], c[1] - center[1], c[2] - center[2]};
+        *radius = SDL_max(*radius, SDL_sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) + clusters[i].radius);
+    }
+}
+
+/*================================================================================
+ * Page packing
+ *================================================================================*/
+
+/* A power of two with 2^20 steps across the bounds, coarsened until every
+   coordinate is within 2^30 steps of the origin. All pages share it, so a
+   vertex on the border of two pages lands on the same point in both. */
+static float position_step(const float min[3], const float max[3])
+{
+    float extent = 0.0f, reach = 0.0f;
+    for (int a = 0; a < 3; a++)
+    {
+        extent = SDL_max(extent, max[a] - min[a]);
+        reach = SDL_max(reach, SDL_max(SDL_fabsf(min[a]), SDL_fabsf(max[a])));
+    }
+    float wanted = SDL_max(extent / 1048576.0f, reach / 1073741824.0f);
+    if (!(wanted > 0.0f) || wanted > 1e30f)
+        return MESHLET_FALLBACK_STEP;
+    float step = 1.0f;
+    while (step < wanted)
+        step *= 2.0f;
+    while (step * 0.5f >= wanted)
+        step *= 0.5f;
+    return step;
+}
+
+static Sint32 lattice(float x, float step)
+{
+    double q = SDL_round((double)x / step);
+    return (Sint32)SDL_clamp(q, -2147483647.0, 2147483647.0);
+}
+
+static size_t packed_size(Uint32 vertex_count, Uint32 index_count, bool wide)
+{
+    size_t position = wide ? sizeof(Uint32) : sizeof(Uint16);
+    return sizeof(MeshletPackedPage) + vertex_count * (2 * sizeof(float) + 3 * position + 2 * sizeof(Sint16)) +
+           index_count;
+}
+
+static void oct_encode(const float n[3], Sint16 out[2])
+{
+    float l1 = SDL_fabsf(n[0]) + SDL_fabsf(n[1]) + SDL_fabsf(n[2]);
+    if (l1 == 0.0f)
+    {
+        out[0] = out[1] = NORMAL_NONE;
+        return;
+    }
+    float u = n[0] / l1, v = n[1] / l1;
+    if (n[2] < 0.0f)
+    {
+        float fu = (1.0f - SDL_fabsf(v)) * (u < 0.0f ? -1.0f : 1.0f);
+        v = (1.0f - SDL_fabsf(u)) * (v < 0.0f ? -1.0f : 1.0f);
+        u = fu;
+    }
+    out[0] = (Sint16)SDL_lroundf(SDL_clamp(u, -1.0f, 1.0f) * 32767.0f);
+    out[1] = (Sint16)SDL_lroundf(SDL_clamp(v, -1.0f, 1.0f) * 32767.0f);
+}
+
+static void oct_decode(const Sint16 in[2], float n[3])
+{
+    if (in[0] == NORMAL_NONE && in[1] == NORMAL_NONE)
+    {
+        n[0] = n[1] = n[2] = 0.0f;
+        return;
+    }
+    float u = in[0] / 32767.0f, v = in[1] / 32767.0f;
+    float z = 1.0f - SDL_fabsf(u) - SDL_fabsf(v);
+    if (z < 0.0f)
+    {
+        float fu = (1.0f - SDL_fabsf(v)) * (u < 0.0f ? -1.0f : 1.0f);
+        v = (1.0f - SDL_fabsf(u)) * (v < 0.0f ? -1.0f : 1.0f);
+        u = fu;
+    }
+    float inv = 1.0f / SDL_sqrtf(u * u + v * v + z * z);
+    n[0] = u * inv;
+    n[1] = v * inv;
+    n[2] = z * inv;
+}
+
+/* Pack the first vertex_count vertices and index_count indices of an
+   unpacked page into `out`, which holds MESHLET_PACKED_MAX_BYTES */
+static size_t pack_page(Uint8 *page, Uint32 vertex_count, Uint32 index_count, float step, Uint8 *out)
+{
+    const MeshletVertex *vertices = page_vertex_data(page);
+    const Uint32 *indices = page_index_data(page);
+    Sint32 lo[3] = {SDL_MAX_SINT32, SDL_MAX_SINT32, SDL_MAX_SINT32};
+    Sint32 hi[3] = {SDL_MIN_SINT32, SDL_MIN_SINT32, SDL_MIN_SINT32};
+    for (Uint32 i = 0; i < vertex_count; i++)
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            Sint32 q = lattice(vertices[i].position[a], step);
+            lo[a] = SDL_min(lo[a], q);
+            hi[a] = SDL_max(hi[a], q);
+        }
+    }
+
+    MeshletPackedPage header;
+    SDL_zero(header);
+    for (int a = 0; a < 3; a++)
+    {
+        header.origin[a] = vertex_count ? lo[a] : 0;
+        header.wide |= vertex_count && (Sint64)hi[a] - lo[a] > 0xFFFF;
+    }
+    header.vertex_count = vertex_count;
+    header.index_count = index_count;
+    SDL_memcpy(out, &header, sizeof(header));
+
+    float *uv = (float *)(out + sizeof(header));
+    Uint8 *positions = (Uint8 *)(uv + 2 * vertex_count);
+    Sint16 *normals = (Sint16 *)(positions + vertex_count * 3 * (header.wide ? sizeof(Uint32) : sizeof(Uint16)));
+    Uint8 *idx = (Uint8 *)(normals + 2 * vertex_count);
+    for (Uint32 i = 0; i < vertex_count; i++)
+    {
+        uv[i * 2 + 0] = vertices[i].uv[0];
+        uv[i * 2 + 1] = vertices[i].uv[1];
+        for (int a = 0; a < 3; a++)
+        {
+            Uint32 offset = (Uint32)((Sint64)lattice(vertices[i].position[a], step) - header.origin[a]);
+            if (header.wide)
+                ((Uint32 *)positions)[i * 3 + a] = offset;
+            else
+                ((Uint16 *)positions)[i * 3 + a] = (Uint16)offset;
+        }
+        oct_encode(vertices[i].normal, &normals[i * 2]);
+    }
+    for (Uint32 i = 0; i < index_count; i++)
+        idx[i] = (Uint8)indices[i];
+    return packed_size(vertex_count, index_count, header.wide != 0);
+}
+
+static bool unpack_page(const Uint8 *packed, size_t size, float step, Uint8 *page)
+{
+    MeshletPackedPage header;
+    if (size < sizeof(header))
+        return false;
+    SDL_memcpy(&header, packed, sizeof(header));
+    if (header.vertex_count > MESHLET_PAGE_VERTICES || header.index_count > MESHLET_PAGE_INDICES ||
+        size != packed_size(header.vertex_count, header.index_count, header.wide != 0))
+        return false;
+
+    MeshletVertex *vertices = page_vertex_data(page);
+    Uint32 *indices = page_index_data(page);
+    const float *uv = (const float *)(packed + sizeof(header));
+    const Uint8 *positions = (const Uint8 *)(uv + 2 * header.vertex_count);
+    const Sint16 *normals =
+        (const Sint16 *)(positions + header.vertex_count * 3 * (header.wide ? sizeof(Uint32) : sizeof(Uint16)));
+    const Uint8 *idx = (const Uint8 *)(normals + 2 * header.vertex_count);
+    for (Uint32 i = 0; i < header.vertex_count; i++)
+    {
+        vertices[i].uv[0] = uv[i * 2 + 0];
+        vertices[i].uv[1] = uv[i * 2 + 1];
+        for (int a = 0; a < 3; a++)
+        {
+            Uint32 offset =
+                header.wide ? ((const Uint32 *)positions)[i * 3 + a] : ((const Uint16 *)positions)[i * 3 + a];
+            /* Integer first: the same lattice point decodes to the same float in every page */
+            vertices[i].position[a] = (float)(Sint32)((Uint32)header.origin[a] + offset) * step;
+        }
+        oct_decode(&normals[i * 2], vertices[i].normal);
+    }
+    for (Uint32 i = 0; i < header.index_count; i++)
+        indices[i] = idx[i];
+    SDL_memset(indices + header.index_count, 0, (MESHLET_PAGE_INDICES - header.index_count) * sizeof(Uint32));
+    return true;
+}
+
+/*================================================================================
+ * Cooking
+ *================================================================================*/
+
+/* Clusters wait here until their page is written. Each level fills a page
+   of its own, so a page holds a single level and none is read for
+   clusters the view does not draw. */
+typedef struct OpenPage
+{
+    Uint8 *data; /* unpacked */
+    Uint32 vertices;
+    Uint32 indices;
+    MeshletCluster *clusters; /* room for one triangle each */
+    Uint32 cluster_count;
+} OpenPage;
+
+typedef struct Cooker
+{
+    SDL_IOStream *io;
+    float step;
+    OpenPage open[MESHLET_MAX_LODS];
+    Uint8 *packed;     /* the page being written */
+    Uint64 page_bytes; /* packed pages written */
+    MeshletPage *pages;
+    Uint32 page_count, page_capacity;
+    MeshletCluster *clusters;
+    Uint32 cluster_count, cluster_capacity;
+    MeshletGroup *groups;
+    Uint32 group_count, group_capacity;
+    Uint32 max_page_clusters;
+    const float *materials;
+    Uint32 material_count;
+    float bounds_min[3], bounds_max[3];
+    Uint64 triangles;
+    Uint64 lod_triangles;
+    Uint64 file_bytes;
+} Cooker;
+
+static void cooker_free(Cooker *c)
+{
+    for (int l = 0; l < MESHLET_MAX_LODS; l++)
+    {
+        SDL_free(c->open[l].data);
+        SDL_free(c->open[l].clusters);
+    }
+    SDL_free(c->packed);
+    SDL_free(c->pages);
+    SDL_free(c->clusters);
+    SDL_free(c->groups);
+}
+
+static bool cooker_begin(Cooker *c, const char *path, const float *materials, Uint32 material_count, float step)
+{
+    SDL_zerop(c);
+    c->step = step;
+    c->materials = materials;
+    c->material_count = material_count;
+    for (int a = 0; a < 3; a++)
+    {
+        c->bounds_min[a] = 1e30f;
+        c->bounds_max[a] = -1e30f;
+    }
+    bool ok = true;
+    for (int l = 0; l < MESHLET_MAX_LODS; l++)
+    {
+        c->open[l].data = SDL_calloc(1, MESHLET_PAGE_BYTES);
+        c->open[l].clusters = SDL_malloc(MESHLET_PAGE_INDICES / 3 * sizeof(MeshletCluster));
+        ok = ok && c->open[l].data && c->open[l].clusters;
+    }
+    c->packed = SDL_malloc(MESHLET_PACKED_MAX_BYTES);
+    c->io = ok && c->packed ? SDL_IOFromFile(path, "wb") : NULL;
+    /* The header is written last; pages start at the next boundary */
+    if (!c->io || SDL_WriteIO(c->io, c->open[0].data, MESHLET_FILE_ALIGN) != MESHLET_FILE_ALIGN)
+    {
+        SDL_Log("Meshlets: cannot write '%s': %s", path, SDL_GetError());
+        if (c->io)
+            SDL_CloseIO(c->io);
+        cooker_free(c);
+        return false;
+    }
+    return true;
+}
+
+static bool flush_page(Cooker *c, OpenPage *open)
+{
+    Uint32 count = open->cluster_count;
+    if (count == 0)
+        return true;
+    if (!grow((void **)&c->pages, &c->page_capacity, c->page_count, sizeof(MeshletPage)))
+        return false;
+    while (c->cluster_count + count > c->cluster_capacity)
+    {
+        if (!grow((void **)&c->clusters, &c->cluster_capacity, c->cluster_capacity, sizeof(MeshletCluster)))
+            return false;
+    }
+
+    MeshletPage *page = &c->pages[c->page_count++];
+    SDL_zerop(page);
+    enclose_spheres(open->clusters, count, page->center, &page->radius);
+    page->first_cluster = c->cluster_count;
+    page->cluster_count = count;
+    page->offset = MESHLET_FILE_ALIGN + c->page_bytes;
+    page->size = (Uint32)pack_page(open->data, open->vertices, open->indices, c->step, c->packed);
+    SDL_memcpy(&c->clusters[c->cluster_count], open->clusters, count * sizeof(MeshletCluster));
+    c->cluster_count += count;
+    c->max_page_clusters = SDL_max(c->max_page_clusters, count);
+    if (SDL_WriteIO(c->io, c->packed, page->size) != page->size)
+        return false;
+    c->page_bytes += page->size;
+
+    SDL_memset(open->data, 0, MESHLET_PAGE_BYTES);
+    open->vertices = 0;
+    open->indices = 0;
+    open->cluster_count = 0;
+    return true;
+}
+
+/* Split one level of a group into clusters and add them to the level's
+   open page */
+static bool add_clusters(Cooker *c, const MeshletVertex *vertices, size_t vertex_count, const Uint32 *indices,
+                         size_t index_count, Uint16 material, Uint8 lod)
+{
+    const float *positions = vertices[0].position;
+    size_t max_meshlets = meshopt_buildMeshletsBound(index_count, MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES);
+    meshopt_Meshlet *meshlets = SDL_malloc(max_meshlets * sizeof(meshopt_Meshlet));
+    unsigned int *meshlet_vertices = SDL_malloc(max_meshlets * MESHLET_MAX_VERTICES * sizeof(unsigned int));
+    unsigned char *meshlet_triangles = SDL_malloc(max_meshlets * MESHLET_MAX_TRIANGLES * 3);
+    bool ok = meshlets && meshlet_vertices && meshlet_triangles;
+
+    size_t count = 0;
+    if (ok)
+    {
+        count = meshopt_buildMeshlets(meshlets, meshlet_vertices, meshlet_triangles, indices, index_count, positions,
+                                      vertex_count, sizeof(MeshletVertex), MESHLET_MAX_VERTICES,
+                                      MESHLET_MAX_TRIANGLES, MESHLET_CONE_WEIGHT);
+    }
+
+    OpenPage *open = &c->open[lod];
+    for (size_t m = 0; m < count && ok; m++)
+    {
+        const meshopt_Meshlet *ml = &meshlets[m];
+        const unsigned int *mv = meshlet_vertices + ml->vertex_offset;
+        const unsigned char *mt = meshlet_triangles + ml->triangle_offset;
+        meshopt_Bounds bounds = meshopt_computeMeshletBounds(mv, mt, ml->triangle_count, positions, vertex_count,
+                                                             sizeof(MeshletVertex));
+
+        if (open->vertices + ml->vertex_count > MESHLET_PAGE_VERTICES ||
+            open->indices + ml->triangle_count * 3 > MESHLET_PAGE_INDICES)
+        {
+            ok = flush_page(c, open);
+            if (!ok)
+                break;
+        }
+
+        MeshletVertex *dst = page_vertex_data(open->data) + open->vertices;
+        for (Uint32 v = 0; v < ml->vertex_count; v++)
+        {
+            dst[v] = vertices[mv[v]];
+            for (int a = 0; a < 3; a++)
+            {
+                c->bounds_min[a] = SDL_min(c->bounds_min[a], dst[v].position[a]);
+                c->bounds_max[a] = SDL_max(c->bounds_max[a], dst[v].position[a]);
+            }
+        }
+        Uint32 *idx = page_index_data(open->data) + open->indices;
+        for (Uint32 i = 0; i < ml->triangle_count * 3; i++)
+            idx[i] = mt[i];
+
+        MeshletCluster *cluster = &open->clusters[open->cluster_count++];
+        SDL_zerop(cluster);
+        SDL_memcpy(cluster->center, bounds.center, sizeof(cluster->center));
+        cluster->radius = bounds.radius + c->step; /* covers the lattice rounding */
+        SDL_memcpy(cluster->cone_axis, bounds.cone_axis, sizeof(cluster->cone_axis));
+        cluster->cone_cutoff = bounds.cone_cutoff;
+        cluster->vertex_offset = (Uint16)open->vertices;
+        cluster->index_offset = (Uint16)open->indices;
+        cluster->vertex_count = (Uint8)ml->vertex_count;
+        cluster->triangle_count = (Uint8)ml->triangle_count;
+        cluster->material = material;
+        cluster->group = c->group_count;
+        cluster->lod = lod;
+        open->vertices += ml->vertex_count;
+        open->indices += ml->triangle_count * 3;
+    }
+
+    SDL_free(meshlets);
+    SDL_free(meshlet_vertices);
+    SDL_free(meshlet_triangles);
+    return ok;
+}
+
+/* Full detail, then levels simplified from it to half the triangles each.
+   Vertices on the group's border stay put, so the groups around it match
+   whichever level they draw. `scratch` holds index_count indices. */
+static bool add_group(Cooker *c, const MeshletVertex *vertices, size_t vertex_count, const Uint32 *indices,
+                      size_t index_count, Uint16 material, Uint32 *scratch)
+{
+    if (!grow((void **)&c->groups, &c->group_capacity, c->group_count, sizeof(MeshletGroup)))
+        return false;
+
+    /* Every level uses a subset of the group's vertices */
+    MeshletGroup group;
+    SDL_zero(group);
+    float lo[3] = {1e30f, 1e30f, 1e30f}, hi[3] = {-1e30f, -1e30f, -1e30f};
+    for (size_t i = 0; i < vertex_count; i++)
+    {
+        for (int a = 0; a < 3; a++)
+        {
+            lo[a] = SDL_min(lo[a], vertices[i].position[a]);
+            hi[a] = SDL_max(hi[a], vertices[i].position[a]);
+        }
+    }
+    for (int a = 0; a < 3; a++)
+        group.center[a] = (lo[a] + hi[a]) * 0.5f;
+    for (size_t i = 0; i < vertex_count; i++)
+    {
+        const float *p = vertices[i].position;
+        float d[3] = {p[0] - group.center[0], p[1] - group.center[1], p[2] - group.center[2]};
+        group.radius = SDL_max(group.radius, SDL_sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]));
+    }
+    group.radius += c->step;
+
+    bool ok = add_clusters(c, vertices, vertex_count, indices, index_count, material, 0);
+    group.lod_count = 1;
+
+    const float *positions = vertices[0].position;
+    float scale = meshopt_simplifyScale(positions, vertex_count, sizeof(MeshletVertex));
+    size_t count = index_count;
+    while (ok && group.lod_count < MESHLET_MAX_LODS && count / 3 > MESHLET_MAX_TRIANGLES)
+    {
+        float error = 0.0f;
+        size_t simplified =
+            meshopt_simplify(scratch, indices, index_count, positions, vertex_count, sizeof(MeshletVertex),
+                             count / 6 * 3, MESHLET_LOD_MAX_ERROR, meshopt_SimplifyLockBorder, &error);
+        /* The locked border or the error bound stopped it early */
+        if (simplified == 0 || simplified > count / 4 * 3)
+            break;
+        group.lod_error[group.lod_count] = SDL_max(error * scale, group.lod_error[group.lod_count - 1]);
+        ok = add_clusters(c, vertices, vertex_count, scratch, simplified, material, (Uint8)group.lod_count);
+        group.lod_count++;
+        c->lod_triangles += simplified / 3;
+        count = simplified;
+    }
+
+    c->groups[c->group_count++] = group;
+    return ok;
+}
+
+/* Weld one mesh's vertices, cut its triangles into groups of nearby ones
+   and append those */
+static bool cooker_add(Cooker *c, const MeshletVertex *vertices, size_t vertex_count, const Uint32 *indices,
+                       size_t index_count, Uint16 material)
+{
+    index_count -= index_count % 3;
+    if (index_count == 0)
+        return true;
+
+    size_t groups = (index_count / 3 + MESHLET_GROUP_TRIANGLES - 1) / MESHLET_GROUP_TRIANGLES;
+    size_t group_indices = (index_count / 3 + groups - 1) / groups * 3;
+    Uint32 *remap = SDL_malloc(vertex_count * sizeof(Uint32));
+    Uint32 *welded_indices = SDL_malloc(index_count * sizeof(Uint32));
+    Uint32 *sorted = SDL_malloc(index_count * sizeof(Uint32));
+    MeshletVertex *group_vertices = SDL_malloc(group_indices * sizeof(MeshletVertex));
+    Uint32 *group = SDL_malloc(group_indices * 2 * sizeof(Uint32));
+    MeshletVertex *welded = NULL;
+    bool ok = remap && welded_indices && sorted && group_vertices && group;
+
+    size_t unique = 0;
+    if (ok)
+    {
+        unique = meshopt_generateVertexRemap(remap, indices, index_count, vertices, vertex_count,
+                                             sizeof(MeshletVertex));
+        welded = SDL_malloc(unique * sizeof(MeshletVertex));
+        ok = welded != NULL;
+    }
+    if (ok)
+    {
+        meshopt_remapVertexBuffer(welded, vertices, vertex_count, sizeof(MeshletVertex), remap);
+        meshopt_remapIndexBuffer(welded_indices, indices, index_count, remap);
+        /* Nearby triangles share groups, clusters and pages */
+        meshopt_spatialSortTriangles(sorted, welded_indices, index_count, welded[0].position, unique,
+                                     sizeof(MeshletVertex));
+        SDL_memset(remap, 0xFF, unique * sizeof(Uint32));
+    }
+
+    /* Each group gets compact vertices of its own; remap is now the
+       vertex's index in the current group */
+    for (size_t first = 0; ok && first < index_count; first += group_indices)
+    {
+        size_t count = SDL_min(group_indices, index_count - first);
+        Uint32 used = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            Uint32 v = sorted[first + i];
+            if (remap[v] == SLOT_NONE)
+            {
+                group_vertices[used] = welded[v];
+                remap[v] = used++;
+            }
+            group[i] = remap[v];
+        }
+        for (size_t i = 0; i < count; i++)
+            remap[sorted[first + i]] = SLOT_NONE;
+        ok = add_group(c, group_vertices, used, group, count, material, group + group_indices);
+    }
+    c->triangles += index_count / 3;
+
+    SDL_free(remap);
+    SDL_free(welded_indices);
+    SDL_free(sorted);
+    SDL_free(group_vertices);
+    SDL_free(group);
+    SDL_free(welded);
+    return ok;
+}
+
+/* Write the tables and the header, and close the file */
+static bool cooker_finish(Cooker *c)
+{
+    bool ok = true;
+    for (int l = 0; l < MESHLET_MAX_LODS; l++)
+        ok = ok && flush_page(c, &c->open[l]);
+    ok = ok && c->cluster_count > 0;
+
+    MeshletFileHeader header;
+    SDL_zero(header);
+    header.magic = MESHLET_FILE_MAGIC;
+    header.version = MESHLET_FILE_VERSION;
+    header.page_vertices = MESHLET_PAGE_VERTICES;
+    header.page_indices = MESHLET_PAGE_INDICES;
+    header.page_count = c->page_count;
+    header.cluster_count = c->cluster_count;
+    header.group_count = c->group_count;
+    header.material_count = c->material_count;
+    header.max_page_clusters = c->max_page_clusters;
+    header.position_step = c->step;
+    SDL_memcpy(header.bounds_min, c->bounds_min, sizeof(header.bounds_min));
+    SDL_memcpy(header.bounds_max, c->bounds_max, sizeof(header.bounds_max));
+    header.pages_offset = MESHLET_FILE_ALIGN;
+    header.tables_offset = header.pages_offset + c->page_bytes;
+
+    size_t page_bytes = c->page_count * sizeof(MeshletPage);
+    size_t cluster_bytes = c->cluster_count * sizeof(MeshletCluster);
+    size_t group_bytes = c->group_count * sizeof(MeshletGroup);
+    size_t material_bytes = c->material_count * 4 * sizeof(float);
+    ok = ok && SDL_WriteIO(c->io, c->pages, page_bytes) == page_bytes &&
+         SDL_WriteIO(c->io, c->clusters, cluster_bytes) == cluster_bytes &&
+         SDL_WriteIO(c->io, c->groups, group_bytes) == group_bytes &&
+         SDL_WriteIO(c->io, c->materials, material_bytes) == material_bytes &&
+         SDL_SeekIO(c->io, 0, SDL_IO_SEEK_SET) == 0 && SDL_WriteIO(c->io, &header, sizeof(header)) == sizeof(header);
+    ok = SDL_CloseIO(c->io) && ok;
+    c->io = NULL;
+    c->file_bytes = header.tables_offset + page_bytes + cluster_bytes + group_bytes + material_bytes;
+    return ok;
+}
+
+/*================================================================================
+ * glTF import
+ *================================================================================*/
+static void *gltf_alloc(void *user, cgltf_size size)
+{
+    (void)user;
+    return SDL_malloc(size);
+}
+
+static void gltf_free(void *user, void *ptr)
+{
+    (void)user;
+    SDL_free(ptr);
+}
+
+/* An external buffer's path, relative to the glTF's directory */
+static char *buffer_path(const char *gltf_path, const char *uri)
+{
+    size_t dir_len = 0;
+    for (const char *p = gltf_path; *p; p++)
+    {
+        if (*p == '/' || *p == '\\')
+            dir_len = (size_t)(p - gltf_path) + 1;
+    }
+    char *decoded = SDL_strdup(uri);
+    if (!decoded)
+        return NULL;
+    cgltf_decode_uri(decoded);
+    char *path = NULL;
+    if (SDL_asprintf(&path, "%.*s%s", (int)dir_len, gltf_path, decoded) < 0)
+        path = NULL;
+    SDL_free(decoded);
+    return path;
+}
+
+/* GLB and data: buffers are in memory after parsing; external ones are
+   only resolved to a path, and read per accessor */
+static bool prepare_buffers(const cgltf_options *options, cgltf_data *data, const char *gltf_path, char **paths)
+{
+    for (size_t i = 0; i < data->buffers_count; i++)
+    {
+        cgltf_buffer *buffer = &data->buffers[i];
+        if (!buffer->uri)
+        {
+            if (data->bin && buffer->size <= data->bin_size)
+            {
+                buffer->data = (void *)data->bin;
+                buffer->data_free_method = cgltf_data_free_method_none;
+            }
+            continue;
+        }
+        if (SDL_strncmp(buffer->uri, "data:", 5) == 0)
+        {
+            const char *comma = SDL_strchr(buffer->uri, ',');
+            if (!comma || cgltf_load_buffer_base64(options, buffer->size, comma + 1, &buffer->data) !=
+                              cgltf_result_success)
+                return false;
+            buffer->data_free_method = cgltf_data_free_method_memory_free;
+            continue;
+        }
+        paths[i] = buffer_path(gltf_path, buffer->uri);
+        if (!paths[i])
+            return false;
+    }
+    return true;
+}
+
+/* Compressed views are decoded whole, so external buffers holding meshopt
+   sources are read in full; everything else stays streamed per accessor */
+static bool decode_meshopt(cgltf_data *data, char **paths, const char *gltf_path)
+{
+    for (size_t i = 0; i < data->buffer_views_count; i++)
+    {
+        const cgltf_buffer_view *view = &data->buffer_views[i];
+        if (!view->has_meshopt_compression)
+            continue;
+        cgltf_buffer *buffer = view->meshopt_compression.buffer;
+        const char *path = paths[buffer - data->buffers];
+        if (buffer->data || !path)
+            continue;
+        size_t size = 0;
+        buffer->data = SDL_LoadFile(path, &size);
+        if (!buffer->data || size < buffer->size)
+        {
+            SDL_Log("Meshlets: failed to read compressed buffer '%s'", path);
+            SDL_free(buffer->data);
+            buffer->data = NULL;
+            return false;
+        }
+        buffer->data_free_method = cgltf_data_free_method_memory_free;
+    }
+    return gltf_meshopt_decode(data, gltf_path);
+}
+
+/* An accessor of an external buffer, pointed at a private view holding
+   just the bytes it covers while one primitive is cooked */
+typedef struct LoadedAccessor
+{
+    cgltf_accessor *accessor;
+    cgltf_buffer_view *view;
+    cgltf_size offset;
+    cgltf_buffer_view local;
+} LoadedAccessor;
+
+static bool load_accessor(const cgltf_data *data, char **paths, cgltf_accessor *acc, LoadedAccessor *out)
+{
+    SDL_zerop(out);
+    cgltf_buffer_view *view = acc->buffer_view;
+    if (!view || view->data || view->buffer->data)
+        return true;
+    const char *path = paths[view->buffer - data->buffers];
+    if (acc->is_sparse || !path)
+    {
+        SDL_Log("Meshlets: accessor '%s' is sparse or has no buffer", acc->name ? acc->name : "(unnamed)");
+        return false;
+    }
+
+    size_t element = cgltf_calc_size(acc->type, acc->component_type);
+    size_t size = acc->count ? acc->stride * (acc->count - 1) + element : 0;
+    void *bytes = SDL_malloc(size ? size : 1);
+    SDL_IOStream *io = bytes ? SDL_IOFromFile(path, "rb") : NULL;
+    bool ok = io && read_at(io, view->offset + acc->offset, bytes, size);
+    if (io)
+        SDL_CloseIO(io);
+    if (!ok)
+    {
+        SDL_Log("Meshlets: cannot read %zu bytes of '%s'", size, path);
+        SDL_free(bytes);
+        return false;
+    }
+
+    out->accessor = acc;
+    out->view = view;
+    out->offset = acc->offset;
+    out->local = *view;
+    out->local.data = bytes;
+    out->local.offset = 0;
+    out->local.size = size;
+    acc->buffer_view = &out->local;
+    acc->offset = 0;
+    return true;
+}
+
+static void unload_accessor(LoadedAccessor *loaded)
+{
+    if (!loaded->accessor)
+        return;
+    SDL_free(loaded->local.data);
+    loaded->accessor->buffer_view = loaded->view;
+    loaded->accessor->offset = loaded->offset;
+    loaded->accessor = NULL;
+}
+
+static cgltf_accessor *find_attribute(const cgltf_primitive *prim, cgltf_attribute_type type)
+{
+    for (size_t i = 0; i < prim->attributes_count; i++)
+    {
+        if (prim->attributes[i].type == type && prim->attributes[i].index == 0)
+            return prim->attributes[i].data;
+    }
+    return NULL;
+}
+
+/* World-space vertices of one primitive instance, with normals by the
+   inverse transpose and the winding kept under mirroring transforms */
+static void transform_vertices(const float *m, const AccessorStreams *streams, MeshletVertex *out, size_t count,
+                               Uint32 *indices, size_t index_count)
+{
+    const float *c0 = &m[0], *c1 = &m[4], *c2 = &m[8];
+    float cof[3][3] = {{c1[1] * c2[2] - c1[2] * c2[1], c1[2] * c2[0] - c1[0] * c2[2], c1[0] * c2[1] - c1[1] * c2[0]},
+                       {c2[1] * c0[2] - c2[2] * c0[1], c2[2] * c0[0] - c2[0] * c0[2], c2[0] * c0[1] - c2[1] * c0[0]},
+                       {c0[1] * c1[2] - c0[2] * c1[1], c0[2] * c1[0] - c0[0] * c1[2], c0[0] * c1[1] - c0[1] * c1[0]}};
+    float det = c0[0] * cof[0][0] + c0[1] * cof[0][1] + c0[2] * cof[0][2];
+
+    for (size_t i = 0; i < count; i++)
+    {
+        float p[3], n[3] = {0.0f, 0.0f, 0.0f};
+        for (int a = 0; a < 3; a++)
+        {
+            p[a] = streams[0].streams[a][i];
+            if (streams[1].count)
+                n[a] = streams[1].streams[a][i];
+        }
+        float len = 0.0f;
+        for (int a = 0; a < 3; a++)
+        {
+            out[i].position[a] = m[a] * p[0] + m[4 + a] * p[1] + m[8 + a] * p[2] + m[12 + a];
+            out[i].normal[a] = cof[0][a] * n[0] + cof[1][a] * n[1] + cof[2][a] * n[2];
+            len += out[i].normal[a] * out[i].normal[a];
+        }
+        float inv = len > 0.0f ? (det < 0.0f ? -1.0f : 1.0f) / SDL_sqrtf(len) : 0.0f;
+        for (int a = 0; a < 3; a++)
+            out[i].normal[a] *= inv;
+        out[i].uv[0] = streams[2].count ? streams[2].streams[0][i] : 0.0f;
+        out[i].uv[1] = streams[2].count ? streams[2].streams[1][i] : 0.0f;
+    }
+
+    if (det < 0.0f)
+    {
+        for (size_t t = 0; t + 2 < index_count; t += 3)
+        {
+            Uint32 swap = indices[t + 1];
+            indices[t + 1] = indices[t + 2];
+            indices[t + 2] = swap;
+        }
+    }
+}
+
+static void grow_bounds(const float *m, const float p[3], float min[3], float max[3])
+{
+    for (int a = 0; a < 3; a++)
+    {
+        float w = m[a] * p[0] + m[4 + a] * p[1] + m[8 + a] * p[2] + m[12 + a];
+        min[a] = SDL_min(min[a], w);
+        max[a] = SDL_max(max[a], w);
+    }
+}
+
+/* World bounds of one primitive instance: the corners of the range its
+   positions declare, unless they are normalized integers, else every
+   position */
+static bool primitive_bounds(const cgltf_data *data, char **paths, cgltf_primitive *prim, const float *world,
+                             float min[3], float max[3])
+{
+    cgltf_accessor *acc = find_attribute(prim, cgltf_attribute_type_position);
+    if (prim->type != cgltf_primitive_type_triangles || !acc || acc->count == 0)
+        return true;
+    if (acc->has_min && acc->has_max && !acc->normalized)
+    {
+        for (int k = 0; k < 8; k++)
+        {
+            float p[3] = {k & 1 ? acc->max[0] : acc->min[0], k & 2 ? acc->max[1] : acc->min[1],
+                          k & 4 ? acc->max[2] : acc->min[2]};
+            grow_bounds(world, p, min, max);
+        }
+        return true;
+    }
+
+    AccessorStreams streams;
+    LoadedAccessor loaded;
+    SDL_zero(streams);
+    AccessorUnpackRequest request = {acc, &streams, NULL};
+    bool ok = load_accessor(data, paths, acc, &loaded) && accessor_unpack_batch(&request, 1);
+    unload_accessor(&loaded);
+    for (size_t i = 0; ok && streams.num_components >= 3 && i < streams.count; i++)
+    {
+        float p[3] = {streams.streams[0][i], streams.streams[1][i], streams.streams[2][i]};
+        grow_bounds(world, p, min, max);
+    }
+    accessor_streams_free(&streams);
+    return ok;
+}
+
+static bool cook_primitive(Cooker *c, const cgltf_data *data, char **paths, cgltf_primitive *prim,
+                           const float *world, Uint16 material)
+{
+    cgltf_accessor *attrs[3] = {find_attribute(prim, cgltf_attribute_type_position),
+                                find_attribute(prim, cgltf_attribute_type_normal),
+                                find_attribute(prim, cgltf_attribute_type_texcoord)};
+    if (prim->type != cgltf_primitive_type_triangles || !attrs[0] || attrs[0]->count == 0)
+        return true;
+    size_t count = attrs[0]->count;
+    for (int a = 1; a < 3; a++)
+    {
+        if (attrs[a] && attrs[a]->count != count)
+            attrs[a] = NULL;
+    }
+
+    size_t index_count = prim->indices ? prim->indices->count : count;
+    Uint32 *indices = SDL_malloc(index_count * sizeof(Uint32) + 1);
+    MeshletVertex *vertices = SDL_malloc(count * sizeof(MeshletVertex));
+    AccessorStreams streams[3];
+    LoadedAccessor loaded[4];
+    AccessorUnpackRequest requests[4];
+    SDL_zeroa(streams);
+    SDL_zeroa(loaded);
+    size_t num_requests = 0;
+    bool ok = indices && vertices;
+
+    for (int a = 0; a < 3 && ok; a++)
+    {
+        if (!attrs[a])
+            continue;
+        ok = load_accessor(data, paths, attrs[a], &loaded[a]);
+        requests[num_requests++] = (AccessorUnpackRequest){attrs[a], &streams[a], NULL};
+    }
+    if (ok && prim->indices)
+    {
+        ok = load_accessor(data, paths, prim->indices, &loaded[3]);
+        requests[num_requests++] = (AccessorUnpackRequest){prim->indices, NULL, indices};
+    }
+    else if (ok)
+    {
+        for (size_t i = 0; i < index_count; i++)
+            indices[i] = (Uint32)i;
+    }
+    ok = ok && accessor_unpack_batch(requests, num_requests);
+    for (int i = 0; i < 4; i++)
+        unload_accessor(&loaded[i]);
+
+    for (size_t i = 0; ok && i < index_count; i++)
+    {
+        if (indices[i] >= count)
+        {
+            SDL_Log("Meshlets: index %u out of range (%zu vertices), primitive skipped", indices[i], count);
+            ok = false;
+        }
+    }
+    bool cooked = true;
+    if (ok && streams[0].num_components >= 3)
+    {
+        transform_vertices(world, streams, vertices, count, indices, index_count);
+        cooked = cooker_add(c, vertices, count, indices, index_count, material);
+    }
+
+    for (int a = 0; a < 3; a++)
+        accessor_streams_free(&streams[a]);
+    SDL_free(indices);
+    SDL_free(vertices);
+    return cooked;
+}
+
+static bool in_default_scene(const cgltf_data *data, const cgltf_node *node)
+{
+    const cgltf_scene *scene = data->scene ? data->scene : data->scenes_count ? &data->scenes[0] : NULL;
+    if (!scene)
+        return true;
+    while (node->parent)
+        node = node->parent;
+    for (size_t i = 0; i < scene->nodes_count; i++)
+    {
+        if (scene->nodes[i] == node)
+            return true;
+    }
+    return false;
+}
+
+static bool supported(const cgltf_data *data, const char *path)
+{
+    static const char *const unsupported[] = {"KHR_draco_mesh_compression"};
+    for (size_t i = 0; i < data->extensions_required_count; i++)
+    {
+        for (size_t j = 0; j < SDL_arraysize(unsupported); j++)
+        {
+            if (SDL_strcmp(data->extensions_required[i], unsupported[j]) == 0)
+            {
+                SDL_Log("Meshlets: '%s' requires %s, which cooking does not decode", path, unsupported[j]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool parse_gltf(const char *path, cgltf_options *options, cgltf_data **data)
+{
+    SDL_zerop(options);
+    options->memory.alloc_func = gltf_alloc;
+    options->memory.free_func = gltf_free;
+    if (cgltf_parse_file(options, path, data) != cgltf_result_success)
+    {
+        SDL_Log("Meshlets: failed to parse '%s'", path);
+        return false;
+    }
+    /* Accessor and view ranges must fit before any is read from disk */
+    if (cgltf_validate(*data) != cgltf_result_success)
+    {
+        SDL_Log("Meshlets: invalid glTF '%s'", path);
+        cgltf_free(*data);
+        *data = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool meshlet_cook_file(const char *gltf_path, const char *out_path, MeshletCookStats *stats)
+{
+    cgltf_options options;
+    cgltf_data *data = NULL;
+    if (!parse_gltf(gltf_path, &options, &data))
+        return false;
+
+    /* Material 0 is the default, glTF material i is i + 1 */
+    char **paths = SDL_calloc(data->buffers_count + 1, sizeof(char *));
+    float *materials = SDL_malloc((data->materials_count + 1) * 4 * sizeof(float));
+    float min[3] = {1e30f, 1e30f, 1e30f}, max[3] = {-1e30f, -1e30f, -1e30f};
+    char *tmp = NULL;
+    Cooker cooker;
+    bool ok = paths && materials && supported(data, gltf_path) &&
+              prepare_buffers(&options, data, gltf_path, paths) && decode_meshopt(data, paths, gltf_path);
+
+    /* The position lattice spans the whole scene, so bounds come first */
+    for (size_t i = 0; ok && i < data->nodes_count; i++)
+    {
+        cgltf_node *node = &data->nodes[i];
+        if (!node->mesh || !in_default_scene(data, node))
+            continue;
+        float world[16];
+        cgltf_node_transform_world(node, world);
+        for (size_t j = 0; ok && j < node->mesh->primitives_count; j++)
+            ok = primitive_bounds(data, paths, &node->mesh->primitives[j], world, min, max);
+    }
+    ok = ok && SDL_asprintf(&tmp, "%s.tmp", out_path) > 0 &&
+         cooker_begin(&cooker, tmp, materials, (Uint32)SDL_min(data->materials_count + 1, 0xFFFF),
+                      position_step(min, max));
+    bool started = ok;
+    if (ok)
+    {
+        const float white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        SDL_memcpy(materials, white, sizeof(white));
+        for (size_t i = 0; i < data->materials_count; i++)
+            SDL_memcpy(&materials[(i + 1) * 4], data->materials[i].pbr_metallic_roughness.base_color_factor,
+                       sizeof(white));
+    }
+
+    for (size_t i = 0; ok && i < data->nodes_count; i++)
+    {
+        cgltf_node *node = &data->nodes[i];
+        if (!node->mesh || !in_default_scene(data, node))
+            continue;
+        float world[16];
+        cgltf_node_transform_world(node, world);
+        for (size_t j = 0; ok && j < node->mesh->primitives_count; j++)
+        {
+            cgltf_primitive *prim = &node->mesh->primitives[j];
+            size_t material = prim->material ? (size_t)(prim->material - data->materials) + 1 : 0;
+            material = SDL_min(material, cooker.material_count - 1);
+            ok = cook_primitive(&cooker, data, paths, prim, world, (Uint16)material);
+        }
+    }
+
+    if (started)
+    {
+        ok = cooker_finish(&cooker) && ok && SDL_RenamePath(tmp, out_path);
+        if (!ok)
+        {
+            SDL_Log("Meshlets: cooking '%s' failed", gltf_path);
+            SDL_RemovePath(tmp);
+        }
+        else if (stats)
+        {
+            stats->triangles = cooker.triangles;
+            stats->lod_triangles = cooker.lod_triangles;
+            stats->clusters = cooker.cluster_count;
+            stats->groups = cooker.group_count;
+            stats->pages = cooker.page_count;
+            stats->file_bytes = cooker.file_bytes;
+        }
+        cooker_free(&cooker);
+    }
+
+    for (size_t i = 0; paths && i < data->buffers_count; i++)
+        SDL_free(paths[i]);
+    SDL_free(paths);
+    SDL_free(materials);
+    SDL_free(tmp);
+    cgltf_free(data);
+    return ok;
+}
+
+/* Files of an older version are cooked again, however new they are */
+static bool current_version(const char *path)
+{
+    MeshletFileHeader h;
+    SDL_IOStream *io = SDL_IOFromFile(path, "rb");
+    bool ok = io && read_at(io, 0, &h, sizeof(h)) && h.magic == MESHLET_FILE_MAGIC &&
+              h.version == MESHLET_FILE_VERSION;
+    if (io)
+        SDL_CloseIO(io);
+    return ok;
+}
+
+bool meshlet_cook(const char *gltf_path, const char *out_path)
+{
+    SDL_PathInfo source, cooked;
+    if (!SDL_GetPathInfo(gltf_path, &source))
+    {
+        SDL_Log("Meshlets: cannot open '%s'", gltf_path);
+        return false;
+    }
+    if (SDL_GetPathInfo(out_path, &cooked) && cooked.modify_time >= source.modify_time && current_version(out_path))
+    {
+        SDL_Log("Meshlets: '%s' is up to date", out_path);
+        return true;
+    }
+
+    Uint64 start = bench_now();
+    MeshletCookStats stats;
+    if (!meshlet_cook_file(gltf_path, out_path, &stats))
+        return false;
+    SDL_Log("Meshlets: '%s' cooked to %u clusters in %u groups and %u pages (%.1f MB, %llu triangles and %llu in "
+            "coarser levels) in %.0f ms",
+            gltf_path, stats.clusters, stats.groups, stats.pages, (double)stats.file_bytes / (1024.0 * 1024.0),
+            (unsigned long long)stats.triangles, (unsigned long long)stats.lod_triangles, bench_ms_since(start));
+    return true;
+}
+
+char **meshlet_cook_dependencies(const char *gltf_path, int *count)
+{
+    *count = 0;
+    cgltf_options options;
+    cgltf_data *data = NULL;
+    if (!parse_gltf(gltf_path, &options, &data))
+        return NULL;
+
+    char **paths = SDL_calloc(data->buffers_count + 1, sizeof(char *));
+    size_t text_bytes = SDL_strlen(gltf_path) + 1;
+    int n = 1;
+    bool ok = paths != NULL;
+    for (size_t i = 0; ok && i < data->buffers_count; i++)
+    {
+        const char *uri = data->buffers[i].uri;
+        if (!uri || SDL_strncmp(uri, "data:", 5) == 0)
+            continue;
+        paths[n] = buffer_path(gltf_path, uri);
+        ok = paths[n] != NULL;
+        if (ok)
+            text_bytes += SDL_strlen(paths[n++]) + 1;
+    }
+
+    /* The pointers, then the strings they point at */
+    char **out = ok ? SDL_malloc(n * sizeof(char *) + text_bytes) : NULL;
+    if (out)
+    {
+        char *text = (char *)(out + n);
+        for (int i = 0; i < n; i++)
+        {
+            const char *src = i ? paths[i] : gltf_path;
+            size_t len = SDL_strlen(src) + 1;
+            SDL_memcpy(text, src, len);
+            out[i] = text;
+            text += len;
+        }
+        *count = n;
+    }
+
+    for (size_t i = 1; paths && i <= data->buffers_count; i++)
+        SDL_free(paths[i]);
+    SDL_free(paths);
+    cgltf_free(data);
+    return out;
+}
+
+/*================================================================================
+ * Streaming
+ *================================================================================*/
+typedef enum PageState
+{
+    PAGE_ABSENT,
+    PAGE_READING,
+    PAGE_READ, /* waiting for its upload */
+    PAGE_RESIDENT,
+    PAGE_FAILED
+} PageState;
+
+typedef enum ReadState
+{
+    READ_FREE,
+    READ_BUSY,
+    READ_DONE,
+    READ_FAILED
+} ReadState;
+
+/* One of the fixed read buffers; the worker only writes bytes and state */
+typedef struct PageRead
+{
+    const MeshletStream *stream;
+    Uint8 *packed;
+    Uint8 *bytes; /* unpacked */
+    Uint32 page;
+    SDL_AtomicInt state;
+} PageRead;
+
+typedef struct PageWant
+{
+    float priority;
+    Uint32 page;
+} PageWant;
+
+struct MeshletStream
+{
+    SDL_GPUDevice *device;
+    char *path;
+    MeshletFileHeader header;
+    MeshletPage *pages;
+    MeshletCluster *clusters;
+    MeshletGroup *groups;
+    float *materials;
+
+    /* Per group and cluster, rebuilt by every update */
+    Uint8 *group_want;    /* level picked for the view, LEVEL_NONE when culled */
+    Uint8 *group_draw;    /* the wanted level, or a coarser one standing in */
+    Uint8 *group_missing; /* bit per level with visible clusters not resident */
+    Uint8 *cluster_seen;  /* visible at a level no finer than wanted */
+
+    /* Per page, main thread only */
+    Uint8 *page_state;
+    Uint32 *page_slot;
+    Uint64 *page_wanted; /* last update that found it visible */
+    PageWant *wants;
+    Uint32 want_count;
+
+    Uint32 slot_count;
+    Uint32 *slot_page; /* SLOT_NONE when free */
+    Uint8 *cpu_pool;   /* the slots' pages when there is no device */
+    PageRead reads[MESHLET_MAX_READS];
+
+    SDL_GPUBuffer *vertex_pool;
+    SDL_GPUBuffer *index_pool;
+    SDL_GPUBuffer *command_buffer;
+    SDL_GPUTransferBuffer *staging; /* commands, then the pages read */
+    SDL_GPUIndexedIndirectDrawCommand *commands;
+    Uint32 *command_cluster;
+    Uint32 command_capacity;
+    Uint32 command_count;
+
+    Uint64 update;
+    size_t cpu_bytes; /* reserved in RESIDENCY_MODELS */
+    MeshletStreamStats stats;
+};
+
+static void read_page_task(void *userdata)
+{
+    PageRead *read = userdata;
+    const MeshletStream *s = read->stream;
+    const MeshletPage *page = &s->pages[read->page];
+    SDL_IOStream *io = SDL_IOFromFile(s->path, "rb");
+    bool ok = io && read_at(io, page->offset, read->packed, page->size) &&
+              unpack_page(read->packed, page->size, s->header.position_step, read->bytes);
+    if (io)
+        SDL_CloseIO(io);
+    SDL_SetAtomicInt(&read->state, ok ? READ_DONE : READ_FAILED);
+}
+
+static bool read_tables(MeshletStream *s, SDL_IOStream *io)
+{
+    const MeshletFileHeader *h = &s->header;
+    size_t page_bytes = h->page_count * sizeof(MeshletPage);
+    size_t cluster_bytes = h->cluster_count * sizeof(MeshletCluster);
+    size_t group_bytes = h->group_count * sizeof(MeshletGroup);
+    size_t material_bytes = h->material_count * 4 * sizeof(float);
+    if (!read_at(io, h->tables_offset, s->pages, page_bytes) ||
+        SDL_ReadIO(io, s->clusters, cluster_bytes) != cluster_bytes ||
+        SDL_ReadIO(io, s->groups, group_bytes) != group_bytes ||
+        SDL_ReadIO(io, s->materials, material_bytes) != material_bytes)
+        return false;
+    for (Uint32 p = 0; p < h->page_count; p++)
+    {
+        const MeshletPage *page = &s->pages[p];
+        if (page->first_cluster > h->cluster_count || page->cluster_count > h->cluster_count - page->first_cluster ||
+            page->cluster_count > h->max_page_clusters || page->offset < h->pages_offset ||
+            page->size < sizeof(MeshletPackedPage) || page->size > MESHLET_PACKED_MAX_BYTES ||
+            page->offset + page->size > h->tables_offset)
+            return false;
+    }
+    for (Uint32 g = 0; g < h->group_count; g++)
+    {
+        if (s->groups[g].lod_count == 0 || s->groups[g].lod_count > MESHLET_MAX_LODS)
+            return false;
+    }
+    for (Uint32 i = 0; i < h->cluster_count; i++)
+    {
+        const MeshletCluster *c = &s->clusters[i];
+        if (c->vertex_offset + c->vertex_count > MESHLET_PAGE_VERTICES ||
+            c->index_offset + c->triangle_count * 3 > MESHLET_PAGE_INDICES || c->material >= h->material_count ||
+            c->group >= h->group_count || c->lod >= s->groups[c->group].lod_count)
+            return false;
+    }
+    return true;
+}
+
+static bool create_pool(MeshletStream *s)
+{
+    SDL_GPUBufferCreateInfo info;
+    SDL_zero(info);
+    info.usage = SDL_GPU_BUFFERUSAGE_VERTEX;
+    info.size = s->slot_count * MESHLET_PAGE_VERTICES * (Uint32)sizeof(MeshletVertex);
+    s->vertex_pool = residency_create_buffer(s->device, &info, RESIDENCY_GEOMETRY);
+    info.usage = SDL_GPU_BUFFERUSAGE_INDEX;
+    info.size = s->slot_count * MESHLET_PAGE_INDICES * (Uint32)sizeof(Uint32);
+    s->index_pool = residency_create_buffer(s->device, &info, RESIDENCY_GEOMETRY);
+    info.usage = SDL_GPU_BUFFERUSAGE_INDIRECT;
+    info.size = s->command_capacity * (Uint32)sizeof(SDL_GPUIndexedIndirectDrawCommand);
+    s->command_buffer = residency_create_buffer(s->device, &info, RESIDENCY_GEOMETRY);
+
+    SDL_GPUTransferBufferCreateInfo tb;
+    SDL_zero(tb);
+    tb.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+    tb.size = info.size + MESHLET_MAX_READS * (Uint32)MESHLET_PAGE_BYTES;
+    s->staging = residency_create_transfer_buffer(s->device, &tb, RESIDENCY_STAGING);
+    return s->vertex_pool && s->index_pool && s->command_buffer && s->staging;
+}
+
+MeshletStream *meshlet_stream_open(SDL_GPUDevice *device, const char *path, size_t memory_cap)
+{
+    SDL_IOStream *io = SDL_IOFromFile(path, "rb");
+    MeshletFileHeader h;
+    if (!io || !read_at(io, 0, &h, sizeof(h)) || h.magic != MESHLET_FILE_MAGIC || h.version != MESHLET_FILE_VERSION ||
+        h.page_vertices != MESHLET_PAGE_VERTICES || h.page_indices != MESHLET_PAGE_INDICES || h.page_count == 0 ||
+        h.group_count == 0 || h.material_count == 0 || h.max_page_clusters == 0 ||
+        h.max_page_clusters > MESHLET_PAGE_INDICES / 3 || !(h.position_step > 0.0f) || h.position_step > 1e30f ||
+        h.tables_offset < h.pages_offset)
+    {
+        SDL_Log("Meshlets: '%s' is not a meshlet file of this version", path);
+        if (io)
+            SDL_CloseIO(io);
+        return NULL;
+    }
+
+    /* Tables, per-page state and read buffers are fixed; the rest of the
+       cap buys page slots and their draw commands */
+    size_t cmd = sizeof(SDL_GPUIndexedIndirectDrawCommand) + sizeof(Uint32);
+    size_t tables = h.page_count * (sizeof(MeshletPage) + sizeof(Uint8) + sizeof(Uint32) + sizeof(Uint64) +
+                                    sizeof(PageWant)) +
+                    h.cluster_count * (sizeof(MeshletCluster) + sizeof(Uint8)) +
+                    h.group_count * (sizeof(MeshletGroup) + 3 * sizeof(Uint8)) + h.material_count * 4 * sizeof(float);
+    size_t reads = MESHLET_MAX_READS * (MESHLET_PACKED_MAX_BYTES + MESHLET_PAGE_BYTES);
+    size_t fixed = tables + reads + (device ? MESHLET_MAX_READS * MESHLET_PAGE_BYTES : 0);
+    size_t per_slot = MESHLET_PAGE_BYTES + sizeof(Uint32) +
+                      h.max_page_clusters * (cmd + (device ? 2 * sizeof(SDL_GPUIndexedIndirectDrawCommand) : 0));
+    if (memory_cap < fixed + per_slot)
+    {
+        SDL_Log("Meshlets: '%s' needs at least %.1f MB to stream", path,
+                (double)(fixed + per_slot) / (1024.0 * 1024.0));
+        SDL_CloseIO(io);
+        return NULL;
+    }
+    Uint32 slots = (Uint32)SDL_min((memory_cap - fixed) / per_slot, (size_t)h.page_count);
+    slots = SDL_min(slots, SDL_MAX_UINT32 / (MESHLET_PAGE_VERTICES * (Uint32)sizeof(MeshletVertex)));
+
+    size_t cpu_bytes = tables + reads + slots * (sizeof(Uint32) + h.max_page_clusters * cmd) +
+                       (device ? 0 : slots * MESHLET_PAGE_BYTES);
+    MeshletStream *s = SDL_calloc(1, sizeof(MeshletStream));
+    if (!s || !residency_reserve(RESIDENCY_MODELS, cpu_bytes))
+    {
+        SDL_Log("Meshlets: %.1f MB of tables and buffers do not fit the model budget",
+                (double)cpu_bytes / (1024.0 * 1024.0));
+        SDL_free(s);
+        SDL_CloseIO(io);
+        return NULL;
+    }
+    s->device = device;
+    s->header = h;
+    s->cpu_bytes = cpu_bytes;
+    s->slot_count = slots;
+    s->command_capacity = slots * h.max_page_clusters;
+    s->path = SDL_strdup(path);
+    s->pages = SDL_malloc(h.page_count * sizeof(MeshletPage));
+    s->clusters = SDL_malloc(h.cluster_count * sizeof(MeshletCluster) + 1);
+    s->groups = SDL_malloc(h.group_count * sizeof(MeshletGroup));
+    s->materials = SDL_malloc(h.material_count * 4 * sizeof(float));
+    s->group_want = SDL_malloc(h.group_count);
+    s->group_draw = SDL_malloc(h.group_count);
+    s->group_missing = SDL_malloc(h.group_count);
+    s->cluster_seen = SDL_malloc(h.cluster_count + 1);
+    s->page_state = SDL_calloc(h.page_count, sizeof(Uint8));
+    s->page_slot = SDL_malloc(h.page_count * sizeof(Uint32));
+    s->page_wanted = SDL_calloc(h.page_count, sizeof(Uint64));
+    s->wants = SDL_malloc(h.page_count * sizeof(PageWant));
+    s->slot_page = SDL_malloc(slots * sizeof(Uint32));
+    s->commands = SDL_malloc(s->command_capacity * sizeof(SDL_GPUIndexedIndirectDrawCommand));
+    s->command_cluster = SDL_malloc(s->command_capacity * sizeof(Uint32));
+    s->cpu_pool = device ? NULL : SDL_malloc(slots * MESHLET_PAGE_BYTES);
+    bool ok = s->path && s->pages && s->clusters && s->groups && s->materials && s->group_want && s->group_draw &&
+              s->group_missing && s->cluster_seen && s->page_state && s->page_slot && s->page_wanted && s->wants &&
+              s->slot_page && s->commands && s->command_cluster && (device || s->cpu_pool);
+    for (int r = 0; r < MESHLET_MAX_READS && ok; r++)
+    {
+        s->reads[r].stream = s;
+        s->reads[r].packed = SDL_malloc(MESHLET_PACKED_MAX_BYTES);
+        s->reads[r].bytes = SDL_malloc(MESHLET_PAGE_BYTES);
+        ok = s->reads[r].packed && s->reads[r].bytes;
+    }
+    ok = ok && read_tables(s, io);
+    SDL_CloseIO(io);
+    if (!ok)
+    {
+        SDL_Log("Meshlets: failed to load the tables of '%s'", path);
+        meshlet_stream_close(s);
+        return NULL;
+    }
+    if (device && !create_pool(s))
+    {
+        SDL_Log("Meshlets: failed to create the page pool: %s", SDL_GetError());
+        meshlet_stream_close(s);
+        return NULL;
+    }
+    for (Uint32 p = 0; p < h.page_count; p++)
+        s->page_slot[p] = SLOT_NONE;
+    for (Uint32 i = 0; i < slots; i++)
+        s->slot_page[i] = SLOT_NONE;
+
+    s->stats.clusters = h.cluster_count;
+    s->stats.groups = h.group_count;
+    s->stats.pages = h.page_count;
+    s->stats.slots = slots;
+    s->stats.memory_bytes = fixed + slots * per_slot;
+    s->stats.file_bytes = (size_t)(h.tables_offset - h.pages_offset);
+    SDL_Log("Meshlets: '%s' %u clusters in %u groups and %u pages (%.1f MB), %u slots on the %s (%.1f MB)", path,
+            h.cluster_count, h.group_count, h.page_count, (double)s->stats.file_bytes / (1024.0 * 1024.0), slots,
+            device ? "GPU" : "CPU", (double)s->stats.memory_bytes / (1024.0 * 1024.0));
+    return s;
+}
+
+void meshlet_stream_wait(MeshletStream *s)
+{
+    for (int r = 0; s && r < MESHLET_MAX_READS; r++)
+    {
+        while (SDL_GetAtomicInt(&s->reads[r].state) == READ_BUSY)
+            SDL_Delay(1);
+    }
+}
+
+void meshlet_stream_close(MeshletStream *s)
+{
+    if (!s)
+        return;
+
+    meshlet_stream_wait(s);
+    if (s->device)
+    {
+        residency_release_buffer(s->device, s->vertex_pool);
+        residency_release_buffer(s->device, s->index_pool);
+        residency_release_buffer(s->device, s->command_buffer);
+        residency_release_transfer_buffer(s->device, s->staging);
+    }
+    for (int r = 0; r < MESHLET_MAX_READS; r++)
+    {
+        SDL_free(s->reads[r].packed);
+        SDL_free(s->reads[r].bytes);
+    }
+    SDL_free(s->path);
+    SDL_free(s->pages);
+    SDL_free(s->clusters);
+    SDL_free(s->groups);
+    SDL_free(s->materials);
+    SDL_free(s->group_want);
+    SDL_free(s->group_draw);
+    SDL_free(s->group_missing);
+    SDL_free(s->cluster_seen);
+    SDL_free(s->page_state);
+    SDL_free(s->page_slot);
+    SDL_free(s->page_wanted);
+    SDL_free(s->wants);
+    SDL_free(s->slot_page);
+    SDL_free(s->commands);
+    SDL_free(s->command_cluster);
+    SDL_free(s->cpu_pool);
+    residency_release(RESIDENCY_MODELS, s->cpu_bytes);
+    SDL_free(s);
+}
+
+static void free_slot(MeshletStream *s, Uint32 page)
+{
+    if (s->page_slot[page] != SLOT_NONE)
+        s->slot_page[s->page_slot[page]] = SLOT_NONE;
+    s->page_slot[page] = SLOT_NONE;
+}
+
+static void make_resident(MeshletStream *s, PageRead *read)
+{
+    s->page_state[read->page] = PAGE_RESIDENT;
+    s->stats.resident++;
+    s->stats.loaded++;
+    SDL_SetAtomicInt(&read->state, READ_FREE);
+}
+
+/* Pages read since the last update wait for their upload; without a
+   device they go straight into their slot */
+static void collect_reads(MeshletStream *s)
+{
+    for (int r = 0; r < MESHLET_MAX_READS; r++)
+    {
+        PageRead *read = &s->reads[r];
+        int state = SDL_GetAtomicInt(&read->state);
+        if (state == READ_FAILED)
+        {
+            SDL_Log("Meshlets: failed to read page %u of '%s'", read->page, s->path);
+            s->page_state[read->page] = PAGE_FAILED;
+            free_slot(s, read->page);
+            SDL_SetAtomicInt(&read->state, READ_FREE);
+        }
+        else if (state == READ_DONE && s->page_state[read->page] == PAGE_READING)
+        {
+            s->page_state[read->page] = PAGE_READ;
+            if (!s->device)
+            {
+                SDL_memcpy(s->cpu_pool + (size_t)s->page_slot[read->page] * MESHLET_PAGE_BYTES, read->bytes,
+                           MESHLET_PAGE_BYTES);
+                make_resident(s, read);
+            }
+        }
+    }
+}
+
+static bool sphere_visible(const float planes[6][4], const float center[3], float radius)
+{
+    for (int p = 0; p < 6; p++)
+    {
+        if (planes[p][0] * center[0] + planes[p][1] * center[1] + planes[p][2] * center[2] + planes[p][3] < -radius)
+            return false;
+    }
+    return true;
+}
+
+/* Frustum and normal cone; *pixels is the projected radius */
+static bool cluster_visible(const MeshletCluster *c, const float planes[6][4], const float eye[3], float pixel_scale,
+                            float *pixels)
+{
+    if (!sphere_visible(planes, c->center, c->radius))
+        return false;
+    float d[3] = {c->center[0] - eye[0], c->center[1] - eye[1], c->center[2] - eye[2]};
+    float dist = SDL_sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    if (d[0] * c->cone_axis[0] + d[1] * c->cone_axis[1] + d[2] * c->cone_axis[2] >= c->cone_cutoff * dist + c->radius)
+        return false;
+    *pixels = c->radius * pixel_scale / SDL_max(dist - c->radius, SDL_max(c->radius * 0.01f, 1e-6f));
+    return *pixels >= MESHLET_ERROR_PIXELS;
+}
+
+static int SDLCALL compare_wants(const void *a, const void *b)
+{
+    float pa = ((const PageWant *)a)->priority, pb = ((const PageWant *)b)->priority;
+    return pa > pb ? -1 : pa < pb ? 1 : 0;
+}
+
+/* A free slot, or the slot of the resident page wanted least recently,
+   unless this update wants that page too */
+static Uint32 take_slot(MeshletStream *s)
+{
+    Uint32 best = SLOT_NONE;
+    Uint64 oldest = s->update;
+    for (Uint32 i = 0; i < s->slot_count; i++)
+    {
+        Uint32 page = s->slot_page[i];
+        if (page == SLOT_NONE)
+            return i;
+        if (s->page_state[page] == PAGE_RESIDENT && s->page_wanted[page] < oldest)
+        {
+            oldest = s->page_wanted[page];
+            best = i;
+        }
+    }
+    if (best != SLOT_NONE)
+    {
+        Uint32 page = s->slot_page[best];
+        s->page_state[page] = PAGE_ABSENT;
+        free_slot(s, page);
+        s->stats.resident--;
+        s->stats.evicted++;
+    }
+    return best;
+}
+
+/* The most visible missing pages first, as far as read buffers and
+   evictable slots go */
+static void schedule_reads(MeshletStream *s)
+{
+    SDL_qsort(s->wants, s->want_count, sizeof(PageWant), compare_wants);
+    Uint32 next = 0;
+    bool full = false;
+    for (int r = 0; r < MESHLET_MAX_READS && next < s->want_count; r++)
+    {
+        PageRead *read = &s->reads[r];
+        if (SDL_GetAtomicInt(&read->state) != READ_FREE)
+            continue;
+        Uint32 slot = take_slot(s);
+        if (slot == SLOT_NONE)
+        {
+            full = true;
+            break;
+        }
+        Uint32 page = s->wants[next++].page;
+        s->page_slot[page] = slot;
+        s->slot_page[slot] = page;
+        s->page_state[page] = PAGE_READING;
+        read->page = page;
+        SDL_SetAtomicInt(&read->state, READ_BUSY);
+        parallel_submit(read_page_task, read);
+    }
+    s->stats.starved = full ? s->want_count - next : 0;
+}
+
+/* The coarsest level whose error, seen from the group's nearest point,
+   projects under MESHLET_ERROR_PIXELS */
+static Uint8 pick_level(const MeshletGroup *g, const float eye[3], float pixel_scale)
+{
+    float d[3] = {g->center[0] - eye[0], g->center[1] - eye[1], g->center[2] - eye[2]};
+    float dist = SDL_sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) - g->radius;
+    dist = SDL_max(dist, SDL_max(g->radius * 0.01f, 1e-6f));
+    Uint32 level = g->lod_count - 1;
+    while (level > 0 && g->lod_error[level] * pixel_scale / dist > MESHLET_ERROR_PIXELS)
+        level--;
+    return (Uint8)level;
+}
+
+void meshlet_stream_update(MeshletStream *s, const Mat4 *view_proj, const float eye[3], float pixel_scale)
+{
+    if (!s)
+        return;
+
+    s->update++;
+    collect_reads(s);
+
+    float planes[6][4];
+    mat4_frustum_planes(view_proj, planes);
+    Uint32 reduced = 0;
+    for (Uint32 g = 0; g < s->header.group_count; g++)
+    {
+        const MeshletGroup *group = &s->groups[g];
+        bool seen = sphere_visible(planes, group->center, group->radius);
+        s->group_want[g] = seen ? pick_level(group, eye, pixel_scale) : LEVEL_NONE;
+        s->group_missing[g] = 0;
+        reduced += seen && s->group_want[g] > 0;
+    }
+
+    /* Clusters of the wanted levels ask for their pages; those of coarser
+       levels only note which are missing, in case they have to stand in */
+    s->want_count = 0;
+    Uint32 visible = 0, waiting = 0;
+    for (Uint32 p = 0; p < s->header.page_count; p++)
+    {
+        const MeshletPage *page = &s->pages[p];
+        if (!sphere_visible(planes, page->center, page->radius))
+            continue;
+
+        bool resident = s->page_state[p] == PAGE_RESIDENT;
+        float priority = 0.0f;
+        for (Uint32 i = page->first_cluster; i < page->first_cluster + page->cluster_count; i++)
+        {
+            const MeshletCluster *c = &s->clusters[i];
+            Uint8 want = s->group_want[c->group];
+            float pixels;
+            s->cluster_seen[i] = c->lod >= want && cluster_visible(c, planes, eye, pixel_scale, &pixels);
+            if (!s->cluster_seen[i])
+                continue;
+            if (!resident)
+                s->group_missing[c->group] |= (Uint8)(1u << c->lod);
+            if (c->lod != want)
+                continue;
+            visible++;
+            waiting += !resident;
+            priority = SDL_max(priority, pixels);
+        }
+        if (priority == 0.0f)
+            continue;
+        s->page_wanted[p] = s->update;
+        if (s->page_state[p] == PAGE_ABSENT)
+            s->wants[s->want_count++] = (PageWant){priority, p};
+    }
+
+    /* Each group draws the finest level, from the wanted one on, that has
+       all its visible clusters resident; when none has, whatever of the
+       wanted level is */
+    Uint32 fallback = 0;
+    for (Uint32 g = 0; g < s->header.group_count; g++)
+    {
+        Uint8 want = s->group_want[g];
+        if (want == LEVEL_NONE)
+            continue;
+        Uint32 level = want;
+        while (level < s->groups[g].lod_count && (s->group_missing[g] & (1u << level)))
+            level++;
+        s->group_draw[g] = level < s->groups[g].lod_count ? (Uint8)level : want;
+        fallback += s->group_draw[g] != want;
+    }
+
+    s->command_count = 0;
+    for (Uint32 p = 0; p < s->header.page_count; p++)
+    {
+        const MeshletPage *page = &s->pages[p];
+        if (s->page_state[p] != PAGE_RESIDENT || !sphere_visible(planes, page->center, page->radius))
+            continue;
+        Uint32 slot = s->page_slot[p];
+        Uint32 first_command = s->command_count;
+        for (Uint32 i = page->first_cluster; i < page->first_cluster + page->cluster_count; i++)
+        {
+            const MeshletCluster *c = &s->clusters[i];
+            if (!s->cluster_seen[i] || c->lod != s->group_draw[c->group] || s->command_count == s->command_capacity)
+                continue;
+            SDL_GPUIndexedIndirectDrawCommand *cmd = &s->commands[s->command_count];
+            cmd->num_indices = c->triangle_count * 3u;
+            cmd->num_instances = 1;
+            cmd->first_index = slot * MESHLET_PAGE_INDICES + c->index_offset;
+            cmd->vertex_offset = (Sint32)(slot * MESHLET_PAGE_VERTICES + c->vertex_offset);
+            cmd->first_instance = c->material;
+            s->command_cluster[s->command_count++] = i;
+        }
+        /* Pages standing in for a finer level must not be evicted for it */
+        if (s->command_count > first_command)
+            s->page_wanted[p] = s->update;
+    }
+
+    schedule_reads(s);
+    s->stats.visible = visible;
+    s->stats.drawn = s->command_count;
+    s->stats.waiting = waiting;
+    s->stats.reduced = reduced;
+    s->stats.fallback = fallback;
+}
+
+void meshlet_stream_upload(MeshletStream *s, SDL_GPUCopyPass *cp)
+{
+    if (!s || !s->device || !cp)
+        return;
+
+    Uint32 command_bytes = s->command_count * (Uint32)sizeof(SDL_GPUIndexedIndirectDrawCommand);
+    Uint32 pages_offset = s->command_capacity * (Uint32)sizeof(SDL_GPUIndexedIndirectDrawCommand);
+    int pending = 0;
+    for (int r = 0; r < MESHLET_MAX_READS; r++)
+    {
+        PageRead *read = &s->reads[r];
+        pending += SDL_GetAtomicInt(&read->state) == READ_DONE && s->page_state[read->page] == PAGE_READ;
+    }
+    if (!command_bytes && !pending)
+        return;
+
+    Uint8 *map = SDL_MapGPUTransferBuffer(s->device, s->staging, true);
+    if (!map)
+        return;
+    SDL_memcpy(map, s->commands, command_bytes);
+    for (int r = 0; r < MESHLET_MAX_READS && pending; r++)
+    {
+        PageRead *read = &s->reads[r];
+        if (SDL_GetAtomicInt(&read->state) == READ_DONE && s->page_state[read->page] == PAGE_READ)
+            SDL_memcpy(map + pages_offset + r * MESHLET_PAGE_BYTES, read->bytes, MESHLET_PAGE_BYTES);
+    }
+    SDL_UnmapGPUTransferBuffer(s->device, s->staging);
+
+    if (command_bytes)
+    {
+        SDL_GPUTransferBufferLocation src = {s->staging, 0};
+        SDL_GPUBufferRegion dst = {s->command_buffer, 0, command_bytes};
+        SDL_UploadToGPUBuffer(cp, &src, &dst, true);
+    }
+    /* Other slots are still drawn from, so the pools must not cycle */
+    const Uint32 vertex_bytes = MESHLET_PAGE_VERTICES * (Uint32)sizeof(MeshletVertex);
+    const Uint32 index_bytes = MESHLET_PAGE_INDICES * (Uint32)sizeof(Uint32);
+    for (int r = 0; r < MESHLET_MAX_READS && pending; r++)
+    {
+        PageRead *read = &s->reads[r];
+        if (SDL_GetAtomicInt(&read->state) != READ_DONE || s->page_state[read->page] != PAGE_READ)
+            continue;
+        Uint32 slot = s->page_slot[read->page];
+        Uint32 offset = pages_offset + (Uint32)r * (Uint32)MESHLET_PAGE_BYTES;
+        SDL_GPUTransferBufferLocation vsrc = {s->staging, offset};
+        SDL_GPUBufferRegion vdst = {s->vertex_pool, slot * vertex_bytes, vertex_bytes};
+        SDL_UploadToGPUBuffer(cp, &vsrc, &vdst, false);
+        SDL_GPUTransferBufferLocation isrc = {s->staging, offset + vertex_bytes};
+        SDL_GPUBufferRegion idst = {s->index_pool, slot * index_bytes, index_bytes};
+        SDL_UploadToGPUBuffer(cp, &isrc, &idst, false);
+        make_resident(s, read);
+    }
+}
+
+void meshlet_stream_draw_buffers(const MeshletStream *s, SDL_GPUBuffer **vertices, SDL_GPUBuffer **indices,
+                                 SDL_GPUBuffer **commands, Uint32 *count)
+{
+    *vertices = s->vertex_pool;
+    *indices = s->index_pool;
+    *commands = s->command_buffer;
+    *count = s->command_count;
+}
+
+const float *meshlet_stream_materials(const MeshletStream *s, Uint32 *count)
+{
+    *count = s->header.material_count;
+    return s->materials;
+}
+
+void meshlet_stream_bounds(const MeshletStream *s, float min[3], float max[3])
+{
+    SDL_memcpy(min, s->header.bounds_min, 3 * sizeof(float));
+    SDL_memcpy(max, s->header.bounds_max, 3 * sizeof(float));
+}
+
+void meshlet_stream_stats(const MeshletStream *s, MeshletStreamStats *out)
+{
+    SDL_zerop(out);
+    if (!s)
+        return;
+    *out = s->stats;
+    for (int r = 0; r < MESHLET_MAX_READS; r++)
+        out->reading += SDL_GetAtomicInt((SDL_AtomicInt *)&s->reads[r].state) != READ_FREE;
+}
+
+bool meshlet_stream_drawn_cluster(const MeshletStream *s, Uint32 command, MeshletDrawnCluster *out)
+{
+    if (!s->cpu_pool || command >= s->command_count)
+        return false;
+    const MeshletCluster *c = &s->clusters[s->command_cluster[command]];
+    Uint32 slot = (Uint32)s->commands[command].vertex_offset / MESHLET_PAGE_VERTICES;
+    Uint8 *page = s->cpu_pool + (size_t)slot * MESHLET_PAGE_BYTES;
+    out->vertices = page_vertex_data(page) + c->vertex_offset;
+    out->vertex_count = c->vertex_count;
+    out->indices = page_index_data(page) + c->index_offset;
+    out->index_count = c->triangle_count * 3u;
+    SDL_memcpy(out->center, c->center, sizeof(out->center));
+    out->radius = c->radius;
+    return true;
+}
+
+/*================================================================================
+ * Benchmark
+ *================================================================================*/
+#define BENCH_TILE_QUADS 64
+#define BENCH_TILE_SIZE 64.0f
+#define BENCH_TILES_PER_ROW 16
+
+static float terrain_height(float x, float z)
+{
+    return 6.0f * SDL_sinf(x * 0.05f) * SDL_cosf(z * 0.043f) + 2.0f * SDL_sinf(x * 0.21f + z * 0.17f);
+}
+
+bool meshlet_cook_terrain(const char *path, size_t bytes)
+{
+    const Uint32 side = BENCH_TILE_QUADS + 1;
+    const float white[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    /* Far more rows than it takes */
+    const float min[3] = {0.0f, -8.0f, 0.0f};
+    const float max[3] = {BENCH_TILES_PER_ROW * BENCH_TILE_SIZE, 8.0f, 64.0f * BENCH_TILE_SIZE};
+    MeshletVertex *vertices = SDL_malloc(side * side * sizeof(MeshletVertex));
+    Uint32 *indices = SDL_malloc(BENCH_TILE_QUADS * BENCH_TILE_QUADS * 6 * sizeof(Uint32));
+    Cooker c;
+    bool ok = vertices && indices && cooker_begin(&c, path, white, 1, position_step(min, max));
+    bool started = ok;
+
+    for (Uint32 z = 0, n = 0; ok && z < BENCH_TILE_QUADS; z++)
+    {
+        for (Uint32 x = 0; x < BENCH_TILE_QUADS; x++)
+        {
+            Uint32 v = z * side + x;
+            Uint32 quad[6] = {v, v + side, v + 1, v + 1, v + side, v + side + 1};
+            SDL_memcpy(&indices[n], quad, sizeof(quad));
+            n += 6;
+        }
+    }
+
+    Uint32 tile = 0;
+    const float step = BENCH_TILE_SIZE / BENCH_TILE_QUADS;
+    for (; ok && c.page_bytes < bytes; tile++)
+    {
+        float x0 = (float)(tile % BENCH_TILES_PER_ROW) * BENCH_TILE_SIZE;
+        float z0 = (float)(tile / BENCH_TILES_PER_ROW) * BENCH_TILE_SIZE;
+        for (Uint32 i = 0; i < side * side; i++)
+        {
+            float x = x0 + (float)(i % side) * step, z = z0 + (float)(i / side) * step;
+            float dx = terrain_height(x + 0.5f, z) - terrain_height(x - 0.5f, z);
+            float dz = terrain_height(x, z + 0.5f) - terrain_height(x, z - 0.5f);
+            float len = SDL_sqrtf(dx * dx + 1.0f + dz * dz);
+            vertices[i] = (MeshletVertex){{x, terrain_height(x, z), z}, {-dx / len, 1.0f / len, -dz / len},
+                                          {(float)(i % side) / BENCH_TILE_QUADS, (float)(i / side) / BENCH_TILE_QUADS}};
+        }
+        ok = cooker_add(&c, vertices, side * side, indices, BENCH_TILE_QUADS * BENCH_TILE_QUADS * 6, 0);
+    }
+
+    if (started)
+    {
+        ok = cooker_finish(&c) && ok;
+        cooker_free(&c);
+    }
+    SDL_free(vertices);
+    SDL_free(indices);
+    return ok;
+}
+
+void meshlet_stream_benchmark(size_t memory_cap)
+{
+    char *dir = SDL_GetPrefPath("arda", "cumulus");
+    char *path = NULL;
+    if (!dir || SDL_asprintf(&path, "%sbench.meshlets", dir) < 0)
+    {
+        SDL_free(dir);
+        return;
+    }
+    SDL_free(dir);
+
+    Uint64 start = bench_now();
+    MeshletStream *s = meshlet_cook_terrain(path, memory_cap * 4) ? meshlet_stream_open(NULL, path, memory_cap) : NULL;
+    double cook_ms = bench_ms_since(start);
+    if (!s)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Meshlet streaming benchmark: could not cook or open '%s'", path);
+        SDL_RemovePath(path);
+        SDL_free(path);
+        return;
+    }
+
+    /* Low over the terrain, looking ahead and down, corner to corner */
+    Mat4 proj, view, vp;
+    mat4_perspective(&proj, 60.0f * SDL_PI_F / 180.0f, 16.0f / 9.0f, 0.5f, 300.0f);
+    const float pixel_scale = 1080.0f / (2.0f * SDL_tanf(30.0f * SDL_PI_F / 180.0f));
+    const float up[3] = {0.0f, 1.0f, 0.0f};
+    float min[3], max[3];
+    meshlet_stream_bounds(s, min, max);
+    const float far_x = max[0], far_z = max[2];
+    const int waypoints = 16, flight = 240;
+
+    Uint32 settled = 0, starved = 0, max_updates = 0;
+    double update_ms = 0.0, coverage = 0.0, reduced = 0.0, fallback = 0.0;
+    Uint32 updates = 0;
+    for (int i = 0; i < waypoints + flight; i++)
+    {
+        /* Waypoints wait for every read; the flight afterwards does not */
+        bool waypoint = i < waypoints;
+        float t = waypoint ? (float)i / (waypoints - 1) : (float)(i - waypoints) / (flight - 1);
+        float eye[3] = {far_x * (0.1f + 0.8f * t), 40.0f, far_z * (0.1f + 0.8f * t)};
+        float target[3] = {eye[0] + 60.0f, 0.0f, eye[2] + 60.0f};
+        mat4_look_at(&view, eye, target, up);
+        mat4_mul(&vp, &proj, &view);
+
+        Uint32 n = 0;
+        do
+        {
+            Uint64 t0 = bench_now();
+            meshlet_stream_update(s, &vp, eye, pixel_scale);
+            update_ms += bench_ms_since(t0);
+            updates++;
+            n++;
+            if (waypoint)
+                meshlet_stream_wait(s);
+        } while (waypoint && s->want_count > 0 && !s->stats.starved && n < 1000);
+        max_updates = SDL_max(max_updates, n);
+
+        if (waypoint)
+        {
+            if (s->stats.starved)
+                starved++;
+            else if (s->stats.waiting == 0 && s->stats.drawn == s->stats.visible)
+                settled++;
+        }
+        else
+        {
+            const MeshletStreamStats *st = &s->stats;
+            coverage += st->visible ? (double)(st->visible - st->waiting) / st->visible : 1.0;
+            reduced += st->reduced;
+            fallback += st->fallback;
+        }
+    }
+    meshlet_stream_wait(s);
+
+    const double mb = 1024.0 * 1024.0;
+    MeshletStreamStats stats = s->stats;
+    SDL_Log("Meshlet streaming (%.1f MB of packed pages, %.1fx the %.1f MB cap, %u clusters in %u groups, cooked "
+            "in %.0f ms): %u of %d waypoints fully resident (%u short of slots, at most %u updates), %.1f%% of "
+            "visible clusters resident in flight, %.1f groups at reduced detail and %.1f standing in per update, "
+            "%llu pages read, %llu evicted, %.3f ms per update, %.1f MB used",
+            (double)stats.file_bytes / mb, (double)stats.file_bytes / (double)memory_cap, (double)memory_cap / mb,
+            stats.clusters, stats.groups, cook_ms, settled, waypoints, starved, max_updates,
+            100.0 * coverage / flight, reduced / flight, fallback / flight, (unsigned long long)stats.loaded,
+            (unsigned long long)stats.evicted, update_ms / updates, (double)stats.memory_bytes / mb);
+
+    meshlet_stream_close(s);
+    SDL_RemovePath(path);
+    SDL_free(path);
+}
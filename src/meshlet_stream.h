@@ -0,0 +1,154 @@
+#ifndef CUMULUS_MESHLET_STREAM_H
+#define CUMULUS_MESHLET_STREAM_H
+
+#include "vecmath.h"
+#include <SDL3/SDL.h>
+
+/* Out-of-core geometry for models larger than memory.
+
+   meshlet_cook welds a glTF's triangles, in world space, and cuts them
+   into groups of about MESHLET_GROUP_TRIANGLES nearby triangles. Each
+   group is simplified into up to MESHLET_MAX_LODS levels of detail with
+   its border locked, so neighbouring groups meet without cracks at any
+   mix of levels, and every level is split into clusters of at most
+   MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES triangles with
+   a bounding sphere and a normal cone each. Clusters are packed into
+   pages of a .meshlets file with positions on a lattice shared by the
+   whole file, octahedral normals and 8-bit indices. Cooking holds one
+   primitive at a time: the bytes of external buffers are read per
+   accessor on demand.
+
+   A stream keeps only the page, cluster and group tables in memory. Each
+   update picks per group the coarsest level whose error projects under
+   MESHLET_ERROR_PIXELS, then culls pages, then their clusters, against
+   the view; a visible cluster whose page is not resident requests it,
+   with its projected radius in pixels as the priority, and clusters under
+   MESHLET_ERROR_PIXELS are left out altogether. Until a level's pages are
+   in, the finest coarser level that is resident is drawn instead. Pages
+   are read and unpacked on worker threads into a few read buffers and
+   copied into a fixed pool of page slots, on the GPU with a device and in
+   memory without one, evicting the page wanted least recently.
+   Everything is allocated when the stream opens, within the memory cap it
+   is given. */
+typedef struct MeshletStream MeshletStream;
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+#define MESHLET_PAGE_VERTICES 2048
+#define MESHLET_PAGE_INDICES (MESHLET_PAGE_VERTICES * 6)
+#define MESHLET_PAGE_BYTES (MESHLET_PAGE_VERTICES * sizeof(MeshletVertex) + MESHLET_PAGE_INDICES * sizeof(Uint32))
+#define MESHLET_ERROR_PIXELS 1.0f
+#define MESHLET_GROUP_TRIANGLES 8192
+#define MESHLET_MAX_LODS 4
+
+/* Bumped whenever cooked files change, so they are cooked again */
+#define MESHLET_FILE_VERSION 2
+
+/* Same layout as the mesh renderer's vertices */
+typedef struct MeshletVertex
+{
+    float position[3];
+    float normal[3];
+    float uv[2];
+} MeshletVertex;
+
+typedef struct MeshletStreamStats
+{
+    Uint32 clusters;
+    Uint32 groups;
+    Uint32 pages;
+    Uint32 slots;        /* pages that fit the pool */
+    Uint32 resident;     /* pages in the pool */
+    Uint32 reading;      /* page reads in flight or waiting for upload */
+    Uint32 visible;      /* clusters of the wanted levels that passed culling in the last update */
+    Uint32 drawn;        /* draw commands, from the wanted levels or coarser stand-ins */
+    Uint32 waiting;      /* visible clusters whose page is not resident */
+    Uint32 reduced;      /* visible groups wanted below full detail */
+    Uint32 fallback;     /* visible groups drawn at a coarser level while theirs streams in */
+    Uint32 starved;      /* wanted pages the last update found no slot for */
+    Uint64 loaded;       /* pages read since the stream opened */
+    Uint64 evicted;
+    size_t memory_bytes; /* everything the stream allocated, CPU and GPU */
+    size_t file_bytes;   /* the pages on disk */
+} MeshletStreamStats;
+
+typedef struct MeshletCookStats
+{
+    Uint64 triangles;     /* at full detail */
+    Uint64 lod_triangles; /* in the coarser levels */
+    Uint32 clusters;
+    Uint32 groups;
+    Uint32 pages;
+    Uint64 file_bytes;
+} MeshletCookStats;
+
+/* Cook `gltf_path` into `out_path`, unless out_path is newer already and
+   of this version */
+bool meshlet_cook(const char *gltf_path, const char *out_path);
+
+/* Cook unconditionally, through a temporary file renamed over out_path on
+   success. Safe to call from several threads at once. `stats` may be NULL. */
+bool meshlet_cook_file(const char *gltf_path, const char *out_path, MeshletCookStats *stats);
+
+/* The files cooking `gltf_path` reads: the glTF itself first, then its
+   external buffers. One allocation; free it with SDL_free. */
+char **meshlet_cook_dependencies(const char *gltf_path, int *count);
+
+/* Open a cooked file, spending at most `memory_cap` bytes on it. The page
+   pool is on the GPU when `device` is not NULL. */
+MeshletStream *meshlet_stream_open(SDL_GPUDevice *device, const char *path, size_t memory_cap);
+
+/* Waits for reads in flight */
+void meshlet_stream_close(MeshletStream *stream);
+
+/* Cull for this view, build the draw commands of the visible resident
+   clusters and start reading the pages missing ones need. `pixel_scale`
+   is the viewport height in pixels over 2 tan(fovy / 2). */
+void meshlet_stream_update(MeshletStream *stream, const Mat4 *view_proj, const float eye[3], float pixel_scale);
+
+/* Record the upload of pages read since the last call and of the draw
+   commands into copy_pass. Uploaded pages are drawn from the next update. */
+void meshlet_stream_upload(MeshletStream *stream, SDL_GPUCopyPass *copy_pass);
+
+/* The pool's vertex and index buffers and `*count` indexed indirect
+   commands, whose first_instance is the cluster's material */
+void meshlet_stream_draw_buffers(const MeshletStream *stream, SDL_GPUBuffer **vertices, SDL_GPUBuffer **indices,
+                                 SDL_GPUBuffer **commands, Uint32 *count);
+
+/* Base color (RGBA) per material */
+const float *meshlet_stream_materials(const MeshletStream *stream, Uint32 *count);
+
+void meshlet_stream_bounds(const MeshletStream *stream, float min[3], float max[3]);
+
+/* Block until no read is in flight */
+void meshlet_stream_wait(MeshletStream *stream);
+
+void meshlet_stream_stats(const MeshletStream *stream, MeshletStreamStats *out);
+
+/* A drawn cluster as the GPU reads it: its vertices and indices where its
+   draw command points into the page pool, and its bounding sphere */
+typedef struct MeshletDrawnCluster
+{
+    const MeshletVertex *vertices;
+    Uint32 vertex_count;
+    const Uint32 *indices; /* relative to vertices */
+    Uint32 index_count;
+    float center[3];
+    float radius;
+} MeshletDrawnCluster;
+
+/* Draw command `command` of the last update. Only streams opened without
+   a device keep their pages in memory; false for the others and past the
+   last command. */
+bool meshlet_stream_drawn_cluster(const MeshletStream *stream, Uint32 command, MeshletDrawnCluster *out);
+
+/* Cook a synthetic heightfield terrain into `path`: square tiles in rows
+   along x, added until the packed pages reach `bytes` */
+bool meshlet_cook_terrain(const char *path, size_t bytes);
+
+/* Cooks a synthetic terrain whose packed pages are four times larger than
+   `memory_cap`, streams it on the CPU along a camera path and logs how
+   much stayed resident and what the updates cost */
+void meshlet_stream_benchmark(size_t memory_cap);
+
+#endif /* CUMULUS_MESHLET_STREAM_H */
@@ -1,12 +1,26 @@
 /*
  * microui SDL3 GPU Backend
  *
+ * Layout and input are in UI units: window pixels divided by the window's
+ * display scale, so the UI keeps its size on HiDPI displays. Text is
+ * rasterized at the display scale from a glyph atlas built per scale.
+ *
+ * Any number of windows claimed on one device can each carry a mu_Context.
+ * The pipeline, textures and glyph atlases are shared; each window has its
+ * own quad buffers and display scale. A context can also draw into an
+ * offscreen texture of a given size and scale, with no window at all.
+ *
  * Usage:
- *   1. mu_sdl3_gpu_init(device, window, render_format, &mu_ctx);
- *   2. In event loop: mu_sdl3_gpu_handle_event(event, mu_ctx);
+ *   1. mu_sdl3_gpu_init(device, color_format, pipelines);
+ *      win = mu_sdl3_gpu_add_window(window, &mu_ctx);   per window
+ *      or mu_sdl3_gpu_add_target(&mu_ctx, w, h, scale) for an offscreen one
+ *   2. In event loop: mu_sdl3_gpu_handle_event(event);  routed by window
  *   3. In render loop:
- *        mu_sdl3_gpu_render(cmd_buf, render_pass, mu_ctx);
- *   4. mu_sdl3_gpu_shutdown();
+ *        mu_sdl3_gpu_prepare(win);           per window, before any pass
+ *        mu_sdl3_gpu_copy(copy_pass);        once, for every window
+ *        mu_sdl3_gpu_render(cmd_buf, render_pass, win);
+ *      or mu_sdl3_gpu_upload(cmd_buf, win) for the first two in its own copy pass
+ *   4. mu_sdl3_gpu_remove_window(win); mu_sdl3_gpu_shutdown();
  */
 
 #ifndef MU_SDL3_GPU_H
@@ -16,9 +30,22 @@
 #include <stdio.h>
 #include <string.h>
 // #include <math.h>
+#include "frame_arena.h"
+#include "glyph_cache.h"
 #include "microui.h"
+#include "pipeline_cache.h"
+#include "residency.h"
 #include <SDL3/SDL.h>
 
+#define MU_UI_FONT_PX 16.0f
+#define MU_MAX_SCALES 4
+#define MU_MAX_WINDOWS 8
+
+#ifdef CUMULUS_HAVE_SPIRV
+#include "microui_frag.spv.h"
+#include "microui_vert.spv.h"
+#endif
+
 /*================================================================================
  * Embedded 8x13 bitmap font (ASCII 32-126)
  * Public domain, originally from misc-fixed
@@ -246,11 +273,42 @@ typedef struct
 /*================================================================================
  * Device context
  *================================================================================*/
+typedef struct MuSDL3GPU_Window
+{
+    SDL_Window *window; /* NULL for an offscreen target */
+    mu_Context *ctx;
+    Uint32 width, height; /* offscreen target size in pixels */
+
+    GlyphCache *glyphs; /* TrueType text at this window's scale; NULL: bitmap font */
+    float glyph_scale;  /* scale `glyphs` was built for, the old one while every atlas is in use */
+    float scale;        /* UI units to pixels */
+    float input_scale;  /* window coordinates to UI units */
+
+    /* quads of the last prepare */
+    SDL_GPUBuffer *vertex_buffer;
+    SDL_GPUBuffer *index_buffer;
+    Uint32 vertex_buffer_capacity;
+    Uint32 index_buffer_capacity;
+    Uint32 index_count;
+    Uint32 rect_index_count;
+    Uint32 font_index_end; /* TrueType text follows, drawn from the glyph atlas */
+
+    /* staged by mu_sdl3_gpu_prepare, recorded by mu_sdl3_gpu_copy; the
+       transfer buffer is kept and cycled, so steady frames allocate nothing */
+    SDL_GPUTransferBuffer *upload;
+    Uint32 upload_capacity;
+    Uint32 upload_vbytes;
+    Uint32 upload_ibytes;
+    bool upload_pending;
+} MuSDL3GPU_Window;
+
 typedef struct MuSDL3GPU_Device
 {
     SDL_GPUDevice *device;
-    SDL_Window *window;
+    SDL_GPUTextureFormat color_format; /* every target's, swapchain or offscreen */
 
+    /* Owned by the pipeline cache */
+    PipelineCache *pipelines;
     SDL_GPUShader *vertex_shader;
     SDL_GPUShader *fragment_shader;
     SDL_GPUGraphicsPipeline *pipeline;
@@ -259,20 +317,18 @@ typedef struct MuSDL3GPU_Device
     SDL_GPUTexture *icon_texture;
     SDL_GPUSampler *sampler;
     SDL_GPUTexture *white_texture;
+    GlyphCache *glyph_scales[MU_MAX_SCALES]; /* every atlas built so far, one per scale */
+    Uint32 glyph_scale_count;
+    bool font_missing;
 
-    /* dynamic quad buffer */
-    SDL_GPUBuffer *vertex_buffer;
-    SDL_GPUBuffer *index_buffer;
-    Uint32 vertex_buffer_capacity;
-    Uint32 index_buffer_capacity;
+    MuSDL3GPU_Window *windows[MU_MAX_WINDOWS];
+    Uint32 window_count;
+
+    /* quads being built by mu_sdl3_gpu_prepare, in the frame arena */
     Uint32 vertex_count;
     Uint32 index_count;
-    Uint32 rect_index_count;
-
     MuVertex *vertex_data;
     Uint16 *index_data;
-    Uint32 vertex_data_cap;
-    Uint32 index_data_cap;
     int font_glyph_h;
     int font_glyph_w;
 } MuSDL3GPU_Device;
@@ -280,7 +336,8 @@ typedef struct MuSDL3GPU_Device
 static MuSDL3GPU_Device mu_gpu;
 
 /*================================================================================
- * MSL Shaders (Metal Shading Language) — works on Apple Silicon
+ * MSL Shaders (Metal Shading Language) — works on Apple Silicon. Vulkan uses
+ * the SPIR-V built from shaders/microui.{vert,frag}.
  *================================================================================*/
 static const char *mu_msl_vert = "#include <metal_stdlib>\n"
                                  "using namespace metal;\n"
@@ -321,33 +378,29 @@ static const char *mu_msl_frag = "#include <metal_stdlib>\n"
 /*================================================================================
  * Quad accumulation helpers
  *================================================================================*/
-static void mu_ensure_vertex_cap(int needed)
+/* Room for every quad the context's commands can produce: one per RECT
+   and ICON, at most one per byte of TEXT */
+static Uint32 mu_count_quads(mu_Context *ctx)
 {
-    if (mu_gpu.vertex_data_cap < (Uint32)needed)
-    {
-        mu_gpu.vertex_data_cap = (Uint32)needed * 2;
-        mu_gpu.vertex_data = SDL_realloc(mu_gpu.vertex_data, mu_gpu.vertex_data_cap * sizeof(MuVertex));
-    }
-}
-
-static void mu_ensure_index_cap(int needed)
-{
-    if (mu_gpu.index_data_cap < (Uint32)needed)
+    Uint32 quads = 0;
+    mu_Command *cmd = NULL;
+    while (mu_next_command(ctx, &cmd))
     {
-        mu_gpu.index_data_cap = (Uint32)needed * 2;
-        mu_gpu.index_data = SDL_realloc(mu_gpu.index_data, mu_gpu.index_data_cap * sizeof(Uint16));
+        if (cmd->type == MU_COMMAND_RECT || cmd->type == MU_COMMAND_ICON)
+            quads++;
+        else if (cmd->type == MU_COMMAND_TEXT)
+            quads += (Uint32)strlen(cmd->text.str);
     }
+    return quads;
 }
 
+/* Caller guarantees room: see mu_count_quads */
 static void mu_push_quad(float x1, float y1, float x2, float y2, float u1, float v1, float u2, float v2, Uint8 r,
                          Uint8 g, Uint8 b, Uint8 a)
 {
     int vi = mu_gpu.vertex_count;
     int ii = mu_gpu.index_count;
 
-    mu_ensure_vertex_cap(vi + 4);
-    mu_ensure_index_cap(ii + 6);
-
     MuVertex *v = &mu_gpu.vertex_data[vi];
     v[0].position[0] = x1;
     v[0].position[1] = y1;
@@ -399,9 +452,12 @@ static void mu_push_quad(float x1, float y1, float x2, float y2, float u1, float
 /*================================================================================
  * Font callbacks for microui
  *================================================================================*/
+/* Each context's font is its window, which knows the scale */
 static int mu_text_width_cb(mu_Font font, const char *str, int len)
 {
-    (void)font;
+    const MuSDL3GPU_Window *win = font;
+    if (win->glyphs)
+        return (int)((float)glyph_cache_text_width(win->glyphs, str, len) / win->glyph_scale + 0.5f);
     if (len < 0)
         len = (int)strlen(str);
     return len * MU_FONT_GLYPH_W;
@@ -409,8 +465,38 @@ static int mu_text_width_cb(mu_Font font, const char *str, int len)
 
 static int mu_text_height_cb(mu_Font font)
 {
-    (void)font;
-    return MU_FONT_GLYPH_H;
+    const MuSDL3GPU_Window *win = font;
+    return win->glyphs ? (int)SDL_ceilf((float)glyph_cache_line_height(win->glyphs) / win->glyph_scale)
+                       : MU_FONT_GLYPH_H;
+}
+
+/* Lay out one TEXT command from the glyph atlas, advancing in the same
+   fixed point as glyph_cache_text_width. Glyphs are placed on whole
+   pixels, then converted back to UI units. */
+static void mu_push_glyph_text(const MuSDL3GPU_Window *win, const char *str, int x, int y, mu_Color c)
+{
+    GlyphCache *glyphs = win->glyphs;
+    float atlas = (float)glyph_cache_atlas_size(glyphs);
+    float inv_scale = 1.0f / win->glyph_scale;
+    int origin = (int)((float)x * win->glyph_scale + 0.5f);
+    int baseline = (int)((float)y * win->glyph_scale + 0.5f) + glyph_cache_ascent(glyphs);
+    size_t left = strlen(str);
+    Uint32 pen = 0;
+    while (left > 0)
+    {
+        Uint32 codepoint = SDL_StepUTF8(&str, &left);
+        if (codepoint == 0)
+            break;
+        const GlyphCacheGlyph *g = glyph_cache_glyph(glyphs, codepoint);
+        if (g && g->w > 0)
+        {
+            int gx = origin + (int)((pen + GLYPH_CACHE_SUBPIXELS / 2) / GLYPH_CACHE_SUBPIXELS) + g->xoff;
+            int gy = baseline + g->yoff;
+            mu_push_quad(gx * inv_scale, gy * inv_scale, (gx + g->w) * inv_scale, (gy + g->h) * inv_scale, g->x / atlas,
+                         g->y / atlas, (g->x + g->w) / atlas, (g->y + g->h) / atlas, c.r, c.g, c.b, c.a);
+        }
+        pen += glyph_cache_advance(glyphs, codepoint);
+    }
 }
 
 /*================================================================================
@@ -418,11 +504,19 @@ static int mu_text_height_cb(mu_Font font)
  *================================================================================*/
 static int mu_textures_uploaded = 0;
 
-static void mu_upload_textures(SDL_GPUCommandBuffer *cmd)
+static void mu_upload_textures(SDL_GPUCopyPass *cp)
 {
     /* Build pixel data */
     int font_pitch = MU_FONT_TEX_W * 4;
-    Uint8 *font_pixels = SDL_calloc(1, MU_FONT_TEX_H * font_pitch);
+    int icon_pitch = MU_ICON_TEX_W * 4;
+    Uint8 *font_pixels = frame_alloc(MU_FONT_TEX_H * font_pitch);
+    Uint8 *icon_pixels = frame_alloc(MU_ICON_TEX_H * icon_pitch);
+    if (!font_pixels || !icon_pixels)
+    {
+        SDL_Log("microui: no frame memory for the atlas upload, retrying next frame");
+        return;
+    }
+    SDL_memset(font_pixels, 0, MU_FONT_TEX_H * font_pitch);
     for (int ci = 0; ci < MU_FONT_NUM_CHARS; ci++)
     {
         int gx = (ci % MU_FONT_GRID_COLS) * MU_FONT_GLYPH_W;
@@ -442,8 +536,7 @@ static void mu_upload_textures(SDL_GPUCommandBuffer *cmd)
         }
     }
 
-    int icon_pitch = MU_ICON_TEX_W * 4;
-    Uint8 *icon_pixels = SDL_calloc(1, MU_ICON_TEX_H * icon_pitch);
+    SDL_memset(icon_pixels, 0, MU_ICON_TEX_H * icon_pitch);
     for (int r = 0; r < MU_ICON_SIZE; r++)
     {
         int px = 2 + r, py = 2 + r;
@@ -490,18 +583,14 @@ static void mu_upload_textures(SDL_GPUCommandBuffer *cmd)
     SDL_zero(tb_info);
     tb_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
     tb_info.size = total;
-    SDL_GPUTransferBuffer *tbuf = SDL_CreateGPUTransferBuffer(mu_gpu.device, &tb_info);
+    SDL_GPUTransferBuffer *tbuf = residency_create_transfer_buffer(mu_gpu.device, &tb_info, RESIDENCY_STAGING);
     Uint8 *map = SDL_MapGPUTransferBuffer(mu_gpu.device, tbuf, false);
     SDL_memcpy(map, font_pixels, font_size);
     SDL_memcpy(map + font_size, icon_pixels, icon_size);
     SDL_memcpy(map + font_size + icon_size, white_pixel, 4);
     SDL_UnmapGPUTransferBuffer(mu_gpu.device, tbuf);
-    SDL_free(font_pixels);
-    SDL_free(icon_pixels);
-
-    /* Upload using caller's command buffer */
-    SDL_GPUCopyPass *cp = SDL_BeginGPUCopyPass(cmd);
 
+    /* Upload in the caller's copy pass */
     SDL_GPUTextureTransferInfo src;
     SDL_GPUTextureRegion dst;
 
@@ -539,45 +628,64 @@ static void mu_upload_textures(SDL_GPUCommandBuffer *cmd)
     dst.d = 1;
     SDL_UploadToGPUTexture(cp, &src, &dst, false);
 
-    SDL_EndGPUCopyPass(cp);
-    SDL_ReleaseGPUTransferBuffer(mu_gpu.device, tbuf);
+    residency_release_transfer_buffer(mu_gpu.device, tbuf);
 
     mu_textures_uploaded = 1;
 }
 
+/* SPIR-V when it was built and the driver takes it, else MSL */
+static bool mu_shader_info(SDL_GPUShaderCreateInfo *info, SDL_GPUShaderStage stage)
+{
+    SDL_GPUShaderFormat formats = SDL_GetGPUShaderFormats(mu_gpu.device);
+    bool vertex = stage == SDL_GPU_SHADERSTAGE_VERTEX;
+    SDL_zerop(info);
+    info->stage = stage;
+    info->num_uniform_buffers = vertex ? 1 : 0;
+    info->num_samplers = vertex ? 0 : 1;
+#ifdef CUMULUS_HAVE_SPIRV
+    if (formats & SDL_GPU_SHADERFORMAT_SPIRV)
+    {
+        info->format = SDL_GPU_SHADERFORMAT_SPIRV;
+        info->code = vertex ? microui_vert_spv : microui_frag_spv;
+        info->code_size = vertex ? sizeof(microui_vert_spv) : sizeof(microui_frag_spv);
+        info->entrypoint = "main";
+        return true;
+    }
+#endif
+    if (formats & SDL_GPU_SHADERFORMAT_MSL)
+    {
+        const char *src = vertex ? mu_msl_vert : mu_msl_frag;
+        info->format = SDL_GPU_SHADERFORMAT_MSL;
+        info->code = (const Uint8 *)src;
+        info->code_size = SDL_strlen(src);
+        info->entrypoint = "main0";
+        return true;
+    }
+    SDL_Log("microui: no shipped shader format for the %s driver", SDL_GetGPUDeviceDriver(mu_gpu.device));
+    return false;
+}
+
 static MuSDL3GPU_Device *mu_sdl3_gpu_device_create(void)
 {
     SDL_GPUShaderCreateInfo shader_info;
-    SDL_zero(shader_info);
 
     /* Vertex shader */
-    shader_info.stage = SDL_GPU_SHADERSTAGE_VERTEX;
-    shader_info.format = SDL_GPU_SHADERFORMAT_MSL;
-    shader_info.code = (const Uint8 *)mu_msl_vert;
-    shader_info.code_size = SDL_strlen(mu_msl_vert);
-    shader_info.entrypoint = "main0";
-    shader_info.num_uniform_buffers = 1;
-
-    mu_gpu.vertex_shader = SDL_CreateGPUShader(mu_gpu.device, &shader_info);
+    if (!mu_shader_info(&shader_info, SDL_GPU_SHADERSTAGE_VERTEX))
+        return NULL;
+    mu_gpu.vertex_shader = pipeline_cache_shader(mu_gpu.pipelines, &shader_info);
     if (!mu_gpu.vertex_shader)
     {
-        SDL_Log("Failed to create vertex shader: %s", SDL_GetError());
+        SDL_Log("Failed to create vertex shader");
         return NULL;
     }
 
     /* Fragment shader */
-    shader_info.stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
-    shader_info.format = SDL_GPU_SHADERFORMAT_MSL;
-    shader_info.code = (const Uint8 *)mu_msl_frag;
-    shader_info.code_size = SDL_strlen(mu_msl_frag);
-    shader_info.entrypoint = "main0";
-    shader_info.num_samplers = 1;
-    shader_info.num_uniform_buffers = 0;
-
-    mu_gpu.fragment_shader = SDL_CreateGPUShader(mu_gpu.device, &shader_info);
+    if (!mu_shader_info(&shader_info, SDL_GPU_SHADERSTAGE_FRAGMENT))
+        return NULL;
+    mu_gpu.fragment_shader = pipeline_cache_shader(mu_gpu.pipelines, &shader_info);
     if (!mu_gpu.fragment_shader)
     {
-        SDL_Log("Failed to create fragment shader: %s", SDL_GetError());
+        SDL_Log("Failed to create fragment shader");
         return NULL;
     }
 
@@ -616,7 +724,7 @@ static MuSDL3GPU_Device *mu_sdl3_gpu_device_create(void)
 
     SDL_GPUColorTargetDescription target_desc;
     SDL_zero(target_desc);
-    target_desc.format = SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM;
+    target_desc.format = mu_gpu.color_format;
     target_desc.blend_state.enable_blend = true;
     target_desc.blend_state.src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA;
     target_desc.blend_state.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
@@ -628,10 +736,10 @@ static MuSDL3GPU_Device *mu_sdl3_gpu_device_create(void)
     pipeline_info.target_info.num_color_targets = 1;
     pipeline_info.target_info.color_target_descriptions = &target_desc;
 
-    mu_gpu.pipeline = SDL_CreateGPUGraphicsPipeline(mu_gpu.device, &pipeline_info);
+    mu_gpu.pipeline = pipeline_cache_graphics(mu_gpu.pipelines, &pipeline_info);
     if (!mu_gpu.pipeline)
     {
-        SDL_Log("Failed to create pipeline: %s", SDL_GetError());
+        SDL_Log("Failed to create pipeline");
         return NULL;
     }
 
@@ -658,57 +766,249 @@ static MuSDL3GPU_Device *mu_sdl3_gpu_device_create(void)
         info.layer_count_or_depth = 1;
         info.num_levels = 1;
         info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
-        mu_gpu.font_texture = SDL_CreateGPUTexture(mu_gpu.device, &info);
+        mu_gpu.font_texture = residency_create_texture(mu_gpu.device, &info, RESIDENCY_UI);
 
         info.width = MU_ICON_TEX_W;
         info.height = MU_ICON_TEX_H;
-        mu_gpu.icon_texture = SDL_CreateGPUTexture(mu_gpu.device, &info);
+        mu_gpu.icon_texture = residency_create_texture(mu_gpu.device, &info, RESIDENCY_UI);
 
         info.width = 1;
         info.height = 1;
-        mu_gpu.white_texture = SDL_CreateGPUTexture(mu_gpu.device, &info);
+        mu_gpu.white_texture = residency_create_texture(mu_gpu.device, &info, RESIDENCY_UI);
     }
 
     return &mu_gpu;
 }
 
+/*================================================================================
+ * Display scale
+ *================================================================================*/
+
+static bool mu_glyphs_in_use(const GlyphCache *glyphs)
+{
+    for (Uint32 i = 0; i < mu_gpu.window_count; i++)
+    {
+        if (mu_gpu.windows[i]->glyphs == glyphs)
+            return true;
+    }
+    return false;
+}
+
+/* The atlas for `scale`, built and filled with ASCII the first time that
+   scale is seen; later switches back to it cost nothing. NULL when every
+   atlas is still drawn with: the caller keeps the one it has. */
+static GlyphCache *mu_glyphs_for_scale(float scale)
+{
+    float px = MU_UI_FONT_PX * scale;
+    for (Uint32 i = 0; i < mu_gpu.glyph_scale_count; i++)
+    {
+        if (glyph_cache_pixel_height(mu_gpu.glyph_scales[i]) == px)
+            return mu_gpu.glyph_scales[i];
+    }
+    if (mu_gpu.font_missing)
+        return NULL;
+
+    /* Full: replace one no window uses, keeping the first one to clone from */
+    Uint32 slot = mu_gpu.glyph_scale_count;
+    if (slot == MU_MAX_SCALES)
+    {
+        while (--slot > 0 && mu_glyphs_in_use(mu_gpu.glyph_scales[slot]))
+            ;
+        if (slot == 0)
+            return NULL;
+    }
+
+    Uint32 atlas = scale > 1.5f ? 1024 : 512;
+    GlyphCache *glyphs = mu_gpu.glyph_scale_count > 0 ? glyph_cache_clone(mu_gpu.glyph_scales[0], px, atlas)
+                                                      : glyph_cache_create_default(mu_gpu.device, px, atlas);
+    if (!glyphs)
+    {
+        mu_gpu.font_missing = mu_gpu.glyph_scale_count == 0;
+        if (mu_gpu.font_missing)
+            SDL_Log("No TrueType UI font found (set CUMULUS_UI_FONT); using the built-in bitmap font");
+        return NULL;
+    }
+
+    if (slot == mu_gpu.glyph_scale_count)
+        mu_gpu.glyph_scale_count++;
+    else
+        glyph_cache_destroy(mu_gpu.glyph_scales[slot]);
+    mu_gpu.glyph_scales[slot] = glyphs;
+    glyph_cache_prewarm(glyphs, 32, 126);
+    return glyphs;
+}
+
+/* Pick up a window's display scale. Only a scale not seen before builds
+   an atlas; input keeps one precomputed factor. While every atlas is in
+   use the window keeps its old one, measured at the old scale, and asks
+   again when another window goes away. */
+static void mu_update_scale(MuSDL3GPU_Window *win)
+{
+    if (!win->window)
+        return;
+    float scale = SDL_GetWindowDisplayScale(win->window);
+    float density = SDL_GetWindowPixelDensity(win->window);
+    if (scale <= 0.0f)
+        scale = 1.0f;
+    if (density <= 0.0f)
+        density = 1.0f;
+    win->input_scale = density / scale;
+    bool changed = scale != win->scale;
+    if (!changed && (win->glyph_scale == scale || mu_gpu.font_missing))
+        return;
+
+    win->scale = scale;
+    GlyphCache *glyphs = mu_glyphs_for_scale(scale);
+    if (glyphs || mu_gpu.font_missing)
+    {
+        win->glyphs = glyphs;
+        win->glyph_scale = scale;
+    }
+    if (changed)
+        SDL_Log("UI scale %.2f (pixel density %.2f) for window %u%s", scale, density, SDL_GetWindowID(win->window),
+                win->glyph_scale == scale ? "" : ", every UI atlas in use: text stays at the old scale");
+}
+
+/* Build the atlases for every connected display up front, so moving the
+   window between them never rasterizes a whole font mid-frame */
+static void mu_prebuild_scales(SDL_Window *window)
+{
+    float density = SDL_GetWindowPixelDensity(window);
+    int count = 0;
+    SDL_DisplayID *displays = SDL_GetDisplays(&count);
+    for (int i = 0; displays && i < count && !mu_gpu.font_missing; i++)
+    {
+        float scale = SDL_GetDisplayContentScale(displays[i]) * (density > 0.0f ? density : 1.0f);
+        if (scale > 0.0f)
+            mu_glyphs_for_scale(scale);
+    }
+    SDL_free(displays);
+}
+
 /*================================================================================
  * Public API
  *================================================================================*/
 
-void mu_sdl3_gpu_init(SDL_GPUDevice *device, SDL_Window *window, mu_Context *ctx)
+/* Shared state. The pipeline targets color_format, which every window's
+   swapchain and every offscreen target must use. */
+void mu_sdl3_gpu_init(SDL_GPUDevice *device, SDL_GPUTextureFormat color_format, PipelineCache *pipelines)
 {
     SDL_zero(mu_gpu);
     mu_gpu.device = device;
-    mu_gpu.window = window;
+    mu_gpu.color_format = color_format;
+    mu_gpu.pipelines = pipelines;
 
     mu_sdl3_gpu_device_create();
 
     mu_gpu.font_glyph_w = MU_FONT_GLYPH_W;
     mu_gpu.font_glyph_h = MU_FONT_GLYPH_H;
+}
+
+static MuSDL3GPU_Window *mu_attach(SDL_Window *window, mu_Context *ctx)
+{
+    if (mu_gpu.window_count == MU_MAX_WINDOWS)
+    {
+        SDL_Log("microui: at most %d windows", MU_MAX_WINDOWS);
+        return NULL;
+    }
+    MuSDL3GPU_Window *win = SDL_calloc(1, sizeof(MuSDL3GPU_Window));
+    if (!win)
+        return NULL;
+    win->window = window;
+    win->ctx = ctx;
+    mu_gpu.windows[mu_gpu.window_count++] = win;
 
     mu_init(ctx);
     ctx->text_width = mu_text_width_cb;
     ctx->text_height = mu_text_height_cb;
-    ctx->style->font = (mu_Font)1; /* non-null sentinel */
+    ctx->style->font = (mu_Font)win;
+    return win;
 }
 
-/* Call this before the render pass each frame, with the acquired command buffer
- */
-void mu_sdl3_gpu_frame_start(SDL_GPUCommandBuffer *cmd_buf)
+/* Attach a claimed window and initialize its context. Returns NULL if the
+   window limit is reached or its swapchain format differs. */
+MuSDL3GPU_Window *mu_sdl3_gpu_add_window(SDL_Window *window, mu_Context *ctx)
 {
-    if (!mu_textures_uploaded && mu_gpu.device)
+    if (SDL_GetGPUSwapchainTextureFormat(mu_gpu.device, window) != mu_gpu.color_format)
     {
-        mu_upload_textures(cmd_buf);
+        SDL_Log("microui: window %u has a different swapchain format", SDL_GetWindowID(window));
+        return NULL;
     }
+    if (mu_gpu.glyph_scale_count == 0)
+        mu_prebuild_scales(window);
+    MuSDL3GPU_Window *win = mu_attach(window, ctx);
+    if (win)
+        mu_update_scale(win);
+    return win;
 }
 
-void mu_sdl3_gpu_handle_event(SDL_Event *evt, mu_Context *ctx)
+/* Initialize a context that draws into a width x height texture of the
+   init format, at a fixed scale (UI units to pixels) */
+MuSDL3GPU_Window *mu_sdl3_gpu_add_target(mu_Context *ctx, Uint32 width, Uint32 height, float scale)
 {
+    MuSDL3GPU_Window *win = mu_attach(NULL, ctx);
+    if (!win)
+        return NULL;
+    win->width = width;
+    win->height = height;
+    win->scale = scale > 0.0f ? scale : 1.0f;
+    win->input_scale = 1.0f / win->scale;
+    win->glyphs = mu_glyphs_for_scale(win->scale);
+    win->glyph_scale = win->scale;
+    return win;
+}
+
+/* Release a window's buffers; call before destroying the SDL window */
+void mu_sdl3_gpu_remove_window(MuSDL3GPU_Window *win)
+{
+    if (!win)
+        return;
+    for (Uint32 i = 0; i < mu_gpu.window_count; i++)
+    {
+        if (mu_gpu.windows[i] == win)
+        {
+            mu_gpu.windows[i] = mu_gpu.windows[--mu_gpu.window_count];
+            break;
+        }
+    }
+    if (win->upload)
+        residency_release_transfer_buffer(mu_gpu.device, win->upload);
+    if (win->vertex_buffer)
+        residency_release_buffer(mu_gpu.device, win->vertex_buffer);
+    if (win->index_buffer)
+        residency_release_buffer(mu_gpu.device, win->index_buffer);
+    SDL_free(win);
+
+    /* Its atlas may be free now for a window still waiting on one */
+    for (Uint32 i = 0; i < mu_gpu.window_count; i++)
+    {
+        if (mu_gpu.windows[i]->glyph_scale != mu_gpu.windows[i]->scale)
+            mu_update_scale(mu_gpu.windows[i]);
+    }
+}
+
+/* Feed an event to the context of the window it belongs to */
+void mu_sdl3_gpu_handle_event(SDL_Event *evt)
+{
+    SDL_Window *window = SDL_GetWindowFromEvent(evt);
+    MuSDL3GPU_Window *win = NULL;
+    for (Uint32 i = 0; window && i < mu_gpu.window_count; i++)
+    {
+        if (mu_gpu.windows[i]->window == window)
+            win = mu_gpu.windows[i];
+    }
+    if (!win)
+        return;
+
+    mu_Context *ctx = win->ctx;
     switch (evt->type)
     {
+    case SDL_EVENT_WINDOW_DISPLAY_SCALE_CHANGED:
+    case SDL_EVENT_WINDOW_DISPLAY_CHANGED:
+        mu_update_scale(win);
+        break;
     case SDL_EVENT_MOUSE_MOTION:
-        mu_input_mousemove(ctx, (int)evt->motion.x, (int)evt->motion.y);
+        mu_input_mousemove(ctx, (int)(evt->motion.x * win->input_scale), (int)(evt->motion.y * win->input_scale));
         break;
     case SDL_EVENT_MOUSE_BUTTON_DOWN: {
         int btn = 0;
@@ -718,7 +1018,7 @@ void mu_sdl3_gpu_handle_event(SDL_Event *evt, mu_Context *ctx)
             btn = MU_MOUSE_RIGHT;
         if (evt->button.button == SDL_BUTTON_MIDDLE)
             btn = MU_MOUSE_MIDDLE;
-        mu_input_mousedown(ctx, (int)evt->button.x, (int)evt->button.y, btn);
+        mu_input_mousedown(ctx, (int)(evt->button.x * win->input_scale), (int)(evt->button.y * win->input_scale), btn);
         break;
     }
     case SDL_EVENT_MOUSE_BUTTON_UP: {
@@ -729,10 +1029,11 @@ void mu_sdl3_gpu_handle_event(SDL_Event *evt, mu_Context *ctx)
             btn = MU_MOUSE_RIGHT;
         if (evt->button.button == SDL_BUTTON_MIDDLE)
             btn = MU_MOUSE_MIDDLE;
-        mu_input_mouseup(ctx, (int)evt->button.x, (int)evt->button.y, btn);
+        mu_input_mouseup(ctx, (int)(evt->button.x * win->input_scale), (int)(evt->button.y * win->input_scale), btn);
         break;
     }
     case SDL_EVENT_MOUSE_WHEEL:
+        /* Whole steps: input.c keeps the fractional remainder */
         mu_input_scroll(ctx, (int)evt->wheel.x, (int)evt->wheel.y);
         break;
     case SDL_EVENT_KEY_DOWN:
@@ -765,14 +1066,23 @@ void mu_sdl3_gpu_handle_event(SDL_Event *evt, mu_Context *ctx)
     }
 }
 
-/* Process mu commands and upload vertex data. Call BEFORE render pass.
+/* Process mu commands into quads and stage them for mu_sdl3_gpu_copy.
  * Two-pass approach: RECTs first (white texture), then TEXT+ICON (font texture). */
-void mu_sdl3_gpu_upload(SDL_GPUCommandBuffer *cmd_buf, mu_Context *ctx)
+void mu_sdl3_gpu_prepare(MuSDL3GPU_Window *win)
 {
+    mu_Context *ctx = win->ctx;
     mu_Command *cmd = NULL;
 
+    Uint32 quads = mu_count_quads(ctx);
     mu_gpu.vertex_count = 0;
     mu_gpu.index_count = 0;
+    mu_gpu.vertex_data = frame_alloc(quads * 4 * sizeof(MuVertex));
+    mu_gpu.index_data = frame_alloc(quads * 6 * sizeof(Uint16));
+    if (!mu_gpu.vertex_data || !mu_gpu.index_data)
+    {
+        win->rect_index_count = win->font_index_end = win->index_count = 0;
+        return;
+    }
 
     /* Pass 1: RECT commands — rendered with 1x1 white texture */
     while (mu_next_command(ctx, &cmd))
@@ -785,7 +1095,7 @@ void mu_sdl3_gpu_upload(SDL_GPUCommandBuffer *cmd_buf, mu_Context *ctx)
                          0, 0, 0, 0, c.r, c.g, c.b, c.a);
         }
     }
-    mu_gpu.rect_index_count = mu_gpu.index_count;
+    win->rect_index_count = mu_gpu.index_count;
 
     /* Pass 2: TEXT and ICON commands — rendered with font texture */
     cmd = NULL;
@@ -794,6 +1104,8 @@ void mu_sdl3_gpu_upload(SDL_GPUCommandBuffer *cmd_buf, mu_Context *ctx)
         switch (cmd->type)
         {
         case MU_COMMAND_TEXT: {
+            if (win->glyphs)
+                break;
             const char *str = cmd->text.str;
             int len = (int)strlen(str);
             int gx = cmd->text.pos.x;
@@ -843,6 +1155,19 @@ void mu_sdl3_gpu_upload(SDL_GPUCommandBuffer *cmd_buf, mu_Context *ctx)
             break;
         }
     }
+    win->font_index_end = mu_gpu.index_count;
+
+    /* Pass 3: TrueType TEXT commands — rendered with the glyph atlas */
+    if (win->glyphs)
+    {
+        cmd = NULL;
+        while (mu_next_command(ctx, &cmd))
+        {
+            if (cmd->type == MU_COMMAND_TEXT)
+                mu_push_glyph_text(win, cmd->text.str, cmd->text.pos.x, cmd->text.pos.y, cmd->text.color);
+        }
+    }
+    win->index_count = mu_gpu.index_count;
 
     if (mu_gpu.vertex_count == 0 || !mu_gpu.pipeline)
     {
@@ -853,68 +1178,120 @@ void mu_sdl3_gpu_upload(SDL_GPUCommandBuffer *cmd_buf, mu_Context *ctx)
     Uint32 vbytes = mu_gpu.vertex_count * sizeof(MuVertex);
     Uint32 ibytes = mu_gpu.index_count * sizeof(Uint16);
 
-    if (mu_gpu.vertex_buffer_capacity < vbytes)
+    if (win->vertex_buffer_capacity < vbytes)
     {
-        if (mu_gpu.vertex_buffer)
-            SDL_ReleaseGPUBuffer(mu_gpu.device, mu_gpu.vertex_buffer);
+        if (win->vertex_buffer)
+            residency_release_buffer(mu_gpu.device, win->vertex_buffer);
         SDL_GPUBufferCreateInfo bi;
         SDL_zero(bi);
         bi.usage = SDL_GPU_BUFFERUSAGE_VERTEX;
         bi.size = vbytes * 2;
-        mu_gpu.vertex_buffer = SDL_CreateGPUBuffer(mu_gpu.device, &bi);
-        mu_gpu.vertex_buffer_capacity = bi.size;
+        win->vertex_buffer = residency_create_buffer(mu_gpu.device, &bi, RESIDENCY_UI);
+        win->vertex_buffer_capacity = win->vertex_buffer ? bi.size : 0;
     }
 
-    if (mu_gpu.index_buffer_capacity < ibytes)
+    if (win->index_buffer_capacity < ibytes)
     {
-        if (mu_gpu.index_buffer)
-            SDL_ReleaseGPUBuffer(mu_gpu.device, mu_gpu.index_buffer);
+        if (win->index_buffer)
+            residency_release_buffer(mu_gpu.device, win->index_buffer);
         SDL_GPUBufferCreateInfo bi;
         SDL_zero(bi);
         bi.usage = SDL_GPU_BUFFERUSAGE_INDEX;
         bi.size = ibytes * 2;
-        mu_gpu.index_buffer = SDL_CreateGPUBuffer(mu_gpu.device, &bi);
-        mu_gpu.index_buffer_capacity = bi.size;
+        win->index_buffer = residency_create_buffer(mu_gpu.device, &bi, RESIDENCY_UI);
+        win->index_buffer_capacity = win->index_buffer ? bi.size : 0;
+    }
+    if (!win->vertex_buffer || !win->index_buffer)
+    {
+        /* Over the UI budget: draw nothing rather than from a stale buffer */
+        win->index_count = 0;
+        return;
     }
 
-    /* Upload vertex/index data via copy pass */
-    SDL_GPUTransferBufferCreateInfo tb_info;
-    SDL_zero(tb_info);
-    tb_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-    tb_info.size = vbytes + ibytes;
-
-    SDL_GPUTransferBuffer *tbuf = SDL_CreateGPUTransferBuffer(mu_gpu.device, &tb_info);
-    Uint8 *map = SDL_MapGPUTransferBuffer(mu_gpu.device, tbuf, false);
+    /* Stage vertex/index data for the copy pass */
+    if (win->upload_capacity < vbytes + ibytes)
+    {
+        if (win->upload)
+            residency_release_transfer_buffer(mu_gpu.device, win->upload);
+        SDL_GPUTransferBufferCreateInfo tb_info;
+        SDL_zero(tb_info);
+        tb_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+        tb_info.size = (vbytes + ibytes) * 2;
+        win->upload = residency_create_transfer_buffer(mu_gpu.device, &tb_info, RESIDENCY_UI);
+        win->upload_capacity = win->upload ? tb_info.size : 0;
+        if (!win->upload)
+            return;
+    }
+    /* Cycled: last frame's copy may still be reading it */
+    Uint8 *map = SDL_MapGPUTransferBuffer(mu_gpu.device, win->upload, true);
+    if (!map)
+        return;
     SDL_memcpy(map, mu_gpu.vertex_data, vbytes);
     SDL_memcpy(map + vbytes, mu_gpu.index_data, ibytes);
-    SDL_UnmapGPUTransferBuffer(mu_gpu.device, tbuf);
+    SDL_UnmapGPUTransferBuffer(mu_gpu.device, win->upload);
+    win->upload_vbytes = vbytes;
+    win->upload_ibytes = ibytes;
+    win->upload_pending = true;
+}
 
-    SDL_GPUCopyPass *cp = SDL_BeginGPUCopyPass(cmd_buf);
-    SDL_GPUTransferBufferLocation src;
-    SDL_zero(src);
-    src.transfer_buffer = tbuf;
-    SDL_GPUBufferRegion dr;
-    SDL_zero(dr);
+/* Record the first frame's texture uploads, new glyphs and every window's
+ * staged quads into cp, which may be shared with other uploads. Call once
+ * per frame, after each window's prepare and before the UI render passes. */
+void mu_sdl3_gpu_copy(SDL_GPUCopyPass *cp)
+{
+    if (!mu_textures_uploaded && mu_gpu.device)
+    {
+        mu_upload_textures(cp);
+    }
+    /* Glyphs placed by any window this frame stay until the next one */
+    for (Uint32 i = 0; i < mu_gpu.glyph_scale_count; i++)
+    {
+        glyph_cache_upload(mu_gpu.glyph_scales[i], cp);
+        glyph_cache_begin_frame(mu_gpu.glyph_scales[i]);
+    }
 
-    src.offset = 0;
-    dr.buffer = mu_gpu.vertex_buffer;
-    dr.offset = 0;
-    dr.size = vbytes;
-    SDL_UploadToGPUBuffer(cp, &src, &dr, false);
-
-    src.offset = vbytes;
-    dr.buffer = mu_gpu.index_buffer;
-    dr.size = ibytes;
-    SDL_UploadToGPUBuffer(cp, &src, &dr, false);
+    for (Uint32 i = 0; i < mu_gpu.window_count; i++)
+    {
+        MuSDL3GPU_Window *win = mu_gpu.windows[i];
+        if (!win->upload_pending)
+        {
+            continue;
+        }
+
+        SDL_GPUTransferBufferLocation src;
+        SDL_zero(src);
+        src.transfer_buffer = win->upload;
+        SDL_GPUBufferRegion dr;
+        SDL_zero(dr);
+
+        src.offset = 0;
+        dr.buffer = win->vertex_buffer;
+        dr.offset = 0;
+        dr.size = win->upload_vbytes;
+        SDL_UploadToGPUBuffer(cp, &src, &dr, false);
+
+        src.offset = win->upload_vbytes;
+        dr.buffer = win->index_buffer;
+        dr.size = win->upload_ibytes;
+        SDL_UploadToGPUBuffer(cp, &src, &dr, false);
+        win->upload_pending = false;
+    }
+}
+
+/* prepare + copy in a copy pass of their own. Call BEFORE render pass. */
+void mu_sdl3_gpu_upload(SDL_GPUCommandBuffer *cmd_buf, MuSDL3GPU_Window *win)
+{
+    mu_sdl3_gpu_prepare(win);
+    SDL_GPUCopyPass *cp = SDL_BeginGPUCopyPass(cmd_buf);
+    mu_sdl3_gpu_copy(cp);
     SDL_EndGPUCopyPass(cp);
-    SDL_ReleaseGPUTransferBuffer(mu_gpu.device, tbuf);
 }
 
 /* Draw already-uploaded vertex data. Call INSIDE render pass.
  * Two draw calls: RECTs with white texture, TEXT+ICON with font texture. */
-void mu_sdl3_gpu_render(SDL_GPUCommandBuffer *cmd_buf, SDL_GPURenderPass *render_pass)
+void mu_sdl3_gpu_render(SDL_GPUCommandBuffer *cmd_buf, SDL_GPURenderPass *render_pass, const MuSDL3GPU_Window *win)
 {
-    if (!mu_gpu.pipeline || mu_gpu.vertex_count == 0)
+    if (!mu_gpu.pipeline || !win || win->index_count == 0)
     {
         return;
     }
@@ -923,106 +1300,89 @@ void mu_sdl3_gpu_render(SDL_GPUCommandBuffer *cmd_buf, SDL_GPURenderPass *render
 
     SDL_GPUBufferBinding vb;
     SDL_zero(vb);
-    vb.buffer = mu_gpu.vertex_buffer;
+    vb.buffer = win->vertex_buffer;
     SDL_BindGPUVertexBuffers(render_pass, 0, &vb, 1);
 
     SDL_GPUBufferBinding ib;
     SDL_zero(ib);
-    ib.buffer = mu_gpu.index_buffer;
+    ib.buffer = win->index_buffer;
     SDL_BindGPUIndexBuffer(render_pass, &ib, SDL_GPU_INDEXELEMENTSIZE_16BIT);
 
-    int w, h;
-    SDL_GetWindowSizeInPixels(mu_gpu.window, &w, &h);
+    int w = (int)win->width, h = (int)win->height;
+    if (win->window)
+        SDL_GetWindowSizeInPixels(win->window, &w, &h);
     SDL_GPUViewport vp = {0, 0, (float)w, (float)h, 0, 1};
     SDL_SetGPUViewport(render_pass, &vp);
 
-    float proj[4][4] = {{2.0f / w, 0, 0, 0}, {0, -2.0f / h, 0, 0}, {0, 0, -1, 0}, {-1, 1, 0, 1}};
+    /* UI units in, pixels out */
+    float sx = 2.0f * win->scale / (float)w, sy = -2.0f * win->scale / (float)h;
+    float proj[4][4] = {{sx, 0, 0, 0}, {0, sy, 0, 0}, {0, 0, -1, 0}, {-1, 1, 0, 1}};
     SDL_PushGPUVertexUniformData(cmd_buf, 0, proj, sizeof(proj));
 
     SDL_GPUTextureSamplerBinding tex_binding;
     SDL_zero(tex_binding);
 
     /* Draw 1: RECTs — solid color quads, sample from 1x1 white texture */
-    if (mu_gpu.rect_index_count > 0)
+    if (win->rect_index_count > 0)
     {
         tex_binding.texture = mu_gpu.white_texture;
         tex_binding.sampler = mu_gpu.sampler;
         SDL_BindGPUFragmentSamplers(render_pass, 0, &tex_binding, 1);
-        SDL_DrawGPUIndexedPrimitives(render_pass, mu_gpu.rect_index_count, 1, 0, 0, 0);
+        SDL_DrawGPUIndexedPrimitives(render_pass, win->rect_index_count, 1, 0, 0, 0);
     }
 
     /* Draw 2: TEXT + ICON — glyph-shaped quads, sample from font atlas texture */
-    Uint32 text_index_count = mu_gpu.index_count - mu_gpu.rect_index_count;
+    Uint32 text_index_count = win->font_index_end - win->rect_index_count;
     if (text_index_count > 0)
     {
         tex_binding.texture = mu_gpu.font_texture;
         tex_binding.sampler = mu_gpu.sampler;
         SDL_BindGPUFragmentSamplers(render_pass, 0, &tex_binding, 1);
-        SDL_DrawGPUIndexedPrimitives(render_pass, text_index_count, 1, mu_gpu.rect_index_count, 0, 0);
+        SDL_DrawGPUIndexedPrimitives(render_pass, text_index_count, 1, win->rect_index_count, 0, 0);
+    }
+
+    /* Draw 3: TrueType TEXT — sample from the glyph cache's atlas */
+    Uint32 glyph_index_count = win->index_count - win->font_index_end;
+    if (glyph_index_count > 0)
+    {
+        tex_binding.texture = glyph_cache_texture(win->glyphs);
+        tex_binding.sampler = mu_gpu.sampler;
+        SDL_BindGPUFragmentSamplers(render_pass, 0, &tex_binding, 1);
+        SDL_DrawGPUIndexedPrimitives(render_pass, glyph_index_count, 1, win->font_index_end, 0, 0);
     }
 }
 
 void mu_sdl3_gpu_shutdown(void)
 {
-    if (mu_gpu.vertex_buffer)
+    while (mu_gpu.window_count > 0)
     {
-        SDL_ReleaseGPUBuffer(mu_gpu.device, mu_gpu.vertex_buffer);
-        mu_gpu.vertex_buffer = NULL;
-    }
-    if (mu_gpu.index_buffer)
-    {
-        SDL_ReleaseGPUBuffer(mu_gpu.device, mu_gpu.index_buffer);
-        mu_gpu.index_buffer = NULL;
+        mu_sdl3_gpu_remove_window(mu_gpu.windows[0]);
     }
     if (mu_gpu.font_texture)
     {
-        SDL_ReleaseGPUTexture(mu_gpu.device, mu_gpu.font_texture);
+        residency_release_texture(mu_gpu.device, mu_gpu.font_texture);
         mu_gpu.font_texture = NULL;
     }
     if (mu_gpu.icon_texture)
     {
-        SDL_ReleaseGPUTexture(mu_gpu.device, mu_gpu.icon_texture);
+        residency_release_texture(mu_gpu.device, mu_gpu.icon_texture);
         mu_gpu.icon_texture = NULL;
     }
     if (mu_gpu.white_texture)
     {
-        SDL_ReleaseGPUTexture(mu_gpu.device, mu_gpu.white_texture);
+        residency_release_texture(mu_gpu.device, mu_gpu.white_texture);
         mu_gpu.white_texture = NULL;
     }
+    for (Uint32 i = 0; i < mu_gpu.glyph_scale_count; i++)
+    {
+        glyph_cache_destroy(mu_gpu.glyph_scales[i]);
+        mu_gpu.glyph_scales[i] = NULL;
+    }
     if (mu_gpu.sampler)
     {
         SDL_ReleaseGPUSampler(mu_gpu.device, mu_gpu.sampler);
         mu_gpu.sampler = NULL;
     }
-    if (mu_gpu.pipeline)
-    {
-        SDL_ReleaseGPUGraphicsPipeline(mu_gpu.device, mu_gpu.pipeline);
-        mu_gpu.pipeline = NULL;
-    }
-    if (mu_gpu.vertex_shader)
-    {
-        SDL_ReleaseGPUShader(mu_gpu.device, mu_gpu.vertex_shader);
-        mu_gpu.vertex_shader = NULL;
-    }
-    if (mu_gpu.fragment_shader)
-    {
-        SDL_ReleaseGPUShader(mu_gpu.device, mu_gpu.fragment_shader);
-        mu_gpu.fragment_shader = NULL;
-    }
-
-    if (mu_gpu.vertex_data)
-    {
-        SDL_free(mu_gpu.vertex_data);
-        mu_gpu.vertex_data = NULL;
-        mu_gpu.vertex_data_cap = 0;
-    }
-    if (mu_gpu.index_data)
-    {
-        SDL_free(mu_gpu.index_data);
-        mu_gpu.index_data = NULL;
-        mu_gpu.index_data_cap = 0;
-    }
-
     SDL_zero(mu_gpu);
 }
 
@@ -1,10 +1,317 @@
 #define CGLTF_IMPLEMENTATION
+#include "model_import.h"
+#include "animation.h"
+#include "asset_cache.h"
+#include "bench.h"
+#include "gltf_meshopt.h"
+#include "residency.h"
+#include "scene_graph.h"
+
 #include <SDL3/SDL.h>
 #include <cgltf.h>
 
-struct cgltf_data *model_load(const char *path)
+/* cgltf allocations go through SDL so decoded buffer views (freed by
+   cgltf_free) and our own allocations share one allocator. */
+static void *gltf_alloc(void *user, cgltf_size size)
+{
+    (void)user;
+    return SDL_malloc(size);
+}
+
+static void gltf_free(void *user, void *ptr)
+{
+    (void)user;
+    SDL_free(ptr);
+}
+
+/* With an asset cache every file (the glTF itself, .bin buffers) is read
+   through it and shared with other models */
+static cgltf_result gltf_read(const cgltf_memory_options *memory, const cgltf_file_options *file, const char *path,
+                              cgltf_size *size, void **data)
+{
+    (void)memory;
+    size_t bytes = 0;
+    const void *contents = asset_cache_read_file(file->user_data, path, &bytes);
+    if (!contents)
+        return cgltf_result_file_not_found;
+    *size = bytes;
+    *data = (void *)contents; /* cgltf only reads file data */
+    return cgltf_result_success;
+}
+
+static void gltf_release(const cgltf_memory_options *memory, const cgltf_file_options *file, void *data)
+{
+    (void)memory;
+    asset_cache_release_file(file->user_data, data);
+}
+
+/*================================================================================
+ * KHR_draco_mesh_compression
+ *================================================================================*/
+static bool extension_required(const cgltf_data *data, const char *name)
+{
+    for (size_t i = 0; i < data->extensions_required_count; i++)
+    {
+        if (SDL_strcmp(data->extensions_required[i], name) == 0)
+            return true;
+    }
+    return false;
+}
+
+/* No Draco decoder is linked in. Optional Draco (with uncompressed fallback
+   accessors) loads fine; required Draco would decode as garbage, so refuse. */
+static bool check_draco(const cgltf_data *data, const char *path)
+{
+    size_t draco_prims = 0;
+    for (size_t i = 0; i < data->meshes_count; i++)
+    {
+        for (size_t j = 0; j < data->meshes[i].primitives_count; j++)
+        {
+            if (data->meshes[i].primitives[j].has_draco_mesh_compression)
+                draco_prims++;
+        }
+    }
+    if (draco_prims == 0)
+    {
+        return true;
+    }
+
+    if (extension_required(data, "KHR_draco_mesh_compression"))
+    {
+        SDL_Log("'%s' requires KHR_draco_mesh_compression (%zu primitives), which is not supported", path,
+                draco_prims);
+        return false;
+    }
+
+    SDL_Log("  draco:     %zu primitives compressed, using uncompressed fallback", draco_prims);
+    return true;
+}
+
+/*================================================================================
+ * Geometry unpacking
+ *================================================================================*/
+static const cgltf_accessor *find_attribute(const cgltf_primitive *prim, cgltf_attribute_type type)
+{
+    for (size_t i = 0; i < prim->attributes_count; i++)
+    {
+        if (prim->attributes[i].type == type && prim->attributes[i].index == 0)
+            return prim->attributes[i].data;
+    }
+    return NULL;
+}
+
+static size_t accessor_index(const cgltf_data *data, const cgltf_accessor *acc)
+{
+    return (size_t)(acc - data->accessors);
+}
+
+/* Reference: per-element cgltf reads into the same SoA layout */
+static void benchmark_unpack(const AccessorUnpackRequest *requests, size_t count, double batch_ms)
+{
+    double ref_ms = 0.0;
+    size_t elements = 0;
+    float max_err = 0.0f;
+    for (size_t r = 0; r < count; r++)
+    {
+        const AccessorUnpackRequest *req = &requests[r];
+        if (!req->floats || req->floats->count == 0)
+            continue;
+        const cgltf_accessor *acc = req->accessor;
+        int ncomp = req->floats->num_components;
+        float *soa = SDL_malloc(acc->count * (size_t)ncomp * sizeof(float));
+        if (!soa)
+            continue;
+
+        Uint64 start = bench_now();
+        for (size_t i = 0; i < acc->count; i++)
+        {
+            float v[ACCESSOR_MAX_COMPONENTS];
+            cgltf_accessor_read_float(acc, i, v, (cgltf_size)ncomp);
+            for (int c = 0; c < ncomp; c++)
+                soa[(size_t)c * acc->count + i] = v[c];
+        }
+        ref_ms += bench_ms_since(start);
+
+        for (size_t i = 0; i < acc->count * (size_t)ncomp; i++)
+        {
+            float err = SDL_fabsf(soa[i] - req->floats->storage[i]);
+            max_err = err > max_err ? err : max_err;
+        }
+        elements += acc->count;
+        SDL_free(soa);
+    }
+
+    SDL_Log("  bench:     %zu elements  batch %.2f ms  cgltf_accessor_read_float %.2f ms  (%.1fx, max err %g)",
+            elements, batch_ms, ref_ms, batch_ms > 0.0 ? ref_ms / batch_ms : 0.0, (double)max_err);
+}
+
+static bool unpack_geometry(Model *model)
+{
+    const cgltf_data *data = model->gltf;
+
+    model->accessors = SDL_calloc(data->accessors_count + 1, sizeof(AccessorStreams));
+    model->mesh_first_primitive = SDL_calloc(data->meshes_count + 1, sizeof(size_t));
+    for (size_t i = 0; i < data->meshes_count; i++)
+    {
+        model->mesh_first_primitive[i] = model->primitives_count;
+        model->primitives_count += data->meshes[i].primitives_count;
+    }
+    model->mesh_first_primitive[data->meshes_count] = model->primitives_count;
+    model->primitives = SDL_calloc(model->primitives_count + 1, sizeof(ModelPrimitive));
+
+    /* At most four requests per primitive (position, normal, uv, indices) */
+    AccessorUnpackRequest *requests = SDL_malloc((model->primitives_count * 4 + 1) * sizeof(*requests));
+    bool *requested = SDL_calloc(data->accessors_count + 1, sizeof(bool));
+    if (!model->accessors || !model->mesh_first_primitive || !model->primitives || !requests || !requested)
+    {
+        SDL_free(requests);
+        SDL_free(requested);
+        return false;
+    }
+
+    size_t num_requests = 0, prim_index = 0, vertex_total = 0, index_total = 0;
+    for (size_t i = 0; i < data->meshes_count; i++)
+    {
+        for (size_t j = 0; j < data->meshes[i].primitives_count; j++, prim_index++)
+        {
+            const cgltf_primitive *prim = &data->meshes[i].primitives[j];
+            ModelPrimitive *out = &model->primitives[prim_index];
+            out->source = prim;
+
+            const cgltf_accessor *attrs[3] = {find_attribute(prim, cgltf_attribute_type_position),
+                                              find_attribute(prim, cgltf_attribute_type_normal),
+                                              find_attribute(prim, cgltf_attribute_type_texcoord)};
+            const AccessorStreams **slots[3] = {&out->positions, &out->normals, &out->texcoords};
+            if (!attrs[0])
+                continue;
+
+            for (int a = 0; a < 3; a++)
+            {
+                if (!attrs[a] || (a > 0 && attrs[a]->count != attrs[0]->count))
+                    continue;
+                size_t ai = accessor_index(data, attrs[a]);
+                *slots[a] = &model->accessors[ai];
+                if (!requested[ai])
+                {
+                    requested[ai] = true;
+                    requests[num_requests++] = (AccessorUnpackRequest){attrs[a], &model->accessors[ai], NULL};
+                }
+            }
+
+            out->index_count = prim->indices ? prim->indices->count : attrs[0]->count;
+            out->indices = SDL_malloc(out->index_count * sizeof(Uint32) + 1);
+            if (!out->indices)
+            {
+                SDL_free(requests);
+                SDL_free(requested);
+                return false;
+            }
+            if (prim->indices)
+            {
+                requests[num_requests++] = (AccessorUnpackRequest){prim->indices, NULL, out->indices};
+            }
+            else
+            {
+                for (size_t k = 0; k < out->index_count; k++)
+                    out->indices[k] = (Uint32)k;
+            }
+            vertex_total += attrs[0]->count;
+            index_total += out->index_count;
+        }
+    }
+
+    /* Everything unpacked stays resident with the model */
+    size_t bytes = index_total * sizeof(Uint32);
+    for (size_t r = 0; r < num_requests; r++)
+    {
+        if (requests[r].floats)
+            bytes += requests[r].accessor->count * cgltf_num_components(requests[r].accessor->type) * sizeof(float);
+    }
+    if (!residency_reserve(RESIDENCY_MODELS, bytes))
+    {
+        SDL_Log("  unpack:    %.1f MB of geometry does not fit the model budget", (double)bytes / (1024.0 * 1024.0));
+        SDL_free(requests);
+        SDL_free(requested);
+        return false;
+    }
+    model->resident_bytes = bytes;
+
+    Uint64 start = bench_now();
+    bool ok = accessor_unpack_batch(requests, num_requests);
+    double ms = bench_ms_since(start);
+
+    if (ok)
+    {
+        SDL_Log("  unpack:    %zu accessors, %zu verts, %zu indices in %.2f ms", num_requests, vertex_total,
+                index_total, ms);
+        if (bench_enabled())
+            benchmark_unpack(requests, num_requests, ms);
+    }
+
+    SDL_free(requests);
+    SDL_free(requested);
+    return ok;
+}
+
+/* Hash of exactly what the mesh renderer uploads, so models with the same
+   geometry share GPU buffers */
+static Uint64 hash_geometry(const Model *model)
+{
+    Uint64 h = 0;
+    for (size_t p = 0; p < model->primitives_count; p++)
+    {
+        const ModelPrimitive *prim = &model->primitives[p];
+        if (!prim->positions || prim->source->type != cgltf_primitive_type_triangles)
+            continue;
+
+        size_t n = prim->positions->count;
+        const AccessorStreams *attrs[3] = {prim->positions, prim->normals, prim->texcoords};
+        const int components[3] = {3, 3, 2};
+        for (int a = 0; a < 3; a++)
+        {
+            for (int c = 0; c < components[a]; c++)
+                h = attrs[a] ? asset_hash(attrs[a]->streams[c], n * sizeof(float), h) : asset_hash(NULL, 0, h + a);
+        }
+        h = asset_hash(prim->indices, prim->index_count * sizeof(Uint32), h);
+    }
+    return h;
+}
+
+/* Nodes referencing the same mesh are drawn as instances of one draw per
+   primitive; report how much the file shares. */
+static void log_mesh_sharing(const Model *model)
+{
+    size_t meshes = model->gltf->meshes_count;
+    Uint32 *refs = SDL_calloc(meshes + 1, sizeof(Uint32));
+    if (!refs)
+        return;
+
+    size_t mesh_nodes = 0, shared = 0;
+    for (size_t i = 0; i < model->scene->count; i++)
+    {
+        Sint32 mesh = model->scene->mesh[i];
+        if (mesh < 0)
+            continue;
+        mesh_nodes++;
+        if (refs[mesh]++ == 1)
+            shared++;
+    }
+    SDL_free(refs);
+    if (mesh_nodes > 0)
+        SDL_Log("  instancing: %zu mesh nodes, %zu meshes used by more than one", mesh_nodes, shared);
+}
+
+Model *model_load(const char *path, struct AssetCache *cache)
 {
     cgltf_options options = {0};
+    options.memory.alloc_func = gltf_alloc;
+    options.memory.free_func = gltf_free;
+    if (cache)
+    {
+        options.file.read = gltf_read;
+        options.file.release = gltf_release;
+        options.file.user_data = cache;
+    }
     cgltf_data *data = NULL;
 
     cgltf_result result = cgltf_parse_file(&options, path, &data);
@@ -22,8 +329,25 @@ struct cgltf_data *model_load(const char *path)
         return NULL;
     }
 
+    /* Every accessor inside its view and every view inside its buffer, so
+       the unpack workers never read past what was loaded */
+    result = cgltf_validate(data);
+    if (result != cgltf_result_success)
+    {
+        SDL_Log("Invalid glTF '%s' (error %d)", path, (int)result);
+        cgltf_free(data);
+        return NULL;
+    }
+
     /* Log summary */
     SDL_Log("--- Model: %s ---", path);
+
+    if (!gltf_meshopt_decode(data, path) || !check_draco(data, path))
+    {
+        cgltf_free(data);
+        return NULL;
+    }
+
     SDL_Log("  Nodes:     %zu", data->nodes_count);
     SDL_Log("  Meshes:    %zu", data->meshes_count);
     SDL_Log("  Materials: %zu", data->materials_count);
@@ -41,13 +365,69 @@ struct cgltf_data *model_load(const char *path)
         }
     }
 
-    return data;
+    Model *model = SDL_calloc(1, sizeof(Model));
+    if (!model)
+    {
+        cgltf_free(data);
+        return NULL;
+    }
+    model->gltf = data;
+    model->path = SDL_strdup(path);
+
+    if (!unpack_geometry(model))
+    {
+        SDL_Log("Failed to unpack geometry of '%s'", path);
+        model_free(model);
+        return NULL;
+    }
+    model->geometry_hash = hash_geometry(model);
+
+    Uint64 start = bench_now();
+    model->scene = scene_graph_build(data);
+    if (!model->scene)
+    {
+        SDL_Log("Failed to build scene graph of '%s'", path);
+        model_free(model);
+        return NULL;
+    }
+    SDL_Log("  scene: %zu nodes flattened in %.2f ms", model->scene->count, bench_ms_since(start));
+    log_mesh_sharing(model);
+
+    start = bench_now();
+    model->animation = animation_set_build(data, model->scene);
+    if (model->animation)
+    {
+        SDL_Log("  animation: %zu clips, %zu skins (%zu joints) in %.2f ms", model->animation->clip_count,
+                model->animation->skin_count, model->animation->skin_matrix_count, bench_ms_since(start));
+    }
+
+    return model;
 }
 
-void model_free(struct cgltf_data *model)
+void model_free(Model *model)
 {
-    if (model)
+    if (!model)
+    {
+        return;
+    }
+
+    if (model->accessors)
+    {
+        for (size_t i = 0; i < model->gltf->accessors_count; i++)
+            accessor_streams_free(&model->accessors[i]);
+        SDL_free(model->accessors);
+    }
+    if (model->primitives)
     {
-        cgltf_free(model);
+        for (size_t i = 0; i < model->primitives_count; i++)
+            SDL_free(model->primitives[i].indices);
+        SDL_free(model->primitives);
     }
+    SDL_free(model->mesh_first_primitive);
+    residency_release(RESIDENCY_MODELS, model->resident_bytes);
+    animation_set_free(model->animation);
+    scene_graph_free(model->scene);
+    cgltf_free(model->gltf);
+    SDL_free(model->path);
+    SDL_free(model);
 }
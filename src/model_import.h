@@ -1,13 +1,47 @@
 #ifndef CUMULUS_MODEL_IMPORT_H
 #define CUMULUS_MODEL_IMPORT_H
 
+#include "accessor_unpack.h"
+
 /* Opaque cgltf data handle */
 struct cgltf_data;
+struct cgltf_primitive;
+struct SceneGraph;
+struct AnimationSet;
+struct AssetCache;
+
+/* Engine-ready geometry of one glTF primitive. Stream pointers reference
+   Model.accessors, so primitives sharing an accessor share its data. */
+typedef struct ModelPrimitive
+{
+    const struct cgltf_primitive *source;
+    const AccessorStreams *positions; /* x, y, z — NULL if the primitive has none */
+    const AccessorStreams *normals;   /* x, y, z — may be NULL */
+    const AccessorStreams *texcoords; /* u, v (TEXCOORD_0) — may be NULL */
+    Uint32 *indices;                  /* generated 0..n-1 for unindexed primitives */
+    size_t index_count;
+} ModelPrimitive;
+
+typedef struct Model
+{
+    struct cgltf_data *gltf;
+    char *path;                 /* source file, for resolving relative URIs */
+    AccessorStreams *accessors; /* one per gltf accessor, count 0 if unused */
+    ModelPrimitive *primitives; /* all meshes' primitives, mesh by mesh */
+    size_t primitives_count;
+    size_t *mesh_first_primitive; /* meshes_count + 1 offsets into primitives */
+    struct SceneGraph *scene;     /* flattened node hierarchy of the default scene */
+    struct AnimationSet *animation; /* clips and skins, NULL if the file has none */
+    Uint64 geometry_hash;           /* content of the drawable primitives' streams and indices */
+    size_t resident_bytes;          /* unpacked geometry accounted in RESIDENCY_MODELS */
+} Model;
 
-/* Load glTF file via cgltf. Returns handle or NULL. Logs model summary. */
-struct cgltf_data *model_load(const char *path);
+/* Load glTF file via cgltf and unpack its geometry. Returns handle or NULL.
+   Logs model summary. Files are read through `cache` when it is not NULL;
+   the model must then be freed before the cache. */
+Model *model_load(const char *path, struct AssetCache *cache);
 
 /* Free loaded model. Safe to call with NULL. */
-void model_free(struct cgltf_data *model);
+void model_free(Model *model);
 
 #endif /* CUMULUS_MODEL_IMPORT_H */
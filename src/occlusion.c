@@ -0,0 +1,673 @@
+#include "occlusion.h"
+#include "bench.h"
+#include "model_import.h"
+#include "parallel.h"
+#include "scene_bvh.h"
+#include "scene_graph.h"
+
+#include <SDL3/SDL.h>
+#include <cgltf.h>
+
+#define OCCLUSION_MAX_LEVELS 16
+#define OCCLUSION_BAND_ROWS 16
+#define OCCLUSION_TEST_GRAIN 256
+#define OCCLUSION_NEAR_W 1e-4f      /* vertices closer than this in w are treated as clipped */
+#define OCCLUSION_DEPTH_BIAS 1.0001f /* an item is culled only when clearly behind */
+#define OCCLUSION_INVALID -1.0f      /* 1/w of a clipped vertex */
+
+typedef struct Occluder
+{
+    OcclusionMesh mesh;
+    size_t first_vertex; /* into the screen-space streams */
+    float rect[4];       /* this frame's pixel bounds of the unclipped vertices, min x, min y, max x, max y */
+} Occluder;
+
+struct OcclusionCuller
+{
+    Uint32 width, height;
+    /* 1/w per pixel, 0 where nothing was drawn, then levels of the
+       smallest (farthest) value of each 2x2 block */
+    float *levels[OCCLUSION_MAX_LEVELS];
+    Uint32 level_width[OCCLUSION_MAX_LEVELS];
+    Uint32 level_height[OCCLUSION_MAX_LEVELS];
+    Uint32 level_count;
+
+    Occluder *occluders;
+    Uint32 occluder_count;
+    size_t vertex_count;
+    float *screen[3]; /* per occluder vertex: pixel x, pixel y, 1/w */
+
+    /* Set by occlusion_cull for the worker tasks */
+    const SceneGraph *frame_graph;
+    SceneBvh *frame_bvh;
+    Mat4 frame_view_proj;
+    SDL_AtomicInt frame_culled;
+
+    OcclusionStats stats;
+};
+
+OcclusionCuller *occlusion_create(Uint32 width, Uint32 height)
+{
+    OcclusionCuller *oc = SDL_calloc(1, sizeof(OcclusionCuller));
+    if (!oc)
+        return NULL;
+    oc->width = SDL_max((width + 3) & ~3u, 4);
+    oc->height = SDL_max(height, 1);
+
+    Uint32 w = oc->width, h = oc->height;
+    for (Uint32 l = 0; l < OCCLUSION_MAX_LEVELS; l++)
+    {
+        oc->level_width[l] = w;
+        oc->level_height[l] = h;
+        /* Rows padded to 4 so every level can be written 4 texels at a time */
+        oc->levels[l] = SDL_aligned_alloc(16, ((w + 3) & ~3u) * h * sizeof(float));
+        if (!oc->levels[l])
+        {
+            occlusion_destroy(oc);
+            return NULL;
+        }
+        oc->level_count = l + 1;
+        if (w == 1 && h == 1)
+            break;
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+    }
+    return oc;
+}
+
+static void free_occluders(OcclusionCuller *oc)
+{
+    SDL_free(oc->occluders);
+    for (int c = 0; c < 3; c++)
+        SDL_aligned_free(oc->screen[c]);
+    oc->occluders = NULL;
+    SDL_zeroa(oc->screen);
+    oc->occluder_count = 0;
+    oc->vertex_count = 0;
+    oc->stats.occluders = 0;
+    oc->stats.occluder_triangles = 0;
+}
+
+void occlusion_destroy(OcclusionCuller *oc)
+{
+    if (!oc)
+        return;
+    free_occluders(oc);
+    for (Uint32 l = 0; l < oc->level_count; l++)
+        SDL_aligned_free(oc->levels[l]);
+    SDL_free(oc);
+}
+
+const OcclusionStats *occlusion_stats(const OcclusionCuller *oc)
+{
+    return &oc->stats;
+}
+
+/*================================================================================
+ * Occluders
+ *================================================================================*/
+bool occlusion_set_occluders(OcclusionCuller *oc, const OcclusionMesh *meshes, Uint32 count)
+{
+    if (!oc)
+        return false;
+    free_occluders(oc);
+    if (count == 0)
+        return true;
+
+    oc->occluders = SDL_malloc(count * sizeof(Occluder));
+    if (!oc->occluders)
+        return false;
+    size_t vertices = 0, triangles = 0;
+    for (Uint32 i = 0; i < count; i++)
+    {
+        oc->occluders[i].mesh = meshes[i];
+        oc->occluders[i].first_vertex = vertices;
+        /* Padded so the transform can always run 4 wide */
+        vertices += (meshes[i].vertex_count + 3) & ~(size_t)3;
+        triangles += meshes[i].index_count / 3;
+    }
+    for (int c = 0; c < 3; c++)
+    {
+        oc->screen[c] = SDL_aligned_alloc(16, (vertices ? vertices : 4) * sizeof(float));
+        if (!oc->screen[c])
+        {
+            free_occluders(oc);
+            return false;
+        }
+    }
+    oc->occluder_count = count;
+    oc->vertex_count = vertices;
+    oc->stats.occluders = count;
+    oc->stats.occluder_triangles = (Uint32)triangles;
+    return true;
+}
+
+typedef struct OccluderCandidate
+{
+    float area;
+    Uint32 item;
+} OccluderCandidate;
+
+static int SDLCALL compare_candidates(const void *a, const void *b)
+{
+    float x = ((const OccluderCandidate *)a)->area, y = ((const OccluderCandidate *)b)->area;
+    return x > y ? -1 : x < y ? 1 : 0;
+}
+
+Uint32 occlusion_select_occluders(OcclusionCuller *oc, const Model *model, const SceneBvh *bvh, Uint32 max_occluders)
+{
+    if (!oc)
+        return 0;
+    free_occluders(oc);
+    if (!model || !bvh || bvh->item_count == 0 || max_occluders == 0)
+        return 0;
+
+    /* Blended and cut-out surfaces do not hide what is behind them */
+    OccluderCandidate *candidates = SDL_malloc(bvh->item_count * sizeof(OccluderCandidate));
+    OcclusionMesh *meshes = SDL_malloc(max_occluders * sizeof(OcclusionMesh));
+    if (!candidates || !meshes)
+    {
+        SDL_free(candidates);
+        SDL_free(meshes);
+        return 0;
+    }
+    Uint32 count = 0;
+    for (size_t i = 0; i < bvh->item_count; i++)
+    {
+        const ModelPrimitive *prim = &model->primitives[bvh->item_primitive[i]];
+        const cgltf_material *mat = prim->source->material;
+        if (!prim->positions || prim->positions->num_components < 3 ||
+            prim->source->type != cgltf_primitive_type_triangles || prim->index_count < 3 ||
+            prim->index_count / 3 > OCCLUSION_MAX_MESH_TRIANGLES || (mat && mat->alpha_mode != cgltf_alpha_mode_opaque))
+            continue;
+        const float *b = &bvh->item_world[i * 6];
+        float dx = b[3] - b[0], dy = b[4] - b[1], dz = b[5] - b[2];
+        candidates[count++] = (OccluderCandidate){dx * dy + dy * dz + dz * dx, (Uint32)i};
+    }
+    SDL_qsort(candidates, count, sizeof(OccluderCandidate), compare_candidates);
+
+    Uint32 chosen = 0;
+    size_t triangles = 0;
+    for (Uint32 c = 0; c < count && chosen < max_occluders; c++)
+    {
+        Uint32 item = candidates[c].item;
+        const ModelPrimitive *prim = &model->primitives[bvh->item_primitive[item]];
+        if (triangles + prim->index_count / 3 > OCCLUSION_MAX_TRIANGLES)
+            continue;
+        triangles += prim->index_count / 3;
+        OcclusionMesh *m = &meshes[chosen++];
+        for (int a = 0; a < 3; a++)
+            m->position[a] = prim->positions->streams[a];
+        m->vertex_count = prim->positions->count;
+        m->indices = prim->indices;
+        m->index_count = prim->index_count;
+        m->node = bvh->item_node[item];
+    }
+    SDL_free(candidates);
+
+    bool ok = occlusion_set_occluders(oc, meshes, chosen);
+    SDL_free(meshes);
+    if (ok && chosen > 0)
+        SDL_Log("  occlusion: %u occluders, %u triangles", chosen, oc->stats.occluder_triangles);
+    return ok ? chosen : 0;
+}
+
+/*================================================================================
+ * Rasterization
+ *================================================================================*/
+/* Occluder vertices to pixel x, y and 1/w, 4 at a time */
+static void transform_range(void *userdata, size_t begin, size_t end)
+{
+    OcclusionCuller *oc = userdata;
+    const float sx = 0.5f * (float)oc->width, sy = -0.5f * (float)oc->height;
+    const float ox = 0.5f * (float)oc->width, oy = 0.5f * (float)oc->height;
+    for (size_t o = begin; o < end; o++)
+    {
+        const Occluder *occ = &oc->occluders[o];
+        Mat4 m;
+        mat4_mul(&m, &oc->frame_view_proj, &oc->frame_graph->world[occ->mesh.node]);
+        const float *px = occ->mesh.position[0], *py = occ->mesh.position[1], *pz = occ->mesh.position[2];
+        float *outx = oc->screen[0] + occ->first_vertex, *outy = oc->screen[1] + occ->first_vertex;
+        float *outw = oc->screen[2] + occ->first_vertex;
+        size_t n = occ->mesh.vertex_count, i = 0;
+
+#if defined(SDL_SSE2_INTRINSICS)
+        const __m128 near_w = _mm_set1_ps(OCCLUSION_NEAR_W), invalid = _mm_set1_ps(OCCLUSION_INVALID);
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(px + i), y = _mm_loadu_ps(py + i), z = _mm_loadu_ps(pz + i);
+            __m128 cx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m.m[0])), _mm_mul_ps(y, _mm_set1_ps(m.m[4]))),
+                                   _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m.m[8])), _mm_set1_ps(m.m[12])));
+            __m128 cy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m.m[1])), _mm_mul_ps(y, _mm_set1_ps(m.m[5]))),
+                                   _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m.m[9])), _mm_set1_ps(m.m[13])));
+            __m128 cw = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m.m[3])), _mm_mul_ps(y, _mm_set1_ps(m.m[7]))),
+                                   _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(m.m[11])), _mm_set1_ps(m.m[15])));
+            __m128 ok = _mm_cmpgt_ps(cw, near_w);
+            __m128 iw = _mm_div_ps(_mm_set1_ps(1.0f), _mm_max_ps(cw, near_w));
+            _mm_store_ps(outx + i, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(cx, iw), _mm_set1_ps(sx)), _mm_set1_ps(ox)));
+            _mm_store_ps(outy + i, _mm_add_ps(_mm_mul_ps(_mm_mul_ps(cy, iw), _mm_set1_ps(sy)), _mm_set1_ps(oy)));
+            _mm_store_ps(outw + i, _mm_or_ps(_mm_and_ps(ok, iw), _mm_andnot_ps(ok, invalid)));
+        }
+#elif defined(SDL_NEON_INTRINSICS)
+        const float32x4_t near_w = vdupq_n_f32(OCCLUSION_NEAR_W), invalid = vdupq_n_f32(OCCLUSION_INVALID);
+        for (; i + 4 <= n; i += 4)
+        {
+            float32x4_t x = vld1q_f32(px + i), y = vld1q_f32(py + i), z = vld1q_f32(pz + i);
+            float32x4_t cx =
+                vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m.m[12]), x, m.m[0]), y, m.m[4]), z, m.m[8]);
+            float32x4_t cy =
+                vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m.m[13]), x, m.m[1]), y, m.m[5]), z, m.m[9]);
+            float32x4_t cw =
+                vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vdupq_n_f32(m.m[15]), x, m.m[3]), y, m.m[7]), z, m.m[11]);
+            uint32x4_t ok = vcgtq_f32(cw, near_w);
+            float32x4_t d = vmaxq_f32(cw, near_w);
+            float32x4_t iw = vrecpeq_f32(d);
+            iw = vmulq_f32(iw, vrecpsq_f32(d, iw));
+            iw = vmulq_f32(iw, vrecpsq_f32(d, iw));
+            vst1q_f32(outx + i, vmlaq_n_f32(vdupq_n_f32(ox), vmulq_f32(cx, iw), sx));
+            vst1q_f32(outy + i, vmlaq_n_f32(vdupq_n_f32(oy), vmulq_f32(cy, iw), sy));
+            vst1q_f32(outw + i, vbslq_f32(ok, iw, invalid));
+        }
+#endif
+        for (; i < n; i++)
+        {
+            float x = px[i], y = py[i], z = pz[i];
+            float cw = m.m[3] * x + m.m[7] * y + m.m[11] * z + m.m[15];
+            float iw = 1.0f / SDL_max(cw, OCCLUSION_NEAR_W);
+            outx[i] = (m.m[0] * x + m.m[4] * y + m.m[8] * z + m.m[12]) * iw * sx + ox;
+            outy[i] = (m.m[1] * x + m.m[5] * y + m.m[9] * z + m.m[13]) * iw * sy + oy;
+            outw[i] = cw > OCCLUSION_NEAR_W ? iw : OCCLUSION_INVALID;
+        }
+
+        /* Bands skip occluders off their rows, and all skip those off screen */
+        Occluder *bounds = &oc->occluders[o];
+        bounds->rect[0] = bounds->rect[1] = 1e30f;
+        bounds->rect[2] = bounds->rect[3] = -1e30f;
+        for (i = 0; i < n; i++)
+        {
+            if (outw[i] <= 0.0f)
+                continue;
+            bounds->rect[0] = SDL_min(bounds->rect[0], outx[i]);
+            bounds->rect[1] = SDL_min(bounds->rect[1], outy[i]);
+            bounds->rect[2] = SDL_max(bounds->rect[2], outx[i]);
+            bounds->rect[3] = SDL_max(bounds->rect[3], outy[i]);
+        }
+    }
+}
+
+/* Keep the nearest (largest) 1/w of the pixels of rows [y0, y1) whose
+   centers the triangle covers */
+static void raster_triangle(OcclusionCuller *oc, const float *x, const float *y, const float *w, Uint32 y0, Uint32 y1)
+{
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+    if (area == 0.0f)
+        return;
+    /* Both facings are drawn; order the vertices so inside is positive */
+    int i1 = area > 0.0f ? 1 : 2, i2 = area > 0.0f ? 2 : 1;
+    float ax = x[0], ay = y[0], bx = x[i1], by = y[i1], cx = x[i2], cy = y[i2];
+    float aw = w[0], bw = w[i1], cw = w[i2];
+    float inv_area = 1.0f / SDL_fabsf(area);
+
+    float min_x = SDL_min(ax, SDL_min(bx, cx)), max_x = SDL_max(ax, SDL_max(bx, cx));
+    float min_y = SDL_min(ay, SDL_min(by, cy)), max_y = SDL_max(ay, SDL_max(by, cy));
+    /* Pixel p's center is p + 0.5 */
+    float fx0 = SDL_ceilf(min_x - 0.5f), fx1 = SDL_floorf(max_x - 0.5f);
+    float fy0 = SDL_ceilf(min_y - 0.5f), fy1 = SDL_floorf(max_y - 0.5f);
+    if (fx1 < 0.0f || fy1 < (float)y0 || fx0 > (float)(oc->width - 1) || fy0 > (float)(y1 - 1) || fx0 > fx1 ||
+        fy0 > fy1)
+        return;
+    Uint32 px0 = (Uint32)SDL_max(fx0, 0.0f) & ~3u, px1 = (Uint32)SDL_min(fx1, (float)(oc->width - 1));
+    Uint32 py0 = (Uint32)SDL_max(fy0, (float)y0), py1 = (Uint32)SDL_min(fy1, (float)(y1 - 1));
+
+    /* Edge functions e = A x + B y + C, each the area opposite a vertex */
+    float ea[3] = {by - cy, cy - ay, ay - by};
+    float eb[3] = {cx - bx, ax - cx, bx - ax};
+    float ec[3] = {bx * cy - by * cx, cx * ay - cy * ax, ax * by - ay * bx};
+    /* 1/w as a plane over the pixels */
+    float wa = (ea[0] * aw + ea[1] * bw + ea[2] * cw) * inv_area;
+    float wb = (eb[0] * aw + eb[1] * bw + eb[2] * cw) * inv_area;
+    float wc = (ec[0] * aw + ec[1] * bw + ec[2] * cw) * inv_area;
+
+    float *depth = oc->levels[0];
+    for (Uint32 py = py0; py <= py1; py++)
+    {
+        float fy = (float)py + 0.5f;
+        float *row = depth + (size_t)py * oc->width;
+        float fx = (float)px0 + 0.5f;
+#if defined(SDL_SSE2_INTRINSICS)
+        const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), zero = _mm_setzero_ps();
+        __m128 xs = _mm_add_ps(_mm_set1_ps(fx), lane);
+        __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ea[0]), xs), _mm_set1_ps(eb[0] * fy + ec[0]));
+        __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ea[1]), xs), _mm_set1_ps(eb[1] * fy + ec[1]));
+        __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(ea[2]), xs), _mm_set1_ps(eb[2] * fy + ec[2]));
+        __m128 iw = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(wa), xs), _mm_set1_ps(wb * fy + wc));
+        const __m128 step0 = _mm_set1_ps(ea[0] * 4.0f), step1 = _mm_set1_ps(ea[1] * 4.0f);
+        const __m128 step2 = _mm_set1_ps(ea[2] * 4.0f), stepw = _mm_set1_ps(wa * 4.0f);
+        for (Uint32 px = px0; px <= px1; px += 4)
+        {
+            __m128 d = _mm_load_ps(row + px);
+            __m128 in = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                                   _mm_and_ps(_mm_cmpge_ps(e2, zero), _mm_cmpgt_ps(iw, d)));
+            _mm_store_ps(row + px, _mm_or_ps(_mm_and_ps(in, iw), _mm_andnot_ps(in, d)));
+            e0 = _mm_add_ps(e0, step0);
+            e1 = _mm_add_ps(e1, step1);
+            e2 = _mm_add_ps(e2, step2);
+            iw = _mm_add_ps(iw, stepw);
+        }
+#elif defined(SDL_NEON_INTRINSICS)
+        const float lanes[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+        const float32x4_t zero = vdupq_n_f32(0.0f);
+        float32x4_t xs = vaddq_f32(vdupq_n_f32(fx), vld1q_f32(lanes));
+        float32x4_t e0 = vmlaq_n_f32(vdupq_n_f32(eb[0] * fy + ec[0]), xs, ea[0]);
+        float32x4_t e1 = vmlaq_n_f32(vdupq_n_f32(eb[1] * fy + ec[1]), xs, ea[1]);
+        float32x4_t e2 = vmlaq_n_f32(vdupq_n_f32(eb[2] * fy + ec[2]), xs, ea[2]);
+        float32x4_t iw = vmlaq_n_f32(vdupq_n_f32(wb * fy + wc), xs, wa);
+        const float32x4_t step0 = vdupq_n_f32(ea[0] * 4.0f), step1 = vdupq_n_f32(ea[1] * 4.0f);
+        const float32x4_t step2 = vdupq_n_f32(ea[2] * 4.0f), stepw = vdupq_n_f32(wa * 4.0f);
+        for (Uint32 px = px0; px <= px1; px += 4)
+        {
+            float32x4_t d = vld1q_f32(row + px);
+            uint32x4_t in = vandq_u32(vandq_u32(vcgeq_f32(e0, zero), vcgeq_f32(e1, zero)),
+                                      vandq_u32(vcgeq_f32(e2, zero), vcgtq_f32(iw, d)));
+            vst1q_f32(row + px, vbslq_f32(in, iw, d));
+            e0 = vaddq_f32(e0, step0);
+            e1 = vaddq_f32(e1, step1);
+            e2 = vaddq_f32(e2, step2);
+            iw = vaddq_f32(iw, stepw);
+        }
+#else
+        for (Uint32 px = px0; px <= px1; px++, fx += 1.0f)
+        {
+            float e0 = ea[0] * fx + eb[0] * fy + ec[0];
+            float e1 = ea[1] * fx + eb[1] * fy + ec[1];
+            float e2 = ea[2] * fx + eb[2] * fy + ec[2];
+            float iw = wa * fx + wb * fy + wc;
+            if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f && iw > row[px])
+                row[px] = iw;
+        }
+#endif
+    }
+}
+
+/* Each band of rows is cleared and drawn by one task, so no pixel is
+   shared between workers */
+static void raster_bands(void *userdata, size_t begin, size_t end)
+{
+    OcclusionCuller *oc = userdata;
+    for (size_t band = begin; band < end; band++)
+    {
+        Uint32 y0 = (Uint32)band * OCCLUSION_BAND_ROWS;
+        Uint32 y1 = SDL_min(y0 + OCCLUSION_BAND_ROWS, oc->height);
+        SDL_memset(oc->levels[0] + (size_t)y0 * oc->width, 0, (size_t)(y1 - y0) * oc->width * sizeof(float));
+
+        for (Uint32 o = 0; o < oc->occluder_count; o++)
+        {
+            const Occluder *occ = &oc->occluders[o];
+            if (occ->rect[3] < (float)y0 || occ->rect[1] > (float)y1 || occ->rect[2] < 0.0f ||
+                occ->rect[0] > (float)oc->width)
+                continue;
+            const float *sx = oc->screen[0] + occ->first_vertex, *sy = oc->screen[1] + occ->first_vertex;
+            const float *sw = oc->screen[2] + occ->first_vertex;
+            const Uint32 *idx = occ->mesh.indices;
+            for (size_t t = 0; t + 2 < occ->mesh.index_count; t += 3)
+            {
+                Uint32 a = idx[t], b = idx[t + 1], c = idx[t + 2];
+                if (a >= occ->mesh.vertex_count || b >= occ->mesh.vertex_count || c >= occ->mesh.vertex_count)
+                    continue;
+                /* Clipped by the near plane: dropping it only under-occludes */
+                if (sw[a] <= 0.0f || sw[b] <= 0.0f || sw[c] <= 0.0f)
+                    continue;
+                float x[3] = {sx[a], sx[b], sx[c]}, y[3] = {sy[a], sy[b], sy[c]}, w[3] = {sw[a], sw[b], sw[c]};
+                raster_triangle(oc, x, y, w, y0, y1);
+            }
+        }
+    }
+}
+
+/* Each level keeps the farthest (smallest) 1/w of the 2x2 texels below,
+   edge texels repeating on odd sizes */
+static void build_pyramid(OcclusionCuller *oc)
+{
+    for (Uint32 l = 1; l < oc->level_count; l++)
+    {
+        const float *src = oc->levels[l - 1];
+        float *dst = oc->levels[l];
+        Uint32 sw = oc->level_width[l - 1], sh = oc->level_height[l - 1];
+        for (Uint32 y = 0; y < oc->level_height[l]; y++)
+        {
+            const float *r0 = src + (size_t)(y * 2) * sw;
+            const float *r1 = src + (size_t)SDL_min(y * 2 + 1, sh - 1) * sw;
+            float *out = dst + (size_t)y * oc->level_width[l];
+            for (Uint32 x = 0; x < oc->level_width[l]; x++)
+            {
+                Uint32 x0 = x * 2, x1 = SDL_min(x * 2 + 1, sw - 1);
+                out[x] = SDL_min(SDL_min(r0[x0], r0[x1]), SDL_min(r1[x0], r1[x1]));
+            }
+        }
+    }
+}
+
+/*================================================================================
+ * Testing
+ *================================================================================*/
+static bool item_occluded(const OcclusionCuller *oc, const float *b)
+{
+    const Mat4 *m = &oc->frame_view_proj;
+    float min_x = 1e30f, min_y = 1e30f, max_x = -1e30f, max_y = -1e30f, min_w = 1e30f;
+    for (int corner = 0; corner < 8; corner++)
+    {
+        float p[3] = {b[(corner & 1) ? 3 : 0], b[(corner & 2) ? 4 : 1], b[(corner & 4) ? 5 : 2]};
+        float cw = m->m[3] * p[0] + m->m[7] * p[1] + m->m[11] * p[2] + m->m[15];
+        /* Crossing the near plane: it could be anywhere on screen */
+        if (cw <= OCCLUSION_NEAR_W)
+            return false;
+        float iw = 1.0f / cw;
+        float x = (m->m[0] * p[0] + m->m[4] * p[1] + m->m[8] * p[2] + m->m[12]) * iw;
+        float y = (m->m[1] * p[0] + m->m[5] * p[1] + m->m[9] * p[2] + m->m[13]) * iw;
+        min_x = SDL_min(min_x, x), max_x = SDL_max(max_x, x);
+        min_y = SDL_min(min_y, y), max_y = SDL_max(max_y, y);
+        min_w = SDL_min(min_w, cw);
+    }
+
+    /* Pixel rectangle, one pixel larger all round */
+    float fx0 = SDL_floorf((min_x * 0.5f + 0.5f) * (float)oc->width) - 1.0f;
+    float fx1 = SDL_floorf((max_x * 0.5f + 0.5f) * (float)oc->width) + 1.0f;
+    float fy0 = SDL_floorf((0.5f - max_y * 0.5f) * (float)oc->height) - 1.0f;
+    float fy1 = SDL_floorf((0.5f - min_y * 0.5f) * (float)oc->height) + 1.0f;
+    if (fx1 < 0.0f || fy1 < 0.0f || fx0 >= (float)oc->width || fy0 >= (float)oc->height)
+        return false;
+    Uint32 x0 = (Uint32)SDL_max(fx0, 0.0f), x1 = (Uint32)SDL_min(fx1, (float)(oc->width - 1));
+    Uint32 y0 = (Uint32)SDL_max(fy0, 0.0f), y1 = (Uint32)SDL_min(fy1, (float)(oc->height - 1));
+
+    /* The level where the rectangle spans at most 4x4 texels */
+    Uint32 l = 0;
+    while (l + 1 < oc->level_count && ((x1 >> l) - (x0 >> l) > 3 || (y1 >> l) - (y0 >> l) > 3))
+        l++;
+    float nearest = OCCLUSION_DEPTH_BIAS / min_w;
+    const float *level = oc->levels[l];
+    for (Uint32 y = y0 >> l; y <= y1 >> l; y++)
+    {
+        const float *row = level + (size_t)y * oc->level_width[l];
+        for (Uint32 x = x0 >> l; x <= x1 >> l; x++)
+        {
+            if (row[x] <= nearest)
+                return false;
+        }
+    }
+    return true;
+}
+
+static void test_range(void *userdata, size_t begin, size_t end)
+{
+    OcclusionCuller *oc = userdata;
+    SceneBvh *bvh = oc->frame_bvh;
+    int culled = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        if (bvh->visible[i] && item_occluded(oc, &bvh->item_world[i * 6]))
+        {
+            bvh->visible[i] = 0;
+            culled++;
+        }
+    }
+    if (culled)
+        SDL_AddAtomicInt(&oc->frame_culled, culled);
+}
+
+size_t occlusion_cull(OcclusionCuller *oc, SceneBvh *bvh, const SceneGraph *graph, const Mat4 *view_proj)
+{
+    size_t visible = bvh->stats.visible;
+    if (!oc)
+        return visible;
+    oc->stats.tested = (Uint32)visible;
+    oc->stats.culled = 0;
+    oc->stats.raster_ms = 0.0;
+    oc->stats.test_ms = 0.0;
+    if (oc->occluder_count == 0 || visible == 0)
+        return visible;
+
+    Uint64 start = bench_now();
+    oc->frame_graph = graph;
+    oc->frame_bvh = bvh;
+    oc->frame_view_proj = *view_proj;
+    parallel_for(oc->occluder_count, 1, transform_range, oc);
+    parallel_for((oc->height + OCCLUSION_BAND_ROWS - 1) / OCCLUSION_BAND_ROWS, 1, raster_bands, oc);
+    build_pyramid(oc);
+    oc->stats.raster_ms = bench_ms_since(start);
+
+    start = bench_now();
+    SDL_SetAtomicInt(&oc->frame_culled, 0);
+    parallel_for(bvh->item_count, OCCLUSION_TEST_GRAIN, test_range, oc);
+    oc->stats.culled = (Uint32)SDL_GetAtomicInt(&oc->frame_culled);
+    oc->stats.test_ms = bench_ms_since(start);
+    bvh->stats.visible = visible - oc->stats.culled;
+    return bvh->stats.visible;
+}
+
+/*================================================================================
+ * Benchmark — a floor of closed rooms with furniture, camera in one room
+ *================================================================================*/
+#define BENCH_ROOMS 24        /* per side */
+#define BENCH_ROOM_SIZE 10.0f
+#define BENCH_PROPS 12        /* per room */
+
+/* Unit box, 12 triangles */
+static const float box_x[8] = {-0.5f, 0.5f, -0.5f, 0.5f, -0.5f, 0.5f, -0.5f, 0.5f};
+static const float box_y[8] = {0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f};
+static const float box_z[8] = {-0.5f, -0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f};
+static const Uint32 box_indices[36] = {0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+                                       2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5};
+
+void occlusion_benchmark(void)
+{
+    /* Node 0 is the root; each room has its south and west walls (the
+       grid's far edges get theirs too) and its props */
+    const Uint32 walls = 2 * BENCH_ROOMS * (BENCH_ROOMS + 1);
+    const Uint32 props = BENCH_ROOMS * BENCH_ROOMS * BENCH_PROPS;
+    const Uint32 items = walls + props;
+    Sint32 *parent = SDL_malloc((items + 1) * sizeof(Sint32));
+    Uint32 *item_node = SDL_malloc(items * sizeof(Uint32));
+    Uint32 *item_prim = SDL_calloc(items, sizeof(Uint32));
+    float *bounds = SDL_malloc(items * 6 * sizeof(float));
+    OcclusionMesh *meshes = SDL_malloc(walls * sizeof(OcclusionMesh));
+    SceneGraph *graph = NULL;
+    SceneBvh *bvh = NULL;
+    OcclusionCuller *oc = NULL;
+    if (!parent || !item_node || !item_prim || !bounds || !meshes)
+        goto done;
+
+    parent[0] = -1;
+    for (Uint32 i = 1; i <= items; i++)
+        parent[i] = 0;
+    graph = scene_graph_create(items + 1, parent);
+    if (!graph)
+        goto done;
+
+    const float half = BENCH_ROOMS * BENCH_ROOM_SIZE * 0.5f;
+    Uint32 node = 1, wall = 0;
+    Uint64 seed = 7;
+    for (Uint32 i = 0; i < BENCH_ROOMS + 1; i++)
+    {
+        for (Uint32 j = 0; j < BENCH_ROOMS; j++)
+        {
+            /* A wall along x at z = i, and one along z at x = i */
+            float along = ((float)j + 0.5f) * BENCH_ROOM_SIZE - half, at = (float)i * BENCH_ROOM_SIZE - half;
+            float tx[3] = {along, 0.0f, at}, sx[3] = {BENCH_ROOM_SIZE + 0.2f, 3.0f, 0.2f};
+            float tz[3] = {at, 0.0f, along}, sz[3] = {0.2f, 3.0f, BENCH_ROOM_SIZE + 0.2f};
+            for (int k = 0; k < 2; k++)
+            {
+                scene_graph_set_trs(graph, node, k ? tz : tx, NULL, k ? sz : sx);
+                meshes[wall] = (OcclusionMesh){{box_x, box_y, box_z}, 8, box_indices, 36, node};
+                item_node[wall] = node;
+                wall++, node++;
+            }
+        }
+    }
+    for (Uint32 p = 0; p < props; p++, node++)
+    {
+        Uint32 room = p / BENCH_PROPS;
+        float x0 = (float)(room % BENCH_ROOMS) * BENCH_ROOM_SIZE - half;
+        float z0 = (float)(room / BENCH_ROOMS) * BENCH_ROOM_SIZE - half;
+        float t[3] = {x0 + 1.5f + (float)SDL_rand_r(&seed, 70) * 0.1f, 0.0f,
+                      z0 + 1.5f + (float)SDL_rand_r(&seed, 70) * 0.1f};
+        float s[3] = {0.5f + (float)SDL_rand_r(&seed, 10) * 0.1f, 0.5f + (float)SDL_rand_r(&seed, 15) * 0.1f,
+                      0.5f + (float)SDL_rand_r(&seed, 10) * 0.1f};
+        scene_graph_set_trs(graph, node, t, NULL, s);
+        item_node[walls + p] = node;
+    }
+    for (Uint32 i = 0; i < items; i++)
+    {
+        float *b = &bounds[i * 6];
+        b[0] = -0.5f, b[1] = 0.0f, b[2] = -0.5f;
+        b[3] = 0.5f, b[4] = 1.0f, b[5] = 0.5f;
+    }
+    scene_graph_update(graph);
+    bvh = scene_bvh_create(graph, items, item_node, item_prim, bounds);
+    oc = occlusion_create(OCCLUSION_DEFAULT_WIDTH, OCCLUSION_DEFAULT_HEIGHT);
+    if (!bvh || !oc || !occlusion_set_occluders(oc, meshes, walls))
+        goto done;
+
+    /* Turn around in place in a room near the middle */
+    const Uint32 home = (BENCH_ROOMS / 2) * BENCH_ROOMS + BENCH_ROOMS / 2;
+    const float hx = (float)(home % BENCH_ROOMS) * BENCH_ROOM_SIZE - half + BENCH_ROOM_SIZE * 0.5f;
+    const float hz = (float)(home / BENCH_ROOMS) * BENCH_ROOM_SIZE - half + BENCH_ROOM_SIZE * 0.5f;
+    Mat4 proj, view, vp;
+    mat4_perspective(&proj, 60.0f * SDL_PI_F / 180.0f, 16.0f / 9.0f, 0.1f, 500.0f);
+    const float up[3] = {0.0f, 1.0f, 0.0f};
+    const int frames = 120;
+    double raster_ms = 0.0, test_ms = 0.0;
+    Uint64 tested = 0, culled = 0;
+    for (int f = 0; f < frames; f++)
+    {
+        float angle = (float)f / (float)frames * 2.0f * SDL_PI_F;
+        float eye[3] = {hx, 1.7f, hz};
+        float target[3] = {hx + SDL_cosf(angle), 1.2f, hz + SDL_sinf(angle)};
+        mat4_look_at(&view, eye, target, up);
+        mat4_mul(&vp, &proj, &view);
+
+        scene_bvh_cull(bvh, &vp);
+        occlusion_cull(oc, bvh, graph, &vp);
+        const OcclusionStats *stats = occlusion_stats(oc);
+        raster_ms += stats->raster_ms;
+        test_ms += stats->test_ms;
+        tested += stats->tested;
+        culled += stats->culled;
+    }
+
+    const OcclusionStats *stats = occlusion_stats(oc);
+    SDL_Log("Occlusion (%u occluders, %u triangles, %ux%u, %u items): %.1f%% of frustum-visible items culled, "
+            "raster %.3f ms, test %.3f ms per frame on %d workers",
+            stats->occluders, stats->occluder_triangles, oc->width, oc->height, items,
+            tested ? 100.0 * (double)culled / (double)tested : 0.0, raster_ms / frames, test_ms / frames,
+            parallel_worker_count());
+
+done:
+    occlusion_destroy(oc);
+    scene_bvh_free(bvh);
+    scene_graph_free(graph);
+    SDL_free(parent);
+    SDL_free(item_node);
+    SDL_free(item_prim);
+    SDL_free(bounds);
+    SDL_free(meshes);
+}
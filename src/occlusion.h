@@ -0,0 +1,76 @@
+#ifndef CUMULUS_OCCLUSION_H
+#define CUMULUS_OCCLUSION_H
+
+#include "vecmath.h"
+#include <SDL3/SDL.h>
+
+struct Model;
+struct SceneBvh;
+struct SceneGraph;
+
+/* Software occlusion culling, entirely on the CPU.
+
+   A few large occluder meshes are rasterized each frame into a small
+   depth buffer, 4 pixels at a time, in horizontal bands on the worker
+   pool. The buffer holds 1/w, so depth is linear in screen space and
+   equally precise near and far. A pyramid of per-texel farthest depths
+   is built over it, and every item the frustum cull left visible is
+   tested on the workers: its AABB is projected, and it is culled when
+   its nearest point is behind the pyramid texels its rectangle covers.
+   Triangles crossing the near plane are skipped and rectangles grow by a
+   pixel, so occluders can only under-occlude. */
+typedef struct OcclusionCuller OcclusionCuller;
+
+#define OCCLUSION_DEFAULT_WIDTH 320
+#define OCCLUSION_DEFAULT_HEIGHT 192
+#define OCCLUSION_DEFAULT_OCCLUDERS 64
+#define OCCLUSION_MAX_MESH_TRIANGLES 4096 /* larger primitives are not worth drawing at this resolution */
+#define OCCLUSION_MAX_TRIANGLES 65536     /* over all occluders */
+
+/* Triangles in a scene node's space, placed by its world matrix */
+typedef struct OcclusionMesh
+{
+    const float *position[3]; /* x, y, z streams */
+    size_t vertex_count;
+    const Uint32 *indices;
+    size_t index_count;
+    Uint32 node;
+} OcclusionMesh;
+
+typedef struct OcclusionStats
+{
+    Uint32 occluders;
+    Uint32 occluder_triangles;
+    Uint32 tested;    /* items the frustum cull left visible */
+    Uint32 culled;    /* of those, hidden behind occluders */
+    double raster_ms; /* transform, rasterization and pyramid */
+    double test_ms;
+} OcclusionStats;
+
+/* Depth buffer of width x height pixels; width is rounded up to 4 */
+OcclusionCuller *occlusion_create(Uint32 width, Uint32 height);
+void occlusion_destroy(OcclusionCuller *culler);
+
+/* Replace the occluders. The meshes' streams and indices are referenced,
+   not copied, and must outlive their use. */
+bool occlusion_set_occluders(OcclusionCuller *culler, const OcclusionMesh *meshes, Uint32 count);
+
+/* Use the `max_occluders` opaque triangle primitives of `bvh`'s items with
+   the largest world bounds, within the triangle limits. Returns how many
+   were chosen. */
+Uint32 occlusion_select_occluders(OcclusionCuller *culler, const struct Model *model, const struct SceneBvh *bvh,
+                                  Uint32 max_occluders);
+
+/* Rasterize the occluders for view_proj and clear bvh->visible for the
+   items they hide. Call after scene_bvh_cull. Returns the items still
+   visible. */
+size_t occlusion_cull(OcclusionCuller *culler, struct SceneBvh *bvh, const struct SceneGraph *graph,
+                      const Mat4 *view_proj);
+
+const OcclusionStats *occlusion_stats(const OcclusionCuller *culler);
+
+/* Culls a synthetic building of closed rooms from inside one of them.
+   Logs the culled share and the rasterization and test times. */
+void occlusion_benchmark(void);
+
+#endif /* CUMULUS_OCCLUSION_H */
@@ -0,0 +1,738 @@
+#include "parallel.h"
+#include "bench.h"
+
+#include <SDL3/SDL.h>
+
+#define PARALLEL_MAX_WORKERS 64
+#define PARALLEL_MAX_THREADS (PARALLEL_MAX_WORKERS + 1) /* workers + the thread that started the pool */
+#define PARALLEL_QUEUE_SIZE 1024                         /* background FIFO, power of two */
+#define PARALLEL_MAX_JOBS 4096                           /* job slots, power of two */
+#define PARALLEL_DEQUE_SIZE 1024                         /* per thread, power of two */
+#define PARALLEL_MAX_DEPENDENTS 16                       /* jobs one job can release; more wait at spawn */
+#define PARALLEL_IDLE_SPINS 256
+#define PARALLEL_CACHE_LINE 64
+
+typedef struct ParallelTask
+{
+    ParallelTaskFn fn;
+    void *userdata;
+} ParallelTask;
+
+/* One job slot. It is queued once `unfinished` drops to zero: one count
+   per dependency not yet done, plus one held by spawn until every
+   dependency has been recorded. */
+typedef struct Job
+{
+    ParallelTaskFn fn;
+    void *userdata;
+    SDL_AtomicInt unfinished;
+    SDL_SpinLock lock; /* guards the fields below */
+    Uint32 generation;
+    bool done; /* free for reuse */
+    int dependent_count;
+    Uint32 dependents[PARALLEL_MAX_DEPENDENTS];
+} Job;
+
+/* Chase-Lev deque of job indices. The owner pushes and pops at the
+   bottom; any thread steals from the top. The indices only grow, and
+   differences are taken in unsigned arithmetic, so wrapping is harmless. */
+typedef struct Deque
+{
+    SDL_AtomicInt top;
+    Uint8 pad0[PARALLEL_CACHE_LINE - sizeof(SDL_AtomicInt)];
+    SDL_AtomicInt bottom;
+    Uint8 pad1[PARALLEL_CACHE_LINE - sizeof(SDL_AtomicInt)];
+    Uint32 items[PARALLEL_DEQUE_SIZE];
+} Deque;
+
+static struct
+{
+    SDL_Thread *threads[PARALLEL_MAX_WORKERS];
+    int worker_count;
+    int thread_count; /* deques in use, fixed while the pool runs */
+    bool running;
+    SDL_AtomicInt quit;
+    SDL_AtomicInt sleepers;
+    SDL_Semaphore *wake;
+
+    /* background FIFO */
+    SDL_Mutex *mutex;
+    ParallelTask queue[PARALLEL_QUEUE_SIZE];
+    Uint32 head;
+    Uint32 tail;
+    SDL_AtomicInt queued;
+
+    SDL_AtomicInt next_job;
+    Job jobs[PARALLEL_MAX_JOBS];
+    Deque deques[PARALLEL_MAX_THREADS];
+} pool;
+
+/* Deque index + 1 of the calling thread; 0 outside the pool */
+static SDL_TLSID thread_slot;
+
+static int current_thread(void)
+{
+    return (int)(intptr_t)SDL_GetTLS(&thread_slot) - 1;
+}
+
+/*================================================================================
+ * Deques
+ *================================================================================*/
+static bool deque_push(Deque *d, Uint32 job)
+{
+    Uint32 b = (Uint32)SDL_GetAtomicInt(&d->bottom);
+    Uint32 t = (Uint32)SDL_GetAtomicInt(&d->top);
+    if (b - t >= PARALLEL_DEQUE_SIZE)
+    {
+        return false;
+    }
+    d->items[b & (PARALLEL_DEQUE_SIZE - 1)] = job;
+    SDL_SetAtomicInt(&d->bottom, (int)(b + 1));
+    return true;
+}
+
+static bool deque_pop(Deque *d, Uint32 *job)
+{
+    Uint32 b = (Uint32)SDL_GetAtomicInt(&d->bottom) - 1;
+    SDL_SetAtomicInt(&d->bottom, (int)b);
+    Uint32 t = (Uint32)SDL_GetAtomicInt(&d->top);
+    Sint32 size = (Sint32)(b - t);
+    if (size < 0)
+    {
+        SDL_SetAtomicInt(&d->bottom, (int)(b + 1));
+        return false;
+    }
+    *job = d->items[b & (PARALLEL_DEQUE_SIZE - 1)];
+    if (size > 0)
+    {
+        return true;
+    }
+
+    /* Last item: race the thieves for it */
+    bool won = SDL_CompareAndSwapAtomicInt(&d->top, (int)t, (int)(t + 1));
+    SDL_SetAtomicInt(&d->bottom, (int)(b + 1));
+    return won;
+}
+
+static bool deque_steal(Deque *d, Uint32 *job)
+{
+    Uint32 t = (Uint32)SDL_GetAtomicInt(&d->top);
+    Uint32 b = (Uint32)SDL_GetAtomicInt(&d->bottom);
+    if ((Sint32)(b - t) <= 0)
+    {
+        return false;
+    }
+    *job = d->items[t & (PARALLEL_DEQUE_SIZE - 1)];
+    return SDL_CompareAndSwapAtomicInt(&d->top, (int)t, (int)(t + 1));
+}
+
+static bool deque_empty(Deque *d)
+{
+    return (Sint32)((Uint32)SDL_GetAtomicInt(&d->bottom) - (Uint32)SDL_GetAtomicInt(&d->top)) <= 0;
+}
+
+/*================================================================================
+ * Jobs
+ *================================================================================*/
+static void wake_one(void)
+{
+    if (SDL_GetAtomicInt(&pool.sleepers) > 0)
+    {
+        SDL_SignalSemaphore(pool.wake);
+    }
+}
+
+static void job_run(Uint32 index);
+
+/* All dependencies done: onto this thread's deque, or run now if it has none */
+static void job_ready(Uint32 index)
+{
+    int self = current_thread();
+    if (self < 0 || !deque_push(&pool.deques[self], index))
+    {
+        job_run(index);
+        return;
+    }
+    wake_one();
+}
+
+static void job_release(Uint32 index)
+{
+    if (SDL_AddAtomicInt(&pool.jobs[index].unfinished, -1) == 1)
+    {
+        job_ready(index);
+    }
+}
+
+static void job_run(Uint32 index)
+{
+    Job *job = &pool.jobs[index];
+    job->fn(job->userdata);
+
+    Uint32 dependents[PARALLEL_MAX_DEPENDENTS];
+    SDL_LockSpinlock(&job->lock);
+    int count = job->dependent_count;
+    SDL_memcpy(dependents, job->dependents, (size_t)count * sizeof(Uint32));
+    job->dependent_count = 0;
+    job->done = true;
+    SDL_UnlockSpinlock(&job->lock);
+
+    for (int i = 0; i < count; i++)
+    {
+        job_release(dependents[i]);
+    }
+}
+
+/* A free slot, or false when every slot is in flight */
+static bool job_claim(Uint32 *index, Uint32 *generation)
+{
+    for (int attempt = 0; attempt < PARALLEL_MAX_JOBS; attempt++)
+    {
+        Uint32 i = (Uint32)SDL_AddAtomicInt(&pool.next_job, 1) & (PARALLEL_MAX_JOBS - 1);
+        Job *job = &pool.jobs[i];
+        if (!SDL_TryLockSpinlock(&job->lock))
+        {
+            continue;
+        }
+        bool free = job->done;
+        if (free)
+        {
+            job->done = false;
+            job->generation = job->generation + 1 ? job->generation + 1 : 1;
+            *generation = job->generation;
+        }
+        SDL_UnlockSpinlock(&job->lock);
+        if (free)
+        {
+            *index = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool steal_any(int self, Uint32 *rng, Uint32 *job)
+{
+    *rng ^= *rng << 13;
+    *rng ^= *rng >> 17;
+    *rng ^= *rng << 5;
+    int start = (int)(*rng % (Uint32)pool.thread_count);
+    for (int i = 0; i < pool.thread_count; i++)
+    {
+        int victim = (start + i) % pool.thread_count;
+        if (victim != self && deque_steal(&pool.deques[victim], job))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Own deque first (newest job, still warm in cache), then steal */
+static bool run_one(int self, Uint32 *rng)
+{
+    Uint32 job;
+    if ((self >= 0 && deque_pop(&pool.deques[self], &job)) || steal_any(self, rng, &job))
+    {
+        job_run(job);
+        return true;
+    }
+    return false;
+}
+
+static bool run_background(void)
+{
+    if (SDL_GetAtomicInt(&pool.queued) == 0)
+    {
+        return false;
+    }
+    SDL_LockMutex(pool.mutex);
+    if (pool.head == pool.tail)
+    {
+        SDL_UnlockMutex(pool.mutex);
+        return false;
+    }
+    ParallelTask task = pool.queue[pool.head++ & (PARALLEL_QUEUE_SIZE - 1)];
+    SDL_AddAtomicInt(&pool.queued, -1);
+    SDL_UnlockMutex(pool.mutex);
+
+    task.fn(task.userdata);
+    return true;
+}
+
+static bool has_work(void)
+{
+    if (SDL_GetAtomicInt(&pool.queued) > 0)
+    {
+        return true;
+    }
+    for (int i = 0; i < pool.thread_count; i++)
+    {
+        if (!deque_empty(&pool.deques[i]))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int SDLCALL parallel_worker_main(void *data)
+{
+    int self = (int)(intptr_t)data;
+    SDL_SetTLS(&thread_slot, (void *)(intptr_t)(self + 1), NULL);
+    Uint32 rng = (Uint32)self * 0x9E3779B9u + 1;
+    int idle = 0;
+    for (;;)
+    {
+        if (run_one(self, &rng) || run_background())
+        {
+            idle = 0;
+            continue;
+        }
+        if (SDL_GetAtomicInt(&pool.quit))
+        {
+            /* quit requested and nothing left to run */
+            break;
+        }
+        if (++idle < PARALLEL_IDLE_SPINS)
+        {
+            SDL_CPUPauseInstruction();
+            continue;
+        }
+
+        /* Count ourselves as asleep before the last look, so a producer
+           that pushes after it is sure to see us and signal */
+        SDL_AddAtomicInt(&pool.sleepers, 1);
+        if (!has_work() && !SDL_GetAtomicInt(&pool.quit))
+        {
+            SDL_WaitSemaphore(pool.wake);
+        }
+        SDL_AddAtomicInt(&pool.sleepers, -1);
+        idle = 0;
+    }
+    return 0;
+}
+
+/*================================================================================
+ * Public API
+ *================================================================================*/
+
+/* Exactly num_workers threads; the caller owns deque 0 */
+static bool pool_start(int num_workers)
+{
+    num_workers = SDL_clamp(num_workers, 0, PARALLEL_MAX_WORKERS);
+
+    pool.mutex = SDL_CreateMutex();
+    pool.wake = SDL_CreateSemaphore(0);
+    if (!pool.mutex || !pool.wake)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create worker pool sync objects: %s", SDL_GetError());
+        parallel_shutdown();
+        return false;
+    }
+    for (int i = 0; i < PARALLEL_MAX_JOBS; i++)
+    {
+        pool.jobs[i].done = true;
+    }
+    SDL_SetTLS(&thread_slot, (void *)(intptr_t)1, NULL);
+    pool.thread_count = num_workers + 1;
+    pool.running = true;
+
+    for (int i = 0; i < num_workers; i++)
+    {
+        char name[32];
+        SDL_snprintf(name, sizeof(name), "cumulus-worker-%d", i);
+        pool.threads[i] = SDL_CreateThread(parallel_worker_main, name, (void *)(intptr_t)(i + 1));
+        if (!pool.threads[i])
+        {
+            SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Couldn't create worker thread: %s", SDL_GetError());
+            break;
+        }
+        pool.worker_count++;
+    }
+    return true;
+}
+
+bool parallel_init(int num_workers)
+{
+    if (pool.running)
+    {
+        return true;
+    }
+    if (num_workers <= 0)
+    {
+        num_workers = SDL_GetNumLogicalCPUCores() - 1;
+    }
+    if (!pool_start(num_workers))
+    {
+        return false;
+    }
+    SDL_Log("Worker pool: %d threads", pool.worker_count);
+    return true;
+}
+
+void parallel_shutdown(void)
+{
+    if (pool.running)
+    {
+        SDL_SetAtomicInt(&pool.quit, 1);
+        for (int i = 0; i < pool.worker_count; i++)
+        {
+            SDL_SignalSemaphore(pool.wake);
+        }
+    }
+
+    for (int i = 0; i < pool.worker_count; i++)
+    {
+        SDL_WaitThread(pool.threads[i], NULL);
+    }
+
+    if (pool.wake)
+        SDL_DestroySemaphore(pool.wake);
+    if (pool.mutex)
+        SDL_DestroyMutex(pool.mutex);
+
+    SDL_zero(pool);
+}
+
+int parallel_worker_count(void)
+{
+    return pool.worker_count;
+}
+
+void parallel_submit(ParallelTaskFn fn, void *userdata)
+{
+    if (pool.worker_count == 0)
+    {
+        fn(userdata);
+        return;
+    }
+
+    SDL_LockMutex(pool.mutex);
+    if (pool.tail - pool.head >= PARALLEL_QUEUE_SIZE)
+    {
+        SDL_UnlockMutex(pool.mutex);
+        fn(userdata);
+        return;
+    }
+    pool.queue[pool.tail++ & (PARALLEL_QUEUE_SIZE - 1)] = (ParallelTask){fn, userdata};
+    SDL_AddAtomicInt(&pool.queued, 1);
+    SDL_UnlockMutex(pool.mutex);
+    wake_one();
+}
+
+bool parallel_done(ParallelJob handle)
+{
+    if (handle.generation == 0)
+    {
+        return true;
+    }
+    Job *job = &pool.jobs[handle.index & (PARALLEL_MAX_JOBS - 1)];
+    SDL_LockSpinlock(&job->lock);
+    bool done = job->generation != handle.generation || job->done;
+    SDL_UnlockSpinlock(&job->lock);
+    return done;
+}
+
+void parallel_wait(ParallelJob handle)
+{
+    int self = current_thread();
+    Uint32 rng = (Uint32)(self + 2) * 0x85EBCA6Bu;
+    int idle = 0;
+    while (!parallel_done(handle))
+    {
+        if (run_one(self, &rng))
+        {
+            idle = 0;
+        }
+        else if (++idle < PARALLEL_IDLE_SPINS)
+        {
+            SDL_CPUPauseInstruction();
+        }
+        else
+        {
+            /* The job is running elsewhere; let its thread have the core */
+            SDL_DelayNS(0);
+        }
+    }
+}
+
+ParallelJob parallel_spawn(ParallelTaskFn fn, void *userdata, const ParallelJob *deps, int dep_count)
+{
+    ParallelJob handle = {0, 0};
+    if (pool.worker_count == 0 || current_thread() < 0 || !job_claim(&handle.index, &handle.generation))
+    {
+        for (int i = 0; i < dep_count; i++)
+        {
+            parallel_wait(deps[i]);
+        }
+        fn(userdata);
+        return (ParallelJob){0, 0};
+    }
+
+    Job *job = &pool.jobs[handle.index];
+    job->fn = fn;
+    job->userdata = userdata;
+    SDL_SetAtomicInt(&job->unfinished, 1);
+
+    for (int i = 0; i < dep_count; i++)
+    {
+        if (deps[i].generation == 0)
+        {
+            continue;
+        }
+        Job *dep = &pool.jobs[deps[i].index & (PARALLEL_MAX_JOBS - 1)];
+        bool full = false;
+        SDL_LockSpinlock(&dep->lock);
+        if (dep->generation == deps[i].generation && !dep->done)
+        {
+            if (dep->dependent_count < PARALLEL_MAX_DEPENDENTS)
+            {
+                SDL_AddAtomicInt(&job->unfinished, 1);
+                dep->dependents[dep->dependent_count++] = handle.index;
+            }
+            else
+            {
+                full = true;
+            }
+        }
+        SDL_UnlockSpinlock(&dep->lock);
+        if (full)
+        {
+            parallel_wait(deps[i]);
+        }
+    }
+
+    job_release(handle.index);
+    return handle;
+}
+
+/* Shared state of one parallel_for call; it lives on the caller's stack,
+   which is safe because the caller waits for every helper job */
+typedef struct ParallelRange
+{
+    ParallelRangeFn fn;
+    void *userdata;
+    size_t count;
+    size_t grain;
+    int num_chunks;
+    SDL_AtomicInt next_chunk;
+} ParallelRange;
+
+static void parallel_range_run(void *userdata)
+{
+    ParallelRange *range = userdata;
+    for (;;)
+    {
+        int chunk = SDL_AddAtomicInt(&range->next_chunk, 1);
+        if (chunk >= range->num_chunks)
+        {
+            break;
+        }
+
+        size_t begin = (size_t)chunk * range->grain;
+        size_t end = begin + range->grain < range->count ? begin + range->grain : range->count;
+        range->fn(range->userdata, begin, end);
+    }
+}
+
+void parallel_for(size_t count, size_t grain, ParallelRangeFn fn, void *userdata)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    if (grain == 0)
+    {
+        grain = 1;
+    }
+
+    size_t num_chunks = (count + grain - 1) / grain;
+    if (pool.worker_count == 0 || num_chunks < 2)
+    {
+        fn(userdata, 0, count);
+        return;
+    }
+    if (num_chunks > SDL_MAX_SINT32)
+    {
+        grain = (count + SDL_MAX_SINT32 - 1) / SDL_MAX_SINT32;
+        num_chunks = (count + grain - 1) / grain;
+    }
+
+    ParallelRange range;
+    range.fn = fn;
+    range.userdata = userdata;
+    range.count = count;
+    range.grain = grain;
+    range.num_chunks = (int)num_chunks;
+    SDL_SetAtomicInt(&range.next_chunk, 0);
+
+    /* Helpers claim chunks dynamically; one that starts late finds none */
+    ParallelJob helpers[PARALLEL_MAX_WORKERS];
+    int helper_count = pool.worker_count < range.num_chunks - 1 ? pool.worker_count : range.num_chunks - 1;
+    for (int i = 0; i < helper_count; i++)
+    {
+        helpers[i] = parallel_spawn(parallel_range_run, &range, NULL, 0);
+    }
+
+    parallel_range_run(&range);
+
+    for (int i = 0; i < helper_count; i++)
+    {
+        parallel_wait(helpers[i]);
+    }
+}
+
+/*================================================================================
+ * Benchmark
+ *================================================================================*/
+#define BENCH_FOR_ITEMS (1u << 21)
+#define BENCH_FOR_GRAIN 2048
+#define BENCH_GRAPHS 16
+#define BENCH_FAN 32 /* joins per graph, and leaves per join */
+#define BENCH_LEAF_WORK 400
+
+static float bench_work(float x, int iterations)
+{
+    for (int k = 0; k < iterations; k++)
+    {
+        x = SDL_sinf(x) * 0.5f + x * 0.75f + 0.001f;
+    }
+    return x;
+}
+
+static void bench_for_range(void *userdata, size_t begin, size_t end)
+{
+    float *out = userdata;
+    for (size_t i = begin; i < end; i++)
+    {
+        out[i] = bench_work((float)(i & 1023) * 0.001f, 16);
+    }
+}
+
+typedef struct BenchJoin
+{
+    float *leaves; /* BENCH_FAN values */
+    float *out;
+} BenchJoin;
+
+static void bench_leaf(void *userdata)
+{
+    float *value = userdata;
+    *value = bench_work(*value, BENCH_LEAF_WORK);
+}
+
+static void bench_join(void *userdata)
+{
+    BenchJoin *join = userdata;
+    float sum = 0.0f;
+    for (int i = 0; i < BENCH_FAN; i++)
+    {
+        sum += join->leaves[i];
+    }
+    *join->out = sum;
+}
+
+/* Leaves -> joins -> root, spawned as dependency graphs. Returns the sum
+   of every root, which does not depend on the thread count. */
+static double bench_graphs(float *leaves, float *joins, BenchJoin *join_data, float *roots, double *ms)
+{
+    Uint64 start = bench_now();
+    ParallelJob join_jobs[BENCH_FAN];
+    ParallelJob leaf_jobs[BENCH_FAN];
+    for (int g = 0; g < BENCH_GRAPHS; g++)
+    {
+        for (int j = 0; j < BENCH_FAN; j++)
+        {
+            float *leaf = &leaves[(g * BENCH_FAN + j) * BENCH_FAN];
+            for (int l = 0; l < BENCH_FAN; l++)
+            {
+                leaf[l] = (float)(j * BENCH_FAN + l) * 0.01f;
+                leaf_jobs[l] = parallel_spawn(bench_leaf, &leaf[l], NULL, 0);
+            }
+            BenchJoin *join = &join_data[g * BENCH_FAN + j];
+            join->leaves = leaf;
+            join->out = &joins[g * BENCH_FAN + j];
+            join_jobs[j] = parallel_spawn(bench_join, join, leaf_jobs, BENCH_FAN);
+        }
+        BenchJoin *root = &join_data[BENCH_GRAPHS * BENCH_FAN + g];
+        root->leaves = &joins[g * BENCH_FAN];
+        root->out = &roots[g];
+        parallel_wait(parallel_spawn(bench_join, root, join_jobs, BENCH_FAN));
+    }
+    *ms = bench_ms_since(start);
+
+    double total = 0.0;
+    for (int g = 0; g < BENCH_GRAPHS; g++)
+    {
+        total += roots[g];
+    }
+    return total;
+}
+
+void parallel_benchmark(void)
+{
+    bool was_running = pool.running;
+    int restore = pool.worker_count;
+    parallel_shutdown();
+
+    int cores = SDL_clamp(SDL_GetNumLogicalCPUCores(), 1, PARALLEL_MAX_THREADS);
+    size_t leaf_count = (size_t)BENCH_GRAPHS * BENCH_FAN * BENCH_FAN;
+    float *out = SDL_malloc(BENCH_FOR_ITEMS * sizeof(float));
+    float *reference = SDL_malloc(BENCH_FOR_ITEMS * sizeof(float));
+    float *leaves = SDL_malloc(leaf_count * sizeof(float));
+    float *joins = SDL_malloc((size_t)BENCH_GRAPHS * BENCH_FAN * sizeof(float));
+    float *roots = SDL_malloc(BENCH_GRAPHS * sizeof(float));
+    BenchJoin *join_data = SDL_malloc((size_t)BENCH_GRAPHS * (BENCH_FAN + 1) * sizeof(BenchJoin));
+    if (!out || !reference || !leaves || !joins || !roots || !join_data)
+    {
+        SDL_Log("Job system benchmark: out of memory");
+        goto done;
+    }
+
+    SDL_Log("Job system benchmark: parallel_for over %u items (grain %u), %d graphs of %zu jobs", BENCH_FOR_ITEMS,
+            BENCH_FOR_GRAIN, BENCH_GRAPHS, (size_t)BENCH_FAN * BENCH_FAN + BENCH_FAN + 1);
+    double base_for = 0.0, base_jobs = 0.0, expected = 0.0;
+    bool ok = true;
+    for (int threads = 1; threads <= cores; threads = threads == cores ? cores + 1 : SDL_min(threads * 2, cores))
+    {
+        if (threads > 1 && !pool_start(threads - 1))
+        {
+            break;
+        }
+
+        Uint64 start = bench_now();
+        parallel_for(BENCH_FOR_ITEMS, BENCH_FOR_GRAIN, bench_for_range, threads == 1 ? reference : out);
+        double for_ms = bench_ms_since(start);
+        double jobs_ms;
+        double total = bench_graphs(leaves, joins, join_data, roots, &jobs_ms);
+
+        if (threads == 1)
+        {
+            base_for = for_ms;
+            base_jobs = jobs_ms;
+            expected = total;
+        }
+        else
+        {
+            ok = ok && SDL_memcmp(out, reference, BENCH_FOR_ITEMS * sizeof(float)) == 0 && total == expected;
+        }
+        double job_count = (double)BENCH_GRAPHS * (BENCH_FAN * BENCH_FAN + BENCH_FAN + 1);
+        SDL_Log("  %2d threads: for %.2f ms (%.2fx), jobs %.2f ms (%.2fx, %.0f jobs/ms)", threads, for_ms,
+                base_for / for_ms, jobs_ms, base_jobs / jobs_ms, job_count / jobs_ms);
+        parallel_shutdown();
+    }
+    SDL_Log("  results %s", ok ? "match the single-threaded run" : "DIFFER from the single-threaded run");
+
+done:
+    SDL_free(out);
+    SDL_free(reference);
+    SDL_free(leaves);
+    SDL_free(joins);
+    SDL_free(roots);
+    SDL_free(join_data);
+    if (was_running)
+    {
+        pool_start(restore);
+    }
+}
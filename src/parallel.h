@@ -0,0 +1,60 @@
+#ifndef CUMULUS_PARALLEL_H
+#define CUMULUS_PARALLEL_H
+
+#include <SDL3/SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Work-stealing scheduler shared by the whole engine. Every pool thread,
+   and the thread that started the pool, owns a deque of jobs: it pushes
+   and pops at one end, idle threads steal from the other. Waiting for a
+   job helps run jobs instead of blocking. Fire-and-forget background
+   tasks (decoding, I/O) go to a separate FIFO that only pool threads
+   take, so a wait on the main thread never picks up a long task. */
+
+/* Fire-and-forget task run on a worker thread */
+typedef void (*ParallelTaskFn)(void *userdata);
+
+/* Processes items [begin, end) of a parallel_for range */
+typedef void (*ParallelRangeFn)(void *userdata, size_t begin, size_t end);
+
+/* Handle to a spawned job; stays valid (and done) after the job's slot is
+   reused. The zero handle is always done. */
+typedef struct ParallelJob
+{
+    Uint32 index;
+    Uint32 generation;
+} ParallelJob;
+
+/* Start the shared worker pool. num_workers <= 0 picks (logical cores - 1).
+   Without a pool every call below simply runs on the calling thread. */
+bool parallel_init(int num_workers);
+
+/* Finish queued tasks, join workers. Safe to call if never initialised. */
+void parallel_shutdown(void);
+
+/* Number of worker threads (0 when running single-threaded) */
+int parallel_worker_count(void);
+
+/* Queue fn(userdata) on the background FIFO. Runs inline if it is full. */
+void parallel_submit(ParallelTaskFn fn, void *userdata);
+
+/* Run fn(userdata) on the pool once every job in deps is done. Called
+   from a thread outside the pool, it waits for deps and runs inline. */
+ParallelJob parallel_spawn(ParallelTaskFn fn, void *userdata, const ParallelJob *deps, int dep_count);
+
+bool parallel_done(ParallelJob job);
+
+/* Run other jobs until `job` is done */
+void parallel_wait(ParallelJob job);
+
+/* Split [0, count) into chunks of `grain` items and run them across the pool.
+   The calling thread works on chunks too and returns once all are done.
+   May be called from inside a task or another parallel_for. */
+void parallel_for(size_t count, size_t grain, ParallelRangeFn fn, void *userdata);
+
+/* parallel_for and job-graph throughput with 1..N threads. Restarts the
+   pool, so call it only while nothing else uses it. */
+void parallel_benchmark(void);
+
+#endif /* CUMULUS_PARALLEL_H */
@@ -0,0 +1,833 @@
+#include "pipeline_cache.h"
+#include "bench.h"
+
+#include <SDL3/SDL.h>
+
+#ifdef CUMULUS_HAVE_BUILD_ID
+#include "cumulus_build_id.h"
+#else
+#define CUMULUS_BUILD_ID ""
+#endif
+
+#define CACHE_MAGIC 0x434C5043u /* "CPLC" */
+#define CACHE_VERSION 2u
+#define CACHE_MAX_VERTEX_BUFFERS 16
+#define CACHE_MAX_VERTEX_ATTRIBUTES 16
+#define CACHE_MAX_COLOR_TARGETS 8
+#define CACHE_MAX_ENTRYPOINT 64
+
+typedef enum EntryKind
+{
+    ENTRY_SHADER,
+    ENTRY_GRAPHICS,
+    ENTRY_COMPUTE
+} EntryKind;
+
+/* One cached object and the canonical encoding of its creation info. The
+   key is the hash of that encoding, and the encoding is what goes to disk,
+   so a loaded entry is recreated by exactly the code path that made it. */
+typedef struct CacheEntry
+{
+    Uint64 key;
+    EntryKind kind;
+    Uint8 *blob;
+    Uint32 blob_size;
+    void *object;
+    bool used; /* requested this run; only these are saved */
+} CacheEntry;
+
+struct PipelineCache
+{
+    SDL_GPUDevice *device;
+    char *path;
+    CacheEntry *entries; /* shaders always precede the pipelines using them */
+    size_t count;
+    size_t capacity;
+    bool dirty;
+    bool sealed;
+    PipelineCacheStats stats;
+};
+
+/*================================================================================
+ * Encoding
+ *================================================================================*/
+static Uint64 hash_bytes(const Uint8 *data, size_t size)
+{
+    /* FNV-1a */
+    Uint64 h = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++)
+    {
+        h ^= data[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+typedef struct Writer
+{
+    Uint8 *data;
+    size_t size;
+    size_t capacity;
+    bool ok;
+} Writer;
+
+static void put_bytes(Writer *w, const void *bytes, size_t size)
+{
+    if (!w->ok)
+        return;
+    if (w->size + size > w->capacity)
+    {
+        size_t capacity = SDL_max(w->capacity * 2, w->size + size + 256);
+        Uint8 *data = SDL_realloc(w->data, capacity);
+        if (!data)
+        {
+            w->ok = false;
+            return;
+        }
+        w->data = data;
+        w->capacity = capacity;
+    }
+    SDL_memcpy(w->data + w->size, bytes, size);
+    w->size += size;
+}
+
+/* Fixed little-endian layout so the hash does not depend on struct padding */
+static void put_u32(Writer *w, Uint32 v)
+{
+    Uint32 le = SDL_Swap32LE(v);
+    put_bytes(w, &le, 4);
+}
+
+static void put_u64(Writer *w, Uint64 v)
+{
+    Uint64 le = SDL_Swap64LE(v);
+    put_bytes(w, &le, 8);
+}
+
+static void put_f32(Writer *w, float v)
+{
+    Uint32 bits;
+    SDL_memcpy(&bits, &v, 4);
+    put_u32(w, bits);
+}
+
+static void put_blob(Writer *w, const void *bytes, size_t size)
+{
+    put_u32(w, (Uint32)size);
+    put_bytes(w, bytes, size);
+}
+
+static void put_string(Writer *w, const char *s)
+{
+    put_blob(w, s ? s : "", s ? SDL_strlen(s) : 0);
+}
+
+typedef struct Reader
+{
+    const Uint8 *p;
+    size_t left;
+    bool ok;
+} Reader;
+
+static const Uint8 *get_bytes(Reader *r, size_t size)
+{
+    if (!r->ok || r->left < size)
+    {
+        r->ok = false;
+        return NULL;
+    }
+    const Uint8 *p = r->p;
+    r->p += size;
+    r->left -= size;
+    return p;
+}
+
+static Uint32 get_u32(Reader *r)
+{
+    const Uint8 *p = get_bytes(r, 4);
+    Uint32 v = 0;
+    if (p)
+        SDL_memcpy(&v, p, 4);
+    return SDL_Swap32LE(v);
+}
+
+static Uint64 get_u64(Reader *r)
+{
+    const Uint8 *p = get_bytes(r, 8);
+    Uint64 v = 0;
+    if (p)
+        SDL_memcpy(&v, p, 8);
+    return SDL_Swap64LE(v);
+}
+
+static float get_f32(Reader *r)
+{
+    Uint32 bits = get_u32(r);
+    float v;
+    SDL_memcpy(&v, &bits, 4);
+    return v;
+}
+
+static const Uint8 *get_blob(Reader *r, Uint32 *size)
+{
+    *size = get_u32(r);
+    return get_bytes(r, *size);
+}
+
+/* Copies into buf; false if it does not fit */
+static bool get_string(Reader *r, char *buf, size_t buf_size)
+{
+    Uint32 size;
+    const Uint8 *s = get_blob(r, &size);
+    if (!s || size >= buf_size)
+    {
+        r->ok = false;
+        return false;
+    }
+    SDL_memcpy(buf, s, size);
+    buf[size] = '\0';
+    return true;
+}
+
+static void encode_shader(Writer *w, const SDL_GPUShaderCreateInfo *info)
+{
+    put_u32(w, info->format);
+    put_u32(w, info->stage);
+    put_u32(w, info->num_samplers);
+    put_u32(w, info->num_storage_textures);
+    put_u32(w, info->num_storage_buffers);
+    put_u32(w, info->num_uniform_buffers);
+    put_string(w, info->entrypoint);
+    put_blob(w, info->code, info->code_size);
+}
+
+static void encode_compute(Writer *w, const SDL_GPUComputePipelineCreateInfo *info)
+{
+    put_u32(w, info->format);
+    put_u32(w, info->num_samplers);
+    put_u32(w, info->num_readonly_storage_textures);
+    put_u32(w, info->num_readonly_storage_buffers);
+    put_u32(w, info->num_readwrite_storage_textures);
+    put_u32(w, info->num_readwrite_storage_buffers);
+    put_u32(w, info->num_uniform_buffers);
+    put_u32(w, info->threadcount_x);
+    put_u32(w, info->threadcount_y);
+    put_u32(w, info->threadcount_z);
+    put_string(w, info->entrypoint);
+    put_blob(w, info->code, info->code_size);
+}
+
+static void encode_stencil(Writer *w, const SDL_GPUStencilOpState *s)
+{
+    put_u32(w, s->fail_op);
+    put_u32(w, s->pass_op);
+    put_u32(w, s->depth_fail_op);
+    put_u32(w, s->compare_op);
+}
+
+/* Shaders are referenced by key, so identical code shared by two
+   SDL_GPUShader handles still yields one pipeline */
+static void encode_graphics(Writer *w, Uint64 vertex_shader, Uint64 fragment_shader,
+                            const SDL_GPUGraphicsPipelineCreateInfo *info)
+{
+    const SDL_GPUVertexInputState *vi = &info->vertex_input_state;
+    put_u64(w, vertex_shader);
+    put_u64(w, fragment_shader);
+
+    put_u32(w, vi->num_vertex_buffers);
+    for (Uint32 i = 0; i < vi->num_vertex_buffers; i++)
+    {
+        const SDL_GPUVertexBufferDescription *b = &vi->vertex_buffer_descriptions[i];
+        put_u32(w, b->slot);
+        put_u32(w, b->pitch);
+        put_u32(w, b->input_rate);
+        put_u32(w, b->instance_step_rate);
+    }
+    put_u32(w, vi->num_vertex_attributes);
+    for (Uint32 i = 0; i < vi->num_vertex_attributes; i++)
+    {
+        const SDL_GPUVertexAttribute *a = &vi->vertex_attributes[i];
+        put_u32(w, a->location);
+        put_u32(w, a->buffer_slot);
+        put_u32(w, a->format);
+        put_u32(w, a->offset);
+    }
+
+    put_u32(w, info->primitive_type);
+
+    const SDL_GPURasterizerState *rs = &info->rasterizer_state;
+    put_u32(w, rs->fill_mode);
+    put_u32(w, rs->cull_mode);
+    put_u32(w, rs->front_face);
+    put_f32(w, rs->depth_bias_constant_factor);
+    put_f32(w, rs->depth_bias_clamp);
+    put_f32(w, rs->depth_bias_slope_factor);
+    put_u32(w, rs->enable_depth_bias);
+    put_u32(w, rs->enable_depth_clip);
+
+    put_u32(w, info->multisample_state.sample_count);
+    put_u32(w, info->multisample_state.sample_mask);
+    put_u32(w, info->multisample_state.enable_mask);
+
+    const SDL_GPUDepthStencilState *ds = &info->depth_stencil_state;
+    put_u32(w, ds->compare_op);
+    encode_stencil(w, &ds->back_stencil_state);
+    encode_stencil(w, &ds->front_stencil_state);
+    put_u32(w, ds->compare_mask);
+    put_u32(w, ds->write_mask);
+    put_u32(w, ds->enable_depth_test);
+    put_u32(w, ds->enable_depth_write);
+    put_u32(w, ds->enable_stencil_test);
+
+    const SDL_GPUGraphicsPipelineTargetInfo *ti = &info->target_info;
+    put_u32(w, ti->num_color_targets);
+    for (Uint32 i = 0; i < ti->num_color_targets; i++)
+    {
+        const SDL_GPUColorTargetDescription *c = &ti->color_target_descriptions[i];
+        const SDL_GPUColorTargetBlendState *b = &c->blend_state;
+        put_u32(w, c->format);
+        put_u32(w, b->src_color_blendfactor);
+        put_u32(w, b->dst_color_blendfactor);
+        put_u32(w, b->color_blend_op);
+        put_u32(w, b->src_alpha_blendfactor);
+        put_u32(w, b->dst_alpha_blendfactor);
+        put_u32(w, b->alpha_blend_op);
+        put_u32(w, b->color_write_mask);
+        put_u32(w, b->enable_blend);
+        put_u32(w, b->enable_color_write_mask);
+    }
+    put_u32(w, ti->depth_stencil_format);
+    put_u32(w, ti->has_depth_stencil_target);
+}
+
+/*================================================================================
+ * Creation from an encoding
+ *================================================================================*/
+static CacheEntry *find_entry(PipelineCache *cache, EntryKind kind, Uint64 key)
+{
+    /* A handful of entries per run: a linear scan beats a hash table here */
+    for (size_t i = 0; i < cache->count; i++)
+    {
+        if (cache->entries[i].key == key && cache->entries[i].kind == kind)
+            return &cache->entries[i];
+    }
+    return NULL;
+}
+
+static CacheEntry *find_object(PipelineCache *cache, EntryKind kind, const void *object)
+{
+    for (size_t i = 0; i < cache->count; i++)
+    {
+        if (cache->entries[i].object == object && cache->entries[i].kind == kind)
+            return &cache->entries[i];
+    }
+    return NULL;
+}
+
+static void *create_shader(PipelineCache *cache, Reader *r)
+{
+    SDL_GPUShaderCreateInfo info;
+    char entrypoint[CACHE_MAX_ENTRYPOINT];
+    Uint32 code_size;
+    SDL_zero(info);
+    info.format = get_u32(r);
+    info.stage = get_u32(r);
+    info.num_samplers = get_u32(r);
+    info.num_storage_textures = get_u32(r);
+    info.num_storage_buffers = get_u32(r);
+    info.num_uniform_buffers = get_u32(r);
+    get_string(r, entrypoint, sizeof(entrypoint));
+    info.entrypoint = entrypoint;
+    info.code = get_blob(r, &code_size);
+    info.code_size = code_size;
+    return r->ok ? SDL_CreateGPUShader(cache->device, &info) : NULL;
+}
+
+static void *create_compute(PipelineCache *cache, Reader *r)
+{
+    SDL_GPUComputePipelineCreateInfo info;
+    char entrypoint[CACHE_MAX_ENTRYPOINT];
+    Uint32 code_size;
+    SDL_zero(info);
+    info.format = get_u32(r);
+    info.num_samplers = get_u32(r);
+    info.num_readonly_storage_textures = get_u32(r);
+    info.num_readonly_storage_buffers = get_u32(r);
+    info.num_readwrite_storage_textures = get_u32(r);
+    info.num_readwrite_storage_buffers = get_u32(r);
+    info.num_uniform_buffers = get_u32(r);
+    info.threadcount_x = get_u32(r);
+    info.threadcount_y = get_u32(r);
+    info.threadcount_z = get_u32(r);
+    get_string(r, entrypoint, sizeof(entrypoint));
+    info.entrypoint = entrypoint;
+    info.code = get_blob(r, &code_size);
+    info.code_size = code_size;
+    return r->ok ? SDL_CreateGPUComputePipeline(cache->device, &info) : NULL;
+}
+
+static void decode_stencil(Reader *r, SDL_GPUStencilOpState *s)
+{
+    s->fail_op = get_u32(r);
+    s->pass_op = get_u32(r);
+    s->depth_fail_op = get_u32(r);
+    s->compare_op = get_u32(r);
+}
+
+static void *create_graphics(PipelineCache *cache, Reader *r)
+{
+    SDL_GPUVertexBufferDescription buffers[CACHE_MAX_VERTEX_BUFFERS];
+    SDL_GPUVertexAttribute attributes[CACHE_MAX_VERTEX_ATTRIBUTES];
+    SDL_GPUColorTargetDescription targets[CACHE_MAX_COLOR_TARGETS];
+    SDL_GPUGraphicsPipelineCreateInfo info;
+    SDL_zero(info);
+    SDL_zeroa(buffers);
+    SDL_zeroa(attributes);
+    SDL_zeroa(targets);
+
+    CacheEntry *vs = find_entry(cache, ENTRY_SHADER, get_u64(r));
+    CacheEntry *fs = find_entry(cache, ENTRY_SHADER, get_u64(r));
+    if (!vs || !fs || !vs->object || !fs->object)
+        return NULL;
+    info.vertex_shader = vs->object;
+    info.fragment_shader = fs->object;
+
+    SDL_GPUVertexInputState *vi = &info.vertex_input_state;
+    vi->num_vertex_buffers = get_u32(r);
+    if (vi->num_vertex_buffers > CACHE_MAX_VERTEX_BUFFERS)
+        return NULL;
+    for (Uint32 i = 0; i < vi->num_vertex_buffers; i++)
+    {
+        buffers[i].slot = get_u32(r);
+        buffers[i].pitch = get_u32(r);
+        buffers[i].input_rate = get_u32(r);
+        buffers[i].instance_step_rate = get_u32(r);
+    }
+    vi->vertex_buffer_descriptions = buffers;
+    vi->num_vertex_attributes = get_u32(r);
+    if (vi->num_vertex_attributes > CACHE_MAX_VERTEX_ATTRIBUTES)
+        return NULL;
+    for (Uint32 i = 0; i < vi->num_vertex_attributes; i++)
+    {
+        attributes[i].location = get_u32(r);
+        attributes[i].buffer_slot = get_u32(r);
+        attributes[i].format = get_u32(r);
+        attributes[i].offset = get_u32(r);
+    }
+    vi->vertex_attributes = attributes;
+
+    info.primitive_type = get_u32(r);
+
+    SDL_GPURasterizerState *rs = &info.rasterizer_state;
+    rs->fill_mode = get_u32(r);
+    rs->cull_mode = get_u32(r);
+    rs->front_face = get_u32(r);
+    rs->depth_bias_constant_factor = get_f32(r);
+    rs->depth_bias_clamp = get_f32(r);
+    rs->depth_bias_slope_factor = get_f32(r);
+    rs->enable_depth_bias = get_u32(r) != 0;
+    rs->enable_depth_clip = get_u32(r) != 0;
+
+    info.multisample_state.sample_count = get_u32(r);
+    info.multisample_state.sample_mask = get_u32(r);
+    info.multisample_state.enable_mask = get_u32(r) != 0;
+
+    SDL_GPUDepthStencilState *ds = &info.depth_stencil_state;
+    ds->compare_op = get_u32(r);
+    decode_stencil(r, &ds->back_stencil_state);
+    decode_stencil(r, &ds->front_stencil_state);
+    ds->compare_mask = (Uint8)get_u32(r);
+    ds->write_mask = (Uint8)get_u32(r);
+    ds->enable_depth_test = get_u32(r) != 0;
+    ds->enable_depth_write = get_u32(r) != 0;
+    ds->enable_stencil_test = get_u32(r) != 0;
+
+    SDL_GPUGraphicsPipelineTargetInfo *ti = &info.target_info;
+    ti->num_color_targets = get_u32(r);
+    if (ti->num_color_targets > CACHE_MAX_COLOR_TARGETS)
+        return NULL;
+    for (Uint32 i = 0; i < ti->num_color_targets; i++)
+    {
+        SDL_GPUColorTargetBlendState *b = &targets[i].blend_state;
+        targets[i].format = get_u32(r);
+        b->src_color_blendfactor = get_u32(r);
+        b->dst_color_blendfactor = get_u32(r);
+        b->color_blend_op = get_u32(r);
+        b->src_alpha_blendfactor = get_u32(r);
+        b->dst_alpha_blendfactor = get_u32(r);
+        b->alpha_blend_op = get_u32(r);
+        b->color_write_mask = (Uint8)get_u32(r);
+        b->enable_blend = get_u32(r) != 0;
+        b->enable_color_write_mask = get_u32(r) != 0;
+    }
+    ti->color_target_descriptions = targets;
+    ti->depth_stencil_format = get_u32(r);
+    ti->has_depth_stencil_target = get_u32(r) != 0;
+
+    return r->ok ? SDL_CreateGPUGraphicsPipeline(cache->device, &info) : NULL;
+}
+
+static void *create_object(PipelineCache *cache, EntryKind kind, const Uint8 *blob, Uint32 size)
+{
+    Reader r = {blob, size, true};
+    switch (kind)
+    {
+    case ENTRY_SHADER:
+        return create_shader(cache, &r);
+    case ENTRY_GRAPHICS:
+        return create_graphics(cache, &r);
+    case ENTRY_COMPUTE:
+        return create_compute(cache, &r);
+    }
+    return NULL;
+}
+
+static void release_object(PipelineCache *cache, const CacheEntry *e)
+{
+    if (!e->object)
+        return;
+    switch (e->kind)
+    {
+    case ENTRY_SHADER:
+        SDL_ReleaseGPUShader(cache->device, e->object);
+        break;
+    case ENTRY_GRAPHICS:
+        SDL_ReleaseGPUGraphicsPipeline(cache->device, e->object);
+        break;
+    case ENTRY_COMPUTE:
+        SDL_ReleaseGPUComputePipeline(cache->device, e->object);
+        break;
+    }
+}
+
+static void count_entry(PipelineCache *cache, EntryKind kind)
+{
+    if (kind == ENTRY_SHADER)
+        cache->stats.shaders++;
+    else if (kind == ENTRY_GRAPHICS)
+        cache->stats.graphics_pipelines++;
+    else
+        cache->stats.compute_pipelines++;
+}
+
+/* Takes ownership of blob */
+static CacheEntry *add_entry(PipelineCache *cache, EntryKind kind, Uint64 key, Uint8 *blob, Uint32 size, void *object)
+{
+    if (cache->count == cache->capacity)
+    {
+        size_t capacity = cache->capacity ? cache->capacity * 2 : 16;
+        CacheEntry *entries = SDL_realloc(cache->entries, capacity * sizeof(CacheEntry));
+        if (!entries)
+            return NULL;
+        cache->entries = entries;
+        cache->capacity = capacity;
+    }
+    CacheEntry *e = &cache->entries[cache->count++];
+    e->key = key;
+    e->kind = kind;
+    e->blob = blob;
+    e->blob_size = size;
+    e->object = object;
+    e->used = false;
+    if (object)
+        count_entry(cache, kind);
+    return e;
+}
+
+static const char *kind_name(EntryKind kind)
+{
+    return kind == ENTRY_SHADER ? "shader" : kind == ENTRY_GRAPHICS ? "graphics pipeline" : "compute pipeline";
+}
+
+/* Look the encoding up, creating and recording the object on a miss */
+static void *lookup(PipelineCache *cache, EntryKind kind, Writer *w)
+{
+    if (!w->ok)
+    {
+        SDL_free(w->data);
+        return NULL;
+    }
+
+    Uint64 key = hash_bytes(w->data, w->size);
+    CacheEntry *e = find_entry(cache, kind, key);
+    if (e && e->object)
+    {
+        SDL_free(w->data);
+        cache->stats.hits++;
+        e->used = true;
+        return e->object;
+    }
+
+    Uint64 start = bench_now();
+    void *object = create_object(cache, kind, w->data, (Uint32)w->size);
+    double ms = bench_ms_since(start);
+    cache->stats.misses++;
+    cache->stats.create_ms += ms;
+    if (!object)
+    {
+        SDL_Log("Pipeline cache: failed to create %s: %s", kind_name(kind), SDL_GetError());
+        SDL_free(w->data);
+        return NULL;
+    }
+    if (cache->sealed)
+    {
+        cache->stats.late++;
+        SDL_Log("Pipeline cache: %s %016" SDL_PRIx64 " created after startup (%.2f ms); it is prewarmed from now on",
+                kind_name(kind), key, ms);
+    }
+
+    if (e)
+    {
+        /* Recorded on disk but failed to prewarm */
+        SDL_free(w->data);
+        e->object = object;
+        e->used = true;
+        count_entry(cache, kind);
+        cache->dirty = true;
+        return object;
+    }
+    e = add_entry(cache, kind, key, w->data, (Uint32)w->size, object);
+    if (!e)
+    {
+        SDL_free(w->data);
+        release_object(cache, &(CacheEntry){.kind = kind, .object = object});
+        return NULL;
+    }
+    e->used = true;
+    cache->dirty = true;
+    return object;
+}
+
+/*================================================================================
+ * Persistence
+ *================================================================================*/
+/* The build id changes with any source or shader edit, so a rebuilt app
+   never prewarms entries that only an older build asked for */
+static void encode_header(Writer *w, SDL_GPUDevice *device)
+{
+    put_u32(w, CACHE_MAGIC);
+    put_u32(w, CACHE_VERSION);
+    put_u32(w, (Uint32)SDL_GetVersion());
+    put_string(w, SDL_GetGPUDeviceDriver(device));
+    put_string(w, CUMULUS_BUILD_ID);
+}
+
+static bool saved(const CacheEntry *e)
+{
+    return e->object && e->used;
+}
+
+static void load(PipelineCache *cache)
+{
+    size_t size;
+    Uint8 *file = SDL_LoadFile(cache->path, &size);
+    if (!file)
+        return; /* first run */
+
+    Writer header = {NULL, 0, 0, true};
+    encode_header(&header, cache->device);
+    if (!header.ok || size < header.size || SDL_memcmp(file, header.data, header.size) != 0)
+    {
+        SDL_Log("Pipeline cache: %s was written by another driver, version or build, rebuilding", cache->path);
+        SDL_free(header.data);
+        SDL_free(file);
+        cache->dirty = true;
+        return;
+    }
+
+    Uint64 start = bench_now();
+    Reader r = {file + header.size, size - header.size, true};
+    SDL_free(header.data);
+    Uint32 count = get_u32(&r);
+    Uint32 failed = 0;
+    for (Uint32 i = 0; i < count && r.ok; i++)
+    {
+        Uint32 raw_kind = get_u32(&r);
+        Uint64 key = get_u64(&r);
+        Uint32 blob_size;
+        const Uint8 *blob = get_blob(&r, &blob_size);
+        if (!blob || raw_kind > ENTRY_COMPUTE || hash_bytes(blob, blob_size) != key)
+        {
+            r.ok = false;
+            break;
+        }
+        EntryKind kind = (EntryKind)raw_kind;
+        if (find_entry(cache, kind, key))
+            continue;
+
+        Uint8 *copy = SDL_malloc(blob_size ? blob_size : 1);
+        if (!copy)
+            break;
+        SDL_memcpy(copy, blob, blob_size);
+        void *object = create_object(cache, kind, copy, blob_size);
+        if (!object)
+            failed++;
+        if (!add_entry(cache, kind, key, copy, blob_size, object))
+        {
+            SDL_free(copy);
+            release_object(cache, &(CacheEntry){.kind = kind, .object = object});
+            break;
+        }
+        if (object)
+            cache->stats.prewarmed++;
+    }
+    SDL_free(file);
+
+    cache->stats.prewarm_ms = bench_ms_since(start);
+    if (!r.ok)
+    {
+        SDL_Log("Pipeline cache: %s is truncated or corrupt, rewriting it", cache->path);
+        cache->dirty = true;
+    }
+    if (failed)
+        cache->dirty = true; /* entries the driver no longer accepts get recreated or dropped on save */
+    SDL_Log("Pipeline cache: prewarmed %u shaders and pipelines in %.2f ms (%u failed)", cache->stats.prewarmed,
+            cache->stats.prewarm_ms, failed);
+}
+
+bool pipeline_cache_save(PipelineCache *cache)
+{
+    if (!cache || !cache->path)
+        return false;
+
+    Writer w = {NULL, 0, 0, true};
+    encode_header(&w, cache->device);
+    Uint32 count = 0;
+    for (size_t i = 0; i < cache->count; i++)
+        count += saved(&cache->entries[i]);
+    put_u32(&w, count);
+    for (size_t i = 0; i < cache->count; i++)
+    {
+        const CacheEntry *e = &cache->entries[i];
+        if (!saved(e))
+            continue;
+        put_u32(&w, e->kind);
+        put_u64(&w, e->key);
+        put_blob(&w, e->blob, e->blob_size);
+    }
+    if (!w.ok)
+    {
+        SDL_free(w.data);
+        return false;
+    }
+
+    /* Write beside the old file and swap, so a crash never leaves half a cache */
+    char *tmp = NULL;
+    bool ok = SDL_asprintf(&tmp, "%s.tmp", cache->path) > 0 && SDL_SaveFile(tmp, w.data, w.size) &&
+              SDL_RenamePath(tmp, cache->path);
+    if (ok)
+    {
+        cache->dirty = false;
+        SDL_Log("Pipeline cache: saved %u entries (%zu bytes) to %s", count, w.size, cache->path);
+    }
+    else
+        SDL_Log("Pipeline cache: failed to save %s: %s", cache->path, SDL_GetError());
+    SDL_free(tmp);
+    SDL_free(w.data);
+    return ok;
+}
+
+/*================================================================================
+ * Public API
+ *================================================================================*/
+PipelineCache *pipeline_cache_create(SDL_GPUDevice *device, const char *path)
+{
+    PipelineCache *cache = SDL_calloc(1, sizeof(PipelineCache));
+    if (!cache)
+        return NULL;
+    cache->device = device;
+    if (path)
+    {
+        cache->path = SDL_strdup(path);
+        if (!cache->path)
+        {
+            SDL_free(cache);
+            return NULL;
+        }
+        load(cache);
+    }
+    return cache;
+}
+
+void pipeline_cache_destroy(PipelineCache *cache)
+{
+    if (!cache)
+        return;
+
+    /* Also rewrite when something prewarmed was never requested, so the file
+       only ever holds what the last run used */
+    bool stale = false;
+    for (size_t i = 0; i < cache->count && !stale; i++)
+        stale = cache->entries[i].object && !cache->entries[i].used;
+    if (cache->dirty || stale)
+        pipeline_cache_save(cache);
+
+    /* Pipelines first: they were created from the shaders before them */
+    for (size_t i = cache->count; i-- > 0;)
+    {
+        release_object(cache, &cache->entries[i]);
+        SDL_free(cache->entries[i].blob);
+    }
+    SDL_free(cache->entries);
+    SDL_free(cache->path);
+    SDL_free(cache);
+}
+
+SDL_GPUShader *pipeline_cache_shader(PipelineCache *cache, const SDL_GPUShaderCreateInfo *info)
+{
+    Writer w = {NULL, 0, 0, true};
+    encode_shader(&w, info);
+    return lookup(cache, ENTRY_SHADER, &w);
+}
+
+SDL_GPUGraphicsPipeline *pipeline_cache_graphics(PipelineCache *cache, const SDL_GPUGraphicsPipelineCreateInfo *info)
+{
+    const CacheEntry *vs = find_object(cache, ENTRY_SHADER, info->vertex_shader);
+    const CacheEntry *fs = find_object(cache, ENTRY_SHADER, info->fragment_shader);
+    if (!vs || !fs)
+    {
+        SDL_Log("Pipeline cache: graphics pipeline shaders must come from pipeline_cache_shader");
+        return NULL;
+    }
+    if (info->vertex_input_state.num_vertex_buffers > CACHE_MAX_VERTEX_BUFFERS ||
+        info->vertex_input_state.num_vertex_attributes > CACHE_MAX_VERTEX_ATTRIBUTES ||
+        info->target_info.num_color_targets > CACHE_MAX_COLOR_TARGETS)
+    {
+        SDL_Log("Pipeline cache: graphics pipeline exceeds the cached layout limits");
+        return NULL;
+    }
+
+    Writer w = {NULL, 0, 0, true};
+    encode_graphics(&w, vs->key, fs->key, info);
+    return lookup(cache, ENTRY_GRAPHICS, &w);
+}
+
+SDL_GPUComputePipeline *pipeline_cache_compute(PipelineCache *cache, const SDL_GPUComputePipelineCreateInfo *info)
+{
+    Writer w = {NULL, 0, 0, true};
+    encode_compute(&w, info);
+    return lookup(cache, ENTRY_COMPUTE, &w);
+}
+
+void pipeline_cache_seal(PipelineCache *cache)
+{
+    if (cache)
+        cache->sealed = true;
+}
+
+const PipelineCacheStats *pipeline_cache_stats(const PipelineCache *cache)
+{
+    return &cache->stats;
+}
+
+char *pipeline_cache_default_path(void)
+{
+    char *dir = SDL_GetPrefPath("arda", "cumulus");
+    if (!dir)
+        return NULL;
+    char *path = NULL;
+    if (SDL_asprintf(&path, "%spipelines.cache", dir) < 0)
+        path = NULL;
+    SDL_free(dir);
+    return path;
+}
@@ -0,0 +1,59 @@
+#ifndef CUMULUS_PIPELINE_CACHE_H
+#define CUMULUS_PIPELINE_CACHE_H
+
+#include <SDL3/SDL.h>
+
+/* Shaders and pipelines keyed by a 64-bit hash of everything that goes
+   into creating them: code, entry point and resource counts for shaders;
+   shader keys, vertex layout, fixed-function state and target formats for
+   pipelines. Identical requests share one object, owned by the cache.
+
+   SDL_gpu does not expose driver pipeline binaries, so what is persisted
+   is the creation description of every entry. On the next run they are
+   all recreated while the cache loads, before the first frame; the
+   driver's own shader cache makes those creations cheap, and no pipeline
+   is ever compiled mid-frame for something a previous run already used.
+   Only entries requested during a run are saved, and the file is tied to
+   the build that wrote it, so it does not grow with every shader edit. */
+typedef struct PipelineCache PipelineCache;
+
+typedef struct PipelineCacheStats
+{
+    Uint32 shaders;
+    Uint32 graphics_pipelines;
+    Uint32 compute_pipelines;
+    Uint32 prewarmed; /* entries recreated from disk at load */
+    Uint32 hits;      /* requests answered by an existing entry */
+    Uint32 misses;    /* requests that had to create a new object */
+    Uint32 late;      /* misses after pipeline_cache_seal */
+    double prewarm_ms;
+    double create_ms; /* time spent creating on misses */
+} PipelineCacheStats;
+
+/* Load the entries saved at `path` (NULL keeps the cache in memory) and
+   create them all. A file written by another driver, SDL version or
+   build is ignored. Returns NULL on allocation failure. */
+PipelineCache *pipeline_cache_create(SDL_GPUDevice *device, const char *path);
+
+/* Save if anything was created or went unused, then release every object */
+void pipeline_cache_destroy(PipelineCache *cache);
+
+bool pipeline_cache_save(PipelineCache *cache);
+
+/* The returned objects belong to the cache; do not release them */
+SDL_GPUShader *pipeline_cache_shader(PipelineCache *cache, const SDL_GPUShaderCreateInfo *info);
+
+/* info->vertex_shader and fragment_shader must come from pipeline_cache_shader */
+SDL_GPUGraphicsPipeline *pipeline_cache_graphics(PipelineCache *cache, const SDL_GPUGraphicsPipelineCreateInfo *info);
+SDL_GPUComputePipeline *pipeline_cache_compute(PipelineCache *cache, const SDL_GPUComputePipelineCreateInfo *info);
+
+/* Mark the end of startup: any later miss is logged as a frame hitch */
+void pipeline_cache_seal(PipelineCache *cache);
+
+const PipelineCacheStats *pipeline_cache_stats(const PipelineCache *cache);
+
+/* "<pref path>/pipelines.cache", or NULL if there is no writable pref
+   path. Free with SDL_free. */
+char *pipeline_cache_default_path(void);
+
+#endif /* CUMULUS_PIPELINE_CACHE_H */
@@ -0,0 +1,925 @@
+#include "render_graph.h"
+#include "bench.h"
+#include "residency.h"
+
+#include <SDL3/SDL.h>
+
+/* Pool textures unused for this many compiles are released */
+#define POOL_IDLE_FRAMES 8
+
+typedef struct GraphResource
+{
+    const char *name;
+    bool imported;
+    bool is_buffer;
+    SDL_GPUTexture *texture;
+    SDL_GPUBuffer *buffer;
+    SDL_GPUTextureCreateInfo info; /* transients */
+    Uint64 bytes;
+
+    /* Compile results and scratch */
+    Sint32 first; /* execution position of the first kept pass using it, -1 if unused */
+    Sint32 last;
+    Sint32 slot; /* transients: aliasing slot */
+    Uint32 last_writer;
+    Uint64 readers; /* passes that read it since its last write */
+} GraphResource;
+
+typedef struct GraphAccess
+{
+    Uint32 pass;
+    RenderGraphResource resource;
+    bool write;
+} GraphAccess;
+
+typedef struct ColorTarget
+{
+    RenderGraphResource resource;
+    SDL_GPULoadOp load_op;
+    SDL_FColor clear_color;
+} ColorTarget;
+
+typedef struct GraphPass
+{
+    const char *name;
+    RenderGraphPassType type;
+    RenderGraphExecuteFn fn;
+    void *userdata;
+    ColorTarget color[RENDER_GRAPH_MAX_COLOR_TARGETS];
+    Uint32 color_count;
+    RenderGraphResource depth;
+    SDL_GPULoadOp depth_load_op;
+    float clear_depth;
+
+    Uint64 deps;  /* passes that must run before this one */
+    Uint64 needs; /* passes whose output this one reads */
+    bool kept;
+    Sint32 position; /* in the compiled order, -1 if culled */
+    Uint32 batch;    /* copy passes: index of the shared SDL copy pass */
+} GraphPass;
+
+typedef struct PoolTexture
+{
+    SDL_GPUTextureCreateInfo info;
+    SDL_GPUTexture *texture;
+    Uint64 last_frame;
+    bool taken;
+} PoolTexture;
+
+typedef struct AliasSlot
+{
+    RenderGraphResource owner; /* first resource placed here, defines the layout */
+    Sint32 last;               /* last position any resource placed here is used */
+} AliasSlot;
+
+struct RenderGraph
+{
+    SDL_GPUDevice *device;
+    Uint64 frame;
+
+    GraphPass passes[RENDER_GRAPH_MAX_PASSES];
+    Uint32 pass_count;
+    GraphResource resources[RENDER_GRAPH_MAX_RESOURCES];
+    Uint32 resource_count;
+    GraphAccess accesses[RENDER_GRAPH_MAX_ACCESSES];
+    Uint32 access_count;
+
+    Uint32 order[RENDER_GRAPH_MAX_PASSES];
+    Uint32 order_count;
+    AliasSlot slots[RENDER_GRAPH_MAX_RESOURCES];
+    Uint32 slot_count;
+    bool compiled;
+    bool overflow; /* a declaration did not fit; compile fails */
+
+    PoolTexture *pool;
+    Uint32 pool_count;
+    Uint32 pool_capacity;
+
+    RenderGraphStats stats;
+};
+
+/*================================================================================
+ * Declaration
+ *================================================================================*/
+RenderGraph *render_graph_create(SDL_GPUDevice *device)
+{
+    RenderGraph *g = SDL_calloc(1, sizeof(RenderGraph));
+    if (!g)
+        return NULL;
+    g->device = device;
+    return g;
+}
+
+void render_graph_destroy(RenderGraph *g)
+{
+    if (!g)
+        return;
+    for (Uint32 i = 0; i < g->pool_count; i++)
+        residency_release_texture(g->device, g->pool[i].texture);
+    SDL_free(g->pool);
+    SDL_free(g);
+}
+
+void render_graph_begin(RenderGraph *g)
+{
+    g->pass_count = 0;
+    g->resource_count = 0;
+    g->access_count = 0;
+    g->order_count = 0;
+    g->slot_count = 0;
+    g->compiled = false;
+    g->overflow = false;
+}
+
+static RenderGraphResource add_resource(RenderGraph *g, const char *name)
+{
+    if (g->resource_count >= RENDER_GRAPH_MAX_RESOURCES)
+    {
+        g->overflow = true;
+        return RENDER_GRAPH_NONE;
+    }
+    GraphResource *r = &g->resources[g->resource_count];
+    SDL_zerop(r);
+    r->name = name;
+    return g->resource_count++;
+}
+
+RenderGraphResource render_graph_import_texture(RenderGraph *g, const char *name, SDL_GPUTexture *texture)
+{
+    RenderGraphResource id = add_resource(g, name);
+    if (id != RENDER_GRAPH_NONE)
+    {
+        g->resources[id].imported = true;
+        g->resources[id].texture = texture;
+    }
+    return id;
+}
+
+RenderGraphResource render_graph_import_buffer(RenderGraph *g, const char *name, SDL_GPUBuffer *buffer)
+{
+    RenderGraphResource id = add_resource(g, name);
+    if (id != RENDER_GRAPH_NONE)
+    {
+        g->resources[id].imported = true;
+        g->resources[id].is_buffer = true;
+        g->resources[id].buffer = buffer;
+    }
+    return id;
+}
+
+static Uint64 texture_bytes(const SDL_GPUTextureCreateInfo *info)
+{
+    bool volume = info->type == SDL_GPU_TEXTURETYPE_3D;
+    Uint32 levels = SDL_max(info->num_levels, 1);
+    Uint64 total = 0;
+    for (Uint32 level = 0; level < levels; level++)
+    {
+        Uint32 w = SDL_max(info->width >> level, 1);
+        Uint32 h = SDL_max(info->height >> level, 1);
+        Uint32 d = volume ? SDL_max(info->layer_count_or_depth >> level, 1) : 1;
+        total += SDL_CalculateGPUTextureFormatSize(info->format, w, h, d);
+    }
+    if (!volume)
+        total *= SDL_max(info->layer_count_or_depth, 1);
+    return total << info->sample_count; /* SDL_GPU_SAMPLECOUNT_1 is 0 */
+}
+
+RenderGraphResource render_graph_create_texture(RenderGraph *g, const char *name, const SDL_GPUTextureCreateInfo *info)
+{
+    RenderGraphResource id = add_resource(g, name);
+    if (id != RENDER_GRAPH_NONE)
+    {
+        g->resources[id].info = *info;
+        g->resources[id].info.props = 0;
+        g->resources[id].bytes = texture_bytes(info);
+    }
+    return id;
+}
+
+Uint32 render_graph_add_pass(RenderGraph *g, const char *name, RenderGraphPassType type, RenderGraphExecuteFn fn,
+                             void *userdata)
+{
+    if (g->pass_count >= RENDER_GRAPH_MAX_PASSES)
+    {
+        g->overflow = true;
+        return RENDER_GRAPH_NONE;
+    }
+    GraphPass *p = &g->passes[g->pass_count];
+    SDL_zerop(p);
+    p->name = name;
+    p->type = type;
+    p->fn = fn;
+    p->userdata = userdata;
+    p->depth = RENDER_GRAPH_NONE;
+    return g->pass_count++;
+}
+
+static void add_access(RenderGraph *g, Uint32 pass, RenderGraphResource resource, bool write)
+{
+    if (pass >= g->pass_count || resource >= g->resource_count || g->access_count >= RENDER_GRAPH_MAX_ACCESSES)
+    {
+        g->overflow = true;
+        return;
+    }
+    g->accesses[g->access_count++] = (GraphAccess){pass, resource, write};
+}
+
+void render_graph_read(RenderGraph *g, Uint32 pass, RenderGraphResource resource)
+{
+    add_access(g, pass, resource, false);
+}
+
+void render_graph_write(RenderGraph *g, Uint32 pass, RenderGraphResource resource)
+{
+    add_access(g, pass, resource, true);
+}
+
+void render_graph_color_target(RenderGraph *g, Uint32 pass, RenderGraphResource resource, SDL_GPULoadOp load_op,
+                               SDL_FColor clear_color)
+{
+    if (pass >= g->pass_count || g->passes[pass].color_count >= RENDER_GRAPH_MAX_COLOR_TARGETS)
+    {
+        g->overflow = true;
+        return;
+    }
+    GraphPass *p = &g->passes[pass];
+    p->color[p->color_count++] = (ColorTarget){resource, load_op, clear_color};
+    if (load_op == SDL_GPU_LOADOP_LOAD)
+        add_access(g, pass, resource, false);
+    add_access(g, pass, resource, true);
+}
+
+void render_graph_depth_target(RenderGraph *g, Uint32 pass, RenderGraphResource resource, SDL_GPULoadOp load_op,
+                               float clear_depth)
+{
+    if (pass >= g->pass_count)
+    {
+        g->overflow = true;
+        return;
+    }
+    GraphPass *p = &g->passes[pass];
+    p->depth = resource;
+    p->depth_load_op = load_op;
+    p->clear_depth = clear_depth;
+    if (load_op == SDL_GPU_LOADOP_LOAD)
+        add_access(g, pass, resource, false);
+    add_access(g, pass, resource, true);
+}
+
+/*================================================================================
+ * Compile
+ *================================================================================*/
+static void build_dependencies(RenderGraph *g)
+{
+    for (Uint32 i = 0; i < g->resource_count; i++)
+    {
+        g->resources[i].last_writer = RENDER_GRAPH_NONE;
+        g->resources[i].readers = 0;
+    }
+
+    /* Declaration order is program order: a read depends on the last
+       writer, a write on the last writer and every reader since */
+    for (Uint32 p = 0; p < g->pass_count; p++)
+    {
+        GraphPass *pass = &g->passes[p];
+        Uint64 bit = (Uint64)1 << p;
+        pass->deps = 0;
+        pass->needs = 0;
+        pass->kept = false;
+        pass->position = -1;
+
+        for (Uint32 a = 0; a < g->access_count; a++)
+        {
+            const GraphAccess *access = &g->accesses[a];
+            if (access->pass != p)
+                continue;
+            GraphResource *r = &g->resources[access->resource];
+            if (r->last_writer != RENDER_GRAPH_NONE && r->last_writer != p)
+            {
+                pass->deps |= (Uint64)1 << r->last_writer;
+                if (!access->write)
+                    pass->needs |= (Uint64)1 << r->last_writer;
+            }
+            if (access->write)
+            {
+                pass->deps |= r->readers & ~bit;
+                if (r->imported)
+                    pass->kept = true; /* visible outside the graph */
+            }
+        }
+        for (Uint32 a = 0; a < g->access_count; a++)
+        {
+            const GraphAccess *access = &g->accesses[a];
+            if (access->pass != p)
+                continue;
+            GraphResource *r = &g->resources[access->resource];
+            if (access->write)
+            {
+                r->last_writer = p;
+                r->readers = 0;
+            }
+        }
+        for (Uint32 a = 0; a < g->access_count; a++)
+        {
+            const GraphAccess *access = &g->accesses[a];
+            if (access->pass == p && !access->write)
+                g->resources[access->resource].readers |= bit;
+        }
+    }
+
+    /* Keep whatever a kept pass reads from; needs only point backwards */
+    for (Uint32 p = g->pass_count; p-- > 0;)
+    {
+        if (!g->passes[p].kept)
+            continue;
+        for (Uint32 q = 0; q < p; q++)
+        {
+            if (g->passes[p].needs & ((Uint64)1 << q))
+                g->passes[q].kept = true;
+        }
+    }
+}
+
+/* Topological order over the kept passes. While copies are ready after a
+   copy, they are taken first, so independent uploads land in one batch. */
+static void schedule(RenderGraph *g)
+{
+    Uint64 kept = 0;
+    for (Uint32 p = 0; p < g->pass_count; p++)
+    {
+        if (g->passes[p].kept)
+            kept |= (Uint64)1 << p;
+    }
+
+    Uint64 done = 0;
+    bool last_copy = false;
+    g->order_count = 0;
+    while (done != kept)
+    {
+        Sint32 pick = -1, copy = -1;
+        for (Uint32 p = 0; p < g->pass_count; p++)
+        {
+            Uint64 bit = (Uint64)1 << p;
+            if (!(kept & bit) || (done & bit) || (g->passes[p].deps & kept & ~done))
+                continue;
+            if (pick < 0)
+                pick = (Sint32)p;
+            if (copy < 0 && g->passes[p].type == RENDER_GRAPH_COPY)
+                copy = (Sint32)p;
+        }
+        if (last_copy && copy >= 0)
+            pick = copy;
+        if (pick < 0)
+            break; /* cannot happen: dependencies only point backwards */
+        GraphPass *pass = &g->passes[pick];
+        pass->position = (Sint32)g->order_count;
+        g->order[g->order_count++] = (Uint32)pick;
+        done |= (Uint64)1 << pick;
+        last_copy = pass->type == RENDER_GRAPH_COPY;
+    }
+
+    Uint32 batch = 0;
+    g->stats.copy_passes = 0;
+    g->stats.copy_batches = 0;
+    for (Uint32 i = 0; i < g->order_count; i++)
+    {
+        GraphPass *pass = &g->passes[g->order[i]];
+        if (pass->type != RENDER_GRAPH_COPY)
+            continue;
+        if (i == 0 || g->passes[g->order[i - 1]].type != RENDER_GRAPH_COPY)
+            batch = g->stats.copy_batches++;
+        pass->batch = batch;
+        g->stats.copy_passes++;
+    }
+}
+
+static bool same_layout(const SDL_GPUTextureCreateInfo *a, const SDL_GPUTextureCreateInfo *b)
+{
+    return a->type == b->type && a->format == b->format && a->usage == b->usage && a->width == b->width &&
+           a->height == b->height && a->layer_count_or_depth == b->layer_count_or_depth &&
+           a->num_levels == b->num_levels && a->sample_count == b->sample_count;
+}
+
+/* Interval assignment: transients in order of first use take the first
+   slot of the same layout whose previous tenant is already dead */
+static void assign_slots(RenderGraph *g)
+{
+    for (Uint32 i = 0; i < g->resource_count; i++)
+    {
+        g->resources[i].first = -1;
+        g->resources[i].last = -1;
+        g->resources[i].slot = -1;
+    }
+    for (Uint32 a = 0; a < g->access_count; a++)
+    {
+        const GraphAccess *access = &g->accesses[a];
+        Sint32 pos = g->passes[access->pass].position;
+        if (pos < 0)
+            continue;
+        GraphResource *r = &g->resources[access->resource];
+        if (r->first < 0 || pos < r->first)
+            r->first = pos;
+        if (pos > r->last)
+            r->last = pos;
+    }
+
+    RenderGraphResource sorted[RENDER_GRAPH_MAX_RESOURCES];
+    Uint32 count = 0;
+    for (Uint32 i = 0; i < g->resource_count; i++)
+    {
+        const GraphResource *r = &g->resources[i];
+        if (r->imported || r->first < 0)
+            continue;
+        Uint32 j = count++;
+        while (j > 0 && g->resources[sorted[j - 1]].first > r->first)
+        {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = i;
+    }
+
+    g->slot_count = 0;
+    g->stats.transient_textures = count;
+    g->stats.transient_bytes = 0;
+    g->stats.physical_bytes = 0;
+    for (Uint32 i = 0; i < count; i++)
+    {
+        GraphResource *r = &g->resources[sorted[i]];
+        g->stats.transient_bytes += r->bytes;
+        for (Uint32 s = 0; s < g->slot_count; s++)
+        {
+            AliasSlot *slot = &g->slots[s];
+            if (slot->last < r->first && same_layout(&g->resources[slot->owner].info, &r->info))
+            {
+                r->slot = (Sint32)s;
+                slot->last = r->last;
+                break;
+            }
+        }
+        if (r->slot < 0)
+        {
+            r->slot = (Sint32)g->slot_count;
+            g->slots[g->slot_count++] = (AliasSlot){sorted[i], r->last};
+            g->stats.physical_bytes += r->bytes;
+        }
+    }
+    g->stats.physical_textures = g->slot_count;
+}
+
+/* Back each slot with a pool texture of its layout, reusing last frame's */
+static bool bind_pool(RenderGraph *g)
+{
+    for (Uint32 i = 0; i < g->pool_count; i++)
+        g->pool[i].taken = false;
+
+    SDL_GPUTexture *slot_texture[RENDER_GRAPH_MAX_RESOURCES];
+    for (Uint32 s = 0; s < g->slot_count; s++)
+    {
+        const SDL_GPUTextureCreateInfo *info = &g->resources[g->slots[s].owner].info;
+        PoolTexture *match = NULL;
+        for (Uint32 i = 0; i < g->pool_count && !match; i++)
+        {
+            if (!g->pool[i].taken && same_layout(&g->pool[i].info, info))
+                match = &g->pool[i];
+        }
+        if (!match)
+        {
+            if (g->pool_count == g->pool_capacity)
+            {
+                Uint32 capacity = g->pool_capacity ? g->pool_capacity * 2 : 16;
+                PoolTexture *pool = SDL_realloc(g->pool, capacity * sizeof(PoolTexture));
+                if (!pool)
+                    return false;
+                g->pool = pool;
+                g->pool_capacity = capacity;
+            }
+            SDL_GPUTexture *texture = residency_create_texture(g->device, info, RESIDENCY_TARGETS);
+            if (!texture)
+            {
+                SDL_Log("Render graph: failed to create %s: %s", g->resources[g->slots[s].owner].name,
+                        SDL_GetError());
+                return false;
+            }
+            match = &g->pool[g->pool_count++];
+            match->info = *info;
+            match->texture = texture;
+        }
+        match->taken = true;
+        match->last_frame = g->frame;
+        slot_texture[s] = match->texture;
+    }
+
+    for (Uint32 i = 0; i < g->resource_count; i++)
+    {
+        GraphResource *r = &g->resources[i];
+        if (!r->imported)
+            r->texture = r->slot >= 0 ? slot_texture[r->slot] : NULL;
+    }
+
+    /* Drop textures no frame has wanted for a while */
+    for (Uint32 i = 0; i < g->pool_count;)
+    {
+        if (g->frame - g->pool[i].last_frame > POOL_IDLE_FRAMES)
+        {
+            residency_release_texture(g->device, g->pool[i].texture);
+            g->pool[i] = g->pool[--g->pool_count];
+        }
+        else
+            i++;
+    }
+    return true;
+}
+
+bool render_graph_compile(RenderGraph *g)
+{
+    Uint64 start = bench_now();
+    g->compiled = false;
+    if (g->overflow)
+    {
+        SDL_Log("Render graph: too many passes, resources or accesses declared");
+        return false;
+    }
+
+    build_dependencies(g);
+    schedule(g);
+    assign_slots(g);
+    g->frame++;
+    if (g->device && !bind_pool(g))
+        return false;
+
+    g->stats.passes = g->pass_count;
+    g->stats.culled = g->pass_count - g->order_count;
+    g->stats.compile_ms = bench_ms_since(start);
+    g->compiled = true;
+    return true;
+}
+
+/*================================================================================
+ * Execute
+ *================================================================================*/
+static SDL_GPUStoreOp store_op(const RenderGraph *g, const GraphPass *pass, RenderGraphResource resource)
+{
+    /* A transient no later pass touches never needs its contents stored */
+    const GraphResource *r = &g->resources[resource];
+    return !r->imported && r->last <= pass->position ? SDL_GPU_STOREOP_DONT_CARE : SDL_GPU_STOREOP_STORE;
+}
+
+static SDL_GPURenderPass *begin_render(RenderGraph *g, const GraphPass *pass, SDL_GPUCommandBuffer *cmd)
+{
+    SDL_GPUColorTargetInfo color[RENDER_GRAPH_MAX_COLOR_TARGETS];
+    SDL_zeroa(color);
+    for (Uint32 i = 0; i < pass->color_count; i++)
+    {
+        const ColorTarget *t = &pass->color[i];
+        const GraphResource *r = &g->resources[t->resource];
+        color[i].texture = r->texture;
+        color[i].load_op = t->load_op;
+        color[i].store_op = store_op(g, pass, t->resource);
+        color[i].clear_color = t->clear_color;
+        /* Pooled textures must keep their memory: cycling would allocate anew */
+        color[i].cycle = r->imported && t->load_op != SDL_GPU_LOADOP_LOAD;
+    }
+
+    SDL_GPUDepthStencilTargetInfo depth;
+    SDL_zero(depth);
+    if (pass->depth != RENDER_GRAPH_NONE)
+    {
+        const GraphResource *r = &g->resources[pass->depth];
+        depth.texture = r->texture;
+        depth.load_op = pass->depth_load_op;
+        depth.store_op = store_op(g, pass, pass->depth);
+        depth.clear_depth = pass->clear_depth;
+        depth.stencil_load_op = SDL_GPU_LOADOP_DONT_CARE;
+        depth.stencil_store_op = SDL_GPU_STOREOP_DONT_CARE;
+        depth.cycle = r->imported && pass->depth_load_op != SDL_GPU_LOADOP_LOAD;
+    }
+    return SDL_BeginGPURenderPass(cmd, color, pass->color_count, pass->depth != RENDER_GRAPH_NONE ? &depth : NULL);
+}
+
+static SDL_GPUComputePass *begin_compute(RenderGraph *g, Uint32 index, SDL_GPUCommandBuffer *cmd)
+{
+    SDL_GPUStorageTextureReadWriteBinding textures[RENDER_GRAPH_MAX_STORAGE_WRITES];
+    SDL_GPUStorageBufferReadWriteBinding buffers[RENDER_GRAPH_MAX_STORAGE_WRITES];
+    Uint32 num_textures = 0, num_buffers = 0;
+    SDL_zeroa(textures);
+    SDL_zeroa(buffers);
+    for (Uint32 a = 0; a < g->access_count; a++)
+    {
+        const GraphAccess *access = &g->accesses[a];
+        if (access->pass != index || !access->write)
+            continue;
+        const GraphResource *r = &g->resources[access->resource];
+        if (r->is_buffer && r->buffer && num_buffers < RENDER_GRAPH_MAX_STORAGE_WRITES)
+            buffers[num_buffers++].buffer = r->buffer;
+        else if (!r->is_buffer && r->texture && num_textures < RENDER_GRAPH_MAX_STORAGE_WRITES)
+            textures[num_textures++].texture = r->texture;
+    }
+    return SDL_BeginGPUComputePass(cmd, textures, num_textures, buffers, num_buffers);
+}
+
+void render_graph_execute(RenderGraph *g, SDL_GPUCommandBuffer *cmd)
+{
+    if (!g->compiled || !g->device)
+        return;
+
+    RenderGraphContext ctx;
+    SDL_zero(ctx);
+    ctx.graph = g;
+    ctx.cmd = cmd;
+    for (Uint32 i = 0; i < g->order_count; i++)
+    {
+        Uint32 index = g->order[i];
+        const GraphPass *pass = &g->passes[index];
+        switch (pass->type)
+        {
+        case RENDER_GRAPH_COPY:
+            if (!ctx.copy)
+                ctx.copy = SDL_BeginGPUCopyPass(cmd);
+            if (pass->fn)
+                pass->fn(&ctx, pass->userdata);
+            if (i + 1 == g->order_count || g->passes[g->order[i + 1]].type != RENDER_GRAPH_COPY)
+            {
+                SDL_EndGPUCopyPass(ctx.copy);
+                ctx.copy = NULL;
+            }
+            break;
+        case RENDER_GRAPH_COMPUTE:
+            ctx.compute = begin_compute(g, index, cmd);
+            if (pass->fn)
+                pass->fn(&ctx, pass->userdata);
+            SDL_EndGPUComputePass(ctx.compute);
+            ctx.compute = NULL;
+            break;
+        case RENDER_GRAPH_RENDER:
+            ctx.render = begin_render(g, pass, cmd);
+            if (pass->fn)
+                pass->fn(&ctx, pass->userdata);
+            SDL_EndGPURenderPass(ctx.render);
+            ctx.render = NULL;
+            break;
+        case RENDER_GRAPH_CUSTOM:
+            if (pass->fn)
+                pass->fn(&ctx, pass->userdata);
+            break;
+        }
+    }
+}
+
+SDL_GPUTexture *render_graph_texture(const RenderGraph *g, RenderGraphResource resource)
+{
+    return resource < g->resource_count ? g->resources[resource].texture : NULL;
+}
+
+SDL_GPUBuffer *render_graph_buffer(const RenderGraph *g, RenderGraphResource resource)
+{
+    return resource < g->resource_count ? g->resources[resource].buffer : NULL;
+}
+
+const RenderGraphStats *render_graph_stats(const RenderGraph *g)
+{
+    return &g->stats;
+}
+
+const char *render_graph_pass_at(const RenderGraph *g, Uint32 position)
+{
+    return position < g->order_count ? g->passes[g->order[position]].name : NULL;
+}
+
+bool render_graph_validate(const RenderGraph *g)
+{
+    for (Uint32 p = 0; p < g->pass_count; p++)
+    {
+        const GraphPass *pass = &g->passes[p];
+        for (Uint32 q = 0; pass->kept && q < g->pass_count; q++)
+        {
+            if ((pass->deps & ((Uint64)1 << q)) && g->passes[q].kept && g->passes[q].position >= pass->position)
+                return false;
+        }
+    }
+    for (Uint32 i = 0; i < g->resource_count; i++)
+    {
+        const GraphResource *a = &g->resources[i];
+        for (Uint32 j = i + 1; j < g->resource_count && a->slot >= 0; j++)
+        {
+            const GraphResource *b = &g->resources[j];
+            if (b->slot != a->slot)
+                continue;
+            if (!same_layout(&a->info, &b->info) || !(a->last < b->first || b->last < a->first))
+                return false;
+        }
+    }
+    return true;
+}
+
+/*================================================================================
+ * Report
+ *================================================================================*/
+static const char *pass_type_name(RenderGraphPassType type)
+{
+    static const char *names[] = {"copy", "compute", "render", "custom"};
+    return names[type];
+}
+
+static void list_accesses(const RenderGraph *g, Uint32 pass, bool write, char *text, size_t size)
+{
+    size_t len = 0;
+    text[0] = '\0';
+    for (Uint32 a = 0; a < g->access_count && len < size; a++)
+    {
+        const GraphAccess *access = &g->accesses[a];
+        if (access->pass != pass || access->write != write)
+            continue;
+        int n = SDL_snprintf(text + len, size - len, "%s%s", len ? ", " : "", g->resources[access->resource].name);
+        len += n > 0 ? (size_t)n : 0;
+    }
+}
+
+void render_graph_log_report(const RenderGraph *g)
+{
+    const RenderGraphStats *s = &g->stats;
+    if (!g->compiled)
+    {
+        SDL_Log("Render graph: not compiled");
+        return;
+    }
+    SDL_Log("Render graph: %u passes (%u culled), %u copies in %u copy passes, %u transients in %u textures "
+            "(%.1f MB, %.1f MB without aliasing), compiled in %.3f ms",
+            s->passes, s->culled, s->copy_passes, s->copy_batches, s->transient_textures, s->physical_textures,
+            (double)s->physical_bytes / (1024.0 * 1024.0), (double)s->transient_bytes / (1024.0 * 1024.0),
+            s->compile_ms);
+
+    char reads[256], writes[256];
+    for (Uint32 i = 0; i < g->order_count; i++)
+    {
+        Uint32 index = g->order[i];
+        const GraphPass *pass = &g->passes[index];
+        list_accesses(g, index, false, reads, sizeof(reads));
+        list_accesses(g, index, true, writes, sizeof(writes));
+        if (pass->type == RENDER_GRAPH_COPY)
+            SDL_Log("  %2u %-7s %-20s batch %u | reads: %s | writes: %s", i, pass_type_name(pass->type), pass->name,
+                    pass->batch, reads, writes);
+        else
+            SDL_Log("  %2u %-7s %-20s | reads: %s | writes: %s", i, pass_type_name(pass->type), pass->name, reads,
+                    writes);
+    }
+    for (Uint32 p = 0; p < g->pass_count; p++)
+    {
+        if (!g->passes[p].kept)
+            SDL_Log("  -- culled  %s", g->passes[p].name);
+    }
+    for (Uint32 i = 0; i < g->resource_count; i++)
+    {
+        const GraphResource *r = &g->resources[i];
+        if (r->first < 0)
+            SDL_Log("  %-20s unused", r->name);
+        else if (r->imported)
+            SDL_Log("  %-20s imported   passes %d-%d", r->name, r->first, r->last);
+        else
+            SDL_Log("  %-20s %4ux%-4u  passes %d-%d  texture %d  %.2f MB", r->name, r->info.width, r->info.height,
+                    r->first, r->last, r->slot, (double)r->bytes / (1024.0 * 1024.0));
+    }
+}
+
+/*================================================================================
+ * Benchmark
+ *================================================================================*/
+#define BENCH_COLOR (SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET)
+#define BENCH_DEPTH (SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET)
+#define BENCH_STORAGE (SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE)
+
+static RenderGraphResource bench_texture(RenderGraph *g, const char *name, SDL_GPUTextureFormat format, Uint32 w,
+                                         Uint32 h, SDL_GPUTextureUsageFlags usage)
+{
+    SDL_GPUTextureCreateInfo info;
+    SDL_zero(info);
+    info.type = SDL_GPU_TEXTURETYPE_2D;
+    info.format = format;
+    info.usage = usage;
+    info.width = w;
+    info.height = h;
+    info.layer_count_or_depth = 1;
+    info.num_levels = 1;
+    return render_graph_create_texture(g, name, &info);
+}
+
+/* A deferred frame with shadows, SSAO, bloom and uploads interleaved the
+   way independent subsystems would declare them */
+static void build_bench_frame(RenderGraph *g)
+{
+    const Uint32 w = 1920, h = 1080;
+    const SDL_FColor black = {0, 0, 0, 1};
+    const SDL_GPUTextureFormat rgba8 = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    const SDL_GPUTextureFormat rgba16f = SDL_GPU_TEXTUREFORMAT_R16G16B16A16_FLOAT;
+    const SDL_GPUTextureFormat d32 = SDL_GPU_TEXTUREFORMAT_D32_FLOAT;
+
+    render_graph_begin(g);
+    RenderGraphResource backbuffer = render_graph_import_texture(g, "backbuffer", NULL);
+    RenderGraphResource transforms = render_graph_import_buffer(g, "transforms", NULL);
+    RenderGraphResource lights = render_graph_import_buffer(g, "lights", NULL);
+    RenderGraphResource readback = render_graph_import_buffer(g, "depth readback", NULL);
+    RenderGraphResource shadow = bench_texture(g, "shadow map", d32, 2048, 2048, BENCH_DEPTH);
+    RenderGraphResource albedo = bench_texture(g, "gbuffer albedo", rgba8, w, h, BENCH_COLOR);
+    RenderGraphResource normal = bench_texture(g, "gbuffer normal", rgba16f, w, h, BENCH_COLOR);
+    RenderGraphResource depth = bench_texture(g, "gbuffer depth", d32, w, h, BENCH_DEPTH);
+    RenderGraphResource ao = bench_texture(g, "ssao", SDL_GPU_TEXTUREFORMAT_R8_UNORM, w, h, BENCH_STORAGE);
+    RenderGraphResource ao_blur = bench_texture(g, "ssao blurred", SDL_GPU_TEXTUREFORMAT_R8_UNORM, w, h, BENCH_STORAGE);
+    RenderGraphResource hdr = bench_texture(g, "hdr", rgba16f, w, h, BENCH_COLOR);
+    RenderGraphResource down2 = bench_texture(g, "bloom down 1/2", rgba16f, w / 2, h / 2, BENCH_COLOR);
+    RenderGraphResource down4 = bench_texture(g, "bloom down 1/4", rgba16f, w / 4, h / 4, BENCH_COLOR);
+    RenderGraphResource down8 = bench_texture(g, "bloom down 1/8", rgba16f, w / 8, h / 8, BENCH_COLOR);
+    RenderGraphResource up4 = bench_texture(g, "bloom up 1/4", rgba16f, w / 4, h / 4, BENCH_COLOR);
+    RenderGraphResource up2 = bench_texture(g, "bloom up 1/2", rgba16f, w / 2, h / 2, BENCH_COLOR);
+    RenderGraphResource ldr = bench_texture(g, "ldr", rgba8, w, h, BENCH_COLOR);
+    RenderGraphResource overlay = bench_texture(g, "debug overlay", rgba8, w, h, BENCH_COLOR);
+
+    Uint32 p = render_graph_add_pass(g, "upload transforms", RENDER_GRAPH_COPY, NULL, NULL);
+    render_graph_write(g, p, transforms);
+    p = render_graph_add_pass(g, "shadow", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, transforms);
+    render_graph_depth_target(g, p, shadow, SDL_GPU_LOADOP_CLEAR, 1.0f);
+    p = render_graph_add_pass(g, "gbuffer", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, transforms);
+    render_graph_color_target(g, p, albedo, SDL_GPU_LOADOP_CLEAR, black);
+    render_graph_color_target(g, p, normal, SDL_GPU_LOADOP_CLEAR, black);
+    render_graph_depth_target(g, p, depth, SDL_GPU_LOADOP_CLEAR, 1.0f);
+    p = render_graph_add_pass(g, "upload lights", RENDER_GRAPH_COPY, NULL, NULL);
+    render_graph_write(g, p, lights);
+    p = render_graph_add_pass(g, "ssao", RENDER_GRAPH_COMPUTE, NULL, NULL);
+    render_graph_read(g, p, depth);
+    render_graph_read(g, p, normal);
+    render_graph_write(g, p, ao);
+    p = render_graph_add_pass(g, "ssao blur", RENDER_GRAPH_COMPUTE, NULL, NULL);
+    render_graph_read(g, p, ao);
+    render_graph_write(g, p, ao_blur);
+    p = render_graph_add_pass(g, "lighting", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, albedo);
+    render_graph_read(g, p, normal);
+    render_graph_read(g, p, depth);
+    render_graph_read(g, p, shadow);
+    render_graph_read(g, p, ao_blur);
+    render_graph_read(g, p, lights);
+    render_graph_color_target(g, p, hdr, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "bloom down 1/2", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, hdr);
+    render_graph_color_target(g, p, down2, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "bloom down 1/4", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, down2);
+    render_graph_color_target(g, p, down4, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "bloom down 1/8", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, down4);
+    render_graph_color_target(g, p, down8, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "bloom up 1/4", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, down8);
+    render_graph_color_target(g, p, up4, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "bloom up 1/2", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, up4);
+    render_graph_color_target(g, p, up2, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "tonemap", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, hdr);
+    render_graph_read(g, p, up2);
+    render_graph_color_target(g, p, ldr, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "debug overlay", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, depth);
+    render_graph_color_target(g, p, overlay, SDL_GPU_LOADOP_CLEAR, black);
+    p = render_graph_add_pass(g, "fxaa", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, ldr);
+    render_graph_color_target(g, p, backbuffer, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "read back depth", RENDER_GRAPH_COPY, NULL, NULL);
+    render_graph_read(g, p, depth);
+    render_graph_write(g, p, readback);
+}
+
+void render_graph_benchmark(void)
+{
+    const int iterations = 1000;
+    RenderGraph *g = render_graph_create(NULL);
+    if (!g)
+        return;
+
+    Uint64 start = bench_now();
+    bool ok = true;
+    for (int i = 0; i < iterations && ok; i++)
+    {
+        build_bench_frame(g);
+        ok = render_graph_compile(g);
+    }
+    double ms = bench_ms_since(start) / iterations;
+    if (!ok)
+    {
+        SDL_Log("Render graph benchmark: the frame failed to compile");
+        render_graph_destroy(g);
+        return;
+    }
+
+    const RenderGraphStats *s = &g->stats;
+    SDL_Log("Render graph benchmark: %u passes (%u culled), %u copies merged into %u copy passes, build+compile "
+            "%.3f ms",
+            s->passes, s->culled, s->copy_passes, s->copy_batches, ms);
+    SDL_Log("  %u transients in %u textures: %.1f MB instead of %.1f MB (%.0f%% saved by aliasing)",
+            s->transient_textures, s->physical_textures, (double)s->physical_bytes / (1024.0 * 1024.0),
+            (double)s->transient_bytes / (1024.0 * 1024.0),
+            s->transient_bytes ? 100.0 * (1.0 - (double)s->physical_bytes / (double)s->transient_bytes) : 0.0);
+    render_graph_log_report(g);
+    render_graph_destroy(g);
+}
@@ -0,0 +1,115 @@
+#ifndef CUMULUS_RENDER_GRAPH_H
+#define CUMULUS_RENDER_GRAPH_H
+
+#include <SDL3/SDL.h>
+
+/* Per-frame pass graph. Passes declare the resources they read and write;
+   compiling drops passes nothing consumes, orders the rest by their
+   dependencies, batches adjacent copy passes into one SDL copy pass and
+   assigns transient textures to pooled GPU textures, so that transients
+   whose lifetimes do not overlap share one texture. The graph is rebuilt
+   every frame with render_graph_begin; the texture pool persists. */
+typedef struct RenderGraph RenderGraph;
+
+typedef Uint32 RenderGraphResource;
+#define RENDER_GRAPH_NONE 0xFFFFFFFFu
+
+#define RENDER_GRAPH_MAX_PASSES 64
+#define RENDER_GRAPH_MAX_RESOURCES 128
+#define RENDER_GRAPH_MAX_ACCESSES 512
+#define RENDER_GRAPH_MAX_COLOR_TARGETS 4
+#define RENDER_GRAPH_MAX_STORAGE_WRITES 8
+
+typedef enum RenderGraphPassType
+{
+    RENDER_GRAPH_COPY,    /* runs inside a copy pass shared with adjacent copies */
+    RENDER_GRAPH_COMPUTE, /* written resources are bound as read-write storage */
+    RENDER_GRAPH_RENDER,  /* targets set with render_graph_color/depth_target */
+    RENDER_GRAPH_CUSTOM   /* records its own passes on the command buffer */
+} RenderGraphPassType;
+
+typedef struct RenderGraphContext
+{
+    RenderGraph *graph;
+    SDL_GPUCommandBuffer *cmd;
+    SDL_GPUCopyPass *copy;       /* RENDER_GRAPH_COPY */
+    SDL_GPUComputePass *compute; /* RENDER_GRAPH_COMPUTE */
+    SDL_GPURenderPass *render;   /* RENDER_GRAPH_RENDER */
+} RenderGraphContext;
+
+typedef void (*RenderGraphExecuteFn)(const RenderGraphContext *ctx, void *userdata);
+
+typedef struct RenderGraphStats
+{
+    Uint32 passes;             /* declared this frame */
+    Uint32 culled;             /* passes whose results nothing used */
+    Uint32 copy_passes;        /* kept copy passes ... */
+    Uint32 copy_batches;       /* ... and the SDL copy passes recorded for them */
+    Uint32 transient_textures; /* used by kept passes */
+    Uint32 physical_textures;  /* pool textures backing them */
+    Uint64 transient_bytes;    /* size of every transient on its own */
+    Uint64 physical_bytes;     /* size after aliasing */
+    double compile_ms;
+} RenderGraphStats;
+
+/* device may be NULL to compile graphs without executing them */
+RenderGraph *render_graph_create(SDL_GPUDevice *device);
+void render_graph_destroy(RenderGraph *graph);
+
+/* Forget last frame's passes and resources; pooled textures are kept */
+void render_graph_begin(RenderGraph *graph);
+
+/* External resources. The pointer may be NULL when the resource only
+   orders passes (e.g. a buffer owned and bound by a subsystem). Passes
+   writing an imported resource are never culled. Names must outlive the
+   frame. */
+RenderGraphResource render_graph_import_texture(RenderGraph *graph, const char *name, SDL_GPUTexture *texture);
+RenderGraphResource render_graph_import_buffer(RenderGraph *graph, const char *name, SDL_GPUBuffer *buffer);
+
+/* Texture that only lives within this frame, allocated from the pool */
+RenderGraphResource render_graph_create_texture(RenderGraph *graph, const char *name,
+                                                const SDL_GPUTextureCreateInfo *info);
+
+/* Returns the pass index, or RENDER_GRAPH_NONE when the graph is full */
+Uint32 render_graph_add_pass(RenderGraph *graph, const char *name, RenderGraphPassType type, RenderGraphExecuteFn fn,
+                             void *userdata);
+void render_graph_read(RenderGraph *graph, Uint32 pass, RenderGraphResource resource);
+void render_graph_write(RenderGraph *graph, Uint32 pass, RenderGraphResource resource);
+
+/* Render pass attachments; LOAD also counts as a read */
+void render_graph_color_target(RenderGraph *graph, Uint32 pass, RenderGraphResource resource, SDL_GPULoadOp load_op,
+                               SDL_FColor clear_color);
+void render_graph_depth_target(RenderGraph *graph, Uint32 pass, RenderGraphResource resource, SDL_GPULoadOp load_op,
+                               float clear_depth);
+
+/* Cull, order, batch and alias. Returns false if a resource could not be
+   allocated; the graph must not be executed then. */
+bool render_graph_compile(RenderGraph *graph);
+
+/* Record every kept pass into cmd in compiled order */
+void render_graph_execute(RenderGraph *graph, SDL_GPUCommandBuffer *cmd);
+
+/* Backing objects, valid after compile */
+SDL_GPUTexture *render_graph_texture(const RenderGraph *graph, RenderGraphResource resource);
+SDL_GPUBuffer *render_graph_buffer(const RenderGraph *graph, RenderGraphResource resource);
+
+const RenderGraphStats *render_graph_stats(const RenderGraph *graph);
+
+/* Name of the kept pass at `position` in compiled order, NULL past the
+   last one */
+const char *render_graph_pass_at(const RenderGraph *graph, Uint32 position);
+
+/* Check the compiled frame: every kept pass after its dependencies, and no
+   pooled texture shared by two transients alive at the same time or of
+   different layouts */
+bool render_graph_validate(const RenderGraph *graph);
+
+/* Log the compiled frame: pass order, batches, accesses and resource
+   lifetimes with their pool slots */
+void render_graph_log_report(const RenderGraph *graph);
+
+/* Compile a synthetic deferred frame without a device and log the build
+   and compile time and what aliasing saves */
+void render_graph_benchmark(void);
+
+#endif /* CUMULUS_RENDER_GRAPH_H */
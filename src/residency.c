@@ -0,0 +1,418 @@
+#include "residency.h"
+
+#include <SDL3/SDL.h>
+
+#define MAX_EVICTORS 8
+
+static const char *const category_names[RESIDENCY_CATEGORY_COUNT] = {
+    "Geometry", "Textures", "Targets", "UI", "Staging", "Models", "Decode", "Frame", "ECS",
+};
+
+/* A live GPU resource, in an open-addressed table keyed by handle */
+typedef struct TrackedResource
+{
+    const void *handle;
+    size_t size;
+    ResidencyCategory category;
+} TrackedResource;
+
+typedef struct Evictor
+{
+    ResidencyEvictFn fn;
+    void *userdata;
+} Evictor;
+
+static struct
+{
+    SDL_Mutex *lock;
+    SDL_ThreadID main_thread;
+    ResidencyStats categories[RESIDENCY_CATEGORY_COUNT];
+    ResidencyStats total;
+    Evictor evictors[MAX_EVICTORS];
+    int evictor_count;
+    bool evicting;
+    TrackedResource *table;
+    Uint32 table_capacity; /* power of two */
+    Uint32 table_count;
+} residency;
+
+/*================================================================================
+ * Accounting (lock held)
+ *================================================================================*/
+static void account(ResidencyCategory category, size_t bytes)
+{
+    ResidencyStats *c = &residency.categories[category];
+    c->used += bytes;
+    c->peak = SDL_max(c->peak, c->used);
+    residency.total.used += bytes;
+    residency.total.peak = SDL_max(residency.total.peak, residency.total.used);
+}
+
+static void unaccount(ResidencyCategory category, size_t bytes)
+{
+    ResidencyStats *c = &residency.categories[category];
+    bytes = SDL_min(bytes, c->used);
+    c->used -= bytes;
+    residency.total.used -= bytes;
+}
+
+/* The category short of room (RESIDENCY_CATEGORY_COUNT: the total), or
+   -1 if `bytes` fit. *excess is how much is missing. */
+static int pressure(ResidencyCategory category, size_t bytes, size_t *excess)
+{
+    const ResidencyStats *c = &residency.categories[category];
+    if (c->budget && c->used + bytes > c->budget)
+    {
+        *excess = c->used + bytes - c->budget;
+        return (int)category;
+    }
+    if (residency.total.budget && residency.total.used + bytes > residency.total.budget)
+    {
+        *excess = residency.total.used + bytes - residency.total.budget;
+        return RESIDENCY_CATEGORY_COUNT;
+    }
+    return -1;
+}
+
+/*================================================================================
+ * Resource table (lock held)
+ *================================================================================*/
+static Uint32 slot_of(const void *handle)
+{
+    Uint64 h = (Uint64)(uintptr_t)handle * 0x9E3779B97F4A7C15ull;
+    return (Uint32)(h >> 32) & (residency.table_capacity - 1);
+}
+
+static bool table_insert(const void *handle, size_t size, ResidencyCategory category)
+{
+    if ((residency.table_count + 1) * 2 > residency.table_capacity)
+    {
+        Uint32 capacity = residency.table_capacity ? residency.table_capacity * 2 : 256;
+        TrackedResource *table = SDL_calloc(capacity, sizeof(TrackedResource));
+        if (!table)
+            return false;
+        TrackedResource *old = residency.table;
+        Uint32 old_capacity = residency.table_capacity;
+        residency.table = table;
+        residency.table_capacity = capacity;
+        for (Uint32 i = 0; i < old_capacity; i++)
+        {
+            if (!old[i].handle)
+                continue;
+            Uint32 s = slot_of(old[i].handle);
+            while (table[s].handle)
+                s = (s + 1) & (capacity - 1);
+            table[s] = old[i];
+        }
+        SDL_free(old);
+    }
+
+    Uint32 s = slot_of(handle);
+    while (residency.table[s].handle)
+        s = (s + 1) & (residency.table_capacity - 1);
+    residency.table[s] = (TrackedResource){handle, size, category};
+    residency.table_count++;
+    return true;
+}
+
+/* Removes and returns the entry; false if `handle` is not tracked */
+static bool table_remove(const void *handle, TrackedResource *out)
+{
+    if (!residency.table_count)
+        return false;
+    Uint32 mask = residency.table_capacity - 1;
+    Uint32 s = slot_of(handle);
+    while (residency.table[s].handle != handle)
+    {
+        if (!residency.table[s].handle)
+            return false;
+        s = (s + 1) & mask;
+    }
+    *out = residency.table[s];
+    residency.table_count--;
+
+    /* Shift later entries of the run back so lookups never stop early */
+    Uint32 hole = s;
+    for (Uint32 next = (s + 1) & mask; residency.table[next].handle; next = (next + 1) & mask)
+    {
+        Uint32 home = slot_of(residency.table[next].handle);
+        if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+            residency.table[hole] = residency.table[next];
+            hole = next;
+        }
+    }
+    residency.table[hole].handle = NULL;
+    return true;
+}
+
+/*================================================================================
+ * Budgets
+ *================================================================================*/
+static size_t env_megabytes(const char *name, size_t fallback)
+{
+    const char *value = SDL_getenv(name);
+    return value && *value ? (size_t)SDL_strtoull(value, NULL, 10) * 1024 * 1024 : fallback;
+}
+
+void residency_init(void)
+{
+    if (!residency.lock)
+        residency.lock = SDL_CreateMutex();
+    residency.main_thread = SDL_GetCurrentThreadID();
+
+    residency.total.name = "Total";
+    residency.total.budget = env_megabytes("CUMULUS_MEMORY_MB", 0);
+    for (int i = 0; i < RESIDENCY_CATEGORY_COUNT; i++)
+    {
+        char name[64], upper[16];
+        size_t n = 0;
+        for (const char *c = category_names[i]; *c && n + 1 < sizeof(upper); c++)
+            upper[n++] = (char)SDL_toupper(*c);
+        upper[n] = '\0';
+        SDL_snprintf(name, sizeof(name), "CUMULUS_BUDGET_%s_MB", upper);
+
+        ResidencyStats *c = &residency.categories[i];
+        c->name = category_names[i];
+        c->budget = env_megabytes(name, i == RESIDENCY_DECODE ? RESIDENCY_DECODE_BUDGET : 0);
+        if (c->budget && i != RESIDENCY_DECODE)
+            SDL_Log("Residency: %s budget %zu MB", c->name, c->budget >> 20);
+    }
+    if (residency.total.budget)
+        SDL_Log("Residency: total budget %zu MB", residency.total.budget >> 20);
+}
+
+void residency_shutdown(void)
+{
+    for (int i = 0; i < RESIDENCY_CATEGORY_COUNT; i++)
+    {
+        const ResidencyStats *c = &residency.categories[i];
+        if (c->peak)
+            SDL_Log("Residency: %-8s peak %8.1f MB%s", c->name, (double)c->peak / (1024.0 * 1024.0),
+                    c->used ? " (still in use)" : "");
+        if (c->denied)
+            SDL_Log("Residency: %-8s %u reservations refused", c->name, c->denied);
+    }
+    SDL_Log("Residency: total peak %.1f MB", (double)residency.total.peak / (1024.0 * 1024.0));
+    SDL_free(residency.table);
+    residency.table = NULL;
+    residency.table_capacity = residency.table_count = 0;
+    SDL_DestroyMutex(residency.lock);
+    residency.lock = NULL;
+}
+
+void residency_set_budget(ResidencyCategory category, size_t bytes)
+{
+    SDL_LockMutex(residency.lock);
+    residency.categories[category].budget = bytes;
+    SDL_UnlockMutex(residency.lock);
+}
+
+void residency_set_total_budget(size_t bytes)
+{
+    SDL_LockMutex(residency.lock);
+    residency.total.budget = bytes;
+    SDL_UnlockMutex(residency.lock);
+}
+
+void residency_add_evictor(ResidencyEvictFn fn, void *userdata)
+{
+    SDL_LockMutex(residency.lock);
+    if (residency.evictor_count < MAX_EVICTORS)
+        residency.evictors[residency.evictor_count++] = (Evictor){fn, userdata};
+    SDL_UnlockMutex(residency.lock);
+}
+
+void residency_remove_evictor(ResidencyEvictFn fn, void *userdata)
+{
+    SDL_LockMutex(residency.lock);
+    for (int i = 0; i < residency.evictor_count; i++)
+    {
+        if (residency.evictors[i].fn == fn && residency.evictors[i].userdata == userdata)
+        {
+            SDL_memmove(&residency.evictors[i], &residency.evictors[i + 1],
+                        (size_t)(residency.evictor_count - i - 1) * sizeof(Evictor));
+            residency.evictor_count--;
+            break;
+        }
+    }
+    SDL_UnlockMutex(residency.lock);
+}
+
+bool residency_reserve(ResidencyCategory category, size_t bytes)
+{
+    bool main_thread = SDL_GetCurrentThreadID() == residency.main_thread;
+    SDL_LockMutex(residency.lock);
+
+    /* Evictors run unlocked (they release through here) and one at a time;
+       keep going round while they make progress */
+    size_t excess = 0;
+    int short_of = pressure(category, bytes, &excess);
+    bool progress = true;
+    while (short_of >= 0 && main_thread && !residency.evicting && progress)
+    {
+        progress = false;
+        for (int i = 0; i < residency.evictor_count && short_of >= 0; i++)
+        {
+            Evictor e = residency.evictors[i];
+            residency.evicting = true;
+            SDL_UnlockMutex(residency.lock);
+            size_t freed = e.fn(e.userdata, (ResidencyCategory)short_of, excess);
+            SDL_LockMutex(residency.lock);
+            residency.evicting = false;
+            progress |= freed > 0;
+            short_of = pressure(category, bytes, &excess);
+        }
+    }
+
+    if (short_of >= 0)
+    {
+        residency.categories[category].denied++;
+        residency.total.denied++;
+        SDL_UnlockMutex(residency.lock);
+        return false;
+    }
+    account(category, bytes);
+    SDL_UnlockMutex(residency.lock);
+    return true;
+}
+
+void residency_release(ResidencyCategory category, size_t bytes)
+{
+    SDL_LockMutex(residency.lock);
+    unaccount(category, bytes);
+    SDL_UnlockMutex(residency.lock);
+}
+
+void residency_account(ResidencyCategory category, size_t bytes)
+{
+    SDL_LockMutex(residency.lock);
+    account(category, bytes);
+    SDL_UnlockMutex(residency.lock);
+}
+
+/*================================================================================
+ * GPU resources
+ *================================================================================*/
+/* Reserve for a resource about to be created */
+static bool reserve_resource(ResidencyCategory category, size_t size, const char *kind)
+{
+    if (residency_reserve(category, size))
+        return true;
+    SDL_SetError("%s budget exceeded by a %zu byte %s", category_names[category], size, kind);
+    return false;
+}
+
+static void track(const void *handle, ResidencyCategory category, size_t size)
+{
+    SDL_LockMutex(residency.lock);
+    if (handle && table_insert(handle, size, category))
+        residency.categories[category].count++;
+    else
+        unaccount(category, size);
+    SDL_UnlockMutex(residency.lock);
+}
+
+/* Drops the accounting of `handle`, if it was tracked */
+static void untrack(const void *handle)
+{
+    TrackedResource entry;
+    SDL_LockMutex(residency.lock);
+    if (table_remove(handle, &entry))
+    {
+        residency.categories[entry.category].count--;
+        unaccount(entry.category, entry.size);
+    }
+    SDL_UnlockMutex(residency.lock);
+}
+
+size_t residency_texture_size(const SDL_GPUTextureCreateInfo *info)
+{
+    bool volume = info->type == SDL_GPU_TEXTURETYPE_3D;
+    size_t total = 0;
+    for (Uint32 level = 0; level < SDL_max(info->num_levels, 1); level++)
+    {
+        Uint32 w = SDL_max(info->width >> level, 1);
+        Uint32 h = SDL_max(info->height >> level, 1);
+        Uint32 d = volume ? SDL_max(info->layer_count_or_depth >> level, 1) : info->layer_count_or_depth;
+        total += SDL_CalculateGPUTextureFormatSize(info->format, w, h, d);
+    }
+    return total << info->sample_count; /* SDL_GPU_SAMPLECOUNT_n is log2(n) */
+}
+
+SDL_GPUBuffer *residency_create_buffer(SDL_GPUDevice *device, const SDL_GPUBufferCreateInfo *info,
+                                       ResidencyCategory category)
+{
+    if (!reserve_resource(category, info->size, "buffer"))
+        return NULL;
+    SDL_GPUBuffer *buffer = SDL_CreateGPUBuffer(device, info);
+    track(buffer, category, info->size);
+    return buffer;
+}
+
+void residency_release_buffer(SDL_GPUDevice *device, SDL_GPUBuffer *buffer)
+{
+    if (!buffer)
+        return;
+    untrack(buffer);
+    SDL_ReleaseGPUBuffer(device, buffer);
+}
+
+SDL_GPUTexture *residency_create_texture(SDL_GPUDevice *device, const SDL_GPUTextureCreateInfo *info,
+                                         ResidencyCategory category)
+{
+    size_t size = residency_texture_size(info);
+    if (!reserve_resource(category, size, "texture"))
+        return NULL;
+    SDL_GPUTexture *texture = SDL_CreateGPUTexture(device, info);
+    track(texture, category, size);
+    return texture;
+}
+
+void residency_release_texture(SDL_GPUDevice *device, SDL_GPUTexture *texture)
+{
+    if (!texture)
+        return;
+    untrack(texture);
+    SDL_ReleaseGPUTexture(device, texture);
+}
+
+SDL_GPUTransferBuffer *residency_create_transfer_buffer(SDL_GPUDevice *device,
+                                                        const SDL_GPUTransferBufferCreateInfo *info,
+                                                        ResidencyCategory category)
+{
+    if (!reserve_resource(category, info->size, "transfer buffer"))
+        return NULL;
+    SDL_GPUTransferBuffer *buffer = SDL_CreateGPUTransferBuffer(device, info);
+    track(buffer, category, info->size);
+    return buffer;
+}
+
+void residency_release_transfer_buffer(SDL_GPUDevice *device, SDL_GPUTransferBuffer *buffer)
+{
+    if (!buffer)
+        return;
+    untrack(buffer);
+    SDL_ReleaseGPUTransferBuffer(device, buffer);
+}
+
+/*================================================================================
+ * Stats
+ *================================================================================*/
+void residency_stats(ResidencyCategory category, ResidencyStats *out)
+{
+    SDL_LockMutex(residency.lock);
+    *out = residency.categories[category];
+    if (!out->name)
+        out->name = category_names[category];
+    SDL_UnlockMutex(residency.lock);
+}
+
+void residency_total(ResidencyStats *out)
+{
+    SDL_LockMutex(residency.lock);
+    *out = residency.total;
+    out->name = "Total";
+    out->count = residency.table_count;
+    SDL_UnlockMutex(residency.lock);
+}
@@ -0,0 +1,91 @@
+#ifndef CUMULUS_RESIDENCY_H
+#define CUMULUS_RESIDENCY_H
+
+#include <SDL3/SDL.h>
+
+/* Accounts the app's GPU resources and large CPU allocations by category
+   and holds them to budgets. GPU buffers, textures and transfer buffers
+   are created and released through the wrappers below, which record
+   their size; CPU users reserve and release bytes themselves.
+
+   A reservation that would take a category past its budget, or all of
+   them past the total, first asks the registered evictors to free
+   memory (idle cached assets), and fails if that is not enough: the
+   caller then falls back (fewer mips) or gives up. Budgets are never
+   exceeded by what the app allocates through here. Eviction only runs
+   on the main thread; other threads just fail.
+
+   Budgets come from CUMULUS_MEMORY_MB (all categories together) and
+   CUMULUS_BUDGET_<CATEGORY>_MB, e.g. CUMULUS_BUDGET_TEXTURES_MB=512.
+   Unset means unlimited, except for decoded texture pixels. */
+
+typedef enum ResidencyCategory
+{
+    RESIDENCY_GEOMETRY, /* GPU: model vertex, index, object and command buffers */
+    RESIDENCY_TEXTURES, /* GPU: model textures */
+    RESIDENCY_TARGETS,  /* GPU: depth, Hi-Z, transient and offscreen targets */
+    RESIDENCY_UI,       /* GPU: microui buffers and atlases */
+    RESIDENCY_STAGING,  /* GPU: upload and readback transfer buffers */
+    RESIDENCY_MODELS,   /* CPU: glTF files and unpacked geometry */
+    RESIDENCY_DECODE,   /* CPU: decoded texture pixels waiting for upload */
+    RESIDENCY_FRAME,    /* CPU: the frame arena */
+    RESIDENCY_ECS,      /* CPU: entity component columns */
+    RESIDENCY_CATEGORY_COUNT
+} ResidencyCategory;
+
+/* Default for RESIDENCY_DECODE, which bounds how far decoding runs ahead */
+#define RESIDENCY_DECODE_BUDGET (256u * 1024u * 1024u)
+
+typedef struct ResidencyStats
+{
+    const char *name;
+    size_t used;
+    size_t peak;
+    size_t budget; /* 0: unlimited */
+    Uint32 count;  /* live GPU resources */
+    Uint32 denied; /* reservations refused */
+} ResidencyStats;
+
+/* Ask to free about `bytes` of `category`, or of any category when it is
+   RESIDENCY_CATEGORY_COUNT. Returns the bytes freed. */
+typedef size_t (*ResidencyEvictFn)(void *userdata, ResidencyCategory category, size_t bytes);
+
+/* Reads the budgets. Call on the main thread before creating resources. */
+void residency_init(void);
+
+/* Logs the peaks, and anything still accounted */
+void residency_shutdown(void);
+
+void residency_set_budget(ResidencyCategory category, size_t bytes);
+void residency_set_total_budget(size_t bytes);
+
+void residency_add_evictor(ResidencyEvictFn fn, void *userdata);
+void residency_remove_evictor(ResidencyEvictFn fn, void *userdata);
+
+/* Account `bytes` if they fit, evicting if needed. Safe from any thread. */
+bool residency_reserve(ResidencyCategory category, size_t bytes);
+void residency_release(ResidencyCategory category, size_t bytes);
+
+/* Account memory that is already allocated, budget or not */
+void residency_account(ResidencyCategory category, size_t bytes);
+
+/* SDL_CreateGPU* / SDL_ReleaseGPU* with accounting. Creation fails with
+   an SDL error when over budget. Releasing NULL is a no-op. */
+SDL_GPUBuffer *residency_create_buffer(SDL_GPUDevice *device, const SDL_GPUBufferCreateInfo *info,
+                                       ResidencyCategory category);
+void residency_release_buffer(SDL_GPUDevice *device, SDL_GPUBuffer *buffer);
+SDL_GPUTexture *residency_create_texture(SDL_GPUDevice *device, const SDL_GPUTextureCreateInfo *info,
+                                         ResidencyCategory category);
+void residency_release_texture(SDL_GPUDevice *device, SDL_GPUTexture *texture);
+SDL_GPUTransferBuffer *residency_create_transfer_buffer(SDL_GPUDevice *device,
+                                                        const SDL_GPUTransferBufferCreateInfo *info,
+                                                        ResidencyCategory category);
+void residency_release_transfer_buffer(SDL_GPUDevice *device, SDL_GPUTransferBuffer *buffer);
+
+/* Bytes a texture of `info` occupies, every level included */
+size_t residency_texture_size(const SDL_GPUTextureCreateInfo *info);
+
+void residency_stats(ResidencyCategory category, ResidencyStats *out);
+void residency_total(ResidencyStats *out);
+
+#endif /* CUMULUS_RESIDENCY_H */
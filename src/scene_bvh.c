@@ -0,0 +1,604 @@
+#include "scene_bvh.h"
+#include "bench.h"
+#include "model_import.h"
+#include "scene_graph.h"
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_intrin.h>
+#include <cgltf.h>
+
+#define BVH_LEAF_ITEMS 4
+#define BVH_STACK_DEPTH 64
+#define BVH_HUGE 1e30f
+
+/*================================================================================
+ * Item bounds
+ *================================================================================*/
+static void update_item_world(SceneBvh *bvh, const SceneGraph *graph, size_t item)
+{
+    const float *local = &bvh->item_local[item * 6];
+    float *world = &bvh->item_world[item * 6];
+    mat4_transform_aabb(&graph->world[bvh->item_node[item]], local, local + 3, world, world + 3);
+}
+
+static void node_bounds_from_items(SceneBvh *bvh, SceneBvhNode *node)
+{
+    node->min[0] = node->min[1] = node->min[2] = BVH_HUGE;
+    node->max[0] = node->max[1] = node->max[2] = -BVH_HUGE;
+    for (Uint32 i = node->first; i < node->first + node->count; i++)
+    {
+        const float *b = &bvh->item_world[bvh->order[i] * 6];
+        for (int a = 0; a < 3; a++)
+        {
+            node->min[a] = SDL_min(node->min[a], b[a]);
+            node->max[a] = SDL_max(node->max[a], b[3 + a]);
+        }
+    }
+}
+
+static void node_bounds_from_children(SceneBvh *bvh, SceneBvhNode *node)
+{
+    const SceneBvhNode *l = &bvh->nodes[node->left];
+    const SceneBvhNode *r = &bvh->nodes[node->left + 1];
+    for (int a = 0; a < 3; a++)
+    {
+        node->min[a] = SDL_min(l->min[a], r->min[a]);
+        node->max[a] = SDL_max(l->max[a], r->max[a]);
+    }
+}
+
+/*================================================================================
+ * Build — top-down median split on the longest centroid axis
+ *================================================================================*/
+static float item_centroid(const SceneBvh *bvh, Uint32 item, int axis)
+{
+    const float *b = &bvh->item_world[item * 6];
+    return b[axis] + b[3 + axis];
+}
+
+/* Quickselect so order[first + k] holds the k-th smallest centroid */
+static void select_nth(SceneBvh *bvh, Uint32 *order, size_t count, size_t k, int axis)
+{
+    size_t lo = 0, hi = count - 1;
+    while (lo < hi)
+    {
+        float pivot = item_centroid(bvh, order[(lo + hi) / 2], axis);
+        size_t i = lo, j = hi;
+        while (i <= j)
+        {
+            while (item_centroid(bvh, order[i], axis) < pivot)
+                i++;
+            while (item_centroid(bvh, order[j], axis) > pivot)
+                j--;
+            if (i <= j)
+            {
+                Uint32 t = order[i];
+                order[i] = order[j];
+                order[j] = t;
+                i++;
+                if (j == 0)
+                    break;
+                j--;
+            }
+        }
+        if (k <= j)
+            hi = j;
+        else if (k >= i)
+            lo = i;
+        else
+            break;
+    }
+}
+
+static void build_nodes(SceneBvh *bvh)
+{
+    Uint32 stack[BVH_STACK_DEPTH];
+    int top = 0;
+
+    bvh->node_count = 1;
+    bvh->nodes[0].first = 0;
+    bvh->nodes[0].count = (Uint32)bvh->item_count;
+    bvh->parent[0] = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        Uint32 index = stack[--top];
+        SceneBvhNode *node = &bvh->nodes[index];
+        node->left = 0;
+        node_bounds_from_items(bvh, node);
+
+        if (node->count <= BVH_LEAF_ITEMS || top + 2 > BVH_STACK_DEPTH)
+        {
+            for (Uint32 i = node->first; i < node->first + node->count; i++)
+                bvh->item_leaf[bvh->order[i]] = index;
+            continue;
+        }
+
+        float cmin[3] = {BVH_HUGE, BVH_HUGE, BVH_HUGE};
+        float cmax[3] = {-BVH_HUGE, -BVH_HUGE, -BVH_HUGE};
+        for (Uint32 i = node->first; i < node->first + node->count; i++)
+        {
+            for (int a = 0; a < 3; a++)
+            {
+                float c = item_centroid(bvh, bvh->order[i], a);
+                cmin[a] = SDL_min(cmin[a], c);
+                cmax[a] = SDL_max(cmax[a], c);
+            }
+        }
+        int axis = 0;
+        for (int a = 1; a < 3; a++)
+        {
+            if (cmax[a] - cmin[a] > cmax[axis] - cmin[axis])
+                axis = a;
+        }
+
+        Uint32 half = node->count / 2;
+        select_nth(bvh, bvh->order + node->first, node->count, half, axis);
+
+        Uint32 left = (Uint32)bvh->node_count;
+        bvh->node_count += 2;
+        node->left = left;
+        bvh->nodes[left] = (SceneBvhNode){{0}, {0}, 0, node->first, half};
+        bvh->nodes[left + 1] = (SceneBvhNode){{0}, {0}, 0, node->first + half, node->count - half};
+        bvh->parent[left] = bvh->parent[left + 1] = index;
+
+        /* Median splits keep the tree balanced, so the stack stays shallow */
+        stack[top++] = left + 1;
+        stack[top++] = left;
+    }
+}
+
+SceneBvh *scene_bvh_create(const SceneGraph *graph, size_t count, const Uint32 *item_node,
+                           const Uint32 *item_primitive, const float *local_bounds)
+{
+    Uint64 start = bench_now();
+
+    SceneBvh *bvh = SDL_calloc(1, sizeof(SceneBvh));
+    if (!bvh)
+        return NULL;
+
+    size_t n = count ? count : 1;
+    size_t max_nodes = 2 * n;
+    bvh->item_count = count;
+    bvh->item_node = SDL_malloc(n * sizeof(Uint32));
+    bvh->item_primitive = SDL_malloc(n * sizeof(Uint32));
+    bvh->item_local = SDL_malloc(n * 6 * sizeof(float));
+    bvh->item_world = SDL_malloc(n * 6 * sizeof(float));
+    bvh->visible = SDL_calloc(n, 1);
+    bvh->nodes = SDL_calloc(max_nodes, sizeof(SceneBvhNode));
+    bvh->order = SDL_malloc(n * sizeof(Uint32));
+    bvh->parent = SDL_malloc(max_nodes * sizeof(Uint32));
+    bvh->item_leaf = SDL_malloc(n * sizeof(Uint32));
+    bvh->node_dirty = SDL_calloc(max_nodes, 1);
+    if (!bvh->item_node || !bvh->item_primitive || !bvh->item_local || !bvh->item_world || !bvh->visible ||
+        !bvh->nodes || !bvh->order || !bvh->parent || !bvh->item_leaf || !bvh->node_dirty)
+    {
+        scene_bvh_free(bvh);
+        return NULL;
+    }
+
+    SDL_memcpy(bvh->item_node, item_node, count * sizeof(Uint32));
+    SDL_memcpy(bvh->item_primitive, item_primitive, count * sizeof(Uint32));
+    SDL_memcpy(bvh->item_local, local_bounds, count * 6 * sizeof(float));
+    for (size_t i = 0; i < count; i++)
+    {
+        update_item_world(bvh, graph, i);
+        bvh->order[i] = (Uint32)i;
+    }
+
+    if (count > 0)
+        build_nodes(bvh);
+    bvh->stats.build_ms = bench_ms_since(start);
+    return bvh;
+}
+
+SceneBvh *scene_bvh_build_model(const Model *model)
+{
+    const SceneGraph *graph = model->scene;
+    size_t count = 0;
+    for (size_t i = 0; i < graph->count; i++)
+    {
+        Sint32 mesh = graph->mesh[i];
+        if (mesh >= 0)
+            count += model->mesh_first_primitive[mesh + 1] - model->mesh_first_primitive[mesh];
+    }
+
+    size_t n = count ? count : 1;
+    Uint32 *nodes = SDL_malloc(n * sizeof(Uint32));
+    Uint32 *prims = SDL_malloc(n * sizeof(Uint32));
+    float *bounds = SDL_malloc(n * 6 * sizeof(float));
+    if (!nodes || !prims || !bounds)
+    {
+        SDL_free(nodes);
+        SDL_free(prims);
+        SDL_free(bounds);
+        return NULL;
+    }
+
+    size_t k = 0;
+    for (size_t i = 0; i < graph->count; i++)
+    {
+        Sint32 mesh = graph->mesh[i];
+        if (mesh < 0)
+            continue;
+        for (size_t p = model->mesh_first_primitive[mesh]; p < model->mesh_first_primitive[mesh + 1]; p++)
+        {
+            const ModelPrimitive *prim = &model->primitives[p];
+            float *b = &bounds[k * 6];
+            b[0] = b[1] = b[2] = b[3] = b[4] = b[5] = 0.0f;
+
+            /* Prefer the accessor's declared min/max; scan the stream otherwise,
+               and for normalized integers, whose min/max are not in model units */
+            const cgltf_accessor *acc = NULL;
+            for (size_t a = 0; a < prim->source->attributes_count; a++)
+            {
+                if (prim->source->attributes[a].type == cgltf_attribute_type_position)
+                    acc = prim->source->attributes[a].data;
+            }
+            if (acc && acc->has_min && acc->has_max && !acc->normalized)
+            {
+                SDL_memcpy(b, acc->min, 3 * sizeof(float));
+                SDL_memcpy(b + 3, acc->max, 3 * sizeof(float));
+            }
+            else if (prim->positions && prim->positions->count > 0)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    const float *s = prim->positions->streams[c];
+                    b[c] = b[3 + c] = s[0];
+                    for (size_t v = 1; v < prim->positions->count; v++)
+                    {
+                        b[c] = SDL_min(b[c], s[v]);
+                        b[3 + c] = SDL_max(b[3 + c], s[v]);
+                    }
+                }
+            }
+
+            nodes[k] = (Uint32)i;
+            prims[k] = (Uint32)p;
+            k++;
+        }
+    }
+
+    SceneBvh *bvh = scene_bvh_create(graph, count, nodes, prims, bounds);
+    SDL_free(nodes);
+    SDL_free(prims);
+    SDL_free(bounds);
+    return bvh;
+}
+
+void scene_bvh_free(SceneBvh *bvh)
+{
+    if (!bvh)
+        return;
+
+    SDL_free(bvh->item_node);
+    SDL_free(bvh->item_primitive);
+    SDL_free(bvh->item_local);
+    SDL_free(bvh->item_world);
+    SDL_free(bvh->visible);
+    SDL_free(bvh->nodes);
+    SDL_free(bvh->order);
+    SDL_free(bvh->parent);
+    SDL_free(bvh->item_leaf);
+    SDL_free(bvh->node_dirty);
+    SDL_free(bvh);
+}
+
+/*================================================================================
+ * Refit
+ *================================================================================*/
+static size_t lower_bound_node(const SceneBvh *bvh, Uint32 node)
+{
+    size_t lo = 0, hi = bvh->item_count;
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (bvh->item_node[mid] < node)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+void scene_bvh_refit(SceneBvh *bvh, const SceneGraph *graph)
+{
+    Uint64 start = bench_now();
+    bvh->stats.refit_items = 0;
+
+    if (graph->all_changed)
+    {
+        for (size_t i = 0; i < bvh->item_count; i++)
+            update_item_world(bvh, graph, i);
+        /* Children always have larger indices than their parent */
+        for (size_t n = bvh->node_count; n-- > 0;)
+        {
+            SceneBvhNode *node = &bvh->nodes[n];
+            node->left ? node_bounds_from_children(bvh, node) : node_bounds_from_items(bvh, node);
+        }
+        bvh->stats.refit_items = bvh->item_count;
+        bvh->stats.refit_ms = bench_ms_since(start);
+        return;
+    }
+
+    /* Untouched items keep valid world bounds, so only the leaves of
+       changed items and their ancestors need new bounds */
+    bool any = false;
+    for (size_t c = 0; c < graph->changed_count; c++)
+    {
+        Uint32 root = graph->changed[c];
+        Uint32 end = graph->subtree_end[root];
+        for (size_t i = lower_bound_node(bvh, root); i < bvh->item_count && bvh->item_node[i] < end; i++)
+        {
+            update_item_world(bvh, graph, i);
+            bvh->stats.refit_items++;
+            any = true;
+
+            for (Uint32 n = bvh->item_leaf[i]; !bvh->node_dirty[n]; n = bvh->parent[n])
+            {
+                bvh->node_dirty[n] = 1;
+                if (n == 0)
+                    break;
+            }
+        }
+    }
+
+    /* A byte scan in descending index order is bottom-up and cheaper than
+       sorting the dirty set once more than a handful of items move */
+    for (size_t n = any ? bvh->node_count : 0; n-- > 0;)
+    {
+        if (!bvh->node_dirty[n])
+            continue;
+        SceneBvhNode *node = &bvh->nodes[n];
+        node->left ? node_bounds_from_children(bvh, node) : node_bounds_from_items(bvh, node);
+        bvh->node_dirty[n] = 0;
+    }
+
+    bvh->stats.refit_ms = bench_ms_since(start);
+}
+
+/*================================================================================
+ * Culling
+ *================================================================================*/
+/* Six planes (left, right, bottom, top, near, far) padded to eight with
+   planes every box is inside of, stored as SoA for 4-wide tests. */
+typedef struct Frustum
+{
+    float nx[8], ny[8], nz[8], d[8];
+} Frustum;
+
+enum
+{
+    CULL_OUTSIDE,
+    CULL_INTERSECT,
+    CULL_INSIDE
+};
+
+static void frustum_from_matrix(Frustum *f, const Mat4 *vp)
+{
+    float planes[6][4];
+    mat4_frustum_planes(vp, planes);
+    for (int p = 0; p < 8; p++)
+    {
+        bool pad = p >= 6;
+        f->nx[p] = pad ? 0.0f : planes[p][0];
+        f->ny[p] = pad ? 0.0f : planes[p][1];
+        f->nz[p] = pad ? 0.0f : planes[p][2];
+        f->d[p] = pad ? 1.0f : planes[p][3];
+    }
+}
+
+static inline int test_aabb(const Frustum *f, const float *bmin, const float *bmax)
+{
+    float cx = (bmin[0] + bmax[0]) * 0.5f, ex = (bmax[0] - bmin[0]) * 0.5f;
+    float cy = (bmin[1] + bmax[1]) * 0.5f, ey = (bmax[1] - bmin[1]) * 0.5f;
+    float cz = (bmin[2] + bmax[2]) * 0.5f, ez = (bmax[2] - bmin[2]) * 0.5f;
+
+#if defined(SDL_SSE2_INTRINSICS)
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 vcx = _mm_set1_ps(cx), vcy = _mm_set1_ps(cy), vcz = _mm_set1_ps(cz);
+    __m128 vex = _mm_set1_ps(ex), vey = _mm_set1_ps(ey), vez = _mm_set1_ps(ez);
+    int outside = 0, inside = 0xFF;
+    for (int k = 0; k < 8; k += 4)
+    {
+        __m128 nx = _mm_loadu_ps(f->nx + k), ny = _mm_loadu_ps(f->ny + k), nz = _mm_loadu_ps(f->nz + k);
+        __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, vcx), _mm_mul_ps(ny, vcy)),
+                                 _mm_add_ps(_mm_mul_ps(nz, vcz), _mm_loadu_ps(f->d + k)));
+        __m128 rad = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign, nx), vex), _mm_mul_ps(_mm_andnot_ps(sign, ny), vey)),
+                                _mm_mul_ps(_mm_andnot_ps(sign, nz), vez));
+        outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(dist, rad), _mm_setzero_ps()));
+        inside &= _mm_movemask_ps(_mm_cmpge_ps(_mm_sub_ps(dist, rad), _mm_setzero_ps())) << k | ~(0xF << k);
+    }
+    if (outside)
+        return CULL_OUTSIDE;
+    return inside == 0xFF ? CULL_INSIDE : CULL_INTERSECT;
+#elif defined(SDL_NEON_INTRINSICS)
+    uint32x4_t any_out = vdupq_n_u32(0), all_in = vdupq_n_u32(0xFFFFFFFFu);
+    for (int k = 0; k < 8; k += 4)
+    {
+        float32x4_t nx = vld1q_f32(f->nx + k), ny = vld1q_f32(f->ny + k), nz = vld1q_f32(f->nz + k);
+        float32x4_t dist = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(vld1q_f32(f->d + k), nx, cx), ny, cy), nz, cz);
+        float32x4_t rad = vmlaq_n_f32(vmlaq_n_f32(vmulq_n_f32(vabsq_f32(nx), ex), vabsq_f32(ny), ey), vabsq_f32(nz), ez);
+        any_out = vorrq_u32(any_out, vcltq_f32(vaddq_f32(dist, rad), vdupq_n_f32(0.0f)));
+        all_in = vandq_u32(all_in, vcgeq_f32(vsubq_f32(dist, rad), vdupq_n_f32(0.0f)));
+    }
+    uint32x2_t o = vorr_u32(vget_low_u32(any_out), vget_high_u32(any_out));
+    uint32x2_t i = vand_u32(vget_low_u32(all_in), vget_high_u32(all_in));
+    if (vget_lane_u32(o, 0) | vget_lane_u32(o, 1))
+        return CULL_OUTSIDE;
+    return (vget_lane_u32(i, 0) & vget_lane_u32(i, 1)) ? CULL_INSIDE : CULL_INTERSECT;
+#else
+    bool all_inside = true;
+    for (int p = 0; p < 6; p++)
+    {
+        float dist = f->nx[p] * cx + f->ny[p] * cy + f->nz[p] * cz + f->d[p];
+        float rad = SDL_fabsf(f->nx[p]) * ex + SDL_fabsf(f->ny[p]) * ey + SDL_fabsf(f->nz[p]) * ez;
+        if (dist + rad < 0.0f)
+            return CULL_OUTSIDE;
+        all_inside = all_inside && dist - rad >= 0.0f;
+    }
+    return all_inside ? CULL_INSIDE : CULL_INTERSECT;
+#endif
+}
+
+size_t scene_bvh_cull(SceneBvh *bvh, const Mat4 *view_proj)
+{
+    Uint64 start = bench_now();
+    Frustum f;
+    frustum_from_matrix(&f, view_proj);
+
+    SDL_memset(bvh->visible, 0, bvh->item_count);
+    size_t visible = 0, tested = 0;
+
+    Uint32 stack[BVH_STACK_DEPTH * 2];
+    int top = 0;
+    if (bvh->item_count > 0)
+        stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const SceneBvhNode *node = &bvh->nodes[stack[--top]];
+        int result = test_aabb(&f, node->min, node->max);
+        tested++;
+        if (result == CULL_OUTSIDE)
+            continue;
+
+        if (result == CULL_INSIDE)
+        {
+            /* Whole subtree visible: no further tests */
+            for (Uint32 i = node->first; i < node->first + node->count; i++)
+                bvh->visible[bvh->order[i]] = 1;
+            visible += node->count;
+        }
+        else if (node->left)
+        {
+            stack[top++] = node->left + 1;
+            stack[top++] = node->left;
+        }
+        else
+        {
+            for (Uint32 i = node->first; i < node->first + node->count; i++)
+            {
+                Uint32 item = bvh->order[i];
+                const float *b = &bvh->item_world[item * 6];
+                tested++;
+                if (test_aabb(&f, b, b + 3) != CULL_OUTSIDE)
+                {
+                    bvh->visible[item] = 1;
+                    visible++;
+                }
+            }
+        }
+    }
+
+    bvh->stats.visible = visible;
+    bvh->stats.nodes_tested = tested;
+    bvh->stats.cull_ms = bench_ms_since(start);
+    return visible;
+}
+
+/*================================================================================
+ * Benchmark — city grid of buildings, street-level camera, 1% moving
+ *================================================================================*/
+void scene_bvh_benchmark(void)
+{
+    const int grid = 320;
+    const float spacing = 12.0f;
+    const size_t buildings = (size_t)grid * grid;
+    const size_t count = buildings + 1;
+
+    Sint32 *parent = SDL_malloc(count * sizeof(Sint32));
+    Uint32 *item_node = SDL_malloc(buildings * sizeof(Uint32));
+    Uint32 *item_prim = SDL_malloc(buildings * sizeof(Uint32));
+    float *bounds = SDL_malloc(buildings * 6 * sizeof(float));
+    SceneGraph *graph = NULL;
+    SceneBvh *bvh = NULL;
+    if (!parent || !item_node || !item_prim || !bounds)
+        goto done;
+
+    parent[0] = -1;
+    for (size_t i = 1; i < count; i++)
+        parent[i] = 0;
+    graph = scene_graph_create(count, parent);
+    if (!graph)
+        goto done;
+
+    /* Unit box standing on the ground, scaled per building */
+    Uint64 seed = 42;
+    for (size_t i = 0; i < buildings; i++)
+    {
+        float t[3] = {((float)(i % grid) - grid * 0.5f) * spacing, 0.0f, ((float)(i / grid) - grid * 0.5f) * spacing};
+        float w = 4.0f + (float)SDL_rand_r(&seed, 5);
+        float s[3] = {w, 5.0f + (float)SDL_rand_r(&seed, 60), w};
+        scene_graph_set_trs(graph, (Uint32)(i + 1), t, NULL, s);
+
+        item_node[i] = (Uint32)(i + 1);
+        item_prim[i] = 0;
+        float *b = &bounds[i * 6];
+        b[0] = -0.5f, b[1] = 0.0f, b[2] = -0.5f;
+        b[3] = 0.5f, b[4] = 1.0f, b[5] = 0.5f;
+    }
+    scene_graph_update(graph);
+
+    bvh = scene_bvh_create(graph, buildings, item_node, item_prim, bounds);
+    if (!bvh)
+        goto done;
+
+    Mat4 proj, view, vp;
+    mat4_perspective(&proj, 60.0f * SDL_PI_F / 180.0f, 16.0f / 9.0f, 0.5f, 1500.0f);
+
+    const int frames = 120;
+    double cull_ms = 0.0, refit_ms = 0.0, brute_ms = 0.0;
+    size_t visible = 0, refit_items = 0;
+    size_t movers = buildings / 100;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (size_t k = 0; k < movers; k++)
+        {
+            Uint32 node = 1 + (Uint32)SDL_rand_r(&seed, (Sint32)buildings);
+            const float *t = &graph->translation[node * 3];
+            float moved[3] = {t[0] + 0.1f, t[1], t[2]};
+            scene_graph_set_trs(graph, node, moved, NULL, NULL);
+        }
+        scene_graph_update(graph);
+        scene_bvh_refit(bvh, graph);
+        refit_ms += bvh->stats.refit_ms;
+        refit_items += bvh->stats.refit_items;
+
+        float yaw = (float)frame * (2.0f * SDL_PI_F / frames);
+        float eye[3] = {0.0f, 2.0f, 0.0f};
+        float target[3] = {SDL_cosf(yaw), 2.0f, SDL_sinf(yaw)};
+        float up[3] = {0.0f, 1.0f, 0.0f};
+        mat4_look_at(&view, eye, target, up);
+        mat4_mul(&vp, &proj, &view);
+
+        visible += scene_bvh_cull(bvh, &vp);
+        cull_ms += bvh->stats.cull_ms;
+
+        /* Reference: every item against the frustum, no hierarchy */
+        Uint64 start = bench_now();
+        Frustum f;
+        frustum_from_matrix(&f, &vp);
+        size_t brute_visible = 0;
+        for (size_t i = 0; i < buildings; i++)
+            brute_visible += test_aabb(&f, &bvh->item_world[i * 6], &bvh->item_world[i * 6 + 3]) != CULL_OUTSIDE;
+        brute_ms += bench_ms_since(start);
+        if (brute_visible != bvh->stats.visible)
+            SDL_Log("BVH cull mismatch: %zu vs %zu brute force", bvh->stats.visible, brute_visible);
+    }
+
+    SDL_Log("BVH cull bench (%zu buildings, %zu BVH nodes): build %.2f ms, refit %.3f ms (%zu items), "
+            "cull %.3f ms vs %.3f ms brute force, %.1f%% culled",
+            buildings, bvh->node_count, bvh->stats.build_ms, refit_ms / frames, refit_items / frames, cull_ms / frames,
+            brute_ms / frames, 100.0 * (1.0 - (double)visible / ((double)buildings * frames)));
+
+done:
+    scene_bvh_free(bvh);
+    scene_graph_free(graph);
+    SDL_free(parent);
+    SDL_free(item_node);
+    SDL_free(item_prim);
+    SDL_free(bounds);
+}
@@ -0,0 +1,73 @@
+#ifndef CUMULUS_SCENE_BVH_H
+#define CUMULUS_SCENE_BVH_H
+
+#include "vecmath.h"
+#include <SDL3/SDL.h>
+
+struct Model;
+struct SceneGraph;
+
+/* Bounding-volume hierarchy over the world-space AABBs of a scene's
+   primitives, used for frustum culling. Items are (scene node, primitive)
+   pairs kept in scene node order so a changed subtree maps to a contiguous
+   item range. */
+typedef struct SceneBvhNode
+{
+    float min[3];
+    float max[3];
+    Uint32 left;  /* first child (right is left + 1), 0 for leaves */
+    Uint32 first; /* first entry of SceneBvh.order under this node */
+    Uint32 count; /* entries under this node */
+} SceneBvhNode;
+
+typedef struct SceneBvhStats
+{
+    double build_ms;
+    double refit_ms;
+    double cull_ms;
+    size_t refit_items; /* item bounds recomputed by the last refit */
+    size_t visible;     /* items in the frustum after the last cull */
+    size_t nodes_tested;
+} SceneBvhStats;
+
+typedef struct SceneBvh
+{
+    size_t item_count;
+    Uint32 *item_node;      /* flat scene node index, ascending */
+    Uint32 *item_primitive; /* index into Model.primitives, or caller-defined */
+    float *item_local;      /* 6 per item: local min xyz, max xyz */
+    float *item_world;      /* 6 per item: world min xyz, max xyz */
+    Uint8 *visible;         /* per item, written by scene_bvh_cull */
+
+    SceneBvhNode *nodes;
+    size_t node_count;
+    Uint32 *order;     /* item indices in leaf order */
+    Uint32 *parent;    /* per BVH node, 0 for the root */
+    Uint32 *item_leaf; /* per item */
+    Uint8 *node_dirty;
+
+    SceneBvhStats stats;
+} SceneBvh;
+
+/* Build over explicit items sorted by scene node. local_bounds holds 6
+   floats per item. */
+SceneBvh *scene_bvh_create(const struct SceneGraph *graph, size_t count, const Uint32 *item_node,
+                           const Uint32 *item_primitive, const float *local_bounds);
+
+/* One item per primitive of every mesh node, bounds from POSITION min/max */
+SceneBvh *scene_bvh_build_model(const struct Model *model);
+
+void scene_bvh_free(SceneBvh *bvh);
+
+/* Pull new world bounds for the subtrees the last scene_graph_update
+   changed and refit the affected BVH nodes bottom-up. */
+void scene_bvh_refit(SceneBvh *bvh, const struct SceneGraph *graph);
+
+/* Mark items intersecting the frustum of view_proj in bvh->visible.
+   Returns the visible item count. */
+size_t scene_bvh_cull(SceneBvh *bvh, const Mat4 *view_proj);
+
+/* Log build, refit and cull timings on a synthetic city grid */
+void scene_bvh_benchmark(void);
+
+#endif /* CUMULUS_SCENE_BVH_H */
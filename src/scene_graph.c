@@ -0,0 +1,434 @@
+#include "scene_graph.h"
+#include "bench.h"
+
+#include <SDL3/SDL.h>
+#include <cgltf.h>
+
+static const float IDENTITY_T[3] = {0.0f, 0.0f, 0.0f};
+static const float IDENTITY_R[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+static const float IDENTITY_S[3] = {1.0f, 1.0f, 1.0f};
+
+/*================================================================================
+ * Construction
+ *================================================================================*/
+static SceneGraph *alloc_graph(size_t count)
+{
+    SceneGraph *graph = SDL_calloc(1, sizeof(SceneGraph));
+    if (!graph)
+        return NULL;
+
+    size_t n = count ? count : 1;
+    graph->count = count;
+    graph->parent = SDL_malloc(n * sizeof(Sint32));
+    graph->subtree_end = SDL_malloc(n * sizeof(Uint32));
+    graph->translation = SDL_malloc(n * 3 * sizeof(float));
+    graph->rotation = SDL_malloc(n * 4 * sizeof(float));
+    graph->scale = SDL_malloc(n * 3 * sizeof(float));
+    graph->local = SDL_aligned_alloc(16, n * sizeof(Mat4));
+    graph->world = SDL_aligned_alloc(16, n * sizeof(Mat4));
+    graph->flags = SDL_calloc(n, 1);
+    graph->mesh = SDL_malloc(n * sizeof(Sint32));
+    graph->source = SDL_malloc(n * sizeof(Sint32));
+
+    if (!graph->parent || !graph->subtree_end || !graph->translation || !graph->rotation || !graph->scale ||
+        !graph->local || !graph->world || !graph->flags || !graph->mesh || !graph->source)
+    {
+        scene_graph_free(graph);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        SDL_memcpy(&graph->translation[i * 3], IDENTITY_T, sizeof(IDENTITY_T));
+        SDL_memcpy(&graph->rotation[i * 4], IDENTITY_R, sizeof(IDENTITY_R));
+        SDL_memcpy(&graph->scale[i * 3], IDENTITY_S, sizeof(IDENTITY_S));
+        graph->flags[i] = SCENE_NODE_DIRTY;
+        graph->mesh[i] = -1;
+        graph->source[i] = -1;
+    }
+    return graph;
+}
+
+/* Preorder guarantees every descendant of i follows i and precedes the next
+   node that is not a descendant, so walking backwards finds each range end. */
+static void compute_subtree_ends(SceneGraph *graph)
+{
+    for (size_t i = 0; i < graph->count; i++)
+        graph->subtree_end[i] = (Uint32)(i + 1);
+    for (size_t i = graph->count; i-- > 0;)
+    {
+        Sint32 p = graph->parent[i];
+        if (p >= 0 && graph->subtree_end[p] < graph->subtree_end[i])
+            graph->subtree_end[p] = graph->subtree_end[i];
+    }
+}
+
+SceneGraph *scene_graph_create(size_t count, const Sint32 *parent)
+{
+    SceneGraph *graph = alloc_graph(count);
+    if (!graph)
+        return NULL;
+
+    SDL_memcpy(graph->parent, parent, count * sizeof(Sint32));
+    compute_subtree_ends(graph);
+    scene_graph_update_all(graph);
+    return graph;
+}
+
+/* EXT_mesh_gpu_instancing: instances drawn for a node, 0 without the extension */
+static size_t gpu_instance_count(const cgltf_node *node)
+{
+    if (!node->has_mesh_gpu_instancing || !node->mesh)
+        return 0;
+
+    size_t count = 0;
+    for (size_t a = 0; a < node->mesh_gpu_instancing.attributes_count; a++)
+    {
+        const cgltf_accessor *acc = node->mesh_gpu_instancing.attributes[a].data;
+        if (acc)
+            count = count ? SDL_min(count, acc->count) : acc->count;
+    }
+    return count;
+}
+
+/* Instances become synthetic leaf children of the node, right after it in
+   preorder, each carrying the node's mesh; the node itself draws nothing. */
+static void expand_gpu_instances(SceneGraph *graph, const cgltf_node *node, Sint32 mesh, Uint32 parent, size_t *count)
+{
+    size_t instances = gpu_instance_count(node);
+    Uint32 first = (Uint32)*count;
+    for (size_t i = 0; i < instances; i++)
+    {
+        graph->parent[first + i] = (Sint32)parent;
+        graph->mesh[first + i] = mesh;
+    }
+    graph->mesh[parent] = -1;
+    *count += instances;
+
+    /* Instance TRS are contiguous, so accessors unpack straight into place */
+    for (size_t a = 0; a < node->mesh_gpu_instancing.attributes_count; a++)
+    {
+        const cgltf_attribute *attr = &node->mesh_gpu_instancing.attributes[a];
+        if (!attr->data || !attr->name)
+            continue;
+        if (SDL_strcmp(attr->name, "TRANSLATION") == 0 && attr->data->type == cgltf_type_vec3)
+            cgltf_accessor_unpack_floats(attr->data, &graph->translation[first * 3], instances * 3);
+        else if (SDL_strcmp(attr->name, "ROTATION") == 0 && attr->data->type == cgltf_type_vec4)
+            cgltf_accessor_unpack_floats(attr->data, &graph->rotation[first * 4], instances * 4);
+        else if (SDL_strcmp(attr->name, "SCALE") == 0 && attr->data->type == cgltf_type_vec3)
+            cgltf_accessor_unpack_floats(attr->data, &graph->scale[first * 3], instances * 3);
+    }
+}
+
+SceneGraph *scene_graph_build(const cgltf_data *data)
+{
+    /* Roots: the default scene, else the first scene, else every parentless node */
+    const cgltf_scene *scene = data->scene ? data->scene : (data->scenes_count ? &data->scenes[0] : NULL);
+    size_t root_limit = scene ? scene->nodes_count : data->nodes_count;
+
+    /* Every node is reachable at most once, so nodes_count bounds the stack */
+    const cgltf_node **stack = SDL_malloc((data->nodes_count + 1) * sizeof(cgltf_node *));
+    Sint32 *stack_parent = SDL_malloc((data->nodes_count + 1) * sizeof(Sint32));
+    Uint32 *node_map = SDL_malloc((data->nodes_count + 1) * sizeof(Uint32));
+    size_t instances = 0;
+    for (size_t i = 0; i < data->nodes_count; i++)
+        instances += gpu_instance_count(&data->nodes[i]);
+    SceneGraph *graph = alloc_graph(data->nodes_count + instances);
+    if (!stack || !stack_parent || !node_map || !graph)
+    {
+        SDL_free(stack);
+        SDL_free(stack_parent);
+        SDL_free(node_map);
+        scene_graph_free(graph);
+        return NULL;
+    }
+    for (size_t i = 0; i < data->nodes_count; i++)
+        node_map[i] = SCENE_NODE_NONE;
+
+    size_t count = 0;
+    size_t top = 0;
+    size_t next_root = 0;
+    while (next_root < root_limit || top > 0)
+    {
+        if (top == 0)
+        {
+            const cgltf_node *root = NULL;
+            if (scene)
+            {
+                root = scene->nodes[next_root++];
+            }
+            else
+            {
+                while (!root && next_root < data->nodes_count)
+                {
+                    const cgltf_node *candidate = &data->nodes[next_root++];
+                    root = candidate->parent ? NULL : candidate;
+                }
+                if (!root)
+                    break;
+            }
+            stack[top] = root;
+            stack_parent[top] = -1;
+            top++;
+        }
+
+        const cgltf_node *node = stack[--top];
+        Sint32 parent = stack_parent[top];
+        size_t source = (size_t)(node - data->nodes);
+        if (node_map[source] != SCENE_NODE_NONE)
+            continue; /* malformed file listing a node twice */
+
+        Uint32 index = (Uint32)count++;
+        node_map[source] = index;
+        graph->parent[index] = parent;
+        graph->source[index] = (Sint32)source;
+        graph->mesh[index] = node->mesh ? (Sint32)(node->mesh - data->meshes) : -1;
+
+        if (node->has_matrix)
+        {
+            SDL_memcpy(graph->local[index].m, node->matrix, sizeof(Mat4));
+            graph->flags[index] = SCENE_NODE_MATRIX;
+        }
+        else
+        {
+            if (node->has_translation)
+                SDL_memcpy(&graph->translation[index * 3], node->translation, 3 * sizeof(float));
+            if (node->has_rotation)
+                SDL_memcpy(&graph->rotation[index * 4], node->rotation, 4 * sizeof(float));
+            if (node->has_scale)
+                SDL_memcpy(&graph->scale[index * 3], node->scale, 3 * sizeof(float));
+        }
+        if (gpu_instance_count(node) > 0)
+            expand_gpu_instances(graph, node, graph->mesh[index], index, &count);
+
+        /* Push children in reverse so the first child is visited first */
+        for (size_t c = node->children_count; c-- > 0;)
+        {
+            if (top >= data->nodes_count)
+                break;
+            stack[top] = node->children[c];
+            stack_parent[top] = (Sint32)index;
+            top++;
+        }
+    }
+
+    SDL_free(stack);
+    SDL_free(stack_parent);
+
+    graph->count = count;
+    graph->node_map = node_map;
+    graph->node_map_count = data->nodes_count;
+    compute_subtree_ends(graph);
+    scene_graph_update_all(graph);
+    return graph;
+}
+
+void scene_graph_free(SceneGraph *graph)
+{
+    if (!graph)
+        return;
+
+    SDL_free(graph->parent);
+    SDL_free(graph->subtree_end);
+    SDL_free(graph->translation);
+    SDL_free(graph->rotation);
+    SDL_free(graph->scale);
+    SDL_aligned_free(graph->local);
+    SDL_aligned_free(graph->world);
+    SDL_free(graph->flags);
+    SDL_free(graph->mesh);
+    SDL_free(graph->source);
+    SDL_free(graph->node_map);
+    SDL_free(graph->dirty);
+    SDL_free(graph->changed);
+    SDL_free(graph);
+}
+
+/*================================================================================
+ * Updates
+ *================================================================================*/
+void scene_graph_set_trs(SceneGraph *graph, Uint32 node, const float t[3], const float r[4], const float s[3])
+{
+    if (node >= graph->count)
+        return;
+
+    if (t)
+        SDL_memcpy(&graph->translation[node * 3], t, 3 * sizeof(float));
+    if (r)
+        SDL_memcpy(&graph->rotation[node * 4], r, 4 * sizeof(float));
+    if (s)
+        SDL_memcpy(&graph->scale[node * 3], s, 3 * sizeof(float));
+
+    /* Animated nodes are driven by TRS even if the file gave a matrix */
+    Uint8 flags = graph->flags[node];
+    graph->flags[node] = (Uint8)((flags & ~SCENE_NODE_MATRIX) | SCENE_NODE_DIRTY);
+    if ((flags & SCENE_NODE_QUEUED) || graph->all_dirty)
+        return;
+
+    if (graph->dirty_count == graph->dirty_capacity)
+    {
+        size_t capacity = graph->dirty_capacity ? graph->dirty_capacity * 2 : 64;
+        Uint32 *dirty = SDL_realloc(graph->dirty, capacity * sizeof(Uint32));
+        Uint32 *changed = dirty ? SDL_realloc(graph->changed, capacity * sizeof(Uint32)) : NULL;
+        if (dirty)
+            graph->dirty = dirty;
+        if (!changed)
+        {
+            /* Fall back to a full update rather than losing the change */
+            graph->all_dirty = true;
+            return;
+        }
+        graph->changed = changed;
+        graph->dirty_capacity = capacity;
+    }
+    graph->dirty[graph->dirty_count++] = node;
+    graph->flags[node] |= SCENE_NODE_QUEUED;
+}
+
+static inline void update_node(SceneGraph *graph, size_t i)
+{
+    Uint8 flags = graph->flags[i];
+    if (flags & SCENE_NODE_DIRTY)
+    {
+        if (!(flags & SCENE_NODE_MATRIX))
+            mat4_from_trs(&graph->local[i], &graph->translation[i * 3], &graph->rotation[i * 4], &graph->scale[i * 3]);
+    }
+    graph->flags[i] = (Uint8)(flags & SCENE_NODE_MATRIX);
+
+    Sint32 p = graph->parent[i];
+    if (p < 0)
+        graph->world[i] = graph->local[i];
+    else
+        mat4_mul(&graph->world[i], &graph->world[p], &graph->local[i]);
+}
+
+void scene_graph_update_all(SceneGraph *graph)
+{
+    /* Preorder: every parent's world matrix is final before its children */
+    for (size_t i = 0; i < graph->count; i++)
+    {
+        graph->flags[i] |= SCENE_NODE_DIRTY;
+        update_node(graph, i);
+    }
+    graph->dirty_count = 0;
+    graph->all_dirty = false;
+    graph->changed_count = 0;
+    graph->all_changed = true;
+}
+
+static int SDLCALL compare_u32(const void *a, const void *b)
+{
+    Uint32 x = *(const Uint32 *)a, y = *(const Uint32 *)b;
+    return (x > y) - (x < y);
+}
+
+size_t scene_graph_update(SceneGraph *graph)
+{
+    if (graph->all_dirty)
+    {
+        scene_graph_update_all(graph);
+        return graph->count;
+    }
+    graph->changed_count = 0;
+    graph->all_changed = false;
+    if (graph->dirty_count == 0)
+        return 0;
+
+    /* Ascending order visits ancestors before descendants, so a dirty node
+       inside an already swept subtree is skipped; the sweep handled it. */
+    SDL_qsort(graph->dirty, graph->dirty_count, sizeof(Uint32), compare_u32);
+
+    size_t touched = 0;
+    Uint32 covered_end = 0;
+    for (size_t d = 0; d < graph->dirty_count; d++)
+    {
+        Uint32 root = graph->dirty[d];
+        if (root < covered_end)
+            continue;
+
+        Uint32 end = graph->subtree_end[root];
+        for (Uint32 i = root; i < end; i++)
+            update_node(graph, i);
+        touched += end - root;
+        covered_end = end;
+        graph->changed[graph->changed_count++] = root;
+    }
+    graph->dirty_count = 0;
+    return touched;
+}
+
+/*================================================================================
+ * Benchmark
+ *================================================================================*/
+void scene_graph_benchmark(size_t node_count)
+{
+    Sint32 *parent = SDL_malloc(node_count * sizeof(Sint32));
+    Sint32 *path = SDL_malloc((node_count + 1) * sizeof(Sint32));
+    if (!parent || !path)
+    {
+        SDL_free(parent);
+        SDL_free(path);
+        return;
+    }
+
+    /* Random preorder tree: each node's parent is somewhere on the path to
+       the previous node, keeping depth bounded around a dozen levels. */
+    Uint64 seed = 0x2545F4914F6CDD1Dull;
+    size_t depth = 0;
+    for (size_t i = 0; i < node_count; i++)
+    {
+        Sint32 r = SDL_rand_r(&seed, 100);
+        if (depth > 0 && (r < 30 || depth > 12))
+            depth -= 1 + (size_t)SDL_rand_r(&seed, (Sint32)(depth < 3 ? depth : 3));
+        parent[i] = depth > 0 ? path[depth - 1] : -1;
+        path[depth++] = (Sint32)i;
+    }
+    SDL_free(path);
+
+    SceneGraph *graph = scene_graph_create(node_count, parent);
+    SDL_free(parent);
+    if (!graph)
+        return;
+
+    const int runs = 20;
+    Uint64 start = bench_now();
+    for (int r = 0; r < runs; r++)
+        scene_graph_update_all(graph);
+    double full_ms = bench_ms_since(start) / runs;
+
+    /* Partial: 1% of nodes animated per frame */
+    size_t dirty_nodes = node_count / 100 ? node_count / 100 : 1;
+    size_t touched = 0;
+    double partial_ms = 0.0;
+    for (int r = 0; r < runs; r++)
+    {
+        for (size_t k = 0; k < dirty_nodes; k++)
+        {
+            Uint32 node = (Uint32)SDL_rand_r(&seed, (Sint32)node_count);
+            float t[3] = {(float)r, 0.0f, (float)k};
+            scene_graph_set_trs(graph, node, t, NULL, NULL);
+        }
+        start = bench_now();
+        touched += scene_graph_update(graph);
+        partial_ms += bench_ms_since(start);
+    }
+    partial_ms /= runs;
+    touched /= runs;
+
+    /* Single leaf: the common case of one moving object */
+    Uint32 leaf = (Uint32)(node_count - 1);
+    start = bench_now();
+    for (int r = 0; r < runs; r++)
+    {
+        float t[3] = {(float)r, 1.0f, 0.0f};
+        scene_graph_set_trs(graph, leaf, t, NULL, NULL);
+        scene_graph_update(graph);
+    }
+    double leaf_ms = bench_ms_since(start) / runs;
+
+    SDL_Log("Scene graph bench (%zu nodes): full %.3f ms, 1%% dirty %.3f ms (%zu nodes touched), "
+            "one leaf %.4f ms",
+            node_count, full_ms, partial_ms, touched, leaf_ms);
+
+    scene_graph_free(graph);
+}
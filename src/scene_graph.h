@@ -0,0 +1,73 @@
+#ifndef CUMULUS_SCENE_GRAPH_H
+#define CUMULUS_SCENE_GRAPH_H
+
+#include "vecmath.h"
+#include <SDL3/SDL.h>
+
+struct cgltf_data;
+
+#define SCENE_NODE_NONE 0xFFFFFFFFu
+
+/* Flattened transform hierarchy. Nodes are stored in depth-first preorder,
+   so parent[i] < i and the subtree of node i is the contiguous range
+   [i, subtree_end[i]). All per-node data is kept in parallel arrays. */
+typedef struct SceneGraph
+{
+    size_t count;
+    Sint32 *parent;       /* -1 for roots */
+    Uint32 *subtree_end;  /* exclusive */
+    float *translation;   /* 3 per node */
+    float *rotation;      /* 4 per node, quaternion x, y, z, w */
+    float *scale;         /* 3 per node */
+    Mat4 *local;
+    Mat4 *world;
+    Uint8 *flags;         /* SCENE_NODE_* bits */
+    Sint32 *mesh;         /* glTF mesh index, -1 if none */
+    Sint32 *source;       /* glTF node index, -1 for synthetic nodes */
+
+    Uint32 *node_map;     /* glTF node index -> flat index, SCENE_NODE_NONE if not in the scene */
+    size_t node_map_count;
+
+    Uint32 *dirty;        /* nodes changed since the last update */
+    size_t dirty_count;
+    size_t dirty_capacity;
+    bool all_dirty;       /* the dirty list could not grow: the next update is a full one */
+
+    /* Subtree roots whose world matrices the last update rewrote, ascending;
+       all_changed is set instead after a full update. */
+    Uint32 *changed;
+    size_t changed_count;
+    bool all_changed;
+} SceneGraph;
+
+enum
+{
+    SCENE_NODE_DIRTY = 1 << 0,  /* local TRS changed */
+    SCENE_NODE_MATRIX = 1 << 1, /* local matrix given directly, TRS unused */
+    SCENE_NODE_QUEUED = 1 << 2  /* already in the dirty list */
+};
+
+/* Flatten the default scene of `data` (or every root node if it has none)
+   and compute world matrices. Returns NULL on allocation failure. */
+SceneGraph *scene_graph_build(const struct cgltf_data *data);
+
+/* Identity-TRS graph from a preorder parent array (parent[i] < i) */
+SceneGraph *scene_graph_create(size_t count, const Sint32 *parent);
+
+void scene_graph_free(SceneGraph *graph);
+
+/* Set any of a node's local translation / rotation / scale (NULL keeps the
+   current value) and mark its subtree for the next update. */
+void scene_graph_set_trs(SceneGraph *graph, Uint32 node, const float t[3], const float r[4], const float s[3]);
+
+/* Recompute world matrices of dirty subtrees only, or of every node after
+   all_dirty was set. Returns nodes touched. */
+size_t scene_graph_update(SceneGraph *graph);
+
+/* Recompute every local and world matrix */
+void scene_graph_update_all(SceneGraph *graph);
+
+/* Log full and partial update timings on a synthetic hierarchy */
+void scene_graph_benchmark(size_t node_count);
+
+#endif /* CUMULUS_SCENE_GRAPH_H */
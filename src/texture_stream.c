@@ -0,0 +1,924 @@
+#include "texture_stream.h"
+#include "bench.h"
+#include "model_import.h"
+#include "parallel.h"
+#include "residency.h"
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_intrin.h>
+#include <cgltf.h>
+
+#define STBI_ONLY_PNG
+#define STBI_ONLY_JPEG
+#define STBI_NO_STDIO
+#define STBI_MALLOC(sz) SDL_malloc(sz)
+#define STBI_REALLOC(p, newsz) SDL_realloc(p, newsz)
+#define STBI_FREE(p) SDL_free(p)
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#define TEXTURE_MAX_LEVELS 16
+#define TEXTURE_STAGING_BUFFERS 2
+#define TEXTURE_STAGING_SIZE (4u * 1024u * 1024u)
+#define TEXTURE_MAX_UPLOADS_PER_BUFFER 256
+/* Levels with more texels than this are downsampled across the pool */
+#define TEXTURE_PARALLEL_MIP_TEXELS (512u * 512u)
+
+typedef enum TextureState
+{
+    TEXTURE_QUEUED,
+    TEXTURE_DECODING,
+    TEXTURE_DECODED,
+    TEXTURE_UPLOADING,
+    TEXTURE_RESIDENT,
+    TEXTURE_FAILED
+} TextureState;
+
+typedef struct TextureLevel
+{
+    size_t offset;
+    size_t size;
+    Uint32 width;
+    Uint32 height;
+} TextureLevel;
+
+typedef struct TextureEntry
+{
+    const cgltf_image *image;
+    const char *base_dir;
+    bool srgb;
+    SDL_AtomicInt state;
+
+    /* Written by the decode task, read by the main thread after DECODED */
+    SDL_GPUTextureFormat format;
+    Uint32 num_levels;
+    TextureLevel levels[TEXTURE_MAX_LEVELS];
+    Uint8 *pixels;
+    size_t pixels_size;
+    size_t decode_bytes; /* what the last refused decode needed reserved, 0 if none was refused */
+
+    SDL_GPUTexture *texture;
+    Uint32 first_level; /* levels dropped to fit the texture budget */
+    Uint32 upload_level;
+    Uint32 upload_row; /* in texels */
+} TextureEntry;
+
+struct TextureStreamer
+{
+    SDL_GPUDevice *device;
+    SDL_GPUTransferBuffer *staging[TEXTURE_STAGING_BUFFERS];
+
+    TextureEntry *entries;
+    size_t count;
+    char *base_dir;
+    SDL_AtomicInt in_flight;
+    size_t last_uploaded;
+    Uint64 load_start;
+    bool reported;
+};
+
+/*================================================================================
+ * Source bytes
+ *================================================================================*/
+static int base64_value(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A';
+    if (c >= 'a' && c <= 'z')
+        return c - 'a' + 26;
+    if (c >= '0' && c <= '9')
+        return c - '0' + 52;
+    if (c == '+' || c == '-')
+        return 62;
+    if (c == '/' || c == '_')
+        return 63;
+    return -1;
+}
+
+static Uint8 *decode_data_uri(const char *uri, size_t *out_size)
+{
+    const char *comma = SDL_strchr(uri, ',');
+    if (!comma || !SDL_strstr(uri, ";base64"))
+        return NULL;
+
+    const char *src = comma + 1;
+    size_t len = SDL_strlen(src);
+    Uint8 *out = SDL_malloc(len / 4 * 3 + 3);
+    if (!out)
+        return NULL;
+
+    size_t n = 0;
+    Uint32 acc = 0;
+    int bits = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        int v = base64_value(src[i]);
+        if (v < 0)
+            continue;
+        acc = (acc << 6) | (Uint32)v;
+        bits += 6;
+        if (bits >= 8)
+        {
+            bits -= 8;
+            out[n++] = (Uint8)(acc >> bits);
+        }
+    }
+    *out_size = n;
+    return out;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/* Returns owned bytes of the entry's image, or NULL. *owned tells the caller
+   whether to SDL_free the result. */
+static const Uint8 *load_image_bytes(const TextureEntry *entry, size_t *size, bool *owned)
+{
+    const cgltf_image *image = entry->image;
+    *owned = false;
+
+    if (image->buffer_view)
+    {
+        const Uint8 *data = accessor_view_data(image->buffer_view);
+        *size = image->buffer_view->size;
+        return data;
+    }
+    if (!image->uri)
+        return NULL;
+
+    if (SDL_strncmp(image->uri, "data:", 5) == 0)
+    {
+        *owned = true;
+        return decode_data_uri(image->uri, size);
+    }
+
+    /* Relative file path, percent-decoded */
+    char path[2048];
+    size_t n = SDL_strlcpy(path, entry->base_dir, sizeof(path));
+    for (const char *p = image->uri; *p && n + 1 < sizeof(path); p++)
+    {
+        if (p[0] == '%' && hex_value(p[1]) >= 0 && hex_value(p[2]) >= 0)
+        {
+            path[n++] = (char)(hex_value(p[1]) * 16 + hex_value(p[2]));
+            p += 2;
+        }
+        else
+        {
+            path[n++] = *p;
+        }
+    }
+    path[n] = '\0';
+
+    *owned = true;
+    return SDL_LoadFile(path, size);
+}
+
+/*================================================================================
+ * Mip generation — 2x2 box filter on RGBA8
+ *================================================================================*/
+typedef struct MipJob
+{
+    const Uint8 *src;
+    Uint32 sw, sh;
+    Uint8 *dst;
+    Uint32 dw;
+} MipJob;
+
+static void downsample_rows(void *userdata, size_t begin, size_t end)
+{
+    const MipJob *job = userdata;
+    const size_t src_pitch = (size_t)job->sw * 4;
+
+    for (size_t y = begin; y < end; y++)
+    {
+        Uint32 y0 = (Uint32)y * 2 < job->sh ? (Uint32)y * 2 : job->sh - 1;
+        Uint32 y1 = y0 + 1 < job->sh ? y0 + 1 : y0;
+        const Uint8 *r0 = job->src + y0 * src_pitch;
+        const Uint8 *r1 = job->src + y1 * src_pitch;
+        Uint8 *out = job->dst + y * (size_t)job->dw * 4;
+        Uint32 x = 0;
+
+#if defined(SDL_SSE2_INTRINSICS)
+        /* Two output texels per iteration from four source texels per row */
+        for (; x + 2 <= job->dw && x * 2 + 4 <= job->sw; x += 2)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)(r0 + x * 8));
+            __m128i b = _mm_loadu_si128((const __m128i *)(r1 + x * 8));
+            __m128i v = _mm_avg_epu8(a, b);
+            __m128i even = _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128i odd = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storel_epi64((__m128i *)(out + x * 4), _mm_avg_epu8(even, odd));
+        }
+#elif defined(SDL_NEON_INTRINSICS)
+        for (; x + 2 <= job->dw && x * 2 + 4 <= job->sw; x += 2)
+        {
+            uint8x16_t v = vrhaddq_u8(vld1q_u8(r0 + x * 8), vld1q_u8(r1 + x * 8));
+            uint32x4x2_t split = vuzpq_u32(vreinterpretq_u32_u8(v), vreinterpretq_u32_u8(v));
+            uint8x16_t avg = vrhaddq_u8(vreinterpretq_u8_u32(split.val[0]), vreinterpretq_u8_u32(split.val[1]));
+            vst1_u8(out + x * 4, vget_low_u8(avg));
+        }
+#endif
+        for (; x < job->dw; x++)
+        {
+            Uint32 x0 = x * 2 < job->sw ? x * 2 : job->sw - 1;
+            Uint32 x1 = x0 + 1 < job->sw ? x0 + 1 : x0;
+            for (int c = 0; c < 4; c++)
+            {
+                /* Same rounding as the SIMD path: average rows, then columns */
+                int left = (r0[x0 * 4 + c] + r1[x0 * 4 + c] + 1) >> 1;
+                int right = (r0[x1 * 4 + c] + r1[x1 * 4 + c] + 1) >> 1;
+                out[x * 4 + c] = (Uint8)((left + right + 1) >> 1);
+            }
+        }
+    }
+}
+
+static Uint32 mip_count(Uint32 w, Uint32 h)
+{
+    Uint32 levels = 1;
+    while ((w > 1 || h > 1) && levels < TEXTURE_MAX_LEVELS)
+    {
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+        levels++;
+    }
+    return levels;
+}
+
+static size_t rgba_chain_size(Uint32 w, Uint32 h)
+{
+    size_t total = 0;
+    for (Uint32 i = 0, levels = mip_count(w, h); i < levels; i++)
+    {
+        total += (size_t)w * h * 4;
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+    return total;
+}
+
+/* Takes ownership of base (w*h RGBA8) and fills the entry with a full chain */
+static bool build_rgba_chain(TextureEntry *entry, Uint8 *base, Uint32 w, Uint32 h)
+{
+    Uint32 levels = mip_count(w, h);
+    size_t total = 0;
+    for (Uint32 i = 0, lw = w, lh = h; i < levels; i++)
+    {
+        entry->levels[i] = (TextureLevel){total, (size_t)lw * lh * 4, lw, lh};
+        total += entry->levels[i].size;
+        lw = lw > 1 ? lw / 2 : 1;
+        lh = lh > 1 ? lh / 2 : 1;
+    }
+
+    Uint8 *pixels = SDL_realloc(base, total);
+    if (!pixels)
+    {
+        SDL_free(base);
+        return false;
+    }
+
+    for (Uint32 i = 1; i < levels; i++)
+    {
+        const TextureLevel *src = &entry->levels[i - 1];
+        const TextureLevel *dst = &entry->levels[i];
+        MipJob job = {pixels + src->offset, src->width, src->height, pixels + dst->offset, dst->width};
+        if ((size_t)dst->width * dst->height >= TEXTURE_PARALLEL_MIP_TEXELS)
+            parallel_for(dst->height, 32, downsample_rows, &job);
+        else
+            downsample_rows(&job, 0, dst->height);
+    }
+
+    entry->format = entry->srgb ? SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM_SRGB : SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    entry->num_levels = levels;
+    entry->pixels = pixels;
+    entry->pixels_size = total;
+    return true;
+}
+
+/*================================================================================
+ * KTX2 (no supercompression; RGBA8 or BCn payloads)
+ *================================================================================*/
+static const Uint8 KTX2_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+static Uint32 read_u32(const Uint8 *p)
+{
+    return (Uint32)p[0] | ((Uint32)p[1] << 8) | ((Uint32)p[2] << 16) | ((Uint32)p[3] << 24);
+}
+
+static Uint64 read_u64(const Uint8 *p)
+{
+    return (Uint64)read_u32(p) | ((Uint64)read_u32(p + 4) << 32);
+}
+
+static SDL_GPUTextureFormat ktx2_format(Uint32 vk_format)
+{
+    switch (vk_format)
+    {
+    case 37: /* VK_FORMAT_R8G8B8A8_UNORM */
+        return SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    case 43: /* VK_FORMAT_R8G8B8A8_SRGB */
+        return SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM_SRGB;
+    case 133: /* VK_FORMAT_BC1_RGBA_UNORM_BLOCK */
+        return SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM;
+    case 134:
+        return SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM_SRGB;
+    case 137: /* VK_FORMAT_BC3_UNORM_BLOCK */
+        return SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM;
+    case 138:
+        return SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM_SRGB;
+    case 139: /* VK_FORMAT_BC4_UNORM_BLOCK */
+        return SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM;
+    case 141: /* VK_FORMAT_BC5_UNORM_BLOCK */
+        return SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM;
+    case 145: /* VK_FORMAT_BC7_UNORM_BLOCK */
+        return SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM;
+    case 146:
+        return SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM_SRGB;
+    default:
+        return SDL_GPU_TEXTUREFORMAT_INVALID;
+    }
+}
+
+static bool format_is_block_compressed(SDL_GPUTextureFormat format)
+{
+    return format != SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM && format != SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM_SRGB;
+}
+
+static bool is_ktx2(const Uint8 *data, size_t size)
+{
+    return size >= 80 && SDL_memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0;
+}
+
+static bool decode_ktx2(TextureEntry *entry, const Uint8 *data, size_t size)
+{
+    Uint32 vk_format = read_u32(data + 12);
+    Uint32 width = read_u32(data + 20);
+    Uint32 height = read_u32(data + 24);
+    Uint32 levels = read_u32(data + 40);
+    Uint32 supercompression = read_u32(data + 44);
+    levels = levels ? levels : 1;
+
+    SDL_GPUTextureFormat format = ktx2_format(vk_format);
+    if (supercompression != 0 || format == SDL_GPU_TEXTUREFORMAT_INVALID)
+    {
+        /* BasisLZ / UASTC need a transcoder that is not linked in */
+        SDL_Log("Texture '%s': KTX2 vkFormat %u / supercompression %u not supported",
+                entry->image->name ? entry->image->name : "(unnamed)", vk_format, supercompression);
+        return false;
+    }
+    if (levels > TEXTURE_MAX_LEVELS || 80 + (size_t)levels * 24 > size || width == 0 || height == 0)
+        return false;
+
+    /* Each level must lie inside the file and hold exactly one 2D image of
+       its size; arrays, cube maps and truncated or padded levels are refused */
+    size_t total = 0;
+    for (Uint32 i = 0; i < levels; i++)
+    {
+        Uint64 src_offset = read_u64(data + 80 + i * 24);
+        Uint64 length = read_u64(data + 80 + i * 24 + 8);
+        Uint32 lw = width >> i ? width >> i : 1;
+        Uint32 lh = height >> i ? height >> i : 1;
+        Uint32 expected = SDL_CalculateGPUTextureFormatSize(format, lw, lh, 1);
+        if (expected == 0 || length != expected || src_offset > size || length > size - src_offset)
+        {
+            SDL_Log("Texture '%s': KTX2 level %u is %llu bytes at %llu, expected %u inside %zu",
+                    entry->image->name ? entry->image->name : "(unnamed)", i, (unsigned long long)length,
+                    (unsigned long long)src_offset, expected, size);
+            return false;
+        }
+        total += expected; /* at most TEXTURE_MAX_LEVELS sizes, each within the file */
+    }
+
+    Uint8 *pixels = SDL_malloc(total);
+    if (!pixels)
+        return false;
+
+    size_t offset = 0;
+    for (Uint32 i = 0; i < levels; i++)
+    {
+        Uint64 src_offset = read_u64(data + 80 + i * 24);
+        size_t length = (size_t)read_u64(data + 80 + i * 24 + 8);
+        SDL_memcpy(pixels + offset, data + src_offset, length);
+        Uint32 lw = width >> i ? width >> i : 1;
+        Uint32 lh = height >> i ? height >> i : 1;
+        entry->levels[i] = (TextureLevel){offset, length, lw, lh};
+        offset += length;
+    }
+
+    /* Single-level RGBA8 still gets a CPU mip chain */
+    if (levels == 1 && (format == SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM ||
+                        format == SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM_SRGB))
+    {
+        entry->srgb = entry->srgb || format == SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM_SRGB;
+        return build_rgba_chain(entry, pixels, width, height);
+    }
+
+    entry->format = format;
+    entry->num_levels = levels;
+    entry->pixels = pixels;
+    entry->pixels_size = total;
+    return true;
+}
+
+/* Bytes the decoded chain will hold, read from the header alone; 0 when
+   it cannot be read, and decoding then fails on its own */
+static size_t decoded_size(const Uint8 *bytes, size_t size)
+{
+    if (is_ktx2(bytes, size))
+    {
+        SDL_GPUTextureFormat format = ktx2_format(read_u32(bytes + 12));
+        Uint32 width = read_u32(bytes + 20);
+        Uint32 height = read_u32(bytes + 24);
+        Uint32 levels = read_u32(bytes + 40);
+        levels = levels ? levels : 1;
+        if (format == SDL_GPU_TEXTUREFORMAT_INVALID || levels > TEXTURE_MAX_LEVELS || width == 0 || height == 0)
+            return 0;
+        if (levels == 1 && !format_is_block_compressed(format))
+            return rgba_chain_size(width, height);
+        size_t total = 0;
+        for (Uint32 i = 0; i < levels; i++)
+            total += SDL_CalculateGPUTextureFormatSize(format, width >> i ? width >> i : 1,
+                                                       height >> i ? height >> i : 1, 1);
+        return total;
+    }
+    int w = 0, h = 0, channels = 0;
+    if (size > SDL_MAX_SINT32 || !stbi_info_from_memory(bytes, (int)size, &w, &h, &channels) || w <= 0 || h <= 0)
+        return 0;
+    return rgba_chain_size((Uint32)w, (Uint32)h);
+}
+
+/*================================================================================
+ * Decode task (worker thread)
+ *================================================================================*/
+static void decode_task(void *userdata)
+{
+    TextureEntry *entry = userdata;
+    bool owned = false;
+    size_t size = 0;
+    bool ok = false;
+    int state = TEXTURE_FAILED;
+
+    /* The chain is reserved before anything is decoded, so the budget also
+       bounds decodes in flight */
+    const Uint8 *bytes = load_image_bytes(entry, &size, &owned);
+    size_t needed = bytes && size > 0 ? decoded_size(bytes, size) : 0;
+    if (bytes && needed == 0)
+        SDL_Log("Texture '%s': unsupported or corrupt image", entry->image->name ? entry->image->name : "(unnamed)");
+    if (needed > 0 && !residency_reserve(RESIDENCY_DECODE, needed))
+    {
+        /* Decode once the pixels waiting for upload drain; with none
+           waiting this texture alone is over the budget */
+        ResidencyStats decoded;
+        residency_stats(RESIDENCY_DECODE, &decoded);
+        if (decoded.used == 0)
+            SDL_Log("Texture '%s': %.1f MB of pixels do not fit the decode budget",
+                    entry->image->name ? entry->image->name : "(unnamed)", (double)needed / (1024.0 * 1024.0));
+        entry->decode_bytes = needed;
+        state = decoded.used > 0 ? TEXTURE_QUEUED : TEXTURE_FAILED;
+    }
+    else if (needed > 0)
+    {
+        entry->decode_bytes = 0;
+        if (is_ktx2(bytes, size))
+        {
+            ok = decode_ktx2(entry, bytes, size);
+        }
+        else if (size <= SDL_MAX_SINT32)
+        {
+            int w = 0, h = 0, channels = 0;
+            Uint8 *rgba = stbi_load_from_memory(bytes, (int)size, &w, &h, &channels, 4);
+            if (rgba)
+                ok = build_rgba_chain(entry, rgba, (Uint32)w, (Uint32)h);
+            else
+                SDL_Log("Texture '%s': %s", entry->image->name ? entry->image->name : "(unnamed)",
+                        stbi_failure_reason());
+        }
+        if (ok && entry->pixels_size > needed)
+        {
+            /* The header promised less than the decoder produced */
+            SDL_free(entry->pixels);
+            entry->pixels = NULL;
+            entry->pixels_size = 0;
+            ok = false;
+        }
+        /* Keep exactly what the pixels hold reserved; free_pixels returns it */
+        residency_release(RESIDENCY_DECODE, needed - (ok ? entry->pixels_size : 0));
+        state = ok ? TEXTURE_DECODED : TEXTURE_FAILED;
+    }
+
+    if (owned)
+        SDL_free((void *)bytes);
+    SDL_SetAtomicInt(&entry->state, state);
+}
+
+static void free_pixels(TextureEntry *entry)
+{
+    if (entry->pixels)
+        residency_release(RESIDENCY_DECODE, entry->pixels_size);
+    SDL_free(entry->pixels);
+    entry->pixels = NULL;
+    entry->pixels_size = 0;
+}
+
+typedef struct DecodeTask
+{
+    TextureStreamer *streamer;
+    TextureEntry *entry;
+} DecodeTask;
+
+/*================================================================================
+ * Public API
+ *================================================================================*/
+TextureStreamer *texture_streamer_create(SDL_GPUDevice *device)
+{
+    TextureStreamer *streamer = SDL_calloc(1, sizeof(TextureStreamer));
+    if (!streamer)
+        return NULL;
+    streamer->device = device;
+
+    SDL_GPUTransferBufferCreateInfo info;
+    SDL_zero(info);
+    info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+    info.size = TEXTURE_STAGING_SIZE;
+    for (int i = 0; i < TEXTURE_STAGING_BUFFERS; i++)
+    {
+        streamer->staging[i] = residency_create_transfer_buffer(device, &info, RESIDENCY_STAGING);
+        if (!streamer->staging[i])
+        {
+            SDL_Log("Failed to create texture staging buffer: %s", SDL_GetError());
+            texture_streamer_destroy(streamer);
+            return NULL;
+        }
+    }
+    return streamer;
+}
+
+void texture_streamer_clear(TextureStreamer *streamer)
+{
+    if (!streamer)
+        return;
+
+    /* Decode tasks write into the entries; let them land first */
+    while (SDL_GetAtomicInt(&streamer->in_flight) > 0)
+        SDL_Delay(1);
+
+    for (size_t i = 0; i < streamer->count; i++)
+    {
+        TextureEntry *entry = &streamer->entries[i];
+        free_pixels(entry);
+        residency_release_texture(streamer->device, entry->texture);
+    }
+    SDL_free(streamer->entries);
+    SDL_free(streamer->base_dir);
+    streamer->entries = NULL;
+    streamer->base_dir = NULL;
+    streamer->count = 0;
+}
+
+void texture_streamer_destroy(TextureStreamer *streamer)
+{
+    if (!streamer)
+        return;
+
+    texture_streamer_clear(streamer);
+    for (int i = 0; i < TEXTURE_STAGING_BUFFERS; i++)
+    {
+        if (streamer->staging[i])
+            residency_release_transfer_buffer(streamer->device, streamer->staging[i]);
+    }
+    SDL_free(streamer);
+}
+
+static bool texture_is_color(const cgltf_data *data, const cgltf_image *image)
+{
+    for (size_t i = 0; i < data->materials_count; i++)
+    {
+        const cgltf_material *mat = &data->materials[i];
+        const cgltf_texture *base = mat->pbr_metallic_roughness.base_color_texture.texture;
+        const cgltf_texture *emissive = mat->emissive_texture.texture;
+        if ((base && base->image == image) || (emissive && emissive->image == image))
+            return true;
+    }
+    return false;
+}
+
+void texture_streamer_load(TextureStreamer *streamer, const Model *model)
+{
+    texture_streamer_clear(streamer);
+    if (!model || model->gltf->images_count == 0)
+        return;
+
+    const cgltf_data *data = model->gltf;
+    streamer->entries = SDL_calloc(data->images_count, sizeof(TextureEntry));
+    if (!streamer->entries)
+        return;
+    streamer->count = data->images_count;
+
+    /* Directory of the model file, for relative image URIs */
+    streamer->base_dir = SDL_strdup(model->path ? model->path : "");
+    if (streamer->base_dir)
+    {
+        char *slash = SDL_strrchr(streamer->base_dir, '/');
+        char *backslash = SDL_strrchr(streamer->base_dir, '\\');
+        if (backslash > slash)
+            slash = backslash;
+        slash ? (void)(slash[1] = '\0') : (void)(streamer->base_dir[0] = '\0');
+    }
+
+    for (size_t i = 0; i < streamer->count; i++)
+    {
+        TextureEntry *entry = &streamer->entries[i];
+        entry->image = &data->images[i];
+        entry->base_dir = streamer->base_dir ? streamer->base_dir : "";
+        entry->srgb = texture_is_color(data, entry->image);
+        SDL_SetAtomicInt(&entry->state, TEXTURE_QUEUED);
+    }
+    streamer->load_start = bench_now();
+    streamer->reported = false;
+}
+
+static void decode_task_main(void *userdata)
+{
+    DecodeTask *task = userdata;
+    TextureStreamer *streamer = task->streamer;
+    decode_task(task->entry);
+    SDL_free(task);
+    SDL_AddAtomicInt(&streamer->in_flight, -1);
+}
+
+static size_t backlog_bytes(const TextureStreamer *streamer)
+{
+    size_t bytes = 0;
+    for (size_t i = 0; i < streamer->count; i++)
+    {
+        int state = SDL_GetAtomicInt(&streamer->entries[i].state);
+        if (state == TEXTURE_DECODED || state == TEXTURE_UPLOADING)
+            bytes += streamer->entries[i].pixels_size;
+    }
+    return bytes;
+}
+
+static void kick_decodes(TextureStreamer *streamer)
+{
+    int max_in_flight = parallel_worker_count() > 0 ? parallel_worker_count() : 1;
+
+    /* Decoded pixels waiting for upload hold back new decodes */
+    ResidencyStats decoded;
+    residency_stats(RESIDENCY_DECODE, &decoded);
+    bool backlog_full = decoded.budget && decoded.used >= decoded.budget;
+
+    for (size_t i = 0; i < streamer->count; i++)
+    {
+        if (SDL_GetAtomicInt(&streamer->in_flight) >= max_in_flight || backlog_full)
+            break;
+
+        TextureEntry *entry = &streamer->entries[i];
+        if (SDL_GetAtomicInt(&entry->state) != TEXTURE_QUEUED)
+            continue;
+        /* Refused before: wait until it fits rather than loading it again */
+        if (entry->decode_bytes && decoded.budget && decoded.used + entry->decode_bytes > decoded.budget)
+            continue;
+
+        DecodeTask *task = SDL_malloc(sizeof(DecodeTask));
+        if (!task)
+            break;
+        task->streamer = streamer;
+        task->entry = entry;
+        SDL_SetAtomicInt(&entry->state, TEXTURE_DECODING);
+        SDL_AddAtomicInt(&streamer->in_flight, 1);
+        parallel_submit(decode_task_main, task);
+    }
+}
+
+static bool create_gpu_texture(TextureStreamer *streamer, TextureEntry *entry)
+{
+    if (!SDL_GPUTextureSupportsFormat(streamer->device, entry->format, SDL_GPU_TEXTURETYPE_2D,
+                                      SDL_GPU_TEXTUREUSAGE_SAMPLER))
+    {
+        SDL_Log("Texture '%s': format %d not supported by this GPU",
+                entry->image->name ? entry->image->name : "(unnamed)", (int)entry->format);
+        return false;
+    }
+
+    /* Over the texture budget, drop the largest levels until it fits */
+    SDL_GPUTextureCreateInfo info;
+    SDL_zero(info);
+    info.type = SDL_GPU_TEXTURETYPE_2D;
+    info.format = entry->format;
+    info.layer_count_or_depth = 1;
+    info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+    for (Uint32 first = 0; first < entry->num_levels && !entry->texture; first++)
+    {
+        info.width = entry->levels[first].width;
+        info.height = entry->levels[first].height;
+        info.num_levels = entry->num_levels - first;
+        entry->texture = residency_create_texture(streamer->device, &info, RESIDENCY_TEXTURES);
+        entry->first_level = first;
+    }
+    if (!entry->texture)
+    {
+        SDL_Log("Failed to create texture: %s", SDL_GetError());
+        return false;
+    }
+    if (entry->first_level > 0)
+    {
+        SDL_Log("Texture '%s': %ux%u, %u levels dropped to fit the budget",
+                entry->image->name ? entry->image->name : "(unnamed)", info.width, info.height, entry->first_level);
+    }
+    entry->upload_level = entry->first_level;
+    return true;
+}
+
+typedef struct PendingUpload
+{
+    SDL_GPUTexture *texture;
+    Uint32 offset;
+    Uint32 level;
+    Uint32 y;
+    Uint32 w;
+    Uint32 h;
+} PendingUpload;
+
+/* Copy the next rows of `entry` into the mapped staging buffer.
+   Returns false when the buffer or the upload list is full. */
+static bool stage_entry(TextureStreamer *streamer, TextureEntry *entry, Uint8 *map, Uint32 *fill,
+                        PendingUpload *uploads, int *num_uploads)
+{
+    Uint32 unit_h = format_is_block_compressed(entry->format) ? 4 : 1;
+
+    while (entry->upload_level < entry->num_levels)
+    {
+        if (*num_uploads >= TEXTURE_MAX_UPLOADS_PER_BUFFER)
+            return false;
+
+        const TextureLevel *level = &entry->levels[entry->upload_level];
+        Uint32 units_total = (level->height + unit_h - 1) / unit_h;
+        size_t unit_bytes = level->size / (units_total ? units_total : 1);
+        if (unit_bytes == 0)
+        {
+            /* Nothing to copy; decode refuses such levels, so only skip it */
+            entry->upload_level++;
+            entry->upload_row = 0;
+            continue;
+        }
+        Uint32 unit_done = entry->upload_row / unit_h;
+        Uint32 units_left = units_total - unit_done;
+
+        Uint32 space = TEXTURE_STAGING_SIZE - *fill;
+        Uint32 units_fit = (Uint32)(space / unit_bytes);
+        if (units_fit == 0)
+            return false;
+        Uint32 units = units_fit < units_left ? units_fit : units_left;
+        size_t bytes = units * unit_bytes;
+
+        SDL_memcpy(map + *fill, entry->pixels + level->offset + unit_done * unit_bytes, bytes);
+
+        Uint32 y = entry->upload_row;
+        Uint32 h = units * unit_h;
+        if (y + h > level->height)
+            h = level->height - y;
+        uploads[(*num_uploads)++] =
+            (PendingUpload){entry->texture, *fill, entry->upload_level - entry->first_level, y, level->width, h};
+
+        *fill += (Uint32)((bytes + 15) & ~(size_t)15);
+        entry->upload_row += units * unit_h;
+        if (entry->upload_row >= level->height)
+        {
+            entry->upload_level++;
+            entry->upload_row = 0;
+        }
+        streamer->last_uploaded += bytes;
+        if (*fill >= TEXTURE_STAGING_SIZE)
+            return entry->upload_level >= entry->num_levels;
+    }
+    return true;
+}
+
+void texture_streamer_pump(TextureStreamer *streamer, SDL_GPUCopyPass *cp)
+{
+    if (!streamer || !cp || streamer->count == 0)
+        return;
+
+    streamer->last_uploaded = 0;
+    kick_decodes(streamer);
+
+    size_t next = 0;
+    for (int b = 0; b < TEXTURE_STAGING_BUFFERS; b++)
+    {
+        /* Find work before mapping so idle frames cost nothing */
+        while (next < streamer->count)
+        {
+            int state = SDL_GetAtomicInt(&streamer->entries[next].state);
+            if (state == TEXTURE_DECODED || state == TEXTURE_UPLOADING)
+                break;
+            next++;
+        }
+        if (next >= streamer->count)
+            break;
+
+        /* cycle=true: if the GPU still reads last frame's copy, SDL hands out a fresh backing buffer */
+        Uint8 *map = SDL_MapGPUTransferBuffer(streamer->device, streamer->staging[b], true);
+        if (!map)
+            break;
+
+        PendingUpload uploads[TEXTURE_MAX_UPLOADS_PER_BUFFER];
+        int num_uploads = 0;
+        Uint32 fill = 0;
+
+        for (; next < streamer->count; next++)
+        {
+            TextureEntry *entry = &streamer->entries[next];
+            int state = SDL_GetAtomicInt(&entry->state);
+            if (state == TEXTURE_DECODED)
+            {
+                if (!create_gpu_texture(streamer, entry))
+                {
+                    free_pixels(entry);
+                    SDL_SetAtomicInt(&entry->state, TEXTURE_FAILED);
+                    continue;
+                }
+                SDL_SetAtomicInt(&entry->state, TEXTURE_UPLOADING);
+            }
+            else if (state != TEXTURE_UPLOADING)
+            {
+                continue;
+            }
+
+            if (!stage_entry(streamer, entry, map, &fill, uploads, &num_uploads))
+                break;
+
+            /* Every byte is in the staging buffer now */
+            free_pixels(entry);
+            SDL_SetAtomicInt(&entry->state, TEXTURE_RESIDENT);
+        }
+
+        SDL_UnmapGPUTransferBuffer(streamer->device, streamer->staging[b]);
+
+        if (num_uploads == 0)
+            continue;
+
+        for (int i = 0; i < num_uploads; i++)
+        {
+            SDL_GPUTextureTransferInfo src;
+            SDL_zero(src);
+            src.transfer_buffer = streamer->staging[b];
+            src.offset = uploads[i].offset;
+
+            SDL_GPUTextureRegion dst;
+            SDL_zero(dst);
+            dst.texture = uploads[i].texture;
+            dst.mip_level = uploads[i].level;
+            dst.y = uploads[i].y;
+            dst.w = uploads[i].w;
+            dst.h = uploads[i].h;
+            dst.d = 1;
+            SDL_UploadToGPUTexture(cp, &src, &dst, false);
+        }
+    }
+
+    if (!streamer->reported)
+    {
+        TextureStreamStats stats;
+        texture_streamer_stats(streamer, &stats);
+        if (stats.resident + stats.failed == stats.total)
+        {
+            SDL_Log("  textures: %zu resident, %zu failed in %.1f ms", stats.resident, stats.failed,
+                    bench_ms_since(streamer->load_start));
+            streamer->reported = true;
+        }
+    }
+}
+
+SDL_GPUTexture *texture_streamer_get(const TextureStreamer *streamer, size_t image_index)
+{
+    if (!streamer || image_index >= streamer->count)
+        return NULL;
+    const TextureEntry *entry = &streamer->entries[image_index];
+    return SDL_GetAtomicInt((SDL_AtomicInt *)&entry->state) == TEXTURE_RESIDENT ? entry->texture : NULL;
+}
+
+void texture_streamer_stats(const TextureStreamer *streamer, TextureStreamStats *out)
+{
+    SDL_zerop(out);
+    if (!streamer)
+        return;
+
+    out->total = streamer->count;
+    for (size_t i = 0; i < streamer->count; i++)
+    {
+        int state = SDL_GetAtomicInt((SDL_AtomicInt *)&streamer->entries[i].state);
+        out->resident += state == TEXTURE_RESIDENT;
+        out->reduced += state == TEXTURE_RESIDENT && streamer->entries[i].first_level > 0;
+        out->failed += state == TEXTURE_FAILED;
+    }
+    out->backlog_bytes = backlog_bytes(streamer);
+    out->uploaded_bytes = streamer->last_uploaded;
+}
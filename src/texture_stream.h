@@ -0,0 +1,43 @@
+#ifndef CUMULUS_TEXTURE_STREAM_H
+#define CUMULUS_TEXTURE_STREAM_H
+
+#include <SDL3/SDL.h>
+
+struct Model;
+
+/* Decodes a model's images (PNG/JPEG, uncompressed or BCn KTX2) on worker
+   threads, builds mip chains on the CPU and streams the levels to GPU
+   textures in bounded chunks through a fixed staging pool. A texture that
+   does not fit the texture budget is created without its largest levels. */
+typedef struct TextureStreamer TextureStreamer;
+
+typedef struct TextureStreamStats
+{
+    size_t total;          /* images known to the streamer */
+    size_t resident;       /* fully uploaded */
+    size_t failed;         /* undecodable or unsupported */
+    size_t reduced;        /* resident without their largest levels, to fit the budget */
+    size_t backlog_bytes;  /* decoded CPU pixels waiting for upload */
+    size_t uploaded_bytes; /* uploaded during the last pump */
+} TextureStreamStats;
+
+TextureStreamer *texture_streamer_create(SDL_GPUDevice *device);
+void texture_streamer_destroy(TextureStreamer *streamer);
+
+/* Queue every image of `model`, replacing any previous set. The model must
+   stay alive until texture_streamer_clear or another load. */
+void texture_streamer_load(TextureStreamer *streamer, const struct Model *model);
+
+/* Wait for in-flight decodes and release every texture */
+void texture_streamer_clear(TextureStreamer *streamer);
+
+/* Kick decodes and record uploads up to the per-frame budget into
+   copy_pass. Call once per frame. */
+void texture_streamer_pump(TextureStreamer *streamer, SDL_GPUCopyPass *copy_pass);
+
+/* GPU texture for glTF image `image_index`, NULL until fully resident */
+SDL_GPUTexture *texture_streamer_get(const TextureStreamer *streamer, size_t image_index);
+
+void texture_streamer_stats(const TextureStreamer *streamer, TextureStreamStats *out);
+
+#endif /* CUMULUS_TEXTURE_STREAM_H */
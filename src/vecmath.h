@@ -0,0 +1,237 @@
+#ifndef CUMULUS_VECMATH_H
+#define CUMULUS_VECMATH_H
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_intrin.h>
+
+/* Column-major 4x4 matrix, same layout as glTF and the GPU. Arrays of Mat4
+   are allocated 16-byte aligned so columns load straight into registers. */
+typedef struct Mat4
+{
+    float m[16];
+} Mat4;
+
+static inline void mat4_identity(Mat4 *out)
+{
+    SDL_zerop(out);
+    out->m[0] = out->m[5] = out->m[10] = out->m[15] = 1.0f;
+}
+
+/* out = a * b. out may alias a or b. */
+static inline void mat4_mul(Mat4 *out, const Mat4 *a, const Mat4 *b)
+{
+#if defined(SDL_SSE2_INTRINSICS)
+    __m128 a0 = _mm_loadu_ps(a->m + 0);
+    __m128 a1 = _mm_loadu_ps(a->m + 4);
+    __m128 a2 = _mm_loadu_ps(a->m + 8);
+    __m128 a3 = _mm_loadu_ps(a->m + 12);
+    __m128 r[4];
+    for (int j = 0; j < 4; j++)
+    {
+        const float *bc = b->m + j * 4;
+        __m128 c = _mm_mul_ps(a0, _mm_set1_ps(bc[0]));
+        c = _mm_add_ps(c, _mm_mul_ps(a1, _mm_set1_ps(bc[1])));
+        c = _mm_add_ps(c, _mm_mul_ps(a2, _mm_set1_ps(bc[2])));
+        c = _mm_add_ps(c, _mm_mul_ps(a3, _mm_set1_ps(bc[3])));
+        r[j] = c;
+    }
+    for (int j = 0; j < 4; j++)
+        _mm_storeu_ps(out->m + j * 4, r[j]);
+#elif defined(SDL_NEON_INTRINSICS)
+    float32x4_t a0 = vld1q_f32(a->m + 0);
+    float32x4_t a1 = vld1q_f32(a->m + 4);
+    float32x4_t a2 = vld1q_f32(a->m + 8);
+    float32x4_t a3 = vld1q_f32(a->m + 12);
+    float32x4_t r[4];
+    for (int j = 0; j < 4; j++)
+    {
+        float32x4_t bc = vld1q_f32(b->m + j * 4);
+        float32x4_t c = vmulq_lane_f32(a0, vget_low_f32(bc), 0);
+        c = vmlaq_lane_f32(c, a1, vget_low_f32(bc), 1);
+        c = vmlaq_lane_f32(c, a2, vget_high_f32(bc), 0);
+        c = vmlaq_lane_f32(c, a3, vget_high_f32(bc), 1);
+        r[j] = c;
+    }
+    for (int j = 0; j < 4; j++)
+        vst1q_f32(out->m + j * 4, r[j]);
+#else
+    Mat4 r;
+    for (int j = 0; j < 4; j++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            r.m[j * 4 + i] = a->m[0 * 4 + i] * b->m[j * 4 + 0] + a->m[1 * 4 + i] * b->m[j * 4 + 1] +
+                             a->m[2 * 4 + i] * b->m[j * 4 + 2] + a->m[3 * 4 + i] * b->m[j * 4 + 3];
+        }
+    }
+    *out = r;
+#endif
+}
+
+/* Local matrix from translation, unit quaternion (x, y, z, w) and scale */
+static inline void mat4_from_trs(Mat4 *out, const float t[3], const float q[4], const float s[3])
+{
+    float x = q[0], y = q[1], z = q[2], w = q[3];
+    float xx = x * x, yy = y * y, zz = z * z;
+    float xy = x * y, xz = x * z, yz = y * z;
+    float wx = w * x, wy = w * y, wz = w * z;
+
+    out->m[0] = (1.0f - 2.0f * (yy + zz)) * s[0];
+    out->m[1] = (2.0f * (xy + wz)) * s[0];
+    out->m[2] = (2.0f * (xz - wy)) * s[0];
+    out->m[3] = 0.0f;
+
+    out->m[4] = (2.0f * (xy - wz)) * s[1];
+    out->m[5] = (1.0f - 2.0f * (xx + zz)) * s[1];
+    out->m[6] = (2.0f * (yz + wx)) * s[1];
+    out->m[7] = 0.0f;
+
+    out->m[8] = (2.0f * (xz + wy)) * s[2];
+    out->m[9] = (2.0f * (yz - wx)) * s[2];
+    out->m[10] = (1.0f - 2.0f * (xx + yy)) * s[2];
+    out->m[11] = 0.0f;
+
+    out->m[12] = t[0];
+    out->m[13] = t[1];
+    out->m[14] = t[2];
+    out->m[15] = 1.0f;
+}
+
+/* Transform point (x, y, z, 1); w is assumed to stay 1 (affine matrices) */
+static inline void mat4_transform_point(const Mat4 *m, const float p[3], float out[3])
+{
+    for (int i = 0; i < 3; i++)
+        out[i] = m->m[i] * p[0] + m->m[4 + i] * p[1] + m->m[8 + i] * p[2] + m->m[12 + i];
+}
+
+/* Transform direction (x, y, z, 0) */
+static inline void mat4_transform_vector(const Mat4 *m, const float v[3], float out[3])
+{
+    for (int i = 0; i < 3; i++)
+        out[i] = m->m[i] * v[0] + m->m[4 + i] * v[1] + m->m[8 + i] * v[2];
+}
+
+/* General inverse by cofactors. Returns false, leaving out untouched, when
+   m is singular. out may alias m. */
+static inline bool mat4_invert(Mat4 *out, const Mat4 *m)
+{
+    const float *a = m->m;
+    float r[16];
+    r[0] = a[5] * a[10] * a[15] - a[5] * a[11] * a[14] - a[9] * a[6] * a[15] + a[9] * a[7] * a[14] +
+           a[13] * a[6] * a[11] - a[13] * a[7] * a[10];
+    r[4] = -a[4] * a[10] * a[15] + a[4] * a[11] * a[14] + a[8] * a[6] * a[15] - a[8] * a[7] * a[14] -
+           a[12] * a[6] * a[11] + a[12] * a[7] * a[10];
+    r[8] = a[4] * a[9] * a[15] - a[4] * a[11] * a[13] - a[8] * a[5] * a[15] + a[8] * a[7] * a[13] +
+           a[12] * a[5] * a[11] - a[12] * a[7] * a[9];
+    r[12] = -a[4] * a[9] * a[14] + a[4] * a[10] * a[13] + a[8] * a[5] * a[14] - a[8] * a[6] * a[13] -
+            a[12] * a[5] * a[10] + a[12] * a[6] * a[9];
+    r[1] = -a[1] * a[10] * a[15] + a[1] * a[11] * a[14] + a[9] * a[2] * a[15] - a[9] * a[3] * a[14] -
+           a[13] * a[2] * a[11] + a[13] * a[3] * a[10];
+    r[5] = a[0] * a[10] * a[15] - a[0] * a[11] * a[14] - a[8] * a[2] * a[15] + a[8] * a[3] * a[14] +
+           a[12] * a[2] * a[11] - a[12] * a[3] * a[10];
+    r[9] = -a[0] * a[9] * a[15] + a[0] * a[11] * a[13] + a[8] * a[1] * a[15] - a[8] * a[3] * a[13] -
+           a[12] * a[1] * a[11] + a[12] * a[3] * a[9];
+    r[13] = a[0] * a[9] * a[14] - a[0] * a[10] * a[13] - a[8] * a[1] * a[14] + a[8] * a[2] * a[13] +
+            a[12] * a[1] * a[10] - a[12] * a[2] * a[9];
+    r[2] = a[1] * a[6] * a[15] - a[1] * a[7] * a[14] - a[5] * a[2] * a[15] + a[5] * a[3] * a[14] +
+           a[13] * a[2] * a[7] - a[13] * a[3] * a[6];
+    r[6] = -a[0] * a[6] * a[15] + a[0] * a[7] * a[14] + a[4] * a[2] * a[15] - a[4] * a[3] * a[14] -
+           a[12] * a[2] * a[7] + a[12] * a[3] * a[6];
+    r[10] = a[0] * a[5] * a[15] - a[0] * a[7] * a[13] - a[4] * a[1] * a[15] + a[4] * a[3] * a[13] +
+            a[12] * a[1] * a[7] - a[12] * a[3] * a[5];
+    r[14] = -a[0] * a[5] * a[14] + a[0] * a[6] * a[13] + a[4] * a[1] * a[14] - a[4] * a[2] * a[13] -
+            a[12] * a[1] * a[6] + a[12] * a[2] * a[5];
+    r[3] = -a[1] * a[6] * a[11] + a[1] * a[7] * a[10] + a[5] * a[2] * a[11] - a[5] * a[3] * a[10] -
+           a[9] * a[2] * a[7] + a[9] * a[3] * a[6];
+    r[7] = a[0] * a[6] * a[11] - a[0] * a[7] * a[10] - a[4] * a[2] * a[11] + a[4] * a[3] * a[10] +
+           a[8] * a[2] * a[7] - a[8] * a[3] * a[6];
+    r[11] = -a[0] * a[5] * a[11] + a[0] * a[7] * a[9] + a[4] * a[1] * a[11] - a[4] * a[3] * a[9] -
+            a[8] * a[1] * a[7] + a[8] * a[3] * a[5];
+    r[15] = a[0] * a[5] * a[10] - a[0] * a[6] * a[9] - a[4] * a[1] * a[10] + a[4] * a[2] * a[9] +
+            a[8] * a[1] * a[6] - a[8] * a[2] * a[5];
+
+    float det = a[0] * r[0] + a[1] * r[4] + a[2] * r[8] + a[3] * r[12];
+    if (det == 0.0f)
+        return false;
+    float inv = 1.0f / det;
+    for (int i = 0; i < 16; i++)
+        out->m[i] = r[i] * inv;
+    return true;
+}
+
+/* Right-handed perspective with the 0..1 clip depth range SDL_gpu uses */
+static inline void mat4_perspective(Mat4 *out, float fovy, float aspect, float znear, float zfar)
+{
+    float f = 1.0f / SDL_tanf(fovy * 0.5f);
+    SDL_zerop(out);
+    out->m[0] = f / aspect;
+    out->m[5] = f;
+    out->m[10] = zfar / (znear - zfar);
+    out->m[11] = -1.0f;
+    out->m[14] = znear * zfar / (znear - zfar);
+}
+
+static inline void mat4_look_at(Mat4 *out, const float eye[3], const float target[3], const float up[3])
+{
+    float f[3] = {target[0] - eye[0], target[1] - eye[1], target[2] - eye[2]};
+    float fl = SDL_sqrtf(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+    f[0] /= fl, f[1] /= fl, f[2] /= fl;
+
+    float s[3] = {f[1] * up[2] - f[2] * up[1], f[2] * up[0] - f[0] * up[2], f[0] * up[1] - f[1] * up[0]};
+    float sl = SDL_sqrtf(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+    s[0] /= sl, s[1] /= sl, s[2] /= sl;
+
+    float u[3] = {s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0]};
+
+    mat4_identity(out);
+    out->m[0] = s[0], out->m[4] = s[1], out->m[8] = s[2];
+    out->m[1] = u[0], out->m[5] = u[1], out->m[9] = u[2];
+    out->m[2] = -f[0], out->m[6] = -f[1], out->m[10] = -f[2];
+    out->m[12] = -(s[0] * eye[0] + s[1] * eye[1] + s[2] * eye[2]);
+    out->m[13] = -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]);
+    out->m[14] = f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2];
+}
+
+/* World-space AABB of a local AABB under an affine matrix (Arvo's method) */
+static inline void mat4_transform_aabb(const Mat4 *m, const float lmin[3], const float lmax[3], float out_min[3],
+                                       float out_max[3])
+{
+    for (int i = 0; i < 3; i++)
+    {
+        float lo = m->m[12 + i], hi = m->m[12 + i];
+        for (int j = 0; j < 3; j++)
+        {
+            float a = m->m[j * 4 + i] * lmin[j];
+            float b = m->m[j * 4 + i] * lmax[j];
+            lo += a < b ? a : b;
+            hi += a < b ? b : a;
+        }
+        out_min[i] = lo;
+        out_max[i] = hi;
+    }
+}
+
+/* Normalized planes (a, b, c, d) with ax + by + cz + d >= 0 inside, in the
+   order left, right, bottom, top, near, far. Assumes 0..1 clip depth. */
+static inline void mat4_frustum_planes(const Mat4 *vp, float planes[6][4])
+{
+    for (int c = 0; c < 4; c++)
+    {
+        float r0 = vp->m[c * 4 + 0], r1 = vp->m[c * 4 + 1], r2 = vp->m[c * 4 + 2], r3 = vp->m[c * 4 + 3];
+        planes[0][c] = r3 + r0;
+        planes[1][c] = r3 - r0;
+        planes[2][c] = r3 + r1;
+        planes[3][c] = r3 - r1;
+        planes[4][c] = r2;
+        planes[5][c] = r3 - r2;
+    }
+    for (int p = 0; p < 6; p++)
+    {
+        float len = SDL_sqrtf(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+        float inv = len > 0.0f ? 1.0f / len : 0.0f;
+        for (int c = 0; c < 4; c++)
+            planes[p][c] *= inv;
+    }
+}
+
+#endif /* CUMULUS_VECMATH_H */
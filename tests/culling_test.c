@@ -0,0 +1,371 @@
+/* culling_test: the CPU culling checks, run by ctest without a window or
+   GPU device. Exits nonzero when a case fails. */
+
+/* scene_graph.c unpacks accessors through cgltf, whose implementation
+   lives in model_import.c, which the test does not link */
+#define CGLTF_IMPLEMENTATION
+
+#include "occlusion.h"
+#include "parallel.h"
+#include "scene_bvh.h"
+#include "scene_graph.h"
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+#include <cgltf.h>
+
+/*================================================================================
+ * BVH frustum culling
+ *================================================================================*/
+#define CITY_GRID 64
+#define CITY_SPACING 12.0f
+#define CITY_BUILDINGS (CITY_GRID * CITY_GRID)
+
+/* Reference: one world box against the six planes, no hierarchy. Returns
+   1 inside or crossing, 0 outside, -1 too close to a plane to tell apart
+   from rounding. */
+static int box_in_frustum(const float planes[6][4], const float *b)
+{
+    int result = 1;
+    for (int p = 0; p < 6; p++)
+    {
+        float dist = 0.0f, rad = 0.0f;
+        for (int k = 0; k < 3; k++)
+        {
+            dist += planes[p][k] * (b[k] + b[k + 3]) * 0.5f;
+            rad += SDL_fabsf(planes[p][k]) * (b[k + 3] - b[k]) * 0.5f;
+        }
+        float outer = dist + planes[p][3] + rad;
+        if (SDL_fabsf(outer) < 1e-3f * (1.0f + rad))
+            result = -1;
+        else if (outer < 0.0f)
+            return 0;
+    }
+    return result;
+}
+
+/* A street-level camera turning in a city grid with 1% of the buildings
+   moving every frame: after each refit and cull, every item must be
+   marked visible exactly when it intersects the frustum */
+static bool test_bvh_matches_brute_force(void)
+{
+    Sint32 parent[CITY_BUILDINGS + 1];
+    Uint32 item_node[CITY_BUILDINGS], item_prim[CITY_BUILDINGS];
+    static float bounds[CITY_BUILDINGS * 6];
+    parent[0] = -1;
+    for (Uint32 i = 0; i < CITY_BUILDINGS; i++)
+    {
+        parent[i + 1] = 0;
+        item_node[i] = i + 1;
+        item_prim[i] = 0;
+        float *b = &bounds[i * 6];
+        b[0] = -0.5f, b[1] = 0.0f, b[2] = -0.5f;
+        b[3] = 0.5f, b[4] = 1.0f, b[5] = 0.5f;
+    }
+    SceneGraph *graph = scene_graph_create(CITY_BUILDINGS + 1, parent);
+    if (!graph)
+    {
+        return false;
+    }
+    Uint64 seed = 42;
+    for (Uint32 i = 0; i < CITY_BUILDINGS; i++)
+    {
+        float t[3] = {((float)(i % CITY_GRID) - CITY_GRID * 0.5f) * CITY_SPACING, 0.0f,
+                      ((float)(i / CITY_GRID) - CITY_GRID * 0.5f) * CITY_SPACING};
+        float w = 4.0f + (float)SDL_rand_r(&seed, 5);
+        float s[3] = {w, 5.0f + (float)SDL_rand_r(&seed, 60), w};
+        scene_graph_set_trs(graph, i + 1, t, NULL, s);
+    }
+    scene_graph_update(graph);
+    SceneBvh *bvh = scene_bvh_create(graph, CITY_BUILDINGS, item_node, item_prim, bounds);
+    if (!bvh)
+    {
+        scene_graph_free(graph);
+        return false;
+    }
+
+    Mat4 proj, view, vp;
+    mat4_perspective(&proj, 60.0f * SDL_PI_F / 180.0f, 16.0f / 9.0f, 0.5f, 400.0f);
+    const float up[3] = {0.0f, 1.0f, 0.0f};
+    const int frames = 60;
+    Uint32 wrong = 0, checked = 0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        for (Uint32 k = 0; k < CITY_BUILDINGS / 100; k++)
+        {
+            Uint32 node = 1 + (Uint32)SDL_rand_r(&seed, CITY_BUILDINGS);
+            const float *t = &graph->translation[node * 3];
+            float moved[3] = {t[0] + 0.5f, t[1], t[2]};
+            scene_graph_set_trs(graph, node, moved, NULL, NULL);
+        }
+        scene_graph_update(graph);
+        scene_bvh_refit(bvh, graph);
+
+        float yaw = (float)frame * (2.0f * SDL_PI_F / frames);
+        float eye[3] = {0.0f, 2.0f, 0.0f};
+        float target[3] = {SDL_cosf(yaw), 2.0f, SDL_sinf(yaw)};
+        mat4_look_at(&view, eye, target, up);
+        mat4_mul(&vp, &proj, &view);
+        size_t visible = scene_bvh_cull(bvh, &vp);
+
+        float planes[6][4];
+        mat4_frustum_planes(&vp, planes);
+        size_t marked = 0;
+        for (Uint32 i = 0; i < CITY_BUILDINGS; i++)
+        {
+            float world[6];
+            mat4_transform_aabb(&graph->world[item_node[i]], &bounds[i * 6], &bounds[i * 6 + 3], world, world + 3);
+            marked += bvh->visible[i] != 0;
+            int expected = box_in_frustum(planes, world);
+            if (expected >= 0)
+            {
+                checked++;
+                wrong += (bvh->visible[i] != 0) != (expected == 1);
+            }
+        }
+        if (marked != visible)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Frame %d: %zu items marked visible, cull returned %zu",
+                         frame, marked, visible);
+            wrong++;
+        }
+    }
+    if (wrong > 0)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%u of %u item tests disagree with the brute-force reference",
+                     wrong, checked);
+    }
+    scene_bvh_free(bvh);
+    scene_graph_free(graph);
+    return wrong == 0 && checked > 0;
+}
+
+/*================================================================================
+ * Occlusion
+ *================================================================================*/
+#define ROOMS 8 /* per side */
+#define ROOM_SIZE 10.0f
+#define ROOM_PROPS 12
+#define ROOM_WALLS (2 * ROOMS * (ROOMS + 1))
+#define ROOM_ITEMS (ROOM_WALLS + ROOMS * ROOMS * ROOM_PROPS)
+#define HOME_ROOM ((ROOMS / 2) * ROOMS + ROOMS / 2)
+
+/* Unit box standing on the ground, 12 triangles */
+static const float box_x[8] = {-0.5f, 0.5f, -0.5f, 0.5f, -0.5f, 0.5f, -0.5f, 0.5f};
+static const float box_y[8] = {0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f};
+static const float box_z[8] = {-0.5f, -0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 0.5f, 0.5f};
+static const Uint32 box_indices[36] = {0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+                                       2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5};
+
+/* A floor of closed rooms: the walls come first as items and occluders,
+   then every room's props */
+typedef struct RoomScene
+{
+    SceneGraph *graph;
+    SceneBvh *bvh;
+    OcclusionCuller *culler;
+    Uint32 prop_room[ROOM_ITEMS]; /* SDL_MAX_UINT32 for walls */
+} RoomScene;
+
+static void free_rooms(RoomScene *scene)
+{
+    occlusion_destroy(scene->culler);
+    scene_bvh_free(scene->bvh);
+    scene_graph_free(scene->graph);
+    SDL_free(scene);
+}
+
+static RoomScene *build_rooms(void)
+{
+    static Sint32 parent[ROOM_ITEMS + 1];
+    static Uint32 item_node[ROOM_ITEMS], item_prim[ROOM_ITEMS];
+    static float bounds[ROOM_ITEMS * 6];
+    static OcclusionMesh meshes[ROOM_WALLS];
+    RoomScene *scene = SDL_calloc(1, sizeof(RoomScene));
+    if (!scene)
+    {
+        return NULL;
+    }
+    parent[0] = -1;
+    for (Uint32 i = 0; i < ROOM_ITEMS; i++)
+    {
+        parent[i + 1] = 0;
+        item_node[i] = i + 1;
+        item_prim[i] = 0;
+        float *b = &bounds[i * 6];
+        b[0] = -0.5f, b[1] = 0.0f, b[2] = -0.5f;
+        b[3] = 0.5f, b[4] = 1.0f, b[5] = 0.5f;
+    }
+    scene->graph = scene_graph_create(ROOM_ITEMS + 1, parent);
+    if (!scene->graph)
+    {
+        free_rooms(scene);
+        return NULL;
+    }
+
+    /* Each room's south and west walls, and the grid's far edges */
+    const float half = ROOMS * ROOM_SIZE * 0.5f;
+    Uint32 item = 0;
+    for (Uint32 i = 0; i < ROOMS + 1; i++)
+    {
+        for (Uint32 j = 0; j < ROOMS; j++)
+        {
+            float along = ((float)j + 0.5f) * ROOM_SIZE - half, at = (float)i * ROOM_SIZE - half;
+            float tx[3] = {along, 0.0f, at}, sx[3] = {ROOM_SIZE + 0.2f, 3.0f, 0.2f};
+            float tz[3] = {at, 0.0f, along}, sz[3] = {0.2f, 3.0f, ROOM_SIZE + 0.2f};
+            for (int k = 0; k < 2; k++, item++)
+            {
+                scene_graph_set_trs(scene->graph, item_node[item], k ? tz : tx, NULL, k ? sz : sx);
+                meshes[item] = (OcclusionMesh){{box_x, box_y, box_z}, 8, box_indices, 36, item_node[item]};
+                scene->prop_room[item] = SDL_MAX_UINT32;
+            }
+        }
+    }
+    Uint64 seed = 7;
+    for (; item < ROOM_ITEMS; item++)
+    {
+        Uint32 room = (item - ROOM_WALLS) / ROOM_PROPS;
+        float x0 = (float)(room % ROOMS) * ROOM_SIZE - half, z0 = (float)(room / ROOMS) * ROOM_SIZE - half;
+        float t[3] = {x0 + 1.5f + (float)SDL_rand_r(&seed, 70) * 0.1f, 0.0f,
+                      z0 + 1.5f + (float)SDL_rand_r(&seed, 70) * 0.1f};
+        float s[3] = {0.5f + (float)SDL_rand_r(&seed, 10) * 0.1f, 0.5f + (float)SDL_rand_r(&seed, 15) * 0.1f,
+                      0.5f + (float)SDL_rand_r(&seed, 10) * 0.1f};
+        scene_graph_set_trs(scene->graph, item_node[item], t, NULL, s);
+        scene->prop_room[item] = room;
+    }
+    scene_graph_update(scene->graph);
+
+    scene->bvh = scene_bvh_create(scene->graph, ROOM_ITEMS, item_node, item_prim, bounds);
+    scene->culler = occlusion_create(OCCLUSION_DEFAULT_WIDTH, OCCLUSION_DEFAULT_HEIGHT);
+    if (!scene->bvh || !scene->culler || !occlusion_set_occluders(scene->culler, meshes, ROOM_WALLS))
+    {
+        free_rooms(scene);
+        return NULL;
+    }
+    return scene;
+}
+
+/* Turning in place in the home room: frustum-visible props there and
+   elsewhere, and how many of each survived occlusion */
+typedef struct RoomTally
+{
+    Uint32 home_visible, home_culled;
+    Uint32 away_visible, away_culled;
+} RoomTally;
+
+static bool turn_in_home_room(RoomTally *tally)
+{
+    RoomScene *scene = build_rooms();
+    if (!scene)
+    {
+        return false;
+    }
+    SDL_zerop(tally);
+    const float half = ROOMS * ROOM_SIZE * 0.5f;
+    const float hx = (float)(HOME_ROOM % ROOMS) * ROOM_SIZE - half + ROOM_SIZE * 0.5f;
+    const float hz = (float)(HOME_ROOM / ROOMS) * ROOM_SIZE - half + ROOM_SIZE * 0.5f;
+    const float up[3] = {0.0f, 1.0f, 0.0f};
+    static Uint8 frustum[ROOM_ITEMS];
+    Mat4 proj, view, vp;
+    mat4_perspective(&proj, 60.0f * SDL_PI_F / 180.0f, 16.0f / 9.0f, 0.1f, 500.0f);
+    const int frames = 36;
+    for (int f = 0; f < frames; f++)
+    {
+        float angle = (float)f / (float)frames * 2.0f * SDL_PI_F;
+        float eye[3] = {hx, 1.7f, hz};
+        float target[3] = {hx + SDL_cosf(angle), 1.2f, hz + SDL_sinf(angle)};
+        mat4_look_at(&view, eye, target, up);
+        mat4_mul(&vp, &proj, &view);
+
+        scene_bvh_cull(scene->bvh, &vp);
+        SDL_memcpy(frustum, scene->bvh->visible, ROOM_ITEMS);
+        occlusion_cull(scene->culler, scene->bvh, scene->graph, &vp);
+        for (Uint32 i = ROOM_WALLS; i < ROOM_ITEMS; i++)
+        {
+            if (!frustum[i])
+            {
+                continue;
+            }
+            bool culled = !scene->bvh->visible[i];
+            if (scene->prop_room[i] == HOME_ROOM)
+            {
+                tally->home_visible++;
+                tally->home_culled += culled;
+            }
+            else
+            {
+                tally->away_visible++;
+                tally->away_culled += culled;
+            }
+        }
+    }
+    free_rooms(scene);
+    return true;
+}
+
+/* Occluders may only under-occlude: nothing in the camera's room hides */
+static bool test_home_room_stays_visible(void)
+{
+    RoomTally tally;
+    if (!turn_in_home_room(&tally))
+    {
+        return false;
+    }
+    if (tally.home_culled > 0 || tally.home_visible == 0)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%u of %u props in the camera's room culled", tally.home_culled,
+                     tally.home_visible);
+        return false;
+    }
+    return true;
+}
+
+/* The walls are closed and taller than every prop, so the frustum-visible
+   props of other rooms are nearly all hidden */
+static bool test_walls_hide_other_rooms(void)
+{
+    RoomTally tally;
+    if (!turn_in_home_room(&tally))
+    {
+        return false;
+    }
+    if (tally.away_visible == 0 || tally.away_culled < tally.away_visible * 9 / 10)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Only %u of %u props behind the walls culled", tally.away_culled,
+                     tally.away_visible);
+        return false;
+    }
+    return true;
+}
+
+/*================================================================================
+ * Runner
+ *================================================================================*/
+typedef struct TestCase
+{
+    const char *name;
+    bool (*run)(void);
+} TestCase;
+
+static const TestCase CASES[] = {
+    {"bvh matches brute force", test_bvh_matches_brute_force},
+    {"home room stays visible", test_home_room_stays_visible},
+    {"walls hide other rooms", test_walls_hide_other_rooms},
+};
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+    parallel_init(0);
+    bool ok = true;
+    for (size_t i = 0; i < SDL_arraysize(CASES); i++)
+    {
+        bool passed = CASES[i].run();
+        SDL_Log("culling_test: %s: %s", CASES[i].name, passed ? "passed" : "FAILED");
+        ok = ok && passed;
+    }
+    parallel_shutdown();
+    SDL_Log("culling_test: %s", ok ? "passed" : "FAILED");
+    return ok ? 0 : 1;
+}
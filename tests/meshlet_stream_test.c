@@ -0,0 +1,187 @@
+/* meshlet_stream_test: cooks a terrain four times larger than its memory
+   cap and streams it on the CPU, without a GPU device. Exits nonzero when
+   a case fails. */
+
+/* The engine's cgltf implementation lives in model_import.c, which the
+   test does not link */
+#define CGLTF_IMPLEMENTATION
+
+#include "meshlet_stream.h"
+#include "parallel.h"
+#include "residency.h"
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+#include <cgltf.h>
+
+#define TEST_MEMORY_CAP (8u * 1024u * 1024u)
+#define TEST_WAYPOINTS 16
+#define TEST_FLIGHT 240
+
+/* Low over the terrain, looking ahead and down, corner to corner as t
+   goes from 0 to 1 */
+static void camera_at(const MeshletStream *s, float t, Mat4 *view_proj, float eye[3])
+{
+    float min[3], max[3];
+    meshlet_stream_bounds(s, min, max);
+    Mat4 proj, view;
+    mat4_perspective(&proj, 60.0f * SDL_PI_F / 180.0f, 16.0f / 9.0f, 0.5f, 300.0f);
+    eye[0] = max[0] * (0.1f + 0.8f * t);
+    eye[1] = 40.0f;
+    eye[2] = max[2] * (0.1f + 0.8f * t);
+    const float target[3] = {eye[0] + 60.0f, 0.0f, eye[2] + 60.0f};
+    const float up[3] = {0.0f, 1.0f, 0.0f};
+    mat4_look_at(&view, eye, target, up);
+    mat4_mul(view_proj, &proj, &view);
+}
+
+static float pixel_scale(void)
+{
+    return 1080.0f / (2.0f * SDL_tanf(30.0f * SDL_PI_F / 180.0f));
+}
+
+/* Waiting for every read at each waypoint, the pool ends up holding every
+   visible cluster, unless the view wants more pages than there are slots */
+static bool test_waypoints_settle(MeshletStream *s)
+{
+    Uint32 incomplete = 0, settled = 0;
+    for (int i = 0; i < TEST_WAYPOINTS; i++)
+    {
+        Mat4 vp;
+        float eye[3];
+        camera_at(s, (float)i / (TEST_WAYPOINTS - 1), &vp, eye);
+        MeshletStreamStats stats;
+        Uint32 n = 0;
+        do
+        {
+            meshlet_stream_update(s, &vp, eye, pixel_scale());
+            meshlet_stream_wait(s);
+            meshlet_stream_stats(s, &stats);
+        } while (stats.waiting > 0 && !stats.starved && ++n < 1000);
+
+        if (stats.starved)
+        {
+            continue;
+        }
+        if (stats.waiting == 0 && stats.drawn == stats.visible)
+        {
+            settled++;
+        }
+        else
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Waypoint %d: %u of %u visible clusters drawn, %u waiting", i,
+                         stats.drawn, stats.visible, stats.waiting);
+            incomplete++;
+        }
+    }
+    return incomplete == 0 && settled > 0;
+}
+
+/* In flight, without waiting for reads, every drawn cluster's vertices lie
+   in its own bounding sphere and its indices in its own vertices, so a
+   page landing in the wrong slot is caught */
+static bool test_drawn_clusters_hold_their_data(MeshletStream *s)
+{
+    Uint32 wrong = 0, drawn = 0;
+    for (int i = 0; i < TEST_FLIGHT; i++)
+    {
+        Mat4 vp;
+        float eye[3];
+        camera_at(s, (float)i / (TEST_FLIGHT - 1), &vp, eye);
+        meshlet_stream_update(s, &vp, eye, pixel_scale());
+
+        MeshletDrawnCluster c;
+        for (Uint32 k = 0; meshlet_stream_drawn_cluster(s, k, &c); k++, drawn++)
+        {
+            bool ok = true;
+            for (Uint32 v = 0; v < c.vertex_count; v++)
+            {
+                const float *p = c.vertices[v].position;
+                float d[3] = {p[0] - c.center[0], p[1] - c.center[1], p[2] - c.center[2]};
+                ok = ok && SDL_sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) <= c.radius * 1.001f + 1e-3f;
+            }
+            for (Uint32 n = 0; n < c.index_count; n++)
+            {
+                ok = ok && c.indices[n] < c.vertex_count;
+            }
+            wrong += !ok;
+        }
+    }
+    meshlet_stream_wait(s);
+    if (wrong > 0)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%u of %u drawn clusters carry another cluster's data", wrong,
+                     drawn);
+    }
+    return wrong == 0 && drawn > 0;
+}
+
+/* After both flights: the stream never spent more than its cap on a file
+   four times that size */
+static bool test_memory_cap(MeshletStream *s)
+{
+    MeshletStreamStats stats;
+    meshlet_stream_stats(s, &stats);
+    bool ok = stats.memory_bytes <= TEST_MEMORY_CAP && stats.file_bytes >= TEST_MEMORY_CAP * 4 &&
+              stats.resident <= stats.slots;
+    if (!ok)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "%zu bytes used of a %u byte cap for %zu bytes of pages, %u pages resident in %u slots",
+                     stats.memory_bytes, TEST_MEMORY_CAP, stats.file_bytes, stats.resident, stats.slots);
+    }
+    return ok;
+}
+
+typedef struct TestCase
+{
+    const char *name;
+    bool (*run)(MeshletStream *s);
+} TestCase;
+
+/* In order: each case streams on from where the previous one left off */
+static const TestCase CASES[] = {
+    {"waypoints settle", test_waypoints_settle},
+    {"drawn clusters hold their data", test_drawn_clusters_hold_their_data},
+    {"memory cap", test_memory_cap},
+};
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+    residency_init();
+    parallel_init(0);
+
+    bool ok = false;
+    char *dir = SDL_GetPrefPath("arda", "cumulus");
+    char *path = NULL;
+    if (dir && SDL_asprintf(&path, "%stest.meshlets", dir) >= 0)
+    {
+        MeshletStream *s =
+            meshlet_cook_terrain(path, TEST_MEMORY_CAP * 4) ? meshlet_stream_open(NULL, path, TEST_MEMORY_CAP) : NULL;
+        if (s)
+        {
+            ok = true;
+            for (size_t i = 0; i < SDL_arraysize(CASES); i++)
+            {
+                bool passed = CASES[i].run(s);
+                SDL_Log("meshlet_stream_test: %s: %s", CASES[i].name, passed ? "passed" : "FAILED");
+                ok = ok && passed;
+            }
+            meshlet_stream_close(s);
+        }
+        else
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Could not cook or open '%s'", path);
+        }
+        SDL_RemovePath(path);
+    }
+    SDL_free(path);
+    SDL_free(dir);
+
+    parallel_shutdown();
+    residency_shutdown();
+    SDL_Log("meshlet_stream_test: %s", ok ? "passed" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,245 @@
+/* render_graph_test: compiles a deferred frame without a GPU device and
+   checks its pass order and memory aliasing. Exits nonzero when a case
+   fails. */
+
+#include "render_graph.h"
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+
+#define FRAME_WIDTH 1920
+#define FRAME_HEIGHT 1080
+#define RGBA8 SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM
+#define RGBA16F SDL_GPU_TEXTUREFORMAT_R16G16B16A16_FLOAT
+#define D32 SDL_GPU_TEXTUREFORMAT_D32_FLOAT
+#define COLOR (SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COLOR_TARGET)
+#define DEPTH (SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET)
+#define STORAGE (SDL_GPU_TEXTUREUSAGE_SAMPLER | SDL_GPU_TEXTUREUSAGE_COMPUTE_STORAGE_WRITE)
+
+static RenderGraphResource texture(RenderGraph *g, const char *name, SDL_GPUTextureFormat format, Uint32 w, Uint32 h,
+                                   SDL_GPUTextureUsageFlags usage)
+{
+    SDL_GPUTextureCreateInfo info;
+    SDL_zero(info);
+    info.type = SDL_GPU_TEXTURETYPE_2D;
+    info.format = format;
+    info.usage = usage;
+    info.width = w;
+    info.height = h;
+    info.layer_count_or_depth = 1;
+    info.num_levels = 1;
+    return render_graph_create_texture(g, name, &info);
+}
+
+/* Shadows, SSAO, bloom and uploads, declared out of order the way
+   independent subsystems would, plus an overlay nobody reads */
+static void build_frame(RenderGraph *g)
+{
+    const Uint32 w = FRAME_WIDTH, h = FRAME_HEIGHT;
+    const SDL_FColor black = {0, 0, 0, 1};
+
+    render_graph_begin(g);
+    RenderGraphResource backbuffer = render_graph_import_texture(g, "backbuffer", NULL);
+    RenderGraphResource transforms = render_graph_import_buffer(g, "transforms", NULL);
+    RenderGraphResource lights = render_graph_import_buffer(g, "lights", NULL);
+    RenderGraphResource readback = render_graph_import_buffer(g, "depth readback", NULL);
+    RenderGraphResource shadow = texture(g, "shadow map", D32, 2048, 2048, DEPTH);
+    RenderGraphResource albedo = texture(g, "gbuffer albedo", RGBA8, w, h, COLOR);
+    RenderGraphResource normal = texture(g, "gbuffer normal", RGBA16F, w, h, COLOR);
+    RenderGraphResource depth = texture(g, "gbuffer depth", D32, w, h, DEPTH);
+    RenderGraphResource ao = texture(g, "ssao", SDL_GPU_TEXTUREFORMAT_R8_UNORM, w, h, STORAGE);
+    RenderGraphResource ao_blur = texture(g, "ssao blurred", SDL_GPU_TEXTUREFORMAT_R8_UNORM, w, h, STORAGE);
+    RenderGraphResource hdr = texture(g, "hdr", RGBA16F, w, h, COLOR);
+    RenderGraphResource down2 = texture(g, "bloom down 1/2", RGBA16F, w / 2, h / 2, COLOR);
+    RenderGraphResource down4 = texture(g, "bloom down 1/4", RGBA16F, w / 4, h / 4, COLOR);
+    RenderGraphResource down8 = texture(g, "bloom down 1/8", RGBA16F, w / 8, h / 8, COLOR);
+    RenderGraphResource up4 = texture(g, "bloom up 1/4", RGBA16F, w / 4, h / 4, COLOR);
+    RenderGraphResource up2 = texture(g, "bloom up 1/2", RGBA16F, w / 2, h / 2, COLOR);
+    RenderGraphResource ldr = texture(g, "ldr", RGBA8, w, h, COLOR);
+    RenderGraphResource overlay = texture(g, "debug overlay", RGBA8, w, h, COLOR);
+
+    Uint32 p = render_graph_add_pass(g, "upload transforms", RENDER_GRAPH_COPY, NULL, NULL);
+    render_graph_write(g, p, transforms);
+    p = render_graph_add_pass(g, "shadow", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, transforms);
+    render_graph_depth_target(g, p, shadow, SDL_GPU_LOADOP_CLEAR, 1.0f);
+    p = render_graph_add_pass(g, "gbuffer", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, transforms);
+    render_graph_color_target(g, p, albedo, SDL_GPU_LOADOP_CLEAR, black);
+    render_graph_color_target(g, p, normal, SDL_GPU_LOADOP_CLEAR, black);
+    render_graph_depth_target(g, p, depth, SDL_GPU_LOADOP_CLEAR, 1.0f);
+    p = render_graph_add_pass(g, "upload lights", RENDER_GRAPH_COPY, NULL, NULL);
+    render_graph_write(g, p, lights);
+    p = render_graph_add_pass(g, "ssao", RENDER_GRAPH_COMPUTE, NULL, NULL);
+    render_graph_read(g, p, depth);
+    render_graph_read(g, p, normal);
+    render_graph_write(g, p, ao);
+    p = render_graph_add_pass(g, "ssao blur", RENDER_GRAPH_COMPUTE, NULL, NULL);
+    render_graph_read(g, p, ao);
+    render_graph_write(g, p, ao_blur);
+    p = render_graph_add_pass(g, "lighting", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, albedo);
+    render_graph_read(g, p, normal);
+    render_graph_read(g, p, depth);
+    render_graph_read(g, p, shadow);
+    render_graph_read(g, p, ao_blur);
+    render_graph_read(g, p, lights);
+    render_graph_color_target(g, p, hdr, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "bloom down 1/2", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, hdr);
+    render_graph_color_target(g, p, down2, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "bloom down 1/4", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, down2);
+    render_graph_color_target(g, p, down4, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "bloom down 1/8", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, down4);
+    render_graph_color_target(g, p, down8, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "bloom up 1/4", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, down8);
+    render_graph_color_target(g, p, up4, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "bloom up 1/2", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, up4);
+    render_graph_color_target(g, p, up2, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "tonemap", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, hdr);
+    render_graph_read(g, p, up2);
+    render_graph_color_target(g, p, ldr, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "debug overlay", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, depth);
+    render_graph_color_target(g, p, overlay, SDL_GPU_LOADOP_CLEAR, black);
+    p = render_graph_add_pass(g, "fxaa", RENDER_GRAPH_RENDER, NULL, NULL);
+    render_graph_read(g, p, ldr);
+    render_graph_color_target(g, p, backbuffer, SDL_GPU_LOADOP_DONT_CARE, black);
+    p = render_graph_add_pass(g, "read back depth", RENDER_GRAPH_COPY, NULL, NULL);
+    render_graph_read(g, p, depth);
+    render_graph_write(g, p, readback);
+}
+
+/* A fresh graph holding the compiled frame, NULL if it did not compile */
+static RenderGraph *compile_frame(void)
+{
+    RenderGraph *g = render_graph_create(NULL);
+    if (!g)
+    {
+        return NULL;
+    }
+    build_frame(g);
+    if (!render_graph_compile(g))
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "The frame failed to compile");
+        render_graph_destroy(g);
+        return NULL;
+    }
+    return g;
+}
+
+/* Uploads batched up front, the unread overlay culled, everything else
+   after what it reads */
+static bool test_pass_order(void)
+{
+    static const char *const expected[] = {"upload transforms", "upload lights",  "shadow",         "gbuffer",
+                                           "ssao",              "ssao blur",      "lighting",       "bloom down 1/2",
+                                           "bloom down 1/4",    "bloom down 1/8", "bloom up 1/4",   "bloom up 1/2",
+                                           "tonemap",           "fxaa",           "read back depth"};
+    RenderGraph *g = compile_frame();
+    if (!g)
+    {
+        return false;
+    }
+    bool ok = true;
+    for (Uint32 i = 0; i < SDL_arraysize(expected); i++)
+    {
+        const char *name = render_graph_pass_at(g, i);
+        if (!name || SDL_strcmp(name, expected[i]) != 0)
+        {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "'%s' at position %u, expected '%s'", name ? name : "nothing",
+                         i, expected[i]);
+            ok = false;
+        }
+    }
+    const char *extra = render_graph_pass_at(g, (Uint32)SDL_arraysize(expected));
+    if (extra)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "'%s' kept past the expected passes", extra);
+        ok = false;
+    }
+    render_graph_destroy(g);
+    return ok;
+}
+
+/* bloom up 1/4, bloom up 1/2 and ldr each take over the texture of a
+   transient that is dead by then; nothing else can share */
+static bool test_aliasing_savings(void)
+{
+    const Uint32 aliased = 3;
+    const Uint64 saved = (Uint64)SDL_CalculateGPUTextureFormatSize(RGBA16F, FRAME_WIDTH / 4, FRAME_HEIGHT / 4, 1) +
+                         SDL_CalculateGPUTextureFormatSize(RGBA16F, FRAME_WIDTH / 2, FRAME_HEIGHT / 2, 1) +
+                         SDL_CalculateGPUTextureFormatSize(RGBA8, FRAME_WIDTH, FRAME_HEIGHT, 1);
+    RenderGraph *g = compile_frame();
+    if (!g)
+    {
+        return false;
+    }
+    const RenderGraphStats *s = render_graph_stats(g);
+    bool ok =
+        s->physical_textures + aliased == s->transient_textures && s->physical_bytes + saved == s->transient_bytes;
+    if (!ok)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "%u transients in %u textures (%llu bytes), expected %u textures (%llu bytes)",
+                     s->transient_textures, s->physical_textures, (unsigned long long)s->physical_bytes,
+                     s->transient_textures - aliased, (unsigned long long)(s->transient_bytes - saved));
+    }
+    render_graph_destroy(g);
+    return ok;
+}
+
+/* Rebuilt every frame on a warm pool, the frame must still validate */
+static bool test_no_live_overlap(void)
+{
+    RenderGraph *g = compile_frame();
+    if (!g)
+    {
+        return false;
+    }
+    bool ok = render_graph_validate(g);
+    for (int frame = 0; ok && frame < 3; frame++)
+    {
+        build_frame(g);
+        ok = render_graph_compile(g) && render_graph_validate(g);
+    }
+    if (!ok)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION,
+                     "A pass runs before its dependencies or two live transients share a texture");
+    }
+    render_graph_destroy(g);
+    return ok;
+}
+
+typedef struct TestCase
+{
+    const char *name;
+    bool (*run)(void);
+} TestCase;
+
+static const TestCase CASES[] = {
+    {"pass order", test_pass_order},
+    {"aliasing savings", test_aliasing_savings},
+    {"no live overlap", test_no_live_overlap},
+};
+
+int main(int argc, char *argv[])
+{
+    (void)argc;
+    (void)argv;
+    bool ok = true;
+    for (size_t i = 0; i < SDL_arraysize(CASES); i++)
+    {
+        bool passed = CASES[i].run();
+        SDL_Log("render_graph_test: %s: %s", CASES[i].name, passed ? "passed" : "FAILED");
+        ok = ok && passed;
+    }
+    SDL_Log("render_graph_test: %s", ok ? "passed" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,565 @@
+/* cumulus_cook: cook every .gltf/.glb under a directory into .meshlets
+   files on all cores, rebuilding only what changed since the last run.
+
+   usage: cumulus_cook [-f] [-j threads] <input dir> [output dir]
+
+   Outputs mirror the input tree, named like the ones Cumulus cooks on its
+   own (model.gltf.meshlets), next to the inputs unless an output
+   directory is given. A cook.db in the output directory records, per
+   input, the cooked format version and the size, modification time and
+   CRC-32 of every file the cook read. An input is skipped when its output
+   exists and those files still have the recorded sizes and times, or
+   their contents still hash the same; -f cooks everything. */
+
+/* The engine's cgltf implementation lives in model_import.c, which the
+   cooker does not link */
+#define CGLTF_IMPLEMENTATION
+
+#include "bench.h"
+#include "meshlet_stream.h"
+#include "parallel.h"
+
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+#include <cgltf.h>
+
+#define COOK_DATABASE "cook.db"
+#define COOK_DATABASE_HEADER "cumulus_cook 1"
+#define COOK_MAX_DEPENDENCIES 4096
+#define CRC_CHUNK_BYTES (1024 * 1024)
+
+typedef struct CookDep
+{
+    char *path;
+    Uint64 size;
+    SDL_Time modify_time;
+    Uint32 crc;
+} CookDep;
+
+/* What an input was last cooked from */
+typedef struct CookRecord
+{
+    char *input; /* relative to the input directory */
+    Uint32 version;
+    CookDep *deps;
+    int dep_count;
+    int dep_loaded; /* while parsing */
+} CookRecord;
+
+typedef enum CookStatus
+{
+    COOK_FAILED,
+    COOK_UP_TO_DATE,
+    COOK_DONE,
+} CookStatus;
+
+typedef struct CookJob
+{
+    char *source; /* input directory + input */
+    char *output;
+    const char *input;
+    Uint64 size;
+    const CookRecord *previous;
+    CookRecord record; /* the dependencies this run hashed, if it had to */
+    CookStatus status;
+    Uint64 read_bytes;
+    MeshletCookStats stats;
+    double ms;
+} CookJob;
+
+typedef struct CookBatch
+{
+    CookJob *jobs;
+    Uint32 count;
+    Uint32 capacity;
+    size_t root_length;
+    bool force;
+    SDL_AtomicInt finished;
+} CookBatch;
+
+static bool grow(void **items, Uint32 *capacity, Uint32 count, size_t size)
+{
+    if (count < *capacity)
+        return true;
+    Uint32 next = *capacity ? *capacity * 2 : 64;
+    void *grown = SDL_realloc(*items, next * size);
+    if (!grown)
+        return false;
+    *items = grown;
+    *capacity = next;
+    return true;
+}
+
+static void free_record(CookRecord *record)
+{
+    for (int i = 0; i < record->dep_loaded; i++)
+        SDL_free(record->deps[i].path);
+    SDL_free(record->deps);
+    SDL_free(record->input);
+    SDL_zerop(record);
+}
+
+static bool is_separator(char c)
+{
+    return c == '/' || c == '\\';
+}
+
+static char *with_separator(const char *dir)
+{
+    size_t length = SDL_strlen(dir);
+    char *path = NULL;
+    if (SDL_asprintf(&path, "%s%s", dir, length && is_separator(dir[length - 1]) ? "" : "/") < 0)
+        return NULL;
+    return path;
+}
+
+static bool is_model(const char *name)
+{
+    size_t length = SDL_strlen(name);
+    return (length > 5 && SDL_strcasecmp(name + length - 5, ".gltf") == 0) ||
+           (length > 4 && SDL_strcasecmp(name + length - 4, ".glb") == 0);
+}
+
+/* ------------------------------------------------------------------
+   Dependency database
+   ------------------------------------------------------------------ */
+
+static int SDLCALL compare_records(const void *a, const void *b)
+{
+    return SDL_strcmp(((const CookRecord *)a)->input, ((const CookRecord *)b)->input);
+}
+
+static char *parse_field(char *p, Uint64 *out, int base)
+{
+    char *end = NULL;
+    *out = SDL_strtoull(p, &end, base);
+    return end != p && *end == ' ' ? end + 1 : NULL;
+}
+
+/* Records sorted by input. Records cut short by a damaged file are
+   dropped, so their inputs cook again. */
+static CookRecord *load_database(const char *path, Uint32 *count)
+{
+    *count = 0;
+    char *text = SDL_LoadFile(path, NULL);
+    if (!text)
+        return NULL;
+
+    CookRecord *records = NULL;
+    Uint32 capacity = 0;
+    char *line = text;
+    bool valid = false;
+    while (*line)
+    {
+        char *next = SDL_strchr(line, '\n');
+        if (next)
+            *next++ = '\0';
+        else
+            next = line + SDL_strlen(line);
+        size_t length = SDL_strlen(line);
+        if (length && line[length - 1] == '\r')
+            line[length - 1] = '\0';
+
+        CookRecord *current = *count ? &records[*count - 1] : NULL;
+        Uint64 version, deps, size, modify_time, crc;
+        char *p;
+        if (!valid)
+        {
+            valid = SDL_strcmp(line, COOK_DATABASE_HEADER) == 0;
+            if (!valid)
+                break;
+        }
+        else if (SDL_strncmp(line, "input ", 6) == 0 && (p = parse_field(line + 6, &version, 10)) &&
+                 (p = parse_field(p, &deps, 10)) && *p && deps > 0 && deps <= COOK_MAX_DEPENDENCIES)
+        {
+            if (!grow((void **)&records, &capacity, *count, sizeof(CookRecord)))
+                break;
+            CookRecord *record = &records[(*count)++];
+            SDL_zerop(record);
+            record->input = SDL_strdup(p);
+            record->version = (Uint32)version;
+            record->dep_count = (int)deps;
+            record->deps = SDL_calloc((size_t)deps, sizeof(CookDep));
+            if (!record->input || !record->deps)
+                break;
+        }
+        else if (SDL_strncmp(line, "dep ", 4) == 0 && current && current->dep_loaded < current->dep_count &&
+                 (p = parse_field(line + 4, &size, 10)) && (p = parse_field(p, &modify_time, 10)) &&
+                 (p = parse_field(p, &crc, 16)) && *p)
+        {
+            CookDep *dep = &current->deps[current->dep_loaded];
+            dep->path = SDL_strdup(p);
+            if (!dep->path)
+                break;
+            dep->size = size;
+            dep->modify_time = (SDL_Time)modify_time;
+            dep->crc = (Uint32)crc;
+            current->dep_loaded++;
+        }
+        else if (*line)
+        {
+            SDL_Log("%s: unexpected line, ignoring the rest", path);
+            break;
+        }
+        line = next;
+    }
+    SDL_free(text);
+
+    Uint32 kept = 0;
+    for (Uint32 i = 0; i < *count; i++)
+    {
+        if (records[i].input && records[i].dep_loaded == records[i].dep_count)
+            records[kept++] = records[i];
+        else
+            free_record(&records[i]);
+    }
+    *count = kept;
+    if (kept)
+        SDL_qsort(records, kept, sizeof(CookRecord), compare_records);
+    return records;
+}
+
+static bool write_database(const char *path, const CookJob *jobs, Uint32 count)
+{
+    char *temp = NULL;
+    if (SDL_asprintf(&temp, "%s.tmp", path) < 0)
+        return false;
+    SDL_IOStream *io = SDL_IOFromFile(temp, "w");
+    if (!io)
+    {
+        SDL_Log("Failed to write %s: %s", temp, SDL_GetError());
+        SDL_free(temp);
+        return false;
+    }
+
+    bool ok = SDL_IOprintf(io, "%s\n", COOK_DATABASE_HEADER) > 0;
+    for (Uint32 i = 0; i < count && ok; i++)
+    {
+        const CookJob *job = &jobs[i];
+        if (job->status == COOK_FAILED)
+            continue;
+        /* Skipped on sizes and times alone: the old record still holds */
+        const CookRecord *record = job->record.deps ? &job->record : job->previous;
+        ok = SDL_IOprintf(io, "input %u %d %s\n", record->version, record->dep_count, record->input) > 0;
+        for (int d = 0; d < record->dep_count && ok; d++)
+        {
+            const CookDep *dep = &record->deps[d];
+            ok = SDL_IOprintf(io, "dep %llu %lld %08x %s\n", (unsigned long long)dep->size,
+                              (long long)dep->modify_time, dep->crc, dep->path) > 0;
+        }
+    }
+    ok = SDL_CloseIO(io) && ok;
+    if (ok)
+        ok = SDL_RenamePath(temp, path);
+    if (!ok)
+    {
+        SDL_Log("Failed to write %s: %s", path, SDL_GetError());
+        SDL_RemovePath(temp);
+    }
+    SDL_free(temp);
+    return ok;
+}
+
+static bool file_crc(const char *path, Uint8 *buffer, Uint32 *crc)
+{
+    SDL_IOStream *io = SDL_IOFromFile(path, "rb");
+    if (!io)
+        return false;
+    *crc = 0;
+    size_t read;
+    while ((read = SDL_ReadIO(io, buffer, CRC_CHUNK_BYTES)) > 0)
+        *crc = SDL_crc32(*crc, buffer, read);
+    bool ok = SDL_GetIOStatus(io) == SDL_IO_STATUS_EOF;
+    SDL_CloseIO(io);
+    return ok;
+}
+
+/* Size, time and hash of everything cooking the job reads */
+static bool scan_dependencies(CookJob *job)
+{
+    int count = 0;
+    char **paths = meshlet_cook_dependencies(job->source, &count);
+    Uint8 *buffer = SDL_malloc(CRC_CHUNK_BYTES);
+    CookRecord *record = &job->record;
+    record->input = SDL_strdup(job->input);
+    record->version = MESHLET_FILE_VERSION;
+    record->deps = count ? SDL_calloc((size_t)count, sizeof(CookDep)) : NULL;
+    record->dep_count = count;
+    bool ok = paths && buffer && record->input && record->deps;
+    for (int i = 0; ok && i < count; i++)
+    {
+        CookDep *dep = &record->deps[i];
+        SDL_PathInfo info;
+        dep->path = SDL_strdup(paths[i]);
+        ok = dep->path != NULL;
+        if (!ok)
+            break;
+        record->dep_loaded++;
+        ok = SDL_GetPathInfo(paths[i], &info) && file_crc(paths[i], buffer, &dep->crc);
+        if (!ok)
+        {
+            SDL_Log("%s: cannot read %s", job->input, paths[i]);
+            break;
+        }
+        dep->size = info.size;
+        dep->modify_time = info.modify_time;
+        job->read_bytes += info.size;
+    }
+    SDL_free(buffer);
+    SDL_free(paths);
+    return ok;
+}
+
+static bool same_times(const CookRecord *record)
+{
+    for (int i = 0; i < record->dep_count; i++)
+    {
+        SDL_PathInfo info;
+        const CookDep *dep = &record->deps[i];
+        if (!SDL_GetPathInfo(dep->path, &info) || info.size != dep->size || info.modify_time != dep->modify_time)
+            return false;
+    }
+    return true;
+}
+
+static bool same_contents(const CookRecord *a, const CookRecord *b)
+{
+    if (a->dep_count != b->dep_count)
+        return false;
+    for (int i = 0; i < a->dep_count; i++)
+    {
+        if (SDL_strcmp(a->deps[i].path, b->deps[i].path) != 0 || a->deps[i].size != b->deps[i].size ||
+            a->deps[i].crc != b->deps[i].crc)
+            return false;
+    }
+    return true;
+}
+
+/* ------------------------------------------------------------------
+   Cooking
+   ------------------------------------------------------------------ */
+
+static void cook_job(CookBatch *batch, CookJob *job)
+{
+    Uint64 start = bench_now();
+    const CookRecord *previous = batch->force ? NULL : job->previous;
+    SDL_PathInfo info;
+    if (previous && (previous->version != MESHLET_FILE_VERSION || !SDL_GetPathInfo(job->output, &info) ||
+                     info.type != SDL_PATHTYPE_FILE))
+        previous = NULL;
+
+    if (previous && same_times(previous))
+    {
+        job->status = COOK_UP_TO_DATE;
+        SDL_AddAtomicInt(&batch->finished, 1);
+        return;
+    }
+
+    Uint32 done;
+    if (!scan_dependencies(job))
+    {
+        job->status = COOK_FAILED;
+        done = (Uint32)SDL_AddAtomicInt(&batch->finished, 1) + 1;
+        SDL_Log("[%u/%u] %s: failed", done, batch->count, job->input);
+        return;
+    }
+    /* Touched but not changed: record the new times and move on */
+    if (previous && same_contents(previous, &job->record))
+    {
+        job->status = COOK_UP_TO_DATE;
+        SDL_AddAtomicInt(&batch->finished, 1);
+        return;
+    }
+
+    job->status = meshlet_cook_file(job->source, job->output, &job->stats) ? COOK_DONE : COOK_FAILED;
+    job->ms = bench_ms_since(start);
+    done = (Uint32)SDL_AddAtomicInt(&batch->finished, 1) + 1;
+    if (job->status == COOK_FAILED)
+    {
+        SDL_Log("[%u/%u] %s: failed", done, batch->count, job->input);
+        return;
+    }
+    double mb = job->read_bytes / (1024.0 * 1024.0);
+    SDL_Log("[%u/%u] %s: %.0f ms, %.1f MB at %.1f MB/s, %llu triangles + %llu in LODs, %u clusters in %u pages, "
+            "%.1f MB out",
+            done, batch->count, job->input, job->ms, mb, job->ms > 0.0 ? mb * 1000.0 / job->ms : 0.0,
+            (unsigned long long)job->stats.triangles, (unsigned long long)job->stats.lod_triangles,
+            job->stats.clusters, job->stats.pages, job->stats.file_bytes / (1024.0 * 1024.0));
+}
+
+static void cook_range(void *userdata, size_t begin, size_t end)
+{
+    CookBatch *batch = userdata;
+    for (size_t i = begin; i < end; i++)
+        cook_job(batch, &batch->jobs[i]);
+}
+
+/* Largest first, so a big file does not start last and run alone */
+static int SDLCALL compare_jobs(const void *a, const void *b)
+{
+    Uint64 sa = ((const CookJob *)a)->size, sb = ((const CookJob *)b)->size;
+    return sa < sb ? 1 : sa > sb ? -1 : SDL_strcmp(((const CookJob *)a)->input, ((const CookJob *)b)->input);
+}
+
+static SDL_EnumerationResult SDLCALL scan_entry(void *userdata, const char *dirname, const char *fname)
+{
+    CookBatch *batch = userdata;
+    size_t length = SDL_strlen(dirname);
+    char *path = NULL;
+    if (SDL_asprintf(&path, "%s%s%s", dirname, length && is_separator(dirname[length - 1]) ? "" : "/", fname) < 0)
+        return SDL_ENUM_FAILURE;
+
+    SDL_PathInfo info;
+    if (!SDL_GetPathInfo(path, &info))
+    {
+        SDL_free(path);
+        return SDL_ENUM_CONTINUE;
+    }
+    if (info.type == SDL_PATHTYPE_DIRECTORY)
+    {
+        bool ok = SDL_EnumerateDirectory(path, scan_entry, batch);
+        SDL_free(path);
+        return ok ? SDL_ENUM_CONTINUE : SDL_ENUM_FAILURE;
+    }
+    if (info.type != SDL_PATHTYPE_FILE || !is_model(fname) ||
+        !grow((void **)&batch->jobs, &batch->capacity, batch->count, sizeof(CookJob)))
+    {
+        SDL_free(path);
+        return SDL_ENUM_CONTINUE;
+    }
+    CookJob *job = &batch->jobs[batch->count++];
+    SDL_zerop(job);
+    job->source = path;
+    job->input = path + batch->root_length;
+    job->size = info.size;
+    return SDL_ENUM_CONTINUE;
+}
+
+/* Creates the directory `path` is in, and its parents */
+static void create_parent(const char *path)
+{
+    char *dir = SDL_strdup(path);
+    if (!dir)
+        return;
+    size_t length = SDL_strlen(dir);
+    while (length && !is_separator(dir[length - 1]))
+        length--;
+    if (length)
+    {
+        dir[length] = '\0';
+        SDL_CreateDirectory(dir);
+    }
+    SDL_free(dir);
+}
+
+static int usage(void)
+{
+    SDL_Log("usage: cumulus_cook [-f] [-j threads] <input dir> [output dir]");
+    SDL_Log("  -f          cook everything, ignoring " COOK_DATABASE);
+    SDL_Log("  -j threads  threads to cook on, all cores by default");
+    return 2;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *dirs[2] = {NULL, NULL};
+    int dir_count = 0;
+    int threads = 0;
+    CookBatch batch;
+    SDL_zero(batch);
+    for (int i = 1; i < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "-f") == 0)
+            batch.force = true;
+        else if (SDL_strcmp(argv[i], "-j") == 0 && i + 1 < argc && SDL_atoi(argv[i + 1]) > 0)
+            threads = SDL_atoi(argv[++i]);
+        else if (argv[i][0] != '-' && dir_count < 2)
+            dirs[dir_count++] = argv[i];
+        else
+            return usage();
+    }
+    if (dir_count == 0)
+        return usage();
+
+    char *input_dir = with_separator(dirs[0]);
+    char *output_dir = with_separator(dirs[dir_count - 1]);
+    char *database_path = NULL;
+    if (!input_dir || !output_dir || SDL_asprintf(&database_path, "%s" COOK_DATABASE, output_dir) < 0)
+        return 1;
+
+    batch.root_length = SDL_strlen(input_dir);
+    if (!SDL_EnumerateDirectory(input_dir, scan_entry, &batch))
+    {
+        SDL_Log("Failed to scan %s: %s", input_dir, SDL_GetError());
+        return 1;
+    }
+    if (batch.count == 0)
+    {
+        SDL_Log("No .gltf or .glb files under %s", input_dir);
+        return 0;
+    }
+    SDL_qsort(batch.jobs, batch.count, sizeof(CookJob), compare_jobs);
+
+    Uint32 record_count = 0;
+    CookRecord *records = load_database(database_path, &record_count);
+    for (Uint32 i = 0; i < batch.count; i++)
+    {
+        CookJob *job = &batch.jobs[i];
+        if (SDL_asprintf(&job->output, "%s%s.meshlets", output_dir, job->input) < 0)
+            return 1;
+        create_parent(job->output);
+        CookRecord key = {.input = (char *)job->input};
+        if (record_count)
+            job->previous = SDL_bsearch(&key, records, record_count, sizeof(CookRecord), compare_records);
+    }
+
+    /* The calling thread cooks too */
+    if (threads != 1)
+        parallel_init(threads > 1 ? threads - 1 : 0);
+    int thread_count = parallel_worker_count() + 1;
+
+    Uint64 start = bench_now();
+    parallel_for(batch.count, 1, cook_range, &batch);
+    double ms = bench_ms_since(start);
+
+    Uint32 cooked = 0, up_to_date = 0, failed = 0;
+    Uint64 read_bytes = 0, triangles = 0;
+    double busy_ms = 0.0;
+    for (Uint32 i = 0; i < batch.count; i++)
+    {
+        const CookJob *job = &batch.jobs[i];
+        cooked += job->status == COOK_DONE;
+        up_to_date += job->status == COOK_UP_TO_DATE;
+        failed += job->status == COOK_FAILED;
+        if (job->status == COOK_DONE)
+        {
+            read_bytes += job->read_bytes;
+            triangles += job->stats.triangles;
+            busy_ms += job->ms;
+        }
+    }
+    bool saved = write_database(database_path, batch.jobs, batch.count);
+
+    double seconds = ms / 1000.0;
+    SDL_Log("%u cooked, %u up to date, %u failed in %.2f s on %d threads", cooked, up_to_date, failed, seconds,
+            thread_count);
+    if (cooked && seconds > 0.0)
+        SDL_Log("%.1f MB at %.1f MB/s, %.2f M triangles/s, %.1fx parallel", read_bytes / (1024.0 * 1024.0),
+                read_bytes / (1024.0 * 1024.0) / seconds, triangles / 1e6 / seconds, busy_ms / ms);
+
+    parallel_shutdown();
+    for (Uint32 i = 0; i < batch.count; i++)
+    {
+        free_record(&batch.jobs[i].record);
+        SDL_free(batch.jobs[i].source);
+        SDL_free(batch.jobs[i].output);
+    }
+    for (Uint32 i = 0; i < record_count; i++)
+        free_record(&records[i]);
+    SDL_free(records);
+    SDL_free(batch.jobs);
+    SDL_free(database_path);
+    SDL_free(output_dir);
+    SDL_free(input_dir);
+    return failed || !saved ? 1 : 0;
+}